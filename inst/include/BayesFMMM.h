@@ -1,12 +1,32 @@
 #ifndef BayesFMMM_H
 #define BayesFMMM_H
 
+#include "BayesFMMM/AdaptiveTuning.h"
 #include "BayesFMMM/BFMMM.h"
 #include "BayesFMMM/BSplines.h"
 #include "BayesFMMM/CalculateLikelihood.h"
 #include "BayesFMMM/CalculateTTAcceptance.h"
+#include "BayesFMMM/ConditionalModes.h"
+#include "BayesFMMM/CovariateEffects.h"
+#include "BayesFMMM/CubeList.h"
 #include "BayesFMMM/Distributions.h"
+#include "BayesFMMM/GibbsScheduler.h"
+#include "BayesFMMM/InformationCriteria.h"
+#include "BayesFMMM/KernelPolicies.h"
 #include "BayesFMMM/LabelSwitch.h"
+#include "BayesFMMM/MembershipScoring.h"
+#include "BayesFMMM/ObsStore.h"
+#include "BayesFMMM/Posterior.h"
+#include "BayesFMMM/PosteriorSummary.h"
+#include "BayesFMMM/RaggedObs.h"
+#include "BayesFMMM/Retention.h"
+#include "BayesFMMM/SampleCodec.h"
+#include "BayesFMMM/SampleLoader.h"
+#include "BayesFMMM/SamplerControl.h"
+#include "BayesFMMM/SparseGaussian.h"
+#include "BayesFMMM/StochasticGradient.h"
+#include "BayesFMMM/SubjectScheduler.h"
+#include "BayesFMMM/TemperatureLadder.h"
 #include "BayesFMMM/UpdateA.h"
 #include "BayesFMMM/UpdateAlpha3.h"
 #include "BayesFMMM/UpdateChi.h"
@@ -21,5 +41,6 @@
 #include "BayesFMMM/UpdateSigma.h"
 #include "BayesFMMM/UpdateTau.h"
 #include "BayesFMMM/UpdateXi.h"
+#include "BayesFMMM/Workspace.h"
 
 #endif
@@ -0,0 +1,177 @@
+#ifndef BayesFMMM_ADAPTIVE_TUNING_H
+#define BayesFMMM_ADAPTIVE_TUNING_H
+
+#include <RcppArmadillo.h>
+#include <cmath>
+
+namespace BayesFMMM{
+// Proposal scales of the Metropolis-Hastings steps of the mixed membership
+// model. During the first n_adapt iterations the scales are moved towards the
+// target acceptance rates with Robbins-Monro updates on the log scale; after
+// that they are kept fixed and the acceptance probabilities are averaged so
+// the final tuning can be reported.
+//
+// @name ProposalTuning
+// @field a_Z_PM Vector containing the proposal concentration used for each row of Z
+// @field step_Z Vector containing the leapfrog step size used for each row of Z (only used if n_leapfrog_Z > 0)
+// @field n_leapfrog_Z Int containing the number of leapfrog steps of the Hamiltonian Monte Carlo updates of Z (if 0, then the Dirichlet random walk is used)
+// @field a_pi_PM Double containing the proposal concentration used for pi
+// @field var_alpha3 Double containing the proposal scale used for alpha_3
+// @field var_epsilon1 Double containing the proposal scale used for a_1
+// @field var_epsilon2 Double containing the proposal scale used for a_2
+// @field accept_Z Vector containing the acceptance probability of each row of Z in the last sweep
+// @field accept_pi Double containing the acceptance probability of pi in the last sweep
+// @field accept_alpha3 Double containing the acceptance probability of alpha_3 in the last sweep
+// @field accept_A Vector containing the average acceptance probabilities of a_1 and a_2 in the last sweep
+// @field mean_accept_Z Vector containing the average acceptance probability of each row of Z after adaptation
+// @field mean_accept Vector containing the average acceptance probabilities of pi, alpha_3, a_1 and a_2 after adaptation
+// @field n_adapt Int containing the number of iterations used for adaptation
+// @field n_frozen Int containing the number of sweeps recorded after adaptation
+struct ProposalTuning{
+  arma::vec a_Z_PM;
+  arma::vec step_Z;
+  int n_leapfrog_Z;
+  double a_pi_PM;
+  double var_alpha3;
+  double var_epsilon1;
+  double var_epsilon2;
+  arma::vec accept_Z;
+  double accept_pi;
+  double accept_alpha3;
+  arma::vec accept_A;
+  arma::vec mean_accept_Z;
+  arma::vec mean_accept;
+  int n_adapt;
+  int n_frozen;
+};
+
+// Creates the proposal tuning of a sampler from the user specified proposal
+// scales, including the step size of the Hamiltonian Monte Carlo updates of Z
+//
+// @name makeProposalTuning
+// @param n_funct Int containing number of functions observed
+// @param a_Z_PM Double containing hyperparameter used to sample from the posterior of Z
+// @param a_pi_PM Double containing hyperparameter used to sample from the posterior of pi
+// @param var_alpha3 Double containing hyperparameter for sampling from alpha_3
+// @param var_epsilon1 Double containing hyperparameter for sampling from a_1
+// @param var_epsilon2 Double containing hyperparameter for sampling from a_2
+// @param step_Z Double containing the leapfrog step size of the Hamiltonian Monte Carlo updates of Z
+// @param n_leapfrog_Z Int containing the number of leapfrog steps of the Hamiltonian Monte Carlo updates of Z
+// @param n_adapt Int containing the number of iterations used for adaptation
+// @returns tuning ProposalTuning containing the starting proposal scales
+inline ProposalTuning makeProposalTuning(const int n_funct,
+                                         const double a_Z_PM,
+                                         const double a_pi_PM,
+                                         const double var_alpha3,
+                                         const double var_epsilon1,
+                                         const double var_epsilon2,
+                                         const double step_Z,
+                                         const int n_leapfrog_Z,
+                                         const int n_adapt){
+  ProposalTuning tuning;
+  tuning.a_Z_PM = a_Z_PM * arma::ones(n_funct);
+  tuning.step_Z = step_Z * arma::ones(n_funct);
+  tuning.n_leapfrog_Z = n_leapfrog_Z;
+  tuning.a_pi_PM = a_pi_PM;
+  tuning.var_alpha3 = var_alpha3;
+  tuning.var_epsilon1 = var_epsilon1;
+  tuning.var_epsilon2 = var_epsilon2;
+  tuning.accept_Z = arma::zeros(n_funct);
+  tuning.accept_pi = 0;
+  tuning.accept_alpha3 = 0;
+  tuning.accept_A = arma::zeros(2);
+  tuning.mean_accept_Z = arma::zeros(n_funct);
+  tuning.mean_accept = arma::zeros(4);
+  tuning.n_adapt = n_adapt;
+  tuning.n_frozen = 0;
+  return tuning;
+}
+
+// Creates the proposal tuning of a sampler from the user specified proposal
+// scales
+//
+// @name makeProposalTuning
+inline ProposalTuning makeProposalTuning(const int n_funct,
+                                         const double a_Z_PM,
+                                         const double a_pi_PM,
+                                         const double var_alpha3,
+                                         const double var_epsilon1,
+                                         const double var_epsilon2,
+                                         const int n_adapt){
+  return makeProposalTuning(n_funct, a_Z_PM, a_pi_PM, var_alpha3, var_epsilon1,
+                            var_epsilon2, 0.1, 0, n_adapt);
+}
+
+// Updates the proposal scales using the acceptance probabilities of the last
+// sweep. The concentrations of the Dirichlet proposals (a_Z_PM and a_pi_PM) are
+// inversely related to the step size, so they move in the opposite direction
+// of the random walk scales, while the leapfrog step sizes of the Hamiltonian
+// Monte Carlo updates of Z target the usual 0.65 (0.574 for MALA). The step
+// size of the updates decays as (iter + 1)^(-0.6), and the scales are frozen
+// once iter reaches n_adapt.
+//
+// @name updateProposalTuning
+// @param iter Int containing current MCMC iteration
+// @param tuning ProposalTuning containing the proposal scales and the last acceptance probabilities
+inline void updateProposalTuning(const int iter,
+                                 ProposalTuning& tuning){
+  // target acceptance rates of the multivariate and scalar proposals
+  double target_multi = 0.234;
+  double target_scalar = 0.44;
+  if(iter < tuning.n_adapt){
+    double gain = std::pow(iter + 1.0, -0.6);
+    if(tuning.n_leapfrog_Z > 0){
+      double target_hmc = (tuning.n_leapfrog_Z == 1) ? 0.574 : 0.65;
+      tuning.step_Z = tuning.step_Z %
+        arma::exp(gain * (tuning.accept_Z - target_hmc));
+    }else{
+      for(int i = 0; i < tuning.a_Z_PM.n_elem; i++){
+        tuning.a_Z_PM(i) = std::max(tuning.a_Z_PM(i) *
+          std::exp(-gain * (tuning.accept_Z(i) - target_multi)), 1.0);
+      }
+    }
+    tuning.a_pi_PM = std::max(tuning.a_pi_PM *
+      std::exp(-gain * (tuning.accept_pi - target_multi)), 1.0);
+    tuning.var_alpha3 = tuning.var_alpha3 *
+      std::exp(gain * (tuning.accept_alpha3 - target_scalar));
+    tuning.var_epsilon1 = tuning.var_epsilon1 *
+      std::exp(gain * (tuning.accept_A(0) - target_scalar));
+    tuning.var_epsilon2 = tuning.var_epsilon2 *
+      std::exp(gain * (tuning.accept_A(1) - target_scalar));
+  }else{
+    tuning.n_frozen = tuning.n_frozen + 1;
+    tuning.mean_accept_Z = tuning.mean_accept_Z +
+      ((tuning.accept_Z - tuning.mean_accept_Z) / tuning.n_frozen);
+    arma::vec accept = {tuning.accept_pi, tuning.accept_alpha3,
+                        tuning.accept_A(0), tuning.accept_A(1)};
+    tuning.mean_accept = tuning.mean_accept +
+      ((accept - tuning.mean_accept) / tuning.n_frozen);
+  }
+}
+
+// Summarizes the final proposal scales and the average acceptance
+// probabilities after adaptation
+//
+// @name summarizeProposalTuning
+// @param tuning ProposalTuning containing the proposal scales
+// @returns summary List containing the proposal scales and acceptance probabilities
+inline Rcpp::List summarizeProposalTuning(const ProposalTuning& tuning){
+  Rcpp::List summary = Rcpp::List::create(
+    Rcpp::Named("a_Z_PM", tuning.a_Z_PM),
+    Rcpp::Named("a_pi_PM", tuning.a_pi_PM),
+    Rcpp::Named("var_alpha3", tuning.var_alpha3),
+    Rcpp::Named("var_epsilon1", tuning.var_epsilon1),
+    Rcpp::Named("var_epsilon2", tuning.var_epsilon2),
+    Rcpp::Named("accept_Z", tuning.mean_accept_Z),
+    Rcpp::Named("accept_pi", tuning.mean_accept(0)),
+    Rcpp::Named("accept_alpha3", tuning.mean_accept(1)),
+    Rcpp::Named("accept_epsilon1", tuning.mean_accept(2)),
+    Rcpp::Named("accept_epsilon2", tuning.mean_accept(3)));
+  if(tuning.n_leapfrog_Z > 0){
+    summary.push_back(tuning.step_Z, "step_Z");
+  }
+  return summary;
+}
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <RcppArmadillo.h>
 #include <cmath>
+#include <utility>
 #include <splines2Armadillo.h>
 #include "UpdateClassMembership.h"
 #include "UpdateMixedMembership.h"
@@ -15,8 +16,21 @@
 #include "UpdateTau.h"
 #include "UpdateSigma.h"
 #include "UpdateChi.h"
+#include "UpdateEta.h"
+#include "UpdateXi.h"
 #include "CalculateLikelihood.h"
 #include "CalculateTTAcceptance.h"
+#include "ConditionalModes.h"
+#include "CovariateEffects.h"
+#include "GibbsScheduler.h"
+#include "ObsStore.h"
+#include "RaggedObs.h"
+#include "StochasticGradient.h"
+#include "SubjectScheduler.h"
+#include "PosteriorSummary.h"
+#include "Retention.h"
+#include "AdaptiveTuning.h"
+#include "TemperatureLadder.h"
 #include "UpdateAlpha3.h"
 #include "BSplines.h"
 #include "Distributions.h"
@@ -78,6 +92,9 @@ inline Rcpp::List BFMMM(const arma::field<arma::vec>& y_obs,
                         const double& alpha_0,
                         const double& beta_0,
                         const std::string directory){
+  // every parameter is saved every thinning_num iterations
+  const RetentionPolicy retention = makeRetentionPolicy(modelParams(),
+                                                        thinning_num);
   // Make B_obs
   arma::field<arma::mat> B_obs(n_funct,1);
 
@@ -91,6 +108,9 @@ inline Rcpp::List BFMMM(const arma::field<arma::vec>& y_obs,
     B_obs(i,0) = bspline_mat;
   }
 
+  // Pack observations into contiguous storage
+  const RaggedObs obs = makeRaggedObs(y_obs, B_obs);
+
   arma::mat P_mat(P, P, arma::fill::zeros);
   P_mat.zeros();
   for(int j = 0; j < P_mat.n_rows; j++){
@@ -141,7 +161,7 @@ inline Rcpp::List BFMMM(const arma::field<arma::vec>& y_obs,
   arma::mat B_1(P, P, arma::fill::zeros);
 
   for(int i = 0; i < tot_mcmc_iters; i++){
-    updateZ_PM(y_obs, B_obs, Phi((i % r_stored_iters),0),
+    updateZ_PM(obs, Phi((i % r_stored_iters),0),
                nu.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
                pi.col((i % r_stored_iters)), sigma((i % r_stored_iters)),
                (i % r_stored_iters), r_stored_iters, alpha_3(i % r_stored_iters),
@@ -158,7 +178,7 @@ inline Rcpp::List BFMMM(const arma::field<arma::vec>& y_obs,
       }
     }
 
-    updatePhi(y_obs, B_obs, nu.slice((i % r_stored_iters)),
+    updatePhi(obs, nu.slice((i % r_stored_iters)),
               gamma((i % r_stored_iters),0), tilde_tau,
               Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
               sigma((i % r_stored_iters)), (i % r_stored_iters),
@@ -174,7 +194,7 @@ inline Rcpp::List BFMMM(const arma::field<arma::vec>& y_obs,
     updateGamma(nu_1, delta.slice((i % r_stored_iters)), Phi((i % r_stored_iters),0),
                 (i % r_stored_iters), r_stored_iters, gamma);
 
-    updateNu(y_obs, B_obs, tau.row((i % r_stored_iters)).t(),
+    updateNu(obs, tau.row((i % r_stored_iters)).t(),
              Phi((i % r_stored_iters),0), Z.slice((i % r_stored_iters)),
              chi.slice((i % r_stored_iters)), sigma((i % r_stored_iters)),
              (i % r_stored_iters), r_stored_iters, P_mat, b_1, B_1, nu);
@@ -182,18 +202,18 @@ inline Rcpp::List BFMMM(const arma::field<arma::vec>& y_obs,
     updateTau(alpha, beta, nu.slice((i % r_stored_iters)), (i % r_stored_iters),
               r_stored_iters, P_mat, tau);
 
-    updateSigma(y_obs, B_obs, alpha_0, beta_0,
+    updateSigma(obs, alpha_0, beta_0,
                 nu.slice((i % r_stored_iters)), Phi((i % r_stored_iters),0),
                 Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
                 (i % r_stored_iters), r_stored_iters, sigma);
 
-    updateChi(y_obs, B_obs, Phi((i % r_stored_iters),0),
+    updateChi(obs, Phi((i % r_stored_iters),0),
               nu.slice((i % r_stored_iters)), Z.slice((i % r_stored_iters)),
               sigma((i % r_stored_iters)), (i % r_stored_iters), r_stored_iters,
               chi);
 
     // Calculate log likelihood
-    loglik((i % r_stored_iters)) =  calcLikelihood(y_obs, B_obs, nu.slice((i % r_stored_iters)),
+    loglik((i % r_stored_iters)) =  calcLikelihood(obs, nu.slice((i % r_stored_iters)),
            Phi((i % r_stored_iters),0), Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)), sigma((i % r_stored_iters)));
     if(((i+1) % 20) == 0){
       Rcpp::Rcout << "Iteration: " << i+1 << "\n";
@@ -201,56 +221,18 @@ inline Rcpp::List BFMMM(const arma::field<arma::vec>& y_obs,
       Rcpp::checkUserInterrupt();
     }
     if(((i+1) % r_stored_iters) == 0 && i > 1){
-      // Save parameters
-      arma::cube nu1(K, P, r_stored_iters/thinning_num, arma::fill::randn);
-      arma::cube chi1(n_funct, M, r_stored_iters/thinning_num, arma::fill::randn);
-      arma::mat pi1(K, r_stored_iters/thinning_num, arma::fill::zeros);
-      arma::vec alpha_31(r_stored_iters/thinning_num, arma::fill::zeros);
-      arma::vec sigma1(r_stored_iters/thinning_num, arma::fill::ones);
-      arma::cube A1 = arma::ones(K, 2, r_stored_iters/thinning_num);
-      arma::cube Z1 = arma::randi<arma::cube>(n_funct, K, r_stored_iters/thinning_num,
-                                              arma::distr_param(0,1));
-      arma::cube delta1(K, M, r_stored_iters/thinning_num, arma::fill::ones);
-      arma::field<arma::cube> gamma1(r_stored_iters/thinning_num,1);
-      arma::field<arma::cube> Phi1(r_stored_iters/thinning_num, 1);
-      arma::mat tau1(r_stored_iters/thinning_num, K, arma::fill::ones);
-
-      nu1.slice(0) = nu.slice(0);
-      chi1.slice(0) = chi.slice(0);
-      pi1.col(0) = pi.col(0);
-      sigma1(0) = sigma(0);
-      A1.slice(0) = A.slice(0);
-      Z1.slice(0) = Z.slice(0);
-      delta1.slice(0) = delta.slice(0);
-      gamma1(0,0) = gamma(0,0);
-      Phi1(0,0) = Phi(0,0);
-      tau1.row(0) = tau.row(0);
-
-      for(int p=1; p < r_stored_iters / thinning_num; p++){
-        nu1.slice(p) = nu.slice(thinning_num*p - 1);
-        chi1.slice(p) = chi.slice(thinning_num*p - 1);
-        pi1.col(p) = pi.col(thinning_num*p - 1);
-        alpha_31(p) = alpha_3(thinning_num*p - 1);
-        sigma1(p) = sigma(thinning_num*p - 1);
-        A1.slice(p) = A.slice(thinning_num*p - 1);
-        Z1.slice(p) = Z.slice(thinning_num*p - 1);
-        delta1.slice(p) = delta.slice(thinning_num*p - 1);
-        gamma1(p,0) = gamma(thinning_num*p - 1,0);
-        Phi1(p,0) = Phi(thinning_num*p  - 1,0);
-        tau1.row(p) = tau.row(thinning_num*p - 1);
-      }
-
-      nu1.save(directory + "Nu" + std::to_string(q) + ".txt", arma::arma_ascii);
-      chi1.save(directory + "Chi" + std::to_string(q) +".txt", arma::arma_ascii);
-      pi1.save(directory + "Pi" + std::to_string(q) +".txt", arma::arma_ascii);
-      alpha_31.save(directory + "alpha_3" + std::to_string(q) + ".txt", arma::arma_ascii);
-      A1.save(directory + "A" + std::to_string(q) +".txt", arma::arma_ascii);
-      delta1.save(directory + "Delta" + std::to_string(q) +".txt", arma::arma_ascii);
-      sigma1.save(directory + "Sigma" + std::to_string(q) +".txt", arma::arma_ascii);
-      tau1.save(directory + "Tau" + std::to_string(q) +".txt", arma::arma_ascii);
-      gamma1.save(directory + "Gamma" + std::to_string(q) +".txt");
-      Phi1.save(directory + "Phi" + std::to_string(q) +".txt");
-      Z1.save(directory + "Z" + std::to_string(q) +".txt", arma::arma_ascii);
+      // Save the retained parameters (each file is written once per batch)
+      flushRetained(retention, "Nu", nu, directory, q);
+      flushRetained(retention, "Chi", chi, directory, q);
+      flushRetainedCols(retention, "Pi", pi, directory, q);
+      flushRetained(retention, "alpha_3", alpha_3, directory, q);
+      flushRetained(retention, "A", A, directory, q);
+      flushRetained(retention, "Delta", delta, directory, q);
+      flushRetained(retention, "Sigma", sigma, directory, q);
+      flushRetainedRows(retention, "Tau", tau, directory, q);
+      flushRetained(retention, "Gamma", gamma, directory, q);
+      flushRetained(retention, "Phi", Phi, directory, q);
+      flushRetained(retention, "Z", Z, directory, q);
 
       //reset all parameters
       nu.slice(0) = nu.slice(i % r_stored_iters);
@@ -350,6 +332,9 @@ inline Rcpp::List BFMMM_Templadder(const arma::field<arma::vec>& y_obs,
     B_obs(i,0) = bspline_mat;
   }
 
+  // Pack observations into contiguous storage
+  const RaggedObs obs = makeRaggedObs(y_obs, B_obs);
+
   arma::mat P_mat(P, P, arma::fill::zeros);
   P_mat.zeros();
   for(int j = 0; j < P_mat.n_rows; j++){
@@ -460,7 +445,7 @@ inline Rcpp::List BFMMM_Templadder(const arma::field<arma::vec>& y_obs,
 
   // Perform tempered transitions
   for(int l = 1; l < ((2 * N_t) + 1); l++){
-    updateZTempered_PM(beta_ladder(temp_ind), y_obs, B_obs,
+    updateZTempered_PM(beta_ladder(temp_ind), obs,
                        Phi_TT(l,0), nu_TT.slice(l), chi_TT.slice(l),
                        pi_TT.col(l), sigma_TT(l), l, (2 * N_t) + 1, alpha_3_TT(l), a_Z_PM,
                        Z_ph, Z_TT);
@@ -474,7 +459,7 @@ inline Rcpp::List BFMMM_Templadder(const arma::field<arma::vec>& y_obs,
       }
     }
 
-    updatePhiTempered(beta_ladder(temp_ind), y_obs, B_obs,
+    updatePhiTempered(beta_ladder(temp_ind), obs,
                       nu_TT.slice(l), gamma_TT(l,0), tilde_tau, Z_TT.slice(l),
                       chi_TT.slice(l), sigma_TT(l), l, (2 * N_t) + 1, m_1, M_1,
                       Phi_TT);
@@ -485,16 +470,16 @@ inline Rcpp::List BFMMM_Templadder(const arma::field<arma::vec>& y_obs,
             var_epsilon2, l, (2 * N_t) + 1, A_TT);
     updateGamma(nu_1, delta_TT.slice(l), Phi_TT(l,0), l, (2 * N_t) + 1,
                 gamma_TT);
-    updateNuTempered(beta_ladder(temp_ind), y_obs, B_obs,
+    updateNuTempered(beta_ladder(temp_ind), obs,
                      tau_TT.row(l).t(), Phi_TT(l,0), Z_TT.slice(l),
                      chi_TT.slice(l), sigma_TT(l), l, (2 * N_t) + 1, P_mat,
                      b_1, B_1, nu_TT);
     updateTau(alpha, beta, nu_TT.slice(l), l, (2 * N_t) + 1, P_mat, tau_TT);
-    updateSigmaTempered(beta_ladder(temp_ind), y_obs, B_obs,
+    updateSigmaTempered(beta_ladder(temp_ind), obs,
                         alpha_0, beta_0, nu_TT.slice(l), Phi_TT(l,0),
                         Z_TT.slice(l), chi_TT.slice(l), l, (2 * N_t) + 1,
                         sigma_TT);
-    updateChiTempered(beta_ladder(temp_ind), y_obs, B_obs,
+    updateChiTempered(beta_ladder(temp_ind), obs,
                       Phi_TT(l,0), nu_TT.slice(l), Z_TT.slice(l), sigma_TT(l),
                       l, (2 * N_t) + 1, chi_TT);
 
@@ -509,7 +494,7 @@ inline Rcpp::List BFMMM_Templadder(const arma::field<arma::vec>& y_obs,
 
   }
 
-  logA = CalculateTTAcceptance(beta_ladder, y_obs, B_obs,
+  logA = CalculateTTAcceptance(beta_ladder, obs,
                                nu_TT, Phi_TT, Z_TT, chi_TT, sigma_TT);
   logu = std::log(R::runif(0,1));
 
@@ -593,6 +578,9 @@ inline Rcpp::List BFMMM_MTT(const arma::field<arma::vec>& y_obs,
                             const std::string directory,
                             const double& beta_N_t,
                             const int& N_t){
+  // every parameter is saved every thinning_num iterations
+  const RetentionPolicy retention = makeRetentionPolicy(modelParams(),
+                                                        thinning_num);
   // Make B_obs
   arma::field<arma::mat> B_obs(n_funct,1);
   int P = internal_knots.n_elem + basis_degree + 1;
@@ -607,6 +595,9 @@ inline Rcpp::List BFMMM_MTT(const arma::field<arma::vec>& y_obs,
     B_obs(i,0) = bspline_mat;
   }
 
+  // Pack observations into contiguous storage
+  const RaggedObs obs = makeRaggedObs(y_obs, B_obs);
+
   arma::mat P_mat(P, P, arma::fill::zeros);
   P_mat.zeros();
   for(int j = 0; j < P_mat.n_rows; j++){
@@ -693,7 +684,7 @@ inline Rcpp::List BFMMM_MTT(const arma::field<arma::vec>& y_obs,
 
   for(int i=0; i < tot_mcmc_iters; i++){
     if(((i % n_temp_trans) != 0) || (i == 0)){
-      updateZ_PM(y_obs, B_obs, Phi((i % r_stored_iters),0),
+      updateZ_PM(obs, Phi((i % r_stored_iters),0),
                  nu.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
                  pi.col((i % r_stored_iters)), sigma((i % r_stored_iters)),
                  (i % r_stored_iters), r_stored_iters, alpha_3(i % r_stored_iters),
@@ -712,7 +703,7 @@ inline Rcpp::List BFMMM_MTT(const arma::field<arma::vec>& y_obs,
         }
       }
 
-      updatePhi(y_obs, B_obs, nu.slice((i % r_stored_iters)),
+      updatePhi(obs, nu.slice((i % r_stored_iters)),
                 gamma((i % r_stored_iters),0), tilde_tau,
                 Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
                 sigma((i % r_stored_iters)), (i % r_stored_iters),
@@ -728,7 +719,7 @@ inline Rcpp::List BFMMM_MTT(const arma::field<arma::vec>& y_obs,
       updateGamma(nu_1, delta.slice((i % r_stored_iters)), Phi((i % r_stored_iters),0),
                   (i % r_stored_iters), r_stored_iters, gamma);
 
-      updateNu(y_obs, B_obs, tau.row((i % r_stored_iters)).t(),
+      updateNu(obs, tau.row((i % r_stored_iters)).t(),
                Phi((i % r_stored_iters),0), Z.slice((i % r_stored_iters)),
                chi.slice((i % r_stored_iters)), sigma((i % r_stored_iters)),
                (i % r_stored_iters), r_stored_iters, P_mat, b_1, B_1, nu);
@@ -736,12 +727,12 @@ inline Rcpp::List BFMMM_MTT(const arma::field<arma::vec>& y_obs,
       updateTau(alpha, beta, nu.slice((i % r_stored_iters)), (i % r_stored_iters),
                 r_stored_iters, P_mat, tau);
 
-      updateSigma(y_obs, B_obs, alpha_0, beta_0,
+      updateSigma(obs, alpha_0, beta_0,
                   nu.slice((i % r_stored_iters)), Phi((i % r_stored_iters),0),
                   Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
                   (i % r_stored_iters), r_stored_iters, sigma);
 
-      updateChi(y_obs, B_obs, Phi((i % r_stored_iters),0),
+      updateChi(obs, Phi((i % r_stored_iters),0),
                 nu.slice((i % r_stored_iters)), Z.slice((i % r_stored_iters)),
                 sigma((i % r_stored_iters)), (i % r_stored_iters), r_stored_iters,
                 chi);
@@ -776,7 +767,7 @@ inline Rcpp::List BFMMM_MTT(const arma::field<arma::vec>& y_obs,
 
       // Perform tempered transitions
       for(int l = 1; l < ((2 * N_t) + 1); l++){
-        updateZTempered_PM(beta_ladder(temp_ind), y_obs, B_obs,
+        updateZTempered_PM(beta_ladder(temp_ind), obs,
                            Phi_TT(l,0), nu_TT.slice(l), chi_TT.slice(l),
                            pi_TT.col(l), sigma_TT(l), l, (2 * N_t) + 1, alpha_3_TT(l), a_Z_PM,
                            Z_ph, Z_TT);
@@ -790,7 +781,7 @@ inline Rcpp::List BFMMM_MTT(const arma::field<arma::vec>& y_obs,
           }
         }
 
-        updatePhiTempered(beta_ladder(temp_ind), y_obs, B_obs,
+        updatePhiTempered(beta_ladder(temp_ind), obs,
                           nu_TT.slice(l), gamma_TT(l,0), tilde_tau, Z_TT.slice(l),
                           chi_TT.slice(l), sigma_TT(l), l, (2 * N_t) + 1, m_1, M_1,
                           Phi_TT);
@@ -801,16 +792,16 @@ inline Rcpp::List BFMMM_MTT(const arma::field<arma::vec>& y_obs,
                 var_epsilon2, l, (2 * N_t) + 1, A_TT);
         updateGamma(nu_1, delta_TT.slice(l), Phi_TT(l,0), l, (2 * N_t) + 1,
                     gamma_TT);
-        updateNuTempered(beta_ladder(temp_ind), y_obs, B_obs,
+        updateNuTempered(beta_ladder(temp_ind), obs,
                          tau_TT.row(l).t(), Phi_TT(l,0), Z_TT.slice(l),
                          chi_TT.slice(l), sigma_TT(l), l, (2 * N_t) + 1, P_mat,
                          b_1, B_1, nu_TT);
         updateTau(alpha, beta, nu_TT.slice(l), l, (2 * N_t) + 1, P_mat, tau_TT);
-        updateSigmaTempered(beta_ladder(temp_ind), y_obs, B_obs,
+        updateSigmaTempered(beta_ladder(temp_ind), obs,
                             alpha_0, beta_0, nu_TT.slice(l), Phi_TT(l,0),
                             Z_TT.slice(l), chi_TT.slice(l), l, (2 * N_t) + 1,
                             sigma_TT);
-        updateChiTempered(beta_ladder(temp_ind), y_obs, B_obs,
+        updateChiTempered(beta_ladder(temp_ind), obs,
                           Phi_TT(l,0), nu_TT.slice(l), Z_TT.slice(l), sigma_TT(l),
                           l, (2 * N_t) + 1, chi_TT);
 
@@ -822,7 +813,7 @@ inline Rcpp::List BFMMM_MTT(const arma::field<arma::vec>& y_obs,
           temp_ind = temp_ind - 1;
         }
       }
-      logA = CalculateTTAcceptance(beta_ladder, y_obs, B_obs,
+      logA = CalculateTTAcceptance(beta_ladder, obs,
                                    nu_TT, Phi_TT, Z_TT, chi_TT, sigma_TT);
       logu = std::log(R::runif(0,1));
 
@@ -861,7 +852,7 @@ inline Rcpp::List BFMMM_MTT(const arma::field<arma::vec>& y_obs,
         alpha_3((i+1) % r_stored_iters) =  alpha_3(i % r_stored_iters);
       }
     }
-    loglik((i % r_stored_iters)) =  calcLikelihood(y_obs, B_obs,
+    loglik((i % r_stored_iters)) =  calcLikelihood(obs,
            nu.slice((i % r_stored_iters)), Phi((i % r_stored_iters),0),
            Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
            sigma((i % r_stored_iters)));
@@ -872,71 +863,33 @@ inline Rcpp::List BFMMM_MTT(const arma::field<arma::vec>& y_obs,
       Rcpp::checkUserInterrupt();
     }
     if(((i+1) % r_stored_iters) == 0 && i > 1){
-      // Save parameters
-      arma::cube nu1(K, P, r_stored_iters/thinning_num, arma::fill::randn);
-      arma::cube chi1(n_funct, M, r_stored_iters/thinning_num, arma::fill::randn);
-      arma::mat pi1(K, r_stored_iters/thinning_num, arma::fill::zeros);
-      arma::vec alpha_31(r_stored_iters/thinning_num, arma::fill::zeros);
-      arma::vec sigma1(r_stored_iters/thinning_num, arma::fill::ones);
-      arma::cube A1 = arma::ones(K, 2, r_stored_iters/thinning_num);
-      arma::cube Z1 = arma::randi<arma::cube>(n_funct, K, r_stored_iters/thinning_num,
-                                              arma::distr_param(0,1));
-      arma::cube delta1(K, M, r_stored_iters/thinning_num, arma::fill::ones);
-      arma::field<arma::cube> gamma1(r_stored_iters/thinning_num,1);
-      arma::field<arma::cube> Phi1(r_stored_iters/thinning_num, 1);
-      arma::mat tau1(r_stored_iters/thinning_num, K, arma::fill::ones);
-
-      nu1.slice(0) = nu.slice(0);
-      chi1.slice(0) = chi.slice(0);
-      pi1.col(0) = pi.col(0);
-      sigma1(0) = sigma(0);
-      A1.slice(0) = A.slice(0);
-      Z1.slice(0) = Z.slice(0);
-      delta1.slice(0) = delta.slice(0);
-      gamma1(0,0) = gamma(0,0);
-      Phi1(0,0) = Phi(0,0);
-      tau1.row(0) = tau.row(0);
-
-      for(int p=1; p < r_stored_iters / thinning_num; p++){
-        nu1.slice(p) = nu.slice(thinning_num*p - 1);
-        chi1.slice(p) = chi.slice(thinning_num*p - 1);
-        pi1.col(p) = pi.col(thinning_num*p - 1);
-        alpha_31(p) = alpha_3(thinning_num*p - 1);
-        sigma1(p) = sigma(thinning_num*p - 1);
-        A1.slice(p) = A.slice(thinning_num*p - 1);
-        Z1.slice(p) = Z.slice(thinning_num*p - 1);
-        delta1.slice(p) = delta.slice(thinning_num*p - 1);
-        gamma1(p,0) = gamma(thinning_num*p - 1,0);
-        Phi1(p,0) = Phi(thinning_num*p  - 1,0);
-        tau1.row(p) = tau.row(thinning_num*p - 1);
-
-        nu1.save(directory + "Nu" + std::to_string(q) + ".txt", arma::arma_ascii);
-        chi1.save(directory + "Chi" + std::to_string(q) +".txt", arma::arma_ascii);
-        pi1.save(directory + "Pi" + std::to_string(q) +".txt", arma::arma_ascii);
-        alpha_31.save(directory + "alpha_3" + std::to_string(q) + ".txt", arma::arma_ascii);
-        A1.save(directory + "A" + std::to_string(q) +".txt", arma::arma_ascii);
-        delta1.save(directory + "Delta" + std::to_string(q) +".txt", arma::arma_ascii);
-        sigma1.save(directory + "Sigma" + std::to_string(q) +".txt", arma::arma_ascii);
-        tau1.save(directory + "Tau" + std::to_string(q) +".txt", arma::arma_ascii);
-        gamma1.save(directory + "Gamma" + std::to_string(q) +".txt");
-        Phi1.save(directory + "Phi" + std::to_string(q) +".txt");
-        Z1.save(directory + "Z" + std::to_string(q) +".txt", arma::arma_ascii);
-
-        //reset all parameters
-        nu.slice(0) = nu.slice(i % r_stored_iters);
-        chi.slice(0) = chi.slice(i % r_stored_iters);
-        pi.col(0) = pi.col(i % r_stored_iters);
-        alpha_3(0) = alpha_3(i % r_stored_iters);
-        A.slice(0) = A.slice(i % r_stored_iters);
-        delta.slice(0) = delta.slice(i % r_stored_iters);
-        sigma(0) = sigma(i % r_stored_iters);
-        tau.row(0) = tau.row(i % r_stored_iters);
-        gamma(0,0) = gamma(i % r_stored_iters, 0);
-        Phi(0,0) = Phi(i % r_stored_iters, 0);
-        Z.slice(0) = Z.slice(i % r_stored_iters);
-
-        q = q + 1;
-      }
+      // Save the retained parameters (each file is written once per batch)
+      flushRetained(retention, "Nu", nu, directory, q);
+      flushRetained(retention, "Chi", chi, directory, q);
+      flushRetainedCols(retention, "Pi", pi, directory, q);
+      flushRetained(retention, "alpha_3", alpha_3, directory, q);
+      flushRetained(retention, "A", A, directory, q);
+      flushRetained(retention, "Delta", delta, directory, q);
+      flushRetained(retention, "Sigma", sigma, directory, q);
+      flushRetainedRows(retention, "Tau", tau, directory, q);
+      flushRetained(retention, "Gamma", gamma, directory, q);
+      flushRetained(retention, "Phi", Phi, directory, q);
+      flushRetained(retention, "Z", Z, directory, q);
+
+      //reset all parameters
+      nu.slice(0) = nu.slice(i % r_stored_iters);
+      chi.slice(0) = chi.slice(i % r_stored_iters);
+      pi.col(0) = pi.col(i % r_stored_iters);
+      alpha_3(0) = alpha_3(i % r_stored_iters);
+      A.slice(0) = A.slice(i % r_stored_iters);
+      delta.slice(0) = delta.slice(i % r_stored_iters);
+      sigma(0) = sigma(i % r_stored_iters);
+      tau.row(0) = tau.row(i % r_stored_iters);
+      gamma(0,0) = gamma(i % r_stored_iters, 0);
+      Phi(0,0) = Phi(i % r_stored_iters, 0);
+      Z.slice(0) = Z.slice(i % r_stored_iters);
+
+      q = q + 1;
     }
   }
 
@@ -1022,6 +975,9 @@ inline Rcpp::List BFMMM_Nu_Z(const arma::field<arma::vec>& y_obs,
     B_obs(i,0) = bspline_mat;
   }
 
+  // Pack observations into contiguous storage
+  const RaggedObs obs = makeRaggedObs(y_obs, B_obs);
+
   arma::mat P_mat(P, P, arma::fill::zeros);
   P_mat.zeros();
   for(int j = 0; j < P_mat.n_rows; j++){
@@ -1069,7 +1025,7 @@ inline Rcpp::List BFMMM_Nu_Z(const arma::field<arma::vec>& y_obs,
   arma::mat B_1(P, P, arma::fill::zeros);
 
   for(int i = 0; i < tot_mcmc_iters; i++){
-    updateZ_PM(y_obs, B_obs, Phi(i,0),
+    updateZ_PM(obs, Phi(i,0),
                nu.slice(i), chi.slice(i),
                pi.col(i), sigma(i),
                i, tot_mcmc_iters, alpha_3(i),
@@ -1087,7 +1043,7 @@ inline Rcpp::List BFMMM_Nu_Z(const arma::field<arma::vec>& y_obs,
       }
     }
 
-    updateNu(y_obs, B_obs, tau.row((i)).t(),
+    updateNu(obs, tau.row((i)).t(),
              Phi((i),0), Z.slice((i)),
              chi.slice((i)), sigma((i)),
              (i), tot_mcmc_iters, P_mat, b_1, B_1, nu);
@@ -1095,13 +1051,13 @@ inline Rcpp::List BFMMM_Nu_Z(const arma::field<arma::vec>& y_obs,
     updateTau(alpha, beta, nu.slice((i)), (i),
               tot_mcmc_iters, P_mat, tau);
 
-    updateSigma(y_obs, B_obs, alpha_0, beta_0,
+    updateSigma(obs, alpha_0, beta_0,
                 nu.slice((i)), Phi((i),0),
                 Z.slice((i)), chi.slice((i)),
                 (i), tot_mcmc_iters, sigma);
 
     // Calculate log likelihood
-    loglik((i)) =  calcLikelihood(y_obs, B_obs, nu.slice((i)),
+    loglik((i)) =  calcLikelihood(obs, nu.slice((i)),
            Phi((i),0), Z.slice((i)), chi.slice((i)), sigma((i)));
     if(((i+1) % 100) == 0){
       Rcpp::Rcout << "Iteration: " << i+1 << "\n";
@@ -1193,6 +1149,9 @@ inline Rcpp::List BFMMM_Theta(const arma::field<arma::vec>& y_obs,
     B_obs(i,0) = bspline_mat;
   }
 
+  // Pack observations into contiguous storage
+  const RaggedObs obs = makeRaggedObs(y_obs, B_obs);
+
   arma::mat P_mat(P, P, arma::fill::zeros);
   P_mat.zeros();
   for(int j = 0; j < P_mat.n_rows; j++){
@@ -1256,7 +1215,7 @@ inline Rcpp::List BFMMM_Theta(const arma::field<arma::vec>& y_obs,
       }
     }
 
-    updatePhi(y_obs, B_obs, nu.slice((i)),
+    updatePhi(obs, nu.slice((i)),
               gamma((i),0), tilde_tau,
               Z.slice((i)), chi.slice((i)),
               sigma((i)), (i),
@@ -1275,18 +1234,18 @@ inline Rcpp::List BFMMM_Theta(const arma::field<arma::vec>& y_obs,
     updateTau(alpha, beta, nu.slice((i)), (i),
               tot_mcmc_iters, P_mat, tau);
 
-    updateSigma(y_obs, B_obs, alpha_0, beta_0,
+    updateSigma(obs, alpha_0, beta_0,
                 nu.slice((i)), Phi((i),0),
                 Z.slice((i)), chi.slice((i)),
                 (i), tot_mcmc_iters, sigma);
 
-    updateChi(y_obs, B_obs, Phi((i),0),
+    updateChi(obs, Phi((i),0),
               nu.slice((i)), Z.slice((i)),
               sigma((i)), (i), tot_mcmc_iters,
               chi);
 
     // Calculate log likelihood
-    loglik((i)) =  calcLikelihood(y_obs, B_obs, nu.slice((i)),
+    loglik((i)) =  calcLikelihood(obs, nu.slice((i)),
            Phi((i),0), Z.slice((i)), chi.slice((i)), sigma((i)));
     if(((i+1) % 100) == 0){
       Rcpp::Rcout << "Iteration: " << i+1 << "\n";
@@ -1308,48 +1267,222 @@ inline Rcpp::List BFMMM_Theta(const arma::field<arma::vec>& y_obs,
 }
 
 
-// Conducts a mixture of untempered sampling and termpered sampling to get posterior draws from the mixed membership model
+// Gets starting values for the mixed membership model by iterated conditional
+// modes (ICM): each parameter is set in turn to the mode of its full
+// conditional given the current values of the other parameters, so the log
+// posterior does not decrease at any update and the estimates converge to a
+// local maximum a posteriori (MAP) point estimate. This is not variational
+// inference: no posterior variances are computed and the estimates are only
+// used to start the MCMC. nu, Phi and chi are set to their conditional means
+// (their conditionals are Gaussian), sigma, tau, delta and gamma to the modes
+// of their (inverse) gamma conditionals, and Z, pi, alpha_3 and A to the
+// maximizers of their conditional posteriors.
 //
-// @name BFMMM_MTT_warm_start
+// @name BFMMM_ICM
 // @param y_obs Field (list) of vectors containing the observed values
 // @param t_obs Field (list) of vectors containing time points of observed values
 // @param n_funct Int containing number of functions observed
-// @param thinning_num Int containing how often we save an MCMC iteration
 // @param K Int containing the number of clusters
 // @param basis degree Int containing the degree of B-splines used
 // @param M Int containing the number of eigenfunctions
 // @param boundary_knots Vector containing the boundary points of our index domain of interest
 // @param internal_knots Vector location of internal knots for B-splines
-// @param tot_mcmc_iters Int containing total number of MCMC iterations
-// @param r_stored_iters Int constaining number of iterations performed for each batch
-// @param t_star Field (list) of vectors containing time points of interest that are not observed (optional)
-// @param rho Double containing hyperparmater for sampling from Z
-// @param alpha_3 Double hyperparameter for sampling from pi
-// @param a_12 Vec containing hyperparameters for sampling from delta
-// @param alpha1l Double containing hyperparameters for sampling from A
-// @param alpha2l Double containing hyperparameters for sampling from A
-// @param beta1l Double containing hyperparameters for sampling from A
-// @param beta2l Double containing hyperparameters for sampling from A
-// @param a_Z_PM Double containing hyperparameter used to sample from the posterior of Z
-// @param a_pi_PM Double containing hyperparameter used to sample from the posterior of pi
-// @param var_alpha3 Doubel containing hyperparameter for sampling from alpha_3
-// @param var_epslion1 Double containing hyperparameters for sampling from A having to do with variance for Metropolis-Hastings algorithm
-// @param var_epslion2 Double containing hyperparameters for sampling from A having to do with variance for Metropolis-Hastings algorithm
-// @param alpha Double containing hyperparameters for sampling from tau
-// @param beta Double containing hyperparameters for sampling from tau
-// @param alpha_0 Double containing hyperparameters for sampling from sigma
-// @param beta_0 Double containing hyperparameters for sampling from sigma
-// @param directory String containing path to store batches of MCMC samples
-// @returns params List of objects containing the MCMC samples from the last batch
-inline Rcpp::List BFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
-                                       const arma::field<arma::vec>& t_obs,
-                                       const int& n_funct,
+// @param tot_iters Int containing total number of ICM iterations
+// @param c Vector containing hyperparmeter for pi
+// @param b double containing hyperparamete for alpha_3
+// @param nu_1 Double containing hyperparameter for sampling from gamma
+// @param alpha1l Double containing hyperparameter for sampling from A
+// @param alpha2l Double containing hyperparameter for sampling from A
+// @param beta1l Double containing hyperparameter for sampling from A
+// @param beta2l Double containing hyperparameter for sampling from A
+// @param alpha Double containing hyperparameter for tau
+// @param beta Double containing hyperparameter for tau
+// @param alpha_0 Double containing hyperparameter for sigma
+// @param beta_0 Double containing hyperparameter for sigma
+// @returns params List of objects containing the estimates at each iteration
+inline Rcpp::List BFMMM_ICM(const arma::field<arma::vec>& y_obs,
+                            const arma::field<arma::vec>& t_obs,
+                            const int& n_funct,
+                            const int& K,
+                            const int basis_degree,
+                            const int& M,
+                            const arma::vec boundary_knots,
+                            const arma::vec internal_knots,
+                            const int& tot_iters,
+                            const arma::vec& c,
+                            const double& b,
+                            const double& nu_1,
+                            const double& alpha1l,
+                            const double& alpha2l,
+                            const double& beta1l,
+                            const double& beta2l,
+                            const double& alpha,
+                            const double& beta,
+                            const double& alpha_0,
+                            const double& beta_0){
+  // Make B_obs
+  arma::field<arma::mat> B_obs(n_funct,1);
+  int P = internal_knots.n_elem + basis_degree + 1;
+
+  for(int i = 0; i < n_funct; i++){
+    splines2::BSpline bspline;
+    // Create Bspline object
+    bspline = splines2::BSpline(t_obs(i,0), internal_knots, basis_degree,
+                                boundary_knots);
+    // Get Basis matrix (100 x 8)
+    arma::mat bspline_mat {bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+  }
+
+  // Pack observations into contiguous storage
+  const RaggedObs obs = makeRaggedObs(y_obs, B_obs);
+
+  arma::mat P_mat(P, P, arma::fill::zeros);
+  P_mat.zeros();
+  for(int j = 0; j < P_mat.n_rows; j++){
+    P_mat(0,0) = 1;
+    if(j > 0){
+      P_mat(j,j) = 2;
+      P_mat(j-1,j) = -1;
+      P_mat(j,j-1) = -1;
+    }
+    P_mat(P_mat.n_rows - 1, P_mat.n_rows - 1) = 1;
+  }
+
+  arma::cube nu(K, P, tot_iters, arma::fill::zeros);
+  arma::cube chi(n_funct, M, tot_iters, arma::fill::randn);
+  arma::mat pi(K, tot_iters, arma::fill::zeros);
+  pi.col(0) = c / arma::accu(c);
+  arma::vec sigma(tot_iters, arma::fill::ones);
+  arma::vec alpha_3 = arma::ones(tot_iters);
+  arma::cube Z(n_funct, K, tot_iters, arma::fill::zeros);
+  Z.slice(0).fill(1.0 / K);
+
+  arma::cube delta(K, M, tot_iters, arma::fill::ones);
+  arma::field<arma::cube> gamma(tot_iters,1);
+  arma::field<arma::cube> Phi(tot_iters, 1);
+  arma::mat tilde_tau(K, M, arma::fill::ones);
+  arma::cube A = arma::ones(K, 2, tot_iters);
+  arma::vec loglik = arma::zeros(tot_iters);
+  ConditionalMode mode;
+
+  // Phi = 0 is a fixed point of the coordinate updates of Phi and chi
+  for(int i = 0; i < tot_iters; i++){
+    gamma(i,0) = arma::cube(K, P, M, arma::fill::ones);
+    Phi(i,0) = 0.1 * arma::randn(K, P, M);
+  }
+
+  arma::vec m_1(P, arma::fill::zeros);
+  arma::mat M_1(P, P, arma::fill::zeros);
+  arma::mat tau(tot_iters, K, arma::fill::ones);
+
+  arma::vec b_1(P, arma::fill::zeros);
+  arma::mat B_1(P, P, arma::fill::zeros);
+
+  // Start nu at the (penalized) least squares fits of K functions that are
+  // far apart from each other
+  arma::mat theta(n_funct, P, arma::fill::zeros);
+  for(int i = 0; i < n_funct; i++){
+    if(obs.n_obs(i) > 0){
+      theta.row(i) = arma::solve(obs.B_i(i) * obs.B_i(i).t() + 1e-3 * P_mat,
+                obs.B_i(i) * obs.y_i(i)).t();
+    }
+  }
+  arma::vec dist = arma::sum(arma::square(theta.each_row() -
+    arma::mean(theta, 0)), 1);
+  for(int k = 0; k < K; k++){
+    int anchor = dist.index_max();
+    nu.slice(0).row(k) = theta.row(anchor);
+    dist = arma::min(dist, arma::sum(arma::square(theta.each_row() -
+      theta.row(anchor)), 1));
+  }
+
+  for(int i = 0; i < tot_iters; i++){
+    updateZICM(obs, Phi(i,0), nu.slice(i), chi.slice(i), pi.col(i),
+               alpha_3(i), sigma(i), i, tot_iters, 100, Z);
+
+    updatePiICM(alpha_3(i), Z.slice(i), c, (i), tot_iters, 100, pi);
+
+    updateAlpha3ICM(pi.col(i), b, Z.slice(i), (i), tot_iters, alpha_3);
+
+    for(int k = 0; k < K; k++){
+      tilde_tau(k, 0) = delta(k, 0, i);
+      for(int j = 1; j < M; j++){
+        tilde_tau(k, j) = tilde_tau(k, j-1) * delta(k, j, i);
+      }
+    }
+
+    updateNuICM(obs, tau.row((i)).t(),
+                Phi((i),0), Z.slice((i)),
+                chi.slice((i)), sigma((i)),
+                (i), tot_iters, P_mat, b_1, B_1, nu);
+
+    updatePhiICM(obs, nu.slice((i)),
+                 gamma((i),0), tilde_tau,
+                 Z.slice((i)), chi.slice((i)),
+                 sigma((i)), (i),
+                 tot_iters, m_1, M_1, Phi);
+
+    updateChiICM(obs, Phi((i),0),
+                 nu.slice((i)), Z.slice((i)),
+                 sigma((i)), (i), tot_iters,
+                 chi);
+
+    updateDelta(Phi((i),0), gamma((i),0),
+                A.slice(i), (i),
+                tot_iters, mode, delta);
+
+    updateAICM(alpha1l, beta1l, alpha2l, beta2l, delta.slice((i)),
+               (i), tot_iters, A);
+
+    updateGamma(nu_1, delta.slice((i)), Phi((i),0),
+                (i), tot_iters, mode, gamma);
+
+    updateTauICM(alpha, beta, nu.slice((i)), (i),
+                 tot_iters, P_mat, tau);
+
+    updateSigmaICM(obs, alpha_0, beta_0,
+                   nu.slice((i)), Phi((i),0),
+                   Z.slice((i)), chi.slice((i)),
+                   (i), tot_iters, sigma);
+
+    // Calculate log likelihood
+    loglik((i)) =  calcLikelihood(obs, nu.slice((i)),
+           Phi((i),0), Z.slice((i)), chi.slice((i)), sigma((i)));
+    if(((i+1) % 100) == 0){
+      Rcpp::Rcout << "Iteration: " << i+1 << "\n";
+      Rcpp::Rcout << "Log-likelihood: " << loglik((i)) << "\n";
+      Rcpp::checkUserInterrupt();
+    }
+  }
+  Rcpp::List params = Rcpp::List::create(Rcpp::Named("nu", nu),
+                                         Rcpp::Named("pi", pi),
+                                         Rcpp::Named("alpha_3", alpha_3),
+                                         Rcpp::Named("A", A),
+                                         Rcpp::Named("delta", delta),
+                                         Rcpp::Named("sigma", sigma),
+                                         Rcpp::Named("tau", tau),
+                                         Rcpp::Named("gamma", gamma),
+                                         Rcpp::Named("Phi", Phi),
+                                         Rcpp::Named("Z", Z),
+                                         Rcpp::Named("chi", chi),
+                                         Rcpp::Named("loglik", loglik));
+  return params;
+}
+
+// Conducts a mixture of untempered sampling and termpered sampling to get
+// posterior draws from the mixed membership model using observations that are
+// already packed (and possibly compressed, see compressRaggedObs) in double
+// (RaggedObs) or single (RaggedObsF) precision. Every kernel that reads the
+// observations reads obs. The other parameters are the same as below.
+//
+// @name BFMMM_MTT_warm_start
+// @param obs RaggedObs or RaggedObsF containing observed values and basis functions
+template<class Obs>
+inline Rcpp::List BFMMM_MTT_warm_start(const Obs& obs,
                                        const int& thinning_num,
                                        const int& K,
-                                       const int basis_degree,
                                        const int& M,
-                                       const arma::vec boundary_knots,
-                                       const arma::vec internal_knots,
                                        const int& tot_mcmc_iters,
                                        const int& r_stored_iters,
                                        const int& n_temp_trans,
@@ -1382,10 +1515,1061 @@ inline Rcpp::List BFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
                                        const arma::mat& nu_est,
                                        const arma::vec& tau_est,
                                        const double& sigma_est,
-                                       const arma::mat& chi_est){
+                                       const arma::mat& chi_est,
+                                       const arma::mat& B_grid,
+                                       const arma::vec& summary_probs,
+                                       const int& summary_burnin,
+                                       const int& n_adapt,
+                                       const int& n_adapt_ladder,
+                                       const double& step_Z,
+                                       const int& n_leapfrog_Z,
+                                       const bool& parallel_sweep,
+                                       const RetentionPolicy& retention){
+  int n_funct = obs.n_funct();
+  int P = obs.B_t.n_rows;
+
+  arma::mat P_mat(P, P, arma::fill::zeros);
+  P_mat.zeros();
+  for(int j = 0; j < P_mat.n_rows; j++){
+    P_mat(0,0) = 1;
+    if(j > 0){
+      P_mat(j,j) = 2;
+      P_mat(j-1,j) = -1;
+      P_mat(j,j-1) = -1;
+    }
+    P_mat(P_mat.n_rows - 1, P_mat.n_rows - 1) = 1;
+  }
+
+  arma::cube nu(K, P, r_stored_iters, arma::fill::randn);
+  arma::cube chi(n_funct, M, r_stored_iters, arma::fill::randn);
+  arma::mat pi(K, r_stored_iters, arma::fill::zeros);
+  arma::vec pi_ph = arma::zeros(K);
+  pi.col(0) = rdirichlet(c);
+  arma::vec sigma(r_stored_iters, arma::fill::ones);
+  arma::vec Z_ph = arma::zeros(K);
+  arma::vec alpha_3 = arma::ones(r_stored_iters);
+  arma::cube Z = arma::randi<arma::cube>(n_funct, K, r_stored_iters,
+                                         arma::distr_param(0,1));
+
+  for(int i = 0; i < n_funct; i++){
+    Z.slice(0).row(i) = rdirichlet(pi.col(0) * 100).t();
+  }
+
+  arma::cube delta(K, M, r_stored_iters, arma::fill::ones);
+  arma::field<arma::cube> gamma(r_stored_iters,1);
+  arma::field<arma::cube> Phi(r_stored_iters, 1);
+  arma::mat tilde_tau(K, M, arma::fill::ones);
+  arma::cube A = arma::ones(K, 2, r_stored_iters);
+  arma::vec loglik = arma::zeros(r_stored_iters);
+
+  // start numbering for output files
+  int q = 0;
+
+  for(int i = 0; i < r_stored_iters; i++){
+    gamma(i,0) = arma::cube(K, P, M, arma::fill::ones);
+    Phi(i,0) = arma::randn(K, P, M);
+  }
+
+  arma::vec m_1(P, arma::fill::zeros);
+  arma::mat M_1(P, P, arma::fill::zeros);
+  arma::mat tau(r_stored_iters, K, arma::fill::ones);
+
+  arma::vec b_1(P, arma::fill::zeros);
+  arma::mat B_1(P, P, arma::fill::zeros);
+
+  // Online posterior summaries of the mean and covariance functions
+  bool use_summary = (B_grid.n_elem > 0);
+  OnlineSummary summary(B_grid, K, summary_probs);
+  arma::mat nu_mean(K, P, arma::fill::zeros);
+
+  // Proposal scales of the Metropolis-Hastings steps (adapted during the
+  // first n_adapt iterations)
+  ProposalTuning tuning = makeProposalTuning(n_funct, a_Z_PM, a_pi_PM,
+                                             var_alpha3, var_epsilon1,
+                                             var_epsilon2, step_Z, n_leapfrog_Z,
+                                             n_adapt);
+  arma::vec accept_TT(n_funct);
+
+  // Work-stealing scheduler of the loops over functions (weighted by the
+  // number of observed time points of each function)
+  SubjectScheduler subject_sched = makeSubjectScheduler(obs);
+  // Scratch memory of the serial nu and Phi updates
+  Workspace sweep_ws = makeWorkspace();
+
+  // Create parameters for tempered transitions using geometric scheme
+  arma::vec beta_ladder(N_t, arma::fill::ones);
+  beta_ladder(N_t - 1) = beta_N_t;
+  double geom_mult = std::pow(beta_N_t, 1.0/N_t);
+  // Rcpp::Rcout << "geom_mult: " << geom_mult << "\n";
+  for(int i = 1; i < N_t; i++){
+    beta_ladder(i) = beta_ladder(i-1) * geom_mult;
+    // beta_ladder(i) = 1 - ((1- beta_N_t) *(std::pow(i/ (N_t - 1.0), 2.0)));
+    // Rcpp::Rcout << "beta_i: " << beta_ladder(i) << "\n";
+  }
+  // Statistics of the rungs of the ladder (the ladder is respaced every
+  // ladder_batch tempered transitions during the first n_adapt_ladder
+  // iterations)
+  LadderStats ladder_stats = makeLadderStats(N_t);
+  arma::vec loglik_TT((2 * N_t) + 1);
+  int ladder_batch = 5;
+  // Create storage for tempered transitions
+  arma::cube nu_TT(K, P, (2 * N_t) + 1, arma::fill::randn);
+  arma::cube chi_TT(n_funct, M, (2 * N_t) + 1, arma::fill::randn);
+  arma::mat pi_TT(K, (2 * N_t) + 1, arma::fill::zeros);
+  arma::vec sigma_TT((2 * N_t) + 1, arma::fill::ones);
+  arma::cube Z_TT = arma::randi<arma::cube>(n_funct, K, (2 * N_t) + 1,
+                                            arma::distr_param(0,1));
+  arma::cube delta_TT(K, M, (2 * N_t) + 1, arma::fill::ones);
+  arma::field<arma::cube> gamma_TT((2 * N_t) + 1, 1);
+  arma::field<arma::cube> Phi_TT((2 * N_t) + 1, 1);
+  arma::cube A_TT = arma::ones(K, 2, (2 * N_t) + 1);
+  arma::vec alpha_3_TT = arma::ones((2 * N_t) + 1);
+
+  for(int i = 0; i < ((2 * N_t) + 1); i++){
+    gamma_TT(i,0) = arma::cube(K, P, M, arma::fill::ones);
+    Phi_TT(i,0) = arma::randn(K, P, M);
+  }
+
+  arma::mat tau_TT((2 * N_t) + 1, K, arma::fill::ones);
+
+  int temp_ind = 0;
+  double logA = 0;
+  double logu = 0;
+  int accept_num = 0;
+
+  Z.slice(0) = Z_est;
+  pi.col(0) = pi_est;
+
+  alpha_3(0) = alpha_3_est;
+  delta.slice(0) = delta_est;
+  gamma(0,0) = gamma_est;
+  Phi(0,0) = Phi_est;
+  A.slice(0) = A_est;
+  nu.slice(0) = nu_est;
+  tau.row(0) = tau_est.t();
+  sigma(0) = sigma_est;
+
+  chi.slice(0) = chi_est;
+  nu_mean = nu_est;
+
+  // Blocks of the untempered Gibbs sweep (only used if parallel_sweep is true).
+  // The prior-side updates use their own random number engines so they can run
+  // alongside the likelihood-side updates, which use R's random number
+  // generator on the main thread.
+  int iter_ind = 0;
+  GibbsSchedule sweep;
+  if(parallel_sweep){
+    int b_Z = addGibbsBlock({}, true, [&](std::mt19937_64& rng){
+      if(n_leapfrog_Z > 0){
+        updateZHMC_PM(obs, Phi(iter_ind,0), nu.slice(iter_ind),
+                      chi.slice(iter_ind), pi.col(iter_ind), sigma(iter_ind),
+                      iter_ind, r_stored_iters, alpha_3(iter_ind),
+                      tuning.step_Z, n_leapfrog_Z, subject_sched,
+                      tuning.accept_Z, Z);
+      }else{
+        updateZ_PM(obs, Phi(iter_ind,0), nu.slice(iter_ind),
+                   chi.slice(iter_ind), pi.col(iter_ind), sigma(iter_ind),
+                   iter_ind, r_stored_iters, alpha_3(iter_ind),
+                   tuning.a_Z_PM, subject_sched, Z_ph, tuning.accept_Z, Z);
+      }
+    }, sweep);
+    int b_pi = addGibbsBlock({b_Z}, false, [&](std::mt19937_64& rng){
+      updatePi_PM(alpha_3(iter_ind), Z.slice(iter_ind), c, iter_ind,
+                  r_stored_iters, tuning.a_pi_PM, pi_ph, rng, tuning.accept_pi,
+                  pi);
+    }, sweep);
+    addGibbsBlock({b_pi}, false, [&](std::mt19937_64& rng){
+      updateAlpha3(pi.col(iter_ind), b, Z.slice(iter_ind), iter_ind,
+                   r_stored_iters, tuning.var_alpha3, rng,
+                   tuning.accept_alpha3, alpha_3);
+    }, sweep);
+    int b_Phi = addGibbsBlock({b_Z}, true, [&](std::mt19937_64& rng){
+      for(int k = 0; k < K; k++){
+        tilde_tau(k, 0) = delta(k, 0, iter_ind);
+        for(int j = 1; j < M; j++){
+          tilde_tau(k, j) = tilde_tau(k, j-1) * delta(k, j, iter_ind);
+        }
+      }
+      updatePhi(obs, nu.slice(iter_ind), gamma(iter_ind,0), tilde_tau,
+                Z.slice(iter_ind), chi.slice(iter_ind), sigma(iter_ind),
+                iter_ind, r_stored_iters, sweep_ws, m_1, M_1, Phi);
+    }, sweep);
+    int b_delta = addGibbsBlock({b_Phi}, false, [&](std::mt19937_64& rng){
+      updateDelta(Phi(iter_ind,0), gamma(iter_ind,0), A.slice(iter_ind),
+                  iter_ind, r_stored_iters, rng, delta);
+    }, sweep);
+    addGibbsBlock({b_delta}, false, [&](std::mt19937_64& rng){
+      updateA(alpha1l, beta1l, alpha2l, beta2l, delta.slice(iter_ind),
+              tuning.var_epsilon1, tuning.var_epsilon2, iter_ind,
+              r_stored_iters, rng, tuning.accept_A, A);
+    }, sweep);
+    addGibbsBlock({b_delta}, false, [&](std::mt19937_64& rng){
+      updateGamma(nu_1, delta.slice(iter_ind), Phi(iter_ind,0), iter_ind,
+                  r_stored_iters, rng, gamma);
+    }, sweep);
+    int b_nu = addGibbsBlock({b_Phi}, true, [&](std::mt19937_64& rng){
+      updateNu(obs, tau.row(iter_ind).t(), Phi(iter_ind,0), Z.slice(iter_ind),
+               chi.slice(iter_ind), sigma(iter_ind), iter_ind, r_stored_iters,
+               P_mat, sweep_ws, b_1, B_1, nu, nu_mean);
+    }, sweep);
+    addGibbsBlock({b_nu}, false, [&](std::mt19937_64& rng){
+      updateTau(alpha, beta, nu.slice(iter_ind), iter_ind, r_stored_iters,
+                P_mat, rng, tau);
+    }, sweep);
+    int b_sigma = addGibbsBlock({b_nu}, true, [&](std::mt19937_64& rng){
+      updateSigma(obs, alpha_0, beta_0, nu.slice(iter_ind), Phi(iter_ind,0),
+                  Z.slice(iter_ind), chi.slice(iter_ind), iter_ind,
+                  r_stored_iters, subject_sched, sigma);
+    }, sweep);
+    addGibbsBlock({b_sigma}, true, [&](std::mt19937_64& rng){
+      updateChi(obs, Phi(iter_ind,0), nu.slice(iter_ind), Z.slice(iter_ind),
+                sigma(iter_ind), iter_ind, r_stored_iters, subject_sched, chi);
+    }, sweep);
+  }
+
+  for(int i=0; i < tot_mcmc_iters; i++){
+    if(((i % n_temp_trans) != 0) || (i == 0)){
+      if(parallel_sweep){
+        iter_ind = i % r_stored_iters;
+        runGibbsSchedule(sweep);
+      }else{
+        if(n_leapfrog_Z > 0){
+          updateZHMC_PM(obs, Phi((i % r_stored_iters),0),
+                        nu.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
+                        pi.col((i % r_stored_iters)), sigma((i % r_stored_iters)),
+                        (i % r_stored_iters), r_stored_iters, alpha_3(i % r_stored_iters),
+                        tuning.step_Z, n_leapfrog_Z, subject_sched,
+                        tuning.accept_Z, Z);
+        }else{
+          updateZ_PM(obs, Phi((i % r_stored_iters),0),
+                     nu.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
+                     pi.col((i % r_stored_iters)), sigma((i % r_stored_iters)),
+                     (i % r_stored_iters), r_stored_iters, alpha_3(i % r_stored_iters),
+                     tuning.a_Z_PM, subject_sched, Z_ph, tuning.accept_Z, Z);
+        }
+
+        updatePi_PM(alpha_3(i % r_stored_iters) ,Z.slice(i% r_stored_iters), c,
+                    (i % r_stored_iters), r_stored_iters, tuning.a_pi_PM, pi_ph,
+                    tuning.accept_pi, pi);
+
+        updateAlpha3(pi.col(i % r_stored_iters), b, Z.slice(i % r_stored_iters),
+                     (i % r_stored_iters), r_stored_iters, tuning.var_alpha3,
+                     tuning.accept_alpha3, alpha_3);
+
+        for(int k = 0; k < K; k++){
+          tilde_tau(k, 0) = delta(k, 0, (i % r_stored_iters));
+          for(int j = 1; j < M; j++){
+            tilde_tau(k, j) = tilde_tau(k, j-1) * delta(k, j,(i % r_stored_iters));
+          }
+        }
+
+        updatePhi(obs, nu.slice((i % r_stored_iters)),
+                  gamma((i % r_stored_iters),0), tilde_tau,
+                  Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
+                  sigma((i % r_stored_iters)), (i % r_stored_iters),
+                  r_stored_iters, sweep_ws, m_1, M_1, Phi);
+
+        updateDelta(Phi((i % r_stored_iters),0), gamma((i % r_stored_iters),0),
+                    A.slice(i % r_stored_iters), (i % r_stored_iters),
+                    r_stored_iters, delta);
+
+        updateA(alpha1l, beta1l, alpha2l, beta2l, delta.slice((i % r_stored_iters)),
+                tuning.var_epsilon1, tuning.var_epsilon2, (i % r_stored_iters),
+                r_stored_iters, tuning.accept_A, A);
+
+        updateGamma(nu_1, delta.slice((i % r_stored_iters)), Phi((i % r_stored_iters),0),
+                    (i % r_stored_iters), r_stored_iters, gamma);
+
+        updateNu(obs, tau.row((i % r_stored_iters)).t(),
+                 Phi((i % r_stored_iters),0), Z.slice((i % r_stored_iters)),
+                 chi.slice((i % r_stored_iters)), sigma((i % r_stored_iters)),
+                 (i % r_stored_iters), r_stored_iters, P_mat, sweep_ws, b_1,
+                 B_1, nu, nu_mean);
+
+        updateTau(alpha, beta, nu.slice((i % r_stored_iters)), (i % r_stored_iters),
+                  r_stored_iters, P_mat, tau);
+
+        updateSigma(obs, alpha_0, beta_0,
+                    nu.slice((i % r_stored_iters)), Phi((i % r_stored_iters),0),
+                    Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
+                    (i % r_stored_iters), r_stored_iters, subject_sched, sigma);
+
+        updateChi(obs, Phi((i % r_stored_iters),0),
+                  nu.slice((i % r_stored_iters)), Z.slice((i % r_stored_iters)),
+                  sigma((i % r_stored_iters)), (i % r_stored_iters), r_stored_iters,
+                  subject_sched, chi);
+      }
+
+      updateProposalTuning(i, tuning);
+    }
+
+    if((i % n_temp_trans) == 0 && (i > 0)){
+      // initialize placeholders
+      nu_TT.slice(0) = nu.slice (i % r_stored_iters);
+      chi_TT.slice(0) = chi.slice(i % r_stored_iters);
+      pi_TT.col(0) = pi.col(i % r_stored_iters);
+      sigma_TT(0) = sigma(i % r_stored_iters);
+      Z_TT.slice(0) = Z.slice(i % r_stored_iters);
+      delta_TT.slice(0) = delta.slice(i % r_stored_iters);
+      gamma_TT(0,0) = gamma(i % r_stored_iters,0);
+      Phi_TT(0,0) = Phi(i % r_stored_iters,0);
+      A_TT.slice(0) = A.slice(i % r_stored_iters);
+      tau_TT.row(0) = tau.row(i % r_stored_iters);
+      alpha_3_TT(0) = alpha_3(i % r_stored_iters);
+
+      nu_TT.slice(1) = nu.slice(i % r_stored_iters);
+      chi_TT.slice(1) = chi.slice(i % r_stored_iters);
+      pi_TT.col(1) = pi.col(i % r_stored_iters);
+      sigma_TT(1) = sigma(i % r_stored_iters);
+      Z_TT.slice(1) = Z.slice(i % r_stored_iters);
+      delta_TT.slice(1) = delta.slice(i % r_stored_iters);
+      gamma_TT(1,0) = gamma(i % r_stored_iters,0);
+      Phi_TT(1,0) = Phi(i % r_stored_iters,0);
+      A_TT.slice(1) = A.slice(i % r_stored_iters);
+      tau_TT.row(1) = tau.row(i % r_stored_iters);
+      alpha_3_TT(1) = alpha_3(i % r_stored_iters);
+
+      temp_ind = 0;
+
+      // Perform tempered transitions
+      for(int l = 1; l < ((2 * N_t) + 1); l++){
+        if(n_leapfrog_Z > 0){
+          updateZTemperedHMC_PM(beta_ladder(temp_ind), obs,
+                                Phi_TT(l,0), nu_TT.slice(l), chi_TT.slice(l),
+                                pi_TT.col(l), sigma_TT(l), l, (2 * N_t) + 1,
+                                alpha_3_TT(l), tuning.step_Z, n_leapfrog_Z,
+                                subject_sched, accept_TT, Z_TT);
+        }else{
+          updateZTempered_PM(beta_ladder(temp_ind), obs,
+                             Phi_TT(l,0), nu_TT.slice(l), chi_TT.slice(l),
+                             pi_TT.col(l), sigma_TT(l), l, (2 * N_t) + 1, alpha_3_TT(l),
+                             tuning.a_Z_PM, subject_sched, Z_ph, accept_TT, Z_TT);
+        }
+        updatePi_PM(alpha_3_TT(l), Z_TT.slice(l), c, l, (2 * N_t) + 1,
+                    tuning.a_pi_PM, pi_ph, pi_TT);
+        updateAlpha3(pi_TT.col(l), b, Z_TT.slice(l), l, (2 * N_t) + 1,
+                     tuning.var_alpha3, alpha_3_TT);
+
+        for(int k = 0; k < K; k++){
+          tilde_tau(k, 0) = delta_TT(k, 0, l);
+          for(int j = 1; j < M; j++){
+            tilde_tau(k, j) = tilde_tau(k, j-1) * delta_TT(k, j, l);
+          }
+        }
+
+        updatePhiTempered(beta_ladder(temp_ind), obs,
+                          nu_TT.slice(l), gamma_TT(l,0), tilde_tau, Z_TT.slice(l),
+                          chi_TT.slice(l), sigma_TT(l), l, (2 * N_t) + 1, sweep_ws,
+                          m_1, M_1, Phi_TT);
+        updateDelta(Phi_TT(l,0), gamma_TT(l,0), A_TT.slice(l), l, (2 * N_t) + 1,
+                    delta_TT);
+
+        updateA(alpha1l, beta1l, alpha2l, beta2l, delta_TT.slice(l),
+                tuning.var_epsilon1, tuning.var_epsilon2, l, (2 * N_t) + 1, A_TT);
+        updateGamma(nu_1, delta_TT.slice(l), Phi_TT(l,0), l, (2 * N_t) + 1,
+                    gamma_TT);
+        updateNuTempered(beta_ladder(temp_ind), obs,
+                         tau_TT.row(l).t(), Phi_TT(l,0), Z_TT.slice(l),
+                         chi_TT.slice(l), sigma_TT(l), l, (2 * N_t) + 1, P_mat,
+                         sweep_ws, b_1, B_1, nu_TT);
+        updateTau(alpha, beta, nu_TT.slice(l), l, (2 * N_t) + 1, P_mat, tau_TT);
+        updateSigmaTempered(beta_ladder(temp_ind), obs,
+                            alpha_0, beta_0, nu_TT.slice(l), Phi_TT(l,0),
+                            Z_TT.slice(l), chi_TT.slice(l), l, (2 * N_t) + 1,
+                            subject_sched, sigma_TT);
+        updateChiTempered(beta_ladder(temp_ind), obs,
+                          Phi_TT(l,0), nu_TT.slice(l), Z_TT.slice(l), sigma_TT(l),
+                          l, (2 * N_t) + 1, subject_sched, chi_TT);
+        // update temp_ind
+        if(l < N_t){
+          temp_ind = temp_ind + 1;
+        }
+        if(l > N_t){
+          temp_ind = temp_ind - 1;
+        }
+      }
+      loglik_TT = calcTTLoglik(obs, nu_TT, Phi_TT, Z_TT, chi_TT, sigma_TT);
+      logA = CalculateTTAcceptance(beta_ladder, loglik_TT);
+      logu = std::log(R::runif(0,1));
+      updateLadderStats(beta_ladder, loglik_TT, logu < logA, ladder_stats);
+      if((i < n_adapt_ladder) && (ladder_stats.n_trans >= ladder_batch)){
+        beta_ladder = adaptTemperatureLadder(beta_ladder, ladder_stats);
+        ladder_stats = makeLadderStats(N_t);
+      }
+
+      if(logu < logA){
+        nu.slice(i % r_stored_iters) = nu_TT.slice(2 * N_t);
+        chi.slice(i % r_stored_iters) = chi_TT.slice(2 * N_t);
+        pi.col(i % r_stored_iters) = pi_TT.col(2 * N_t);
+        sigma(i % r_stored_iters) = sigma_TT(2 * N_t);
+        Z.slice(i % r_stored_iters) = Z_TT.slice(2 * N_t);
+        delta.slice(i % r_stored_iters) = delta_TT.slice(2 * N_t);
+        gamma(i % r_stored_iters,0) = gamma_TT(2 * N_t,0);
+        Phi(i % r_stored_iters,0) = Phi_TT(2 * N_t,0);
+        A.slice(i % r_stored_iters) = A_TT.slice(2 * N_t);
+        tau.row(i % r_stored_iters) = tau_TT.row(2 * N_t);
+        alpha_3(i % r_stored_iters) = alpha_3_TT(2 * N_t);
+
+        //update accept number
+        accept_num = accept_num + 1;
+      }
+      // no conditional mean is available after a tempered transition
+      nu_mean = nu.slice(i % r_stored_iters);
+
+      //initialize next state
+      if(((i+1) % r_stored_iters) != 0){
+        nu.slice((i+1) % r_stored_iters) = nu.slice(i % r_stored_iters);
+        chi.slice((i+1) % r_stored_iters) = chi.slice(i % r_stored_iters);
+        pi.col((i+1) % r_stored_iters) = pi.col(i % r_stored_iters);
+        sigma((i+1) % r_stored_iters) = sigma(i % r_stored_iters);
+        Z.slice((i+1) % r_stored_iters) = Z.slice(i % r_stored_iters);
+        delta.slice((i+1) % r_stored_iters) = delta.slice(i % r_stored_iters);
+        A.slice((i+1) % r_stored_iters) = A.slice(i % r_stored_iters);
+        tau.row((i+1) % r_stored_iters) = tau.row(i % r_stored_iters);
+        Phi((i+1) % r_stored_iters,0) = Phi(i % r_stored_iters, 0);
+        alpha_3((i+1) % r_stored_iters) =  alpha_3(i % r_stored_iters);
+      }
+    }
+    loglik((i % r_stored_iters)) =  calcLikelihood(obs,
+           nu.slice((i % r_stored_iters)), Phi((i % r_stored_iters),0),
+           Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
+           sigma((i % r_stored_iters)), subject_sched);
+    if(((i+1) % 100) == 0){
+      Rcpp::Rcout << "Iteration: " << i+1 << "\n";
+      Rcpp::Rcout << "Accpetance Probability: " << accept_num / (std::round(i / n_temp_trans)) << "\n";
+      Rcpp::Rcout << "Log-likelihood: " << arma::mean(loglik.subvec((i % r_stored_iters)-4, (i % r_stored_iters))) << "\n";
+      Rcpp::checkUserInterrupt();
+    }
+    if(use_summary && (i >= summary_burnin) &&
+       (((i - summary_burnin + 1) % thinning_num) == 0)){
+      summary.update(nu.slice(i % r_stored_iters), nu_mean,
+                     Phi(i % r_stored_iters, 0));
+    }
+    if(((i+1) % r_stored_iters) == 0 && i > 1 && !directory.empty()){
+      // Save the retained parameters (each file is written once per batch)
+      flushRetained(retention, "Nu", nu, directory, q);
+      flushRetained(retention, "Chi", chi, directory, q);
+      flushRetainedCols(retention, "Pi", pi, directory, q);
+      flushRetained(retention, "alpha_3", alpha_3, directory, q);
+      flushRetained(retention, "A", A, directory, q);
+      flushRetained(retention, "Delta", delta, directory, q);
+      flushRetained(retention, "Sigma", sigma, directory, q);
+      flushRetainedRows(retention, "Tau", tau, directory, q);
+      flushRetained(retention, "Gamma", gamma, directory, q);
+      flushRetained(retention, "Phi", Phi, directory, q);
+      flushRetained(retention, "Z", Z, directory, q);
+      q = q + 1;
+    }
+    if(((i+1) % r_stored_iters) == 0 && i > 1){
+      //reset all parameters
+      nu.slice(0) = nu.slice(i % r_stored_iters);
+      chi.slice(0) = chi.slice(i % r_stored_iters);
+      pi.col(0) = pi.col(i % r_stored_iters);
+      alpha_3(0) = alpha_3(i % r_stored_iters);
+      A.slice(0) = A.slice(i % r_stored_iters);
+      delta.slice(0) = delta.slice(i % r_stored_iters);
+      sigma(0) = sigma(i % r_stored_iters);
+      tau.row(0) = tau.row(i % r_stored_iters);
+      gamma(0,0) = gamma(i % r_stored_iters, 0);
+      Phi(0,0) = Phi(i % r_stored_iters, 0);
+      Z.slice(0) = Z.slice(i % r_stored_iters);
+    }
+  }
+
+  Rcpp::List params = Rcpp::List::create(Rcpp::Named("nu", nu),
+                                         Rcpp::Named("alpha_3", alpha_3),
+                                         Rcpp::Named("chi", chi),
+                                         Rcpp::Named("pi", pi),
+                                         Rcpp::Named("A", A),
+                                         Rcpp::Named("delta", delta),
+                                         Rcpp::Named("sigma", sigma),
+                                         Rcpp::Named("tau", tau),
+                                         Rcpp::Named("gamma", gamma),
+                                         Rcpp::Named("Phi", Phi),
+                                         Rcpp::Named("Z", Z),
+                                         Rcpp::Named("loglik", loglik));
+  if(use_summary){
+    params.push_back(summary.summary(), "summary");
+  }
+  if(n_adapt > 0){
+    params.push_back(summarizeProposalTuning(tuning), "tuning");
+  }
+  if(n_temp_trans <= tot_mcmc_iters){
+    params.push_back(summarizeLadderStats(beta_ladder, ladder_stats), "ladder");
+  }
+  params.push_back(summarizeSubjectScheduler(subject_sched), "utilization");
+  return params;
+}
+
+// Conducts a mixture of untempered sampling and termpered sampling using
+// packed observations. If single_precision is true, the observations are
+// rounded to single precision and the double precision copy is released
+// before sampling, so every kernel reads the single precision copy and only
+// one copy of the observations is kept in memory.
+//
+// @name BFMMM_MTT_warm_start
+// @param obs RaggedObs containing observed values and basis functions (moved from by the caller)
+// @param single_precision Boolean indicating whether the sampler reads a single precision copy of the observations and basis functions
+inline Rcpp::List BFMMM_MTT_warm_start(RaggedObs obs,
+                                       const int& thinning_num,
+                                       const int& K,
+                                       const int& M,
+                                       const int& tot_mcmc_iters,
+                                       const int& r_stored_iters,
+                                       const int& n_temp_trans,
+                                       const arma::vec& c,
+                                       const double& b,
+                                       const double& nu_1,
+                                       const double& alpha1l,
+                                       const double& alpha2l,
+                                       const double& beta1l,
+                                       const double& beta2l,
+                                       const double& a_Z_PM,
+                                       const double& a_pi_PM,
+                                       const double& var_alpha3,
+                                       const double& var_epsilon1,
+                                       const double& var_epsilon2,
+                                       const double& alpha,
+                                       const double& beta,
+                                       const double& alpha_0,
+                                       const double& beta_0,
+                                       const std::string directory,
+                                       const double& beta_N_t,
+                                       const int& N_t,
+                                       const arma::mat& Z_est,
+                                       const arma::vec& pi_est,
+                                       const double& alpha_3_est,
+                                       const arma::mat& delta_est,
+                                       const arma::cube& gamma_est,
+                                       const arma::cube& Phi_est,
+                                       const arma::mat& A_est,
+                                       const arma::mat& nu_est,
+                                       const arma::vec& tau_est,
+                                       const double& sigma_est,
+                                       const arma::mat& chi_est,
+                                       const arma::mat& B_grid,
+                                       const arma::vec& summary_probs,
+                                       const int& summary_burnin,
+                                       const int& n_adapt,
+                                       const int& n_adapt_ladder,
+                                       const double& step_Z,
+                                       const int& n_leapfrog_Z,
+                                       const bool& parallel_sweep,
+                                       const bool& single_precision,
+                                       const RetentionPolicy& retention){
+  if(single_precision){
+    const RaggedObsF obs_f = makeRaggedObsF(obs);
+    obs = RaggedObs();
+    return BFMMM_MTT_warm_start(obs_f, thinning_num, K, M, tot_mcmc_iters,
+                                r_stored_iters, n_temp_trans, c, b, nu_1,
+                                alpha1l, alpha2l, beta1l, beta2l, a_Z_PM,
+                                a_pi_PM, var_alpha3, var_epsilon1, var_epsilon2,
+                                alpha, beta, alpha_0, beta_0, directory,
+                                beta_N_t, N_t, Z_est, pi_est, alpha_3_est,
+                                delta_est, gamma_est, Phi_est, A_est, nu_est,
+                                tau_est, sigma_est, chi_est, B_grid,
+                                summary_probs, summary_burnin, n_adapt,
+                                n_adapt_ladder, step_Z, n_leapfrog_Z,
+                                parallel_sweep, retention);
+  }
+  return BFMMM_MTT_warm_start(obs, thinning_num, K, M, tot_mcmc_iters,
+                              r_stored_iters, n_temp_trans, c, b, nu_1, alpha1l,
+                              alpha2l, beta1l, beta2l, a_Z_PM, a_pi_PM,
+                              var_alpha3, var_epsilon1, var_epsilon2, alpha,
+                              beta, alpha_0, beta_0, directory, beta_N_t, N_t,
+                              Z_est, pi_est, alpha_3_est, delta_est, gamma_est,
+                              Phi_est, A_est, nu_est, tau_est, sigma_est,
+                              chi_est, B_grid, summary_probs, summary_burnin,
+                              n_adapt, n_adapt_ladder, step_Z, n_leapfrog_Z,
+                              parallel_sweep, retention);
+}
+
+// Conducts a mixture of untempered sampling and termpered sampling to get posterior draws from the mixed membership model
+//
+// @name BFMMM_MTT_warm_start
+// @param y_obs Field (list) of vectors containing the observed values
+// @param t_obs Field (list) of vectors containing time points of observed values
+// @param n_funct Int containing number of functions observed
+// @param thinning_num Int containing how often we save an MCMC iteration
+// @param K Int containing the number of clusters
+// @param basis degree Int containing the degree of B-splines used
+// @param M Int containing the number of eigenfunctions
+// @param boundary_knots Vector containing the boundary points of our index domain of interest
+// @param internal_knots Vector location of internal knots for B-splines
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param r_stored_iters Int constaining number of iterations performed for each batch
+// @param t_star Field (list) of vectors containing time points of interest that are not observed (optional)
+// @param rho Double containing hyperparmater for sampling from Z
+// @param alpha_3 Double hyperparameter for sampling from pi
+// @param a_12 Vec containing hyperparameters for sampling from delta
+// @param alpha1l Double containing hyperparameters for sampling from A
+// @param alpha2l Double containing hyperparameters for sampling from A
+// @param beta1l Double containing hyperparameters for sampling from A
+// @param beta2l Double containing hyperparameters for sampling from A
+// @param a_Z_PM Double containing hyperparameter used to sample from the posterior of Z
+// @param a_pi_PM Double containing hyperparameter used to sample from the posterior of pi
+// @param var_alpha3 Doubel containing hyperparameter for sampling from alpha_3
+// @param var_epslion1 Double containing hyperparameters for sampling from A having to do with variance for Metropolis-Hastings algorithm
+// @param var_epslion2 Double containing hyperparameters for sampling from A having to do with variance for Metropolis-Hastings algorithm
+// @param alpha Double containing hyperparameters for sampling from tau
+// @param beta Double containing hyperparameters for sampling from tau
+// @param alpha_0 Double containing hyperparameters for sampling from sigma
+// @param beta_0 Double containing hyperparameters for sampling from sigma
+// @param directory String containing path to store batches of MCMC samples (empty if draws should not be saved)
+// @param B_grid Matrix containing basis functions evaluated at the grid used for online summaries (empty if no summaries are wanted)
+// @param summary_probs Vector containing probabilities of the pointwise quantiles tracked by the online summaries
+// @param summary_burnin Int containing number of MCMC iterations discarded before updating the online summaries
+// @param n_adapt Int containing number of MCMC iterations used to adapt the Metropolis-Hastings proposal scales
+// @param n_adapt_ladder Int containing number of MCMC iterations used to adapt the temperature ladder
+// @param step_Z Double containing the leapfrog step size of the Hamiltonian Monte Carlo updates of Z
+// @param n_leapfrog_Z Int containing the number of leapfrog steps of the Hamiltonian Monte Carlo updates of Z (if 0, then the Dirichlet random walk is used)
+// @param parallel_sweep Boolean indicating whether conditionally independent blocks of the untempered Gibbs sweep are run concurrently
+// @param single_precision Boolean indicating whether the sampler reads a single precision copy of the observations and basis functions (the double precision copy is released before sampling)
+// @param retention RetentionPolicy selecting the parameters saved to directory and their thinning
+// @returns params List of objects containing the MCMC samples from the last batch
+inline Rcpp::List BFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
+                                       const arma::field<arma::vec>& t_obs,
+                                       const int& n_funct,
+                                       const int& thinning_num,
+                                       const int& K,
+                                       const int basis_degree,
+                                       const int& M,
+                                       const arma::vec boundary_knots,
+                                       const arma::vec internal_knots,
+                                       const int& tot_mcmc_iters,
+                                       const int& r_stored_iters,
+                                       const int& n_temp_trans,
+                                       const arma::vec& c,
+                                       const double& b,
+                                       const double& nu_1,
+                                       const double& alpha1l,
+                                       const double& alpha2l,
+                                       const double& beta1l,
+                                       const double& beta2l,
+                                       const double& a_Z_PM,
+                                       const double& a_pi_PM,
+                                       const double& var_alpha3,
+                                       const double& var_epsilon1,
+                                       const double& var_epsilon2,
+                                       const double& alpha,
+                                       const double& beta,
+                                       const double& alpha_0,
+                                       const double& beta_0,
+                                       const std::string directory,
+                                       const double& beta_N_t,
+                                       const int& N_t,
+                                       const arma::mat& Z_est,
+                                       const arma::vec& pi_est,
+                                       const double& alpha_3_est,
+                                       const arma::mat& delta_est,
+                                       const arma::cube& gamma_est,
+                                       const arma::cube& Phi_est,
+                                       const arma::mat& A_est,
+                                       const arma::mat& nu_est,
+                                       const arma::vec& tau_est,
+                                       const double& sigma_est,
+                                       const arma::mat& chi_est,
+                                       const arma::mat& B_grid,
+                                       const arma::vec& summary_probs,
+                                       const int& summary_burnin,
+                                       const int& n_adapt,
+                                       const int& n_adapt_ladder,
+                                       const double& step_Z,
+                                       const int& n_leapfrog_Z,
+                                       const bool& parallel_sweep,
+                                       const bool& single_precision,
+                                       const RetentionPolicy& retention){
+  // Make B_obs
+  arma::field<arma::mat> B_obs(n_funct,1);
+  int P = internal_knots.n_elem + basis_degree + 1;
+
+  for(int i = 0; i < n_funct; i++){
+    splines2::BSpline bspline;
+    // Create Bspline object
+    bspline = splines2::BSpline(t_obs(i,0), internal_knots, basis_degree,
+                                boundary_knots);
+    // Get Basis matrix (100 x 8)
+    arma::mat bspline_mat {bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+  }
+
+  // Pack observations into contiguous storage (the sampler owns the only copy)
+  RaggedObs obs = makeRaggedObs(y_obs, B_obs);
+  B_obs.reset();
+
+  return BFMMM_MTT_warm_start(std::move(obs), thinning_num, K, M,
+                              tot_mcmc_iters, r_stored_iters, n_temp_trans, c,
+                              b, nu_1, alpha1l, alpha2l, beta1l, beta2l, a_Z_PM,
+                              a_pi_PM, var_alpha3, var_epsilon1, var_epsilon2,
+                              alpha, beta, alpha_0, beta_0, directory, beta_N_t,
+                              N_t, Z_est, pi_est, alpha_3_est, delta_est,
+                              gamma_est, Phi_est, A_est, nu_est, tau_est,
+                              sigma_est, chi_est, B_grid, summary_probs,
+                              summary_burnin, n_adapt, n_adapt_ladder, step_Z,
+                              n_leapfrog_Z, parallel_sweep, single_precision,
+                              retention);
+}
+
+// Gets posterior draws from the mixed membership model with a stochastic
+// gradient (minibatch) sampler. Every iteration the Z and chi parameters of a
+// minibatch of sg_batch_size functions are updated, nu and Phi are moved by
+// preconditioned stochastic gradient Langevin steps with control variates
+// (see SGState), sigma is drawn from its full conditional given a control
+// variate estimate of the residual sum of squares, and pi and alpha_3 are
+// updated exactly from the sums of the log memberships. The cost of an
+// iteration only depends on the number of functions through one pass over all
+// functions every sg_n_anchor iterations (when the anchor of the control
+// variates is refreshed).
+//
+// Since only the functions of the minibatch change, the Z and chi parameters
+// are only stored for every iteration of the batch when they are saved to
+// directory (so that their draws are aligned with the draws of nu, Phi and
+// sigma), and their current values are returned as matrices. The
+// log-likelihood is the control variate estimate.
+//
+// @name BFMMM_SG_warm_start
+// @param obs RaggedObs containing observed values and basis functions
+// @param K Int containing the number of clusters
+// @param M Int containing the number of eigenfunctions
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param r_stored_iters Int constaining number of iterations performed for each batch
+// @param c Vector containing hyperparameters for pi
+// @param b Double containing hyperparameter for alpha_3
+// @param nu_1 Double containing hyperparameter for gamma
+// @param alpha1l Double containing hyperparameters for sampling from A
+// @param alpha2l Double containing hyperparameters for sampling from A
+// @param beta1l Double containing hyperparameters for sampling from A
+// @param beta2l Double containing hyperparameters for sampling from A
+// @param a_Z_PM Double containing hyperparameter used to sample from the posterior of Z
+// @param a_pi_PM Double containing hyperparameter used to sample from the posterior of pi
+// @param var_alpha3 Double containing hyperparameter for sampling from alpha_3
+// @param var_epsilon1 Double containing hyperparameters for sampling from A
+// @param var_epsilon2 Double containing hyperparameters for sampling from A
+// @param alpha Double containing hyperparameters for sampling from tau
+// @param beta Double containing hyperparameters for sampling from tau
+// @param alpha_0 Double containing hyperparameters for sampling from sigma
+// @param beta_0 Double containing hyperparameters for sampling from sigma
+// @param directory String containing path to store batches of MCMC samples (empty if draws should not be saved)
+// @param Z_est Matrix containing starting values of Z (all elements must be positive)
+// @param pi_est Vector containing starting values of pi
+// @param alpha_3_est Double containing starting value of alpha_3
+// @param delta_est Matrix containing starting values of delta
+// @param gamma_est Cube containing starting values of gamma
+// @param Phi_est Cube containing starting values of Phi
+// @param A_est Matrix containing starting values of A
+// @param nu_est Matrix containing starting values of nu
+// @param tau_est Vector containing starting values of tau
+// @param sigma_est Double containing starting value of sigma
+// @param chi_est Matrix containing starting values of chi
+// @param sg_batch_size Int containing the number of functions in each minibatch
+// @param sg_step Double containing the step size of the Langevin steps of nu and Phi
+// @param sg_n_anchor Int containing how often (in MCMC iterations) the anchor of the control variates is refreshed
+// @param retention RetentionPolicy selecting the parameters saved to directory and their thinning
+// @returns params List of objects containing the MCMC samples from the last batch
+inline Rcpp::List BFMMM_SG_warm_start(const RaggedObs& obs,
+                                      const int& K,
+                                      const int& M,
+                                      const int& tot_mcmc_iters,
+                                      const int& r_stored_iters,
+                                      const arma::vec& c,
+                                      const double& b,
+                                      const double& nu_1,
+                                      const double& alpha1l,
+                                      const double& alpha2l,
+                                      const double& beta1l,
+                                      const double& beta2l,
+                                      const double& a_Z_PM,
+                                      const double& a_pi_PM,
+                                      const double& var_alpha3,
+                                      const double& var_epsilon1,
+                                      const double& var_epsilon2,
+                                      const double& alpha,
+                                      const double& beta,
+                                      const double& alpha_0,
+                                      const double& beta_0,
+                                      const std::string directory,
+                                      const arma::mat& Z_est,
+                                      const arma::vec& pi_est,
+                                      const double& alpha_3_est,
+                                      const arma::mat& delta_est,
+                                      const arma::cube& gamma_est,
+                                      const arma::cube& Phi_est,
+                                      const arma::mat& A_est,
+                                      const arma::mat& nu_est,
+                                      const arma::vec& tau_est,
+                                      const double& sigma_est,
+                                      const arma::mat& chi_est,
+                                      const int& sg_batch_size,
+                                      const double& sg_step,
+                                      const int& sg_n_anchor,
+                                      const RetentionPolicy& retention){
+  int n_funct = obs.n_funct();
+  int P = obs.B_t.n_rows;
+  if(arma::any(arma::vectorise(Z_est) <= 0)){
+    Rcpp::stop("the elements of 'Z_est' must be positive when a stochastic gradient sampler is used");
+  }
+
+  arma::mat P_mat(P, P, arma::fill::zeros);
+  P_mat.zeros();
+  for(int j = 0; j < P_mat.n_rows; j++){
+    P_mat(0,0) = 1;
+    if(j > 0){
+      P_mat(j,j) = 2;
+      P_mat(j-1,j) = -1;
+      P_mat(j,j-1) = -1;
+    }
+    P_mat(P_mat.n_rows - 1, P_mat.n_rows - 1) = 1;
+  }
+
+  arma::cube nu(K, P, r_stored_iters, arma::fill::zeros);
+  arma::mat pi(K, r_stored_iters, arma::fill::zeros);
+  arma::vec pi_ph = arma::zeros(K);
+  arma::vec sigma(r_stored_iters, arma::fill::ones);
+  arma::vec alpha_3 = arma::ones(r_stored_iters);
+  arma::cube delta(K, M, r_stored_iters, arma::fill::ones);
+  arma::field<arma::cube> gamma(r_stored_iters,1);
+  arma::field<arma::cube> Phi(r_stored_iters, 1);
+  arma::mat tilde_tau(K, M, arma::fill::ones);
+  arma::cube A = arma::ones(K, 2, r_stored_iters);
+  arma::mat tau(r_stored_iters, K, arma::fill::ones);
+  arma::vec loglik = arma::zeros(r_stored_iters);
+  for(int i = 0; i < r_stored_iters; i++){
+    gamma(i,0) = arma::cube(K, P, M, arma::fill::ones);
+    Phi(i,0) = arma::zeros(K, P, M);
+  }
+
+  // Only the current values of the local parameters are kept, unless they are
+  // saved to directory
+  arma::mat Z = Z_est;
+  arma::mat chi = chi_est;
+  bool save_Z = !directory.empty() && (retainedThinning(retention, "Z") > 0);
+  bool save_chi = !directory.empty() && (retainedThinning(retention, "Chi") > 0);
+  arma::cube Z_batch(n_funct, K, save_Z ? r_stored_iters : 0);
+  arma::cube chi_batch(n_funct, M, save_chi ? r_stored_iters : 0);
+
+  // start numbering for output files
+  int q = 0;
+
+  pi.col(0) = pi_est;
+  alpha_3(0) = alpha_3_est;
+  delta.slice(0) = delta_est;
+  gamma(0,0) = gamma_est;
+  Phi(0,0) = Phi_est;
+  A.slice(0) = A_est;
+  nu.slice(0) = nu_est;
+  tau.row(0) = tau_est.t();
+  sigma(0) = sigma_est;
+
+  SGState state = makeSGState(K, P, M);
+  double accept_Z = 0;
+  double accept_pi = 0;
+  double accept_alpha3 = 0;
+  double accept_prob = 0;
+  int iter_ind = 0;
+
+  for(int i = 0; i < tot_mcmc_iters; i++){
+    iter_ind = i % r_stored_iters;
+    if((i % sg_n_anchor) == 0){
+      setSGAnchor(obs, nu.slice(iter_ind), Phi(iter_ind,0), Z, chi, state);
+    }
+    sampleMinibatch(n_funct, sg_batch_size, state);
+
+    accept_Z = accept_Z +
+      updateSGLocals(obs, Phi(iter_ind,0), nu.slice(iter_ind), pi.col(iter_ind),
+                     alpha_3(iter_ind), sigma(iter_ind), a_Z_PM, state, Z, chi);
+
+    updatePi_PM(alpha_3(iter_ind), state.log_Z_sum, n_funct, c, iter_ind,
+                r_stored_iters, a_pi_PM, pi_ph, accept_prob, pi);
+    accept_pi = accept_pi + accept_prob;
+
+    updateAlpha3(pi.col(iter_ind), b, state.log_Z_sum, n_funct, iter_ind,
+                 r_stored_iters, var_alpha3, accept_prob, alpha_3);
+    accept_alpha3 = accept_alpha3 + accept_prob;
+
+    for(int k = 0; k < K; k++){
+      tilde_tau(k, 0) = delta(k, 0, iter_ind);
+      for(int j = 1; j < M; j++){
+        tilde_tau(k, j) = tilde_tau(k, j-1) * delta(k, j, iter_ind);
+      }
+    }
+
+    updatePhiSG(obs, nu.slice(iter_ind), gamma(iter_ind,0), tilde_tau, Z, chi,
+                sigma(iter_ind), sg_step, state, iter_ind, r_stored_iters, Phi);
+
+    updateDelta(Phi(iter_ind,0), gamma(iter_ind,0), A.slice(iter_ind),
+                iter_ind, r_stored_iters, delta);
+
+    updateA(alpha1l, beta1l, alpha2l, beta2l, delta.slice(iter_ind),
+            var_epsilon1, var_epsilon2, iter_ind, r_stored_iters, A);
+
+    updateGamma(nu_1, delta.slice(iter_ind), Phi(iter_ind,0), iter_ind,
+                r_stored_iters, gamma);
+
+    updateNuSG(obs, tau.row(iter_ind).t(), Phi(iter_ind,0), Z, chi,
+               sigma(iter_ind), P_mat, sg_step, state, iter_ind, r_stored_iters,
+               nu);
+
+    updateTau(alpha, beta, nu.slice(iter_ind), iter_ind, r_stored_iters, P_mat,
+              tau);
+
+    updateSigmaSG(obs, alpha_0, beta_0, nu.slice(iter_ind), Phi(iter_ind,0), Z,
+                  chi, iter_ind, r_stored_iters, state, sigma);
+
+    if(save_Z){
+      Z_batch.slice(iter_ind) = Z;
+    }
+    if(save_chi){
+      chi_batch.slice(iter_ind) = chi;
+    }
+
+    // Control variate estimate of the log likelihood
+    loglik(iter_ind) = -0.5 * obs.n_total() *
+      std::log(2 * arma::datum::pi * sigma(iter_ind)) -
+      (state.rss_est / (2 * sigma(iter_ind)));
+    if(((i+1) % 100) == 0){
+      Rcpp::Rcout << "Iteration: " << i+1 << "\n";
+      Rcpp::Rcout << "Log-likelihood: " << loglik(iter_ind) << "\n";
+      Rcpp::checkUserInterrupt();
+    }
+    if(((i+1) % r_stored_iters) == 0 && i > 1 && !directory.empty()){
+      // Save the retained parameters (each file is written once per batch)
+      flushRetained(retention, "Nu", nu, directory, q);
+      flushRetainedCols(retention, "Pi", pi, directory, q);
+      flushRetained(retention, "alpha_3", alpha_3, directory, q);
+      flushRetained(retention, "A", A, directory, q);
+      flushRetained(retention, "Delta", delta, directory, q);
+      flushRetained(retention, "Sigma", sigma, directory, q);
+      flushRetainedRows(retention, "Tau", tau, directory, q);
+      flushRetained(retention, "Gamma", gamma, directory, q);
+      flushRetained(retention, "Phi", Phi, directory, q);
+      flushRetained(retention, "Chi", chi_batch, directory, q);
+      flushRetained(retention, "Z", Z_batch, directory, q);
+      q = q + 1;
+    }
+    if(((i+1) % r_stored_iters) == 0 && i > 1){
+      //reset all parameters
+      nu.slice(0) = nu.slice(iter_ind);
+      pi.col(0) = pi.col(iter_ind);
+      alpha_3(0) = alpha_3(iter_ind);
+      A.slice(0) = A.slice(iter_ind);
+      delta.slice(0) = delta.slice(iter_ind);
+      sigma(0) = sigma(iter_ind);
+      tau.row(0) = tau.row(iter_ind);
+      gamma(0,0) = gamma(iter_ind, 0);
+      Phi(0,0) = Phi(iter_ind, 0);
+    }
+  }
+
+  Rcpp::List sg = Rcpp::List::create(Rcpp::Named("batch_size", std::min(sg_batch_size, n_funct)),
+                                     Rcpp::Named("step", sg_step),
+                                     Rcpp::Named("n_anchor", state.n_anchor),
+                                     Rcpp::Named("accept_Z", accept_Z / tot_mcmc_iters),
+                                     Rcpp::Named("accept_pi", accept_pi / tot_mcmc_iters),
+                                     Rcpp::Named("accept_alpha3", accept_alpha3 / tot_mcmc_iters));
+  Rcpp::List params = Rcpp::List::create(Rcpp::Named("nu", nu),
+                                         Rcpp::Named("alpha_3", alpha_3),
+                                         Rcpp::Named("chi", chi),
+                                         Rcpp::Named("pi", pi),
+                                         Rcpp::Named("A", A),
+                                         Rcpp::Named("delta", delta),
+                                         Rcpp::Named("sigma", sigma),
+                                         Rcpp::Named("tau", tau),
+                                         Rcpp::Named("gamma", gamma),
+                                         Rcpp::Named("Phi", Phi),
+                                         Rcpp::Named("Z", Z),
+                                         Rcpp::Named("loglik", loglik));
+  params.push_back(sg, "sg");
+  return params;
+}
+
+
+// Conducts a mixture of untempered sampling and tempered sampling to get posterior draws from the covariate adjusted mixed membership model.
+// The covariate adjusted mean and eigenfunction coefficients of every function are computed once per sweep and are kept up to date as nu, eta, Phi and xi are drawn,
+// so that the full conditionals are evaluated in the same way as in the unadjusted model.
+//
+// @name BFMMM_CovariateAdj_MTT
+// @param y_obs Field (list) of vectors containing the observed values
+// @param t_obs Field (list) of vectors containing time points of observed values
+// @param n_funct Int containing number of functions observed
+// @param X Matrix (n_funct x D) containing the covariates
+// @param thinning_num Int containing how often we save an MCMC iteration
+// @param K Int containing the number of clusters
+// @param basis degree Int containing the degree of B-splines used
+// @param M Int containing the number of eigenfunctions
+// @param boundary_knots Vector containing the boundary points of our index domain of interest
+// @param internal_knots Vector location of internal knots for B-splines
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param r_stored_iters Int constaining number of iterations performed for each batch
+// @param n_temp_trans Int containing how often tempered transitions are performed
+// @param c Vector containing hyperparmater for sampling from pi
+// @param b Double containing hyperparameter for sampling from alpha_3
+// @param nu_1 Double containing hyperparameter for sampling from gamma and gamma_xi
+// @param alpha1l Double containing hyperparameters for sampling from A and A_xi
+// @param alpha2l Double containing hyperparameters for sampling from A and A_xi
+// @param beta1l Double containing hyperparameters for sampling from A and A_xi
+// @param beta2l Double containing hyperparameters for sampling from A and A_xi
+// @param a_Z_PM Double containing hyperparameter used to sample from the posterior of Z
+// @param a_pi_PM Double containing hyperparameter used to sample from the posterior of pi
+// @param var_alpha3 Doubel containing hyperparameter for sampling from alpha_3
+// @param var_epslion1 Double containing hyperparameters for sampling from A having to do with variance for Metropolis-Hastings algorithm
+// @param var_epslion2 Double containing hyperparameters for sampling from A having to do with variance for Metropolis-Hastings algorithm
+// @param alpha Double containing hyperparameters for sampling from tau and tau_eta
+// @param beta Double containing hyperparameters for sampling from tau and tau_eta
+// @param alpha_0 Double containing hyperparameters for sampling from sigma
+// @param beta_0 Double containing hyperparameters for sampling from sigma
+// @param directory String containing path to store batches of MCMC samples (empty if draws should not be saved)
+// @param beta_N_t Double containing the maximum weight for tempered transitions
+// @param N_t Int containing total number of tempered transitions
+// @param retention RetentionPolicy selecting the parameters saved to directory and their thinning
+// @returns params List of objects containing the MCMC samples from the last batch
+inline Rcpp::List BFMMM_CovariateAdj_MTT(const arma::field<arma::vec>& y_obs,
+                                         const arma::field<arma::vec>& t_obs,
+                                         const int& n_funct,
+                                         const arma::mat& X,
+                                         const int& thinning_num,
+                                         const int& K,
+                                         const int basis_degree,
+                                         const int& M,
+                                         const arma::vec boundary_knots,
+                                         const arma::vec internal_knots,
+                                         const int& tot_mcmc_iters,
+                                         const int& r_stored_iters,
+                                         const int& n_temp_trans,
+                                         const arma::vec& c,
+                                         const double& b,
+                                         const double& nu_1,
+                                         const double& alpha1l,
+                                         const double& alpha2l,
+                                         const double& beta1l,
+                                         const double& beta2l,
+                                         const double& a_Z_PM,
+                                         const double& a_pi_PM,
+                                         const double& var_alpha3,
+                                         const double& var_epsilon1,
+                                         const double& var_epsilon2,
+                                         const double& alpha,
+                                         const double& beta,
+                                         const double& alpha_0,
+                                         const double& beta_0,
+                                         const std::string directory,
+                                         const double& beta_N_t,
+                                         const int& N_t,
+                                         const arma::mat& Z_est,
+                                         const arma::vec& pi_est,
+                                         const double& alpha_3_est,
+                                         const arma::mat& delta_est,
+                                         const arma::cube& gamma_est,
+                                         const arma::cube& Phi_est,
+                                         const arma::mat& A_est,
+                                         const arma::mat& nu_est,
+                                         const arma::vec& tau_est,
+                                         const double& sigma_est,
+                                         const arma::mat& chi_est,
+                                         const RetentionPolicy& retention){
   // Make B_obs
   arma::field<arma::mat> B_obs(n_funct,1);
   int P = internal_knots.n_elem + basis_degree + 1;
+  int D = X.n_cols;
 
   for(int i = 0; i < n_funct; i++){
     splines2::BSpline bspline;
@@ -1397,6 +2581,9 @@ inline Rcpp::List BFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
     B_obs(i,0) = bspline_mat;
   }
 
+  // Pack observations into contiguous storage
+  const RaggedObs obs = makeRaggedObs(y_obs, B_obs);
+
   arma::mat P_mat(P, P, arma::fill::zeros);
   P_mat.zeros();
   for(int j = 0; j < P_mat.n_rows; j++){
@@ -1413,69 +2600,89 @@ inline Rcpp::List BFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
   arma::cube chi(n_funct, M, r_stored_iters, arma::fill::randn);
   arma::mat pi(K, r_stored_iters, arma::fill::zeros);
   arma::vec pi_ph = arma::zeros(K);
-  pi.col(0) = rdirichlet(c);
   arma::vec sigma(r_stored_iters, arma::fill::ones);
   arma::vec Z_ph = arma::zeros(K);
   arma::vec alpha_3 = arma::ones(r_stored_iters);
-  arma::cube Z = arma::randi<arma::cube>(n_funct, K, r_stored_iters,
-                                         arma::distr_param(0,1));
-
-  for(int i = 0; i < n_funct; i++){
-    Z.slice(0).row(i) = rdirichlet(pi.col(0) * 100).t();
-  }
-
+  arma::cube Z(n_funct, K, r_stored_iters, arma::fill::zeros);
   arma::cube delta(K, M, r_stored_iters, arma::fill::ones);
   arma::field<arma::cube> gamma(r_stored_iters,1);
   arma::field<arma::cube> Phi(r_stored_iters, 1);
   arma::mat tilde_tau(K, M, arma::fill::ones);
   arma::cube A = arma::ones(K, 2, r_stored_iters);
+  arma::mat tau(r_stored_iters, K, arma::fill::ones);
   arma::vec loglik = arma::zeros(r_stored_iters);
 
+  // Covariate adjusted parameters (start with no covariate effects)
+  arma::field<arma::cube> eta(r_stored_iters, 1);
+  arma::cube tau_eta(K, D, r_stored_iters, arma::fill::ones);
+  arma::field<arma::cube> xi(r_stored_iters, K);
+  arma::field<arma::cube> gamma_xi(r_stored_iters, K);
+  arma::field<arma::cube> delta_xi(r_stored_iters, 1);
+  arma::field<arma::cube> a_xi(r_stored_iters, 1);
+  arma::cube tilde_tau_xi(K, M, D, arma::fill::ones);
+
   // start numbering for output files
   int q = 0;
 
   for(int i = 0; i < r_stored_iters; i++){
     gamma(i,0) = arma::cube(K, P, M, arma::fill::ones);
     Phi(i,0) = arma::randn(K, P, M);
+    eta(i,0) = arma::zeros(P, D, K);
+    delta_xi(i,0) = arma::ones(K, M, D);
+    a_xi(i,0) = arma::ones(K, 2, D);
+    for(int k = 0; k < K; k++){
+      xi(i,k) = arma::zeros(P, D, M);
+      gamma_xi(i,k) = arma::ones(P, D, M);
+    }
   }
 
   arma::vec m_1(P, arma::fill::zeros);
   arma::mat M_1(P, P, arma::fill::zeros);
-  arma::mat tau(r_stored_iters, K, arma::fill::ones);
-
   arma::vec b_1(P, arma::fill::zeros);
   arma::mat B_1(P, P, arma::fill::zeros);
 
+  // Covariate adjusted coefficients of every function
+  CovariateEffects cov;
+
   // Create parameters for tempered transitions using geometric scheme
   arma::vec beta_ladder(N_t, arma::fill::ones);
   beta_ladder(N_t - 1) = beta_N_t;
   double geom_mult = std::pow(beta_N_t, 1.0/N_t);
-  // Rcpp::Rcout << "geom_mult: " << geom_mult << "\n";
   for(int i = 1; i < N_t; i++){
     beta_ladder(i) = beta_ladder(i-1) * geom_mult;
-    // beta_ladder(i) = 1 - ((1- beta_N_t) *(std::pow(i/ (N_t - 1.0), 2.0)));
-    // Rcpp::Rcout << "beta_i: " << beta_ladder(i) << "\n";
   }
   // Create storage for tempered transitions
   arma::cube nu_TT(K, P, (2 * N_t) + 1, arma::fill::randn);
   arma::cube chi_TT(n_funct, M, (2 * N_t) + 1, arma::fill::randn);
   arma::mat pi_TT(K, (2 * N_t) + 1, arma::fill::zeros);
   arma::vec sigma_TT((2 * N_t) + 1, arma::fill::ones);
-  arma::cube Z_TT = arma::randi<arma::cube>(n_funct, K, (2 * N_t) + 1,
-                                            arma::distr_param(0,1));
+  arma::cube Z_TT(n_funct, K, (2 * N_t) + 1, arma::fill::zeros);
   arma::cube delta_TT(K, M, (2 * N_t) + 1, arma::fill::ones);
   arma::field<arma::cube> gamma_TT((2 * N_t) + 1, 1);
   arma::field<arma::cube> Phi_TT((2 * N_t) + 1, 1);
   arma::cube A_TT = arma::ones(K, 2, (2 * N_t) + 1);
   arma::vec alpha_3_TT = arma::ones((2 * N_t) + 1);
+  arma::mat tau_TT((2 * N_t) + 1, K, arma::fill::ones);
+  arma::field<arma::cube> eta_TT((2 * N_t) + 1, 1);
+  arma::cube tau_eta_TT(K, D, (2 * N_t) + 1, arma::fill::ones);
+  arma::field<arma::cube> xi_TT((2 * N_t) + 1, K);
+  arma::field<arma::cube> gamma_xi_TT((2 * N_t) + 1, K);
+  arma::field<arma::cube> delta_xi_TT((2 * N_t) + 1, 1);
+  arma::field<arma::cube> a_xi_TT((2 * N_t) + 1, 1);
+  CovariateEffects cov_TT;
 
   for(int i = 0; i < ((2 * N_t) + 1); i++){
     gamma_TT(i,0) = arma::cube(K, P, M, arma::fill::ones);
     Phi_TT(i,0) = arma::randn(K, P, M);
+    eta_TT(i,0) = arma::zeros(P, D, K);
+    delta_xi_TT(i,0) = arma::ones(K, M, D);
+    a_xi_TT(i,0) = arma::ones(K, 2, D);
+    for(int k = 0; k < K; k++){
+      xi_TT(i,k) = arma::zeros(P, D, M);
+      gamma_xi_TT(i,k) = arma::ones(P, D, M);
+    }
   }
 
-  arma::mat tau_TT((2 * N_t) + 1, K, arma::fill::ones);
-
   int temp_ind = 0;
   double logA = 0;
   double logu = 0;
@@ -1483,7 +2690,6 @@ inline Rcpp::List BFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
 
   Z.slice(0) = Z_est;
   pi.col(0) = pi_est;
-
   alpha_3(0) = alpha_3_est;
   delta.slice(0) = delta_est;
   gamma(0,0) = gamma_est;
@@ -1492,18 +2698,21 @@ inline Rcpp::List BFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
   nu.slice(0) = nu_est;
   tau.row(0) = tau_est.t();
   sigma(0) = sigma_est;
-
   chi.slice(0) = chi_est;
 
   for(int i=0; i < tot_mcmc_iters; i++){
+    // compute covariate adjusted coefficients once per sweep
+    updateCovariateEffects(nu.slice(i % r_stored_iters), eta(i % r_stored_iters,0),
+                           Phi(i % r_stored_iters,0), xi, (i % r_stored_iters), X,
+                           cov);
+
     if(((i % n_temp_trans) != 0) || (i == 0)){
-      updateZ_PM(y_obs, B_obs, Phi((i % r_stored_iters),0),
-                 nu.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
-                 pi.col((i % r_stored_iters)), sigma((i % r_stored_iters)),
-                 (i % r_stored_iters), r_stored_iters, alpha_3(i % r_stored_iters),
-                 a_Z_PM, Z_ph, Z);
+      updateZ_PMCovariateAdj(obs, cov, chi.slice(i % r_stored_iters),
+                             pi.col(i % r_stored_iters), sigma(i % r_stored_iters),
+                             (i % r_stored_iters), r_stored_iters,
+                             alpha_3(i % r_stored_iters), a_Z_PM, Z_ph, Z);
 
-      updatePi_PM(alpha_3(i % r_stored_iters) ,Z.slice(i% r_stored_iters), c,
+      updatePi_PM(alpha_3(i % r_stored_iters), Z.slice(i % r_stored_iters), c,
                   (i % r_stored_iters), r_stored_iters, a_pi_PM, pi_ph, pi);
 
       updateAlpha3(pi.col(i % r_stored_iters), b, Z.slice(i % r_stored_iters),
@@ -1516,11 +2725,10 @@ inline Rcpp::List BFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
         }
       }
 
-      updatePhi(y_obs, B_obs, nu.slice((i % r_stored_iters)),
-                gamma((i % r_stored_iters),0), tilde_tau,
-                Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
-                sigma((i % r_stored_iters)), (i % r_stored_iters),
-                r_stored_iters, m_1, M_1, Phi);
+      updatePhiCovariateAdj(obs, cov, gamma((i % r_stored_iters),0), tilde_tau,
+                            Z.slice(i % r_stored_iters), chi.slice(i % r_stored_iters),
+                            sigma(i % r_stored_iters), (i % r_stored_iters),
+                            r_stored_iters, m_1, M_1, Phi);
 
       updateDelta(Phi((i % r_stored_iters),0), gamma((i % r_stored_iters),0),
                   A.slice(i % r_stored_iters), (i % r_stored_iters),
@@ -1532,59 +2740,92 @@ inline Rcpp::List BFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
       updateGamma(nu_1, delta.slice((i % r_stored_iters)), Phi((i % r_stored_iters),0),
                   (i % r_stored_iters), r_stored_iters, gamma);
 
-      updateNu(y_obs, B_obs, tau.row((i % r_stored_iters)).t(),
-               Phi((i % r_stored_iters),0), Z.slice((i % r_stored_iters)),
-               chi.slice((i % r_stored_iters)), sigma((i % r_stored_iters)),
-               (i % r_stored_iters), r_stored_iters, P_mat, b_1, B_1, nu);
+      for(int d = 0; d < D; d++){
+        for(int k = 0; k < K; k++){
+          tilde_tau_xi(k, 0, d) = delta_xi(i % r_stored_iters,0)(k, 0, d);
+          for(int j = 1; j < M; j++){
+            tilde_tau_xi(k, j, d) = tilde_tau_xi(k, j-1, d) *
+              delta_xi(i % r_stored_iters,0)(k, j, d);
+          }
+        }
+      }
 
-      updateTau(alpha, beta, nu.slice((i % r_stored_iters)), (i % r_stored_iters),
+      updateXiCovariateAdj(obs, cov, gamma_xi, tilde_tau_xi,
+                           Z.slice(i % r_stored_iters), chi.slice(i % r_stored_iters),
+                           sigma(i % r_stored_iters), X, (i % r_stored_iters),
+                           r_stored_iters, m_1, M_1, xi);
+
+      updateDeltaXi(xi, gamma_xi, a_xi(i % r_stored_iters,0), (i % r_stored_iters),
+                    r_stored_iters, delta_xi);
+
+      updateAXi(alpha1l, beta1l, alpha2l, beta2l, delta_xi(i % r_stored_iters,0),
+                var_epsilon1, var_epsilon2, (i % r_stored_iters), r_stored_iters,
+                a_xi);
+
+      updateGammaXi(nu_1, delta_xi(i % r_stored_iters,0), xi, (i % r_stored_iters),
+                    r_stored_iters, gamma_xi);
+
+      updateNuCovariateAdj(obs, cov, tau.row(i % r_stored_iters).t(),
+                           Z.slice(i % r_stored_iters), chi.slice(i % r_stored_iters),
+                           sigma(i % r_stored_iters), (i % r_stored_iters),
+                           r_stored_iters, P_mat, b_1, B_1, nu);
+
+      updateTau(alpha, beta, nu.slice(i % r_stored_iters), (i % r_stored_iters),
                 r_stored_iters, P_mat, tau);
 
-      updateSigma(y_obs, B_obs, alpha_0, beta_0,
-                  nu.slice((i % r_stored_iters)), Phi((i % r_stored_iters),0),
-                  Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
-                  (i % r_stored_iters), r_stored_iters, sigma);
+      updateEta(obs, cov, tau_eta.slice(i % r_stored_iters),
+                Z.slice(i % r_stored_iters), chi.slice(i % r_stored_iters),
+                sigma(i % r_stored_iters), (i % r_stored_iters), r_stored_iters,
+                P_mat, X, b_1, B_1, eta);
 
-      updateChi(y_obs, B_obs, Phi((i % r_stored_iters),0),
-                nu.slice((i % r_stored_iters)), Z.slice((i % r_stored_iters)),
-                sigma((i % r_stored_iters)), (i % r_stored_iters), r_stored_iters,
-                chi);
+      updateTauEta(alpha, beta, eta(i % r_stored_iters,0), (i % r_stored_iters),
+                   r_stored_iters, P_mat, tau_eta);
+
+      updateSigmaCovariateAdj(obs, cov, alpha_0, beta_0, Z.slice(i % r_stored_iters),
+                              chi.slice(i % r_stored_iters), (i % r_stored_iters),
+                              r_stored_iters, sigma);
+
+      updateChiCovariateAdj(obs, cov, Z.slice(i % r_stored_iters),
+                            sigma(i % r_stored_iters), (i % r_stored_iters),
+                            r_stored_iters, chi);
     }
 
     if((i % n_temp_trans) == 0 && (i > 0)){
       // initialize placeholders
-      nu_TT.slice(0) = nu.slice (i % r_stored_iters);
-      chi_TT.slice(0) = chi.slice(i % r_stored_iters);
-      pi_TT.col(0) = pi.col(i % r_stored_iters);
-      sigma_TT(0) = sigma(i % r_stored_iters);
-      Z_TT.slice(0) = Z.slice(i % r_stored_iters);
-      delta_TT.slice(0) = delta.slice(i % r_stored_iters);
-      gamma_TT(0,0) = gamma(i % r_stored_iters,0);
-      Phi_TT(0,0) = Phi(i % r_stored_iters,0);
-      A_TT.slice(0) = A.slice(i % r_stored_iters);
-      tau_TT.row(0) = tau.row(i % r_stored_iters);
-      alpha_3_TT(0) = alpha_3(i % r_stored_iters);
-
-      nu_TT.slice(1) = nu.slice(i % r_stored_iters);
-      chi_TT.slice(1) = chi.slice(i % r_stored_iters);
-      pi_TT.col(1) = pi.col(i % r_stored_iters);
-      sigma_TT(1) = sigma(i % r_stored_iters);
-      Z_TT.slice(1) = Z.slice(i % r_stored_iters);
-      delta_TT.slice(1) = delta.slice(i % r_stored_iters);
-      gamma_TT(1,0) = gamma(i % r_stored_iters,0);
-      Phi_TT(1,0) = Phi(i % r_stored_iters,0);
-      A_TT.slice(1) = A.slice(i % r_stored_iters);
-      tau_TT.row(1) = tau.row(i % r_stored_iters);
-      alpha_3_TT(1) = alpha_3(i % r_stored_iters);
+      for(int l = 0; l < 2; l++){
+        nu_TT.slice(l) = nu.slice(i % r_stored_iters);
+        chi_TT.slice(l) = chi.slice(i % r_stored_iters);
+        pi_TT.col(l) = pi.col(i % r_stored_iters);
+        sigma_TT(l) = sigma(i % r_stored_iters);
+        Z_TT.slice(l) = Z.slice(i % r_stored_iters);
+        delta_TT.slice(l) = delta.slice(i % r_stored_iters);
+        gamma_TT(l,0) = gamma(i % r_stored_iters,0);
+        Phi_TT(l,0) = Phi(i % r_stored_iters,0);
+        A_TT.slice(l) = A.slice(i % r_stored_iters);
+        tau_TT.row(l) = tau.row(i % r_stored_iters);
+        alpha_3_TT(l) = alpha_3(i % r_stored_iters);
+        eta_TT(l,0) = eta(i % r_stored_iters,0);
+        tau_eta_TT.slice(l) = tau_eta.slice(i % r_stored_iters);
+        delta_xi_TT(l,0) = delta_xi(i % r_stored_iters,0);
+        a_xi_TT(l,0) = a_xi(i % r_stored_iters,0);
+        for(int k = 0; k < K; k++){
+          xi_TT(l,k) = xi(i % r_stored_iters,k);
+          gamma_xi_TT(l,k) = gamma_xi(i % r_stored_iters,k);
+        }
+      }
 
       temp_ind = 0;
 
       // Perform tempered transitions
       for(int l = 1; l < ((2 * N_t) + 1); l++){
-        updateZTempered_PM(beta_ladder(temp_ind), y_obs, B_obs,
-                           Phi_TT(l,0), nu_TT.slice(l), chi_TT.slice(l),
-                           pi_TT.col(l), sigma_TT(l), l, (2 * N_t) + 1, alpha_3_TT(l), a_Z_PM,
-                           Z_ph, Z_TT);
+        // compute covariate adjusted coefficients once per sweep
+        updateCovariateEffects(nu_TT.slice(l), eta_TT(l,0), Phi_TT(l,0), xi_TT,
+                               l, X, cov_TT);
+
+        updateZTempered_PMCovariateAdj(beta_ladder(temp_ind), obs, cov_TT,
+                                       chi_TT.slice(l), pi_TT.col(l), sigma_TT(l),
+                                       l, (2 * N_t) + 1, alpha_3_TT(l), a_Z_PM,
+                                       Z_ph, Z_TT);
         updatePi_PM(alpha_3_TT(l), Z_TT.slice(l), c, l, (2 * N_t) + 1, a_pi_PM, pi_ph, pi_TT);
         updateAlpha3(pi_TT.col(l), b, Z_TT.slice(l), l, (2 * N_t) + 1, var_alpha3, alpha_3_TT);
 
@@ -1595,29 +2836,54 @@ inline Rcpp::List BFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
           }
         }
 
-        updatePhiTempered(beta_ladder(temp_ind), y_obs, B_obs,
-                          nu_TT.slice(l), gamma_TT(l,0), tilde_tau, Z_TT.slice(l),
-                          chi_TT.slice(l), sigma_TT(l), l, (2 * N_t) + 1, m_1, M_1,
-                          Phi_TT);
+        updatePhiTemperedCovariateAdj(beta_ladder(temp_ind), obs, cov_TT,
+                                      gamma_TT(l,0), tilde_tau, Z_TT.slice(l),
+                                      chi_TT.slice(l), sigma_TT(l), l, (2 * N_t) + 1,
+                                      m_1, M_1, Phi_TT);
         updateDelta(Phi_TT(l,0), gamma_TT(l,0), A_TT.slice(l), l, (2 * N_t) + 1,
                     delta_TT);
-
         updateA(alpha1l, beta1l, alpha2l, beta2l, delta_TT.slice(l), var_epsilon1,
                 var_epsilon2, l, (2 * N_t) + 1, A_TT);
         updateGamma(nu_1, delta_TT.slice(l), Phi_TT(l,0), l, (2 * N_t) + 1,
                     gamma_TT);
-        updateNuTempered(beta_ladder(temp_ind), y_obs, B_obs,
-                         tau_TT.row(l).t(), Phi_TT(l,0), Z_TT.slice(l),
-                         chi_TT.slice(l), sigma_TT(l), l, (2 * N_t) + 1, P_mat,
-                         b_1, B_1, nu_TT);
+
+        for(int d = 0; d < D; d++){
+          for(int k = 0; k < K; k++){
+            tilde_tau_xi(k, 0, d) = delta_xi_TT(l,0)(k, 0, d);
+            for(int j = 1; j < M; j++){
+              tilde_tau_xi(k, j, d) = tilde_tau_xi(k, j-1, d) *
+                delta_xi_TT(l,0)(k, j, d);
+            }
+          }
+        }
+
+        updateXiTemperedCovariateAdj(beta_ladder(temp_ind), obs, cov_TT,
+                                     gamma_xi_TT, tilde_tau_xi, Z_TT.slice(l),
+                                     chi_TT.slice(l), sigma_TT(l), X, l,
+                                     (2 * N_t) + 1, m_1, M_1, xi_TT);
+        updateDeltaXi(xi_TT, gamma_xi_TT, a_xi_TT(l,0), l, (2 * N_t) + 1,
+                      delta_xi_TT);
+        updateAXi(alpha1l, beta1l, alpha2l, beta2l, delta_xi_TT(l,0), var_epsilon1,
+                  var_epsilon2, l, (2 * N_t) + 1, a_xi_TT);
+        updateGammaXi(nu_1, delta_xi_TT(l,0), xi_TT, l, (2 * N_t) + 1,
+                      gamma_xi_TT);
+
+        updateNuTemperedCovariateAdj(beta_ladder(temp_ind), obs, cov_TT,
+                                     tau_TT.row(l).t(), Z_TT.slice(l),
+                                     chi_TT.slice(l), sigma_TT(l), l, (2 * N_t) + 1,
+                                     P_mat, b_1, B_1, nu_TT);
         updateTau(alpha, beta, nu_TT.slice(l), l, (2 * N_t) + 1, P_mat, tau_TT);
-        updateSigmaTempered(beta_ladder(temp_ind), y_obs, B_obs,
-                            alpha_0, beta_0, nu_TT.slice(l), Phi_TT(l,0),
-                            Z_TT.slice(l), chi_TT.slice(l), l, (2 * N_t) + 1,
-                            sigma_TT);
-        updateChiTempered(beta_ladder(temp_ind), y_obs, B_obs,
-                          Phi_TT(l,0), nu_TT.slice(l), Z_TT.slice(l), sigma_TT(l),
-                          l, (2 * N_t) + 1, chi_TT);
+        updateEtaTempered(beta_ladder(temp_ind), obs, cov_TT, tau_eta_TT.slice(l),
+                          Z_TT.slice(l), chi_TT.slice(l), sigma_TT(l), l,
+                          (2 * N_t) + 1, P_mat, X, b_1, B_1, eta_TT);
+        updateTauEta(alpha, beta, eta_TT(l,0), l, (2 * N_t) + 1, P_mat, tau_eta_TT);
+        updateSigmaTemperedCovariateAdj(beta_ladder(temp_ind), obs, cov_TT,
+                                        alpha_0, beta_0, Z_TT.slice(l),
+                                        chi_TT.slice(l), l, (2 * N_t) + 1,
+                                        sigma_TT);
+        updateChiTemperedCovariateAdj(beta_ladder(temp_ind), obs, cov_TT,
+                                      Z_TT.slice(l), sigma_TT(l), l,
+                                      (2 * N_t) + 1, chi_TT);
         // update temp_ind
         if(l < N_t){
           temp_ind = temp_ind + 1;
@@ -1626,15 +2892,12 @@ inline Rcpp::List BFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
           temp_ind = temp_ind - 1;
         }
       }
-      logA = CalculateTTAcceptance(beta_ladder, y_obs, B_obs,
-                                   nu_TT, Phi_TT, Z_TT, chi_TT, sigma_TT);
+      logA = CalculateTTAcceptanceCovariateAdj(beta_ladder, obs, nu_TT, eta_TT,
+                                               Phi_TT, xi_TT, Z_TT, chi_TT, X,
+                                               sigma_TT, cov_TT);
       logu = std::log(R::runif(0,1));
 
-      Rcpp::Rcout << "prob_accept: " << logA<< "\n";
-      Rcpp::Rcout << "logu: " << logu<< "\n";
-
       if(logu < logA){
-        Rcpp::Rcout << "Accept \n";
         nu.slice(i % r_stored_iters) = nu_TT.slice(2 * N_t);
         chi.slice(i % r_stored_iters) = chi_TT.slice(2 * N_t);
         pi.col(i % r_stored_iters) = pi_TT.col(2 * N_t);
@@ -1646,6 +2909,19 @@ inline Rcpp::List BFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
         A.slice(i % r_stored_iters) = A_TT.slice(2 * N_t);
         tau.row(i % r_stored_iters) = tau_TT.row(2 * N_t);
         alpha_3(i % r_stored_iters) = alpha_3_TT(2 * N_t);
+        eta(i % r_stored_iters,0) = eta_TT(2 * N_t,0);
+        tau_eta.slice(i % r_stored_iters) = tau_eta_TT.slice(2 * N_t);
+        delta_xi(i % r_stored_iters,0) = delta_xi_TT(2 * N_t,0);
+        a_xi(i % r_stored_iters,0) = a_xi_TT(2 * N_t,0);
+        for(int k = 0; k < K; k++){
+          xi(i % r_stored_iters,k) = xi_TT(2 * N_t,k);
+          gamma_xi(i % r_stored_iters,k) = gamma_xi_TT(2 * N_t,k);
+        }
+
+        // the accepted state has different covariate adjusted coefficients
+        updateCovariateEffects(nu.slice(i % r_stored_iters), eta(i % r_stored_iters,0),
+                               Phi(i % r_stored_iters,0), xi, (i % r_stored_iters),
+                               X, cov);
 
         //update accept number
         accept_num = accept_num + 1;
@@ -1661,72 +2937,50 @@ inline Rcpp::List BFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
         delta.slice((i+1) % r_stored_iters) = delta.slice(i % r_stored_iters);
         A.slice((i+1) % r_stored_iters) = A.slice(i % r_stored_iters);
         tau.row((i+1) % r_stored_iters) = tau.row(i % r_stored_iters);
+        gamma((i+1) % r_stored_iters,0) = gamma(i % r_stored_iters,0);
         Phi((i+1) % r_stored_iters,0) = Phi(i % r_stored_iters, 0);
         alpha_3((i+1) % r_stored_iters) =  alpha_3(i % r_stored_iters);
+        eta((i+1) % r_stored_iters,0) = eta(i % r_stored_iters,0);
+        tau_eta.slice((i+1) % r_stored_iters) = tau_eta.slice(i % r_stored_iters);
+        delta_xi((i+1) % r_stored_iters,0) = delta_xi(i % r_stored_iters,0);
+        a_xi((i+1) % r_stored_iters,0) = a_xi(i % r_stored_iters,0);
+        for(int k = 0; k < K; k++){
+          xi((i+1) % r_stored_iters,k) = xi(i % r_stored_iters,k);
+          gamma_xi((i+1) % r_stored_iters,k) = gamma_xi(i % r_stored_iters,k);
+        }
       }
     }
-    loglik((i % r_stored_iters)) =  calcLikelihood(y_obs, B_obs,
-           nu.slice((i % r_stored_iters)), Phi((i % r_stored_iters),0),
-           Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
-           sigma((i % r_stored_iters)));
+    loglik(i % r_stored_iters) = calcLikelihoodCovariateAdj(obs, cov,
+           Z.slice(i % r_stored_iters), chi.slice(i % r_stored_iters),
+           sigma(i % r_stored_iters));
     if(((i+1) % 100) == 0){
       Rcpp::Rcout << "Iteration: " << i+1 << "\n";
       Rcpp::Rcout << "Accpetance Probability: " << accept_num / (std::round(i / n_temp_trans)) << "\n";
       Rcpp::Rcout << "Log-likelihood: " << arma::mean(loglik.subvec((i % r_stored_iters)-4, (i % r_stored_iters))) << "\n";
       Rcpp::checkUserInterrupt();
     }
+    if(((i+1) % r_stored_iters) == 0 && i > 1 && !directory.empty()){
+      // Save the retained parameters (each file is written once per batch)
+      flushRetained(retention, "Nu", nu, directory, q);
+      flushRetained(retention, "Chi", chi, directory, q);
+      flushRetainedCols(retention, "Pi", pi, directory, q);
+      flushRetained(retention, "alpha_3", alpha_3, directory, q);
+      flushRetained(retention, "A", A, directory, q);
+      flushRetained(retention, "Delta", delta, directory, q);
+      flushRetained(retention, "Sigma", sigma, directory, q);
+      flushRetainedRows(retention, "Tau", tau, directory, q);
+      flushRetained(retention, "Gamma", gamma, directory, q);
+      flushRetained(retention, "Phi", Phi, directory, q);
+      flushRetained(retention, "Z", Z, directory, q);
+      flushRetained(retention, "Eta", eta, directory, q);
+      flushRetained(retention, "TauEta", tau_eta, directory, q);
+      flushRetained(retention, "Xi", xi, directory, q);
+      flushRetained(retention, "GammaXi", gamma_xi, directory, q);
+      flushRetained(retention, "DeltaXi", delta_xi, directory, q);
+      flushRetained(retention, "AXi", a_xi, directory, q);
+      q = q + 1;
+    }
     if(((i+1) % r_stored_iters) == 0 && i > 1){
-      // Save parameters
-      arma::cube nu1(K, P, r_stored_iters/thinning_num, arma::fill::randn);
-      arma::cube chi1(n_funct, M, r_stored_iters/thinning_num, arma::fill::randn);
-      arma::mat pi1(K, r_stored_iters/thinning_num, arma::fill::zeros);
-      arma::vec alpha_31(r_stored_iters/thinning_num, arma::fill::zeros);
-      arma::vec sigma1(r_stored_iters/thinning_num, arma::fill::ones);
-      arma::cube A1 = arma::ones(K, 2, r_stored_iters/thinning_num);
-      arma::cube Z1 = arma::randi<arma::cube>(n_funct, K, r_stored_iters/thinning_num,
-                                              arma::distr_param(0,1));
-      arma::cube delta1(K, M, r_stored_iters/thinning_num, arma::fill::ones);
-      arma::field<arma::cube> gamma1(r_stored_iters/thinning_num,1);
-      arma::field<arma::cube> Phi1(r_stored_iters/thinning_num, 1);
-      arma::mat tau1(r_stored_iters/thinning_num, K, arma::fill::ones);
-
-      nu1.slice(0) = nu.slice(0);
-      chi1.slice(0) = chi.slice(0);
-      pi1.col(0) = pi.col(0);
-      sigma1(0) = sigma(0);
-      A1.slice(0) = A.slice(0);
-      Z1.slice(0) = Z.slice(0);
-      delta1.slice(0) = delta.slice(0);
-      gamma1(0,0) = gamma(0,0);
-      Phi1(0,0) = Phi(0,0);
-      tau1.row(0) = tau.row(0);
-
-      for(int p=1; p < r_stored_iters / thinning_num; p++){
-        nu1.slice(p) = nu.slice(thinning_num*p - 1);
-        chi1.slice(p) = chi.slice(thinning_num*p - 1);
-        pi1.col(p) = pi.col(thinning_num*p - 1);
-        alpha_31(p) = alpha_3(thinning_num*p - 1);
-        sigma1(p) = sigma(thinning_num*p - 1);
-        A1.slice(p) = A.slice(thinning_num*p - 1);
-        Z1.slice(p) = Z.slice(thinning_num*p - 1);
-        delta1.slice(p) = delta.slice(thinning_num*p - 1);
-        gamma1(p,0) = gamma(thinning_num*p - 1,0);
-        Phi1(p,0) = Phi(thinning_num*p  - 1,0);
-        tau1.row(p) = tau.row(thinning_num*p - 1);
-      }
-
-      nu1.save(directory + "Nu" + std::to_string(q) + ".txt", arma::arma_ascii);
-      chi1.save(directory + "Chi" + std::to_string(q) +".txt", arma::arma_ascii);
-      pi1.save(directory + "Pi" + std::to_string(q) +".txt", arma::arma_ascii);
-      alpha_31.save(directory + "alpha_3" + std::to_string(q) + ".txt", arma::arma_ascii);
-      A1.save(directory + "A" + std::to_string(q) +".txt", arma::arma_ascii);
-      delta1.save(directory + "Delta" + std::to_string(q) +".txt", arma::arma_ascii);
-      sigma1.save(directory + "Sigma" + std::to_string(q) +".txt", arma::arma_ascii);
-      tau1.save(directory + "Tau" + std::to_string(q) +".txt", arma::arma_ascii);
-      gamma1.save(directory + "Gamma" + std::to_string(q) +".txt");
-      Phi1.save(directory + "Phi" + std::to_string(q) +".txt");
-      Z1.save(directory + "Z" + std::to_string(q) +".txt", arma::arma_ascii);
-
       //reset all parameters
       nu.slice(0) = nu.slice(i % r_stored_iters);
       chi.slice(0) = chi.slice(i % r_stored_iters);
@@ -1739,8 +2993,14 @@ inline Rcpp::List BFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
       gamma(0,0) = gamma(i % r_stored_iters, 0);
       Phi(0,0) = Phi(i % r_stored_iters, 0);
       Z.slice(0) = Z.slice(i % r_stored_iters);
-
-      q = q + 1;
+      eta(0,0) = eta(i % r_stored_iters,0);
+      tau_eta.slice(0) = tau_eta.slice(i % r_stored_iters);
+      delta_xi(0,0) = delta_xi(i % r_stored_iters,0);
+      a_xi(0,0) = a_xi(i % r_stored_iters,0);
+      for(int k = 0; k < K; k++){
+        xi(0,k) = xi(i % r_stored_iters,k);
+        gamma_xi(0,k) = gamma_xi(i % r_stored_iters,k);
+      }
     }
   }
 
@@ -1755,6 +3015,12 @@ inline Rcpp::List BFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
                                          Rcpp::Named("gamma", gamma),
                                          Rcpp::Named("Phi", Phi),
                                          Rcpp::Named("Z", Z),
+                                         Rcpp::Named("eta", eta),
+                                         Rcpp::Named("tau_eta", tau_eta),
+                                         Rcpp::Named("xi", xi),
+                                         Rcpp::Named("gamma_xi", gamma_xi),
+                                         Rcpp::Named("delta_xi", delta_xi),
+                                         Rcpp::Named("A_xi", a_xi),
                                          Rcpp::Named("loglik", loglik));
   return params;
 }
@@ -1813,6 +3079,9 @@ inline Rcpp::List BFMMM_MTTMV(const arma::mat& y_obs,
                               const std::string directory,
                               const double& beta_N_t,
                               const int& N_t){
+  // every parameter is saved every thinning_num iterations
+  const RetentionPolicy retention = makeRetentionPolicy(modelParams(),
+                                                        thinning_num);
   int P = y_obs.n_cols;
   int n_obs = y_obs.n_rows;
 
@@ -2069,71 +3338,33 @@ inline Rcpp::List BFMMM_MTTMV(const arma::mat& y_obs,
       Rcpp::checkUserInterrupt();
     }
     if(((i+1) % r_stored_iters) == 0 && i > 1){
-      // Save parameters
-      arma::cube nu1(K, P, r_stored_iters/thinning_num, arma::fill::randn);
-      arma::cube chi1(n_obs, M, r_stored_iters/thinning_num, arma::fill::randn);
-      arma::mat pi1(K, r_stored_iters/thinning_num, arma::fill::zeros);
-      arma::vec alpha_31(r_stored_iters/thinning_num, arma::fill::zeros);
-      arma::vec sigma1(r_stored_iters/thinning_num, arma::fill::ones);
-      arma::cube A1 = arma::ones(K, 2, r_stored_iters/thinning_num);
-      arma::cube Z1 = arma::randi<arma::cube>(n_obs, K, r_stored_iters/thinning_num,
-                                              arma::distr_param(0,1));
-      arma::cube delta1(K, M, r_stored_iters/thinning_num, arma::fill::ones);
-      arma::field<arma::cube> gamma1(r_stored_iters/thinning_num,1);
-      arma::field<arma::cube> Phi1(r_stored_iters/thinning_num, 1);
-      arma::mat tau1(r_stored_iters/thinning_num, K, arma::fill::ones);
-
-      nu1.slice(0) = nu.slice(0);
-      chi1.slice(0) = chi.slice(0);
-      pi1.col(0) = pi.col(0);
-      sigma1(0) = sigma(0);
-      A1.slice(0) = A.slice(0);
-      Z1.slice(0) = Z.slice(0);
-      delta1.slice(0) = delta.slice(0);
-      gamma1(0,0) = gamma(0,0);
-      Phi1(0,0) = Phi(0,0);
-      tau1.row(0) = tau.row(0);
-
-      for(int p=1; p < r_stored_iters / thinning_num; p++){
-        nu1.slice(p) = nu.slice(thinning_num*p - 1);
-        chi1.slice(p) = chi.slice(thinning_num*p - 1);
-        pi1.col(p) = pi.col(thinning_num*p - 1);
-        alpha_31(p) = alpha_3(thinning_num*p - 1);
-        sigma1(p) = sigma(thinning_num*p - 1);
-        A1.slice(p) = A.slice(thinning_num*p - 1);
-        Z1.slice(p) = Z.slice(thinning_num*p - 1);
-        delta1.slice(p) = delta.slice(thinning_num*p - 1);
-        gamma1(p,0) = gamma(thinning_num*p - 1,0);
-        Phi1(p,0) = Phi(thinning_num*p  - 1,0);
-        tau1.row(p) = tau.row(thinning_num*p - 1);
-
-        nu1.save(directory + "Nu" + std::to_string(q) + ".txt", arma::arma_ascii);
-        chi1.save(directory + "Chi" + std::to_string(q) +".txt", arma::arma_ascii);
-        pi1.save(directory + "Pi" + std::to_string(q) +".txt", arma::arma_ascii);
-        alpha_31.save(directory + "alpha_3" + std::to_string(q) + ".txt", arma::arma_ascii);
-        A1.save(directory + "A" + std::to_string(q) +".txt", arma::arma_ascii);
-        delta1.save(directory + "Delta" + std::to_string(q) +".txt", arma::arma_ascii);
-        sigma1.save(directory + "Sigma" + std::to_string(q) +".txt", arma::arma_ascii);
-        tau1.save(directory + "Tau" + std::to_string(q) +".txt", arma::arma_ascii);
-        gamma1.save(directory + "Gamma" + std::to_string(q) +".txt");
-        Phi1.save(directory + "Phi" + std::to_string(q) +".txt");
-        Z1.save(directory + "Z" + std::to_string(q) +".txt", arma::arma_ascii);
-
-        //reset all parameters
-        nu.slice(0) = nu.slice(i % r_stored_iters);
-        chi.slice(0) = chi.slice(i % r_stored_iters);
-        pi.col(0) = pi.col(i % r_stored_iters);
-        alpha_3(0) = alpha_3(i % r_stored_iters);
-        A.slice(0) = A.slice(i % r_stored_iters);
-        delta.slice(0) = delta.slice(i % r_stored_iters);
-        sigma(0) = sigma(i % r_stored_iters);
-        tau.row(0) = tau.row(i % r_stored_iters);
-        gamma(0,0) = gamma(i % r_stored_iters, 0);
-        Phi(0,0) = Phi(i % r_stored_iters, 0);
-        Z.slice(0) = Z.slice(i % r_stored_iters);
-
-        q = q + 1;
-      }
+      // Save the retained parameters (each file is written once per batch)
+      flushRetained(retention, "Nu", nu, directory, q);
+      flushRetained(retention, "Chi", chi, directory, q);
+      flushRetainedCols(retention, "Pi", pi, directory, q);
+      flushRetained(retention, "alpha_3", alpha_3, directory, q);
+      flushRetained(retention, "A", A, directory, q);
+      flushRetained(retention, "Delta", delta, directory, q);
+      flushRetained(retention, "Sigma", sigma, directory, q);
+      flushRetainedRows(retention, "Tau", tau, directory, q);
+      flushRetained(retention, "Gamma", gamma, directory, q);
+      flushRetained(retention, "Phi", Phi, directory, q);
+      flushRetained(retention, "Z", Z, directory, q);
+
+      //reset all parameters
+      nu.slice(0) = nu.slice(i % r_stored_iters);
+      chi.slice(0) = chi.slice(i % r_stored_iters);
+      pi.col(0) = pi.col(i % r_stored_iters);
+      alpha_3(0) = alpha_3(i % r_stored_iters);
+      A.slice(0) = A.slice(i % r_stored_iters);
+      delta.slice(0) = delta.slice(i % r_stored_iters);
+      sigma(0) = sigma(i % r_stored_iters);
+      tau.row(0) = tau.row(i % r_stored_iters);
+      gamma(0,0) = gamma(i % r_stored_iters, 0);
+      Phi(0,0) = Phi(i % r_stored_iters, 0);
+      Z.slice(0) = Z.slice(i % r_stored_iters);
+
+      q = q + 1;
     }
   }
 
@@ -2471,6 +3702,7 @@ inline Rcpp::List BFMMM_ThetaMV(const arma::mat& y_obs,
 // @param alpha_0 Double containing hyperparameters for sampling from sigma
 // @param beta_0 Double containing hyperparameters for sampling from sigma
 // @param directory String containing path to store batches of MCMC samples
+// @param retention RetentionPolicy selecting the parameters saved to directory and their thinning
 // @returns params List of objects containing the MCMC samples from the last batch
 inline Rcpp::List BFMMM_MTT_warm_startMV(const arma::mat& y_obs,
                                          const int& thinning_num,
@@ -2508,7 +3740,8 @@ inline Rcpp::List BFMMM_MTT_warm_startMV(const arma::mat& y_obs,
                                          const arma::mat& nu_est,
                                          const arma::vec& tau_est,
                                          const double& sigma_est,
-                                         const arma::mat& chi_est){
+                                         const arma::mat& chi_est,
+                                         const RetentionPolicy& retention){
   int n_obs = y_obs.n_rows;
   int P = y_obs.n_cols;
 
@@ -2780,56 +4013,18 @@ inline Rcpp::List BFMMM_MTT_warm_startMV(const arma::mat& y_obs,
       Rcpp::checkUserInterrupt();
     }
     if(((i+1) % r_stored_iters) == 0 && i > 1){
-      // Save parameters
-      arma::cube nu1(K, P, r_stored_iters/thinning_num, arma::fill::randn);
-      arma::cube chi1(n_obs, M, r_stored_iters/thinning_num, arma::fill::randn);
-      arma::mat pi1(K, r_stored_iters/thinning_num, arma::fill::zeros);
-      arma::vec alpha_31(r_stored_iters/thinning_num, arma::fill::zeros);
-      arma::vec sigma1(r_stored_iters/thinning_num, arma::fill::ones);
-      arma::cube A1 = arma::ones(K, 2, r_stored_iters/thinning_num);
-      arma::cube Z1 = arma::randi<arma::cube>(n_obs, K, r_stored_iters/thinning_num,
-                                              arma::distr_param(0,1));
-      arma::cube delta1(K, M, r_stored_iters/thinning_num, arma::fill::ones);
-      arma::field<arma::cube> gamma1(r_stored_iters/thinning_num,1);
-      arma::field<arma::cube> Phi1(r_stored_iters/thinning_num, 1);
-      arma::mat tau1(r_stored_iters/thinning_num, K, arma::fill::ones);
-
-      nu1.slice(0) = nu.slice(0);
-      chi1.slice(0) = chi.slice(0);
-      pi1.col(0) = pi.col(0);
-      sigma1(0) = sigma(0);
-      A1.slice(0) = A.slice(0);
-      Z1.slice(0) = Z.slice(0);
-      delta1.slice(0) = delta.slice(0);
-      gamma1(0,0) = gamma(0,0);
-      Phi1(0,0) = Phi(0,0);
-      tau1.row(0) = tau.row(0);
-
-      for(int p=1; p < r_stored_iters / thinning_num; p++){
-        nu1.slice(p) = nu.slice(thinning_num*p - 1);
-        chi1.slice(p) = chi.slice(thinning_num*p - 1);
-        pi1.col(p) = pi.col(thinning_num*p - 1);
-        alpha_31(p) = alpha_3(thinning_num*p - 1);
-        sigma1(p) = sigma(thinning_num*p - 1);
-        A1.slice(p) = A.slice(thinning_num*p - 1);
-        Z1.slice(p) = Z.slice(thinning_num*p - 1);
-        delta1.slice(p) = delta.slice(thinning_num*p - 1);
-        gamma1(p,0) = gamma(thinning_num*p - 1,0);
-        Phi1(p,0) = Phi(thinning_num*p  - 1,0);
-        tau1.row(p) = tau.row(thinning_num*p - 1);
-      }
-
-      nu1.save(directory + "Nu" + std::to_string(q) + ".txt", arma::arma_ascii);
-      chi1.save(directory + "Chi" + std::to_string(q) +".txt", arma::arma_ascii);
-      pi1.save(directory + "Pi" + std::to_string(q) +".txt", arma::arma_ascii);
-      alpha_31.save(directory + "alpha_3" + std::to_string(q) + ".txt", arma::arma_ascii);
-      A1.save(directory + "A" + std::to_string(q) +".txt", arma::arma_ascii);
-      delta1.save(directory + "Delta" + std::to_string(q) +".txt", arma::arma_ascii);
-      sigma1.save(directory + "Sigma" + std::to_string(q) +".txt", arma::arma_ascii);
-      tau1.save(directory + "Tau" + std::to_string(q) +".txt", arma::arma_ascii);
-      gamma1.save(directory + "Gamma" + std::to_string(q) +".txt");
-      Phi1.save(directory + "Phi" + std::to_string(q) +".txt");
-      Z1.save(directory + "Z" + std::to_string(q) +".txt", arma::arma_ascii);
+      // Save the retained parameters (each file is written once per batch)
+      flushRetained(retention, "Nu", nu, directory, q);
+      flushRetained(retention, "Chi", chi, directory, q);
+      flushRetainedCols(retention, "Pi", pi, directory, q);
+      flushRetained(retention, "alpha_3", alpha_3, directory, q);
+      flushRetained(retention, "A", A, directory, q);
+      flushRetained(retention, "Delta", delta, directory, q);
+      flushRetained(retention, "Sigma", sigma, directory, q);
+      flushRetainedRows(retention, "Tau", tau, directory, q);
+      flushRetained(retention, "Gamma", gamma, directory, q);
+      flushRetained(retention, "Phi", Phi, directory, q);
+      flushRetained(retention, "Z", Z, directory, q);
 
       //reset all parameters
       nu.slice(0) = nu.slice(i % r_stored_iters);
@@ -2923,7 +4118,14 @@ inline Rcpp::List BHDFMMM_Nu_Z(const arma::field<arma::vec>& y_obs,
   arma::field<arma::mat> B_obs = TensorBSpline(t_obs, n_funct, basis_degree,
                                                boundary_knots, internal_knots);
 
-  arma::mat P_mat = GetP(basis_degree,internal_knots);
+  // Pack observations into contiguous storage
+  const RaggedObs obs = makeRaggedObs(y_obs, B_obs);
+
+  // Sparse P matrix and basis functions (the P x P precision matrices of nu
+  // and Phi are never formed, see drawGaussianPO)
+  arma::sp_mat P_diff = GetPDiff(basis_degree, internal_knots);
+  arma::sp_mat P_mat = P_diff.t() * P_diff;
+  const arma::sp_mat B_sp(obs.B_t);
 
   int P = P_mat.n_cols;
   arma::cube nu(K, P, tot_mcmc_iters, arma::fill::randn);
@@ -2953,15 +4155,10 @@ inline Rcpp::List BHDFMMM_Nu_Z(const arma::field<arma::vec>& y_obs,
     Phi(i,0) = arma::zeros(K, P, M);
   }
 
-  arma::vec m_1(P, arma::fill::zeros);
-  arma::mat M_1(P, P, arma::fill::zeros);
   arma::mat tau(tot_mcmc_iters, K, arma::fill::ones);
 
-  arma::vec b_1(P, arma::fill::zeros);
-  arma::mat B_1(P, P, arma::fill::zeros);
-
   for(int i = 0; i < tot_mcmc_iters; i++){
-    updateZ_PM(y_obs, B_obs, Phi(i,0),
+    updateZ_PM(obs, Phi(i,0),
                nu.slice(i), chi.slice(i),
                pi.col(i), sigma(i),
                i, tot_mcmc_iters, alpha_3(i),
@@ -2979,21 +4176,21 @@ inline Rcpp::List BHDFMMM_Nu_Z(const arma::field<arma::vec>& y_obs,
       }
     }
 
-    updateNu(y_obs, B_obs, tau.row((i)).t(),
-             Phi((i),0), Z.slice((i)),
-             chi.slice((i)), sigma((i)),
-             (i), tot_mcmc_iters, P_mat, b_1, B_1, nu);
+    updateNuPCG(obs, B_sp, tau.row((i)).t(),
+                Phi((i),0), Z.slice((i)),
+                chi.slice((i)), sigma((i)),
+                (i), tot_mcmc_iters, P_diff, P_mat, nu);
 
     updateTau(alpha, beta, nu.slice((i)), (i),
               tot_mcmc_iters, P_mat, tau);
 
-    updateSigma(y_obs, B_obs, alpha_0, beta_0,
+    updateSigma(obs, alpha_0, beta_0,
                 nu.slice((i)), Phi((i),0),
                 Z.slice((i)), chi.slice((i)),
                 (i), tot_mcmc_iters, sigma);
 
     // Calculate log likelihood
-    loglik((i)) =  calcLikelihood(y_obs, B_obs, nu.slice((i)),
+    loglik((i)) =  calcLikelihood(obs, nu.slice((i)),
            Phi((i),0), Z.slice((i)), chi.slice((i)), sigma((i)));
     if(((i+1) % 100) == 0){
       Rcpp::Rcout << "Iteration: " << i+1 << "\n";
@@ -3075,7 +4272,14 @@ inline Rcpp::List BHDFMMM_Theta(const arma::field<arma::vec>& y_obs,
   arma::field<arma::mat> B_obs = TensorBSpline(t_obs, n_funct, basis_degree,
                                                boundary_knots, internal_knots);
 
-  arma::mat P_mat = GetP(basis_degree,internal_knots);
+  // Pack observations into contiguous storage
+  const RaggedObs obs = makeRaggedObs(y_obs, B_obs);
+
+  // Sparse P matrix and basis functions (the P x P precision matrices of nu
+  // and Phi are never formed, see drawGaussianPO)
+  arma::sp_mat P_diff = GetPDiff(basis_degree, internal_knots);
+  arma::sp_mat P_mat = P_diff.t() * P_diff;
+  const arma::sp_mat B_sp(obs.B_t);
 
   int P = P_mat.n_cols;
   arma::cube nu(K, P, tot_mcmc_iters, arma::fill::randn);
@@ -3105,13 +4309,8 @@ inline Rcpp::List BHDFMMM_Theta(const arma::field<arma::vec>& y_obs,
     Phi(i,0) = arma::randn(K, P, M);
   }
 
-  arma::vec m_1(P, arma::fill::zeros);
-  arma::mat M_1(P, P, arma::fill::zeros);
   arma::mat tau(tot_mcmc_iters, K, arma::fill::ones);
 
-  arma::vec b_1(P, arma::fill::zeros);
-  arma::mat B_1(P, P, arma::fill::zeros);
-
   Z.slice(0) = Z_est;
   nu.slice(0) = nu_est;
 
@@ -3129,11 +4328,11 @@ inline Rcpp::List BHDFMMM_Theta(const arma::field<arma::vec>& y_obs,
       }
     }
 
-    updatePhi(y_obs, B_obs, nu.slice((i)),
-              gamma((i),0), tilde_tau,
-              Z.slice((i)), chi.slice((i)),
-              sigma((i)), (i),
-              tot_mcmc_iters, m_1, M_1, Phi);
+    updatePhiPCG(obs, B_sp, nu.slice((i)),
+                 gamma((i),0), tilde_tau,
+                 Z.slice((i)), chi.slice((i)),
+                 sigma((i)), (i),
+                 tot_mcmc_iters, Phi);
 
     updateDelta(Phi((i),0), gamma((i),0),
                 A.slice(i), (i),
@@ -3148,18 +4347,18 @@ inline Rcpp::List BHDFMMM_Theta(const arma::field<arma::vec>& y_obs,
     updateTau(alpha, beta, nu.slice((i)), (i),
               tot_mcmc_iters, P_mat, tau);
 
-    updateSigma(y_obs, B_obs, alpha_0, beta_0,
+    updateSigma(obs, alpha_0, beta_0,
                 nu.slice((i)), Phi((i),0),
                 Z.slice((i)), chi.slice((i)),
                 (i), tot_mcmc_iters, sigma);
 
-    updateChi(y_obs, B_obs, Phi((i),0),
+    updateChi(obs, Phi((i),0),
               nu.slice((i)), Z.slice((i)),
               sigma((i)), (i), tot_mcmc_iters,
               chi);
 
     // Calculate log likelihood
-    loglik((i)) =  calcLikelihood(y_obs, B_obs, nu.slice((i)),
+    loglik((i)) =  calcLikelihood(obs, nu.slice((i)),
            Phi((i),0), Z.slice((i)), chi.slice((i)), sigma((i)));
     if(((i+1) % 100) == 0){
       Rcpp::Rcout << "Iteration: " << i+1 << "\n";
@@ -3212,6 +4411,7 @@ inline Rcpp::List BHDFMMM_Theta(const arma::field<arma::vec>& y_obs,
 // @param alpha_0 Double containing hyperparameters for sampling from sigma
 // @param beta_0 Double containing hyperparameters for sampling from sigma
 // @param directory String containing path to store batches of MCMC samples
+// @param retention RetentionPolicy selecting the parameters saved to directory and their thinning
 // @returns params List of objects containing the MCMC samples from the last batch
 inline Rcpp::List BHDFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
                                          const arma::field<arma::mat>& t_obs,
@@ -3254,12 +4454,20 @@ inline Rcpp::List BHDFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
                                          const arma::mat& nu_est,
                                          const arma::vec& tau_est,
                                          const double& sigma_est,
-                                         const arma::mat& chi_est){
+                                         const arma::mat& chi_est,
+                                         const RetentionPolicy& retention){
   // Make B_obs
   arma::field<arma::mat> B_obs = TensorBSpline(t_obs, n_funct, basis_degree,
                                                boundary_knots, internal_knots);
 
-  arma::mat P_mat = GetP(basis_degree,internal_knots);
+  // Pack observations into contiguous storage
+  const RaggedObs obs = makeRaggedObs(y_obs, B_obs);
+
+  // Sparse P matrix and basis functions (the P x P precision matrices of nu
+  // and Phi are never formed, see drawGaussianPO)
+  arma::sp_mat P_diff = GetPDiff(basis_degree, internal_knots);
+  arma::sp_mat P_mat = P_diff.t() * P_diff;
+  const arma::sp_mat B_sp(obs.B_t);
   int P = B_obs(0,0).n_cols;
 
   arma::cube nu(K, P, r_stored_iters, arma::fill::randn);
@@ -3292,13 +4500,8 @@ inline Rcpp::List BHDFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
     Phi(i,0) = arma::randn(K, P, M);
   }
 
-  arma::vec m_1(P, arma::fill::zeros);
-  arma::mat M_1(P, P, arma::fill::zeros);
   arma::mat tau(r_stored_iters, K, arma::fill::ones);
 
-  arma::vec b_1(P, arma::fill::zeros);
-  arma::mat B_1(P, P, arma::fill::zeros);
-
   // Create parameters for tempered transitions using geometric scheme
   arma::vec beta_ladder(N_t, arma::fill::ones);
   beta_ladder(N_t - 1) = beta_N_t;
@@ -3350,7 +4553,7 @@ inline Rcpp::List BHDFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
 
   for(int i=0; i < tot_mcmc_iters; i++){
     if(((i % n_temp_trans) != 0) || (i == 0)){
-      updateZ_PM(y_obs, B_obs, Phi((i % r_stored_iters),0),
+      updateZ_PM(obs, Phi((i % r_stored_iters),0),
                  nu.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
                  pi.col((i % r_stored_iters)), sigma((i % r_stored_iters)),
                  (i % r_stored_iters), r_stored_iters, alpha_3(i % r_stored_iters),
@@ -3369,11 +4572,11 @@ inline Rcpp::List BHDFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
         }
       }
 
-      updatePhi(y_obs, B_obs, nu.slice((i % r_stored_iters)),
-                gamma((i % r_stored_iters),0), tilde_tau,
-                Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
-                sigma((i % r_stored_iters)), (i % r_stored_iters),
-                r_stored_iters, m_1, M_1, Phi);
+      updatePhiPCG(obs, B_sp, nu.slice((i % r_stored_iters)),
+                   gamma((i % r_stored_iters),0), tilde_tau,
+                   Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
+                   sigma((i % r_stored_iters)), (i % r_stored_iters),
+                   r_stored_iters, Phi);
 
       updateDelta(Phi((i % r_stored_iters),0), gamma((i % r_stored_iters),0),
                   A.slice(i % r_stored_iters), (i % r_stored_iters),
@@ -3385,20 +4588,20 @@ inline Rcpp::List BHDFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
       updateGamma(nu_1, delta.slice((i % r_stored_iters)), Phi((i % r_stored_iters),0),
                   (i % r_stored_iters), r_stored_iters, gamma);
 
-      updateNu(y_obs, B_obs, tau.row((i % r_stored_iters)).t(),
-               Phi((i % r_stored_iters),0), Z.slice((i % r_stored_iters)),
-               chi.slice((i % r_stored_iters)), sigma((i % r_stored_iters)),
-               (i % r_stored_iters), r_stored_iters, P_mat, b_1, B_1, nu);
+      updateNuPCG(obs, B_sp, tau.row((i % r_stored_iters)).t(),
+                  Phi((i % r_stored_iters),0), Z.slice((i % r_stored_iters)),
+                  chi.slice((i % r_stored_iters)), sigma((i % r_stored_iters)),
+                  (i % r_stored_iters), r_stored_iters, P_diff, P_mat, nu);
 
       updateTau(alpha, beta, nu.slice((i % r_stored_iters)), (i % r_stored_iters),
                 r_stored_iters, P_mat, tau);
 
-      updateSigma(y_obs, B_obs, alpha_0, beta_0,
+      updateSigma(obs, alpha_0, beta_0,
                   nu.slice((i % r_stored_iters)), Phi((i % r_stored_iters),0),
                   Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
                   (i % r_stored_iters), r_stored_iters, sigma);
 
-      updateChi(y_obs, B_obs, Phi((i % r_stored_iters),0),
+      updateChi(obs, Phi((i % r_stored_iters),0),
                 nu.slice((i % r_stored_iters)), Z.slice((i % r_stored_iters)),
                 sigma((i % r_stored_iters)), (i % r_stored_iters), r_stored_iters,
                 chi);
@@ -3434,7 +4637,7 @@ inline Rcpp::List BHDFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
 
       // Perform tempered transitions
       for(int l = 1; l < ((2 * N_t) + 1); l++){
-        updateZTempered_PM(beta_ladder(temp_ind), y_obs, B_obs,
+        updateZTempered_PM(beta_ladder(temp_ind), obs,
                            Phi_TT(l,0), nu_TT.slice(l), chi_TT.slice(l),
                            pi_TT.col(l), sigma_TT(l), l, (2 * N_t) + 1, alpha_3_TT(l), a_Z_PM,
                            Z_ph, Z_TT);
@@ -3448,10 +4651,10 @@ inline Rcpp::List BHDFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
             tilde_tau(k, j) = tilde_tau(k, j-1) * delta_TT(k, j, l);
           }
         }
-        updatePhiTempered(beta_ladder(temp_ind), y_obs, B_obs,
-                          nu_TT.slice(l), gamma_TT(l,0), tilde_tau, Z_TT.slice(l),
-                          chi_TT.slice(l), sigma_TT(l), l, (2 * N_t) + 1, m_1, M_1,
-                          Phi_TT);
+        updatePhiTemperedPCG(beta_ladder(temp_ind), obs, B_sp,
+                             nu_TT.slice(l), gamma_TT(l,0), tilde_tau, Z_TT.slice(l),
+                             chi_TT.slice(l), sigma_TT(l), l, (2 * N_t) + 1,
+                             Phi_TT);
         updateDelta(Phi_TT(l,0), gamma_TT(l,0), A_TT.slice(l), l, (2 * N_t) + 1,
                     delta_TT);
 
@@ -3459,16 +4662,16 @@ inline Rcpp::List BHDFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
                 var_epsilon2, l, (2 * N_t) + 1, A_TT);
         updateGamma(nu_1, delta_TT.slice(l), Phi_TT(l,0), l, (2 * N_t) + 1,
                     gamma_TT);
-        updateNuTempered(beta_ladder(temp_ind), y_obs, B_obs,
-                         tau_TT.row(l).t(), Phi_TT(l,0), Z_TT.slice(l),
-                         chi_TT.slice(l), sigma_TT(l), l, (2 * N_t) + 1, P_mat,
-                         b_1, B_1, nu_TT);
+        updateNuTemperedPCG(beta_ladder(temp_ind), obs, B_sp,
+                            tau_TT.row(l).t(), Phi_TT(l,0), Z_TT.slice(l),
+                            chi_TT.slice(l), sigma_TT(l), l, (2 * N_t) + 1, P_diff,
+                            P_mat, nu_TT);
         updateTau(alpha, beta, nu_TT.slice(l), l, (2 * N_t) + 1, P_mat, tau_TT);
-        updateSigmaTempered(beta_ladder(temp_ind), y_obs, B_obs,
+        updateSigmaTempered(beta_ladder(temp_ind), obs,
                             alpha_0, beta_0, nu_TT.slice(l), Phi_TT(l,0),
                             Z_TT.slice(l), chi_TT.slice(l), l, (2 * N_t) + 1,
                             sigma_TT);
-        updateChiTempered(beta_ladder(temp_ind), y_obs, B_obs,
+        updateChiTempered(beta_ladder(temp_ind), obs,
                           Phi_TT(l,0), nu_TT.slice(l), Z_TT.slice(l), sigma_TT(l),
                           l, (2 * N_t) + 1, chi_TT);
         // update temp_ind
@@ -3479,7 +4682,7 @@ inline Rcpp::List BHDFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
           temp_ind = temp_ind - 1;
         }
       }
-      logA = CalculateTTAcceptance(beta_ladder, y_obs, B_obs,
+      logA = CalculateTTAcceptance(beta_ladder, obs,
                                    nu_TT, Phi_TT, Z_TT, chi_TT, sigma_TT);
       logu = std::log(R::runif(0,1));
 
@@ -3518,7 +4721,7 @@ inline Rcpp::List BHDFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
         alpha_3((i+1) % r_stored_iters) =  alpha_3(i % r_stored_iters);
       }
     }
-    loglik((i % r_stored_iters)) =  calcLikelihood(y_obs, B_obs,
+    loglik((i % r_stored_iters)) =  calcLikelihood(obs,
            nu.slice((i % r_stored_iters)), Phi((i % r_stored_iters),0),
            Z.slice((i % r_stored_iters)), chi.slice((i % r_stored_iters)),
            sigma((i % r_stored_iters)));
@@ -3529,56 +4732,18 @@ inline Rcpp::List BHDFMMM_MTT_warm_start(const arma::field<arma::vec>& y_obs,
       Rcpp::checkUserInterrupt();
     }
     if(((i+1) % r_stored_iters) == 0 && i > 1){
-      // Save parameters
-      arma::cube nu1(K, P, r_stored_iters/thinning_num, arma::fill::randn);
-      arma::cube chi1(n_funct, M, r_stored_iters/thinning_num, arma::fill::randn);
-      arma::mat pi1(K, r_stored_iters/thinning_num, arma::fill::zeros);
-      arma::vec alpha_31(r_stored_iters/thinning_num, arma::fill::zeros);
-      arma::vec sigma1(r_stored_iters/thinning_num, arma::fill::ones);
-      arma::cube A1 = arma::ones(K, 2, r_stored_iters/thinning_num);
-      arma::cube Z1 = arma::randi<arma::cube>(n_funct, K, r_stored_iters/thinning_num,
-                                              arma::distr_param(0,1));
-      arma::cube delta1(K, M, r_stored_iters/thinning_num, arma::fill::ones);
-      arma::field<arma::cube> gamma1(r_stored_iters/thinning_num,1);
-      arma::field<arma::cube> Phi1(r_stored_iters/thinning_num, 1);
-      arma::mat tau1(r_stored_iters/thinning_num, K, arma::fill::ones);
-
-      nu1.slice(0) = nu.slice(0);
-      chi1.slice(0) = chi.slice(0);
-      pi1.col(0) = pi.col(0);
-      sigma1(0) = sigma(0);
-      A1.slice(0) = A.slice(0);
-      Z1.slice(0) = Z.slice(0);
-      delta1.slice(0) = delta.slice(0);
-      gamma1(0,0) = gamma(0,0);
-      Phi1(0,0) = Phi(0,0);
-      tau1.row(0) = tau.row(0);
-
-      for(int p=1; p < r_stored_iters / thinning_num; p++){
-        nu1.slice(p) = nu.slice(thinning_num*p - 1);
-        chi1.slice(p) = chi.slice(thinning_num*p - 1);
-        pi1.col(p) = pi.col(thinning_num*p - 1);
-        alpha_31(p) = alpha_3(thinning_num*p - 1);
-        sigma1(p) = sigma(thinning_num*p - 1);
-        A1.slice(p) = A.slice(thinning_num*p - 1);
-        Z1.slice(p) = Z.slice(thinning_num*p - 1);
-        delta1.slice(p) = delta.slice(thinning_num*p - 1);
-        gamma1(p,0) = gamma(thinning_num*p - 1,0);
-        Phi1(p,0) = Phi(thinning_num*p  - 1,0);
-        tau1.row(p) = tau.row(thinning_num*p - 1);
-      }
-
-      nu1.save(directory + "Nu" + std::to_string(q) + ".txt", arma::arma_ascii);
-      chi1.save(directory + "Chi" + std::to_string(q) +".txt", arma::arma_ascii);
-      pi1.save(directory + "Pi" + std::to_string(q) +".txt", arma::arma_ascii);
-      alpha_31.save(directory + "alpha_3" + std::to_string(q) + ".txt", arma::arma_ascii);
-      A1.save(directory + "A" + std::to_string(q) +".txt", arma::arma_ascii);
-      delta1.save(directory + "Delta" + std::to_string(q) +".txt", arma::arma_ascii);
-      sigma1.save(directory + "Sigma" + std::to_string(q) +".txt", arma::arma_ascii);
-      tau1.save(directory + "Tau" + std::to_string(q) +".txt", arma::arma_ascii);
-      gamma1.save(directory + "Gamma" + std::to_string(q) +".txt");
-      Phi1.save(directory + "Phi" + std::to_string(q) +".txt");
-      Z1.save(directory + "Z" + std::to_string(q) +".txt", arma::arma_ascii);
+      // Save the retained parameters (each file is written once per batch)
+      flushRetained(retention, "Nu", nu, directory, q);
+      flushRetained(retention, "Chi", chi, directory, q);
+      flushRetainedCols(retention, "Pi", pi, directory, q);
+      flushRetained(retention, "alpha_3", alpha_3, directory, q);
+      flushRetained(retention, "A", A, directory, q);
+      flushRetained(retention, "Delta", delta, directory, q);
+      flushRetained(retention, "Sigma", sigma, directory, q);
+      flushRetainedRows(retention, "Tau", tau, directory, q);
+      flushRetained(retention, "Gamma", gamma, directory, q);
+      flushRetained(retention, "Phi", Phi, directory, q);
+      flushRetained(retention, "Z", Z, directory, q);
 
       //reset all parameters
       nu.slice(0) = nu.slice(i % r_stored_iters);
@@ -30,27 +30,13 @@ inline arma::field<arma::mat> TensorBSpline(const arma::field<arma::mat>& t_obs,
     dim_counter(i) = dim_counter(i+1) * (internal_knots(i+1,0).n_elem + basis_degree(i+1) + 1);
   }
 
-  arma::field<arma::mat> B(n_funct,1);
-  for(int i = 0; i < n_funct; i++){
-    B(i,0) = arma::ones(t_obs(i,0).n_rows, P);
-  }
-
+  // marginal basis function of each dimension used by each tensor basis function
+  arma::umat marg_ind(dim, P);
   arma::vec counter = arma::zeros(dim);
   int counter_i = 1;
   for(int i = 0; i < P; i++){
-    for(int j = 0; j < n_funct; j++){
-      arma::field<arma::mat> B_ph(dim, 1);
-      for(int l = 0; l < dim; l++){
-        splines2::BSpline bspline;
-        // Create Bspline object
-        bspline = splines2::BSpline(t_obs(j,0).col(l), internal_knots(l,0),
-                                    basis_degree(l), boundary_knots.row(l).t());
-        arma::mat bspline_mat{bspline.basis(true)};
-        B_ph(l,0) = bspline_mat;
-        for(int k = 0; k < t_obs(j,0).n_rows; k++){
-          B(j,0)(k,i) = B(j,0)(k,i) * B_ph(l,0)(k, counter(l));
-        }
-      }
+    for(int l = 0; l < dim; l++){
+      marg_ind(l,i) = counter(l);
     }
     for(int l = 0; l < dim; l++){
       counter(l) = std::fmod(counter_i / dim_counter(l), internal_knots(l,0).n_elem + basis_degree(l) + 1.0);
@@ -58,64 +44,102 @@ inline arma::field<arma::mat> TensorBSpline(const arma::field<arma::mat>& t_obs,
     counter = arma::floor(counter);
     counter_i++;
   }
+
+  // the marginal B-splines are evaluated once per function and dimension
+  arma::field<arma::mat> B(n_funct,1);
+  arma::field<arma::mat> B_marg(dim, 1);
+  for(int j = 0; j < n_funct; j++){
+    for(int l = 0; l < dim; l++){
+      splines2::BSpline bspline;
+      // Create Bspline object
+      bspline = splines2::BSpline(t_obs(j,0).col(l), internal_knots(l,0),
+                                  basis_degree(l), boundary_knots.row(l).t());
+      B_marg(l,0) = bspline.basis(true);
+    }
+    B(j,0) = arma::ones(t_obs(j,0).n_rows, P);
+    for(int i = 0; i < P; i++){
+      for(int l = 0; l < dim; l++){
+        const double* b_l = B_marg(l,0).colptr(marg_ind(l,i));
+        double* b_i = B(j,0).colptr(i);
+        for(int k = 0; k < t_obs(j,0).n_rows; k++){
+          b_i[k] = b_i[k] * b_l[k];
+        }
+      }
+    }
+  }
   return B;
 }
 
-// Creates the P matrix used when updating the nu parameters
+// Creates the sparse matrix of first differences between adjacent tensor
+// basis coefficients (coefficients whose indices differ by one in exactly one
+// dimension), so that the P matrix is P_diff' P_diff. Each row contains one
+// difference, so the matrix has O(P * dim) non-zero elements.
 //
-// @name GetP
+// @name GetPDiff
 // @param basis_degree vector containing the desired basis degree for each dimension
 // @param internal_knots field of vectors containing the internal knots for each dimension
-// @returns P_mat matrix used to update nu parameters
-inline arma::mat GetP(const arma::vec& basis_degree,
-               const arma::field<arma::vec>& internal_knots){
+// @returns P_diff sparse matrix containing the differences between adjacent basis coefficients
+inline arma::sp_mat GetPDiff(const arma::vec& basis_degree,
+                             const arma::field<arma::vec>& internal_knots){
   int dim = basis_degree.n_elem;
   int P = 1;
-  arma::vec dim_counter = arma::ones(dim);
+  arma::uvec n_basis(dim);
+  arma::uvec dim_counter = arma::ones<arma::uvec>(dim);
   for(int i = 0; i < dim; i++){
-    P = P * (internal_knots(i,0).n_elem + basis_degree(i) + 1);
+    n_basis(i) = internal_knots(i,0).n_elem + basis_degree(i) + 1;
+    P = P * n_basis(i);
   }
   for(int i = (dim - 2); i >= 0; i--){
-    dim_counter(i) = dim_counter(i+1) * (internal_knots(i+1,0).n_elem + basis_degree(i+1) + 1);
-  }
-  int p_pow = 1;
-  for(int i = 0; i < dim; i++){
-    p_pow = p_pow * (P-1);
+    dim_counter(i) = dim_counter(i+1) * n_basis(i+1);
   }
-  arma::mat Constraint_mat = arma::zeros(p_pow, P);
 
-  arma::vec counter = arma::zeros(dim);
-  arma::field<arma::vec> index(P,1);
-  int counter_i = 1;
-  for(int i = 0; i < P; i++){
-    index(i,0) = counter;
-    for(int l = 0; l < dim; l++){
-      counter(l) = std::fmod(counter_i / dim_counter(l), internal_knots(l,0).n_elem + basis_degree(l) + 1.0);
-    }
-    counter = arma::floor(counter);
-    counter_i++;
+  // the neighbour of coefficient i in dimension l is i + dim_counter(l)
+  int n_diff = 0;
+  for(int l = 0; l < dim; l++){
+    n_diff = n_diff + ((P / n_basis(l)) * (n_basis(l) - 1));
   }
-
-  int diff = 0;
-  int abs_diff = 0;
-  counter_i = 0;
+  arma::umat locations(2, 2 * n_diff);
+  arma::vec values(2 * n_diff);
+  int counter_i = 0;
   for(int i = 0; i < P; i++){
-    for(int j = i; j < P; j++){
-      diff = 0;
-      abs_diff = 0;
-      for(int l = 0; l < dim; l++){
-        diff = diff + (index(j,0)(l) - index(i,0)(l));
-        abs_diff = abs_diff + std::abs(index(j,0)(l) - index(i,0)(l));
-      }
-      if((diff == 1) && (abs_diff == 1)){
-        Constraint_mat(counter_i, i) = 1;
-        Constraint_mat(counter_i, j) = -1;
+    for(int l = 0; l < dim; l++){
+      if(((i / dim_counter(l)) % n_basis(l)) + 1 < n_basis(l)){
+        locations(0, 2 * counter_i) = counter_i;
+        locations(1, 2 * counter_i) = i;
+        values(2 * counter_i) = 1;
+        locations(0, (2 * counter_i) + 1) = counter_i;
+        locations(1, (2 * counter_i) + 1) = i + dim_counter(l);
+        values((2 * counter_i) + 1) = -1;
         counter_i++;
       }
     }
   }
+  arma::sp_mat P_diff(locations, values, n_diff, P);
+  return P_diff;
+}
 
-  arma::mat P_mat = Constraint_mat.t() * Constraint_mat;
+// Creates the sparse P matrix used when updating the nu parameters
+//
+// @name GetPSparse
+// @param basis_degree vector containing the desired basis degree for each dimension
+// @param internal_knots field of vectors containing the internal knots for each dimension
+// @returns P_mat sparse matrix used to update nu parameters
+inline arma::sp_mat GetPSparse(const arma::vec& basis_degree,
+                               const arma::field<arma::vec>& internal_knots){
+  arma::sp_mat P_diff = GetPDiff(basis_degree, internal_knots);
+  arma::sp_mat P_mat = P_diff.t() * P_diff;
+  return P_mat;
+}
+
+// Creates the P matrix used when updating the nu parameters
+//
+// @name GetP
+// @param basis_degree vector containing the desired basis degree for each dimension
+// @param internal_knots field of vectors containing the internal knots for each dimension
+// @returns P_mat matrix used to update nu parameters
+inline arma::mat GetP(const arma::vec& basis_degree,
+               const arma::field<arma::vec>& internal_knots){
+  arma::mat P_mat(GetPSparse(basis_degree, internal_knots));
   return P_mat;
 }
 
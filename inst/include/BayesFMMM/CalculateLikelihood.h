@@ -3,8 +3,55 @@
 
 #include <RcppArmadillo.h>
 #include <cmath>
+#include "CovariateEffects.h"
+#include "KernelPolicies.h"
+#include "RaggedObs.h"
+#include "SubjectScheduler.h"
 
 namespace BayesFMMM {
+// Calculates the log likelihood of any variant of the model (see
+// KernelPolicies.h). The residual sum of squares of each function is
+// computed in parallel on the subject scheduler and summed in the order of
+// the functions.
+//
+// @name calcLikelihoodKernel
+// @param data Data model containing the observations
+// @param coefs Coefficient policy containing the mean and eigenfunction coefficients
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param sigma Double containing current sigma parameter
+// @param sched SubjectScheduler used to distribute the functions over threads
+// @return log_lik Double containing the log likelihood of the model
+template<class Data, class Coefs>
+inline double calcLikelihoodKernel(const Data& data,
+                                   const Coefs& coefs,
+                                   const arma::mat& Z,
+                                   const arma::mat& chi,
+                                   const double& sigma,
+                                   SubjectScheduler& sched){
+  arma::vec rss_i = calcRSSKernel(data, coefs, Z, chi, "loglik", sched);
+  double rss = 0;
+  for(int i = 0; i < Z.n_rows; i++){
+    rss = rss + rss_i(i);
+  }
+  double log_lik = -0.5 * data.n_total() * std::log(2 * arma::datum::pi * sigma) -
+    (rss / (2 * sigma));
+  return log_lik;
+}
+
+// Calculates the log likelihood of any variant of the model
+//
+// @name calcLikelihoodKernel
+template<class Data, class Coefs>
+inline double calcLikelihoodKernel(const Data& data,
+                                   const Coefs& coefs,
+                                   const arma::mat& Z,
+                                   const arma::mat& chi,
+                                   const double& sigma){
+  SubjectScheduler sched = makeSubjectScheduler(data.weights());
+  return calcLikelihoodKernel(data, coefs, Z, chi, sigma, sched);
+}
+
 // Calculates the log likelihood of the model
 //
 // @name calcLikelihood
@@ -23,26 +70,68 @@ inline double calcLikelihood(const arma::field<arma::vec>& y_obs,
                              const arma::mat& Z,
                              const arma::mat& chi,
                              const double& sigma){
-  double log_lik = 0;
-  double mean = 0;
-  for(int i = 0; i < Z.n_rows; i++){
-    for(int l = 0; l < y_obs(i,0).n_elem; l++){
-      mean = 0;
-      for(int k = 0; k < Z.n_cols; k++){
-        if(Z(i,k) != 0){
-          mean = mean + Z(i,k) * arma::dot(nu.row(k), B_obs(i,0).row(l));
-          for(int n = 0; n < Phi.n_slices; n++){
-            mean = mean + Z(i,k) * chi(i,n) * arma::dot(Phi.slice(n).row(k),
-                            B_obs(i,0).row(l));
-          }
-        }
-      }
-      log_lik = log_lik + R::dnorm(y_obs(i,0)(l), mean, std::sqrt(sigma), true);
-    }
-  }
-  return log_lik;
+  FieldData data = {y_obs, B_obs};
+  SharedCoefs coefs = {nu, Phi};
+  return calcLikelihoodKernel(data, coefs, Z, chi, sigma);
+}
+
+// Calculates the log likelihood of the model using contiguous observation
+// storage and the subject scheduler
+//
+// @name calcLikelihood
+// @param obs RaggedObs containing observed values and basis functions
+// @param nu Matrix containing current nu parameters
+// @param Phi Cube containing current Phi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param sigma Double containing current sigma parameter
+// @param sched SubjectScheduler used to distribute the functions over threads
+// @return log_lik Double containing the log likelihood of the model
+inline double calcLikelihood(const RaggedObs& obs,
+                             const arma::mat& nu,
+                             const arma::cube& Phi,
+                             const arma::mat& Z,
+                             const arma::mat& chi,
+                             const double& sigma,
+                             SubjectScheduler& sched){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  return calcLikelihoodKernel(data, coefs, Z, chi, sigma, sched);
+}
+
+// Calculates the log likelihood of the model using single precision
+// observation storage and the subject scheduler (the log-density is
+// accumulated in double precision)
+//
+// @name calcLikelihood
+inline double calcLikelihood(const RaggedObsF& obs,
+                             const arma::mat& nu,
+                             const arma::cube& Phi,
+                             const arma::mat& Z,
+                             const arma::mat& chi,
+                             const double& sigma,
+                             SubjectScheduler& sched){
+  RaggedDataF data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  return calcLikelihoodKernel(data, coefs, Z, chi, sigma, sched);
 }
 
+// Calculates the log likelihood of the model using contiguous observation
+// storage
+//
+// @name calcLikelihood
+inline double calcLikelihood(const RaggedObs& obs,
+                             const arma::mat& nu,
+                             const arma::cube& Phi,
+                             const arma::mat& Z,
+                             const arma::mat& chi,
+                             const double& sigma){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  return calcLikelihoodKernel(data, coefs, Z, chi, sigma);
+}
+
+
 // Calculates the second term of the DIC expression
 //
 // @name calcDIC2
@@ -95,22 +184,9 @@ inline double calcLikelihoodMV(const arma::mat& y_obs,
                                const arma::mat& Z,
                                const arma::mat& chi,
                                const double& sigma){
-  double log_lik = 0;
-  arma::vec mean = arma::zeros(y_obs.n_cols);
-  for(int i = 0; i < chi.n_rows; i++){
-    mean = arma::zeros(y_obs.n_cols);
-    for(int k = 0; k < Z.n_cols; k++){
-      if(Z(i,k) != 0){
-        mean = mean + Z(i,k) * nu.row(k).t();
-        for(int n = 0; n < Phi.n_slices; n++){
-          mean = mean + Z(i,k) * chi(i,n) * Phi.slice(n).row(k).t();
-        }
-      }
-    }
-    log_lik = log_lik - ((y_obs.n_cols / 2) * std::log(2 * arma::datum::pi * sigma)) - (
-      (1 / (sigma * 2)) * arma::dot(y_obs.row(i).t() - mean, y_obs.row(i).t() - mean));
-  }
-  return log_lik;
+  MVData data = {y_obs};
+  SharedCoefs coefs = {nu, Phi};
+  return calcLikelihoodKernel(data, coefs, Z, chi, sigma);
 }
 
 // Calculates the second term of the DIC expression for multivariate model
@@ -174,25 +250,29 @@ inline double calcLikelihoodCovariateAdj(const arma::field<arma::vec>& y_obs,
                                          const int& iter,
                                          const arma::mat& X,
                                          const double& sigma){
-  double log_lik = 0;
-  double mean = 0;
-  for(int i = 0; i < Z.n_rows; i++){
-    for(int l = 0; l < y_obs(i,0).n_elem; l++){
-      mean = 0;
-      for(int k = 0; k < Z.n_cols; k++){
-        if(Z(i,k) != 0){
-          mean = mean + Z(i,k) * arma::dot(nu.row(k).t() +
-            (eta.slice(k) * X.row(i).t()), B_obs(i,0).row(l));
-          for(int n = 0; n < Phi.n_slices; n++){
-            mean = mean + Z(i,k) * chi(i,n) * arma::dot(Phi.slice(n).row(k).t() +
-              (xi(iter,k).slice(n) * X.row(i).t()), B_obs(i,0).row(l));
-          }
-        }
-      }
-      log_lik = log_lik + R::dnorm(y_obs(i,0)(l), mean, std::sqrt(sigma), true);
-    }
-  }
-  return log_lik;
+  FieldData data = {y_obs, B_obs};
+  CovariateCoefs coefs = {nu, eta, Phi, xi, iter, X};
+  return calcLikelihoodKernel(data, coefs, Z, chi, sigma);
+}
+
+// Calculates the log likelihood of the covariate adjusted partial membership
+// model for functional data using the cached covariate adjusted coefficients
+//
+// @name calcLikelihoodCovariateAdj
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param sigma Double containing current sigma parameter
+// @return log_lik Double containing the log likelihood of the model
+inline double calcLikelihoodCovariateAdj(const RaggedObs& obs,
+                                         const CovariateEffects& cov,
+                                         const arma::mat& Z,
+                                         const arma::mat& chi,
+                                         const double& sigma){
+  RaggedData data = {obs};
+  CachedCovariateCoefs coefs = {cov};
+  return calcLikelihoodKernel(data, coefs, Z, chi, sigma);
 }
 
 // Calculates the log likelihood of the covariate adjusted multivariate model
@@ -219,23 +299,9 @@ inline double calcLikelihoodMVCovariateAdj(const arma::mat& y_obs,
                                            const int& iter,
                                            const arma::mat& X,
                                            const double& sigma){
-  double log_lik = 0;
-  arma::vec mean = arma::zeros(y_obs.n_cols);
-  for(int i = 0; i < chi.n_rows; i++){
-    mean = arma::zeros(y_obs.n_cols);
-    for(int k = 0; k < Z.n_cols; k++){
-      if(Z(i,k) != 0){
-        mean = mean + Z(i,k) * (nu.row(k).t() + (eta.slice(k) * X.row(i).t()));
-        for(int n = 0; n < Phi.n_slices; n++){
-          mean = mean + Z(i,k) * chi(i,n) * (Phi.slice(n).row(k).t() +
-            (xi(iter,k).slice(n) * X.row(i).t()));
-        }
-      }
-    }
-    log_lik = log_lik - ((y_obs.n_cols / 2) * std::log(2 * arma::datum::pi * sigma)) - (
-      (1 / (sigma * 2)) * arma::dot(y_obs.row(i).t() - mean, y_obs.row(i).t() - mean));
-  }
-  return log_lik;
+  MVData data = {y_obs};
+  CovariateCoefs coefs = {nu, eta, Phi, xi, iter, X};
+  return calcLikelihoodKernel(data, coefs, Z, chi, sigma);
 }
 
 }
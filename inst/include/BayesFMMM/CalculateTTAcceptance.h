@@ -3,6 +3,8 @@
 
 #include <RcppArmadillo.h>
 #include <cmath>
+#include "CovariateEffects.h"
+#include "RaggedObs.h"
 
 namespace BayesFMMM{
 
@@ -96,6 +98,166 @@ inline double CalculateTTAcceptance(const arma::vec& beta,
   return logAcceptance;
 }
 
+// Calculates the log acceptance probability at a specific temperature using
+// contiguous observation storage
+//
+// @name calculatePZeta
+// @param beta_i Double containing the current temperature
+// @param obs RaggedObs containing observed values and basis functions
+// @param nu Matrix containing current nu parameters
+// @param Phi Cube containing current Phi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param iter Int containing current temperature step
+// @param sigma double containing sigma current parameter
+// @returns logAcceptance Double containing the tempered likelihood pdf
+inline double calculatePZeta(const double& beta_i,
+                             const RaggedObs& obs,
+                             const arma::mat& nu,
+                             const arma::cube& Phi,
+                             const arma::mat& Z,
+                             const arma::mat& chi,
+                             const int& iter,
+                             const double& sigma){
+  double rss = 0;
+  arma::vec coef = arma::zeros(nu.n_cols);
+  for(int i = 0; i < chi.n_rows; i++){
+    calcMeanCoef(nu, Phi, Z.row(i), chi.row(i), coef);
+    rss = rss + calcRSS(obs, i, coef);
+  }
+  double logAcceptance = (-(beta_i/2) * obs.n_total() * std::log(sigma)) -
+    (beta_i / (2 * sigma)) * rss;
+  return logAcceptance;
+}
+
+// Calculates the log acceptance probability at a specific temperature using
+// single precision observation storage
+//
+// @name calculatePZeta
+inline double calculatePZeta(const double& beta_i,
+                             const RaggedObsF& obs,
+                             const arma::mat& nu,
+                             const arma::cube& Phi,
+                             const arma::mat& Z,
+                             const arma::mat& chi,
+                             const int& iter,
+                             const double& sigma){
+  double rss = 0;
+  arma::vec coef = arma::zeros(nu.n_cols);
+  for(int i = 0; i < chi.n_rows; i++){
+    calcMeanCoef(nu, Phi, Z.row(i), chi.row(i), coef);
+    rss = rss + calcRSS(obs, i, coef);
+  }
+  double logAcceptance = (-(beta_i/2) * obs.n_total() * std::log(sigma)) -
+    (beta_i / (2 * sigma)) * rss;
+  return logAcceptance;
+}
+
+// Calculates the log acceptance probability of accepting the tempered
+// transitions using contiguous observation storage
+//
+// @name CalculateTTAcceptance
+// @param beta Vector containing the temperature ladder
+// @param obs RaggedObs containing observed values and basis functions
+// @param nu Cube containing nu parameters for all tempered transitions steps
+// @param Phi Field of Cubes containing Phi parameters for all tempered transitions steps
+// @param Z Cube containing Z parameters for all tempered transitions steps
+// @param chi Cube containing chi parameters for all tempered transitions steps
+// @param sigma Vector containing sigma parameters for all tempered transition steps
+// @returns log pdf of acceptance probability
+inline double CalculateTTAcceptance(const arma::vec& beta,
+                                    const RaggedObs& obs,
+                                    const arma::cube& nu,
+                                    const arma::field<arma::cube>& Phi,
+                                    const arma::cube& Z,
+                                    const arma::cube& chi,
+                                    const arma::vec& sigma){
+  double logAcceptance = 0;
+  int m = sigma.n_elem - 1;
+  for(int i = 0; i < (beta.n_elem - 1); i++){
+    // calculate for heating up
+    logAcceptance = logAcceptance + calculatePZeta(beta(i+1), obs, nu.slice(i),
+                                                   Phi(i,0), Z.slice(i),
+                                                   chi.slice(i), i, sigma(i));
+    logAcceptance = logAcceptance - calculatePZeta(beta(i), obs, nu.slice(i),
+                                                   Phi(i,0), Z.slice(i),
+                                                   chi.slice(i), i, sigma(i));
+
+    // calculate for cooling down
+    logAcceptance = logAcceptance - calculatePZeta(beta(i+1), obs, nu.slice(m-i),
+                                                   Phi(m-i,0), Z.slice(m-i),
+                                                   chi.slice(m-i), m-i, sigma(m-i));
+    logAcceptance = logAcceptance + calculatePZeta(beta(i), obs, nu.slice(m-i),
+                                                   Phi(m-i,0), Z.slice(m-i),
+                                                   chi.slice(m-i), m-i, sigma(m-i));
+  }
+  return logAcceptance;
+}
+
+
+// Calculates the (untempered) log-likelihood of every state visited during a
+// tempered transition. Since the tempered likelihood is linear in the
+// temperature, these values are enough to compute the acceptance probability
+// and the energy statistics of each rung of the temperature ladder.
+//
+// @name calcTTLoglik
+// @param obs RaggedObs containing observed values and basis functions
+// @param nu Cube containing nu parameters for all tempered transitions steps
+// @param Phi Field of Cubes containing Phi parameters for all tempered transitions steps
+// @param Z Cube containing Z parameters for all tempered transitions steps
+// @param chi Cube containing chi parameters for all tempered transitions steps
+// @param sigma Vector containing sigma parameters for all tempered transition steps
+// @returns loglik Vector containing the log-likelihood of each state
+inline arma::vec calcTTLoglik(const RaggedObs& obs,
+                              const arma::cube& nu,
+                              const arma::field<arma::cube>& Phi,
+                              const arma::cube& Z,
+                              const arma::cube& chi,
+                              const arma::vec& sigma){
+  arma::vec loglik = arma::zeros(sigma.n_elem);
+  for(int l = 0; l < sigma.n_elem; l++){
+    loglik(l) = calculatePZeta(1.0, obs, nu.slice(l), Phi(l,0), Z.slice(l),
+                               chi.slice(l), l, sigma(l));
+  }
+  return loglik;
+}
+
+// Calculates the (untempered) log-likelihood of every state visited during a
+// tempered transition using single precision observation storage
+//
+// @name calcTTLoglik
+inline arma::vec calcTTLoglik(const RaggedObsF& obs,
+                              const arma::cube& nu,
+                              const arma::field<arma::cube>& Phi,
+                              const arma::cube& Z,
+                              const arma::cube& chi,
+                              const arma::vec& sigma){
+  arma::vec loglik = arma::zeros(sigma.n_elem);
+  for(int l = 0; l < sigma.n_elem; l++){
+    loglik(l) = calculatePZeta(1.0, obs, nu.slice(l), Phi(l,0), Z.slice(l),
+                               chi.slice(l), l, sigma(l));
+  }
+  return loglik;
+}
+
+// Calculates the log acceptance probability of accepting the tempered
+// transitions from the log-likelihood of every state visited
+//
+// @name CalculateTTAcceptance
+// @param beta Vector containing the temperature ladder
+// @param loglik Vector containing the log-likelihood of each state (from calcTTLoglik)
+// @returns log pdf of acceptance probability
+inline double CalculateTTAcceptance(const arma::vec& beta,
+                                    const arma::vec& loglik){
+  double logAcceptance = 0;
+  int m = loglik.n_elem - 1;
+  for(int i = 0; i < (beta.n_elem - 1); i++){
+    logAcceptance = logAcceptance + ((beta(i+1) - beta(i)) *
+      (loglik(i) - loglik(m-i)));
+  }
+  return logAcceptance;
+}
+
 // Calculates the log acceptaMV
 // @param beta_i Double containing the current temperature
 // @param y_obs Matrix containing observed vectors
@@ -279,6 +441,86 @@ inline double CalculateTTAcceptanceCovariateAdj(const arma::vec& beta,
   return logAcceptance;
 }
 
+// Calculates the log acceptance probability at a specific temperature for
+// covariate adjusted model using the cached covariate adjusted coefficients
+//
+// @name calculatePZetaCovariateAdj
+// @param beta_i Double containing the current temperature
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param sigma double containing sigma current parameter
+// @returns logAcceptance Double containing the tempered likelihood pdf
+inline double calculatePZetaCovariateAdj(const double& beta_i,
+                                         const RaggedObs& obs,
+                                         const CovariateEffects& cov,
+                                         const arma::mat& Z,
+                                         const arma::mat& chi,
+                                         const double& sigma){
+  double rss = 0;
+  arma::vec coef = arma::zeros(cov.nu.n_cols);
+  for(int i = 0; i < chi.n_rows; i++){
+    calcMeanCoef(cov, i, Z.row(i), chi.row(i), coef);
+    rss = rss + calcRSS(obs, i, coef);
+  }
+  double logAcceptance = (-(beta_i/2) * obs.n_total() * std::log(sigma)) -
+    (beta_i / (2 * sigma)) * rss;
+  return logAcceptance;
+}
+
+// Calculates the log acceptance probability of accepting the tempered
+// transitions for the covariate adjusted model. The covariate adjusted
+// coefficients are computed once for each tempered transition step.
+//
+// @name CalculateTTAcceptanceCovariateAdj
+// @param beta Vector containing the temperature ladder
+// @param obs RaggedObs containing observed values and basis functions
+// @param nu Cube containing nu parameters for all tempered transition steps
+// @param eta Field of Cubes containing eta parameters for all tempered transition steps
+// @param Phi Field of Cubes containing Phi parameters for all tempered transition steps
+// @param xi Field of Cubes containing xi parameters for all tempered transition steps
+// @param Z Cube containing Z parameters for all tempered transitions steps
+// @param chi Cube containing chi parameters for all tempered transitions steps
+// @param X Matrix containing covariates
+// @param sigma Vector containing sigma parameters for all tempered transition steps
+// @param cov CovariateEffects acting as a placeholder for the covariate adjusted coefficients
+// @returns log pdf of acceptance probability
+inline double CalculateTTAcceptanceCovariateAdj(const arma::vec& beta,
+                                                const RaggedObs& obs,
+                                                const arma::cube& nu,
+                                                const arma::field<arma::cube>& eta,
+                                                const arma::field<arma::cube>& Phi,
+                                                const arma::field<arma::cube>& xi,
+                                                const arma::cube& Z,
+                                                const arma::cube& chi,
+                                                const arma::mat& X,
+                                                const arma::vec& sigma,
+                                                CovariateEffects& cov){
+  double logAcceptance = 0;
+  int m = sigma.n_elem - 1;
+  for(int i = 0; i < (beta.n_elem - 1); i++){
+    // calculate for heating up
+    updateCovariateEffects(nu.slice(i), eta(i,0), Phi(i,0), xi, i, X, cov);
+    logAcceptance = logAcceptance + calculatePZetaCovariateAdj(beta(i+1), obs, cov,
+                                                               Z.slice(i), chi.slice(i),
+                                                               sigma(i));
+    logAcceptance = logAcceptance - calculatePZetaCovariateAdj(beta(i), obs, cov,
+                                                               Z.slice(i), chi.slice(i),
+                                                               sigma(i));
+
+    // calculate for cooling down
+    updateCovariateEffects(nu.slice(m-i), eta(m-i,0), Phi(m-i,0), xi, m-i, X, cov);
+    logAcceptance = logAcceptance - calculatePZetaCovariateAdj(beta(i+1), obs, cov,
+                                                               Z.slice(m-i), chi.slice(m-i),
+                                                               sigma(m-i));
+    logAcceptance = logAcceptance + calculatePZetaCovariateAdj(beta(i), obs, cov,
+                                                               Z.slice(m-i), chi.slice(m-i),
+                                                               sigma(m-i));
+  }
+  return logAcceptance;
+}
+
 // Calculates the log acceptance probability at a specific temperature for multivariate covariate adjusted model
 //
 // @name calculatePZetaMVCovariateAdj
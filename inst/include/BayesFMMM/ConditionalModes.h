@@ -0,0 +1,168 @@
+#ifndef BayesFMMM_CONDITIONAL_MODES_H
+#define BayesFMMM_CONDITIONAL_MODES_H
+
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <functional>
+
+namespace BayesFMMM{
+// Source of "randomness" that returns the mode of the distribution instead
+// of a draw, so that the kernels templated on the source of randomness (e.g.
+// updateDelta and updateGamma) set the parameter to its conditional posterior
+// mode. Only the distributions with a closed-form mode are supported.
+//
+// @name ConditionalMode
+struct ConditionalMode{};
+
+// Gets the mode of the gamma distribution (its mean if shape <= 1, where the
+// mode is 0 and would collapse the precision parameters)
+//
+// @name drawGamma
+// @param shape Double containing the shape parameter
+// @param scale Double containing the scale parameter
+// @param mode ConditionalMode
+// @returns x Double containing the mode
+inline double drawGamma(const double shape,
+                        const double scale,
+                        ConditionalMode& mode){
+  if(shape > 1){
+    return (shape - 1) * scale;
+  }
+  return shape * scale;
+}
+
+// Gets the mode of the standard normal distribution, so that the Gaussian
+// draws of the kernels (e.g. drawGaussianCanonical) return their mean
+//
+// @name drawNorm
+// @param mode ConditionalMode
+// @returns x Double containing the mode
+inline double drawNorm(ConditionalMode& mode){
+  return 0;
+}
+
+// Projects a vector onto the probability simplex (Euclidean projection)
+//
+// @name projectSimplex
+// @param x Vector to be projected
+// @returns proj Vector containing the closest point of the simplex to x
+inline arma::vec projectSimplex(const arma::vec& x){
+  arma::vec u = arma::sort(x, "descend");
+  double cum_sum = 0;
+  double theta = 0;
+  for(int l = 0; l < u.n_elem; l++){
+    cum_sum = cum_sum + u(l);
+    if(u(l) - ((cum_sum - 1) / (l + 1)) > 0){
+      theta = (cum_sum - 1) / (l + 1);
+    }
+  }
+  return arma::clamp(x - theta, 0, arma::datum::inf);
+}
+
+// Projects a vector onto the points of the probability simplex whose elements
+// are all greater than or equal to z_min
+//
+// @name projectSimplex
+// @param x Vector to be projected
+// @param z_min Double containing the lower bound of the elements (z_min * x.n_elem < 1)
+// @returns proj Vector containing the closest point of the truncated simplex to x
+inline arma::vec projectSimplex(const arma::vec& x,
+                                const double z_min){
+  double scale = 1 - (z_min * x.n_elem);
+  return z_min + scale * projectSimplex((x - z_min) / scale);
+}
+
+// Maximizes a smooth function over the points of the probability simplex
+// whose elements are all greater than or equal to z_min, using projected
+// gradient ascent with backtracking
+//
+// @name maximizeSimplex
+// @param f Function to be maximized
+// @param grad Function returning the gradient of f
+// @param z_min Double containing the lower bound of the elements
+// @param n_steps Int containing the maximum number of projected gradient steps
+// @param step Double containing the initial step size
+// @param z Vector containing the starting point and acting as a placeholder for the maximizer
+inline void maximizeSimplex(const std::function<double(const arma::vec&)>& f,
+                            const std::function<arma::vec(const arma::vec&)>& grad,
+                            const double z_min,
+                            const int n_steps,
+                            double step,
+                            arma::vec& z){
+  z = projectSimplex(z, z_min);
+  double f_z = f(z);
+  arma::vec g;
+  arma::vec z_new;
+  arma::vec d;
+  double f_new = 0;
+  for(int j = 0; j < n_steps; j++){
+    g = grad(z);
+    while(true){
+      z_new = projectSimplex(z + step * g, z_min);
+      f_new = f(z_new);
+      d = z_new - z;
+      if((f_new >= f_z + arma::dot(g, d) - (arma::dot(d, d) / (2 * step))) ||
+         (step < 1e-14)){
+        break;
+      }
+      step = step / 2;
+    }
+    if(!(f_new >= f_z)){
+      break;
+    }
+    z = z_new;
+    f_z = f_new;
+    if(arma::abs(d).max() < 1e-8){
+      break;
+    }
+    step = 2 * step;
+  }
+}
+
+// Maximizes a unimodal function of a positive parameter by golden section
+// search on the log scale, within a factor of exp(width) of the current value
+//
+// @name maximizePositive
+// @param f Function to be maximized
+// @param width Double containing the half-width of the search interval on the log scale
+// @param n_steps Int containing the number of golden section steps
+// @param x Double containing the current value and acting as a placeholder for the maximizer
+inline void maximizePositive(const std::function<double(const double)>& f,
+                             const double width,
+                             const int n_steps,
+                             double& x){
+  // undefined values are never the maximum
+  auto f_log = [&](const double u){
+    double f_u = f(std::exp(u));
+    return std::isnan(f_u) ? -arma::datum::inf : f_u;
+  };
+  double ratio = (std::sqrt(5.0) - 1) / 2;
+  double lower = std::log(x) - width;
+  double upper = std::log(x) + width;
+  double u_1 = upper - ratio * (upper - lower);
+  double u_2 = lower + ratio * (upper - lower);
+  double f_1 = f_log(u_1);
+  double f_2 = f_log(u_2);
+  for(int j = 0; j < n_steps; j++){
+    if(f_1 >= f_2){
+      upper = u_2;
+      u_2 = u_1;
+      f_2 = f_1;
+      u_1 = upper - ratio * (upper - lower);
+      f_1 = f_log(u_1);
+    }else{
+      lower = u_1;
+      u_1 = u_2;
+      f_1 = f_2;
+      u_2 = lower + ratio * (upper - lower);
+      f_2 = f_log(u_2);
+    }
+  }
+  double x_new = std::exp((lower + upper) / 2);
+  if(f_log(std::log(x_new)) >= f_log(std::log(x))){
+    x = x_new;
+  }
+}
+}
+
+#endif
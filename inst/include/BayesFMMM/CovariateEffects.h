@@ -0,0 +1,89 @@
+#ifndef BayesFMMM_COVARIATE_EFFECTS_H
+#define BayesFMMM_COVARIATE_EFFECTS_H
+
+#include <RcppArmadillo.h>
+#include <cmath>
+#include "RaggedObs.h"
+
+namespace BayesFMMM{
+// Covariate adjusted mean and eigenfunction coefficients of every function.
+// For the ith function, slice i of nu contains nu_k + eta_k * X_i in row k,
+// and Phi(i,0) contains Phi_kn + xi_kn * X_i in row k of slice n, so the
+// covariate adjusted model can be evaluated in the same way as the
+// unadjusted model.
+//
+// @name CovariateEffects
+// @field nu Cube (K x P x n_funct) containing the covariate adjusted mean coefficients
+// @field Phi Field of cubes (n_funct x 1, each K x P x M) containing the covariate adjusted eigenfunction coefficients
+struct CovariateEffects{
+  arma::cube nu;
+  arma::field<arma::cube> Phi;
+};
+
+// Computes the covariate adjusted coefficients of every function from the
+// current values of nu, eta, Phi and xi
+//
+// @name updateCovariateEffects
+// @param nu Matrix containing current nu parameters
+// @param eta Cube containing current eta parameters
+// @param Phi Cube containing current Phi parameters
+// @param xi Field of cubes containing xi parameters
+// @param iter Int containing current mcmc sample
+// @param X Matrix containing covariates
+// @param cov CovariateEffects acting as a placeholder for the covariate adjusted coefficients
+inline void updateCovariateEffects(const arma::mat& nu,
+                                   const arma::cube& eta,
+                                   const arma::cube& Phi,
+                                   const arma::field<arma::cube>& xi,
+                                   const int& iter,
+                                   const arma::mat& X,
+                                   CovariateEffects& cov){
+  int n_funct = X.n_rows;
+  if((cov.nu.n_rows != nu.n_rows) || (cov.nu.n_cols != nu.n_cols) ||
+     (cov.nu.n_slices != X.n_rows)){
+    cov.nu.set_size(nu.n_rows, nu.n_cols, n_funct);
+    cov.Phi.set_size(n_funct, 1);
+  }
+
+  arma::mat eta_X;
+  for(int k = 0; k < nu.n_rows; k++){
+    // covariate effects of all functions (P x n_funct)
+    eta_X = eta.slice(k) * X.t();
+    eta_X.each_col() += nu.row(k).t();
+    for(int i = 0; i < n_funct; i++){
+      cov.nu.slice(i).row(k) = eta_X.col(i).t();
+    }
+  }
+
+  for(int i = 0; i < n_funct; i++){
+    cov.Phi(i,0) = Phi;
+  }
+  for(int k = 0; k < nu.n_rows; k++){
+    for(int n = 0; n < Phi.n_slices; n++){
+      eta_X = xi(iter,k).slice(n) * X.t();
+      for(int i = 0; i < n_funct; i++){
+        cov.Phi(i,0).slice(n).row(k) += eta_X.col(i).t();
+      }
+    }
+  }
+}
+
+// Calculates the basis coefficients of the conditional mean of a function
+// for the covariate adjusted model
+//
+// @name calcMeanCoef
+// @param cov CovariateEffects containing the covariate adjusted coefficients
+// @param i Int containing the function of interest
+// @param Z Vector containing the row of Z for the function of interest
+// @param chi Vector containing the row of chi for the function of interest
+// @param coef Vector acting as a placeholder for the coefficients
+inline void calcMeanCoef(const CovariateEffects& cov,
+                         const int& i,
+                         const arma::rowvec& Z,
+                         const arma::rowvec& chi,
+                         arma::vec& coef){
+  calcMeanCoef(cov.nu.slice(i), cov.Phi(i,0), Z, chi, coef);
+}
+}
+
+#endif
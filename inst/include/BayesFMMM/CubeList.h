@@ -0,0 +1,79 @@
+#ifndef BayesFMMM_CUBE_LIST_H
+#define BayesFMMM_CUBE_LIST_H
+
+#include <RcppArmadillo.h>
+#include <vector>
+
+namespace BayesFMMM{
+// Read-only access to a list of equally sized cubes passed in from R without
+// copying. The input can either be a list of 3-dimensional arrays (as returned
+// by the samplers) or a packed 4-dimensional array, where the last dimension
+// indexes the list element. All elements alias R memory, so a CubeList must not
+// outlive the R object it was constructed from.
+//
+// @name CubeList
+// @param x R object containing a list of arrays or a packed 4-dimensional array
+class CubeList{
+public:
+  arma::uword n_elem;
+  arma::uword n_rows;
+  arma::uword n_cols;
+  arma::uword n_slices;
+
+  CubeList(SEXP x){
+    if(Rf_isNewList(x)){
+      Rcpp::List x_list(x);
+      n_elem = x_list.size();
+      if(n_elem == 0){
+        Rcpp::stop("list of cubes must contain at least one element");
+      }
+      for(arma::uword l = 0; l < n_elem; l++){
+        Rcpp::NumericVector x_l(x_list[l]);
+        Rcpp::IntegerVector dim_l = x_l.attr("dim");
+        if(dim_l.size() != 3){
+          Rcpp::stop("all elements of the list must be 3-dimensional arrays");
+        }
+        if(l == 0){
+          n_rows = dim_l[0];
+          n_cols = dim_l[1];
+          n_slices = dim_l[2];
+        }
+        if((dim_l[0] != n_rows) || (dim_l[1] != n_cols) || (dim_l[2] != n_slices)){
+          Rcpp::stop("all elements of the list must have the same dimensions");
+        }
+        storage.push_back(x_l);
+        ptrs.push_back(x_l.begin());
+      }
+    }else{
+      Rcpp::NumericVector x_packed(x);
+      Rcpp::IntegerVector dim = x_packed.attr("dim");
+      if(dim.size() != 4){
+        Rcpp::stop("packed cubes must be stored in a 4-dimensional array");
+      }
+      n_rows = dim[0];
+      n_cols = dim[1];
+      n_slices = dim[2];
+      n_elem = dim[3];
+      storage.push_back(x_packed);
+      for(arma::uword l = 0; l < n_elem; l++){
+        ptrs.push_back(x_packed.begin() + l * n_rows * n_cols * n_slices);
+      }
+    }
+  }
+
+  // Element (i,j,m) of the lth cube
+  double operator()(const arma::uword l,
+                    const arma::uword i,
+                    const arma::uword j,
+                    const arma::uword m) const{
+    return ptrs[l][i + n_rows * (j + n_cols * m)];
+  }
+
+private:
+  // keeps the R objects referenced by ptrs alive
+  std::vector<Rcpp::NumericVector> storage;
+  std::vector<const double*> ptrs;
+};
+}
+
+#endif
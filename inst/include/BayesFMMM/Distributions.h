@@ -2,7 +2,10 @@
 #define BayesFMMM_DISTRIBUTIONS_H
 
 #include <RcppArmadillo.h>
+#include <algorithm>
 #include <cmath>
+#include <random>
+#include <truncnorm.h>
 
 namespace BayesFMMM {
 // Calculates log gamma of a double
@@ -14,6 +17,95 @@ inline double logGamma(double x){
   return log(tgamma(x));
 }
 
+// Source of randomness that draws from R's random number generator. The
+// updates of the prior-side parameters are templated on the source of
+// randomness, so the same kernel is used with R's generator (RRng, only on
+// the main thread) and with a random number engine owned by the calling
+// thread (std::mt19937_64, safe to call from multiple threads).
+//
+// @name RRng
+struct RRng{};
+
+// Generates a random sample from the gamma distribution
+//
+// @name drawGamma
+// @param shape Double containing the shape parameter
+// @param scale Double containing the scale parameter
+// @param rng Source of randomness
+// @returns x Double containing the random sample
+inline double drawGamma(const double shape,
+                        const double scale,
+                        RRng& rng){
+  return R::rgamma(shape, scale);
+}
+
+inline double drawGamma(const double shape,
+                        const double scale,
+                        std::mt19937_64& rng){
+  std::gamma_distribution<double> rgamma(shape, scale);
+  return rgamma(rng);
+}
+
+// Generates a random sample from the uniform distribution on (0, 1)
+//
+// @name drawUnif
+// @param rng Source of randomness
+// @returns x Double containing the random sample
+inline double drawUnif(RRng& rng){
+  return R::runif(0, 1);
+}
+
+inline double drawUnif(std::mt19937_64& rng){
+  std::uniform_real_distribution<double> runif(0.0, 1.0);
+  return runif(rng);
+}
+
+// Generates a random sample from the standard normal distribution
+//
+// @name drawNorm
+// @param rng Source of randomness
+// @returns x Double containing the random sample
+inline double drawNorm(RRng& rng){
+  return R::norm_rand();
+}
+
+inline double drawNorm(std::mt19937_64& rng){
+  std::normal_distribution<double> rnorm(0.0, 1.0);
+  return rnorm(rng);
+}
+
+// Generates a random sample from the Dirichlet Distribution
+//
+// @name rdirichlet
+// @param alpha Vector containing concentration parameters
+// @param rng Source of randomness (RRng or a random number engine owned by the calling thread)
+// @returns distribution Vector containing the random sample
+template <typename Rng>
+inline arma::vec rdirichlet(arma::vec alpha,
+                            Rng& rng){
+  // Check for numerical stability
+  for(int i = 0; i < alpha.n_elem; i++){
+    if(alpha(i) <= 0){
+      alpha(i) = 10;
+    }
+  }
+  arma::vec distribution(alpha.n_elem, arma::fill::zeros);
+
+  double sum_term = 0;
+
+  for (int j = 0; j < alpha.n_elem; ++j) {
+    double gam = drawGamma(alpha[j], 1.0, rng);
+    distribution(j) = gam;
+    sum_term += gam;
+  }
+
+  for (int j = 0; j < alpha.n_elem; ++j) {
+    distribution(j) = distribution(j) / sum_term;
+  }
+
+  return distribution;
+}
+
 // Generates a random sample from the Dirichlet Distribution
 //
 // @name rdirichlet
@@ -43,7 +135,33 @@ inline arma::vec rdirichlet(arma::vec alpha){
   return distribution;
 }
 
-// Calculates the log of B(a) function used in the dirichlet distribution
+// Generates a random sample from the Dirichlet Distribution into a
+// placeholder (same draws as rdirichlet(alpha), without allocating when the
+// placeholder already has the right size)
+//
+// @name rdirichlet
+// @param alpha Vector containing concentration parameters
+// @param distribution Vector acting as a placeholder for the random sample
+inline void rdirichlet(const arma::vec& alpha,
+                       arma::vec& distribution){
+  distribution.set_size(alpha.n_elem);
+  double sum_term = 0;
+
+  for (int j = 0; j < alpha.n_elem; ++j) {
+    // Check for numerical stability
+    double gam = R::rgamma((alpha[j] <= 0) ? 10 : alpha[j], 1.0);
+    distribution(j) = gam;
+    sum_term += gam;
+  }
+
+  for (int j = 0; j < alpha.n_elem; ++j) {
+    distribution(j) = distribution(j) / sum_term;
+  }
+}
+
+// Calculates the log of B(a) function used in the dirichlet distribution.
+// R::lgammafn is used instead of std::lgamma, which writes the global signgam
+// and so cannot be called from the kernels run over threads.
 //
 // @name calc_lB
 // @param alpha Vector containing input to the function
@@ -52,13 +170,179 @@ inline double calc_lB(const arma::vec& alpha){
   double log_B = 0;
 
   for(int i=0; i < alpha.n_elem; i++){
-    log_B = log_B + std::lgamma(alpha(i));
+    log_B = log_B + R::lgammafn(alpha(i));
   }
-  log_B = log_B - std::lgamma(arma::accu(alpha));
+  log_B = log_B - R::lgammafn(arma::accu(alpha));
 
   return log_B;
 }
 
+// Converts the log of a Metropolis-Hastings ratio into an acceptance
+// probability (proposals with an undefined ratio are never accepted)
+//
+// @name calcAcceptanceProb
+// @param log_ratio Double containing the log of the Metropolis-Hastings ratio
+// @returns prob Double containing the acceptance probability
+inline double calcAcceptanceProb(const double log_ratio){
+  if(std::isnan(log_ratio)){
+    return 0;
+  }
+  if(log_ratio >= 0){
+    return 1;
+  }
+  return std::exp(log_ratio);
+}
+
+// Generates a random sample from a normal distribution truncated to the
+// positive real line using a given random number engine (safe to call from
+// multiple threads, unlike r_truncnorm). Naive rejection is used when the
+// truncation point is close to the mean, and the exponential rejection
+// sampler of Robert (1995) otherwise.
+//
+// @name rtruncnormPositive
+// @param mean Double containing the mean of the untruncated distribution
+// @param sd Double containing the standard deviation of the untruncated distribution
+// @param rng Random number engine owned by the calling thread
+// @returns x Double containing the random sample
+inline double rtruncnormPositive(const double mean,
+                                 const double sd,
+                                 std::mt19937_64& rng){
+  std::normal_distribution<double> rnorm(0.0, 1.0);
+  std::uniform_real_distribution<double> runif(0.0, 1.0);
+  double alpha = -mean / sd;
+  double z = 0;
+  if(alpha < 0.5){
+    do{
+      z = rnorm(rng);
+    }while(z <= alpha);
+  }else{
+    double lambda = 0.5 * (alpha + std::sqrt((alpha * alpha) + 4));
+    std::exponential_distribution<double> rexp(lambda);
+    do{
+      z = alpha + rexp(rng);
+    }while(runif(rng) > std::exp(-0.5 * (z - lambda) * (z - lambda)));
+  }
+  return mean + (sd * z);
+}
+
+// Generates a random sample from a normal distribution truncated to the
+// positive real line
+//
+// @name drawTruncnormPositive
+// @param mean Double containing the mean of the untruncated distribution
+// @param sd Double containing the standard deviation of the untruncated distribution
+// @param rng Source of randomness
+// @returns x Double containing the random sample
+inline double drawTruncnormPositive(const double mean,
+                                    const double sd,
+                                    RRng& rng){
+  return r_truncnorm(mean, sd, 0, std::numeric_limits<double>::infinity());
+}
+
+inline double drawTruncnormPositive(const double mean,
+                                    const double sd,
+                                    std::mt19937_64& rng){
+  return rtruncnormPositive(mean, sd, rng);
+}
+
+// Generates a random sample from the Gaussian distribution with precision Q
+// and mean Q^{-1} b. Q is factorized as U'U by a Cholesky decomposition and
+// U^{-1} is formed in place, so no temporaries are allocated once the
+// placeholders have the right size. Only the upper triangle of Q is read. If
+// Q is not positive definite the covariance is taken to be the pseudo-inverse
+// of Q.
+//
+// @name drawGaussianCanonical
+// @param Q Matrix containing the precision (overwritten with the covariance)
+// @param b Vector containing the precision times the mean
+// @param rng Source of randomness (ConditionalMode sets x to the mean)
+// @param U Matrix (P x P) acting as a placeholder for the inverse Cholesky factor
+// @param mean Vector (P) acting as a placeholder for the mean
+// @param x Vector (P) acting as a placeholder for the random sample
+template <typename Rng>
+inline void drawGaussianCanonical(arma::mat& Q,
+                                  const arma::vec& b,
+                                  Rng& rng,
+                                  arma::mat& U,
+                                  arma::vec& mean,
+                                  arma::vec& x){
+  const arma::uword P = Q.n_rows;
+  bool pos_def = true;
+  double s = 0;
+
+  // upper triangular U with U'U = Q
+  for(arma::uword j = 0; (j < P) && pos_def; j++){
+    for(arma::uword i = 0; i <= j; i++){
+      s = Q.at(i,j);
+      for(arma::uword k = 0; k < i; k++){
+        s = s - U.at(k,i) * U.at(k,j);
+      }
+      if(i < j){
+        U.at(i,j) = s / U.at(i,i);
+      }else if(s > 0){
+        U.at(j,j) = std::sqrt(s);
+      }else{
+        pos_def = false;
+      }
+    }
+    for(arma::uword i = j + 1; i < P; i++){
+      U.at(i,j) = 0;
+    }
+  }
+
+  if(pos_def){
+    // U^{-1}, column by column
+    for(arma::uword j = 0; j < P; j++){
+      U.at(j,j) = 1 / U.at(j,j);
+      for(arma::uword i = 0; i < j; i++){
+        s = 0;
+        for(arma::uword k = i; k < j; k++){
+          s = s + U.at(i,k) * U.at(k,j);
+        }
+        U.at(i,j) = -s * U.at(j,j);
+      }
+    }
+    // covariance U^{-1} U^{-T}
+    for(arma::uword j = 0; j < P; j++){
+      for(arma::uword i = 0; i <= j; i++){
+        s = 0;
+        for(arma::uword k = j; k < P; k++){
+          s = s + U.at(i,k) * U.at(j,k);
+        }
+        Q.at(i,j) = s;
+        Q.at(j,i) = s;
+      }
+    }
+  }else{
+    Q = arma::pinv(arma::symmatu(Q));
+    Q = (Q + Q.t()) / 2;
+    arma::vec eigval;
+    arma::eig_sym(eigval, U, Q);
+    for(arma::uword k = 0; k < P; k++){
+      U.col(k) *= std::sqrt(std::max(eigval(k), 0.0));
+    }
+  }
+
+  // x = mean + U^{-1} z, where U^{-1} is upper triangular unless Q was
+  // not positive definite
+  for(arma::uword i = 0; i < P; i++){
+    s = 0;
+    for(arma::uword k = 0; k < P; k++){
+      s = s + Q.at(i,k) * b.at(k);
+    }
+    mean.at(i) = s;
+    x.at(i) = s;
+  }
+  for(arma::uword k = 0; k < P; k++){
+    s = drawNorm(rng);
+    if(s != 0){
+      for(arma::uword i = 0; i < P; i++){
+        x.at(i) = x.at(i) + U.at(i,k) * s;
+      }
+    }
+  }
+}
+
 }
 
 #endif
@@ -0,0 +1,193 @@
+#ifndef BayesFMMM_GIBBS_SCHEDULER_H
+#define BayesFMMM_GIBBS_SCHEDULER_H
+
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <random>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace BayesFMMM{
+// One block of a Gibbs sweep. Blocks that use R's random number generator
+// (uses_r = true) are always run by the main thread (the thread R runs on),
+// which may use the remaining threads for its own per-subject parallelism
+// (e.g. through parallelForSubjects); the other blocks receive a random number
+// engine seeded from R's random number generator, cannot use the R API, and
+// may be run by any thread.
+//
+// @name GibbsBlock
+// @field update Function performing the update of the block
+// @field deps Vector containing the indices of the blocks that must be updated before this block
+// @field uses_r Boolean indicating whether the block uses R's random number generator
+// @field wave Int containing the index of the wave the block belongs to
+struct GibbsBlock{
+  std::function<void(std::mt19937_64&)> update;
+  std::vector<int> deps;
+  bool uses_r;
+  int wave;
+};
+
+// Dependency graph of the blocks of a Gibbs sweep. Block j depends on block i
+// if j reads a parameter drawn by i in the same sweep, or if j draws a
+// parameter that i reads from the previous sweep, so any order respecting the
+// dependencies gives the same Markov kernel as the sequential sweep. Blocks
+// are grouped into waves, where the blocks of a wave only depend on blocks of
+// earlier waves and are therefore conditionally independent of each other.
+//
+// @name GibbsSchedule
+// @field blocks Vector containing the blocks in the order of the sequential sweep
+// @field waves Vector containing the indices of the blocks in each wave
+struct GibbsSchedule{
+  std::vector<GibbsBlock> blocks;
+  std::vector<std::vector<int> > waves;
+};
+
+// Adds a block to the Gibbs sweep. Blocks must be added in the order of the
+// sequential sweep, so a block can only depend on blocks added before it.
+//
+// @name addGibbsBlock
+// @param deps Vector containing the indices of the blocks that must be updated before this block
+// @param uses_r Boolean indicating whether the block uses R's random number generator
+// @param update Function performing the update of the block
+// @param schedule GibbsSchedule to which the block is added
+// @returns index Int containing the index of the block
+inline int addGibbsBlock(const std::vector<int>& deps,
+                         const bool uses_r,
+                         const std::function<void(std::mt19937_64&)>& update,
+                         GibbsSchedule& schedule){
+  int index = schedule.blocks.size();
+  GibbsBlock block;
+  block.update = update;
+  block.deps = deps;
+  block.uses_r = uses_r;
+  block.wave = 0;
+  for(int j = 0; j < deps.size(); j++){
+    if((deps[j] < 0) || (deps[j] >= index)){
+      Rcpp::stop("blocks of a Gibbs sweep can only depend on blocks added before them");
+    }
+    block.wave = std::max(block.wave, schedule.blocks[deps[j]].wave + 1);
+  }
+  if(block.wave >= schedule.waves.size()){
+    schedule.waves.resize(block.wave + 1);
+  }
+  schedule.waves[block.wave].push_back(index);
+  schedule.blocks.push_back(block);
+  return index;
+}
+
+// Runs the given blocks of a wave in order, each with an engine seeded from
+// the corresponding seed
+//
+// @name runEngineBlocks
+// @param schedule GibbsSchedule containing the blocks of the sweep
+// @param blocks Vector containing the indices of the blocks to run
+// @param seeds Vector containing the seed of the engine of each block
+inline void runEngineBlocks(GibbsSchedule& schedule,
+                            const std::vector<int>& blocks,
+                            const std::vector<std::uint64_t>& seeds){
+  std::mt19937_64 rng;
+  for(int l = 0; l < blocks.size(); l++){
+    rng.seed(seeds[l]);
+    schedule.blocks[blocks[l]].update(rng);
+  }
+}
+
+// Performs one Gibbs sweep. The waves are run in order. Within a wave, the
+// engines of the blocks that do not use R's random number generator are
+// seeded from R's random number generator first, so the draws only depend on
+// the seed set in R and not on the number of threads. If the wave contains
+// both kinds of blocks, one thread runs the engine blocks while the main
+// thread runs the blocks using R's random number generator, whose per-subject
+// loops are given the remaining threads through a nested parallel region.
+// Waves with only engine blocks run them in parallel (one block per thread),
+// and waves with only R blocks run them on the main thread.
+//
+// @name runGibbsSchedule
+// @param schedule GibbsSchedule containing the blocks of the sweep
+inline void runGibbsSchedule(GibbsSchedule& schedule){
+  std::mt19937_64 rng_main;
+  for(int w = 0; w < schedule.waves.size(); w++){
+    const std::vector<int>& wave = schedule.waves[w];
+    std::vector<int> engine_blocks;
+    std::vector<int> r_blocks;
+    std::vector<std::uint64_t> seeds;
+    for(int j = 0; j < wave.size(); j++){
+      if(schedule.blocks[wave[j]].uses_r){
+        r_blocks.push_back(wave[j]);
+      }else{
+        seeds.push_back((std::uint64_t) std::floor(R::runif(0, 4294967296.0)));
+        engine_blocks.push_back(wave[j]);
+      }
+    }
+    int n_engine = engine_blocks.size();
+    int n_threads = 1;
+#ifdef _OPENMP
+    n_threads = omp_get_max_threads();
+#endif
+
+    if((n_engine > 0) && (r_blocks.size() > 0) && (n_threads > 1)){
+      // overlap the engine blocks with the blocks using R's generator
+      std::exception_ptr error;
+#ifdef _OPENMP
+      int max_levels = omp_get_max_active_levels();
+      omp_set_max_active_levels(std::max(max_levels, 2));
+#endif
+      #pragma omp parallel num_threads(2)
+      {
+        int tid = 0;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+#endif
+        try{
+          if(tid == 0){
+#ifdef _OPENMP
+            omp_set_num_threads(n_threads - 1);
+#endif
+            for(int j = 0; j < r_blocks.size(); j++){
+              schedule.blocks[r_blocks[j]].update(rng_main);
+            }
+          }else{
+            runEngineBlocks(schedule, engine_blocks, seeds);
+          }
+        }catch(...){
+          // exceptions cannot leave the parallel region
+          #pragma omp critical(gibbs_schedule_error)
+          {
+            if(!error){
+              error = std::current_exception();
+            }
+          }
+        }
+      }
+#ifdef _OPENMP
+      omp_set_max_active_levels(max_levels);
+#endif
+      if(error){
+        std::rethrow_exception(error);
+      }
+      continue;
+    }
+
+    if(n_engine == 1){
+      runEngineBlocks(schedule, engine_blocks, seeds);
+    }else if(n_engine > 1){
+      #pragma omp parallel for schedule(dynamic, 1)
+      for(int l = 0; l < n_engine; l++){
+        std::mt19937_64 rng(seeds[l]);
+        schedule.blocks[engine_blocks[l]].update(rng);
+      }
+    }
+    for(int j = 0; j < r_blocks.size(); j++){
+      schedule.blocks[r_blocks[j]].update(rng_main);
+    }
+  }
+}
+}
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef BayesFMMM_INFORMATION_CRITERIA_H
+#define BayesFMMM_INFORMATION_CRITERIA_H
+
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <limits>
+#include "RaggedObs.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace BayesFMMM{
+// Calculates log(sum(exp(x))) without overflow
+//
+// @name logSumExp
+// @param x Vector of log values
+// @returns lse Double containing log(sum(exp(x)))
+inline double logSumExp(const arma::vec& x){
+  double max_x = x.max();
+  return max_x + std::log(arma::accu(arma::exp(x - max_x)));
+}
+
+// Fits a generalized Pareto distribution using the empirical Bayes estimate
+// of Zhang and Stephens (2009), with the weakly informative prior on the shape
+// parameter used in Pareto smoothed importance sampling
+//
+// @name gpdFit
+// @param x Vector containing the exceedances over the threshold (sorted in increasing order)
+// @param k Double acting as a placeholder for the shape parameter
+// @param sigma Double acting as a placeholder for the scale parameter
+inline void gpdFit(const arma::vec& x,
+                   double& k,
+                   double& sigma){
+  int n = x.n_elem;
+  int m = 30 + std::floor(std::sqrt((double) n));
+  double prior = 3;
+  double x_star = x(std::floor((n / 4.0) + 0.5) - 1);
+  arma::vec theta = arma::zeros(m);
+  arma::vec l_theta = arma::zeros(m);
+  double k_j = 0;
+  for(int j = 0; j < m; j++){
+    theta(j) = (1 / x(n - 1)) + (1 - std::sqrt(m / (j + 0.5))) / prior / x_star;
+    k_j = 0;
+    for(int i = 0; i < n; i++){
+      k_j = k_j + std::log1p(-theta(j) * x(i));
+    }
+    k_j = k_j / n;
+    l_theta(j) = n * (std::log(-theta(j) / k_j) - k_j - 1);
+  }
+  arma::vec w_theta = arma::exp(l_theta - logSumExp(l_theta));
+  double theta_hat = arma::dot(theta, w_theta);
+
+  k = 0;
+  for(int i = 0; i < n; i++){
+    k = k + std::log1p(-theta_hat * x(i));
+  }
+  k = k / n;
+  sigma = -k / theta_hat;
+
+  // shrink towards 0.5 for small tail sizes
+  k = ((k * n) + (0.5 * 10)) / (n + 10);
+}
+
+// Calculates the leave-one-out log predictive density of one observation
+// using Pareto smoothed importance sampling (Vehtari, Gelman and Gabry, 2017)
+//
+// @name calcPSISLoo
+// @param ll Vector containing the log-likelihood of the observation for each MCMC sample
+// @param k_hat Double acting as a placeholder for the estimated Pareto shape parameter
+// @returns elpd_loo Double containing the leave-one-out log predictive density
+inline double calcPSISLoo(const arma::vec& ll,
+                          double& k_hat){
+  int S = ll.n_elem;
+  arma::vec lw = -ll;
+  lw = lw - lw.max();
+  int tail_len = std::ceil(std::min(0.2 * S, 3 * std::sqrt((double) S)));
+  k_hat = std::numeric_limits<double>::infinity();
+
+  if((tail_len >= 5) && (S > tail_len)){
+    arma::uvec ord = arma::sort_index(lw);
+    arma::vec lw_sorted = lw(ord);
+    arma::vec lw_tail = lw_sorted.tail(tail_len);
+    double cutoff = lw_sorted(S - tail_len - 1);
+    if((lw_tail.max() - lw_tail.min()) > 1e-14){
+      // fit generalized Pareto distribution to the largest weights
+      double exp_cutoff = std::exp(cutoff);
+      arma::vec x = arma::exp(lw_tail) - exp_cutoff;
+      double k = 0;
+      double sigma = 0;
+      gpdFit(x, k, sigma);
+      if(std::isfinite(k)){
+        // replace largest weights by expected order statistics
+        double p = 0;
+        double q = 0;
+        for(int z = 0; z < tail_len; z++){
+          p = (z + 0.5) / tail_len;
+          if(std::abs(k) > 1e-10){
+            q = sigma * std::expm1(-k * std::log1p(-p)) / k;
+          }else{
+            q = -sigma * std::log1p(-p);
+          }
+          lw(ord(S - tail_len + z)) = std::log(q + exp_cutoff);
+        }
+      }
+      k_hat = k;
+    }
+  }
+
+  // truncate at the largest raw weight
+  lw.elem(arma::find(lw > 0)).zeros();
+  return logSumExp(lw + ll) - logSumExp(lw);
+}
+
+// Calculates DIC, WAIC and PSIS-LOO of the functional model. The pointwise
+// log-likelihood of every observed time point is computed in a single pass
+// over the functions, where the fitted curves of all MCMC samples are
+// obtained with one matrix product per function. Functions are processed in
+// parallel when OpenMP is available. The pointwise log-likelihood requires
+// the observations themselves, so compressed observations (see
+// compressRaggedObs) cannot be used.
+//
+// @name calcInformationCriteria
+// @param obs RaggedObs containing observed values and basis functions
+// @param nu Cube containing MCMC samples of nu
+// @param Phi Field of cubes containing MCMC samples of Phi
+// @param Z Cube containing MCMC samples of Z
+// @param chi Cube containing MCMC samples of chi
+// @param sigma Vector containing MCMC samples of sigma
+// @param burnin Int containing number of MCMC samples to discard
+// @returns IC List containing DIC, WAIC, LOOIC and their components
+inline Rcpp::List calcInformationCriteria(const RaggedObs& obs,
+                                          const arma::cube& nu,
+                                          const arma::field<arma::cube>& Phi,
+                                          const arma::cube& Z,
+                                          const arma::cube& chi,
+                                          const arma::vec& sigma,
+                                          const int burnin){
+  if(obs.compressed()){
+    Rcpp::stop("the information criteria cannot be calculated from compressed observations");
+  }
+  int S = nu.n_slices - burnin;
+  int n_funct = obs.n_funct();
+  arma::vec pareto_k = arma::zeros(obs.y.n_elem);
+
+  // constant part of the log-likelihood for each sample
+  arma::vec log_norm = -0.5 * arma::log(2 * M_PI * sigma.subvec(burnin, sigma.n_elem - 1));
+
+  double lppd = 0;
+  double expected_log_f = 0;
+  double p_waic = 0;
+  double elpd_loo = 0;
+
+  #pragma omp parallel for schedule(dynamic) reduction(+:lppd,expected_log_f,p_waic,elpd_loo)
+  for(int i = 0; i < n_funct; i++){
+    if(obs.n_obs(i) == 0){
+      continue;
+    }
+    // basis coefficients of the fitted curve for every sample
+    arma::mat coef = arma::zeros(nu.n_cols, S);
+    for(int s = 0; s < S; s++){
+      arma::rowvec Z_i = Z.slice(s + burnin).row(i);
+      coef.col(s) = nu.slice(s + burnin).t() * Z_i.t();
+      for(int n = 0; n < chi.n_cols; n++){
+        coef.col(s) = coef.col(s) + chi(i, n, s + burnin) *
+          (Phi(s + burnin, 0).slice(n).t() * Z_i.t());
+      }
+    }
+    arma::mat fit = obs.B_i(i).t() * coef;
+
+    // pointwise log-likelihood (time points x samples)
+    arma::mat ll = fit.each_col() - obs.y_i(i);
+    ll = arma::square(ll);
+    ll.each_row() %= (-0.5 / sigma.subvec(burnin, sigma.n_elem - 1)).t();
+    ll.each_row() += log_norm.t();
+
+    double k_hat = 0;
+    arma::vec ll_j;
+    for(int j = 0; j < ll.n_rows; j++){
+      ll_j = ll.row(j).t();
+      lppd += logSumExp(ll_j) - std::log((double) S);
+      expected_log_f += arma::mean(ll_j);
+      p_waic += arma::var(ll_j);
+      elpd_loo += calcPSISLoo(ll_j, k_hat);
+      pareto_k(obs.offsets(i) + j) = k_hat;
+    }
+  }
+
+  double DIC = (2 * lppd) - (4 * expected_log_f);
+  double WAIC = -2 * (lppd - p_waic);
+  double LOOIC = -2 * elpd_loo;
+  return Rcpp::List::create(Rcpp::Named("DIC", DIC),
+                            Rcpp::Named("WAIC", WAIC),
+                            Rcpp::Named("p_waic", p_waic),
+                            Rcpp::Named("LOOIC", LOOIC),
+                            Rcpp::Named("elpd_loo", elpd_loo),
+                            Rcpp::Named("p_loo", lppd - elpd_loo),
+                            Rcpp::Named("lppd", lppd),
+                            Rcpp::Named("pareto_k", pareto_k));
+}
+}
+
+#endif
@@ -0,0 +1,727 @@
+#ifndef BayesFMMM_KERNEL_POLICIES_H
+#define BayesFMMM_KERNEL_POLICIES_H
+
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <string>
+#include "CovariateEffects.h"
+#include "RaggedObs.h"
+#include "SubjectScheduler.h"
+
+namespace BayesFMMM{
+// Policies used to instantiate one kernel for every variant of the model.
+// Kernels are templated on
+//   - a tempering policy, which scales the log-likelihood terms (Untempered
+//     compiles the scaling away, so the cold chain pays nothing for it),
+//   - a data model, which gives the observations of each function and the
+//     basis they are represented in (RaggedData, RaggedDataF, FieldData,
+//     MVData),
+//   - a coefficient policy, which gives the mean and eigenfunction
+//     coefficients of each function (SharedCoefs, CachedCovariateCoefs,
+//     SyncedCovariateCoefs, CovariateCoefs),
+// and on the number of features (K_) and eigenfunctions (M_), where 0 means
+// that the size is only known at run time. dispatchDims instantiates the
+// common small sizes so the loops over K and M can be unrolled.
+//
+// The Metropolis-Hastings update of Z (ZKernel), the updates of chi, nu and
+// Phi, the residual sum of squares used by sigma and the log-likelihood are
+// written once against these policies; new variants of those updates should
+// be added as policies rather than as new functions. The updates of nu and
+// Phi are also templated on the source of randomness, so their ICM versions
+// are the same kernels run with ConditionalMode.
+
+// Tempering policy of the cold chain
+//
+// @name Untempered
+struct Untempered{
+  double scale(const double x) const{
+    return x;
+  }
+};
+
+// Tempering policy of a tempered transition
+//
+// @name Tempered
+// @field beta_i Double containing the current temperature
+struct Tempered{
+  double beta_i;
+  double scale(const double x) const{
+    return beta_i * x;
+  }
+};
+
+// Data model of functional data stored contiguously
+//
+// @name RaggedData
+// @field obs RaggedObs containing observed values and basis functions
+struct RaggedData{
+  const RaggedObs& obs;
+
+  // Total number of observations
+  double n_total() const{
+    return obs.n_total();
+  }
+
+  // Number of basis functions
+  arma::uword n_basis() const{
+    return obs.B_t.n_rows;
+  }
+
+  // Cost of each function (number of observed time points plus one basis evaluation)
+  arma::vec weights() const{
+    arma::vec weight(obs.n_funct());
+    for(arma::uword i = 0; i < obs.n_funct(); i++){
+      weight(i) = obs.n_obs(i) + obs.B_t.n_rows;
+    }
+    return weight;
+  }
+
+  // Residual sum of squares of the ith function
+  double rss(const int i,
+             const arma::vec& coef) const{
+    return calcRSS(obs, i, coef);
+  }
+
+  // Inner products <B_i dir, y_i - B_i coef> (w) and <B_i dir, B_i dir> (W)
+  void crossResid(const int i,
+                  const arma::vec& dir,
+                  const arma::vec& coef,
+                  double& w,
+                  double& W) const{
+    const double* d = dir.memptr();
+    const double* c = coef.memptr();
+    const double* b;
+    double ph = 0;
+    double r = 0;
+    w = 0;
+    W = 0;
+    for(arma::uword t = obs.offsets(i); t < obs.offsets(i + 1); t++){
+      b = obs.B_t.colptr(t);
+      ph = 0;
+      r = obs.y.at(t);
+      for(arma::uword p = 0; p < obs.B_t.n_rows; p++){
+        ph = ph + (b[p] * d[p]);
+        r = r - (b[p] * c[p]);
+      }
+      w = w + (ph * r);
+      W = W + (ph * ph);
+    }
+  }
+
+  // Adds a * B_i B_i' to the upper triangle of G and c * B_i (y_i - B_i' coef)
+  // to g
+  void addGram(const int i,
+               const arma::vec& coef,
+               const double a,
+               const double c,
+               arma::mat& G,
+               arma::vec& g) const{
+    const double* cf = coef.memptr();
+    const double* b;
+    double r = 0;
+    double b_q = 0;
+    for(arma::uword t = obs.offsets(i); t < obs.offsets(i + 1); t++){
+      b = obs.B_t.colptr(t);
+      r = obs.y.at(t);
+      for(arma::uword p = 0; p < obs.B_t.n_rows; p++){
+        r = r - (b[p] * cf[p]);
+      }
+      r = c * r;
+      for(arma::uword q = 0; q < obs.B_t.n_rows; q++){
+        b_q = a * b[q];
+        for(arma::uword p = 0; p <= q; p++){
+          G.at(p,q) = G.at(p,q) + (b_q * b[p]);
+        }
+        g.at(q) = g.at(q) + (r * b[q]);
+      }
+    }
+  }
+};
+
+// Data model of functional data stored contiguously in single precision.
+// Products with the basis are computed in single precision and the sums over
+// observations are accumulated in double precision.
+//
+// @name RaggedDataF
+// @field obs RaggedObsF containing observed values and basis functions
+struct RaggedDataF{
+  const RaggedObsF& obs;
+
+  // Total number of observations
+  double n_total() const{
+    return obs.n_total();
+  }
+
+  // Number of basis functions
+  arma::uword n_basis() const{
+    return obs.B_t.n_rows;
+  }
+
+  // Cost of each function (number of observed time points plus one basis evaluation)
+  arma::vec weights() const{
+    arma::vec weight(obs.n_funct());
+    for(arma::uword i = 0; i < obs.n_funct(); i++){
+      weight(i) = obs.n_obs(i) + obs.B_t.n_rows;
+    }
+    return weight;
+  }
+
+  // Residual sum of squares of the ith function
+  double rss(const int i,
+             const arma::vec& coef) const{
+    return calcRSS(obs, i, coef);
+  }
+
+  // Inner products <B_i dir, y_i - B_i coef> (w) and <B_i dir, B_i dir> (W)
+  void crossResid(const int i,
+                  const arma::vec& dir,
+                  const arma::vec& coef,
+                  double& w,
+                  double& W) const{
+    const double* d = dir.memptr();
+    const double* c = coef.memptr();
+    const float* b;
+    float ph = 0;
+    float fitted = 0;
+    double r = 0;
+    w = 0;
+    W = 0;
+    for(arma::uword t = obs.offsets(i); t < obs.offsets(i + 1); t++){
+      b = obs.B_t.colptr(t);
+      ph = 0;
+      fitted = 0;
+      for(arma::uword p = 0; p < obs.B_t.n_rows; p++){
+        ph = ph + (b[p] * static_cast<float>(d[p]));
+        fitted = fitted + (b[p] * static_cast<float>(c[p]));
+      }
+      r = static_cast<double>(obs.y.at(t)) - fitted;
+      w = w + (ph * r);
+      W = W + (static_cast<double>(ph) * ph);
+    }
+  }
+
+  // Adds a * B_i B_i' to the upper triangle of G and c * B_i (y_i - B_i' coef)
+  // to g
+  void addGram(const int i,
+               const arma::vec& coef,
+               const double a,
+               const double c,
+               arma::mat& G,
+               arma::vec& g) const{
+    const double* cf = coef.memptr();
+    const float* b;
+    float fitted = 0;
+    double r = 0;
+    double b_q = 0;
+    for(arma::uword t = obs.offsets(i); t < obs.offsets(i + 1); t++){
+      b = obs.B_t.colptr(t);
+      fitted = 0;
+      for(arma::uword p = 0; p < obs.B_t.n_rows; p++){
+        fitted = fitted + (b[p] * static_cast<float>(cf[p]));
+      }
+      r = c * (static_cast<double>(obs.y.at(t)) - fitted);
+      for(arma::uword q = 0; q < obs.B_t.n_rows; q++){
+        b_q = a * b[q];
+        for(arma::uword p = 0; p <= q; p++){
+          G.at(p,q) = G.at(p,q) + (b_q * b[p]);
+        }
+        g.at(q) = g.at(q) + (r * b[q]);
+      }
+    }
+  }
+};
+
+// Data model of functional data stored in fields
+//
+// @name FieldData
+// @field y_obs Field of vectors containing observed values
+// @field B_obs Field of matrices containing basis functions evaluated at observed time points
+struct FieldData{
+  const arma::field<arma::vec>& y_obs;
+  const arma::field<arma::mat>& B_obs;
+
+  // Total number of observations
+  double n_total() const{
+    double n = 0;
+    for(arma::uword i = 0; i < y_obs.n_rows; i++){
+      n = n + y_obs(i,0).n_elem;
+    }
+    return n;
+  }
+
+  // Number of basis functions
+  arma::uword n_basis() const{
+    return B_obs(0,0).n_cols;
+  }
+
+  // Cost of each function (number of observed time points plus one basis evaluation)
+  arma::vec weights() const{
+    arma::vec weight(y_obs.n_rows);
+    for(arma::uword i = 0; i < y_obs.n_rows; i++){
+      weight(i) = y_obs(i,0).n_elem + B_obs(i,0).n_cols;
+    }
+    return weight;
+  }
+
+  // Residual sum of squares of the ith function
+  double rss(const int i,
+             const arma::vec& coef) const{
+    const arma::mat& B = B_obs(i,0);
+    double r = 0;
+    double rss = 0;
+    for(arma::uword t = 0; t < B.n_rows; t++){
+      r = y_obs(i,0).at(t);
+      for(arma::uword p = 0; p < B.n_cols; p++){
+        r = r - B.at(t,p) * coef.at(p);
+      }
+      rss = rss + (r * r);
+    }
+    return rss;
+  }
+
+  // Inner products <B_i dir, y_i - B_i coef> (w) and <B_i dir, B_i dir> (W)
+  void crossResid(const int i,
+                  const arma::vec& dir,
+                  const arma::vec& coef,
+                  double& w,
+                  double& W) const{
+    const arma::mat& B = B_obs(i,0);
+    double ph = 0;
+    double r = 0;
+    w = 0;
+    W = 0;
+    for(arma::uword t = 0; t < B.n_rows; t++){
+      ph = 0;
+      r = y_obs(i,0).at(t);
+      for(arma::uword p = 0; p < B.n_cols; p++){
+        ph = ph + B.at(t,p) * dir.at(p);
+        r = r - B.at(t,p) * coef.at(p);
+      }
+      w = w + (ph * r);
+      W = W + (ph * ph);
+    }
+  }
+
+  // Adds a * B_i' B_i to the upper triangle of G and c * B_i' (y_i - B_i coef)
+  // to g (B_i has one row per observed time point)
+  void addGram(const int i,
+               const arma::vec& coef,
+               const double a,
+               const double c,
+               arma::mat& G,
+               arma::vec& g) const{
+    const arma::mat& B = B_obs(i,0);
+    double r = 0;
+    double b_q = 0;
+    for(arma::uword t = 0; t < B.n_rows; t++){
+      r = y_obs(i,0).at(t);
+      for(arma::uword p = 0; p < B.n_cols; p++){
+        r = r - B.at(t,p) * coef.at(p);
+      }
+      r = c * r;
+      for(arma::uword q = 0; q < B.n_cols; q++){
+        b_q = a * B.at(t,q);
+        for(arma::uword p = 0; p <= q; p++){
+          G.at(p,q) = G.at(p,q) + (b_q * B.at(t,p));
+        }
+        g.at(q) = g.at(q) + (r * B.at(t,q));
+      }
+    }
+  }
+};
+
+// Data model of multivariate data (the basis is the identity)
+//
+// @name MVData
+// @field y_obs Matrix containing the observed vectors
+struct MVData{
+  const arma::mat& y_obs;
+
+  // Total number of observations
+  double n_total() const{
+    return y_obs.n_elem;
+  }
+
+  // Number of dimensions of the observed vectors
+  arma::uword n_basis() const{
+    return y_obs.n_cols;
+  }
+
+  // Cost of each observed vector
+  arma::vec weights() const{
+    return y_obs.n_cols * arma::ones(y_obs.n_rows);
+  }
+
+  // Residual sum of squares of the ith vector
+  double rss(const int i,
+             const arma::vec& coef) const{
+    double r = 0;
+    double total = 0;
+    for(arma::uword j = 0; j < y_obs.n_cols; j++){
+      r = y_obs.at(i,j) - coef.at(j);
+      total = total + (r * r);
+    }
+    return total;
+  }
+
+  // Inner products <dir, y_i - coef> (w) and <dir, dir> (W)
+  void crossResid(const int i,
+                  const arma::vec& dir,
+                  const arma::vec& coef,
+                  double& w,
+                  double& W) const{
+    w = 0;
+    W = 0;
+    for(arma::uword j = 0; j < y_obs.n_cols; j++){
+      w = w + dir.at(j) * (y_obs.at(i,j) - coef.at(j));
+      W = W + dir.at(j) * dir.at(j);
+    }
+  }
+
+  // Adds a * I to G and c * (y_i - coef) to g
+  void addGram(const int i,
+               const arma::vec& coef,
+               const double a,
+               const double c,
+               arma::mat& G,
+               arma::vec& g) const{
+    for(arma::uword j = 0; j < y_obs.n_cols; j++){
+      G.at(j,j) = G.at(j,j) + a;
+      g.at(j) = g.at(j) + c * (y_obs.at(i,j) - coef.at(j));
+    }
+  }
+};
+
+// Calculates the coefficients of the conditional mean of the ith function
+// (sum_k Z_ik * (nu_k + sum_m chi_im * Phi_km)) with the sizes known at
+// compile time when K_ and M_ are positive
+//
+// @name calcMeanCoefFixed
+// @param nu Matrix containing nu parameters
+// @param Phi Cube containing Phi parameters
+// @param Z Matrix containing Z parameters
+// @param chi Matrix containing chi parameters
+// @param i Int containing the function of interest
+// @param coef Vector acting as a placeholder for the coefficients
+template<int K_, int M_>
+inline void calcMeanCoefFixed(const arma::mat& nu,
+                              const arma::cube& Phi,
+                              const arma::mat& Z,
+                              const arma::mat& chi,
+                              const int i,
+                              arma::vec& coef){
+  const int K = (K_ > 0) ? K_ : nu.n_rows;
+  const int M = (M_ > 0) ? M_ : Phi.n_slices;
+  coef.set_size(nu.n_cols);
+  double c = 0;
+  double s = 0;
+  for(arma::uword p = 0; p < nu.n_cols; p++){
+    c = 0;
+    for(int k = 0; k < K; k++){
+      s = nu.at(k,p);
+      for(int m = 0; m < M; m++){
+        s = s + chi.at(i,m) * Phi.at(k,p,m);
+      }
+      c = c + Z.at(i,k) * s;
+    }
+    coef.at(p) = c;
+  }
+}
+
+// Calculates the coefficients of the mth eigenfunction of the ith function
+// (sum_k Z_ik * Phi_km) with the number of features known at compile time
+// when K_ is positive
+//
+// @name calcPhiCoefFixed
+// @param Phi Cube containing Phi parameters
+// @param Z Matrix containing Z parameters
+// @param i Int containing the function of interest
+// @param m Int containing the eigenfunction of interest
+// @param coef Vector acting as a placeholder for the coefficients
+template<int K_>
+inline void calcPhiCoefFixed(const arma::cube& Phi,
+                             const arma::mat& Z,
+                             const int i,
+                             const int m,
+                             arma::vec& coef){
+  const int K = (K_ > 0) ? K_ : Phi.n_rows;
+  coef.set_size(Phi.n_cols);
+  double c = 0;
+  for(arma::uword p = 0; p < Phi.n_cols; p++){
+    c = 0;
+    for(int k = 0; k < K; k++){
+      c = c + Z.at(i,k) * Phi.at(k,p,m);
+    }
+    coef.at(p) = c;
+  }
+}
+
+// Coefficients shared by every function (model without covariates)
+//
+// @name SharedCoefs
+// @field nu Matrix containing nu parameters
+// @field Phi Cube containing Phi parameters
+struct SharedCoefs{
+  const arma::mat& nu;
+  const arma::cube& Phi;
+
+  template<int K_, int M_>
+  void meanCoef(const int i,
+                const arma::mat& Z,
+                const arma::mat& chi,
+                arma::vec& coef) const{
+    calcMeanCoefFixed<K_, M_>(nu, Phi, Z, chi, i, coef);
+  }
+
+  template<int K_>
+  void phiCoef(const int i,
+               const int m,
+               const arma::mat& Z,
+               arma::vec& coef) const{
+    calcPhiCoefFixed<K_>(Phi, Z, i, m, coef);
+  }
+
+  // Called after nu_j (or Phi_jm) has moved by delta; nu and Phi are read
+  // directly, so there is nothing to update
+  void moveNu(const int j,
+              const arma::vec& delta) const{}
+
+  void movePhi(const int j,
+               const int m,
+               const arma::vec& delta) const{}
+};
+
+// Covariate adjusted coefficients cached for every function
+//
+// @name CachedCovariateCoefs
+// @field cov CovariateEffects containing the covariate adjusted coefficients
+struct CachedCovariateCoefs{
+  const CovariateEffects& cov;
+
+  template<int K_, int M_>
+  void meanCoef(const int i,
+                const arma::mat& Z,
+                const arma::mat& chi,
+                arma::vec& coef) const{
+    calcMeanCoefFixed<K_, M_>(cov.nu.slice(i), cov.Phi(i,0), Z, chi, i, coef);
+  }
+
+  template<int K_>
+  void phiCoef(const int i,
+               const int m,
+               const arma::mat& Z,
+               arma::vec& coef) const{
+    calcPhiCoefFixed<K_>(cov.Phi(i,0), Z, i, m, coef);
+  }
+};
+
+// Covariate adjusted coefficients cached for every function, kept up to date
+// by the updates of nu and Phi (nu_j and Phi_jm are shared by every function,
+// so a move of delta is added to the cached coefficients of each function)
+//
+// @name SyncedCovariateCoefs
+// @field cov CovariateEffects containing the covariate adjusted coefficients
+struct SyncedCovariateCoefs{
+  CovariateEffects& cov;
+
+  template<int K_, int M_>
+  void meanCoef(const int i,
+                const arma::mat& Z,
+                const arma::mat& chi,
+                arma::vec& coef) const{
+    calcMeanCoefFixed<K_, M_>(cov.nu.slice(i), cov.Phi(i,0), Z, chi, i, coef);
+  }
+
+  template<int K_>
+  void phiCoef(const int i,
+               const int m,
+               const arma::mat& Z,
+               arma::vec& coef) const{
+    calcPhiCoefFixed<K_>(cov.Phi(i,0), Z, i, m, coef);
+  }
+
+  void moveNu(const int j,
+              const arma::vec& delta) const{
+    for(arma::uword i = 0; i < cov.nu.n_slices; i++){
+      for(arma::uword p = 0; p < delta.n_elem; p++){
+        cov.nu.at(j,p,i) = cov.nu.at(j,p,i) + delta.at(p);
+      }
+    }
+  }
+
+  void movePhi(const int j,
+               const int m,
+               const arma::vec& delta) const{
+    for(arma::uword i = 0; i < cov.Phi.n_rows; i++){
+      arma::cube& Phi_i = cov.Phi(i,0);
+      for(arma::uword p = 0; p < delta.n_elem; p++){
+        Phi_i.at(j,p,m) = Phi_i.at(j,p,m) + delta.at(p);
+      }
+    }
+  }
+};
+
+// Covariate adjusted coefficients computed from the covariates of each
+// function when they are needed
+//
+// @name CovariateCoefs
+// @field nu Matrix containing nu parameters
+// @field eta Cube containing eta parameters
+// @field Phi Cube containing Phi parameters
+// @field xi Field of cubes containing xi parameters
+// @field iter Int containing the row of xi to use
+// @field X Matrix containing covariates
+struct CovariateCoefs{
+  const arma::mat& nu;
+  const arma::cube& eta;
+  const arma::cube& Phi;
+  const arma::field<arma::cube>& xi;
+  const int iter;
+  const arma::mat& X;
+
+  template<int K_, int M_>
+  void meanCoef(const int i,
+                const arma::mat& Z,
+                const arma::mat& chi,
+                arma::vec& coef) const{
+    const int K = (K_ > 0) ? K_ : nu.n_rows;
+    const int M = (M_ > 0) ? M_ : Phi.n_slices;
+    coef.zeros(nu.n_cols);
+    double s = 0;
+    double phi = 0;
+    for(int k = 0; k < K; k++){
+      if(Z.at(i,k) != 0){
+        const arma::cube& xi_k = xi(iter,k);
+        for(arma::uword p = 0; p < nu.n_cols; p++){
+          s = nu.at(k,p);
+          for(arma::uword d = 0; d < X.n_cols; d++){
+            s = s + eta.at(p,d,k) * X.at(i,d);
+          }
+          for(int m = 0; m < M; m++){
+            phi = Phi.at(k,p,m);
+            for(arma::uword d = 0; d < X.n_cols; d++){
+              phi = phi + xi_k.at(p,d,m) * X.at(i,d);
+            }
+            s = s + chi.at(i,m) * phi;
+          }
+          coef.at(p) = coef.at(p) + Z.at(i,k) * s;
+        }
+      }
+    }
+  }
+
+  template<int K_>
+  void phiCoef(const int i,
+               const int m,
+               const arma::mat& Z,
+               arma::vec& coef) const{
+    const int K = (K_ > 0) ? K_ : nu.n_rows;
+    coef.zeros(nu.n_cols);
+    double phi = 0;
+    for(int k = 0; k < K; k++){
+      const arma::cube& xi_k = xi(iter,k);
+      for(arma::uword p = 0; p < nu.n_cols; p++){
+        phi = Phi.at(k,p,m);
+        for(arma::uword d = 0; d < X.n_cols; d++){
+          phi = phi + xi_k.at(p,d,m) * X.at(i,d);
+        }
+        coef.at(p) = coef.at(p) + Z.at(i,k) * phi;
+      }
+    }
+  }
+
+  // Called after nu_j (or Phi_jm) has moved by delta; nu and Phi are read
+  // directly, so there is nothing to update
+  void moveNu(const int j,
+              const arma::vec& delta) const{}
+
+  void movePhi(const int j,
+               const int m,
+               const arma::vec& delta) const{}
+};
+
+// Runs kernel.run<K_, M_>() with the number of features and eigenfunctions
+// known at compile time for the common small sizes (K = 2, 3, 4 and
+// M = 1, 2, 3), and with the sizes known at run time otherwise
+//
+// @name dispatchDims
+// @param K Int containing the number of features
+// @param M Int containing the number of eigenfunctions
+// @param kernel Object with a member template run<K_, M_>()
+template<class Kernel>
+inline void dispatchDims(const int K,
+                         const int M,
+                         const Kernel& kernel){
+  if((K == 2) && (M == 1)){
+    kernel.template run<2, 1>();
+  }else if((K == 2) && (M == 2)){
+    kernel.template run<2, 2>();
+  }else if((K == 2) && (M == 3)){
+    kernel.template run<2, 3>();
+  }else if((K == 3) && (M == 1)){
+    kernel.template run<3, 1>();
+  }else if((K == 3) && (M == 2)){
+    kernel.template run<3, 2>();
+  }else if((K == 3) && (M == 3)){
+    kernel.template run<3, 3>();
+  }else if((K == 4) && (M == 1)){
+    kernel.template run<4, 1>();
+  }else if((K == 4) && (M == 2)){
+    kernel.template run<4, 2>();
+  }else if((K == 4) && (M == 3)){
+    kernel.template run<4, 3>();
+  }else{
+    kernel.template run<0, 0>();
+  }
+}
+
+// Residual sum of squares of every function for one data model and
+// coefficient policy, computed in parallel on the subject scheduler
+//
+// @name RSSKernel
+template<class Data, class Coefs>
+struct RSSKernel{
+  const Data& data;
+  const Coefs& coefs;
+  const arma::mat& Z;
+  const arma::mat& chi;
+  const std::string& name;
+  SubjectScheduler& sched;
+  arma::vec& rss;
+
+  template<int K_, int M_>
+  void run() const{
+    parallelForSubjects(sched, name, [&](const int i){
+      Workspace& ws = subjectWorkspace(sched);
+      arma::vec& coef = fitScratch(ws.coef, data.n_basis(), ws.n_alloc);
+      coefs.template meanCoef<K_, M_>(i, Z, chi, coef);
+      rss(i) = data.rss(i, coef);
+    });
+  }
+};
+
+// Calculates the residual sum of squares of every function
+//
+// @name calcRSSKernel
+// @param data Data model containing the observations
+// @param coefs Coefficient policy containing the mean and eigenfunction coefficients
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param name String containing the name under which the utilization is recorded
+// @param sched SubjectScheduler used to distribute the functions over threads
+// @returns rss Vector containing the residual sum of squares of each function
+template<class Data, class Coefs>
+inline arma::vec calcRSSKernel(const Data& data,
+                               const Coefs& coefs,
+                               const arma::mat& Z,
+                               const arma::mat& chi,
+                               const std::string& name,
+                               SubjectScheduler& sched){
+  arma::vec rss = arma::zeros(Z.n_rows);
+  RSSKernel<Data, Coefs> kernel = {data, coefs, Z, chi, name, sched, rss};
+  dispatchDims(Z.n_cols, chi.n_cols, kernel);
+  return rss;
+}
+}
+
+#endif
@@ -0,0 +1,282 @@
+#ifndef BayesFMMM_MEMBERSHIP_SCORING_H
+#define BayesFMMM_MEMBERSHIP_SCORING_H
+
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "Distributions.h"
+#include "RaggedObs.h"
+#include "UpdateMixedMembership.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace BayesFMMM{
+// Stacks the mean and eigenfunction coefficients of the posterior draws into a
+// single matrix. With L = K(M + 1), columns sL, ..., sL + L - 1 contain the
+// rows of nu and of Phi_1, ..., Phi_M for the sth draw kept, so the mean
+// coefficients of a function are C_s * [z; chi_1 z; ...; chi_M z].
+//
+// @name stackScoringCoef
+// @param nu Cube containing MCMC samples for nu
+// @param Phi Field of cubes containing MCMC samples for Phi
+// @param burnin Int containing the number of MCMC samples to discard
+// @returns C Matrix (P x L * number of draws kept) containing the stacked coefficients
+inline arma::mat stackScoringCoef(const arma::cube& nu,
+                                  const arma::field<arma::cube>& Phi,
+                                  const int burnin){
+  int K = nu.n_rows;
+  int M = Phi(0,0).n_slices;
+  int L = K * (M + 1);
+  int n_samp = nu.n_slices - burnin;
+  arma::mat C = arma::zeros(nu.n_cols, L * n_samp);
+  for(int s = 0; s < n_samp; s++){
+    C.cols(s * L, (s * L) + K - 1) = nu.slice(burnin + s).t();
+    for(int m = 0; m < M; m++){
+      C.cols((s * L) + (K * (m + 1)), (s * L) + (K * (m + 2)) - 1) =
+        Phi(burnin + s,0).slice(m).t();
+    }
+  }
+  return C;
+}
+
+// Gets log-pdf of z_i given chi_i and one posterior draw of the population
+// level parameters, where the residual sum of squares is evaluated from the
+// Gram matrix of the stacked coefficients
+//
+// @name lpdf_zScoring
+// @param Z Vector containing the memberships of the function
+// @param chi Vector containing the scores of the function
+// @param yty Double containing the sum of squares of the observed values
+// @param Cty Vector (L) containing the stacked coefficients times B_i y_i
+// @param Q Matrix (L x L) containing C_s' B_i B_i' C_s
+// @param pi Vector containing the elements of pi
+// @param alpha_3 Double containing the value of alpha_3
+// @param sigma_sq Double containing the value of sigma_sq
+// @returns lpdf Double containing the log-pdf
+inline double lpdf_zScoring(const arma::vec& Z,
+                            const arma::vec& chi,
+                            const double yty,
+                            const arma::vec& Cty,
+                            const arma::mat& Q,
+                            const arma::vec& pi,
+                            const double alpha_3,
+                            const double sigma_sq){
+  int K = Z.n_elem;
+  arma::vec v = arma::zeros(Q.n_rows);
+  v.subvec(0, K - 1) = Z;
+  for(int m = 0; m < chi.n_elem; m++){
+    v.subvec(K * (m + 1), (K * (m + 2)) - 1) = chi(m) * Z;
+  }
+  double rss = yty - (2 * arma::dot(v, Cty)) + arma::as_scalar(v.t() * Q * v);
+
+  double lpdf = 0;
+  for(int l = 0; l < K; l++){
+    lpdf = lpdf + ((alpha_3 * pi(l) - 1) * std::log(Z(l)));
+  }
+  return lpdf - (rss / (2 * sigma_sq));
+}
+
+// Samples the memberships and scores of one new function for every posterior
+// draw kept. A single chain is run across the draws: for each draw, n_iter
+// sweeps of a Metropolis-Hastings step for z_i (same Dirichlet proposal as
+// updateZ_PM) followed by a joint Gibbs step for chi_i are performed, and the
+// final state is recorded. Only std random number engines are used, so this
+// function can be called from multiple threads.
+//
+// @name scoreFunction
+// @param yty Double containing the sum of squares of the observed values
+// @param Bty Vector (P) containing B_i y_i
+// @param BtB Matrix (P x P) containing B_i B_i'
+// @param C Matrix containing the stacked coefficients (from stackScoringCoef)
+// @param pi Matrix (K x number of draws kept) containing the draws of pi
+// @param alpha_3 Vector containing the draws of alpha_3
+// @param sigma Vector containing the draws of sigma_sq
+// @param n_iter Int containing the number of sweeps per posterior draw
+// @param n_warmup Int containing the number of sweeps before the first draw is recorded
+// @param a_Z_PM Double containing hyperparameter for sampling Z
+// @param rng Random number engine owned by the calling thread
+// @param Z_samp Matrix (K x number of draws kept) acting as a placeholder for the draws of z_i
+// @param chi_samp Matrix (M x number of draws kept) acting as a placeholder for the draws of chi_i
+// @returns n_accept Int containing the number of accepted proposals of z_i
+inline int scoreFunction(const double yty,
+                         const arma::vec& Bty,
+                         const arma::mat& BtB,
+                         const arma::mat& C,
+                         const arma::mat& pi,
+                         const arma::vec& alpha_3,
+                         const arma::vec& sigma,
+                         const int n_iter,
+                         const int n_warmup,
+                         const double a_Z_PM,
+                         std::mt19937_64& rng,
+                         arma::mat& Z_samp,
+                         arma::mat& chi_samp){
+  int K = Z_samp.n_rows;
+  int M = chi_samp.n_rows;
+  int L = K * (M + 1);
+  int n_samp = Z_samp.n_cols;
+  std::uniform_real_distribution<double> runif(0.0, 1.0);
+  std::normal_distribution<double> rnorm(0.0, 1.0);
+
+  // sufficient statistics of the function for all draws at once
+  arma::vec Cty_all = C.t() * Bty;
+  arma::mat BC = BtB * C;
+
+  arma::vec Z = arma::ones(K) / K;
+  arma::vec chi = arma::zeros(M);
+  arma::vec Z_new;
+  arma::mat Q;
+  arma::vec Cty;
+  arma::mat Zb = arma::zeros(L, M + 1);
+  arma::mat A;
+  arma::vec b;
+  arma::vec w;
+  arma::mat R;
+  arma::vec e = arma::zeros(M);
+  double z_lpdf = 0;
+  double z_new_lpdf = 0;
+  double acceptance_prob = 0;
+  int n_accept = 0;
+  bool valid = true;
+
+  for(int s = 0; s < n_samp; s++){
+    Q = C.cols(s * L, (s * L) + L - 1).t() * BC.cols(s * L, (s * L) + L - 1);
+    Cty = Cty_all.subvec(s * L, (s * L) + L - 1);
+    int n_sweeps = (s == 0) ? n_iter + n_warmup : n_iter;
+    for(int j = 0; j < n_sweeps; j++){
+      // Update z_i
+      Z_new = rdirichlet(a_Z_PM * Z, rng);
+      valid = true;
+      for(int l = 0; l < K; l++){
+        if(Z_new(l) <= 0){
+          valid = false;
+        }
+      }
+      if(valid){
+        z_lpdf = lpdf_zScoring(Z, chi, yty, Cty, Q, pi.col(s), alpha_3(s),
+                               sigma(s));
+        z_new_lpdf = lpdf_zScoring(Z_new, chi, yty, Cty, Q, pi.col(s),
+                                   alpha_3(s), sigma(s));
+        acceptance_prob = z_new_lpdf - z_lpdf +
+          Z_proposal_density(Z, a_Z_PM * Z_new) -
+          Z_proposal_density(Z_new, a_Z_PM * Z);
+        if(std::log(runif(rng)) < acceptance_prob){
+          Z = Z_new;
+          n_accept++;
+        }
+      }
+
+      // Update chi_i given z_i (the M scores are drawn jointly)
+      for(int n = 0; n <= M; n++){
+        Zb.submat(K * n, n, (K * (n + 1)) - 1, n) = Z;
+      }
+      A = Zb.t() * Q * Zb;
+      b = Zb.t() * Cty;
+      R = arma::chol(arma::eye(M, M) + (A.submat(1, 1, M, M) / sigma(s)));
+      w = (b.subvec(1, M) - A.submat(1, 0, M, 0)) / sigma(s);
+      for(int m = 0; m < M; m++){
+        e(m) = rnorm(rng);
+      }
+      chi = arma::solve(arma::trimatu(R),
+                        arma::solve(arma::trimatl(R.t()), w) + e);
+    }
+    Z_samp.col(s) = Z;
+    chi_samp.col(s) = chi;
+  }
+  return n_accept;
+}
+
+// Samples the memberships and scores of new functions given the posterior
+// samples of a fitted model. The functions are processed in parallel when the
+// package is compiled with OpenMP support; the engines used by each function
+// are seeded from R's random number generator beforehand, so the results only
+// depend on the seed set in R.
+//
+// @name scoreMembership
+// @param obs RaggedObs containing observed values and basis functions of the new functions
+// @param nu Cube containing MCMC samples for nu
+// @param Phi Field of cubes containing MCMC samples for Phi
+// @param pi Matrix (K x number of MCMC samples) containing MCMC samples for pi
+// @param alpha_3 Vector containing MCMC samples for alpha_3
+// @param sigma Vector containing MCMC samples for sigma_sq
+// @param burnin Int containing the number of MCMC samples to discard
+// @param n_iter Int containing the number of sweeps per posterior draw
+// @param n_warmup Int containing the number of sweeps before the first draw is recorded
+// @param a_Z_PM Double containing hyperparameter for sampling Z
+// @param Z_samp Cube (n_funct x K x number of draws kept) acting as a placeholder for the draws of Z
+// @param chi_samp Cube (n_funct x M x number of draws kept) acting as a placeholder for the draws of chi
+// @param acceptance Vector acting as a placeholder for the acceptance rate of each function
+inline void scoreMembership(const RaggedObs& obs,
+                            const arma::cube& nu,
+                            const arma::field<arma::cube>& Phi,
+                            const arma::mat& pi,
+                            const arma::vec& alpha_3,
+                            const arma::vec& sigma,
+                            const int burnin,
+                            const int n_iter,
+                            const int n_warmup,
+                            const double a_Z_PM,
+                            arma::cube& Z_samp,
+                            arma::cube& chi_samp,
+                            arma::vec& acceptance){
+  int n_funct = obs.n_funct();
+  int K = nu.n_rows;
+  int P = nu.n_cols;
+  int M = Phi(0,0).n_slices;
+  int n_samp = nu.n_slices - burnin;
+
+  const arma::mat C = stackScoringCoef(nu, Phi, burnin);
+  const arma::mat pi_post = pi.cols(burnin, pi.n_cols - 1);
+  const arma::vec alpha_3_post = alpha_3.subvec(burnin, alpha_3.n_elem - 1);
+  const arma::vec sigma_post = sigma.subvec(burnin, sigma.n_elem - 1);
+
+  Z_samp = arma::zeros(n_funct, K, n_samp);
+  chi_samp = arma::zeros(n_funct, M, n_samp);
+  acceptance = arma::zeros(n_funct);
+
+  // R's random number generator cannot be used inside the parallel region
+  std::vector<std::uint64_t> seeds(n_funct);
+  for(int i = 0; i < n_funct; i++){
+    seeds[i] = (std::uint64_t) std::floor(R::runif(0, 4294967296.0));
+  }
+
+  #pragma omp parallel
+  {
+    arma::mat Z_i = arma::zeros(K, n_samp);
+    arma::mat chi_i = arma::zeros(M, n_samp);
+    arma::vec Bty;
+    arma::mat BtB;
+    double yty = 0;
+    int n_accept = 0;
+    #pragma omp for schedule(dynamic)
+    for(int i = 0; i < n_funct; i++){
+      std::mt19937_64 rng(seeds[i]);
+      yty = 0;
+      Bty = arma::zeros(P);
+      BtB = arma::zeros(P, P);
+      if(obs.n_obs(i) > 0){
+        yty = arma::dot(obs.y_i(i), obs.y_i(i)) + obs.rss_offset(i);
+        Bty = obs.B_i(i) * obs.y_i(i);
+        BtB = obs.B_i(i) * obs.B_i(i).t();
+      }
+      n_accept = scoreFunction(yty, Bty, BtB, C, pi_post, alpha_3_post,
+                               sigma_post, n_iter, n_warmup, a_Z_PM, rng, Z_i,
+                               chi_i);
+      acceptance(i) = n_accept / (double) ((n_samp * n_iter) + n_warmup);
+      for(int s = 0; s < n_samp; s++){
+        for(int k = 0; k < K; k++){
+          Z_samp(i, k, s) = Z_i(k, s);
+        }
+        for(int m = 0; m < M; m++){
+          chi_samp(i, m, s) = chi_i(m, s);
+        }
+      }
+    }
+  }
+}
+}
+
+#endif
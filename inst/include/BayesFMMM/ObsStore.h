@@ -0,0 +1,274 @@
+#ifndef BayesFMMM_OBS_STORE_H
+#define BayesFMMM_OBS_STORE_H
+
+#include <RcppArmadillo.h>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <splines2Armadillo.h>
+#include "RaggedObs.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace BayesFMMM{
+// Observation stores are binary files holding the observed functions of a
+// cohort that does not fit in RAM. The file starts with the magic bytes
+// "BFMMMOB1" and is followed by one record per function, each containing the
+// number of observed time points n_i (64-bit integer), the n_i time points
+// and the n_i observed values (doubles), so that new functions can be
+// appended to an existing store.
+const char OBS_STORE_MAGIC[8] = {'B', 'F', 'M', 'M', 'M', 'O', 'B', '1'};
+
+// Read-only view of an observation store. The file is memory-mapped where
+// available, so only the pages of the functions that are being read are
+// loaded, and the operating system can release them once they have been
+// processed; otherwise each record is read from the file when it is needed.
+//
+// @name ObsStore
+// @field file String containing the path of the store
+// @field data Pointer to the mapped file (null if the file is not mapped)
+// @field size Int containing the size of the file in bytes
+// @field positions Vector containing the position of the record of each function
+// @field n_obs Vector containing the number of observed time points of each function
+struct ObsStore{
+  std::string file;
+  const char* data;
+  std::size_t size;
+  std::vector<std::size_t> positions;
+  std::vector<arma::uword> n_obs;
+
+  ObsStore() : data(nullptr), size(0){}
+  ObsStore(const ObsStore&) = delete;
+  ObsStore& operator=(const ObsStore&) = delete;
+
+  // Number of functions stored
+  arma::uword n_funct() const{
+    return positions.size();
+  }
+
+  // Unmaps the file
+  void close(){
+#ifndef _WIN32
+    if(data != nullptr){
+      munmap(const_cast<char*>(data), size);
+    }
+#endif
+    data = nullptr;
+    size = 0;
+    positions.clear();
+    n_obs.clear();
+  }
+
+  ~ObsStore(){
+    close();
+  }
+};
+
+// Reads bytes of an observation store (from the mapping if the file is
+// mapped and from the file otherwise). Can be called concurrently.
+//
+// @name readObsBytes
+// @param store ObsStore
+// @param pos Int containing the position of the first byte
+// @param n_bytes Int containing the number of bytes read
+// @param dest Pointer to storage for the bytes
+// @returns success Boolean indicating if the bytes were read
+inline bool readObsBytes(const ObsStore& store,
+                         const std::size_t pos,
+                         const std::size_t n_bytes,
+                         void* dest){
+  if(pos + n_bytes > store.size){
+    return false;
+  }
+  if(n_bytes == 0){
+    return true;
+  }
+  if(store.data != nullptr){
+    std::memcpy(dest, store.data + pos, n_bytes);
+    return true;
+  }
+  std::ifstream in(store.file, std::ios::binary);
+  in.seekg(pos);
+  in.read(static_cast<char*>(dest), n_bytes);
+  return in.good();
+}
+
+// Opens an observation store and indexes the records of the functions
+//
+// @name openObsStore
+// @param file String containing the path of the store
+// @param store ObsStore acting as a placeholder for the opened store
+inline void openObsStore(const std::string& file,
+                         ObsStore& store){
+  store.close();
+  store.file = file;
+  std::ifstream in(file, std::ios::binary | std::ios::ate);
+  if(!in.good()){
+    Rcpp::stop("unable to open '" + file + "'");
+  }
+  store.size = static_cast<std::streamoff>(in.tellg());
+  char magic[8];
+  in.seekg(0);
+  in.read(magic, 8);
+  if(!in.good() || (std::memcmp(magic, OBS_STORE_MAGIC, 8) != 0)){
+    Rcpp::stop("'" + file + "' is not an observation store");
+  }
+  in.close();
+#ifndef _WIN32
+  int fd = open(file.c_str(), O_RDONLY);
+  if(fd >= 0){
+    void* map = mmap(nullptr, store.size, PROT_READ, MAP_SHARED, fd, 0);
+    if(map != MAP_FAILED){
+      store.data = static_cast<const char*>(map);
+    }
+    ::close(fd);
+  }
+#endif
+
+  std::size_t pos = 8;
+  std::uint64_t n_i = 0;
+  while(pos < store.size){
+    if(!readObsBytes(store, pos, sizeof(n_i), &n_i) ||
+       (n_i > (store.size - pos) / (2 * sizeof(double)))){
+      store.close();
+      Rcpp::stop("'" + file + "' is truncated");
+    }
+    store.positions.push_back(pos);
+    store.n_obs.push_back(n_i);
+    pos = pos + sizeof(n_i) + 2 * n_i * sizeof(double);
+  }
+  if(pos != store.size){
+    store.close();
+    Rcpp::stop("'" + file + "' is truncated");
+  }
+}
+
+// Reads the observed time points and values of the ith function of an
+// observation store. Can be called concurrently.
+//
+// @name readObsRecord
+// @param store ObsStore
+// @param i Int containing the function of interest
+// @param t_i Vector acting as a placeholder for the observed time points
+// @param y_i Vector acting as a placeholder for the observed values
+// @returns success Boolean indicating if the record was read
+inline bool readObsRecord(const ObsStore& store,
+                          const arma::uword i,
+                          arma::vec& t_i,
+                          arma::vec& y_i){
+  std::size_t n_i = store.n_obs[i];
+  std::size_t pos = store.positions[i] + sizeof(std::uint64_t);
+  t_i.set_size(n_i);
+  y_i.set_size(n_i);
+  return readObsBytes(store, pos, n_i * sizeof(double), t_i.memptr()) &&
+    readObsBytes(store, pos + n_i * sizeof(double), n_i * sizeof(double),
+                 y_i.memptr());
+}
+
+// Writes observed functions to an observation store
+//
+// @name writeObsStore
+// @param y_obs Field of vectors containing observed values
+// @param t_obs Field of vectors containing time points of observed values
+// @param file String containing the path of the store
+// @param append Boolean indicating whether the functions are appended to an existing store
+// @returns success Boolean indicating if the functions were written
+inline bool writeObsStore(const arma::field<arma::vec>& y_obs,
+                          const arma::field<arma::vec>& t_obs,
+                          const std::string& file,
+                          const bool append){
+  bool exists = std::ifstream(file).good();
+  std::ofstream out;
+  if(append && exists){
+    char magic[8];
+    std::ifstream in(file, std::ios::binary);
+    in.read(magic, 8);
+    if(!in.good() || (std::memcmp(magic, OBS_STORE_MAGIC, 8) != 0)){
+      return false;
+    }
+    out.open(file, std::ios::binary | std::ios::app);
+  }else{
+    out.open(file, std::ios::binary | std::ios::trunc);
+    out.write(OBS_STORE_MAGIC, 8);
+  }
+  for(arma::uword i = 0; i < y_obs.n_elem; i++){
+    std::uint64_t n_i = y_obs(i).n_elem;
+    out.write(reinterpret_cast<const char*>(&n_i), sizeof(n_i));
+    if(n_i > 0){
+      out.write(reinterpret_cast<const char*>(t_obs(i).memptr()),
+                n_i * sizeof(double));
+      out.write(reinterpret_cast<const char*>(y_obs(i).memptr()),
+                n_i * sizeof(double));
+    }
+  }
+  return out.good();
+}
+
+// Streams the functions of an observation store and keeps only their
+// sufficient statistics (see compressFunction). Each function is read,
+// evaluated on the B-spline basis and compressed to at most P
+// pseudo-observations by one thread, so the memory used only depends on the
+// number of functions, the number of basis functions and the largest
+// function, and not on the total number of observations.
+//
+// @name makeRaggedObs
+// @param store ObsStore containing the observations
+// @param internal_knots Vector location of internal knots for B-splines
+// @param basis_degree Int containing the degree of B-splines used
+// @param boundary_knots Vector containing the boundary points of our index domain of interest
+// @returns obs RaggedObs containing the compressed observations
+inline RaggedObs makeRaggedObs(const ObsStore& store,
+                               const arma::vec& internal_knots,
+                               const int basis_degree,
+                               const arma::vec& boundary_knots){
+  arma::uword P = internal_knots.n_elem + basis_degree + 1;
+  int n_funct = store.n_funct();
+  RaggedObs obs;
+  obs.n_raw = arma::zeros<arma::uvec>(n_funct);
+  for(int i = 0; i < n_funct; i++){
+    obs.n_raw(i) = store.n_obs[i];
+  }
+  obs.offsets = compressedOffsets(obs.n_raw, P);
+  obs.y = arma::zeros(obs.offsets(n_funct));
+  obs.B_t = arma::zeros(P, obs.offsets(n_funct));
+  obs.rss0 = arma::zeros(n_funct);
+  std::vector<int> compressed(n_funct, 1);
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < n_funct; i++){
+    arma::vec t_i;
+    arma::vec y_i;
+    if(!readObsRecord(store, i, t_i, y_i)){
+      compressed[i] = 0;
+      continue;
+    }
+    if(y_i.n_elem == 0){
+      continue;
+    }
+    try{
+      splines2::BSpline bspline(t_i, internal_knots, basis_degree,
+                                boundary_knots);
+      arma::mat B_i = bspline.basis(true).t();
+      compressed[i] = compressFunction(B_i, y_i,
+                                       obs.y.memptr() + obs.offsets(i),
+                                       obs.B_t.colptr(obs.offsets(i)),
+                                       obs.rss0(i));
+    }catch(...){
+      compressed[i] = 0;
+    }
+  }
+  for(int i = 0; i < n_funct; i++){
+    if(compressed[i] == 0){
+      Rcpp::stop("unable to read the observations of function " +
+        std::to_string(i + 1) + " from '" + store.file + "'");
+    }
+  }
+  return obs;
+}
+}
+
+#endif
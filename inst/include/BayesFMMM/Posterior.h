@@ -0,0 +1,827 @@
+#ifndef BayesFMMM_POSTERIOR_H
+#define BayesFMMM_POSTERIOR_H
+
+#include <RcppArmadillo.h>
+#include <splines2Armadillo.h>
+#include <cmath>
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+#include "CalculateLikelihood.h"
+#include "InformationCriteria.h"
+#include "MembershipScoring.h"
+#include "RaggedObs.h"
+#include "SampleCodec.h"
+#include "SampleLoader.h"
+
+namespace BayesFMMM{
+// Last saved state of a chain of the functional mixed membership model
+//
+// @name ChainState
+// @field Z Matrix containing the Z parameters
+// @field pi Vector containing the pi parameters
+// @field alpha_3 Double containing the alpha_3 parameter
+// @field delta Matrix containing the delta parameters
+// @field gamma Cube containing the gamma parameters
+// @field Phi Cube containing the Phi parameters
+// @field A Matrix containing the A parameters
+// @field nu Matrix containing the nu parameters
+// @field tau Vector containing the tau parameters
+// @field sigma Double containing the sigma parameter
+// @field chi Matrix containing the chi parameters
+struct ChainState{
+  arma::mat Z;
+  arma::vec pi;
+  double alpha_3;
+  arma::mat delta;
+  arma::cube gamma;
+  arma::cube Phi;
+  arma::mat A;
+  arma::mat nu;
+  arma::vec tau;
+  double sigma;
+  arma::mat chi;
+};
+
+// Reads the last MCMC sample saved by the samplers (the last sample of the
+// last file), so that a chain can be continued from where it stopped
+//
+// @name loadLastState
+// @param dir String containing the directory where the MCMC files are located
+// @param n_files Int containing the number of files per parameter
+// @returns state ChainState containing the last MCMC sample
+inline ChainState loadLastState(const std::string& dir,
+                                const int n_files){
+  std::string last = std::to_string(n_files - 1) + ".txt";
+  ChainState state;
+  arma::cube cube_ph;
+  arma::mat mat_ph;
+  arma::vec vec_ph;
+  arma::field<arma::cube> field_ph;
+
+  loadSamples(cube_ph, dir + "Z" + last);
+  state.Z = cube_ph.slice(cube_ph.n_slices - 1);
+  loadSamples(cube_ph, dir + "Nu" + last);
+  state.nu = cube_ph.slice(cube_ph.n_slices - 1);
+  loadSamples(cube_ph, dir + "Chi" + last);
+  state.chi = cube_ph.slice(cube_ph.n_slices - 1);
+  loadSamples(cube_ph, dir + "Delta" + last);
+  state.delta = cube_ph.slice(cube_ph.n_slices - 1);
+  loadSamples(cube_ph, dir + "A" + last);
+  state.A = cube_ph.slice(cube_ph.n_slices - 1);
+  loadSamples(mat_ph, dir + "Pi" + last);
+  state.pi = mat_ph.col(mat_ph.n_cols - 1);
+  loadSamples(mat_ph, dir + "Tau" + last);
+  state.tau = mat_ph.row(mat_ph.n_rows - 1).t();
+  loadSamples(vec_ph, dir + "alpha_3" + last);
+  state.alpha_3 = vec_ph(vec_ph.n_elem - 1);
+  loadSamples(vec_ph, dir + "Sigma" + last);
+  state.sigma = vec_ph(vec_ph.n_elem - 1);
+  loadSamples(field_ph, dir + "Gamma" + last);
+  state.gamma = field_ph(field_ph.n_rows - 1, 0);
+  loadSamples(field_ph, dir + "Phi" + last);
+  state.Phi = field_ph(field_ph.n_rows - 1, 0);
+  return state;
+}
+
+// Gets the matrix used to rescale the parameters so that at least one
+// observation is completely in each group. The kth row is the membership of
+// the observation with the largest membership in the kth group.
+//
+// @name getTransformMat
+// @param Z Matrix containing the Z parameters of one MCMC iteration
+// @returns transform_mat Matrix used to rescale the parameters
+inline arma::mat getTransformMat(const arma::mat& Z){
+  arma::mat transform_mat = arma::zeros(Z.n_cols, Z.n_cols);
+  for(arma::uword i = 0; i < Z.n_cols; i++){
+    transform_mat.row(i) = Z.row(arma::index_max(Z.col(i)));
+  }
+  return transform_mat;
+}
+
+// Gets the matrix used to rescale the parameters into a placeholder, so that
+// it is only allocated once when called for every MCMC iteration
+//
+// @name getTransformMat
+// @param Z Matrix containing the Z parameters of one MCMC iteration
+// @param transform_mat Matrix acting as a placeholder for the rescaling matrix
+inline void getTransformMat(const arma::mat& Z,
+                            arma::mat& transform_mat){
+  transform_mat.set_size(Z.n_cols, Z.n_cols);
+  for(arma::uword i = 0; i < Z.n_cols; i++){
+    const arma::uword i_max = Z.col(i).index_max();
+    for(arma::uword k = 0; k < Z.n_cols; k++){
+      transform_mat.at(i,k) = Z.at(i_max,k);
+    }
+  }
+}
+
+// Rescales the coefficients of one eigenfunction (or mean) of every cluster
+// and writes the coefficients of the lth rescaled cluster into out
+//
+// @name rescaleCoef
+// @param transform_mat Matrix used to rescale the parameters
+// @param l Int containing the cluster of interest (starting at 0)
+// @param coefs Matrix (K x P) containing the coefficients of each cluster
+// @param out Pointer to the P rescaled coefficients
+inline void rescaleCoef(const arma::mat& transform_mat,
+                        const arma::uword l,
+                        const arma::mat& coefs,
+                        double* out){
+  for(arma::uword p = 0; p < coefs.n_cols; p++){
+    out[p] = 0;
+    for(arma::uword k = 0; k < coefs.n_rows; k++){
+      out[p] = out[p] + (transform_mat.at(l,k) * coefs.at(k,p));
+    }
+  }
+}
+
+// Calculates quantiles of each row of a matrix of MCMC draws (each row is a
+// grid point or cell, each column is an MCMC sample). Only the order
+// statistics needed for the interpolation are selected (std::nth_element on
+// a shrinking range) rather than sorting the whole row, and rows are processed
+// in parallel when OpenMP is available. The values are the same as
+// arma::quantile applied to each row.
+//
+// @name calcRowQuantiles
+// @param X Matrix containing MCMC draws (cells x samples)
+// @param p Vector containing probabilities of the quantiles
+// @returns q Matrix containing the quantiles (cells x probabilities)
+inline arma::mat calcRowQuantiles(const arma::mat& X,
+                                  const arma::vec& p){
+  arma::uword N = X.n_cols;
+  arma::mat q = arma::zeros(X.n_rows, p.n_elem);
+  if(N == 0){
+    return q;
+  }
+
+  // R's type 5 quantile (used by arma::quantile), in increasing order of p
+  arma::uvec p_order = arma::sort_index(p);
+  arma::uvec lo = arma::zeros<arma::uvec>(p.n_elem);
+  arma::vec frac = arma::zeros(p.n_elem);
+  for(arma::uword r = 0; r < p.n_elem; r++){
+    double h = (N * p(r)) + 0.5;
+    if(h <= 1){
+      lo(r) = 0;
+      frac(r) = 0;
+    }else if(h >= N){
+      lo(r) = N - 1;
+      frac(r) = 0;
+    }else{
+      lo(r) = std::floor(h) - 1;
+      frac(r) = h - std::floor(h);
+    }
+  }
+
+  #pragma omp parallel
+  {
+    std::vector<double> x(N);
+    #pragma omp for schedule(static)
+    for(arma::uword i = 0; i < X.n_rows; i++){
+      for(arma::uword n = 0; n < N; n++){
+        x[n] = X(i,n);
+      }
+      // elements before 'first' are already known to be smaller than the
+      // order statistic needed for the next probability
+      std::vector<double>::iterator first = x.begin();
+      for(arma::uword o = 0; o < p.n_elem; o++){
+        arma::uword r = p_order(o);
+        std::vector<double>::iterator nth = x.begin() + lo(r);
+        std::nth_element(first, nth, x.end());
+        double x_lo = *nth;
+        if(frac(r) > 0){
+          double x_hi = *std::min_element(nth + 1, x.end());
+          q(i,r) = x_lo + frac(r) * (x_hi - x_lo);
+        }else{
+          q(i,r) = x_lo;
+        }
+        first = nth;
+      }
+    }
+  }
+  return q;
+}
+
+// Calculates pointwise or simultaneous credible intervals for each row of a
+// matrix of MCMC draws
+//
+// @name calcRowCI
+// @param X Matrix containing MCMC draws (cells x samples)
+// @param alpha Double specifying the percentile of the credible interval
+// @param simultaneous Boolean indicating whether simultaneous credible intervals should be computed
+// @param CI_Lower Vector acting as a placeholder for the lower bound
+// @param CI_50 Vector acting as a placeholder for the median (or mean if simultaneous)
+// @param CI_Upper Vector acting as a placeholder for the upper bound
+inline void calcRowCI(const arma::mat& X,
+                      const double alpha,
+                      const bool simultaneous,
+                      arma::vec& CI_Lower,
+                      arma::vec& CI_50,
+                      arma::vec& CI_Upper){
+  if(simultaneous == false){
+    arma::vec p = {alpha/2, 0.5, 1 - (alpha/2)};
+    arma::mat q = calcRowQuantiles(X, p);
+    CI_Lower = q.col(0);
+    CI_50 = q.col(1);
+    CI_Upper = q.col(2);
+  }else{
+    arma::vec x_mean = arma::mean(X, 1);
+    arma::vec x_sd = arma::stddev(X, 0, 1);
+
+    // max statistic of each sample
+    arma::vec C = arma::zeros(X.n_cols);
+    #pragma omp parallel for schedule(static)
+    for(arma::uword i = 0; i < X.n_cols; i++){
+      double C_i = 0;
+      for(arma::uword j = 0; j < X.n_rows; j++){
+        C_i = std::max(C_i, std::abs((X(j,i) - x_mean(j)) / x_sd(j)));
+      }
+      C(i) = C_i;
+    }
+    arma::vec p = {1 - alpha};
+    arma::vec q = arma::quantile(C, p);
+    CI_Lower = x_mean - q(0) * x_sd;
+    CI_50 = x_mean;
+    CI_Upper = x_mean + q(0) * x_sd;
+  }
+}
+
+// Posterior samples of a functional mixed membership model. The samples are
+// read from the directory the first time they are needed and kept in memory,
+// and the B-spline bases are cached for each set of evaluation points, so that
+// many summaries can be computed without re-reading the files.
+//
+// @name Posterior
+// @param dir String containing the directory where the MCMC files are located
+// @param n_files Int containing the number of files per parameter
+// @param basis_degree Int containing the degree of B-splines used
+// @param boundary_knots Vector containing the boundary points of our index domain of interest
+// @param internal_knots Vector location of internal knots for B-splines
+class Posterior{
+public:
+  Posterior(const std::string& dir,
+            const int n_files,
+            const int basis_degree,
+            const arma::vec& boundary_knots,
+            const arma::vec& internal_knots) : dir(dir), n_files(n_files),
+            basis_degree(basis_degree), boundary_knots(boundary_knots),
+            internal_knots(internal_knots){
+    loaded_nu = false;
+    loaded_Phi = false;
+    loaded_Z = false;
+    loaded_chi = false;
+    loaded_sigma = false;
+    loaded_pi = false;
+    loaded_alpha_3 = false;
+  }
+
+  // Used when no functional summaries are needed (e.g. Z or sigma of any model)
+  Posterior(const std::string& dir,
+            const int n_files) : Posterior(dir, n_files, 0, arma::zeros(2),
+            arma::zeros(0)){}
+
+  // Posterior samples (read from dir on first access)
+  const arma::cube& nu(){
+    if(!loaded_nu){
+      nu_samp = loadCubeSamples(dir, "Nu", n_files);
+      loaded_nu = true;
+    }
+    return nu_samp;
+  }
+
+  const arma::field<arma::cube>& Phi(){
+    if(!loaded_Phi){
+      Phi_samp = loadFieldSamples(dir, "Phi", n_files);
+      loaded_Phi = true;
+    }
+    return Phi_samp;
+  }
+
+  const arma::cube& Z(){
+    if(!loaded_Z){
+      Z_samp = loadCubeSamples(dir, "Z", n_files);
+      loaded_Z = true;
+    }
+    return Z_samp;
+  }
+
+  const arma::cube& chi(){
+    if(!loaded_chi){
+      chi_samp = loadCubeSamples(dir, "Chi", n_files);
+      loaded_chi = true;
+    }
+    return chi_samp;
+  }
+
+  const arma::vec& sigma(){
+    if(!loaded_sigma){
+      sigma_samp = loadVecSamples(dir, "Sigma", n_files);
+      loaded_sigma = true;
+    }
+    return sigma_samp;
+  }
+
+  const arma::mat& pi(){
+    if(!loaded_pi){
+      pi_samp = loadMatSamples(dir, "Pi", n_files);
+      loaded_pi = true;
+    }
+    return pi_samp;
+  }
+
+  const arma::vec& alpha_3(){
+    if(!loaded_alpha_3){
+      alpha_3_samp = loadVecSamples(dir, "alpha_3", n_files);
+      loaded_alpha_3 = true;
+    }
+    return alpha_3_samp;
+  }
+
+  // B-spline basis evaluated at the time points of interest (cached)
+  const arma::mat& basis(const arma::vec& time){
+    for(arma::uword i = 0; i < grid_cache.size(); i++){
+      if((grid_cache[i].n_elem == time.n_elem) &&
+         arma::approx_equal(grid_cache[i], time, "absdiff", 0)){
+        return basis_cache[i];
+      }
+    }
+    splines2::BSpline bspline = splines2::BSpline(time, internal_knots,
+                                                  basis_degree, boundary_knots);
+    arma::mat bspline_mat{bspline.basis(true)};
+    grid_cache.push_back(time);
+    basis_cache.push_back(bspline_mat);
+    return basis_cache.back();
+  }
+
+  // B-spline bases evaluated at the observed time points of each function (cached)
+  const arma::field<arma::mat>& basisObs(const arma::field<arma::vec>& time){
+    bool same = (obs_time.n_elem == time.n_elem);
+    for(arma::uword i = 0; (i < time.n_elem) && same; i++){
+      same = (obs_time(i).n_elem == time(i).n_elem) &&
+        arma::approx_equal(obs_time(i), time(i), "absdiff", 0);
+    }
+    if(!same){
+      obs_time = time;
+      B_obs = arma::field<arma::mat>(time.n_elem, 1);
+      for(arma::uword i = 0; i < time.n_elem; i++){
+        splines2::BSpline bspline = splines2::BSpline(time(i), internal_knots,
+                                                      basis_degree,
+                                                      boundary_knots);
+        arma::mat bspline_mat{bspline.basis(true)};
+        B_obs(i,0) = bspline_mat;
+      }
+    }
+    return B_obs;
+  }
+
+  // Credible interval of the mean function of the kth cluster
+  //
+  // @param time Vector containing time points of interest
+  // @param k Int containing the cluster group (1-based)
+  // @param alpha Double specifying the percentile of the credible interval
+  // @param rescale Boolean indicating whether the parameters should be rescaled
+  // @param simultaneous Boolean indicating whether simultaneous credible intervals should be computed
+  // @param burnin_prop Double containing proportion of MCMC samples to discard
+  Rcpp::List FMeanCI(const arma::vec& time,
+                     const int k,
+                     const double alpha,
+                     bool rescale,
+                     const bool simultaneous,
+                     const double burnin_prop){
+    const arma::cube& nu_all = nu();
+    if(k <= 0){
+      Rcpp::stop("'k' must be positive");
+    }
+    if(k > nu_all.n_rows){
+      Rcpp::stop("'k' must be less than or equal to the number of clusters in the model");
+    }
+    if(rescale == true){
+      if(nu_all.n_rows > 2){
+        rescale = false;
+        Rcpp::Rcout << "Rescale property cannot be used for K > 2";
+      }
+    }
+    if(rescale == true){
+      checkDraws({"Nu", "Z"});
+    }
+    int burnin = std::round(nu_all.n_slices * burnin_prop);
+    int n_samp = nu_all.n_slices - burnin;
+    const arma::mat& B = basis(time);
+
+    // coefficients of all samples stacked column-wise, so the mean functions
+    // are evaluated with one matrix product
+    arma::mat nu_k = arma::zeros(nu_all.n_cols, n_samp);
+    arma::mat transform_mat;
+    for(int i = 0; i < n_samp; i++){
+      if(rescale == true){
+        getTransformMat(Z().slice(i + burnin), transform_mat);
+        rescaleCoef(transform_mat, k - 1, nu_all.slice(i + burnin),
+                    nu_k.colptr(i));
+      }else{
+        nu_k.col(i) = nu_all.slice(i + burnin).row(k-1).t();
+      }
+    }
+    arma::mat f_draws = B * nu_k;
+
+    arma::vec CI_Upper;
+    arma::vec CI_50;
+    arma::vec CI_Lower;
+    calcRowCI(f_draws, alpha, simultaneous, CI_Lower, CI_50, CI_Upper);
+    arma::mat f_samp = f_draws.t();
+
+    return Rcpp::List::create(Rcpp::Named("CI_Upper", CI_Upper),
+                              Rcpp::Named("CI_50", CI_50),
+                              Rcpp::Named("CI_Lower", CI_Lower),
+                              Rcpp::Named("mean_trace", f_samp));
+  }
+
+  // Credible interval of the covariance function between the lth and mth clusters
+  //
+  // @param time1 Vector containing time points of interest for first cluster
+  // @param time2 Vector containing time points of interest for second cluster
+  // @param l Int containing the 1st cluster group (1-based)
+  // @param m Int containing the 2nd cluster group (1-based)
+  // @param alpha Double specifying the percentile of the credible interval
+  // @param rescale Boolean indicating whether the parameters should be rescaled
+  // @param simultaneous Boolean indicating whether simultaneous credible intervals should be computed
+  // @param burnin_prop Double containing proportion of MCMC samples to discard
+  Rcpp::List FCovCI(const arma::vec& time1,
+                    const arma::vec& time2,
+                    const int l,
+                    const int m,
+                    const double alpha,
+                    bool rescale,
+                    const bool simultaneous,
+                    const double burnin_prop){
+    const arma::field<arma::cube>& Phi_all = Phi();
+    if(l <= 0){
+      Rcpp::stop("'l' must be positive");
+    }
+    if(l > Phi_all(0,0).n_rows){
+      Rcpp::stop("'l' must be less than or equal to the number of clusters in the model");
+    }
+    if(m <= 0){
+      Rcpp::stop("'m' must be positive");
+    }
+    if(m > Phi_all(0,0).n_rows){
+      Rcpp::stop("'m' must be less than or equal to the number of clusters in the model");
+    }
+    if(rescale == true){
+      if(Phi_all(0,0).n_rows > 2){
+        rescale = false;
+        Rcpp::Rcout << "Rescale property cannot be used for K > 2";
+      }
+    }
+    if(rescale == true){
+      checkDraws({"Phi", "Z"});
+    }
+    int burnin = std::round(Phi_all.n_elem * burnin_prop);
+    int n_samp = Phi_all.n_elem - burnin;
+    const arma::mat& B1 = basis(time1);
+    const arma::mat& B2 = basis(time2);
+
+    // eigenfunction coefficients of all samples stacked column-wise, so the
+    // eigenfunctions are evaluated with one matrix product per cluster
+    int n_eigen = Phi_all(0,0).n_slices;
+    arma::mat Phi_l = arma::zeros(Phi_all(0,0).n_cols, n_samp * n_eigen);
+    arma::mat Phi_m = arma::zeros(Phi_all(0,0).n_cols, n_samp * n_eigen);
+    arma::mat transform_mat;
+    for(int i = 0; i < n_samp; i++){
+      const arma::cube& Phi_i = Phi_all(i + burnin, 0);
+      if(rescale == true){
+        getTransformMat(Z().slice(i + burnin), transform_mat);
+      }
+      for(int j = 0; j < n_eigen; j++){
+        if(rescale == true){
+          rescaleCoef(transform_mat, l - 1, Phi_i.slice(j),
+                      Phi_l.colptr(i * n_eigen + j));
+          rescaleCoef(transform_mat, m - 1, Phi_i.slice(j),
+                      Phi_m.colptr(i * n_eigen + j));
+        }else{
+          Phi_l.col(i * n_eigen + j) = Phi_i.slice(j).row(l-1).t();
+          Phi_m.col(i * n_eigen + j) = Phi_i.slice(j).row(m-1).t();
+        }
+      }
+    }
+    arma::mat B1_Phi_l = B1 * Phi_l;
+    arma::mat B2_Phi_m = B2 * Phi_m;
+
+    // each covariance surface is a rank n_eigen product
+    arma::cube cov_samp = arma::zeros(time1.n_elem, time2.n_elem, n_samp);
+    for(int i = 0; i < n_samp; i++){
+      cov_samp.slice(i) = B1_Phi_l.cols(i * n_eigen, (i + 1) * n_eigen - 1) *
+        B2_Phi_m.cols(i * n_eigen, (i + 1) * n_eigen - 1).t();
+    }
+
+    // view the draws as a (cells x samples) matrix without copying
+    const arma::mat cov_draws(cov_samp.memptr(), time1.n_elem * time2.n_elem,
+                              n_samp, false, true);
+    arma::vec CI_Upper_vec;
+    arma::vec CI_50_vec;
+    arma::vec CI_Lower_vec;
+    calcRowCI(cov_draws, alpha, simultaneous, CI_Lower_vec, CI_50_vec, CI_Upper_vec);
+    arma::mat CI_Upper = arma::reshape(CI_Upper_vec, time1.n_elem, time2.n_elem);
+    arma::mat CI_50 = arma::reshape(CI_50_vec, time1.n_elem, time2.n_elem);
+    arma::mat CI_Lower = arma::reshape(CI_Lower_vec, time1.n_elem, time2.n_elem);
+
+    return Rcpp::List::create(Rcpp::Named("CI_Upper", CI_Upper),
+                              Rcpp::Named("CI_50", CI_50),
+                              Rcpp::Named("CI_Lower", CI_Lower),
+                              Rcpp::Named("cov_trace", cov_samp));
+  }
+
+  // Credible interval of the membership parameters
+  //
+  // @param alpha Double specifying the percentile of the credible interval
+  // @param rescale Boolean indicating whether the parameters should be rescaled
+  // @param burnin_prop Double containing proportion of MCMC samples to discard
+  Rcpp::List ZCI(const double alpha,
+                 bool rescale,
+                 const double burnin_prop){
+    const arma::cube& Z_all = Z();
+    if(rescale == true){
+      if(Z_all.n_cols > 2){
+        rescale = false;
+        Rcpp::Rcout << "Rescale property cannot be used for K > 2";
+      }
+    }
+    int burnin = std::round(Z_all.n_slices * burnin_prop);
+    int n_samp = Z_all.n_slices - burnin;
+
+    arma::cube Z_post = Z_all.slices(burnin, Z_all.n_slices - 1);
+    if(rescale == true){
+      for(int j = 0; j < n_samp; j++){
+        Z_post.slice(j) = arma::solve(getTransformMat(Z_post.slice(j)).t(),
+                                      Z_post.slice(j).t(),
+                                      arma::solve_opts::no_approx).t();
+      }
+    }
+
+    arma::vec p = {alpha/2, 0.5, 1 - (alpha/2)};
+    const arma::mat Z_draws(Z_post.memptr(), Z_all.n_rows * Z_all.n_cols,
+                            n_samp, false, true);
+    arma::mat q = calcRowQuantiles(Z_draws, p);
+    arma::mat CI_Upper = arma::reshape(q.col(2), Z_all.n_rows, Z_all.n_cols);
+    arma::mat CI_50 = arma::reshape(q.col(1), Z_all.n_rows, Z_all.n_cols);
+    arma::mat CI_Lower = arma::reshape(q.col(0), Z_all.n_rows, Z_all.n_cols);
+
+    return Rcpp::List::create(Rcpp::Named("CI_Upper", CI_Upper),
+                              Rcpp::Named("CI_50", CI_50),
+                              Rcpp::Named("CI_Lower", CI_Lower));
+  }
+
+  // Credible interval of sigma squared
+  //
+  // @param alpha Double specifying the percentile of the credible interval
+  Rcpp::List SigmaCI(const double alpha){
+    arma::vec p = {alpha/2, 0.5, 1 - (alpha/2)};
+    arma::vec q = arma::quantile(sigma(), p);
+    return Rcpp::List::create(Rcpp::Named("CI_Upper", q(2)),
+                              Rcpp::Named("CI_50", q(1)),
+                              Rcpp::Named("CI_Lower", q(0)));
+  }
+
+  // Log-likelihood of the observed functions at each MCMC iteration
+  //
+  // @param time Field of vectors containing time points at which the function was observed
+  // @param Y Field of vectors containing observed values of the function
+  arma::vec LLik(const arma::field<arma::vec>& time,
+                 const arma::field<arma::vec>& Y){
+    checkDraws({"Nu", "Phi", "Z", "Chi", "Sigma"});
+    const arma::field<arma::mat>& B = basisObs(time);
+    arma::vec LLik = arma::zeros(nu().n_slices);
+    for(int i = 0; i < nu().n_slices; i++){
+      LLik(i) = calcLikelihood(Y, B, nu().slice(i), Phi()(i,0), Z().slice(i),
+                               chi().slice(i), sigma()(i));
+    }
+    return LLik;
+  }
+
+  // DIC, WAIC and PSIS-LOO of the model, computed from a single pass over the
+  // pointwise log-likelihood
+  //
+  // @param time Field of vectors containing time points at which the function was observed
+  // @param Y Field of vectors containing observed values of the function
+  // @param burnin_prop Double containing proportion of MCMC samples to discard
+  Rcpp::List IC(const arma::field<arma::vec>& time,
+                const arma::field<arma::vec>& Y,
+                const double burnin_prop){
+    checkDraws({"Nu", "Phi", "Z", "Chi", "Sigma"});
+    const arma::field<arma::mat>& B = basisObs(time);
+    int burnin = std::round(burnin_prop * nu().n_slices);
+    const RaggedObs obs = makeRaggedObs(Y, B);
+    return calcInformationCriteria(obs, nu(), Phi(), Z(), chi(), sigma(), burnin);
+  }
+
+  // Memberships and scores of new functions sampled given the posterior
+  // samples of the model
+  //
+  // @param time Field of vectors containing time points at which the new functions were observed
+  // @param Y Field of vectors containing observed values of the new functions
+  // @param alpha Double specifying the percentile of the credible interval
+  // @param burnin_prop Double containing proportion of MCMC samples to discard
+  // @param n_iter Int containing the number of sweeps per posterior draw
+  // @param n_warmup Int containing the number of sweeps before the first draw is recorded
+  // @param a_Z_PM Double containing hyperparameter for sampling Z
+  // @param return_draws Boolean indicating whether the draws of Z and chi should be returned
+  Rcpp::List ScoreMembership(const arma::field<arma::vec>& time,
+                             const arma::field<arma::vec>& Y,
+                             const double alpha,
+                             const double burnin_prop,
+                             const int n_iter,
+                             const int n_warmup,
+                             const double a_Z_PM,
+                             const bool return_draws){
+    // B-spline bases of new functions are not cached
+    arma::field<arma::mat> B(time.n_elem, 1);
+    for(arma::uword i = 0; i < time.n_elem; i++){
+      splines2::BSpline bspline = splines2::BSpline(time(i), internal_knots,
+                                                    basis_degree,
+                                                    boundary_knots);
+      arma::mat bspline_mat{bspline.basis(true)};
+      B(i,0) = bspline_mat;
+    }
+    const RaggedObs obs = makeRaggedObs(Y, B);
+    checkDraws({"Nu", "Phi", "Pi", "alpha_3", "Sigma"});
+    int burnin = std::round(burnin_prop * nu().n_slices);
+
+    arma::cube Z_samp;
+    arma::cube chi_samp;
+    arma::vec acceptance;
+    scoreMembership(obs, nu(), Phi(), pi(), alpha_3(), sigma(), burnin, n_iter,
+                    n_warmup, a_Z_PM, Z_samp, chi_samp, acceptance);
+
+    arma::vec p = {alpha/2, 0.5, 1 - (alpha/2)};
+    const arma::mat Z_draws(Z_samp.memptr(), Z_samp.n_rows * Z_samp.n_cols,
+                            Z_samp.n_slices, false, true);
+    arma::mat q = calcRowQuantiles(Z_draws, p);
+    Rcpp::List Z_CI = Rcpp::List::create(
+      Rcpp::Named("CI_Upper", arma::reshape(q.col(2), Z_samp.n_rows, Z_samp.n_cols)),
+      Rcpp::Named("CI_50", arma::reshape(q.col(1), Z_samp.n_rows, Z_samp.n_cols)),
+      Rcpp::Named("CI_Lower", arma::reshape(q.col(0), Z_samp.n_rows, Z_samp.n_cols)));
+
+    arma::mat Z_mean = arma::mean(Z_samp, 2).eval().slice(0);
+    arma::mat chi_mean = arma::mean(chi_samp, 2).eval().slice(0);
+    Rcpp::List scores = Rcpp::List::create(Rcpp::Named("Z_mean", Z_mean),
+                                           Rcpp::Named("Z_CI", Z_CI),
+                                           Rcpp::Named("chi_mean", chi_mean),
+                                           Rcpp::Named("acceptance", acceptance));
+    if(return_draws){
+      scores.push_back(Z_samp, "Z");
+      scores.push_back(chi_samp, "chi");
+    }
+    return scores;
+  }
+
+  // DIC of the model
+  //
+  // @param time Field of vectors containing time points at which the function was observed
+  // @param Y Field of vectors containing observed values of the function
+  // @param burnin_prop Double containing proportion of MCMC samples to discard
+  double DIC(const arma::field<arma::vec>& time,
+             const arma::field<arma::vec>& Y,
+             const double burnin_prop){
+    Rcpp::List ic = IC(time, Y, burnin_prop);
+    return ic["DIC"];
+  }
+
+  // AIC of the model
+  //
+  // @param time Field of vectors containing time points at which the function was observed
+  // @param Y Field of vectors containing observed values of the function
+  // @param burnin_prop Double containing proportion of MCMC samples to discard
+  double AIC(const arma::field<arma::vec>& time,
+             const arma::field<arma::vec>& Y,
+             const double burnin_prop){
+    double log_lik = meanCurveLikelihood(time, Y, burnin_prop);
+    return 2 * nParams() - (2 * log_lik);
+  }
+
+  // BIC of the model
+  //
+  // @param time Field of vectors containing time points at which the function was observed
+  // @param Y Field of vectors containing observed values of the function
+  // @param burnin_prop Double containing proportion of MCMC samples to discard
+  double BIC(const arma::field<arma::vec>& time,
+             const arma::field<arma::vec>& Y,
+             const double burnin_prop){
+    double log_lik = meanCurveLikelihood(time, Y, burnin_prop);
+    double tilde_N = 0;
+    for(int i = 0; i < Y.n_elem; i++){
+      tilde_N = tilde_N + Y(i,0).n_elem;
+    }
+    return (2 * log_lik) - (std::log(tilde_N) * nParams());
+  }
+
+private:
+  std::string dir;
+  int n_files;
+  int basis_degree;
+  arma::vec boundary_knots;
+  arma::vec internal_knots;
+
+  bool loaded_nu;
+  bool loaded_Phi;
+  bool loaded_Z;
+  bool loaded_chi;
+  bool loaded_sigma;
+  bool loaded_pi;
+  bool loaded_alpha_3;
+  arma::cube nu_samp;
+  arma::field<arma::cube> Phi_samp;
+  arma::cube Z_samp;
+  arma::cube chi_samp;
+  arma::vec sigma_samp;
+  arma::mat pi_samp;
+  arma::vec alpha_3_samp;
+
+  // deque keeps references to cached bases valid when new bases are added
+  std::deque<arma::vec> grid_cache;
+  std::deque<arma::mat> basis_cache;
+  arma::field<arma::vec> obs_time;
+  arma::field<arma::mat> B_obs;
+
+  // Number of MCMC samples of a parameter
+  arma::uword nDraws(const std::string& name){
+    if(name == "Nu"){
+      return nu().n_slices;
+    }
+    if(name == "Phi"){
+      return Phi().n_rows;
+    }
+    if(name == "Z"){
+      return Z().n_slices;
+    }
+    if(name == "Chi"){
+      return chi().n_slices;
+    }
+    if(name == "Pi"){
+      return pi().n_cols;
+    }
+    if(name == "alpha_3"){
+      return alpha_3().n_elem;
+    }
+    return sigma().n_elem;
+  }
+
+  // Stops if parameters whose draws are read together do not contain the
+  // same number of MCMC samples (e.g. if they were saved with different
+  // thinning), since the ith samples would not come from the same iteration
+  void checkDraws(const std::vector<std::string>& names){
+    for(std::size_t j = 1; j < names.size(); j++){
+      if(nDraws(names[j]) != nDraws(names[0])){
+        Rcpp::stop("the files of '" + names[j] + "' and '" + names[0] +
+          "' do not contain the same number of MCMC samples (they must be " +
+          "saved with the same thinning)");
+      }
+    }
+  }
+
+  // Number of parameters used in the AIC and BIC
+  double nParams(){
+    const arma::cube& Phi_0 = Phi()(0,0);
+    return (Z().n_rows + Phi_0.n_cols) * Z().n_cols +
+      2 * Phi_0.n_cols * Phi_0.n_slices * Phi_0.n_rows +
+      2 + 4 * Z().n_cols + chi().n_rows * chi().n_cols +
+      (Phi_0.n_slices * Z().n_cols);
+  }
+
+  // Log-likelihood evaluated at the posterior mean of the curve fits and sigma squared
+  double meanCurveLikelihood(const arma::field<arma::vec>& time,
+                             const arma::field<arma::vec>& Y,
+                             const double burnin_prop){
+    checkDraws({"Nu", "Phi", "Z", "Chi", "Sigma"});
+    const arma::field<arma::mat>& B = basisObs(time);
+    int burnin = std::round(burnin_prop * sigma().n_elem);
+    int n_samp = sigma().n_elem - burnin;
+
+    // Get posterior mean of sigma^2
+    double mean_sigma = arma::mean(sigma());
+
+    double log_lik = 0;
+    arma::rowvec Z_ph(Z().n_cols, arma::fill::zeros);
+    arma::rowvec mean_curve_fit;
+    for(int i = 0; i < Z().n_rows; i++){
+      // Estimate individual curve fit
+      mean_curve_fit = arma::zeros<arma::rowvec>(Y(i,0).n_elem);
+      for(int j = burnin; j < sigma().n_elem; j++){
+        Z_ph = Z()(arma::span(i), arma::span::all, arma::span(j));
+        mean_curve_fit = mean_curve_fit + Z_ph * nu().slice(j) * B(i,0).t();
+        for(int k = 0; k < chi().n_cols; k++){
+          mean_curve_fit = mean_curve_fit + (chi()(i, k, j) * Z_ph *
+            Phi()(j,0).slice(k) * B(i,0).t());
+        }
+      }
+      mean_curve_fit = mean_curve_fit / n_samp;
+      for(int j = 0; j < Y(i,0).n_elem; j++){
+        log_lik = log_lik + R::dnorm(Y(i,0)(j), mean_curve_fit(j),
+                                     std::sqrt(mean_sigma), true);
+      }
+    }
+    return log_lik;
+  }
+};
+}
+
+#endif
@@ -0,0 +1,270 @@
+#ifndef BayesFMMM_POSTERIOR_SUMMARY_H
+#define BayesFMMM_POSTERIOR_SUMMARY_H
+
+#include <RcppArmadillo.h>
+#include <cmath>
+
+namespace BayesFMMM{
+// Streaming estimate of a single quantile using the P-square algorithm
+// (Jain and Chlamtac, 1985). Only five markers are stored, so the memory
+// footprint does not depend on the number of MCMC draws.
+//
+// @name P2Quantile
+// @param p Double containing the probability of the quantile of interest
+class P2Quantile{
+public:
+  P2Quantile(const double p = 0.5){
+    reset(p);
+  }
+
+  void reset(const double p){
+    prob = p;
+    count = 0;
+    for(int i = 0; i < 5; i++){
+      q[i] = 0;
+      n[i] = i;
+    }
+    np[0] = 0;
+    np[1] = 2 * p;
+    np[2] = 4 * p;
+    np[3] = 2 + 2 * p;
+    np[4] = 4;
+    dn[0] = 0;
+    dn[1] = p / 2;
+    dn[2] = p;
+    dn[3] = (1 + p) / 2;
+    dn[4] = 1;
+  }
+
+  // Adds an observation to the estimator
+  void update(const double x){
+    if(count < 5){
+      // insertion sort of the first five observations
+      int i = count;
+      while((i > 0) && (q[i - 1] > x)){
+        q[i] = q[i - 1];
+        i = i - 1;
+      }
+      q[i] = x;
+      count = count + 1;
+      return;
+    }
+    count = count + 1;
+
+    // find cell containing x and update extreme markers
+    int k = 0;
+    if(x < q[0]){
+      q[0] = x;
+      k = 0;
+    }else if(x >= q[4]){
+      q[4] = x;
+      k = 3;
+    }else{
+      k = 0;
+      while(x >= q[k + 1]){
+        k = k + 1;
+      }
+    }
+    for(int i = k + 1; i < 5; i++){
+      n[i] = n[i] + 1;
+    }
+    for(int i = 0; i < 5; i++){
+      np[i] = np[i] + dn[i];
+    }
+
+    // adjust the middle markers
+    for(int i = 1; i < 4; i++){
+      double d = np[i] - n[i];
+      if(((d >= 1) && ((n[i + 1] - n[i]) > 1)) ||
+         ((d <= -1) && ((n[i - 1] - n[i]) < -1))){
+        int s = (d >= 0) ? 1 : -1;
+        double q_new = parabolic(i, s);
+        if((q[i - 1] < q_new) && (q_new < q[i + 1])){
+          q[i] = q_new;
+        }else{
+          q[i] = q[i] + s * (q[i + s] - q[i]) / (n[i + s] - n[i]);
+        }
+        n[i] = n[i] + s;
+      }
+    }
+  }
+
+  // Current estimate of the quantile
+  double value() const{
+    if(count == 0){
+      return 0;
+    }
+    if(count < 5){
+      // exact quantile of the stored observations
+      double h = (count - 1) * prob;
+      int lo = std::floor(h);
+      int hi = std::ceil(h);
+      return q[lo] + (h - lo) * (q[hi] - q[lo]);
+    }
+    return q[2];
+  }
+
+private:
+  double prob;
+  int count;
+  double q[5];
+  double n[5];
+  double np[5];
+  double dn[5];
+
+  double parabolic(const int i, const int s) const{
+    return q[i] + (s / (n[i + 1] - n[i - 1])) *
+      ((n[i] - n[i - 1] + s) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]) +
+      (n[i + 1] - n[i] - s) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+  }
+};
+
+// Online posterior summaries of the mean functions and covariance surfaces
+// evaluated on a fixed grid. Running means and variances are updated using
+// Welford's algorithm and pointwise quantiles are tracked by P-square
+// estimators, so no MCMC draws need to be stored. The posterior mean of the
+// mean functions is Rao-Blackwellized, while their posterior standard
+// deviations and quantiles are computed from the draws.
+//
+// @name OnlineSummary
+// @param B_grid Matrix containing basis functions evaluated at the grid points
+// @param K Int containing the number of clusters
+// @param quant_probs Vector containing the probabilities of the quantiles to track
+class OnlineSummary{
+public:
+  OnlineSummary(const arma::mat& B_grid,
+                const int K,
+                const arma::vec& quant_probs) : B(B_grid), probs(quant_probs){
+    n_draws = 0;
+    n_grid = B.n_rows;
+    n_pairs = (K * (K + 1)) / 2;
+    pairs = arma::zeros<arma::umat>(n_pairs, 2);
+    int ind = 0;
+    for(int l = 0; l < K; l++){
+      for(int m = l; m < K; m++){
+        pairs(ind, 0) = l;
+        pairs(ind, 1) = m;
+        ind = ind + 1;
+      }
+    }
+    mean_mean = arma::zeros(K, n_grid);
+    mean_draws = arma::zeros(K, n_grid);
+    mean_M2 = arma::zeros(K, n_grid);
+    mean_quant = arma::field<P2Quantile>(K * n_grid, probs.n_elem);
+    cov_mean = arma::zeros(n_grid, n_grid, n_pairs);
+    cov_M2 = arma::zeros(n_grid, n_grid, n_pairs);
+    cov_quant = arma::field<P2Quantile>(n_grid * n_grid * n_pairs, probs.n_elem);
+    for(int r = 0; r < probs.n_elem; r++){
+      for(arma::uword i = 0; i < mean_quant.n_rows; i++){
+        mean_quant(i, r).reset(probs(r));
+      }
+      for(arma::uword i = 0; i < cov_quant.n_rows; i++){
+        cov_quant(i, r).reset(probs(r));
+      }
+    }
+  }
+
+  // Adds one MCMC draw to the summaries
+  //
+  // @param nu Matrix containing nu parameters used for the standard deviations and quantiles
+  // @param nu_mean Matrix containing the conditional posterior mean of nu, used for the running mean
+  // @param Phi Cube containing Phi parameters
+  void update(const arma::mat& nu,
+              const arma::mat& nu_mean,
+              const arma::cube& Phi){
+    n_draws = n_draws + 1;
+    double delta = 0;
+
+    // mean functions (Rao-Blackwellized running mean)
+    arma::mat f_rb = nu_mean * B.t();
+    arma::mat f = nu * B.t();
+    for(arma::uword k = 0; k < f.n_rows; k++){
+      for(arma::uword g = 0; g < n_grid; g++){
+        mean_mean(k,g) = mean_mean(k,g) + (f_rb(k,g) - mean_mean(k,g)) / n_draws;
+        // the variance of the conditional means would miss the variance of
+        // the draws around them, so the standard deviation uses the draws
+        delta = f(k,g) - mean_draws(k,g);
+        mean_draws(k,g) = mean_draws(k,g) + delta / n_draws;
+        mean_M2(k,g) = mean_M2(k,g) + delta * (f(k,g) - mean_draws(k,g));
+        for(arma::uword r = 0; r < probs.n_elem; r++){
+          mean_quant(k + f.n_rows * g, r).update(f(k,g));
+        }
+      }
+    }
+
+    // covariance surfaces
+    arma::field<arma::mat> PhiB(Phi.n_slices);
+    for(arma::uword n = 0; n < Phi.n_slices; n++){
+      PhiB(n) = B * Phi.slice(n).t();
+    }
+    arma::mat C = arma::zeros(n_grid, n_grid);
+    for(arma::uword p = 0; p < n_pairs; p++){
+      C.zeros();
+      for(arma::uword n = 0; n < Phi.n_slices; n++){
+        C = C + PhiB(n).col(pairs(p,0)) * PhiB(n).col(pairs(p,1)).t();
+      }
+      for(arma::uword j = 0; j < n_grid; j++){
+        for(arma::uword i = 0; i < n_grid; i++){
+          delta = C(i,j) - cov_mean(i,j,p);
+          cov_mean(i,j,p) = cov_mean(i,j,p) + delta / n_draws;
+          cov_M2(i,j,p) = cov_M2(i,j,p) + delta * (C(i,j) - cov_mean(i,j,p));
+          for(arma::uword r = 0; r < probs.n_elem; r++){
+            cov_quant(i + n_grid * (j + n_grid * p), r).update(C(i,j));
+          }
+        }
+      }
+    }
+  }
+
+  // Returns the summaries as an R list
+  Rcpp::List summary() const{
+    double denom = (n_draws > 1) ? (n_draws - 1) : 1;
+    arma::cube mean_q(mean_mean.n_rows, n_grid, probs.n_elem);
+    arma::field<arma::cube> cov_q(probs.n_elem);
+    for(arma::uword r = 0; r < probs.n_elem; r++){
+      for(arma::uword g = 0; g < n_grid; g++){
+        for(arma::uword k = 0; k < mean_mean.n_rows; k++){
+          mean_q(k,g,r) = mean_quant(k + mean_mean.n_rows * g, r).value();
+        }
+      }
+      cov_q(r) = arma::zeros(n_grid, n_grid, n_pairs);
+      for(arma::uword p = 0; p < n_pairs; p++){
+        for(arma::uword j = 0; j < n_grid; j++){
+          for(arma::uword i = 0; i < n_grid; i++){
+            cov_q(r)(i,j,p) = cov_quant(i + n_grid * (j + n_grid * p), r).value();
+          }
+        }
+      }
+    }
+    arma::umat pairs1 = pairs + 1;
+    arma::mat mean_sd = arma::sqrt(mean_M2 / denom);
+    arma::cube cov_sd = arma::sqrt(cov_M2 / denom);
+    return Rcpp::List::create(Rcpp::Named("n_draws", n_draws),
+                              Rcpp::Named("probs", probs),
+                              Rcpp::Named("mean", mean_mean),
+                              Rcpp::Named("mean_sd", mean_sd),
+                              Rcpp::Named("mean_quantiles", mean_q),
+                              Rcpp::Named("cov_pairs", pairs1),
+                              Rcpp::Named("cov", cov_mean),
+                              Rcpp::Named("cov_sd", cov_sd),
+                              Rcpp::Named("cov_quantiles", cov_q));
+  }
+
+private:
+  arma::mat B;
+  arma::vec probs;
+  int n_draws;
+  arma::uword n_grid;
+  arma::uword n_pairs;
+  arma::umat pairs;
+  arma::mat mean_mean;
+  arma::mat mean_draws;
+  arma::mat mean_M2;
+  arma::field<P2Quantile> mean_quant;
+  arma::cube cov_mean;
+  arma::cube cov_M2;
+  arma::field<P2Quantile> cov_quant;
+};
+}
+
+#endif
@@ -0,0 +1,392 @@
+#ifndef BayesFMMM_RAGGED_OBS_H
+#define BayesFMMM_RAGGED_OBS_H
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace BayesFMMM{
+// Contiguous storage for ragged functional observations. The observed values
+// of all functions are stacked into a single vector and the basis functions
+// evaluated at the observed time points are stored in a single matrix, where
+// each column corresponds to one observed time point. The observations of the
+// ith function occupy positions offsets(i), ..., offsets(i + 1) - 1.
+//
+// The observations of a function can also be replaced by their sufficient
+// statistics (see compressRaggedObs), in which case rss0 and n_raw are not
+// empty.
+//
+// @name RaggedObs
+// @field y Vector containing all observed values
+// @field B_t Matrix (P x total number of observations) containing the basis functions evaluated at the observed time points
+// @field offsets Vector (n_funct + 1) containing the starting position of each function
+// @field rss0 Vector containing the part of the residual sum of squares of each function that does not depend on the basis coefficients (empty if the observations are not compressed)
+// @field n_raw Vector containing the number of observed time points of each function before compression (empty if the observations are not compressed)
+struct RaggedObs{
+  arma::vec y;
+  arma::mat B_t;
+  arma::uvec offsets;
+  arma::vec rss0;
+  arma::uvec n_raw;
+
+  // Number of functions stored
+  arma::uword n_funct() const{
+    return offsets.n_elem - 1;
+  }
+
+  // Number of observed time points for the ith function
+  arma::uword n_obs(const arma::uword i) const{
+    return offsets(i + 1) - offsets(i);
+  }
+
+  // Whether the observations were replaced by their sufficient statistics
+  bool compressed() const{
+    return rss0.n_elem > 0;
+  }
+
+  // Total number of observed values (before compression)
+  double n_total() const{
+    if(compressed()){
+      return arma::accu(n_raw);
+    }
+    return y.n_elem;
+  }
+
+  // Residual sum of squares of the ith function that is not stored in y_i
+  double rss_offset(const arma::uword i) const{
+    if(compressed()){
+      return rss0(i);
+    }
+    return 0;
+  }
+
+  // Observed values of the ith function (requires n_obs(i) > 0)
+  const arma::subview_col<double> y_i(const arma::uword i) const{
+    return y.subvec(offsets(i), offsets(i + 1) - 1);
+  }
+
+  // Basis functions of the ith function, one column per time point (requires n_obs(i) > 0)
+  const arma::subview<double> B_i(const arma::uword i) const{
+    return B_t.cols(offsets(i), offsets(i + 1) - 1);
+  }
+};
+
+// Packs the observed values and basis matrices into contiguous storage. Every
+// function must have as many rows in its basis matrix as observed values, and
+// the basis matrices of all observed functions must have the same number of
+// columns.
+//
+// @name makeRaggedObs
+// @param y_obs Field of vectors containing observed values
+// @param B_obs Field of matrices containing basis functions evaluated at observed time points
+// @returns obs RaggedObs containing the packed observations
+inline RaggedObs makeRaggedObs(const arma::field<arma::vec>& y_obs,
+                               const arma::field<arma::mat>& B_obs){
+  if(y_obs.n_elem == 0){
+    Rcpp::stop("'y_obs' must contain at least one function");
+  }
+  if(B_obs.n_elem != y_obs.n_elem){
+    Rcpp::stop("'y_obs' and 'B_obs' must contain the same number of functions");
+  }
+  arma::uword P = B_obs(0,0).n_cols;
+  for(arma::uword i = 0; i < y_obs.n_elem; i++){
+    if(y_obs(i,0).n_elem > 0){
+      P = B_obs(i,0).n_cols;
+      break;
+    }
+  }
+  for(arma::uword i = 0; i < y_obs.n_elem; i++){
+    if((y_obs(i,0).n_elem > 0) &&
+       ((B_obs(i,0).n_rows != y_obs(i,0).n_elem) || (B_obs(i,0).n_cols != P))){
+      Rcpp::stop("the basis matrix of function " + std::to_string(i + 1) +
+        " does not match its observed values");
+    }
+  }
+
+  RaggedObs obs;
+  obs.offsets = arma::zeros<arma::uvec>(y_obs.n_elem + 1);
+  for(arma::uword i = 0; i < y_obs.n_elem; i++){
+    obs.offsets(i + 1) = obs.offsets(i) + y_obs(i,0).n_elem;
+  }
+
+  obs.y = arma::zeros(obs.offsets(y_obs.n_elem));
+  obs.B_t = arma::zeros(P, obs.offsets(y_obs.n_elem));
+  for(arma::uword i = 0; i < y_obs.n_elem; i++){
+    if(obs.n_obs(i) > 0){
+      obs.y.subvec(obs.offsets(i), obs.offsets(i + 1) - 1) = y_obs(i,0);
+      obs.B_t.cols(obs.offsets(i), obs.offsets(i + 1) - 1) = B_obs(i,0).t();
+    }
+  }
+  return obs;
+}
+
+// Replaces the observations of a function by pseudo-observations with the
+// same sufficient statistics. If B_i' = Q R (thin QR decomposition), the P
+// pseudo-observations Q' y_i with basis functions R' have the same B_i B_i'
+// and B_i y_i as the observations, so every update that depends on the data
+// only through these statistics is unchanged, and every residual sum of
+// squares is smaller by rss0 = y_i' y_i - ||Q' y_i||^2. The observations are
+// copied if there are not more time points than basis functions.
+//
+// @name compressFunction
+// @param B_i Matrix (P x n_i) containing the basis functions evaluated at the observed time points
+// @param y_i Vector containing the observed values
+// @param y_c Pointer to storage for the min(n_i, P) pseudo-observations
+// @param B_c Pointer to storage for the basis functions of the pseudo-observations (P x min(n_i, P), column major)
+// @param rss0 Double acting as a placeholder for the residual sum of squares that is not retained
+// @returns success Boolean indicating if the QR decomposition succeeded
+inline bool compressFunction(const arma::mat& B_i,
+                             const arma::vec& y_i,
+                             double* y_c,
+                             double* B_c,
+                             double& rss0){
+  arma::uword P = B_i.n_rows;
+  rss0 = 0;
+  if(y_i.n_elem <= P){
+    if(y_i.n_elem > 0){
+      std::memcpy(y_c, y_i.memptr(), y_i.n_elem * sizeof(double));
+      std::memcpy(B_c, B_i.memptr(), B_i.n_elem * sizeof(double));
+    }
+    return true;
+  }
+  arma::mat Q;
+  arma::mat R;
+  if(!arma::qr_econ(Q, R, B_i.t())){
+    return false;
+  }
+  arma::vec y_tilde(y_c, P, false, true);
+  arma::mat B_tilde(B_c, P, P, false, true);
+  y_tilde = Q.t() * y_i;
+  B_tilde = R.t();
+  rss0 = std::max(arma::dot(y_i, y_i) - arma::dot(y_tilde, y_tilde), 0.0);
+  return true;
+}
+
+// Gets the starting position of each function after compression (each
+// function keeps at most P pseudo-observations)
+//
+// @name compressedOffsets
+// @param n_raw Vector containing the number of observed time points of each function
+// @param P Int containing the number of basis functions
+// @returns offsets Vector (n_funct + 1) containing the starting position of each function
+inline arma::uvec compressedOffsets(const arma::uvec& n_raw,
+                                    const arma::uword P){
+  arma::uvec offsets = arma::zeros<arma::uvec>(n_raw.n_elem + 1);
+  for(arma::uword i = 0; i < n_raw.n_elem; i++){
+    offsets(i + 1) = offsets(i) + std::min(n_raw(i), P);
+  }
+  return offsets;
+}
+
+// Replaces the observations of every function by their sufficient statistics
+// (see compressFunction). The number of stored values of a function becomes
+// at most P, so the memory used by the observations and the cost of every
+// sweep over them no longer grow with the number of observed time points,
+// while the updates, residual sums of squares and likelihood are unchanged.
+//
+// @name compressRaggedObs
+// @param obs RaggedObs containing the packed observations
+// @returns obs_c RaggedObs containing the compressed observations
+inline RaggedObs compressRaggedObs(const RaggedObs& obs){
+  arma::uword P = obs.B_t.n_rows;
+  int n_funct = obs.n_funct();
+  RaggedObs obs_c;
+  obs_c.n_raw = arma::zeros<arma::uvec>(n_funct);
+  for(int i = 0; i < n_funct; i++){
+    obs_c.n_raw(i) = obs.compressed() ? obs.n_raw(i) : obs.n_obs(i);
+  }
+  arma::uvec n_stored(n_funct);
+  for(int i = 0; i < n_funct; i++){
+    n_stored(i) = obs.n_obs(i);
+  }
+  obs_c.offsets = compressedOffsets(n_stored, P);
+  obs_c.y = arma::zeros(obs_c.offsets(n_funct));
+  obs_c.B_t = arma::zeros(P, obs_c.offsets(n_funct));
+  obs_c.rss0 = arma::zeros(n_funct);
+  std::vector<int> compressed(n_funct, 1);
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < n_funct; i++){
+    if(obs.n_obs(i) > 0){
+      const arma::mat B_i = obs.B_i(i);
+      const arma::vec y_i = obs.y_i(i);
+      compressed[i] = compressFunction(B_i, y_i,
+                                       obs_c.y.memptr() + obs_c.offsets(i),
+                                       obs_c.B_t.colptr(obs_c.offsets(i)),
+                                       obs_c.rss0(i));
+      obs_c.rss0(i) = obs_c.rss0(i) + obs.rss_offset(i);
+    }
+  }
+  for(int i = 0; i < n_funct; i++){
+    if(compressed[i] == 0){
+      Rcpp::stop("unable to compress the observations of function " +
+        std::to_string(i + 1));
+    }
+  }
+  return obs_c;
+}
+
+// Single precision copy of RaggedObs. The observation noise of functional data
+// is orders of magnitude larger than the rounding error of single precision,
+// so the observed values and basis functions can be streamed at half the
+// memory bandwidth; sums over observations are still accumulated in double
+// precision.
+//
+// @name RaggedObsF
+// @field y Vector containing all observed values
+// @field B_t Matrix (P x total number of observations) containing the basis functions evaluated at the observed time points
+// @field offsets Vector (n_funct + 1) containing the starting position of each function
+// @field rss0 Vector containing the part of the residual sum of squares of each function that does not depend on the basis coefficients (empty if the observations are not compressed)
+// @field n_raw Vector containing the number of observed time points of each function before compression (empty if the observations are not compressed)
+struct RaggedObsF{
+  arma::fvec y;
+  arma::fmat B_t;
+  arma::uvec offsets;
+  arma::vec rss0;
+  arma::uvec n_raw;
+
+  // Number of functions stored
+  arma::uword n_funct() const{
+    return offsets.n_elem - 1;
+  }
+
+  // Number of observed time points for the ith function
+  arma::uword n_obs(const arma::uword i) const{
+    return offsets(i + 1) - offsets(i);
+  }
+
+  // Whether the observations were replaced by their sufficient statistics
+  bool compressed() const{
+    return rss0.n_elem > 0;
+  }
+
+  // Total number of observed values (before compression)
+  double n_total() const{
+    if(compressed()){
+      return arma::accu(n_raw);
+    }
+    return y.n_elem;
+  }
+
+  // Residual sum of squares of the ith function that is not stored in y_i
+  double rss_offset(const arma::uword i) const{
+    if(compressed()){
+      return rss0(i);
+    }
+    return 0;
+  }
+
+  // Observed values of the ith function (requires n_obs(i) > 0)
+  const arma::subview_col<float> y_i(const arma::uword i) const{
+    return y.subvec(offsets(i), offsets(i + 1) - 1);
+  }
+
+  // Basis functions of the ith function, one column per time point (requires n_obs(i) > 0)
+  const arma::subview<float> B_i(const arma::uword i) const{
+    return B_t.cols(offsets(i), offsets(i + 1) - 1);
+  }
+};
+
+// Rounds packed observations to single precision
+//
+// @name makeRaggedObsF
+// @param obs RaggedObs containing the packed observations
+// @returns obs_f RaggedObsF containing the observations in single precision
+inline RaggedObsF makeRaggedObsF(const RaggedObs& obs){
+  RaggedObsF obs_f;
+  obs_f.y = arma::conv_to<arma::fvec>::from(obs.y);
+  obs_f.B_t = arma::conv_to<arma::fmat>::from(obs.B_t);
+  obs_f.offsets = obs.offsets;
+  obs_f.rss0 = obs.rss0;
+  obs_f.n_raw = obs.n_raw;
+  return obs_f;
+}
+
+// Calculates the basis coefficients of the conditional mean of a function
+// (sum_k Z_k * (nu_k + sum_n chi_n * Phi_kn))
+//
+// @name calcMeanCoef
+// @param nu Matrix containing current nu parameters
+// @param Phi Cube containing current Phi parameters
+// @param Z Vector containing the row of Z for the function of interest
+// @param chi Vector containing the row of chi for the function of interest
+// @param coef Vector acting as a placeholder for the coefficients
+inline void calcMeanCoef(const arma::mat& nu,
+                         const arma::cube& Phi,
+                         const arma::rowvec& Z,
+                         const arma::rowvec& chi,
+                         arma::vec& coef){
+  coef.set_size(nu.n_cols);
+  double c = 0;
+  double s = 0;
+  for(arma::uword p = 0; p < nu.n_cols; p++){
+    c = 0;
+    for(arma::uword k = 0; k < nu.n_rows; k++){
+      s = nu.at(k,p);
+      for(arma::uword n = 0; n < Phi.n_slices; n++){
+        s = s + chi.at(n) * Phi.at(k,p,n);
+      }
+      c = c + Z.at(k) * s;
+    }
+    coef.at(p) = c;
+  }
+}
+
+// Calculates the residual sum of squares of the ith function
+//
+// @name calcRSS
+// @param obs RaggedObs containing the observations
+// @param i Int containing the function of interest
+// @param coef Vector containing basis coefficients of the conditional mean
+// @returns rss Double containing the residual sum of squares
+inline double calcRSS(const RaggedObs& obs,
+                      const arma::uword i,
+                      const arma::vec& coef){
+  const double* c = coef.memptr();
+  const double* b;
+  double r = 0;
+  double rss = 0;
+  for(arma::uword t = obs.offsets(i); t < obs.offsets(i + 1); t++){
+    b = obs.B_t.colptr(t);
+    r = obs.y.at(t);
+    for(arma::uword p = 0; p < obs.B_t.n_rows; p++){
+      r = r - (b[p] * c[p]);
+    }
+    rss = rss + (r * r);
+  }
+  return rss + obs.rss_offset(i);
+}
+
+// Calculates the residual sum of squares of the ith function from single
+// precision observations. The fitted values are computed in single precision
+// and the squared residuals are accumulated in double precision.
+//
+// @name calcRSS
+// @param obs RaggedObsF containing the observations
+// @param i Int containing the function of interest
+// @param coef Vector containing basis coefficients of the conditional mean
+// @returns rss Double containing the residual sum of squares
+inline double calcRSS(const RaggedObsF& obs,
+                      const arma::uword i,
+                      const arma::vec& coef){
+  const double* c = coef.memptr();
+  const float* b;
+  float fitted = 0;
+  double r = 0;
+  double rss = 0;
+  for(arma::uword t = obs.offsets(i); t < obs.offsets(i + 1); t++){
+    b = obs.B_t.colptr(t);
+    fitted = 0;
+    for(arma::uword p = 0; p < obs.B_t.n_rows; p++){
+      fitted = fitted + (b[p] * static_cast<float>(c[p]));
+    }
+    r = static_cast<double>(obs.y.at(t)) - fitted;
+    rss = rss + (r * r);
+  }
+  return rss + obs.rss_offset(i);
+}
+}
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef BayesFMMM_RETENTION_H
+#define BayesFMMM_RETENTION_H
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+#include "SampleCodec.h"
+
+namespace BayesFMMM{
+// Selects which parameters the samplers write to disk and how often. The
+// samplers keep a batch of r_stored_iters MCMC iterations in RAM; once the
+// batch is complete, the retained iterations of each retained parameter are
+// written to one file, so every file is written exactly once per batch.
+// Within a batch the pth retained iteration of a parameter with thinning t is
+// the first iteration of the batch if p = 0 and the (t * p)th iteration
+// otherwise (the same iterations as thinning_num = t). The files are written
+// with the storage codec of the policy.
+//
+// @name RetentionPolicy
+// @field thinning Map containing the thinning of each retained parameter (keyed by the file prefix of the parameter)
+// @field codec SampleCodec used to write the files
+struct RetentionPolicy{
+  std::map<std::string, int> thinning;
+  SampleCodec codec;
+};
+
+// Creates a retention policy where every parameter is saved with the same
+// thinning (written in the Armadillo text format)
+//
+// @name makeRetentionPolicy
+// @param params Vector containing the file prefixes of the parameters of the model
+// @param thinning_num Int containing how often the MCMC iterations are saved
+// @returns retention RetentionPolicy retaining every parameter
+inline RetentionPolicy makeRetentionPolicy(const std::vector<std::string>& params,
+                                           const int thinning_num){
+  RetentionPolicy retention;
+  retention.codec = makeSampleCodec();
+  for(std::size_t j = 0; j < params.size(); j++){
+    retention.thinning[params[j]] = thinning_num;
+  }
+  return retention;
+}
+
+// Gets the thinning of a parameter (0 if the parameter is not retained)
+//
+// @name retainedThinning
+// @param retention RetentionPolicy
+// @param param String containing the file prefix of the parameter
+// @returns thinning Int containing the thinning of the parameter
+inline int retainedThinning(const RetentionPolicy& retention,
+                            const std::string& param){
+  std::map<std::string, int>::const_iterator it = retention.thinning.find(param);
+  if(it == retention.thinning.end()){
+    return 0;
+  }
+  return it->second;
+}
+
+// File prefixes of the parameters whose draws are read together by the
+// posterior summaries (e.g. the likelihood of the ith draw uses the ith draw
+// of each of them), so they must be saved with the same thinning
+//
+// @name jointParams
+// @returns params Vector containing the file prefixes
+inline std::vector<std::string> jointParams(){
+  return std::vector<std::string>{"Nu", "Phi", "Z", "Chi", "Sigma", "Pi",
+                                  "alpha_3"};
+}
+
+// Creates a retention policy from a named vector, where the names are the
+// file prefixes of the parameters that should be saved and the values are
+// their thinning. Parameters that are not named are not saved, and the
+// retained parameters returned by jointParams must have the same thinning.
+// If the vector is NULL, every parameter is saved every thinning_num
+// iterations.
+//
+// @name makeRetentionPolicy
+// @param params Vector containing the file prefixes of the parameters of the model
+// @param thinning_num Int containing how often the MCMC iterations are saved
+// @param r_stored_iters Int containing how many MCMC iterations are stored in RAM
+// @param retain Named vector containing the thinning of each retained parameter
+// @returns retention RetentionPolicy
+inline RetentionPolicy makeRetentionPolicy(const std::vector<std::string>& params,
+                                           const int thinning_num,
+                                           const int r_stored_iters,
+                                           Rcpp::Nullable<Rcpp::NumericVector> retain){
+  if(retain.isNull()){
+    return makeRetentionPolicy(params, thinning_num);
+  }
+  Rcpp::NumericVector retain_vec(retain);
+  if(retain_vec.size() == 0){
+    return makeRetentionPolicy(params, thinning_num);
+  }
+  if(Rf_isNull(retain_vec.names())){
+    Rcpp::stop("'retain' must be a named vector");
+  }
+  Rcpp::CharacterVector names = retain_vec.names();
+  RetentionPolicy retention;
+  retention.codec = makeSampleCodec();
+  for(int j = 0; j < retain_vec.size(); j++){
+    std::string name = Rcpp::as<std::string>(names[j]);
+    if(std::find(params.begin(), params.end(), name) == params.end()){
+      Rcpp::stop("'" + name + "' is not a parameter of the model and cannot be retained");
+    }
+    if((retain_vec[j] < 1) || (retain_vec[j] != std::floor(retain_vec[j]))){
+      Rcpp::stop("the values of 'retain' must be positive integers");
+    }
+    if(retain_vec[j] > r_stored_iters){
+      Rcpp::stop("the values of 'retain' must be less than or equal to 'r_stored_iters'");
+    }
+    retention.thinning[name] = (int) retain_vec[j];
+  }
+  std::vector<std::string> joint = jointParams();
+  std::string first;
+  for(std::size_t j = 0; j < joint.size(); j++){
+    int thinning = retainedThinning(retention, joint[j]);
+    if(thinning == 0){
+      continue;
+    }
+    if(first.empty()){
+      first = joint[j];
+    }else if(thinning != retention.thinning[first]){
+      Rcpp::stop("'" + joint[j] + "' and '" + first + "' must be retained with " +
+        "the same thinning, since their draws are read together");
+    }
+  }
+  return retention;
+}
+
+// Gets the position in the batch of the pth retained MCMC iteration
+//
+// @name retainedSlot
+// @param p Int containing the index of the retained iteration
+// @param thinning Int containing the thinning of the parameter
+// @returns slot Int containing the position of the iteration in the batch
+inline arma::uword retainedSlot(const int p,
+                                const int thinning){
+  if(p == 0){
+    return 0;
+  }
+  return (thinning * p) - 1;
+}
+
+// Writes the retained MCMC iterations of a parameter stored as the slices of
+// a cube
+//
+// @name flushRetained
+// @param retention RetentionPolicy
+// @param param String containing the file prefix of the parameter
+// @param x Cube containing the batch of MCMC iterations (one per slice)
+// @param directory String containing the directory where the files are saved
+// @param q Int containing the index of the batch
+inline void flushRetained(const RetentionPolicy& retention,
+                          const std::string& param,
+                          const arma::cube& x,
+                          const std::string& directory,
+                          const int q){
+  int thinning = retainedThinning(retention, param);
+  if(thinning == 0){
+    return;
+  }
+  arma::cube x1(x.n_rows, x.n_cols, x.n_slices / thinning);
+  for(arma::uword p = 0; p < x1.n_slices; p++){
+    x1.slice(p) = x.slice(retainedSlot(p, thinning));
+  }
+  saveSamples(x1, directory + param + std::to_string(q) + ".txt", retention.codec);
+}
+
+// Writes the retained MCMC iterations of a parameter stored as the elements
+// of a vector
+//
+// @name flushRetained
+inline void flushRetained(const RetentionPolicy& retention,
+                          const std::string& param,
+                          const arma::vec& x,
+                          const std::string& directory,
+                          const int q){
+  int thinning = retainedThinning(retention, param);
+  if(thinning == 0){
+    return;
+  }
+  arma::vec x1(x.n_elem / thinning);
+  for(arma::uword p = 0; p < x1.n_elem; p++){
+    x1(p) = x(retainedSlot(p, thinning));
+  }
+  saveSamples(x1, directory + param + std::to_string(q) + ".txt", retention.codec);
+}
+
+// Writes the retained MCMC iterations of a parameter stored as the rows of a
+// field (every column of the field is kept)
+//
+// @name flushRetained
+inline void flushRetained(const RetentionPolicy& retention,
+                          const std::string& param,
+                          const arma::field<arma::cube>& x,
+                          const std::string& directory,
+                          const int q){
+  int thinning = retainedThinning(retention, param);
+  if(thinning == 0){
+    return;
+  }
+  arma::field<arma::cube> x1(x.n_rows / thinning, x.n_cols);
+  for(arma::uword p = 0; p < x1.n_rows; p++){
+    for(arma::uword k = 0; k < x1.n_cols; k++){
+      x1(p,k) = x(retainedSlot(p, thinning), k);
+    }
+  }
+  saveSamples(x1, directory + param + std::to_string(q) + ".txt", retention.codec);
+}
+
+// Writes the retained MCMC iterations of a parameter stored as the columns
+// of a matrix
+//
+// @name flushRetainedCols
+inline void flushRetainedCols(const RetentionPolicy& retention,
+                              const std::string& param,
+                              const arma::mat& x,
+                              const std::string& directory,
+                              const int q){
+  int thinning = retainedThinning(retention, param);
+  if(thinning == 0){
+    return;
+  }
+  arma::mat x1(x.n_rows, x.n_cols / thinning);
+  for(arma::uword p = 0; p < x1.n_cols; p++){
+    x1.col(p) = x.col(retainedSlot(p, thinning));
+  }
+  saveSamples(x1, directory + param + std::to_string(q) + ".txt", retention.codec);
+}
+
+// Writes the retained MCMC iterations of a parameter stored as the rows of a
+// matrix
+//
+// @name flushRetainedRows
+inline void flushRetainedRows(const RetentionPolicy& retention,
+                              const std::string& param,
+                              const arma::mat& x,
+                              const std::string& directory,
+                              const int q){
+  int thinning = retainedThinning(retention, param);
+  if(thinning == 0){
+    return;
+  }
+  arma::mat x1(x.n_rows / thinning, x.n_cols);
+  for(arma::uword p = 0; p < x1.n_rows; p++){
+    x1.row(p) = x.row(retainedSlot(p, thinning));
+  }
+  saveSamples(x1, directory + param + std::to_string(q) + ".txt", retention.codec);
+}
+
+// File prefixes of the parameters saved by the functional and multivariate
+// samplers
+//
+// @name modelParams
+// @returns params Vector containing the file prefixes
+inline std::vector<std::string> modelParams(){
+  return std::vector<std::string>{"Nu", "Chi", "Pi", "alpha_3", "A", "Delta",
+                                  "Sigma", "Tau", "Gamma", "Phi", "Z"};
+}
+
+// File prefixes of the parameters saved by the covariate adjusted sampler
+//
+// @name covariateAdjParams
+// @returns params Vector containing the file prefixes
+inline std::vector<std::string> covariateAdjParams(){
+  std::vector<std::string> params = modelParams();
+  std::vector<std::string> cov_params{"Eta", "TauEta", "Xi", "GammaXi",
+                                      "DeltaXi", "AXi"};
+  params.insert(params.end(), cov_params.begin(), cov_params.end());
+  return params;
+}
+}
+
+#endif
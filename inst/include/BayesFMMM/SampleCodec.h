@@ -0,0 +1,824 @@
+#ifndef BayesFMMM_SAMPLE_CODEC_H
+#define BayesFMMM_SAMPLE_CODEC_H
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace BayesFMMM{
+// Storage codecs of the posterior draws. Files written with a codec other than
+// arma_ascii start with the bytes "BFMMMSC1" followed by the type of the
+// object, the codec used, the dimensions and the encoded values (native byte
+// order), so the loaders can tell them apart from files saved by Armadillo.
+//   - arma_ascii: Armadillo text format (no compression)
+//   - lossless: values are byte-shuffled (the ith byte of every value is
+//     stored together) and compressed with a byte-oriented LZ77 coder
+//   - float16: values are rounded to half precision (relative error of at
+//     most 2^-11 for |x| > 6.1e-5), byte-shuffled and compressed
+//   - quantized: values are rounded to a grid with spacing 2 * tol (absolute
+//     error of at most tol), byte-shuffled and compressed
+// If the values of a file cannot be represented by a lossy codec (values
+// out of the range of half precision, non-finite values or too many grid
+// points), the file is written with the lossless codec.
+const int SAMPLE_CODEC_ASCII = 0;
+const int SAMPLE_CODEC_LOSSLESS = 1;
+const int SAMPLE_CODEC_FLOAT16 = 2;
+const int SAMPLE_CODEC_QUANTIZED = 3;
+
+// Storage codec used to write the posterior draws
+//
+// @name SampleCodec
+// @field method Int containing the codec (one of the SAMPLE_CODEC_ constants)
+// @field tol Double containing the absolute error bound of the quantized codec
+struct SampleCodec{
+  int method;
+  double tol;
+};
+
+// Creates the default storage codec (Armadillo text format)
+//
+// @name makeSampleCodec
+// @returns codec SampleCodec
+inline SampleCodec makeSampleCodec(){
+  SampleCodec codec;
+  codec.method = SAMPLE_CODEC_ASCII;
+  codec.tol = 0;
+  return codec;
+}
+
+// Creates a storage codec from its name
+//
+// @name makeSampleCodec
+// @param method String containing the name of the codec ("arma_ascii", "lossless", "float16" or "quantized")
+// @param tol Double containing the absolute error bound of the quantized codec
+// @returns codec SampleCodec
+inline SampleCodec makeSampleCodec(const std::string& method,
+                                   const double tol){
+  SampleCodec codec = makeSampleCodec();
+  if(method == "arma_ascii"){
+    codec.method = SAMPLE_CODEC_ASCII;
+  }else if(method == "lossless"){
+    codec.method = SAMPLE_CODEC_LOSSLESS;
+  }else if(method == "float16"){
+    codec.method = SAMPLE_CODEC_FLOAT16;
+  }else if(method == "quantized"){
+    if(!(tol > 0)){
+      Rcpp::stop("'codec_tol' must be positive when using the quantized codec");
+    }
+    codec.method = SAMPLE_CODEC_QUANTIZED;
+    codec.tol = tol;
+  }else{
+    Rcpp::stop("'codec' must be one of 'arma_ascii', 'lossless', 'float16' or 'quantized'");
+  }
+  return codec;
+}
+
+const char SAMPLE_CODEC_MAGIC[8] = {'B', 'F', 'M', 'M', 'M', 'S', 'C', '1'};
+const std::uint8_t SAMPLE_TYPE_VEC = 0;
+const std::uint8_t SAMPLE_TYPE_MAT = 1;
+const std::uint8_t SAMPLE_TYPE_CUBE = 2;
+const std::uint8_t SAMPLE_TYPE_FIELD_CUBE = 3;
+
+// Appends an unsigned integer using 7 bits per byte
+//
+// @name putVarint
+// @param x Unsigned integer
+// @param out Vector of bytes where the integer is appended
+inline void putVarint(std::uint64_t x,
+                      std::vector<unsigned char>& out){
+  while(x >= 0x80){
+    out.push_back((unsigned char) ((x & 0x7f) | 0x80));
+    x = x >> 7;
+  }
+  out.push_back((unsigned char) x);
+}
+
+// Reads an unsigned integer written by putVarint
+//
+// @name getVarint
+// @param in Vector of bytes
+// @param pos Position of the integer in the vector (moved past the integer)
+// @param x Unsigned integer read
+// @returns success Boolean indicating if the integer was read
+inline bool getVarint(const std::vector<unsigned char>& in,
+                      std::size_t& pos,
+                      std::uint64_t& x){
+  x = 0;
+  for(int shift = 0; shift < 64; shift = shift + 7){
+    if(pos >= in.size()){
+      return false;
+    }
+    unsigned char b = in[pos];
+    pos++;
+    x = x | (((std::uint64_t) (b & 0x7f)) << shift);
+    if(b < 0x80){
+      return true;
+    }
+  }
+  return false;
+}
+
+// Stores the ith byte of every element together, so that the bytes holding
+// the sign and exponent of neighbouring values end up next to each other
+//
+// @name shuffleBytes
+// @param in Pointer to the elements
+// @param n_elem Int containing the number of elements
+// @param width Int containing the number of bytes per element
+// @param out Vector of bytes containing the shuffled bytes
+inline void shuffleBytes(const unsigned char* in,
+                         const std::size_t n_elem,
+                         const std::size_t width,
+                         std::vector<unsigned char>& out){
+  out.resize(n_elem * width);
+  for(std::size_t i = 0; i < n_elem; i++){
+    for(std::size_t b = 0; b < width; b++){
+      out[b * n_elem + i] = in[i * width + b];
+    }
+  }
+}
+
+// Reverses shuffleBytes
+//
+// @name unshuffleBytes
+// @param in Vector of shuffled bytes
+// @param n_elem Int containing the number of elements
+// @param width Int containing the number of bytes per element
+// @param out Pointer to the elements
+inline void unshuffleBytes(const std::vector<unsigned char>& in,
+                           const std::size_t n_elem,
+                           const std::size_t width,
+                           unsigned char* out){
+  for(std::size_t i = 0; i < n_elem; i++){
+    for(std::size_t b = 0; b < width; b++){
+      out[i * width + b] = in[b * n_elem + i];
+    }
+  }
+}
+
+// Compresses a vector of bytes with a greedy LZ77 coder. The output is a
+// sequence of (number of literals, literals, match length - 3, offset)
+// records where a match length of 0 ends the stream.
+//
+// @name compressBytes
+// @param in Vector of bytes
+// @param out Vector of bytes containing the compressed stream
+inline void compressBytes(const std::vector<unsigned char>& in,
+                          std::vector<unsigned char>& out){
+  const std::size_t n = in.size();
+  const std::size_t window = 65535;
+  std::vector<std::int64_t> table(1 << 16, -1);
+  out.clear();
+  out.reserve(n / 2 + 16);
+  std::size_t anchor = 0;
+  std::size_t i = 0;
+  std::uint32_t seq = 0;
+  while((i + 4) <= n){
+    std::memcpy(&seq, &in[i], 4);
+    std::uint32_t h = (seq * 2654435761u) >> 16;
+    std::int64_t cand = table[h];
+    table[h] = i;
+    if((cand >= 0) && ((i - (std::size_t) cand) <= window) &&
+       (std::memcmp(&in[cand], &in[i], 4) == 0)){
+      std::size_t len = 4;
+      while(((i + len) < n) && (in[cand + len] == in[i + len])){
+        len++;
+      }
+      putVarint(i - anchor, out);
+      out.insert(out.end(), in.begin() + anchor, in.begin() + i);
+      putVarint(len - 3, out);
+      putVarint(i - (std::size_t) cand, out);
+      i = i + len;
+      anchor = i;
+    }else{
+      i++;
+    }
+  }
+  putVarint(n - anchor, out);
+  out.insert(out.end(), in.begin() + anchor, in.end());
+  putVarint(0, out);
+}
+
+// Decompresses a stream written by compressBytes
+//
+// @name decompressBytes
+// @param in Vector of bytes containing the compressed stream
+// @param n Int containing the number of decompressed bytes
+// @param out Vector of bytes containing the decompressed bytes
+// @returns success Boolean indicating if the stream was valid
+inline bool decompressBytes(const std::vector<unsigned char>& in,
+                            const std::size_t n,
+                            std::vector<unsigned char>& out){
+  out.resize(n);
+  std::size_t pos = 0;
+  std::size_t o = 0;
+  std::uint64_t n_lit = 0;
+  std::uint64_t len = 0;
+  std::uint64_t offset = 0;
+  while(true){
+    if(!getVarint(in, pos, n_lit) || (n_lit > (n - o)) ||
+       (n_lit > (in.size() - pos))){
+      return false;
+    }
+    std::copy(in.begin() + pos, in.begin() + pos + n_lit, out.begin() + o);
+    o = o + n_lit;
+    pos = pos + n_lit;
+    if(!getVarint(in, pos, len)){
+      return false;
+    }
+    if(len == 0){
+      return o == n;
+    }
+    len = len + 3;
+    if(!getVarint(in, pos, offset) || (offset == 0) || (offset > o) ||
+       (len > (n - o))){
+      return false;
+    }
+    // byte by byte, since the match can overlap the bytes being written
+    for(std::uint64_t j = 0; j < len; j++){
+      out[o + j] = out[o - offset + j];
+    }
+    o = o + len;
+  }
+}
+
+// Rounds a double to the nearest half precision value (ties to even)
+//
+// @name doubleToHalf
+// @param x Double
+// @returns h Half precision value (bits)
+inline std::uint16_t doubleToHalf(const double x){
+  float f = (float) x;
+  std::uint32_t bits = 0;
+  std::memcpy(&bits, &f, 4);
+  std::uint32_t sign = (bits >> 16) & 0x8000;
+  std::int32_t exponent = (std::int32_t) ((bits >> 23) & 0xff) - 127 + 15;
+  std::uint32_t mantissa = bits & 0x7fffff;
+  if(((bits >> 23) & 0xff) == 0xff){
+    return (std::uint16_t) (sign | 0x7c00 | ((mantissa != 0) ? 0x200 : 0));
+  }
+  if(exponent >= 31){
+    return (std::uint16_t) (sign | 0x7c00);
+  }
+  if(exponent <= 0){
+    // subnormal half precision value
+    if(exponent < -10){
+      return (std::uint16_t) sign;
+    }
+    mantissa = mantissa | 0x800000;
+    std::uint32_t shift = 14 - exponent;
+    std::uint32_t h = mantissa >> shift;
+    std::uint32_t rem = mantissa & ((1u << shift) - 1);
+    std::uint32_t halfway = 1u << (shift - 1);
+    if((rem > halfway) || ((rem == halfway) && ((h & 1) != 0))){
+      h++;
+    }
+    return (std::uint16_t) (sign | h);
+  }
+  std::uint32_t h = ((std::uint32_t) exponent << 10) | (mantissa >> 13);
+  std::uint32_t rem = mantissa & 0x1fff;
+  if((rem > 0x1000) || ((rem == 0x1000) && ((h & 1) != 0))){
+    // a carry into the exponent gives the correctly rounded value
+    h++;
+  }
+  return (std::uint16_t) (sign | h);
+}
+
+// Converts a half precision value to a double
+//
+// @name halfToDouble
+// @param h Half precision value (bits)
+// @returns x Double
+inline double halfToDouble(const std::uint16_t h){
+  double sign = ((h & 0x8000) != 0) ? -1 : 1;
+  int exponent = (h >> 10) & 0x1f;
+  int mantissa = h & 0x3ff;
+  if(exponent == 0){
+    return sign * std::ldexp((double) mantissa, -24);
+  }
+  if(exponent == 31){
+    if(mantissa != 0){
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    return sign * std::numeric_limits<double>::infinity();
+  }
+  return sign * std::ldexp((double) (mantissa + 1024), exponent - 25);
+}
+
+// Shuffles and compresses elements of a given width and appends the stream
+// (compressed size followed by the compressed bytes) to the output
+//
+// @name appendCompressed
+// @param in Pointer to the elements
+// @param n_elem Int containing the number of elements
+// @param width Int containing the number of bytes per element
+// @param out Vector of bytes where the stream is appended
+inline void appendCompressed(const unsigned char* in,
+                             const std::size_t n_elem,
+                             const std::size_t width,
+                             std::vector<unsigned char>& out){
+  std::vector<unsigned char> shuffled;
+  std::vector<unsigned char> compressed;
+  shuffleBytes(in, n_elem, width, shuffled);
+  compressBytes(shuffled, compressed);
+  putVarint(compressed.size(), out);
+  out.insert(out.end(), compressed.begin(), compressed.end());
+}
+
+// Reads a stream written by appendCompressed
+//
+// @name readCompressed
+// @param in Vector of bytes
+// @param pos Position of the stream in the vector (moved past the stream)
+// @param n_elem Int containing the number of elements
+// @param width Int containing the number of bytes per element
+// @param out Pointer to the elements
+// @returns success Boolean indicating if the stream was valid
+inline bool readCompressed(const std::vector<unsigned char>& in,
+                           std::size_t& pos,
+                           const std::size_t n_elem,
+                           const std::size_t width,
+                           unsigned char* out){
+  std::uint64_t n_bytes = 0;
+  if(!getVarint(in, pos, n_bytes) || (n_bytes > (in.size() - pos))){
+    return false;
+  }
+  std::vector<unsigned char> compressed(in.begin() + pos,
+                                        in.begin() + pos + n_bytes);
+  pos = pos + n_bytes;
+  std::vector<unsigned char> shuffled;
+  if(!decompressBytes(compressed, n_elem * width, shuffled)){
+    return false;
+  }
+  unshuffleBytes(shuffled, n_elem, width, out);
+  return true;
+}
+
+// Encodes the values of a file with a codec, falling back to the lossless
+// codec when the values cannot be represented by a lossy codec
+//
+// @name encodeSampleValues
+// @param x Pointer to the values
+// @param n_elem Int containing the number of values
+// @param codec SampleCodec
+// @param out Vector of bytes where the codec used and the encoded values are appended
+inline void encodeSampleValues(const double* x,
+                               const std::size_t n_elem,
+                               const SampleCodec& codec,
+                               std::vector<unsigned char>& out){
+  int method = codec.method;
+  double x_min = 0;
+  double x_max = 0;
+  bool finite = true;
+  for(std::size_t i = 0; i < n_elem; i++){
+    finite = finite && std::isfinite(x[i]);
+    x_min = (i == 0) ? x[i] : std::min(x_min, x[i]);
+    x_max = (i == 0) ? x[i] : std::max(x_max, x[i]);
+  }
+  if((method == SAMPLE_CODEC_FLOAT16) &&
+     (!finite || (std::max(std::abs(x_min), std::abs(x_max)) > 65504))){
+    method = SAMPLE_CODEC_LOSSLESS;
+  }
+  if((method == SAMPLE_CODEC_QUANTIZED) &&
+     (!finite || (((x_max - x_min) / (2 * codec.tol)) > 4294967294.0))){
+    method = SAMPLE_CODEC_LOSSLESS;
+  }
+
+  out.push_back((unsigned char) method);
+  if(method == SAMPLE_CODEC_FLOAT16){
+    std::vector<std::uint16_t> h(n_elem);
+    for(std::size_t i = 0; i < n_elem; i++){
+      h[i] = doubleToHalf(x[i]);
+    }
+    appendCompressed((const unsigned char*) h.data(), n_elem, 2, out);
+  }else if(method == SAMPLE_CODEC_QUANTIZED){
+    double step = 2 * codec.tol;
+    const unsigned char* b_min = (const unsigned char*) &x_min;
+    const unsigned char* b_step = (const unsigned char*) &step;
+    out.insert(out.end(), b_min, b_min + sizeof(double));
+    out.insert(out.end(), b_step, b_step + sizeof(double));
+    std::vector<std::uint32_t> q(n_elem);
+    for(std::size_t i = 0; i < n_elem; i++){
+      q[i] = (std::uint32_t) std::floor(((x[i] - x_min) / step) + 0.5);
+    }
+    appendCompressed((const unsigned char*) q.data(), n_elem, 4, out);
+  }else{
+    appendCompressed((const unsigned char*) x, n_elem, sizeof(double), out);
+  }
+}
+
+// Decodes values written by encodeSampleValues
+//
+// @name decodeSampleValues
+// @param in Vector of bytes
+// @param pos Position of the values in the vector (moved past the values)
+// @param n_elem Int containing the number of values
+// @param x Pointer to the values
+// @returns success Boolean indicating if the values were decoded
+inline bool decodeSampleValues(const std::vector<unsigned char>& in,
+                               std::size_t& pos,
+                               const std::size_t n_elem,
+                               double* x){
+  if(pos >= in.size()){
+    return false;
+  }
+  int method = in[pos];
+  pos++;
+  if(method == SAMPLE_CODEC_FLOAT16){
+    std::vector<std::uint16_t> h(n_elem);
+    if(!readCompressed(in, pos, n_elem, 2, (unsigned char*) h.data())){
+      return false;
+    }
+    for(std::size_t i = 0; i < n_elem; i++){
+      x[i] = halfToDouble(h[i]);
+    }
+    return true;
+  }
+  if(method == SAMPLE_CODEC_QUANTIZED){
+    double x_min = 0;
+    double step = 0;
+    if((in.size() - pos) < (2 * sizeof(double))){
+      return false;
+    }
+    std::memcpy(&x_min, in.data() + pos, sizeof(double));
+    std::memcpy(&step, in.data() + pos + sizeof(double), sizeof(double));
+    pos = pos + 2 * sizeof(double);
+    std::vector<std::uint32_t> q(n_elem);
+    if(!readCompressed(in, pos, n_elem, 4, (unsigned char*) q.data())){
+      return false;
+    }
+    for(std::size_t i = 0; i < n_elem; i++){
+      x[i] = x_min + step * q[i];
+    }
+    return true;
+  }
+  if(method == SAMPLE_CODEC_LOSSLESS){
+    return readCompressed(in, pos, n_elem, sizeof(double), (unsigned char*) x);
+  }
+  return false;
+}
+
+// Writes the header of a file written with a codec
+//
+// @name encodeSampleHeader
+// @param type Int containing the type of the object (one of the SAMPLE_TYPE_ constants)
+// @param out Vector of bytes where the header is written
+inline void encodeSampleHeader(const std::uint8_t type,
+                               std::vector<unsigned char>& out){
+  out.assign(SAMPLE_CODEC_MAGIC, SAMPLE_CODEC_MAGIC + 8);
+  out.push_back(type);
+}
+
+// Writes a vector of bytes to a file
+//
+// @name writeSampleBytes
+// @param bytes Vector of bytes
+// @param file String containing the path of the file
+// @returns success Boolean indicating if the file was written
+inline bool writeSampleBytes(const std::vector<unsigned char>& bytes,
+                             const std::string& file){
+  std::ofstream f(file, std::ios::binary | std::ios::trunc);
+  f.write((const char*) bytes.data(), bytes.size());
+  return f.good();
+}
+
+// Reads a file written with a codec. Returns false if the file cannot be
+// read or was not written with a codec.
+//
+// @name readSampleBytes
+// @param file String containing the path of the file
+// @param type Int containing the type of the object stored in the file
+// @param bytes Vector of bytes containing the file
+// @param pos Position after the header of the file
+// @returns success Boolean indicating if the file was written with a codec
+inline bool readSampleBytes(const std::string& file,
+                            std::uint8_t& type,
+                            std::vector<unsigned char>& bytes,
+                            std::size_t& pos){
+  std::ifstream f(file, std::ios::binary);
+  char magic[8];
+  if(!f.read(magic, 8) || (std::memcmp(magic, SAMPLE_CODEC_MAGIC, 8) != 0)){
+    return false;
+  }
+  bytes.assign(std::istreambuf_iterator<char>(f),
+               std::istreambuf_iterator<char>());
+  if(bytes.empty()){
+    return false;
+  }
+  type = bytes[0];
+  pos = 1;
+  return true;
+}
+
+// Checks if a file was written with a codec (other than arma_ascii)
+//
+// @name isCodecFile
+// @param file String containing the path of the file
+// @returns encoded Boolean indicating if the file starts with the codec header
+inline bool isCodecFile(const std::string& file){
+  std::ifstream f(file, std::ios::binary);
+  char magic[8];
+  return f.read(magic, 8) && (std::memcmp(magic, SAMPLE_CODEC_MAGIC, 8) == 0);
+}
+
+// Parses a matrix or cube saved by Armadillo in its text format (header
+// ARMA_MAT_TXT_FN008 or ARMA_CUB_TXT_FN008). Each row of a slice is stored on
+// one line, so the values are transposed into column-major order. Returns
+// false if the file is missing or has another format, without printing
+// warnings, so it can be called from multiple threads.
+//
+// @name parseArmaText
+// @param file String containing the path of the file
+// @param header String containing the expected header
+// @param dim Vector containing the number of rows, columns and slices
+// @param values Vector containing the values in column-major order
+// @returns success Boolean indicating if the file was parsed
+inline bool parseArmaText(const std::string& file,
+                          const std::string& header,
+                          std::vector<arma::uword>& dim,
+                          std::vector<double>& values){
+  std::ifstream f(file, std::ios::binary);
+  if(!f.good()){
+    return false;
+  }
+  std::string text((std::istreambuf_iterator<char>(f)),
+                   std::istreambuf_iterator<char>());
+  if(text.compare(0, header.size(), header) != 0){
+    return false;
+  }
+  const char* ptr = text.c_str() + header.size();
+  char* end = nullptr;
+  for(std::size_t d = 0; d < dim.size(); d++){
+    long n = std::strtol(ptr, &end, 10);
+    if((end == ptr) || (n < 0)){
+      return false;
+    }
+    dim[d] = n;
+    ptr = end;
+  }
+  arma::uword n_slice = dim[0] * dim[1];
+  arma::uword n_slices = (dim.size() == 3) ? dim[2] : 1;
+  values.resize(n_slice * n_slices);
+  for(arma::uword s = 0; s < n_slices; s++){
+    for(arma::uword i = 0; i < dim[0]; i++){
+      for(arma::uword j = 0; j < dim[1]; j++){
+        double x = std::strtod(ptr, &end);
+        if(end == ptr){
+          return false;
+        }
+        values[(s * n_slice) + (j * dim[0]) + i] = x;
+        ptr = end;
+      }
+    }
+  }
+  return true;
+}
+
+// Loads a cube saved by Armadillo in its text format
+//
+// @name loadArmaText
+// @param x Cube where the values are loaded
+// @param file String containing the path of the file
+// @returns success Boolean indicating if the file was parsed
+inline bool loadArmaText(arma::cube& x,
+                         const std::string& file){
+  std::vector<arma::uword> dim(3);
+  std::vector<double> values;
+  if(!parseArmaText(file, "ARMA_CUB_TXT_FN008", dim, values)){
+    return false;
+  }
+  x.set_size(dim[0], dim[1], dim[2]);
+  std::copy(values.begin(), values.end(), x.memptr());
+  return true;
+}
+
+// Loads a matrix saved by Armadillo in its text format
+//
+// @name loadArmaText
+inline bool loadArmaText(arma::mat& x,
+                         const std::string& file){
+  std::vector<arma::uword> dim(2);
+  std::vector<double> values;
+  if(!parseArmaText(file, "ARMA_MAT_TXT_FN008", dim, values)){
+    return false;
+  }
+  x.set_size(dim[0], dim[1]);
+  std::copy(values.begin(), values.end(), x.memptr());
+  return true;
+}
+
+// Loads a vector saved by Armadillo in its text format (as a matrix with one
+// column or one row)
+//
+// @name loadArmaText
+inline bool loadArmaText(arma::vec& x,
+                         const std::string& file){
+  std::vector<arma::uword> dim(2);
+  std::vector<double> values;
+  if(!parseArmaText(file, "ARMA_MAT_TXT_FN008", dim, values) ||
+     ((dim[0] != 1) && (dim[1] != 1))){
+    return false;
+  }
+  x.set_size(values.size());
+  std::copy(values.begin(), values.end(), x.memptr());
+  return true;
+}
+
+// Saves a cube of posterior draws with a storage codec
+//
+// @name saveSamples
+// @param x Cube containing the draws
+// @param file String containing the path of the file
+// @param codec SampleCodec
+// @returns success Boolean indicating if the file was written
+inline bool saveSamples(const arma::cube& x,
+                        const std::string& file,
+                        const SampleCodec& codec){
+  if(codec.method == SAMPLE_CODEC_ASCII){
+    return x.save(file, arma::arma_ascii);
+  }
+  std::vector<unsigned char> bytes;
+  encodeSampleHeader(SAMPLE_TYPE_CUBE, bytes);
+  putVarint(x.n_rows, bytes);
+  putVarint(x.n_cols, bytes);
+  putVarint(x.n_slices, bytes);
+  encodeSampleValues(x.memptr(), x.n_elem, codec, bytes);
+  return writeSampleBytes(bytes, file);
+}
+
+// Saves a matrix of posterior draws with a storage codec
+//
+// @name saveSamples
+inline bool saveSamples(const arma::mat& x,
+                        const std::string& file,
+                        const SampleCodec& codec){
+  if(codec.method == SAMPLE_CODEC_ASCII){
+    return x.save(file, arma::arma_ascii);
+  }
+  std::vector<unsigned char> bytes;
+  encodeSampleHeader(SAMPLE_TYPE_MAT, bytes);
+  putVarint(x.n_rows, bytes);
+  putVarint(x.n_cols, bytes);
+  encodeSampleValues(x.memptr(), x.n_elem, codec, bytes);
+  return writeSampleBytes(bytes, file);
+}
+
+// Saves a vector of posterior draws with a storage codec
+//
+// @name saveSamples
+inline bool saveSamples(const arma::vec& x,
+                        const std::string& file,
+                        const SampleCodec& codec){
+  if(codec.method == SAMPLE_CODEC_ASCII){
+    return x.save(file, arma::arma_ascii);
+  }
+  std::vector<unsigned char> bytes;
+  encodeSampleHeader(SAMPLE_TYPE_VEC, bytes);
+  putVarint(x.n_elem, bytes);
+  encodeSampleValues(x.memptr(), x.n_elem, codec, bytes);
+  return writeSampleBytes(bytes, file);
+}
+
+// Saves a field of cubes of posterior draws with a storage codec (the values
+// of all cubes are encoded together)
+//
+// @name saveSamples
+inline bool saveSamples(const arma::field<arma::cube>& x,
+                        const std::string& file,
+                        const SampleCodec& codec){
+  if(codec.method == SAMPLE_CODEC_ASCII){
+    return x.save(file);
+  }
+  std::vector<unsigned char> bytes;
+  encodeSampleHeader(SAMPLE_TYPE_FIELD_CUBE, bytes);
+  putVarint(x.n_rows, bytes);
+  putVarint(x.n_cols, bytes);
+  arma::uword n_elem = 0;
+  for(arma::uword j = 0; j < x.n_elem; j++){
+    putVarint(x(j).n_rows, bytes);
+    putVarint(x(j).n_cols, bytes);
+    putVarint(x(j).n_slices, bytes);
+    n_elem = n_elem + x(j).n_elem;
+  }
+  std::vector<double> values(n_elem);
+  arma::uword k = 0;
+  for(arma::uword j = 0; j < x.n_elem; j++){
+    std::memcpy(values.data() + k, x(j).memptr(), x(j).n_elem * sizeof(double));
+    k = k + x(j).n_elem;
+  }
+  encodeSampleValues(values.data(), n_elem, codec, bytes);
+  return writeSampleBytes(bytes, file);
+}
+
+// Loads a cube of posterior draws saved by saveSamples or by Armadillo (files
+// in the Armadillo text format are parsed directly)
+//
+// @name loadSamples
+// @param x Cube where the draws are loaded
+// @param file String containing the path of the file
+// @returns success Boolean indicating if the file was loaded
+inline bool loadSamples(arma::cube& x,
+                        const std::string& file){
+  std::uint8_t type = 0;
+  std::vector<unsigned char> bytes;
+  std::size_t pos = 0;
+  if(!readSampleBytes(file, type, bytes, pos)){
+    return loadArmaText(x, file) || x.load(file);
+  }
+  std::uint64_t dim[3];
+  if((type != SAMPLE_TYPE_CUBE) || !getVarint(bytes, pos, dim[0]) ||
+     !getVarint(bytes, pos, dim[1]) || !getVarint(bytes, pos, dim[2])){
+    return false;
+  }
+  x.set_size(dim[0], dim[1], dim[2]);
+  return decodeSampleValues(bytes, pos, x.n_elem, x.memptr());
+}
+
+// Loads a matrix of posterior draws saved by saveSamples or by Armadillo
+//
+// @name loadSamples
+inline bool loadSamples(arma::mat& x,
+                        const std::string& file){
+  std::uint8_t type = 0;
+  std::vector<unsigned char> bytes;
+  std::size_t pos = 0;
+  if(!readSampleBytes(file, type, bytes, pos)){
+    return loadArmaText(x, file) || x.load(file);
+  }
+  std::uint64_t dim[2];
+  if((type != SAMPLE_TYPE_MAT) || !getVarint(bytes, pos, dim[0]) ||
+     !getVarint(bytes, pos, dim[1])){
+    return false;
+  }
+  x.set_size(dim[0], dim[1]);
+  return decodeSampleValues(bytes, pos, x.n_elem, x.memptr());
+}
+
+// Loads a vector of posterior draws saved by saveSamples or by Armadillo
+//
+// @name loadSamples
+inline bool loadSamples(arma::vec& x,
+                        const std::string& file){
+  std::uint8_t type = 0;
+  std::vector<unsigned char> bytes;
+  std::size_t pos = 0;
+  if(!readSampleBytes(file, type, bytes, pos)){
+    return loadArmaText(x, file) || x.load(file);
+  }
+  std::uint64_t n_elem = 0;
+  if((type != SAMPLE_TYPE_VEC) || !getVarint(bytes, pos, n_elem)){
+    return false;
+  }
+  x.set_size(n_elem);
+  return decodeSampleValues(bytes, pos, x.n_elem, x.memptr());
+}
+
+// Loads a field of cubes of posterior draws saved by saveSamples or by
+// Armadillo
+//
+// @name loadSamples
+inline bool loadSamples(arma::field<arma::cube>& x,
+                        const std::string& file){
+  std::uint8_t type = 0;
+  std::vector<unsigned char> bytes;
+  std::size_t pos = 0;
+  if(!readSampleBytes(file, type, bytes, pos)){
+    return x.load(file);
+  }
+  std::uint64_t dim[3];
+  if((type != SAMPLE_TYPE_FIELD_CUBE) || !getVarint(bytes, pos, dim[0]) ||
+     !getVarint(bytes, pos, dim[1])){
+    return false;
+  }
+  x.set_size(dim[0], dim[1]);
+  arma::uword n_elem = 0;
+  for(arma::uword j = 0; j < x.n_elem; j++){
+    if(!getVarint(bytes, pos, dim[0]) || !getVarint(bytes, pos, dim[1]) ||
+       !getVarint(bytes, pos, dim[2])){
+      return false;
+    }
+    x(j).set_size(dim[0], dim[1], dim[2]);
+    n_elem = n_elem + x(j).n_elem;
+  }
+  std::vector<double> values(n_elem);
+  if(!decodeSampleValues(bytes, pos, n_elem, values.data())){
+    return false;
+  }
+  arma::uword k = 0;
+  for(arma::uword j = 0; j < x.n_elem; j++){
+    std::memcpy(x(j).memptr(), values.data() + k, x(j).n_elem * sizeof(double));
+    k = k + x(j).n_elem;
+  }
+  return true;
+}
+}
+
+#endif
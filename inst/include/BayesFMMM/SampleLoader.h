@@ -0,0 +1,316 @@
+#ifndef BayesFMMM_SAMPLE_LOADER_H
+#define BayesFMMM_SAMPLE_LOADER_H
+
+#include <RcppArmadillo.h>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "SampleCodec.h"
+
+namespace BayesFMMM{
+// Gets the path of the ith file of a parameter saved by the samplers
+//
+// @name sampleFileName
+// @param dir String containing the directory where the MCMC files are located
+// @param name String containing the name of the parameter (file prefix)
+// @param i Int containing the index of the file
+// @returns file String containing the path of the file
+inline std::string sampleFileName(const std::string& dir,
+                                  const std::string& name,
+                                  const int i){
+  return dir + name + std::to_string(i) + ".txt";
+}
+
+// Counts the files of a parameter saved by the samplers (the number of
+// consecutive files starting from file 0)
+//
+// @name countSampleFiles
+// @param dir String containing the directory where the MCMC files are located
+// @param name String containing the name of the parameter (file prefix)
+// @returns n_files Int containing the number of files
+inline int countSampleFiles(const std::string& dir,
+                            const std::string& name){
+  int n_files = 0;
+  while(std::ifstream(sampleFileName(dir, name, n_files)).good()){
+    n_files++;
+  }
+  return n_files;
+}
+
+// Reads the files of a parameter concurrently (one file per thread). Any
+// format read by loadSamples can be used, and the files do not need to
+// contain the same number of MCMC samples.
+//
+// @name loadSampleFiles
+// @param dir String containing the directory where the MCMC files are located
+// @param name String containing the name of the parameter (file prefix)
+// @param n_files Int containing the number of files per parameter
+// @param parts Vector containing the content of each file
+template <typename T>
+inline void loadSampleFiles(const std::string& dir,
+                            const std::string& name,
+                            const int n_files,
+                            std::vector<T>& parts){
+  if(n_files < 1){
+    Rcpp::stop("'n_files' must be greater than 0");
+  }
+  std::vector<std::string> files(n_files);
+  for(int i = 0; i < n_files; i++){
+    files[i] = sampleFileName(dir, name, i);
+    if(!std::ifstream(files[i]).good()){
+      Rcpp::stop("unable to open '" + files[i] + "'");
+    }
+  }
+  parts.resize(n_files);
+  std::vector<int> loaded(n_files, 0);
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < n_files; i++){
+    loaded[i] = loadSamples(parts[i], files[i]);
+  }
+  for(int i = 0; i < n_files; i++){
+    if(loaded[i] == 0){
+      Rcpp::stop("unable to read '" + files[i] + "'");
+    }
+  }
+}
+
+// Reads the batches of a cube-valued parameter saved by the samplers
+// (e.g. Nu0.txt, Nu1.txt, ...) concurrently and stacks them along the slices
+//
+// @name loadCubeSamples
+// @param dir String containing the directory where the MCMC files are located
+// @param name String containing the name of the parameter (file prefix)
+// @param n_files Int containing the number of files per parameter
+// @returns samp Cube containing all MCMC samples
+inline arma::cube loadCubeSamples(const std::string& dir,
+                                  const std::string& name,
+                                  const int n_files){
+  std::vector<arma::cube> parts;
+  loadSampleFiles(dir, name, n_files, parts);
+  std::vector<arma::uword> offset(n_files + 1, 0);
+  for(int i = 0; i < n_files; i++){
+    if((parts[i].n_rows != parts[0].n_rows) || (parts[i].n_cols != parts[0].n_cols)){
+      Rcpp::stop("the files of '" + name + "' do not have the same dimensions");
+    }
+    offset[i + 1] = offset[i] + parts[i].n_slices;
+  }
+  arma::cube samp(parts[0].n_rows, parts[0].n_cols, offset[n_files]);
+  #pragma omp parallel for schedule(static)
+  for(int i = 0; i < n_files; i++){
+    if(parts[i].n_elem > 0){
+      std::memcpy(samp.slice_memptr(offset[i]), parts[i].memptr(),
+                  parts[i].n_elem * sizeof(double));
+    }
+  }
+  return samp;
+}
+
+// Reads the batches of a vector-valued parameter saved by the samplers
+// concurrently
+//
+// @name loadVecSamples
+// @param dir String containing the directory where the MCMC files are located
+// @param name String containing the name of the parameter (file prefix)
+// @param n_files Int containing the number of files per parameter
+// @returns samp Vector containing all MCMC samples
+inline arma::vec loadVecSamples(const std::string& dir,
+                                const std::string& name,
+                                const int n_files){
+  std::vector<arma::vec> parts;
+  loadSampleFiles(dir, name, n_files, parts);
+  std::vector<arma::uword> offset(n_files + 1, 0);
+  for(int i = 0; i < n_files; i++){
+    offset[i + 1] = offset[i] + parts[i].n_elem;
+  }
+  arma::vec samp(offset[n_files]);
+  for(int i = 0; i < n_files; i++){
+    if(parts[i].n_elem > 0){
+      std::memcpy(samp.memptr() + offset[i], parts[i].memptr(),
+                  parts[i].n_elem * sizeof(double));
+    }
+  }
+  return samp;
+}
+
+// Reads the batches of a matrix-valued parameter saved with one column per
+// MCMC sample (e.g. Pi0.txt, Pi1.txt, ...) concurrently and stacks them along
+// the columns
+//
+// @name loadMatSamples
+// @param dir String containing the directory where the MCMC files are located
+// @param name String containing the name of the parameter (file prefix)
+// @param n_files Int containing the number of files per parameter
+// @returns samp Matrix containing all MCMC samples
+inline arma::mat loadMatSamples(const std::string& dir,
+                                const std::string& name,
+                                const int n_files){
+  std::vector<arma::mat> parts;
+  loadSampleFiles(dir, name, n_files, parts);
+  std::vector<arma::uword> offset(n_files + 1, 0);
+  for(int i = 0; i < n_files; i++){
+    if(parts[i].n_rows != parts[0].n_rows){
+      Rcpp::stop("the files of '" + name + "' do not have the same dimensions");
+    }
+    offset[i + 1] = offset[i] + parts[i].n_cols;
+  }
+  arma::mat samp(parts[0].n_rows, offset[n_files]);
+  for(int i = 0; i < n_files; i++){
+    if(parts[i].n_elem > 0){
+      std::memcpy(samp.colptr(offset[i]), parts[i].memptr(),
+                  parts[i].n_elem * sizeof(double));
+    }
+  }
+  return samp;
+}
+
+// Stacks the MCMC samples of the files of a field-valued parameter, keeping
+// the first n_samp rows (MCMC samples) of each file
+//
+// @name stackFieldSamples
+// @param parts Vector containing the content of each file
+// @param name String containing the name of the parameter (file prefix)
+// @param n_samp Int containing the number of MCMC samples kept per file
+// @returns samp Field of cubes containing all MCMC samples
+inline arma::field<arma::cube> stackFieldSamples(const std::vector<arma::field<arma::cube> >& parts,
+                                                 const std::string& name,
+                                                 const int n_samp){
+  int n_files = parts.size();
+  for(int i = 0; i < n_files; i++){
+    if((parts[i].n_rows < (arma::uword) n_samp) ||
+       (parts[i].n_cols != parts[0].n_cols)){
+      Rcpp::stop("the files of '" + name + "' do not have the same dimensions");
+    }
+  }
+  arma::field<arma::cube> samp(n_samp * n_files, parts[0].n_cols);
+  #pragma omp parallel for schedule(static)
+  for(int i = 0; i < n_files; i++){
+    for(int j = 0; j < n_samp; j++){
+      for(arma::uword k = 0; k < samp.n_cols; k++){
+        samp((i * n_samp) + j, k) = parts[i](j,k);
+      }
+    }
+  }
+  return samp;
+}
+
+// Reads the batches of a field-valued parameter saved by the samplers
+// concurrently, keeping the first n_samp rows (MCMC samples) of each file
+//
+// @name loadFieldSamples
+// @param dir String containing the directory where the MCMC files are located
+// @param name String containing the name of the parameter (file prefix)
+// @param n_files Int containing the number of files per parameter
+// @param n_samp Int containing the number of MCMC samples kept per file
+// @returns samp Field of cubes containing all MCMC samples
+inline arma::field<arma::cube> loadFieldSamples(const std::string& dir,
+                                                const std::string& name,
+                                                const int n_files,
+                                                const int n_samp){
+  std::vector<arma::field<arma::cube> > parts;
+  loadSampleFiles(dir, name, n_files, parts);
+  return stackFieldSamples(parts, name, n_samp);
+}
+
+// Reads the batches of a field-valued parameter saved by the samplers
+// concurrently
+//
+// @name loadFieldSamples
+inline arma::field<arma::cube> loadFieldSamples(const std::string& dir,
+                                                const std::string& name,
+                                                const int n_files){
+  std::vector<arma::field<arma::cube> > parts;
+  loadSampleFiles(dir, name, n_files, parts);
+  return stackFieldSamples(parts, name, parts[0].n_rows);
+}
+
+// Gets the type of object in which a parameter is saved by the samplers
+//
+// @name sampleFileType
+// @param name String containing the name of the parameter (file prefix)
+// @returns type Int containing the type (one of the SAMPLE_TYPE_ constants)
+inline std::uint8_t sampleFileType(const std::string& name){
+  if((name == "Sigma") || (name == "alpha_3")){
+    return SAMPLE_TYPE_VEC;
+  }
+  if((name == "Pi") || (name == "Tau")){
+    return SAMPLE_TYPE_MAT;
+  }
+  if((name == "Phi") || (name == "Gamma") || (name == "Eta") ||
+     (name == "Xi") || (name == "GammaXi") || (name == "DeltaXi") ||
+     (name == "AXi")){
+    return SAMPLE_TYPE_FIELD_CUBE;
+  }
+  return SAMPLE_TYPE_CUBE;
+}
+
+// Reads a file of a parameter and writes it with a storage codec
+//
+// @name convertSampleFile
+// @param in_file String containing the path of the file that is read
+// @param out_file String containing the path of the file that is written
+// @param type Int containing the type of object stored in the file
+// @param codec SampleCodec used to write the file
+// @returns success Boolean indicating if the file was converted
+inline bool convertSampleFile(const std::string& in_file,
+                              const std::string& out_file,
+                              const std::uint8_t type,
+                              const SampleCodec& codec){
+  if(type == SAMPLE_TYPE_VEC){
+    arma::vec x;
+    return loadSamples(x, in_file) && saveSamples(x, out_file, codec);
+  }
+  if(type == SAMPLE_TYPE_MAT){
+    arma::mat x;
+    return loadSamples(x, in_file) && saveSamples(x, out_file, codec);
+  }
+  if(type == SAMPLE_TYPE_FIELD_CUBE){
+    arma::field<arma::cube> x;
+    return loadSamples(x, in_file) && saveSamples(x, out_file, codec);
+  }
+  arma::cube x;
+  return loadSamples(x, in_file) && saveSamples(x, out_file, codec);
+}
+
+// Converts every file of a results directory to a storage codec. The files
+// of all parameters are converted concurrently, and out_dir can be the same
+// directory as dir (each file is read completely before it is overwritten).
+//
+// @name convertSampleDirectory
+// @param dir String containing the directory where the MCMC files are located
+// @param out_dir String containing the directory where the converted files are written
+// @param params Vector containing the file prefixes of the parameters
+// @param codec SampleCodec used to write the files
+// @returns n_files Vector containing the number of files converted for each parameter
+inline arma::uvec convertSampleDirectory(const std::string& dir,
+                                         const std::string& out_dir,
+                                         const std::vector<std::string>& params,
+                                         const SampleCodec& codec){
+  arma::uvec n_files(params.size());
+  std::vector<std::string> in_files;
+  std::vector<std::string> out_files;
+  std::vector<std::uint8_t> types;
+  for(std::size_t j = 0; j < params.size(); j++){
+    n_files(j) = countSampleFiles(dir, params[j]);
+    for(arma::uword i = 0; i < n_files(j); i++){
+      in_files.push_back(sampleFileName(dir, params[j], i));
+      out_files.push_back(sampleFileName(out_dir, params[j], i));
+      types.push_back(sampleFileType(params[j]));
+    }
+  }
+  int n_total = in_files.size();
+  std::vector<int> converted(n_total, 0);
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < n_total; i++){
+    converted[i] = convertSampleFile(in_files[i], out_files[i], types[i], codec);
+  }
+  for(int i = 0; i < n_total; i++){
+    if(converted[i] == 0){
+      Rcpp::stop("unable to convert '" + in_files[i] + "'");
+    }
+  }
+  return n_files;
+}
+}
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef BayesFMMM_SAMPLER_CONTROL_H
+#define BayesFMMM_SAMPLER_CONTROL_H
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "SampleCodec.h"
+
+namespace BayesFMMM{
+// Options of the samplers that do not change the model (online summaries,
+// adaptation, how the sweep is run and how the draws and observations are
+// stored). The R functions take them as one named list (control), which is
+// parsed once before the chain is started. Options that are not in the list
+// (or are NULL) keep their default values.
+//
+// @name SamplerControl
+// @field summary_time Vector containing the time points of the online summaries (empty if no summaries are computed)
+// @field summary_probs Vector containing the probabilities of the pointwise quantiles of the online summaries
+// @field summary_burnin Int containing number of MCMC iterations discarded before updating the online summaries
+// @field n_adapt Int containing number of MCMC iterations during which the proposal scales are adapted
+// @field n_adapt_ladder Int containing number of MCMC iterations during which the temperature ladder is respaced
+// @field n_leapfrog_Z Int containing the number of leapfrog steps of the updates of Z (0 for the random walk)
+// @field step_Z Double containing the leapfrog step size of the updates of Z
+// @field parallel_sweep Boolean indicating whether independent blocks of the sweep are updated concurrently
+// @field single_precision Boolean indicating whether the observations are stored in single precision
+// @field retain Named vector containing the thinning of each retained parameter (NULL if every parameter is retained)
+// @field codec SampleCodec used to write the retained parameters
+// @field data_file String containing the path of the observation store (empty if the observations are passed from R)
+// @field compress_obs Boolean indicating whether the observations are replaced by their sufficient statistics
+// @field sg_batch_size Int containing the number of functions in each minibatch of the stochastic gradient sampler (0 for the tempered transitions sampler)
+// @field sg_step Double containing the step size of the stochastic gradient Langevin steps
+// @field sg_n_anchor Int containing how often the control variates of the stochastic gradient sampler are recomputed
+struct SamplerControl{
+  arma::vec summary_time;
+  arma::vec summary_probs;
+  int summary_burnin;
+  int n_adapt;
+  int n_adapt_ladder;
+  int n_leapfrog_Z;
+  double step_Z;
+  bool parallel_sweep;
+  bool single_precision;
+  Rcpp::Nullable<Rcpp::NumericVector> retain;
+  SampleCodec codec;
+  std::string data_file;
+  bool compress_obs;
+  int sg_batch_size;
+  double sg_step;
+  int sg_n_anchor;
+};
+
+// Names of the control options of the samplers that write their draws to
+// disk (BFMMM_CovariateAdj_warm_start, BHDFMMM_warm_start and
+// BMVMMM_warm_start)
+//
+// @name storageControls
+// @returns options Vector containing the names of the options
+inline std::vector<std::string> storageControls(){
+  return std::vector<std::string>{"retain", "codec", "codec_tol"};
+}
+
+// Names of the control options of the tempered transitions sampler of
+// functional data (BFMMM_warm_start_incremental)
+//
+// @name temperedControls
+// @returns options Vector containing the names of the options
+inline std::vector<std::string> temperedControls(){
+  std::vector<std::string> options{"summary_time", "summary_probs",
+                                   "summary_burnin", "n_adapt",
+                                   "n_adapt_ladder", "n_leapfrog_Z", "step_Z",
+                                   "parallel_sweep", "single_precision"};
+  std::vector<std::string> storage = storageControls();
+  options.insert(options.end(), storage.begin(), storage.end());
+  return options;
+}
+
+// Names of the control options of BFMMM_warm_start
+//
+// @name warmStartControls
+// @returns options Vector containing the names of the options
+inline std::vector<std::string> warmStartControls(){
+  std::vector<std::string> options = temperedControls();
+  options.push_back("data_file");
+  options.push_back("compress_obs");
+  options.push_back("sg_batch_size");
+  options.push_back("sg_step");
+  options.push_back("sg_n_anchor");
+  return options;
+}
+
+// Creates the default control options
+//
+// @name makeSamplerControl
+// @returns control SamplerControl
+inline SamplerControl makeSamplerControl(){
+  SamplerControl control;
+  control.summary_probs = {0.025, 0.5, 0.975};
+  control.summary_burnin = 0;
+  control.n_adapt = 0;
+  control.n_adapt_ladder = 0;
+  control.n_leapfrog_Z = 0;
+  control.step_Z = 0.1;
+  control.parallel_sweep = false;
+  control.single_precision = false;
+  control.codec = makeSampleCodec();
+  control.compress_obs = false;
+  control.sg_batch_size = 0;
+  control.sg_step = 0.1;
+  control.sg_n_anchor = 100;
+  return control;
+}
+
+// Creates the control options from a named list. Every name must be one of
+// the options of the sampler, so that misspelled options are not silently
+// ignored.
+//
+// @name makeSamplerControl
+// @param control Named list containing the options that are not left at their default values
+// @param options Vector containing the names of the options of the sampler
+// @returns control SamplerControl
+inline SamplerControl makeSamplerControl(Rcpp::Nullable<Rcpp::List> control,
+                                         const std::vector<std::string>& options){
+  SamplerControl ctrl = makeSamplerControl();
+  if(control.isNull()){
+    return ctrl;
+  }
+  Rcpp::List control_(control);
+  if(control_.size() == 0){
+    return ctrl;
+  }
+  if(Rf_isNull(control_.names())){
+    Rcpp::stop("'control' must be a named list");
+  }
+  Rcpp::CharacterVector names = control_.names();
+  std::string codec = "arma_ascii";
+  double codec_tol = 1e-4;
+  for(int j = 0; j < control_.size(); j++){
+    std::string name = Rcpp::as<std::string>(names[j]);
+    if(std::find(options.begin(), options.end(), name) == options.end()){
+      Rcpp::stop("'" + name + "' is not an option of this sampler and cannot be specified in 'control'");
+    }
+    SEXP value = control_[j];
+    if(Rf_isNull(value)){
+      continue;
+    }
+    if(name == "summary_time"){
+      ctrl.summary_time = Rcpp::as<arma::vec>(value);
+    }else if(name == "summary_probs"){
+      ctrl.summary_probs = Rcpp::as<arma::vec>(value);
+    }else if(name == "summary_burnin"){
+      ctrl.summary_burnin = Rcpp::as<int>(value);
+    }else if(name == "n_adapt"){
+      ctrl.n_adapt = Rcpp::as<int>(value);
+    }else if(name == "n_adapt_ladder"){
+      ctrl.n_adapt_ladder = Rcpp::as<int>(value);
+    }else if(name == "n_leapfrog_Z"){
+      ctrl.n_leapfrog_Z = Rcpp::as<int>(value);
+    }else if(name == "step_Z"){
+      ctrl.step_Z = Rcpp::as<double>(value);
+    }else if(name == "parallel_sweep"){
+      ctrl.parallel_sweep = Rcpp::as<bool>(value);
+    }else if(name == "single_precision"){
+      ctrl.single_precision = Rcpp::as<bool>(value);
+    }else if(name == "retain"){
+      ctrl.retain = Rcpp::Nullable<Rcpp::NumericVector>(value);
+    }else if(name == "codec"){
+      codec = Rcpp::as<std::string>(value);
+    }else if(name == "codec_tol"){
+      codec_tol = Rcpp::as<double>(value);
+    }else if(name == "data_file"){
+      ctrl.data_file = Rcpp::as<std::string>(value);
+    }else if(name == "compress_obs"){
+      ctrl.compress_obs = Rcpp::as<bool>(value);
+    }else if(name == "sg_batch_size"){
+      ctrl.sg_batch_size = Rcpp::as<int>(value);
+    }else if(name == "sg_step"){
+      ctrl.sg_step = Rcpp::as<double>(value);
+    }else if(name == "sg_n_anchor"){
+      ctrl.sg_n_anchor = Rcpp::as<int>(value);
+    }
+  }
+
+  // generate warnings
+  for(arma::uword i = 0; i < ctrl.summary_probs.n_elem; i++){
+    if((ctrl.summary_probs(i) < 0) || (ctrl.summary_probs(i) > 1)){
+      Rcpp::stop("all elements of 'summary_probs' must be between 0 and 1");
+    }
+  }
+  if(ctrl.summary_burnin < 0){
+    Rcpp::stop("'summary_burnin' must be a non-negative integer");
+  }
+  if(ctrl.n_adapt < 0){
+    Rcpp::stop("'n_adapt' must be a non-negative integer");
+  }
+  if(ctrl.n_adapt_ladder < 0){
+    Rcpp::stop("'n_adapt_ladder' must be a non-negative integer");
+  }
+  if(ctrl.n_leapfrog_Z < 0){
+    Rcpp::stop("'n_leapfrog_Z' must be a non-negative integer");
+  }
+  if(ctrl.step_Z <= 0){
+    Rcpp::stop("'step_Z' must be positive");
+  }
+  if(ctrl.sg_batch_size < 0){
+    Rcpp::stop("'sg_batch_size' must be a non-negative integer");
+  }
+  if(ctrl.sg_step <= 0){
+    Rcpp::stop("'sg_step' must be positive");
+  }
+  if(ctrl.sg_n_anchor < 1){
+    Rcpp::stop("'sg_n_anchor' must be a positive integer");
+  }
+  if((ctrl.sg_batch_size > 0) && !ctrl.summary_time.is_empty()){
+    Rcpp::stop("'summary_time' cannot be used with the stochastic gradient sampler ('sg_batch_size' > 0)");
+  }
+  ctrl.codec = makeSampleCodec(codec, codec_tol);
+  return ctrl;
+}
+}
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef BayesFMMM_SPARSE_GAUSSIAN_H
+#define BayesFMMM_SPARSE_GAUSSIAN_H
+
+#include <RcppArmadillo.h>
+#include <cmath>
+#include "RaggedObs.h"
+
+namespace BayesFMMM{
+// Gaussian full conditionals of the form N(Q^{-1} b, Q^{-1}), with
+// Q = s * B_w B_w' + Q_0 and b = s * B_w r, can be sampled without forming
+// Q^{-1} (perturbation-optimization): if e ~ N(0, I) and v ~ N(0, Q_0), the
+// solution of Q x = s * B_w r + sqrt(s) * B_w e + v follows the full
+// conditional. When the tensor B-splines are evaluated at the observed time
+// points, B_w only has (basis_degree + 1)^dim non-zero elements per column,
+// and Q_0 is either diagonal or the sparse P matrix, so Q is sparse and the
+// system can be solved by preconditioned conjugate gradients in
+// O(nnz(Q) * n_iter) operations instead of O(P^3).
+
+// Computes the basis functions of all observations with the columns of the
+// ith function multiplied by w(i)
+//
+// @name weightedBasis
+// @param obs RaggedObs containing observed values and basis functions
+// @param B_sp Sparse matrix containing obs.B_t
+// @param w Vector containing the weight of each function
+// @returns B_w Sparse matrix containing the weighted basis functions
+inline arma::sp_mat weightedBasis(const RaggedObs& obs,
+                                  const arma::sp_mat& B_sp,
+                                  const arma::vec& w){
+  arma::uvec row_indices(B_sp.n_nonzero);
+  arma::uvec col_ptrs(B_sp.n_cols + 1);
+  arma::vec values(B_sp.n_nonzero);
+  for(arma::uword l = 0; l < B_sp.n_nonzero; l++){
+    row_indices(l) = B_sp.row_indices[l];
+  }
+  for(arma::uword t = 0; t <= B_sp.n_cols; t++){
+    col_ptrs(t) = B_sp.col_ptrs[t];
+  }
+  for(arma::uword i = 0; i < obs.n_funct(); i++){
+    for(arma::uword l = B_sp.col_ptrs[obs.offsets(i)];
+        l < B_sp.col_ptrs[obs.offsets(i + 1)]; l++){
+      values(l) = w(i) * B_sp.values[l];
+    }
+  }
+  arma::sp_mat B_w(row_indices, col_ptrs, values, B_sp.n_rows, B_sp.n_cols);
+  return B_w;
+}
+
+// Computes the residuals of the ith function given the basis coefficients of
+// its mean
+//
+// @name sparseResid
+// @param obs RaggedObs containing observed values and basis functions
+// @param B_sp Sparse matrix containing obs.B_t
+// @param i Int containing the function of interest
+// @param coef Vector containing the basis coefficients
+// @param resid Vector containing the residuals of all observations (only the ones of the ith function are modified)
+inline void sparseResid(const RaggedObs& obs,
+                        const arma::sp_mat& B_sp,
+                        const arma::uword i,
+                        const arma::vec& coef,
+                        arma::vec& resid){
+  for(arma::uword t = obs.offsets(i); t < obs.offsets(i + 1); t++){
+    double fit = 0;
+    for(arma::uword l = B_sp.col_ptrs[t]; l < B_sp.col_ptrs[t + 1]; l++){
+      fit = fit + B_sp.values[l] * coef(B_sp.row_indices[l]);
+    }
+    resid(t) = obs.y(t) - fit;
+  }
+}
+
+// Solves Q x = rhs, where Q is a sparse symmetric positive definite matrix,
+// using conjugate gradients with a Jacobi (diagonal) preconditioner
+//
+// @name pcgSolve
+// @param Q Sparse matrix containing the system
+// @param rhs Vector containing the right hand side
+// @param tol Double containing the tolerance on the relative norm of the residual
+// @param max_iter Int containing the maximum number of iterations
+// @param x Vector containing the starting point and acting as a placeholder for the solution
+// @returns n_iter Int containing the number of iterations performed
+inline int pcgSolve(const arma::sp_mat& Q,
+                    const arma::vec& rhs,
+                    const double tol,
+                    const int max_iter,
+                    arma::vec& x){
+  if(x.n_elem != rhs.n_elem){
+    x.zeros(rhs.n_elem);
+  }
+  double rhs_norm = arma::norm(rhs);
+  if(rhs_norm == 0){
+    x.zeros();
+    return 0;
+  }
+  arma::vec prec(Q.n_rows);
+  for(arma::uword l = 0; l < prec.n_elem; l++){
+    prec(l) = (Q(l,l) > 0) ? 1 / Q(l,l) : 1;
+  }
+  arma::vec resid = rhs - Q * x;
+  arma::vec z = prec % resid;
+  arma::vec p = z;
+  arma::vec Q_p;
+  double rz = arma::dot(resid, z);
+  int n_iter = 0;
+  while((n_iter < max_iter) && (arma::norm(resid) > tol * rhs_norm)){
+    Q_p = Q * p;
+    double step = rz / arma::dot(p, Q_p);
+    x += step * p;
+    resid -= step * Q_p;
+    z = prec % resid;
+    double rz_new = arma::dot(resid, z);
+    p = z + (rz_new / rz) * p;
+    rz = rz_new;
+    n_iter++;
+  }
+  return n_iter;
+}
+
+// Draws a sample from N(Q^{-1} b, Q^{-1}), where Q = s * B_w B_w' + Q_0 and
+// b = s * B_w r, by perturbing the data and the prior and solving the
+// resulting system with preconditioned conjugate gradients
+//
+// @name drawGaussianPO
+// @param B_w Sparse matrix containing the weighted basis functions (one column per observation)
+// @param r Vector containing the residuals of all observations
+// @param s Double containing the scale of the likelihood (temperature over variance)
+// @param Q_0 Sparse matrix containing the prior precision
+// @param v Vector containing a draw from N(0, Q_0)
+// @param x Vector containing the current value (used as starting point) and acting as a placeholder for the sample
+// @returns n_iter Int containing the number of conjugate gradient iterations performed
+inline int drawGaussianPO(const arma::sp_mat& B_w,
+                          const arma::vec& r,
+                          const double s,
+                          const arma::sp_mat& Q_0,
+                          const arma::vec& v,
+                          arma::vec& x){
+  arma::vec e(r.n_elem);
+  for(arma::uword t = 0; t < e.n_elem; t++){
+    e(t) = R::norm_rand();
+  }
+  arma::vec rhs = B_w * ((s * r) + (std::sqrt(s) * e));
+  rhs += v;
+  arma::sp_mat Q = s * (B_w * B_w.t());
+  Q += Q_0;
+  return pcgSolve(Q, rhs, 1e-10, 10 * Q.n_rows, x);
+}
+}
+
+#endif
@@ -0,0 +1,531 @@
+#ifndef BayesFMMM_STOCHASTIC_GRADIENT_H
+#define BayesFMMM_STOCHASTIC_GRADIENT_H
+
+#include <RcppArmadillo.h>
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <vector>
+#include "Distributions.h"
+#include "KernelPolicies.h"
+#include "RaggedObs.h"
+#include "UpdateMixedMembership.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace BayesFMMM{
+// State of the stochastic gradient (minibatch) sampler of the mixed
+// membership model. Every iteration only the functions of a minibatch are
+// visited: their Z and chi parameters are updated, and nu and Phi are moved
+// by a preconditioned stochastic gradient Langevin step that uses the anchor
+// (nu_hat, Phi_hat) as a control variate, i.e. the gradient of the
+// log-likelihood is estimated by
+//
+//   grad_hat + (n_funct / n_batch) * sum_{i in batch} (g_i(theta) - g_i(theta_hat)).
+//
+// The sums over all functions at the anchor are kept up to date as the Z and
+// chi parameters of the functions of the minibatches change, so the
+// estimator stays unbiased between two refreshes of the anchor.
+//
+// @name SGState
+// @field batch Vector containing the (sorted) functions of the current minibatch
+// @field nu_hat Matrix containing the nu parameters of the anchor
+// @field Phi_hat Cube containing the Phi parameters of the anchor
+// @field grad_nu_hat Matrix containing sum_i Z_ik B_i'(y_i - B_i coef_i) at the anchor
+// @field grad_Phi_hat Cube containing sum_i Z_ik chi_im B_i'(y_i - B_i coef_i) at the anchor
+// @field rss_hat Double containing the residual sum of squares at the anchor
+// @field prec_nu Matrix containing the diagonal of the precision of nu given by the likelihood (times sigma) at the anchor
+// @field prec_Phi Cube containing the diagonal of the precision of Phi given by the likelihood (times sigma) at the anchor
+// @field log_Z_sum Vector containing sum_i log(Z_ik) for each feature
+// @field rss_est Double containing the last estimate of the residual sum of squares
+// @field n_anchor Int containing the number of times the anchor was set
+struct SGState{
+  arma::uvec batch;
+  arma::mat nu_hat;
+  arma::cube Phi_hat;
+  arma::mat grad_nu_hat;
+  arma::cube grad_Phi_hat;
+  double rss_hat;
+  arma::mat prec_nu;
+  arma::cube prec_Phi;
+  arma::vec log_Z_sum;
+  double rss_est;
+  int n_anchor;
+};
+
+// Creates an empty stochastic gradient state
+//
+// @name makeSGState
+// @param K Int containing the number of features
+// @param P Int containing the number of basis functions
+// @param M Int containing the number of eigenfunctions
+// @returns state SGState
+inline SGState makeSGState(const int K,
+                           const int P,
+                           const int M){
+  SGState state;
+  state.nu_hat = arma::zeros(K, P);
+  state.Phi_hat = arma::zeros(K, P, M);
+  state.grad_nu_hat = arma::zeros(K, P);
+  state.grad_Phi_hat = arma::zeros(K, P, M);
+  state.rss_hat = 0;
+  state.prec_nu = arma::zeros(K, P);
+  state.prec_Phi = arma::zeros(K, P, M);
+  state.log_Z_sum = arma::zeros(K);
+  state.rss_est = 0;
+  state.n_anchor = 0;
+  return state;
+}
+
+// Adds the contribution of the ith function to the gradient of the
+// log-likelihood (times sigma) with respect to nu and Phi
+//
+// @name addSubjectGradient
+// @param obs RaggedObs containing observed values and basis functions
+// @param i Int containing the function of interest
+// @param nu Matrix containing nu parameters
+// @param Phi Cube containing Phi parameters
+// @param Z Matrix containing Z parameters
+// @param chi Matrix containing chi parameters
+// @param w Double containing the weight of the contribution
+// @param coef Vector acting as a placeholder for the mean coefficients
+// @param u Vector acting as a placeholder for B_i'(y_i - B_i coef_i)
+// @param g_nu Matrix containing the gradient with respect to nu
+// @param g_Phi Cube containing the gradient with respect to Phi
+// @returns rss Double containing the residual sum of squares of the function
+inline double addSubjectGradient(const RaggedObs& obs,
+                                 const arma::uword i,
+                                 const arma::mat& nu,
+                                 const arma::cube& Phi,
+                                 const arma::mat& Z,
+                                 const arma::mat& chi,
+                                 const double w,
+                                 arma::vec& coef,
+                                 arma::vec& u,
+                                 arma::mat& g_nu,
+                                 arma::cube& g_Phi){
+  calcMeanCoef(nu, Phi, Z.row(i), chi.row(i), coef);
+  u.zeros(obs.B_t.n_rows);
+  const double* c = coef.memptr();
+  const double* b;
+  double r = 0;
+  double rss = 0;
+  for(arma::uword t = obs.offsets(i); t < obs.offsets(i + 1); t++){
+    b = obs.B_t.colptr(t);
+    r = obs.y.at(t);
+    for(arma::uword p = 0; p < obs.B_t.n_rows; p++){
+      r = r - (b[p] * c[p]);
+    }
+    for(arma::uword p = 0; p < obs.B_t.n_rows; p++){
+      u.at(p) = u.at(p) + (r * b[p]);
+    }
+    rss = rss + (r * r);
+  }
+  for(arma::uword k = 0; k < Z.n_cols; k++){
+    for(arma::uword p = 0; p < u.n_elem; p++){
+      g_nu.at(k,p) = g_nu.at(k,p) + (w * Z.at(i,k) * u.at(p));
+      for(arma::uword m = 0; m < chi.n_cols; m++){
+        g_Phi.at(k,p,m) = g_Phi.at(k,p,m) +
+          (w * Z.at(i,k) * chi.at(i,m) * u.at(p));
+      }
+    }
+  }
+  return rss + obs.rss_offset(i);
+}
+
+// Adds the weighted contributions of a set of functions to the gradient of
+// the log-likelihood (times sigma) with respect to nu and Phi. The functions
+// are split into one block per thread and the blocks are added in order, so
+// the result does not depend on how the threads are scheduled.
+//
+// @name accumulateSubjects
+// @param obs RaggedObs containing observed values and basis functions
+// @param subjects Vector containing the functions of interest
+// @param nu Matrix containing nu parameters
+// @param Phi Cube containing Phi parameters
+// @param Z Matrix containing Z parameters
+// @param chi Matrix containing chi parameters
+// @param w Double containing the weight of the contributions
+// @param g_nu Matrix containing the gradient with respect to nu
+// @param g_Phi Cube containing the gradient with respect to Phi
+// @returns rss Double containing the weighted residual sum of squares of the functions
+inline double accumulateSubjects(const RaggedObs& obs,
+                                 const arma::uvec& subjects,
+                                 const arma::mat& nu,
+                                 const arma::cube& Phi,
+                                 const arma::mat& Z,
+                                 const arma::mat& chi,
+                                 const double w,
+                                 arma::mat& g_nu,
+                                 arma::cube& g_Phi){
+  int n_blocks = 1;
+#ifdef _OPENMP
+  n_blocks = std::max(1, std::min(omp_get_max_threads(),
+                                  (int) subjects.n_elem));
+#endif
+  std::vector<arma::mat> g_nu_b(n_blocks);
+  std::vector<arma::cube> g_Phi_b(n_blocks);
+  std::vector<double> rss_b(n_blocks, 0);
+  #pragma omp parallel for schedule(static)
+  for(int l = 0; l < n_blocks; l++){
+    arma::vec coef;
+    arma::vec u;
+    g_nu_b[l] = arma::zeros(g_nu.n_rows, g_nu.n_cols);
+    g_Phi_b[l] = arma::zeros(g_Phi.n_rows, g_Phi.n_cols, g_Phi.n_slices);
+    arma::uword start = (subjects.n_elem * l) / n_blocks;
+    arma::uword end = (subjects.n_elem * (l + 1)) / n_blocks;
+    for(arma::uword j = start; j < end; j++){
+      rss_b[l] = rss_b[l] + addSubjectGradient(obs, subjects(j), nu, Phi, Z,
+                                               chi, 1.0, coef, u, g_nu_b[l],
+                                               g_Phi_b[l]);
+    }
+  }
+  double rss = 0;
+  for(int l = 0; l < n_blocks; l++){
+    g_nu = g_nu + (w * g_nu_b[l]);
+    g_Phi = g_Phi + (w * g_Phi_b[l]);
+    rss = rss + (w * rss_b[l]);
+  }
+  return rss;
+}
+
+// Sets the anchor of the stochastic gradient sampler to the current nu and
+// Phi parameters (one pass over all functions). The sums of the log
+// memberships and the diagonal preconditioners are recomputed as well.
+//
+// @name setSGAnchor
+// @param obs RaggedObs containing observed values and basis functions
+// @param nu Matrix containing current nu parameters
+// @param Phi Cube containing current Phi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param state SGState
+inline void setSGAnchor(const RaggedObs& obs,
+                        const arma::mat& nu,
+                        const arma::cube& Phi,
+                        const arma::mat& Z,
+                        const arma::mat& chi,
+                        SGState& state){
+  int n_funct = obs.n_funct();
+  arma::uvec all = arma::regspace<arma::uvec>(0, n_funct - 1);
+  state.nu_hat = nu;
+  state.Phi_hat = Phi;
+  state.grad_nu_hat.zeros(nu.n_rows, nu.n_cols);
+  state.grad_Phi_hat.zeros(Phi.n_rows, Phi.n_cols, Phi.n_slices);
+  state.rss_hat = accumulateSubjects(obs, all, nu, Phi, Z, chi, 1.0,
+                                     state.grad_nu_hat, state.grad_Phi_hat);
+  state.rss_est = state.rss_hat;
+
+  // diagonal of sum_i B_i B_i' for each function (scaled by Z and chi)
+  state.prec_nu.zeros(nu.n_rows, nu.n_cols);
+  state.prec_Phi.zeros(Phi.n_rows, Phi.n_cols, Phi.n_slices);
+  state.log_Z_sum.zeros(Z.n_cols);
+  arma::vec d(obs.B_t.n_rows);
+  for(int i = 0; i < n_funct; i++){
+    d.zeros();
+    for(arma::uword t = obs.offsets(i); t < obs.offsets(i + 1); t++){
+      d = d + arma::square(obs.B_t.col(t));
+    }
+    for(arma::uword k = 0; k < Z.n_cols; k++){
+      state.log_Z_sum(k) = state.log_Z_sum(k) + std::log(Z(i,k));
+      for(arma::uword p = 0; p < d.n_elem; p++){
+        state.prec_nu(k,p) = state.prec_nu(k,p) + (Z(i,k) * Z(i,k) * d(p));
+        for(arma::uword m = 0; m < chi.n_cols; m++){
+          state.prec_Phi(k,p,m) = state.prec_Phi(k,p,m) +
+            (Z(i,k) * Z(i,k) * chi(i,m) * chi(i,m) * d(p));
+        }
+      }
+    }
+  }
+  state.n_anchor = state.n_anchor + 1;
+}
+
+// Samples a minibatch of functions without replacement (Floyd's algorithm)
+//
+// @name sampleMinibatch
+// @param n_funct Int containing the number of functions
+// @param n_batch Int containing the number of functions in the minibatch
+// @param state SGState whose batch is replaced
+inline void sampleMinibatch(const int n_funct,
+                            const int n_batch,
+                            SGState& state){
+  if(n_batch >= n_funct){
+    state.batch = arma::regspace<arma::uvec>(0, n_funct - 1);
+    return;
+  }
+  std::set<arma::uword> chosen;
+  for(int j = n_funct - n_batch; j < n_funct; j++){
+    arma::uword t = std::min((arma::uword) std::floor(R::unif_rand() * (j + 1)),
+                             (arma::uword) j);
+    if(!chosen.insert(t).second){
+      chosen.insert(j);
+    }
+  }
+  state.batch = arma::uvec(std::vector<arma::uword>(chosen.begin(),
+                                                    chosen.end()));
+}
+
+// Updates the Z and chi parameters of the functions of the minibatch (one
+// Dirichlet random walk step for each row of Z followed by a Gibbs update of
+// chi) and updates the sums over all functions kept at the anchor
+//
+// @name updateSGLocals
+// @param obs RaggedObs containing observed values and basis functions
+// @param Phi Cube containing current Phi parameters
+// @param nu Matrix containing current nu parameters
+// @param pi Vector containing current pi parameters
+// @param alpha_3 Double containing current alpha_3 parameter
+// @param sigma_sq Double containing current sigma parameter
+// @param a_Z_PM Double containing hyperparameter for sampling Z
+// @param state SGState
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @returns accept_prob Double containing the mean acceptance probability of the Z proposals
+inline double updateSGLocals(const RaggedObs& obs,
+                             const arma::cube& Phi,
+                             const arma::mat& nu,
+                             const arma::vec& pi,
+                             const double& alpha_3,
+                             const double& sigma_sq,
+                             const double& a_Z_PM,
+                             SGState& state,
+                             arma::mat& Z,
+                             arma::mat& chi){
+  RaggedData data = {obs};
+  int K = Z.n_cols;
+  int M = chi.n_cols;
+  arma::vec coef(nu.n_cols);
+  arma::vec phi_coef(nu.n_cols);
+  arma::vec u;
+  arma::vec Z_old(K);
+  arma::vec Z_ph(K);
+  arma::vec alpha(K);
+  double z_lpdf = 0;
+  double z_new_lpdf = 0;
+  double acceptance_prob = 0;
+  double accept_prob = 0;
+  double w = 0;
+  double W = 0;
+  for(arma::uword j = 0; j < state.batch.n_elem; j++){
+    arma::uword i = state.batch(j);
+    // remove the function from the sums kept at the anchor
+    state.rss_hat = state.rss_hat -
+      addSubjectGradient(obs, i, state.nu_hat, state.Phi_hat, Z, chi, -1.0,
+                         coef, u, state.grad_nu_hat, state.grad_Phi_hat);
+    for(int k = 0; k < K; k++){
+      state.log_Z_sum(k) = state.log_Z_sum(k) - std::log(Z(i,k));
+    }
+
+    // Dirichlet random walk for the ith row of Z
+    Z_old = Z.row(i).t();
+    alpha = a_Z_PM * Z_old;
+    rdirichlet(alpha, Z_ph);
+    z_lpdf = lpdf_zTempered(1.0, obs, i, Phi, nu, chi.row(i), pi, Z.row(i),
+                            alpha_3, sigma_sq, coef);
+    z_new_lpdf = lpdf_zTempered(1.0, obs, i, Phi, nu, chi.row(i), pi,
+                                Z_ph.t(), alpha_3, sigma_sq, coef);
+    acceptance_prob = z_new_lpdf - z_lpdf +
+      Z_proposal_density(Z_old, a_Z_PM * Z_ph) -
+      Z_proposal_density(Z_ph, alpha);
+    if(arma::any(Z_ph <= 0)){
+      acceptance_prob = -arma::datum::inf;
+    }
+    accept_prob = accept_prob + calcAcceptanceProb(acceptance_prob);
+    if(std::log(R::unif_rand()) < acceptance_prob){
+      Z.row(i) = Z_ph.t();
+    }
+
+    // Gibbs update of the ith row of chi
+    for(int m = 0; m < M; m++){
+      phi_coef = Phi.slice(m).t() * Z.row(i).t();
+      calcMeanCoef(nu, Phi, Z.row(i), chi.row(i), coef);
+      coef -= chi(i,m) * phi_coef;
+      data.crossResid(i, phi_coef, coef, w, W);
+      w = w / sigma_sq;
+      W = 1 / (1 + (W / sigma_sq));
+      chi(i,m) = (W * w) + (std::sqrt(W) * R::norm_rand());
+    }
+
+    // add the function back with its new parameters
+    state.rss_hat = state.rss_hat +
+      addSubjectGradient(obs, i, state.nu_hat, state.Phi_hat, Z, chi, 1.0,
+                         coef, u, state.grad_nu_hat, state.grad_Phi_hat);
+    for(int k = 0; k < K; k++){
+      state.log_Z_sum(k) = state.log_Z_sum(k) + std::log(Z(i,k));
+    }
+  }
+  return accept_prob / state.batch.n_elem;
+}
+
+// Gets the control variate estimate of the gradient of the log-likelihood
+// (times sigma) with respect to nu and Phi, and of the residual sum of
+// squares, at the current parameters
+//
+// @name estimateSGGradient
+// @param obs RaggedObs containing observed values and basis functions
+// @param nu Matrix containing current nu parameters
+// @param Phi Cube containing current Phi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param state SGState
+// @param g_nu Matrix acting as a placeholder for the gradient with respect to nu
+// @param g_Phi Cube acting as a placeholder for the gradient with respect to Phi
+// @returns rss Double containing the estimate of the residual sum of squares
+inline double estimateSGGradient(const RaggedObs& obs,
+                                 const arma::mat& nu,
+                                 const arma::cube& Phi,
+                                 const arma::mat& Z,
+                                 const arma::mat& chi,
+                                 const SGState& state,
+                                 arma::mat& g_nu,
+                                 arma::cube& g_Phi){
+  double scale = obs.n_funct() / (double) state.batch.n_elem;
+  g_nu = state.grad_nu_hat;
+  g_Phi = state.grad_Phi_hat;
+  double rss = state.rss_hat;
+  rss = rss + accumulateSubjects(obs, state.batch, nu, Phi, Z, chi, scale,
+                                 g_nu, g_Phi);
+  rss = rss + accumulateSubjects(obs, state.batch, state.nu_hat,
+                                 state.Phi_hat, Z, chi, -scale, g_nu, g_Phi);
+  return std::max(rss, 0.0);
+}
+
+// Moves the Phi parameters with a preconditioned stochastic gradient Langevin
+// step (the preconditioner is the diagonal of the posterior precision at the
+// anchor)
+//
+// @name updatePhiSG
+// @param obs RaggedObs containing observed values and basis functions
+// @param nu Matrix containing current nu parameters
+// @param gamma Cube containing current gamma parameters
+// @param tilde_tau Matrix containing current tilde_tau parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param sigma Double containing current sigma parameter
+// @param step Double containing the step size
+// @param state SGState
+// @param iter Int containing current MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param Phi Field of cubes containing MCMC samples for Phi
+inline void updatePhiSG(const RaggedObs& obs,
+                        const arma::mat& nu,
+                        const arma::cube& gamma,
+                        const arma::mat& tilde_tau,
+                        const arma::mat& Z,
+                        const arma::mat& chi,
+                        const double& sigma,
+                        const double& step,
+                        const SGState& state,
+                        const int& iter,
+                        const int& tot_mcmc_iters,
+                        arma::field<arma::cube>& Phi){
+  arma::mat g_nu;
+  arma::cube g_Phi;
+  estimateSGGradient(obs, nu, Phi(iter,0), Z, chi, state, g_nu, g_Phi);
+  arma::cube& Phi_iter = Phi(iter,0);
+  double prior = 0;
+  double D = 0;
+  for(arma::uword m = 0; m < Phi_iter.n_slices; m++){
+    for(arma::uword p = 0; p < Phi_iter.n_cols; p++){
+      for(arma::uword k = 0; k < Phi_iter.n_rows; k++){
+        prior = tilde_tau(k,m) * gamma(k,p,m);
+        D = 1 / ((state.prec_Phi(k,p,m) / sigma) + prior);
+        Phi_iter(k,p,m) = Phi_iter(k,p,m) +
+          (0.5 * step * D * ((g_Phi(k,p,m) / sigma) - (prior * Phi_iter(k,p,m)))) +
+          (std::sqrt(step * D) * R::norm_rand());
+      }
+    }
+  }
+  if(iter < (tot_mcmc_iters - 1)){
+    Phi(iter + 1,0) = Phi(iter,0);
+  }
+}
+
+// Moves the nu parameters with a preconditioned stochastic gradient Langevin
+// step (the preconditioner is the diagonal of the posterior precision at the
+// anchor)
+//
+// @name updateNuSG
+// @param obs RaggedObs containing observed values and basis functions
+// @param tau Vector containing current tau parameters
+// @param Phi Cube containing current Phi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param sigma Double containing current sigma parameter
+// @param P Matrix containing the penalty matrix
+// @param step Double containing the step size
+// @param state SGState
+// @param iter Int containing current MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param nu Cube containing MCMC samples for nu
+inline void updateNuSG(const RaggedObs& obs,
+                       const arma::vec& tau,
+                       const arma::cube& Phi,
+                       const arma::mat& Z,
+                       const arma::mat& chi,
+                       const double& sigma,
+                       const arma::mat& P,
+                       const double& step,
+                       const SGState& state,
+                       const int& iter,
+                       const int& tot_mcmc_iters,
+                       arma::cube& nu){
+  arma::mat g_nu;
+  arma::cube g_Phi;
+  estimateSGGradient(obs, nu.slice(iter), Phi, Z, chi, state, g_nu, g_Phi);
+  arma::mat prior = nu.slice(iter) * P;
+  double D = 0;
+  for(arma::uword p = 0; p < nu.n_cols; p++){
+    for(arma::uword k = 0; k < nu.n_rows; k++){
+      D = 1 / ((state.prec_nu(k,p) / sigma) + (tau(k) * P(p,p)));
+      nu(k,p,iter) = nu(k,p,iter) +
+        (0.5 * step * D * ((g_nu(k,p) / sigma) - (tau(k) * prior(k,p)))) +
+        (std::sqrt(step * D) * R::norm_rand());
+    }
+  }
+  if(iter < (tot_mcmc_iters - 1)){
+    nu.slice(iter + 1) = nu.slice(iter);
+  }
+}
+
+// Updates sigma from the control variate estimate of the residual sum of
+// squares
+//
+// @name updateSigmaSG
+// @param obs RaggedObs containing observed values and basis functions
+// @param alpha_0 Double containing hyperparameter
+// @param beta_0 Double containing hyperparameter
+// @param nu Matrix containing current nu parameters
+// @param Phi Cube containing current Phi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param iter Int containing current MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param state SGState (rss_est is updated)
+// @param sigma Vector containing MCMC samples for sigma
+inline void updateSigmaSG(const RaggedObs& obs,
+                          const double alpha_0,
+                          const double beta_0,
+                          const arma::mat& nu,
+                          const arma::cube& Phi,
+                          const arma::mat& Z,
+                          const arma::mat& chi,
+                          const int& iter,
+                          const int& tot_mcmc_iters,
+                          SGState& state,
+                          arma::vec& sigma){
+  arma::mat g_nu;
+  arma::cube g_Phi;
+  state.rss_est = estimateSGGradient(obs, nu, Phi, Z, chi, state, g_nu, g_Phi);
+  double b_1 = beta_0 + (0.5 * state.rss_est);
+  double a = (0.5 * obs.n_total()) + alpha_0;
+  sigma(iter) = 1 / R::rgamma(a, 1/b_1);
+
+  if(iter < (tot_mcmc_iters - 1)){
+    sigma(iter + 1) = sigma(iter);
+  }
+}
+}
+
+#endif
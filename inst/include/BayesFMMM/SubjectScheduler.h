@@ -0,0 +1,312 @@
+#ifndef BayesFMMM_SUBJECT_SCHEDULER_H
+#define BayesFMMM_SUBJECT_SCHEDULER_H
+
+#include <RcppArmadillo.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "RaggedObs.h"
+#include "Workspace.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace BayesFMMM{
+// Utilization statistics of one kernel run on the subject scheduler
+//
+// @name KernelUtilization
+// @field n_calls Int containing the number of times the kernel was run
+// @field wall Double containing the total wall time (seconds) spent in the kernel
+// @field busy Vector containing the time (seconds) each thread spent processing subjects
+// @field weight Vector containing the total weight of the subjects processed by each thread
+// @field n_steals Int containing the number of chunks taken from another thread
+struct KernelUtilization{
+  int n_calls;
+  double wall;
+  arma::vec busy;
+  arma::vec weight;
+  int n_steals;
+};
+
+// Work-stealing scheduler for loops over subjects. The subjects are split into
+// contiguous chunks of similar weight (number of observed time points plus a
+// constant cost per subject). Each thread starts with a contiguous range of
+// chunks of similar total weight, takes chunks from the front of its own range
+// and, once it is empty, steals chunks from the back of the ranges of the
+// other threads. Each thread also owns a Workspace, which the kernels use
+// as scratch memory for the subjects it processes, and the serial parts of
+// the kernels (e.g. the draws taken from R's random number generator before
+// the parallel loop) use a separate Workspace.
+//
+// @name SubjectScheduler
+// @field chunk_start Vector (number of chunks + 1) containing the first subject of each chunk
+// @field chunk_weight Vector containing the weight of each chunk
+// @field stats Map containing the utilization statistics of each kernel
+// @field scratch Vector containing the Workspace of each thread
+// @field serial Workspace used outside of the parallel loops
+struct SubjectScheduler{
+  arma::uvec chunk_start;
+  arma::vec chunk_weight;
+  std::map<std::string, KernelUtilization> stats;
+  std::vector<Workspace> scratch;
+  Workspace serial;
+};
+
+// Creates the subject scheduler of a set of functions with given costs
+//
+// @name makeSubjectScheduler
+// @param weight Vector containing the cost of processing each function
+// @param chunks_per_thread Int containing the number of chunks created per thread
+// @returns sched SubjectScheduler with empty utilization statistics
+inline SubjectScheduler makeSubjectScheduler(const arma::vec& weight,
+                                             const int chunks_per_thread){
+  int n_funct = weight.n_elem;
+  int n_threads = 1;
+#ifdef _OPENMP
+  n_threads = omp_get_max_threads();
+#endif
+  int n_chunks = std::max(std::min(n_threads * chunks_per_thread, n_funct), 1);
+  double target = arma::accu(weight) / n_chunks;
+
+  SubjectScheduler sched;
+  std::vector<arma::uword> start(1, 0);
+  std::vector<double> chunk_weight;
+  double cum_weight = 0;
+  for(int i = 0; i < n_funct; i++){
+    cum_weight = cum_weight + weight(i);
+    if((cum_weight >= target) || (i == (n_funct - 1))){
+      start.push_back(i + 1);
+      chunk_weight.push_back(cum_weight);
+      cum_weight = 0;
+    }
+  }
+  sched.chunk_start = arma::uvec(start);
+  sched.chunk_weight = arma::vec(chunk_weight);
+  sched.scratch = std::vector<Workspace>(n_threads, makeWorkspace());
+  sched.serial = makeWorkspace();
+  return sched;
+}
+
+// Creates the subject scheduler of a set of functions with given costs
+//
+// @name makeSubjectScheduler
+inline SubjectScheduler makeSubjectScheduler(const arma::vec& weight){
+  return makeSubjectScheduler(weight, 8);
+}
+
+// Creates the subject scheduler of a set of observations, where each
+// function costs its number of observed time points plus one basis evaluation
+//
+// @name makeSubjectScheduler
+// @param obs RaggedObs containing observed values and basis functions
+// @returns sched SubjectScheduler with empty utilization statistics
+inline SubjectScheduler makeSubjectScheduler(const RaggedObs& obs){
+  arma::vec weight(obs.n_funct());
+  for(arma::uword i = 0; i < obs.n_funct(); i++){
+    weight(i) = obs.n_obs(i) + obs.B_t.n_rows;
+  }
+  return makeSubjectScheduler(weight, 8);
+}
+
+// Creates the subject scheduler of a set of single precision observations
+//
+// @name makeSubjectScheduler
+inline SubjectScheduler makeSubjectScheduler(const RaggedObsF& obs){
+  arma::vec weight(obs.n_funct());
+  for(arma::uword i = 0; i < obs.n_funct(); i++){
+    weight(i) = obs.n_obs(i) + obs.B_t.n_rows;
+  }
+  return makeSubjectScheduler(weight, 8);
+}
+
+// Runs body(i) for every subject on the work-stealing scheduler and records
+// the utilization of the threads under the name of the kernel. The body is
+// run from multiple threads, so it cannot use the R API, and it should only
+// write to the outputs of subject i. If the body throws, the remaining chunks
+// are skipped and the first exception is rethrown once every thread is done.
+//
+// @name parallelForSubjects
+// @param sched SubjectScheduler containing the chunks of subjects
+// @param kernel String containing the name under which the statistics are recorded
+// @param body Function processing one subject
+inline void parallelForSubjects(SubjectScheduler& sched,
+                                const std::string& kernel,
+                                const std::function<void(const int)>& body){
+  int n_chunks = sched.chunk_weight.n_elem;
+  int n_threads = 1;
+#ifdef _OPENMP
+  n_threads = std::max(std::min(omp_get_max_threads(), n_chunks), 1);
+  if(omp_get_active_level() >= omp_get_max_active_levels()){
+    // called from a parallel region without nested parallelism
+    n_threads = 1;
+  }
+#endif
+  if(sched.scratch.size() < n_threads){
+    sched.scratch.resize(n_threads, makeWorkspace());
+  }
+  KernelUtilization& stats = sched.stats[kernel];
+  if(stats.busy.n_elem < n_threads){
+    // the kernel may be run with fewer threads (e.g. next to the engine
+    // blocks of a Gibbs sweep), so the statistics are kept for every thread
+    stats.busy.resize(n_threads);
+    stats.weight.resize(n_threads);
+  }
+
+  // initial ranges of chunks with similar total weight
+  std::vector<int> head(n_threads, 0);
+  std::vector<int> tail(n_threads, 0);
+  std::vector<std::mutex> lock(n_threads);
+  double total = arma::accu(sched.chunk_weight);
+  double cum_weight = 0;
+  int c = 0;
+  for(int t = 0; t < n_threads; t++){
+    head[t] = c;
+    while((c < n_chunks) && ((t == (n_threads - 1)) ||
+          ((cum_weight + (0.5 * sched.chunk_weight(c))) <
+            (total * (t + 1) / n_threads)))){
+      cum_weight = cum_weight + sched.chunk_weight(c);
+      c++;
+    }
+    tail[t] = c;
+  }
+
+  std::vector<double> busy(n_threads, 0);
+  std::vector<double> weight(n_threads, 0);
+  std::vector<int> n_steals(n_threads, 0);
+  std::chrono::steady_clock::time_point wall_start =
+    std::chrono::steady_clock::now();
+  std::atomic<bool> failed(false);
+  std::exception_ptr error;
+  std::mutex error_lock;
+
+  #pragma omp parallel num_threads(n_threads)
+  {
+    int tid = 0;
+#ifdef _OPENMP
+    tid = omp_get_thread_num();
+#endif
+    int chunk = 0;
+    int victim = 0;
+    std::chrono::steady_clock::time_point chunk_start;
+    while(true){
+      chunk = -1;
+      {
+        std::lock_guard<std::mutex> guard(lock[tid]);
+        if(head[tid] < tail[tid]){
+          chunk = head[tid];
+          head[tid] = head[tid] + 1;
+        }
+      }
+      for(int v = 1; (chunk < 0) && (v < n_threads); v++){
+        victim = (tid + v) % n_threads;
+        std::lock_guard<std::mutex> guard(lock[victim]);
+        if(head[victim] < tail[victim]){
+          tail[victim] = tail[victim] - 1;
+          chunk = tail[victim];
+          n_steals[tid] = n_steals[tid] + 1;
+        }
+      }
+      if((chunk < 0) || failed){
+        break;
+      }
+      chunk_start = std::chrono::steady_clock::now();
+      try{
+        for(int i = sched.chunk_start(chunk); i < sched.chunk_start(chunk + 1); i++){
+          body(i);
+        }
+      }catch(...){
+        // exceptions cannot leave the parallel region
+        std::lock_guard<std::mutex> guard(error_lock);
+        if(!error){
+          error = std::current_exception();
+        }
+        failed = true;
+      }
+      busy[tid] = busy[tid] + std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - chunk_start).count();
+      weight[tid] = weight[tid] + sched.chunk_weight(chunk);
+    }
+  }
+
+  stats.n_calls = stats.n_calls + 1;
+  stats.wall = stats.wall + std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - wall_start).count();
+  for(int t = 0; t < n_threads; t++){
+    stats.busy(t) = stats.busy(t) + busy[t];
+    stats.weight(t) = stats.weight(t) + weight[t];
+    stats.n_steals = stats.n_steals + n_steals[t];
+  }
+  if(error){
+    std::rethrow_exception(error);
+  }
+}
+
+// Gets the workspace of the thread processing the current subject (only valid
+// inside the body run by parallelForSubjects)
+//
+// @name subjectWorkspace
+// @param sched SubjectScheduler running the loop
+// @returns ws Workspace of the current thread
+inline Workspace& subjectWorkspace(SubjectScheduler& sched){
+  int tid = 0;
+#ifdef _OPENMP
+  tid = omp_get_thread_num();
+#endif
+  return sched.scratch[tid];
+}
+
+// Counts the (re)allocations of the workspaces of all threads and of the
+// serial parts of the kernels
+//
+// @name countWorkspaceAllocations
+// @param sched SubjectScheduler owning the workspaces
+// @returns n_alloc Int containing the number of (re)allocations
+inline int countWorkspaceAllocations(const SubjectScheduler& sched){
+  int n_alloc = sched.serial.n_alloc;
+  for(std::size_t t = 0; t < sched.scratch.size(); t++){
+    n_alloc = n_alloc + sched.scratch[t].n_alloc;
+  }
+  return n_alloc;
+}
+
+// Summarizes the utilization of the threads for each kernel run on the
+// subject scheduler. The utilization is the fraction of the wall time the
+// threads spent processing subjects, and the imbalance is the ratio between
+// the largest and the average busy time of the threads.
+//
+// @name summarizeSubjectScheduler
+// @param sched SubjectScheduler containing the utilization statistics
+// @returns summary List containing the statistics of each kernel
+inline Rcpp::List summarizeSubjectScheduler(const SubjectScheduler& sched){
+  Rcpp::List summary;
+  std::map<std::string, KernelUtilization>::const_iterator it;
+  for(it = sched.stats.begin(); it != sched.stats.end(); it++){
+    const KernelUtilization& stats = it->second;
+    double utilization = 0;
+    double imbalance = 1;
+    if(stats.wall > 0){
+      utilization = arma::accu(stats.busy) / (stats.wall * stats.busy.n_elem);
+    }
+    if(arma::mean(stats.busy) > 0){
+      imbalance = stats.busy.max() / arma::mean(stats.busy);
+    }
+    summary.push_back(Rcpp::List::create(Rcpp::Named("n_calls", stats.n_calls),
+                                         Rcpp::Named("wall", stats.wall),
+                                         Rcpp::Named("busy", stats.busy),
+                                         Rcpp::Named("weight", stats.weight),
+                                         Rcpp::Named("utilization", utilization),
+                                         Rcpp::Named("imbalance", imbalance),
+                                         Rcpp::Named("n_steals", stats.n_steals)),
+                                         it->first);
+  }
+  return summary;
+}
+}
+
+#endif
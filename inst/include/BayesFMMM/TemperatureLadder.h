@@ -0,0 +1,162 @@
+#ifndef BayesFMMM_TEMPERATURE_LADDER_H
+#define BayesFMMM_TEMPERATURE_LADDER_H
+
+#include <RcppArmadillo.h>
+#include <cmath>
+#include "Distributions.h"
+
+namespace BayesFMMM{
+// Statistics of the rungs of the temperature ladder collected during tempered
+// transitions. The log-likelihood of the states sampled at each temperature
+// is tracked with Welford's algorithm, and for each pair of adjacent
+// temperatures the contribution to the log acceptance probability of the
+// tempered transition is recorded.
+//
+// @name LadderStats
+// @field loglik_mean Vector containing the running mean of the log-likelihood at each temperature
+// @field loglik_M2 Vector containing the running sum of squared deviations of the log-likelihood at each temperature
+// @field n_loglik Vector containing the number of states recorded at each temperature
+// @field accept_sum Vector containing the sum of min(1, exp(contribution)) for each pair of adjacent temperatures
+// @field log_ratio_sum Vector containing the sum of the contributions for each pair of adjacent temperatures
+// @field n_trans Int containing the number of tempered transitions recorded
+// @field n_accept Int containing the number of accepted tempered transitions
+struct LadderStats{
+  arma::vec loglik_mean;
+  arma::vec loglik_M2;
+  arma::vec n_loglik;
+  arma::vec accept_sum;
+  arma::vec log_ratio_sum;
+  int n_trans;
+  int n_accept;
+};
+
+// Creates empty statistics for a temperature ladder
+//
+// @name makeLadderStats
+// @param N_t Int containing the number of temperatures
+// @returns stats LadderStats with no recorded transitions
+inline LadderStats makeLadderStats(const int N_t){
+  LadderStats stats;
+  stats.loglik_mean = arma::zeros(N_t);
+  stats.loglik_M2 = arma::zeros(N_t);
+  stats.n_loglik = arma::zeros(N_t);
+  stats.accept_sum = arma::zeros(std::max(N_t - 1, 0));
+  stats.log_ratio_sum = arma::zeros(std::max(N_t - 1, 0));
+  stats.n_trans = 0;
+  stats.n_accept = 0;
+  return stats;
+}
+
+// Records the states of one tempered transition. State l of the transition
+// (l = 1, ..., 2N_t) is sampled at temperature beta(l - 1) while heating up
+// and at temperature beta(2N_t - l) while cooling down.
+//
+// @name updateLadderStats
+// @param beta Vector containing the temperature ladder
+// @param loglik Vector containing the log-likelihood of each state (from calcTTLoglik)
+// @param accepted Boolean indicating whether the tempered transition was accepted
+// @param stats LadderStats containing the statistics to be updated
+inline void updateLadderStats(const arma::vec& beta,
+                              const arma::vec& loglik,
+                              const bool accepted,
+                              LadderStats& stats){
+  int N_t = beta.n_elem;
+  int m = loglik.n_elem - 1;
+  double delta = 0;
+  for(int r = 0; r < N_t; r++){
+    arma::uvec states = {(arma::uword) (r + 1), (arma::uword) (m - r)};
+    for(int j = 0; j < 2; j++){
+      stats.n_loglik(r) = stats.n_loglik(r) + 1;
+      delta = loglik(states(j)) - stats.loglik_mean(r);
+      stats.loglik_mean(r) = stats.loglik_mean(r) + (delta / stats.n_loglik(r));
+      stats.loglik_M2(r) = stats.loglik_M2(r) +
+        (delta * (loglik(states(j)) - stats.loglik_mean(r)));
+    }
+  }
+  double log_ratio = 0;
+  for(int r = 0; r < (N_t - 1); r++){
+    log_ratio = (beta(r + 1) - beta(r)) * (loglik(r) - loglik(m - r));
+    stats.log_ratio_sum(r) = stats.log_ratio_sum(r) + log_ratio;
+    stats.accept_sum(r) = stats.accept_sum(r) + calcAcceptanceProb(log_ratio);
+  }
+  stats.n_trans = stats.n_trans + 1;
+  if(accepted){
+    stats.n_accept = stats.n_accept + 1;
+  }
+}
+
+// Respaces the temperatures so that every pair of adjacent temperatures covers
+// the same thermodynamic length, which is approximated by the integral of the
+// standard deviation of the log-likelihood over the temperatures. Since the
+// contribution of a pair of temperatures to the log acceptance probability
+// scales with this length, the acceptance of the rungs becomes close to
+// uniform. The first and last temperatures are kept fixed.
+//
+// @name adaptTemperatureLadder
+// @param beta Vector containing the temperature ladder
+// @param stats LadderStats containing the statistics collected with this ladder
+// @returns beta_new Vector containing the respaced temperature ladder
+inline arma::vec adaptTemperatureLadder(const arma::vec& beta,
+                                        const LadderStats& stats){
+  int N_t = beta.n_elem;
+  arma::vec beta_new = beta;
+  if((N_t < 3) || (arma::min(stats.n_loglik) < 2)){
+    return beta_new;
+  }
+  arma::vec sd = arma::sqrt(stats.loglik_M2 / (stats.n_loglik - 1));
+
+  // cumulative thermodynamic length at each temperature
+  arma::vec length = arma::zeros(N_t);
+  for(int r = 1; r < N_t; r++){
+    length(r) = length(r - 1) + (std::abs(beta(r - 1) - beta(r)) *
+      0.5 * (sd(r - 1) + sd(r)));
+  }
+  if(!(length(N_t - 1) > 0)){
+    return beta_new;
+  }
+
+  int r = 0;
+  double target = 0;
+  for(int j = 1; j < (N_t - 1); j++){
+    target = length(N_t - 1) * j / (N_t - 1.0);
+    while((r < (N_t - 2)) && (length(r + 1) < target)){
+      r = r + 1;
+    }
+    if(length(r + 1) > length(r)){
+      beta_new(j) = beta(r) + ((beta(r + 1) - beta(r)) *
+        (target - length(r)) / (length(r + 1) - length(r)));
+    }else{
+      beta_new(j) = beta(r);
+    }
+  }
+  return beta_new;
+}
+
+// Summarizes the temperature ladder and the statistics of each rung
+//
+// @name summarizeLadderStats
+// @param beta Vector containing the temperature ladder
+// @param stats LadderStats containing the statistics collected with this ladder
+// @returns summary List containing the ladder and the statistics of each rung
+inline Rcpp::List summarizeLadderStats(const arma::vec& beta,
+                                       const LadderStats& stats){
+  double n_trans = std::max(stats.n_trans, 1);
+  arma::vec loglik_sd = arma::zeros(beta.n_elem);
+  for(int r = 0; r < beta.n_elem; r++){
+    if(stats.n_loglik(r) > 1){
+      loglik_sd(r) = std::sqrt(stats.loglik_M2(r) / (stats.n_loglik(r) - 1));
+    }
+  }
+  Rcpp::List summary = Rcpp::List::create(
+    Rcpp::Named("beta", beta),
+    Rcpp::Named("rung_accept", stats.accept_sum / n_trans),
+    Rcpp::Named("rung_log_ratio", stats.log_ratio_sum / n_trans),
+    Rcpp::Named("loglik_mean", stats.loglik_mean),
+    Rcpp::Named("loglik_sd", loglik_sd),
+    Rcpp::Named("n_trans", stats.n_trans),
+    Rcpp::Named("accept", stats.n_accept / n_trans));
+  return summary;
+}
+}
+
+#endif
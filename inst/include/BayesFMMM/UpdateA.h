@@ -4,6 +4,7 @@
 #include <RcppArmadillo.h>
 #include <cmath>
 #include <truncnorm.h>
+#include "ConditionalModes.h"
 #include "Distributions.h"
 
 namespace BayesFMMM{
@@ -43,7 +44,8 @@ inline double lpdf_a2(const double& alpha_2l,
   return lpdf;
 }
 
-// updates the a parameters for individualized covariance matrix
+// updates the a parameters for individualized covariance matrix, recording
+// the average acceptance probability of the proposals of a_1 and a_2
 //
 // @name updateA
 // @param alpha_1l Double containing hyperparameters for a
@@ -54,7 +56,10 @@ inline double lpdf_a2(const double& alpha_2l,
 // @param var_epsilon1 Double containing hyperparameter epsilon1
 // @param var_epsilon2 Double containing hyperparameter epsilon2
 // @param iter Double containing MCMC iteration
+// @param rng Source of randomness (RRng or a random number engine owned by the calling thread)
+// @param accept_prob Vector acting as a placeholder for the average acceptance probabilities (a_1, a_2)
 // @param a Cube containing values of a
+template <typename Rng>
 inline void updateA(const double& alpha_1l,
                     const double& beta_1l,
                     const double& alpha_2l,
@@ -64,54 +69,40 @@ inline void updateA(const double& alpha_1l,
                     const double& var_epsilon2,
                     const int& iter,
                     const int& tot_mcmc_iters,
+                    Rng& rng,
+                    arma::vec& accept_prob,
                     arma::cube& a){
   double a_lpdf = 0;
   double a_new_lpdf = 0;
   double acceptance_prob = 0;
-  double rand_unif_var = 0;
   double new_a = 0;
+  double sd = 0;
+  accept_prob = arma::zeros(2);
 
-  // calculate first lpdf
   for(int j = 0; j < a.n_rows; j++){
     for(int i = 0; i < a.n_cols; i++){
       if(i == 0){
+        sd = var_epsilon1 / beta_1l;
         a_lpdf = lpdf_a1(alpha_1l, beta_1l, a(j, i, iter), delta(j,i));
-        new_a = r_truncnorm(a(j, i, iter), var_epsilon1 / beta_1l, 0,
-                            std::numeric_limits<double>::infinity());
-
+        new_a = drawTruncnormPositive(a(j, i, iter), sd, rng);
         a_new_lpdf = lpdf_a1(alpha_1l, beta_1l, new_a, delta(j,i));
-
-        acceptance_prob = (a_new_lpdf +
-          d_truncnorm(a(j, i, iter), new_a, var_epsilon1 / beta_1l, 0,
-                      std::numeric_limits<double>::infinity(), 1)) - a_lpdf -
-                        d_truncnorm(new_a, a(j, i, iter),
-                                    var_epsilon1 / beta_1l, 0,
-                                    std::numeric_limits<double>::infinity(), 1);
-        rand_unif_var = R::runif(0,1);
-
-        if(log(rand_unif_var) < acceptance_prob){
-          // Accept new state and update parameters
-          a(j, i, iter) = new_a;
-        }
       }else{
+        sd = var_epsilon2 / beta_2l;
         a_lpdf = lpdf_a2(alpha_2l, beta_2l, a(j, i, iter), delta.row(j).t());
-        new_a = r_truncnorm(a(j, i, iter), var_epsilon2 / beta_2l, 0,
-                            std::numeric_limits<double>::infinity());
-
+        new_a = drawTruncnormPositive(a(j, i, iter), sd, rng);
         a_new_lpdf = lpdf_a2(alpha_2l, beta_2l, new_a, delta.row(j).t());
+      }
+      acceptance_prob = (a_new_lpdf +
+        d_truncnorm(a(j, i, iter), new_a, sd, 0,
+                    std::numeric_limits<double>::infinity(), 1)) - a_lpdf -
+                      d_truncnorm(new_a, a(j, i, iter), sd, 0,
+                                  std::numeric_limits<double>::infinity(), 1);
+      accept_prob(i) = accept_prob(i) +
+        (calcAcceptanceProb(acceptance_prob) / a.n_rows);
 
-        acceptance_prob = (a_new_lpdf +
-          d_truncnorm(a(j, i, iter), new_a, var_epsilon2 / beta_2l, 0,
-                      std::numeric_limits<double>::infinity(), 1)) - a_lpdf -
-                        d_truncnorm(new_a, a(j, i, iter),
-                                    var_epsilon2 / beta_2l, 0,
-                                    std::numeric_limits<double>::infinity(), 1);
-        rand_unif_var = R::runif(0,1);
-
-        if(log(rand_unif_var) < acceptance_prob){
-          // Accept new state and update parameters
-          a(j, i, iter) = new_a;
-        }
+      if(std::log(drawUnif(rng)) < acceptance_prob){
+        // Accept new state and update parameters
+        a(j, i, iter) = new_a;
       }
     }
   }
@@ -122,6 +113,45 @@ inline void updateA(const double& alpha_1l,
   }
 }
 
+// updates the a parameters for individualized covariance matrix using R's
+// random number generator, recording the average acceptance probability of
+// the proposals of a_1 and a_2
+//
+// @name updateA
+inline void updateA(const double& alpha_1l,
+                    const double& beta_1l,
+                    const double& alpha_2l,
+                    const double& beta_2l,
+                    const arma::mat& delta,
+                    const double& var_epsilon1,
+                    const double& var_epsilon2,
+                    const int& iter,
+                    const int& tot_mcmc_iters,
+                    arma::vec& accept_prob,
+                    arma::cube& a){
+  RRng rng;
+  updateA(alpha_1l, beta_1l, alpha_2l, beta_2l, delta, var_epsilon1,
+          var_epsilon2, iter, tot_mcmc_iters, rng, accept_prob, a);
+}
+
+// updates the a parameters for individualized covariance matrix
+//
+// @name updateA
+inline void updateA(const double& alpha_1l,
+                    const double& beta_1l,
+                    const double& alpha_2l,
+                    const double& beta_2l,
+                    const arma::mat& delta,
+                    const double& var_epsilon1,
+                    const double& var_epsilon2,
+                    const int& iter,
+                    const int& tot_mcmc_iters,
+                    arma::cube& a){
+  arma::vec accept_prob = arma::zeros(2);
+  updateA(alpha_1l, beta_1l, alpha_2l, beta_2l, delta, var_epsilon1,
+          var_epsilon2, iter, tot_mcmc_iters, accept_prob, a);
+}
+
 // updates the a parameters for individualized covariance matrix
 //
 // @name updateA
@@ -204,6 +234,47 @@ inline void updateAXi(const double& alpha_1l,
   }
 }
 
+// updates the a parameters for individualized covariance matrix by iterated
+// conditional modes, setting each a to the maximizer of its conditional
+// posterior (the conditional log-densities are concave when alpha_1l and
+// alpha_2l are at least 1, and the maximizer within a factor of exp(3) of the
+// current value is found by golden section search)
+//
+// @name updateAICM
+// @param alpha_1l Double containing hyperparameters for a
+// @param beta_1l Double containing hyperparameters for a
+// @param alpha_2l Double containing hyperparameters for a
+// @param beta_2l Double containing hyperparameters for a
+// @param delta Vector contianing value of delta
+// @param iter Double containing current iteration
+// @param tot_mcmc_iters Int containing total number of iterations
+// @param a Cube containing values of a
+inline void updateAICM(const double& alpha_1l,
+                       const double& beta_1l,
+                       const double& alpha_2l,
+                       const double& beta_2l,
+                       const arma::mat& delta,
+                       const int& iter,
+                       const int& tot_mcmc_iters,
+                       arma::cube& a){
+  for(int j = 0; j < a.n_rows; j++){
+    arma::vec delta_j = delta.row(j).t();
+    auto f_1 = [&](const double x){
+      return lpdf_a1(alpha_1l, beta_1l, x, delta(j,0));
+    };
+    auto f_2 = [&](const double x){
+      return lpdf_a2(alpha_2l, beta_2l, x, delta_j);
+    };
+    maximizePositive(f_1, 3, 60, a(j, 0, iter));
+    maximizePositive(f_2, 3, 60, a(j, 1, iter));
+  }
+
+  // update next iteration
+  if(iter < (tot_mcmc_iters - 1)){
+    a.slice(iter + 1) = a.slice(iter);
+  }
+}
+
 }
 #endif
 
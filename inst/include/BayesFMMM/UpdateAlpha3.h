@@ -4,6 +4,7 @@
 #include <RcppArmadillo.h>
 #include <cmath>
 #include <truncnorm.h>
+#include "ConditionalModes.h"
 #include "Distributions.h"
 
 namespace BayesFMMM{
@@ -26,33 +27,132 @@ inline double lpdf_alpha3(const arma::vec& pi,
 }
 
 
-// Updates the Alpha3 parameter
+// Updates the Alpha3 parameter, recording the acceptance probability of the
+// proposal
 //
 // @name updateAlpha3
 // @param pi Vector containing current values of pi
 // @param b Double containing hyperparameter b
 // @param Z Matrix containing current values of Z
+// @param rng Source of randomness (RRng or a random number engine owned by the calling thread)
+// @param accept_prob Double acting as a placeholder for the acceptance probability
 // @param alpha_3 vector containing all alpha_3
+template <typename Rng>
 inline void updateAlpha3(const arma::vec& pi,
                          const double& b,
                          const arma::mat& Z,
                          const int& iter,
                          const int& tot_mcmc_iters,
                          const double& sigma_alpha_3,
+                         Rng& rng,
+                         double& accept_prob,
                          arma::vec& alpha_3){
 
   // propose new value
-  double alpha_3_ph = r_truncnorm(alpha_3(iter), sigma_alpha_3, 0,
-                                  std::numeric_limits<double>::infinity());
+  double alpha_3_ph = drawTruncnormPositive(alpha_3(iter), sigma_alpha_3, rng);
 
   double lpdf_old = lpdf_alpha3(pi, b, Z, alpha_3(iter), alpha_3_ph, sigma_alpha_3);
 
   double lpdf_new = lpdf_alpha3(pi, b, Z, alpha_3_ph, alpha_3(iter), sigma_alpha_3);
 
   double acceptance_prob = lpdf_new - lpdf_old;
-  double rand_unif_var = R::runif(0,1);
+  accept_prob = calcAcceptanceProb(acceptance_prob);
+
+  if(std::log(drawUnif(rng)) < acceptance_prob){
+    // Accept new state and update parameters
+    alpha_3(iter) = alpha_3_ph;
+  }
+
+  if((tot_mcmc_iters - 1) > iter){
+    alpha_3(iter+1) = alpha_3(iter);
+  }
+}
+
+// Updates the Alpha3 parameter using R's random number generator, recording
+// the acceptance probability of the proposal
+//
+// @name updateAlpha3
+inline void updateAlpha3(const arma::vec& pi,
+                         const double& b,
+                         const arma::mat& Z,
+                         const int& iter,
+                         const int& tot_mcmc_iters,
+                         const double& sigma_alpha_3,
+                         double& accept_prob,
+                         arma::vec& alpha_3){
+  RRng rng;
+  updateAlpha3(pi, b, Z, iter, tot_mcmc_iters, sigma_alpha_3, rng, accept_prob,
+               alpha_3);
+}
+
+// Updates the Alpha3 parameter
+//
+// @name updateAlpha3
+inline void updateAlpha3(const arma::vec& pi,
+                         const double& b,
+                         const arma::mat& Z,
+                         const int& iter,
+                         const int& tot_mcmc_iters,
+                         const double& sigma_alpha_3,
+                         arma::vec& alpha_3){
+  double accept_prob = 0;
+  updateAlpha3(pi, b, Z, iter, tot_mcmc_iters, sigma_alpha_3, accept_prob,
+               alpha_3);
+}
+
+// Gets the log-pdf of alpha_3 from the sums of the log memberships of each
+// feature (sum_i log(Z_ik)), so that the cost does not depend on the number
+// of functions
+//
+// @name lpdf_alpha3
+inline double lpdf_alpha3(const arma::vec& pi,
+                          const double& b,
+                          const arma::vec& log_Z_sum,
+                          const int n_funct,
+                          double& alpha_3,
+                          double& alpha_3_ph,
+                          const double& sigma_alpha_3){
+  double lpdf = (-b) * alpha_3;
+  for(int k = 0; k < pi.n_elem; k++){
+    lpdf = lpdf + (((alpha_3 * pi(k)) - 1) * log_Z_sum(k));
+  }
+  lpdf = lpdf - (n_funct * calc_lB(alpha_3 * pi));
+  lpdf = lpdf + d_truncnorm(alpha_3_ph, alpha_3_ph, sigma_alpha_3, 0,
+                            std::numeric_limits<double>::infinity(), 1);
+  return lpdf;
+}
+
+// Updates the Alpha3 parameter from the sums of the log memberships of each
+// feature, recording the acceptance probability of the proposal
+//
+// @name updateAlpha3
+// @param pi Vector containing current values of pi
+// @param b Double containing hyperparameter b
+// @param log_Z_sum Vector containing the sum of log(Z_ik) over the functions for each feature
+// @param n_funct Int containing the number of functions
+// @param accept_prob Double acting as a placeholder for the acceptance probability
+// @param alpha_3 vector containing all alpha_3
+inline void updateAlpha3(const arma::vec& pi,
+                         const double& b,
+                         const arma::vec& log_Z_sum,
+                         const int n_funct,
+                         const int& iter,
+                         const int& tot_mcmc_iters,
+                         const double& sigma_alpha_3,
+                         double& accept_prob,
+                         arma::vec& alpha_3){
+  double alpha_3_ph = r_truncnorm(alpha_3(iter), sigma_alpha_3, 0,
+                                  std::numeric_limits<double>::infinity());
+
+  double lpdf_old = lpdf_alpha3(pi, b, log_Z_sum, n_funct, alpha_3(iter),
+                                alpha_3_ph, sigma_alpha_3);
+  double lpdf_new = lpdf_alpha3(pi, b, log_Z_sum, n_funct, alpha_3_ph,
+                                alpha_3(iter), sigma_alpha_3);
+
+  double acceptance_prob = lpdf_new - lpdf_old;
+  accept_prob = calcAcceptanceProb(acceptance_prob);
 
-  if(std::log(rand_unif_var) < acceptance_prob){
+  if(std::log(R::runif(0,1)) < acceptance_prob){
     // Accept new state and update parameters
     alpha_3(iter) = alpha_3_ph;
   }
@@ -61,6 +161,41 @@ inline void updateAlpha3(const arma::vec& pi,
     alpha_3(iter+1) = alpha_3(iter);
   }
 }
+
+// Updates the Alpha3 parameter by iterated conditional modes, setting alpha_3
+// to the maximizer of its conditional posterior (the conditional log-density
+// is concave, so the maximizer within a factor of exp(3) of the current value
+// is found by golden section search)
+//
+// @name updateAlpha3ICM
+// @param pi Vector containing current values of pi
+// @param b Double containing hyperparameter b
+// @param Z Matrix containing current values of Z
+// @param iter Int containing current iteration
+// @param tot_mcmc_iters Int containing total number of iterations
+// @param alpha_3 vector containing all alpha_3
+inline void updateAlpha3ICM(const arma::vec& pi,
+                            const double& b,
+                            const arma::mat& Z,
+                            const int& iter,
+                            const int& tot_mcmc_iters,
+                            arma::vec& alpha_3){
+  arma::vec log_Z_sum = arma::sum(arma::log(Z), 0).t();
+  int n_funct = Z.n_rows;
+  auto f = [&](const double x){
+    double lpdf = (-b) * x;
+    for(int k = 0; k < pi.n_elem; k++){
+      lpdf = lpdf + (((x * pi(k)) - 1) * log_Z_sum(k));
+    }
+    return lpdf - (n_funct * calc_lB(x * pi));
+  };
+  maximizePositive(f, 3, 60, alpha_3(iter));
+
+  if((tot_mcmc_iters - 1) > iter){
+    alpha_3(iter+1) = alpha_3(iter);
+  }
+}
+
 }
 
 #endif
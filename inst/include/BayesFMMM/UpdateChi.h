@@ -2,8 +2,112 @@
 #define BayesFMMM_UPDATE_CHI_H
 
 #include <RcppArmadillo.h>
+#include <cmath>
+#include "CovariateEffects.h"
+#include "KernelPolicies.h"
+#include "RaggedObs.h"
+#include "SubjectScheduler.h"
 
 namespace BayesFMMM{
+// Gibbs update of chi for one data model, coefficient policy and tempering
+// policy (see KernelPolicies.h). The scores of each function are updated one
+// at a time from their full conditional, which only depends on the other
+// scores of the same function, so functions are updated in parallel on the
+// subject scheduler. The standard normal draws are taken from R's random
+// number generator beforehand in the order used by the sequential sampler,
+// so the draws do not depend on the number of threads.
+//
+// @name ChiKernel
+template<class Data, class Coefs, class Temper>
+struct ChiKernel{
+  const Data& data;
+  const Coefs& coefs;
+  const Temper& temper;
+  const arma::mat& Z;
+  const double sigma;
+  const arma::mat& e;
+  SubjectScheduler& sched;
+  arma::mat& chi;
+
+  template<int K_, int M_>
+  void run() const{
+    const int M = chi.n_cols;
+    parallelForSubjects(sched, "chi", [&](const int i){
+      double w = 0;
+      double W = 0;
+      Workspace& ws = subjectWorkspace(sched);
+      arma::vec& coef = fitScratch(ws.coef, data.n_basis(), ws.n_alloc);
+      arma::vec& phi_coef = fitScratch(ws.dir, data.n_basis(), ws.n_alloc);
+      for(int m = 0; m < M; m++){
+        // residual after removing the chi_im term
+        coefs.template phiCoef<K_>(i, m, Z, phi_coef);
+        coefs.template meanCoef<K_, M_>(i, Z, chi, coef);
+        coef -= chi(i,m) * phi_coef;
+        data.crossResid(i, phi_coef, coef, w, W);
+        w = temper.scale(w) / sigma;
+        W = 1 + (temper.scale(W) / sigma);
+        W = 1 / W;
+        chi(i,m) = (W*w) + (std::sqrt(W) * e(i,m));
+      }
+    });
+  }
+};
+
+// Updates the chi parameters of any variant of the model
+//
+// @name updateChiKernel
+// @param data Data model containing the observations
+// @param coefs Coefficient policy containing the mean and eigenfunction coefficients
+// @param temper Tempering policy
+// @param Z Matrix containing current Z parameters
+// @param sigma double containing current sigma parameter
+// @param iter Int containing MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param sched SubjectScheduler used to distribute the functions over threads
+// @param chi Cube containing MCMC samples for chi
+template<class Data, class Coefs, class Temper>
+inline void updateChiKernel(const Data& data,
+                            const Coefs& coefs,
+                            const Temper& temper,
+                            const arma::mat& Z,
+                            const double& sigma,
+                            const int& iter,
+                            const int& tot_mcmc_iters,
+                            SubjectScheduler& sched,
+                            arma::cube& chi){
+  // R's random number generator cannot be used inside the parallel region
+  arma::mat e(chi.n_rows, chi.n_cols);
+  for(int i = 0; i < chi.n_rows; i++){
+    for(int m = 0; m < chi.n_cols; m++){
+      e(i,m) = R::norm_rand();
+    }
+  }
+  arma::mat& chi_iter = chi.slice(iter);
+  ChiKernel<Data, Coefs, Temper> kernel = {data, coefs, temper, Z, sigma, e,
+                                           sched, chi_iter};
+  dispatchDims(Z.n_cols, chi.n_cols, kernel);
+  if(iter < (tot_mcmc_iters - 1)){
+    chi.slice(iter + 1) = chi.slice(iter);
+  }
+}
+
+// Updates the chi parameters of any variant of the model
+//
+// @name updateChiKernel
+template<class Data, class Coefs, class Temper>
+inline void updateChiKernel(const Data& data,
+                            const Coefs& coefs,
+                            const Temper& temper,
+                            const arma::mat& Z,
+                            const double& sigma,
+                            const int& iter,
+                            const int& tot_mcmc_iters,
+                            arma::cube& chi){
+  SubjectScheduler sched = makeSubjectScheduler(data.weights());
+  updateChiKernel(data, coefs, temper, Z, sigma, iter, tot_mcmc_iters, sched,
+                  chi);
+}
+
 // Updates the chi parameters
 //
 // @name updateChi
@@ -25,42 +129,10 @@ inline void updateChi(const arma::field<arma::vec>& y_obs,
                       const int& iter,
                       const int& tot_mcmc_iters,
                       arma::cube& chi){
-  double w = 0;
-  double W = 0;
-  double ph = 0;
-  for(int i = 0; i < chi.n_rows; i++){
-    for(int m = 0; m < chi.n_cols; m++){
-      w = 0;
-      W = 0;
-      for(int l = 0; l < y_obs(i,0).n_elem; l++){
-        ph = 0;
-        for(int k2 = 0; k2 < Z.n_cols; k2++){
-          ph = ph + Z(i, k2) * arma::dot(Phi.slice(m).row(k2),
-                      B_obs(i,0).row(l));
-        }
-        w = w + ph * y_obs(i,0)(l);
-        W = W + ph * ph;
-        for(int k1 =0; k1 < Z.n_cols; k1++){
-          if(Z(i,k1) != 0){
-            w = w - Z(i,k1) * ph * arma::dot(nu.row(k1), B_obs(i,0).row(l));
-            for(int n = 0; n < chi.n_cols; n++){
-              if(n != m){
-                w = w - Z(i,k1) * ph * chi(i, n, iter) * arma::dot(Phi.slice(n).row(k1),
-                          B_obs(i,0).row(l));
-              }
-            }
-          }
-        }
-      }
-      w = w / sigma;
-      W = 1 + (W / sigma);
-      W = 1 / W;
-      chi(i, m, iter) = R::rnorm(W*w, std::sqrt(W));
-    }
-  }
-  if(iter < (tot_mcmc_iters - 1)){
-    chi.slice(iter + 1) = chi.slice(iter);
-  }
+  FieldData data = {y_obs, B_obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateChiKernel(data, coefs, Untempered(), Z, sigma, iter, tot_mcmc_iters,
+                  chi);
 }
 
 // Updates the chi parameters using Tempered Transitions
@@ -86,37 +158,182 @@ inline void updateChiTempered(const double& beta_i,
                               const int& iter,
                               const int& tot_mcmc_iters,
                               arma::cube& chi){
-  double w = 0;
-  double W = 0;
-  double ph = 0;
+  FieldData data = {y_obs, B_obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateChiKernel(data, coefs, temper, Z, sigma, iter, tot_mcmc_iters, chi);
+}
+
+// Updates the chi parameters using Tempered Transitions, contiguous
+// observation storage and the subject scheduler
+//
+// @name updateChiTempered
+// @param beta_i Vector containing the current temperature
+// @param obs RaggedObs containing observed values and basis functions
+// @param Phi Cube containing current Phi parameters
+// @param nu Matrix containing current nu parameters
+// @param Z Matrix containing current Z parameters
+// @param sigma double containing current sigma parameter
+// @param iter Int containing MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param sched SubjectScheduler used to distribute the functions over threads
+// @param chi Cube containing MCMC samples for chi
+inline void updateChiTempered(const double& beta_i,
+                              const RaggedObs& obs,
+                              const arma::cube& Phi,
+                              const arma::mat& nu,
+                              const arma::mat& Z,
+                              const double& sigma,
+                              const int& iter,
+                              const int& tot_mcmc_iters,
+                              SubjectScheduler& sched,
+                              arma::cube& chi){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateChiKernel(data, coefs, temper, Z, sigma, iter, tot_mcmc_iters, sched,
+                  chi);
+}
+
+// Updates the chi parameters using Tempered Transitions, single precision
+// observation storage and the subject scheduler
+//
+// @name updateChiTempered
+inline void updateChiTempered(const double& beta_i,
+                              const RaggedObsF& obs,
+                              const arma::cube& Phi,
+                              const arma::mat& nu,
+                              const arma::mat& Z,
+                              const double& sigma,
+                              const int& iter,
+                              const int& tot_mcmc_iters,
+                              SubjectScheduler& sched,
+                              arma::cube& chi){
+  RaggedDataF data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateChiKernel(data, coefs, temper, Z, sigma, iter, tot_mcmc_iters, sched,
+                  chi);
+}
+
+// Updates the chi parameters using Tempered Transitions and contiguous
+// observation storage
+//
+// @name updateChiTempered
+inline void updateChiTempered(const double& beta_i,
+                              const RaggedObs& obs,
+                              const arma::cube& Phi,
+                              const arma::mat& nu,
+                              const arma::mat& Z,
+                              const double& sigma,
+                              const int& iter,
+                              const int& tot_mcmc_iters,
+                              arma::cube& chi){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateChiKernel(data, coefs, temper, Z, sigma, iter, tot_mcmc_iters, chi);
+}
+
+// Updates the chi parameters using contiguous observation storage
+//
+// @name updateChi
+// @param obs RaggedObs containing observed values and basis functions
+// @param Phi Cube containing current Phi parameters
+// @param nu Matrix containing current nu parameters
+// @param Z Matrix containing current Z parameters
+// @param sigma double containing current sigma parameter
+// @param iter Int containing MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param chi Cube containing MCMC samples for chi
+inline void updateChi(const RaggedObs& obs,
+                      const arma::cube& Phi,
+                      const arma::mat& nu,
+                      const arma::mat& Z,
+                      const double& sigma,
+                      const int& iter,
+                      const int& tot_mcmc_iters,
+                      arma::cube& chi){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateChiKernel(data, coefs, Untempered(), Z, sigma, iter, tot_mcmc_iters,
+                  chi);
+}
+
+// Updates the chi parameters using contiguous observation storage and the
+// subject scheduler
+//
+// @name updateChi
+inline void updateChi(const RaggedObs& obs,
+                      const arma::cube& Phi,
+                      const arma::mat& nu,
+                      const arma::mat& Z,
+                      const double& sigma,
+                      const int& iter,
+                      const int& tot_mcmc_iters,
+                      SubjectScheduler& sched,
+                      arma::cube& chi){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateChiKernel(data, coefs, Untempered(), Z, sigma, iter, tot_mcmc_iters,
+                  sched, chi);
+}
+
+// Updates the chi parameters using single precision observation storage and
+// the subject scheduler
+//
+// @name updateChi
+inline void updateChi(const RaggedObsF& obs,
+                      const arma::cube& Phi,
+                      const arma::mat& nu,
+                      const arma::mat& Z,
+                      const double& sigma,
+                      const int& iter,
+                      const int& tot_mcmc_iters,
+                      SubjectScheduler& sched,
+                      arma::cube& chi){
+  RaggedDataF data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateChiKernel(data, coefs, Untempered(), Z, sigma, iter, tot_mcmc_iters,
+                  sched, chi);
+}
+
+
+// Updates the chi parameters by iterated conditional modes, setting the scores
+// of each function to their (joint) conditional posterior mode, i.e. their
+// mean since the conditional is Gaussian (used by the ICM initializer)
+//
+// @name updateChiICM
+// @param obs RaggedObs containing observed values and basis functions
+// @param Phi Cube containing current Phi parameters
+// @param nu Matrix containing current nu parameters
+// @param Z Matrix containing current Z parameters
+// @param sigma double containing current sigma parameter
+// @param iter Int containing current iteration
+// @param tot_mcmc_iters Int containing total number of iterations
+// @param chi Cube containing the estimates of chi at each iteration
+inline void updateChiICM(const RaggedObs& obs,
+                         const arma::cube& Phi,
+                         const arma::mat& nu,
+                         const arma::mat& Z,
+                         const double& sigma,
+                         const int& iter,
+                         const int& tot_mcmc_iters,
+                         arma::cube& chi){
+  arma::mat Phi_Z = arma::zeros(nu.n_cols, chi.n_cols);
+  arma::mat B_Phi;
+  arma::vec resid;
   for(int i = 0; i < chi.n_rows; i++){
-    for(int m = 0; m < chi.n_cols; m++){
-      w = 0;
-      W = 0;
-      for(int l = 0; l < y_obs(i,0).n_elem; l++){
-        ph = 0;
-        for(int k2 = 0; k2 < Z.n_cols; k2++){
-          ph = ph + Z(i, k2) * arma::dot(Phi.slice(m).row(k2),
-                      B_obs(i,0).row(l));
-        }
-        w = w + ph * y_obs(i,0)(l);
-        W = W + ph * ph;
-        for(int k1 =0; k1 < Z.n_cols; k1++){
-          if(Z(i,k1) != 0){
-            w = w - Z(i,k1) * ph * arma::dot(nu.row(k1), B_obs(i,0).row(l));
-            for(int n = 0; n < chi.n_cols; n++){
-              if(n != m){
-                w = w - Z(i,k1) * ph * chi(i, n, iter) * arma::dot(Phi.slice(n).row(k1),
-                          B_obs(i,0).row(l));
-              }
-            }
-          }
-        }
+    if(obs.n_obs(i) > 0){
+      for(int m = 0; m < chi.n_cols; m++){
+        Phi_Z.col(m) = Phi.slice(m).t() * Z.row(i).t();
       }
-      w = (w * beta_i) / sigma;
-      W = 1 + ((W * beta_i) / sigma);
-      W = 1 / W;
-      chi(i, m, iter) = R::rnorm(W*w, std::sqrt(W));
+      B_Phi = obs.B_i(i).t() * Phi_Z;
+      resid = obs.y_i(i) - obs.B_i(i).t() * (nu.t() * Z.row(i).t());
+      chi.slice(iter).row(i) = arma::solve(arma::eye(chi.n_cols, chi.n_cols) +
+        ((B_Phi.t() * B_Phi) / sigma), (B_Phi.t() * resid) / sigma).t();
+    }else{
+      chi.slice(iter).row(i).zeros();
     }
   }
   if(iter < (tot_mcmc_iters - 1)){
@@ -143,34 +360,10 @@ inline void updateChiMV(const arma::mat& y_obs,
                         const int& iter,
                         const int& tot_mcmc_iters,
                         arma::cube& chi){
-  double w = 0;
-  double W = 0;
-  arma::vec ph = arma::zeros(Phi.n_cols);
-  arma::vec ph2 = arma::zeros(Phi.n_cols);
-  for(int i = 0; i < chi.n_rows; i++){
-    for(int m = 0; m < chi.n_cols; m++){
-      w = 0;
-      W = 0;
-      ph = arma::zeros(Phi.n_cols);
-      ph2 = y_obs.row(i).t();
-      for(int k = 0; k < Z.n_cols; k++){
-        ph = ph + Z(i,k) * Phi.slice(m).row(k).t();
-        ph2 = ph2 - Z(i,k) * nu.row(k).t();
-        for(int n = 0; n < Phi.n_slices; n++){
-          if(n != m){
-            ph2 = ph2 - Z(i,k) * chi(i,n, iter) * Phi.slice(n).row(k).t();
-          }
-        }
-      }
-      w = arma::dot(ph, ph2) / sigma;
-      W = 1 + (arma::dot(ph, ph) / sigma);
-      W = 1 / W;
-      chi(i, m, iter) = R::rnorm(W*w, std::sqrt(W));
-    }
-  }
-  if(iter < (tot_mcmc_iters - 1)){
-    chi.slice(iter + 1) = chi.slice(iter);
-  }
+  MVData data = {y_obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateChiKernel(data, coefs, Untempered(), Z, sigma, iter, tot_mcmc_iters,
+                  chi);
 }
 
 // Updates the chi parameters using Tempered Transitions for the multivariate model
@@ -194,34 +387,10 @@ inline void updateChiTemperedMV(const double& beta_i,
                                 const int& iter,
                                 const int& tot_mcmc_iters,
                                 arma::cube& chi){
-  double w = 0;
-  double W = 0;
-  arma::vec ph = arma::zeros(Phi.n_cols);
-  arma::vec ph2 = arma::zeros(Phi.n_cols);
-  for(int i = 0; i < chi.n_rows; i++){
-    for(int m = 0; m < chi.n_cols; m++){
-      w = 0;
-      W = 0;
-      ph = arma::zeros(Phi.n_cols);
-      ph2 = y_obs.row(i).t();
-      for(int k = 0; k < Z.n_cols; k++){
-        ph = ph + Z(i,k) * Phi.slice(m).row(k).t();
-        ph2 = ph2 - Z(i,k) * nu.row(k).t();
-        for(int n = 0; n < Phi.n_slices; n++){
-          if(n != m){
-            ph2 = ph2 - Z(i,k) * chi(i,n, iter) * Phi.slice(n).row(k).t();
-          }
-        }
-      }
-      w = (beta_i * arma::dot(ph, ph2)) / sigma;
-      W = 1 + ((arma::dot(ph, ph) * beta_i) / sigma);
-      W = 1 / W;
-      chi(i, m, iter) = R::rnorm(W*w, std::sqrt(W));
-    }
-  }
-  if(iter < (tot_mcmc_iters - 1)){
-    chi.slice(iter + 1) = chi.slice(iter);
-  }
+  MVData data = {y_obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateChiKernel(data, coefs, temper, Z, sigma, iter, tot_mcmc_iters, chi);
 }
 
 // Updates the chi parameters for the covariate adjusted model
@@ -251,42 +420,10 @@ inline void updateChiCovariateAdj(const arma::field<arma::vec>& y_obs,
                                   const int& tot_mcmc_iters,
                                   const arma::mat& X,
                                   arma::cube& chi){
-  double w = 0;
-  double W = 0;
-  double ph = 0;
-  for(int i = 0; i < chi.n_rows; i++){
-    for(int m = 0; m < chi.n_cols; m++){
-      w = 0;
-      W = 0;
-      for(int l = 0; l < y_obs(i,0).n_elem; l++){
-        ph = 0;
-        for(int k2 = 0; k2 < Z.n_cols; k2++){
-          ph = ph + Z(i, k2) * arma::dot(Phi.slice(m).row(k2).t() + (xi(iter,k2).slice(m) * X.row(i).t()),
-                      B_obs(i,0).row(l));
-        }
-        w = w + ph * y_obs(i,0)(l);
-        W = W + ph * ph;
-        for(int k1 =0; k1 < Z.n_cols; k1++){
-          if(Z(i,k1) != 0){
-            w = w - Z(i,k1) * ph * arma::dot(nu.row(k1).t() + (eta.slice(k1) * X.row(i).t()), B_obs(i,0).row(l));
-            for(int n = 0; n < chi.n_cols; n++){
-              if(n != m){
-                w = w - Z(i,k1) * ph * chi(i, n, iter) * arma::dot(Phi.slice(n).row(k1).t() +
-                  (xi(iter,k1).slice(n) * X.row(i).t()), B_obs(i,0).row(l));
-              }
-            }
-          }
-        }
-      }
-      w = w / sigma;
-      W = 1 + (W / sigma);
-      W = 1 / W;
-      chi(i, m, iter) = R::rnorm(W*w, std::sqrt(W));
-    }
-  }
-  if(iter < (tot_mcmc_iters - 1)){
-    chi.slice(iter + 1) = chi.slice(iter);
-  }
+  FieldData data = {y_obs, B_obs};
+  CovariateCoefs coefs = {nu, eta, Phi, xi, iter, X};
+  updateChiKernel(data, coefs, Untempered(), Z, sigma, iter, tot_mcmc_iters,
+                  chi);
 }
 
 // Updates the chi parameters for the covariate adjusted model
@@ -318,42 +455,60 @@ inline void updateChiTemperedCovariateAdj(const double& beta_i,
                                           const int& tot_mcmc_iters,
                                           const arma::mat& X,
                                           arma::cube& chi){
-  double w = 0;
-  double W = 0;
-  double ph = 0;
-  for(int i = 0; i < chi.n_rows; i++){
-    for(int m = 0; m < chi.n_cols; m++){
-      w = 0;
-      W = 0;
-      for(int l = 0; l < y_obs(i,0).n_elem; l++){
-        ph = 0;
-        for(int k2 = 0; k2 < Z.n_cols; k2++){
-          ph = ph + Z(i, k2) * arma::dot(Phi.slice(m).row(k2).t() + (xi(iter,k2).slice(m) * X.row(i).t()),
-                      B_obs(i,0).row(l));
-        }
-        w = w + ph * y_obs(i,0)(l);
-        W = W + ph * ph;
-        for(int k1 =0; k1 < Z.n_cols; k1++){
-          if(Z(i,k1) != 0){
-            w = w - Z(i,k1) * ph * arma::dot(nu.row(k1).t() + (eta.slice(k1) * X.row(i).t()), B_obs(i,0).row(l));
-            for(int n = 0; n < chi.n_cols; n++){
-              if(n != m){
-                w = w - Z(i,k1) * ph * chi(i, n, iter) * arma::dot(Phi.slice(n).row(k1).t() +
-                  (xi(iter,k1).slice(n) * X.row(i).t()), B_obs(i,0).row(l));
-              }
-            }
-          }
-        }
-      }
-      w = (w * beta_i) / sigma;
-      W = 1 + ((W * beta_i) / sigma);
-      W = 1 / W;
-      chi(i, m, iter) = R::rnorm(W*w, std::sqrt(W));
-    }
-  }
-  if(iter < (tot_mcmc_iters - 1)){
-    chi.slice(iter + 1) = chi.slice(iter);
-  }
+  FieldData data = {y_obs, B_obs};
+  CovariateCoefs coefs = {nu, eta, Phi, xi, iter, X};
+  Tempered temper = {beta_i};
+  updateChiKernel(data, coefs, temper, Z, sigma, iter, tot_mcmc_iters, chi);
+}
+
+// Updates the chi parameters for the covariate adjusted model using Tempered
+// Transitions and the cached covariate adjusted coefficients
+//
+// @name updateChiTemperedCovariateAdj
+// @param beta_i Double containing the current temperature
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients
+// @param Z Matrix containing current Z parameters
+// @param sigma double containing current sigma parameter
+// @param iter Int containing MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param chi Cube containing MCMC samples for chi
+inline void updateChiTemperedCovariateAdj(const double& beta_i,
+                                          const RaggedObs& obs,
+                                          const CovariateEffects& cov,
+                                          const arma::mat& Z,
+                                          const double& sigma,
+                                          const int& iter,
+                                          const int& tot_mcmc_iters,
+                                          arma::cube& chi){
+  RaggedData data = {obs};
+  CachedCovariateCoefs coefs = {cov};
+  Tempered temper = {beta_i};
+  updateChiKernel(data, coefs, temper, Z, sigma, iter, tot_mcmc_iters, chi);
+}
+
+// Updates the chi parameters for the covariate adjusted model using the
+// cached covariate adjusted coefficients
+//
+// @name updateChiCovariateAdj
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients
+// @param Z Matrix containing current Z parameters
+// @param sigma double containing current sigma parameter
+// @param iter Int containing MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param chi Cube containing MCMC samples for chi
+inline void updateChiCovariateAdj(const RaggedObs& obs,
+                                  const CovariateEffects& cov,
+                                  const arma::mat& Z,
+                                  const double& sigma,
+                                  const int& iter,
+                                  const int& tot_mcmc_iters,
+                                  arma::cube& chi){
+  RaggedData data = {obs};
+  CachedCovariateCoefs coefs = {cov};
+  updateChiKernel(data, coefs, Untempered(), Z, sigma, iter, tot_mcmc_iters,
+                  chi);
 }
 
 // Updates the chi parameters for the covariate adjusted multivariate model
@@ -378,36 +533,10 @@ inline void updateChiMVCovariateAdj(const arma::mat& y_obs,
                                     const int& tot_mcmc_iters,
                                     const arma::mat& X,
                                     arma::cube& chi){
-  double w = 0;
-  double W = 0;
-  arma::vec ph = arma::zeros(Phi.n_cols);
-  arma::vec ph2 = arma::zeros(Phi.n_cols);
-  for(int i = 0; i < chi.n_rows; i++){
-    for(int m = 0; m < chi.n_cols; m++){
-      w = 0;
-      W = 0;
-      ph = arma::zeros(Phi.n_cols);
-      ph2 = y_obs.row(i).t();
-      for(int k = 0; k < Z.n_cols; k++){
-        ph = ph + Z(i,k) * (Phi.slice(m).row(k).t() +
-          (xi(iter,k).slice(m) * X.row(i).t()));
-        ph2 = ph2 - Z(i,k) * (nu.row(k).t() + (eta.slice(k) * X.row(i).t()));
-        for(int n = 0; n < Phi.n_slices; n++){
-          if(n != m){
-            ph2 = ph2 - Z(i,k) * chi(i,n, iter) * (Phi.slice(n).row(k).t() +
-              xi(iter,k).slice(n) * X.row(i).t());
-          }
-        }
-      }
-      w = arma::dot(ph, ph2) / sigma;
-      W = 1 + (arma::dot(ph, ph) / sigma);
-      W = 1 / W;
-      chi(i, m, iter) = R::rnorm(W*w, std::sqrt(W));
-    }
-  }
-  if(iter < (tot_mcmc_iters - 1)){
-    chi.slice(iter + 1) = chi.slice(iter);
-  }
+  MVData data = {y_obs};
+  CovariateCoefs coefs = {nu, eta, Phi, xi, iter, X};
+  updateChiKernel(data, coefs, Untempered(), Z, sigma, iter, tot_mcmc_iters,
+                  chi);
 }
 
 // Updates the chi parameters for the tempered multivariate covariate adjusted model
@@ -434,36 +563,10 @@ inline void updateChiTemperedMVCovariateAdj(const double& beta_i,
                                             const int& tot_mcmc_iters,
                                             const arma::mat& X,
                                             arma::cube& chi){
-  double w = 0;
-  double W = 0;
-  arma::vec ph = arma::zeros(Phi.n_cols);
-  arma::vec ph2 = arma::zeros(Phi.n_cols);
-  for(int i = 0; i < chi.n_rows; i++){
-    for(int m = 0; m < chi.n_cols; m++){
-      w = 0;
-      W = 0;
-      ph = arma::zeros(Phi.n_cols);
-      ph2 = y_obs.row(i).t();
-      for(int k = 0; k < Z.n_cols; k++){
-        ph = ph + Z(i,k) * (Phi.slice(m).row(k).t() +
-          (xi(iter,k).slice(m) * X.row(i).t()));
-        ph2 = ph2 - Z(i,k) * (nu.row(k).t() + (eta.slice(k) * X.row(i).t()));
-        for(int n = 0; n < Phi.n_slices; n++){
-          if(n != m){
-            ph2 = ph2 - Z(i,k) * chi(i,n, iter) * (Phi.slice(n).row(k).t() +
-              xi(iter,k).slice(n) * X.row(i).t());
-          }
-        }
-      }
-      w = (beta_i * arma::dot(ph, ph2)) / sigma;
-      W = 1 + ((arma::dot(ph, ph) * beta_i) / sigma);
-      W = 1 / W;
-      chi(i, m, iter) = R::rnorm(W*w, std::sqrt(W));
-    }
-  }
-  if(iter < (tot_mcmc_iters - 1)){
-    chi.slice(iter + 1) = chi.slice(iter);
-  }
+  MVData data = {y_obs};
+  CovariateCoefs coefs = {nu, eta, Phi, xi, iter, X};
+  Tempered temper = {beta_i};
+  updateChiKernel(data, coefs, temper, Z, sigma, iter, tot_mcmc_iters, chi);
 }
 
 }
@@ -3,6 +3,8 @@
 
 #include <RcppArmadillo.h>
 #include <cmath>
+#include <random>
+#include "Distributions.h"
 
 namespace BayesFMMM{
 // Updates the delta parameters for individualized covariance matrix
@@ -13,12 +15,15 @@ namespace BayesFMMM{
 // @param a Cube containing current values of a
 // @param iter Int containing MCMC current iteration number
 // @parma tot_mcmc_iters Int containing total number of MCMC iterations
+// @param rng Source of randomness (RRng or a random number engine owned by the calling thread)
 // @param delta Cube containing values of delta
+template <typename Rng>
 inline void updateDelta(const arma::cube& phi,
                         const arma::cube& gamma,
                         const arma::mat& a,
                         const int& iter,
                         const int& tot_mcmc_iters,
+                        Rng& rng,
                         arma::cube& delta){
   double param1 = 0;
   double param2 = 0;
@@ -39,7 +44,6 @@ inline void updateDelta(const arma::cube& phi,
             param2 = param2 + (0.5 * gamma(k, j, m) * tilde_tau * std::pow(phi(k, j, m), 2.0));
           }
         }
-        delta(k, i, iter) = R::rgamma(param1, 1/param2);
       }else{
         param1 = a(k,1) + ((phi.n_cols * (phi.n_slices - i)) / 2.0);
         param2 = 1;
@@ -54,8 +58,8 @@ inline void updateDelta(const arma::cube& phi,
             param2 = param2 + (0.5 * gamma(k, j, m) * tilde_tau * std::pow(phi(k, j, m), 2.0));
           }
         }
-        delta(k, i, iter) = R::rgamma(param1, 1/param2);
       }
+      delta(k, i, iter) = drawGamma(param1, 1/param2, rng);
     }
   }
   if(iter < (tot_mcmc_iters - 1)){
@@ -63,6 +67,19 @@ inline void updateDelta(const arma::cube& phi,
   }
 }
 
+// Updates the delta parameters for individualized covariance matrix using R's
+// random number generator
+//
+// @name updateDelta
+inline void updateDelta(const arma::cube& phi,
+                        const arma::cube& gamma,
+                        const arma::mat& a,
+                        const int& iter,
+                        const int& tot_mcmc_iters,
+                        arma::cube& delta){
+  RRng rng;
+  updateDelta(phi, gamma, a, iter, tot_mcmc_iters, rng, delta);
+}
 
 // Updates the delta parameters for individualized covariance matrix
 //
@@ -3,6 +3,9 @@
 
 #include <RcppArmadillo.h>
 #include <cmath>
+#include "CovariateEffects.h"
+#include "RaggedObs.h"
+#include "Workspace.h"
 
 namespace BayesFMMM{
 
@@ -53,7 +56,7 @@ inline void updateEta(const arma::field<arma::vec>& y_obs,
           for(int l = 0; l < y_obs(i,0).n_elem; l++){
             ph = 0;
             ph = y_obs(i,0)(l);
-            B_1 = B_1 + Z(i,j) * Z(i,j) * X(i,d) * X(i,d) * (B_obs(i,0).row(l).t() * B_obs(i,0).row(l));
+            addOuterRow(B_obs(i,0), l, Z(i,j) * Z(i,j) * X(i,d) * X(i,d), B_1);
             for(int r = 0; r < eta.n_cols; r++){
               if(r != d){
                 ph = ph - Z(i,j) * X(i,r) * arma::dot(eta(iter,0).slice(j).col(r), B_obs(i,0).row(l));
@@ -75,7 +78,7 @@ inline void updateEta(const arma::field<arma::vec>& y_obs,
                 }
               }
             }
-            b_1 = b_1 + Z(i,j) * B_obs(i,0).row(l).t() * ph;
+            addScaledRow(B_obs(i,0), l, Z(i,j) * ph, b_1);
           }
         }
       }
@@ -142,7 +145,7 @@ inline void updateEtaTempered(const double& beta_i,
           for(int l = 0; l < y_obs(i,0).n_elem; l++){
             ph = 0;
             ph = y_obs(i,0)(l);
-            B_1 = B_1 + Z(i,j) * Z(i,j) * X(i,d) * X(i,d) * (B_obs(i,0).row(l).t() * B_obs(i,0).row(l));
+            addOuterRow(B_obs(i,0), l, Z(i,j) * Z(i,j) * X(i,d) * X(i,d), B_1);
             for(int r = 0; r < eta.n_cols; r++){
               if(r != d){
                 ph = ph - Z(i,j) * X(i,r) * arma::dot(eta(iter,0).slice(j).col(r), B_obs(i,0).row(l));
@@ -164,7 +167,7 @@ inline void updateEtaTempered(const double& beta_i,
                 }
               }
             }
-            b_1 = b_1 + Z(i,j) * B_obs(i,0).row(l).t() * ph;
+            addScaledRow(B_obs(i,0), l, Z(i,j) * ph, b_1);
           }
         }
       }
@@ -182,6 +185,110 @@ inline void updateEtaTempered(const double& beta_i,
   }
 }
 
+// Updates the eta parameters using tempered transitions and the cached
+// covariate adjusted coefficients
+//
+// @name updateEtaTempered
+// @param beta_i temperature at current step
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients (updated after each draw)
+// @param tau_eta matrix containing current tau_eta parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param sigma Double containing current sigma parameter
+// @param iter Int containing MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param P Matrix containing tridiagonal P matrix
+// @param X Matrix containing covariates
+// @param b_1 Vector acting as a placeholder for mean vector
+// @param B_1 Matrix acting as placeholder for covariance matrix
+// @param eta Field of cubes containing MCMC samples for eta
+inline void updateEtaTempered(const double& beta_i,
+                              const RaggedObs& obs,
+                              CovariateEffects& cov,
+                              const arma::mat& tau_eta,
+                              const arma::mat& Z,
+                              const arma::mat& chi,
+                              const double& sigma,
+                              const int& iter,
+                              const int& tot_mcmc_iters,
+                              const arma::mat& P,
+                              const arma::mat& X,
+                              arma::vec& b_1,
+                              arma::mat& B_1,
+                              arma::field<arma::cube>& eta){
+  arma::vec coef = arma::zeros(P.n_rows);
+  arma::vec resid;
+  arma::vec eta_old;
+  for(int d = 0; d < eta(iter,0).n_cols; d++){
+    for(int j = 0; j < eta(iter,0).n_slices; j++){
+      b_1.zeros();
+      B_1.zeros();
+      for(int i = 0; i < Z.n_rows; i++){
+        if((Z(i,j) != 0) && (X(i,d) != 0) && (obs.n_obs(i) > 0)){
+          // residual after removing every term except eta_jd
+          calcMeanCoef(cov, i, Z.row(i), chi.row(i), coef);
+          coef = coef - Z(i,j) * X(i,d) * eta(iter,0).slice(j).col(d);
+          resid = obs.y_i(i) - obs.B_i(i).t() * coef;
+          B_1 = B_1 + Z(i,j) * Z(i,j) * X(i,d) * X(i,d) *
+            (obs.B_i(i) * obs.B_i(i).t());
+          b_1 = b_1 + Z(i,j) * X(i,d) * (obs.B_i(i) * resid);
+        }
+      }
+      b_1 = b_1 * (beta_i / sigma);
+      B_1 = B_1 * (beta_i / sigma);
+      B_1 = B_1 + tau_eta(j,d) * P;
+      B_1 = arma::pinv(B_1);
+      B_1 = (B_1 + B_1.t())/2;
+      eta_old = eta(iter,0).slice(j).col(d);
+      eta(iter,0).slice(j).col(d) = arma::mvnrnd(B_1 * b_1, B_1);
+
+      // propagate the change to the covariate adjusted mean of each function
+      eta_old = eta(iter,0).slice(j).col(d) - eta_old;
+      for(int i = 0; i < Z.n_rows; i++){
+        cov.nu.slice(i).row(j) += X(i,d) * eta_old.t();
+      }
+    }
+  }
+
+  if(iter < (tot_mcmc_iters - 1)){
+    eta(iter + 1,0) = eta(iter,0);
+  }
+}
+
+// Updates the eta parameters using the cached covariate adjusted coefficients
+//
+// @name updateEta
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients (updated after each draw)
+// @param tau_eta matrix containing current tau_eta parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param sigma Double containing current sigma parameter
+// @param iter Int containing MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param P Matrix containing tridiagonal P matrix
+// @param X Matrix containing covariates
+// @param b_1 Vector acting as a placeholder for mean vector
+// @param B_1 Matrix acting as placeholder for covariance matrix
+// @param eta Field of cubes containing MCMC samples for eta
+inline void updateEta(const RaggedObs& obs,
+                      CovariateEffects& cov,
+                      const arma::mat& tau_eta,
+                      const arma::mat& Z,
+                      const arma::mat& chi,
+                      const double& sigma,
+                      const int& iter,
+                      const int& tot_mcmc_iters,
+                      const arma::mat& P,
+                      const arma::mat& X,
+                      arma::vec& b_1,
+                      arma::mat& B_1,
+                      arma::field<arma::cube>& eta){
+  updateEtaTempered(1.0, obs, cov, tau_eta, Z, chi, sigma, iter, tot_mcmc_iters,
+                    P, X, b_1, B_1, eta);
+}
+
 // Updates the eta parameters for multivariate model
 //
 // @name updateEtaMV
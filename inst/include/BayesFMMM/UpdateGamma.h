@@ -3,6 +3,8 @@
 
 #include <RcppArmadillo.h>
 #include <cmath>
+#include <random>
+#include "Distributions.h"
 
 namespace BayesFMMM{
 // Updates the gamma parameters
@@ -12,13 +14,15 @@ namespace BayesFMMM{
 // @param iter int containing MCMC iteration
 // @param delta Matrix containing current values of delta
 // @param phi Cube containing current values of phi
-// @param Z matrix containing current values of class inclusion
+// @param rng Source of randomness (RRng or a random number engine owned by the calling thread)
 // @param gamma Field of cubes contianing MCMC samples for gamma
+template <typename Rng>
 inline void updateGamma(const double& nu_gamma,
                         const arma::mat& delta,
                         const arma::cube& phi,
                         const int& iter,
                         const int& tot_mcmc_iters,
+                        Rng& rng,
                         arma::field<arma::cube>& gamma){
   double placeholder = 1;
   for(int i = 0; i < phi.n_rows; i++){
@@ -26,8 +30,8 @@ inline void updateGamma(const double& nu_gamma,
       placeholder = 1;
       for(int j = 0; j < phi.n_slices; j++){
         placeholder = placeholder * delta(i, j);
-        gamma(iter,0)(i,l,j) = R::rgamma((nu_gamma + 1)/2, 2/(nu_gamma + placeholder *
-          (phi(i,l,j) * phi(i,l,j))));
+        gamma(iter,0)(i,l,j) = drawGamma((nu_gamma + 1)/2, 2/(nu_gamma + placeholder *
+          (phi(i,l,j) * phi(i,l,j))), rng);
       }
     }
   }
@@ -36,6 +40,19 @@ inline void updateGamma(const double& nu_gamma,
   }
 }
 
+// Updates the gamma parameters using R's random number generator
+//
+// @name updateGamma
+inline void updateGamma(const double& nu_gamma,
+                        const arma::mat& delta,
+                        const arma::cube& phi,
+                        const int& iter,
+                        const int& tot_mcmc_iters,
+                        arma::field<arma::cube>& gamma){
+  RRng rng;
+  updateGamma(nu_gamma, delta, phi, iter, tot_mcmc_iters, rng, gamma);
+}
+
 // Updates the gamma_xi parameters for the covariate adjusted model
 //
 // @name updateGammaXi
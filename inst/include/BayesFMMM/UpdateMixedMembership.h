@@ -3,113 +3,225 @@
 
 #include <RcppArmadillo.h>
 #include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "ConditionalModes.h"
+#include "CovariateEffects.h"
 #include "Distributions.h"
+#include "KernelPolicies.h"
+#include "RaggedObs.h"
+#include "SubjectScheduler.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace BayesFMMM{
-// Gets log-pdf of z_i given zeta_{-z_i}
+// Calculates the probability that we propose a state given we are in another state
 //
-// @name lpdf_z
-// @param y_obs Vector containing y at observed time points
-// @param B_obs Matrix containing basis functions evaluated at observed time points
-// @param Phi Cube containing Phi parameters
-// @param nu Matrix containing nu parameters
-// @param pi vector containing the elements of pi
-// @param Z Vector containing the ith row of Z
-// @param sigma_sq double containing the sigma_sq variable
-// @return lpdf_z double containing the log-pdf
-inline double lpdf_z(const arma::vec& y_obs,
-                     const arma::mat& B_obs,
-                     const arma::cube& Phi,
-                     const arma::mat& nu,
-                     const arma::rowvec& chi,
-                     const arma::vec& pi,
-                     const arma::rowvec& Z,
-                     const double& alpha_3,
-                     const int& num,
-                     const double& sigma_sq){
-  double lpdf = 0;
-  double mean = 0;
-
-  for(int l = 0; l < pi.n_elem; l++){
-    lpdf = lpdf + ((alpha_3* pi(l) - 1) * std::log(Z(l)));
+// @name Z_proposal_density
+// @param Z Vector containing state we are proposing
+// @param alpha Vector containing parameters used to propose the proposed state
+inline double Z_proposal_density(const arma::vec& Z,
+                                 const arma::vec& alpha)
+{
+  double density = 0;
+  for(int i = 0; i < Z.n_elem; i++){
+    density = density + (alpha(i) - 1) * std::log(Z(i));
   }
 
-  for(int l = 0; l < B_obs.n_rows; l++){
-    mean = 0;
-    for(int k = 0; k < pi.n_elem; k++){
-      mean = mean + Z(k) * arma::dot(nu.row(k), B_obs.row(l).t());
-      for(int n = 0; n < Phi.n_slices; n++){
-        mean = mean + Z(k) * chi(n) * arma::dot(Phi.slice(n).row(k),
-                        B_obs.row(l).t());
-      }
-    }
-    lpdf = lpdf - (std::pow(y_obs(l) - mean, 2.0) / (2 * sigma_sq));
-  }
+  density = density - calc_lB(alpha);
 
-  return lpdf;
+  return density;
 }
 
-// Gets log-pdf of z_i given zeta_{-z_i} using tempered trasitions
+// Metropolis-Hastings update of Z for one data model, coefficient policy and
+// tempering policy (see KernelPolicies.h). Each row of Z is proposed from a
+// Dirichlet distribution centred at its current value. The proposals and the
+// uniform draws are taken from R's random number generator beforehand in the
+// order used by the sequential sampler, and since the acceptance of a row
+// only depends on that row, the functions are then updated in parallel on the
+// subject scheduler (the draws do not depend on the number of threads).
 //
-// @name lpdf_zTempered
-// @param beta_i Double containing current temperature
-// @param y_obs Vector containing y at observed time points
-// @param B_obs Matrix containing basis functions evaluated at observed time points
-// @param Phi Cube containing Phi parameters
-// @param nu Matrix containing nu parameters
-// @param pi vector containing the elements of pi
-// @param Z Vector containing the ith row of Z
-// @param sigma_sq double containing the sigma_sq variable
-// @return lpdf_z double contianing the log-pdf
-inline double lpdf_zTempered(const double& beta_i,
-                             const arma::vec& y_obs,
-                             const arma::mat& B_obs,
-                             const arma::cube& Phi,
-                             const arma::mat& nu,
-                             const arma::rowvec& chi,
-                             const arma::vec& pi,
-                             const arma::rowvec& Z,
-                             const double& alpha_3,
-                             const int& num,
-                             const double& sigma_sq){
-  double lpdf = 0;
-  double mean = 0;
+// @name ZKernel
+template<class Data, class Coefs, class Temper>
+struct ZKernel{
+  const Data& data;
+  const Coefs& coefs;
+  const Temper& temper;
+  const arma::mat& chi;
+  const arma::vec& pi;
+  const double sigma_sq;
+  const double alpha_3;
+  const arma::vec& a_Z_PM;
+  const arma::mat& Z_prop;
+  const arma::vec& u;
+  SubjectScheduler& sched;
+  arma::vec& accept_prob;
+  arma::mat& Z;
+
+  template<int K_, int M_>
+  void run() const{
+    const int K = (K_ > 0) ? K_ : Z.n_cols;
+    parallelForSubjects(sched, "Z", [&](const int i){
+      Workspace& ws = subjectWorkspace(sched);
+      arma::vec& coef = fitScratch(ws.coef, data.n_basis(), ws.n_alloc);
+      arma::vec& alpha = fitScratch(ws.prop_alpha, K, ws.n_alloc);
+      double z_lpdf = 0;
+      double z_new_lpdf = 0;
+      double lpdf_propose_new = 0;
+      double lpdf_propose_old = 0;
+      bool boundary = false;
+      for(int k = 0; k < K; k++){
+        z_lpdf = z_lpdf + ((alpha_3 * pi(k) - 1) * std::log(Z.at(i,k)));
+        z_new_lpdf = z_new_lpdf + ((alpha_3 * pi(k) - 1) *
+          std::log(Z_prop.at(i,k)));
+        boundary = boundary || (Z.at(i,k) <= 0);
+      }
 
-  for(int l = 0; l < pi.n_elem; l++){
-    lpdf = lpdf + ((alpha_3* pi(l) - 1) * std::log(Z(l)));
-  }
+      // Get old and new state log pdf
+      coefs.template meanCoef<K_, M_>(i, Z, chi, coef);
+      z_lpdf = z_lpdf - (temper.scale(data.rss(i, coef)) / (2 * sigma_sq));
+      coefs.template meanCoef<K_, M_>(i, Z_prop, chi, coef);
+      z_new_lpdf = z_new_lpdf -
+        (temper.scale(data.rss(i, coef)) / (2 * sigma_sq));
+
+      // Get proposal densities
+      for(int k = 0; k < K; k++){
+        alpha(k) = a_Z_PM(i) * Z.at(i,k);
+        lpdf_propose_new = lpdf_propose_new +
+          ((alpha(k) - 1) * std::log(Z_prop.at(i,k)));
+      }
+      lpdf_propose_new = lpdf_propose_new - calc_lB(alpha);
+      for(int k = 0; k < K; k++){
+        alpha(k) = a_Z_PM(i) * Z_prop.at(i,k);
+        lpdf_propose_old = lpdf_propose_old +
+          ((alpha(k) - 1) * std::log(Z.at(i,k)));
+      }
+      lpdf_propose_old = lpdf_propose_old - calc_lB(alpha);
 
-  for(int l = 0; l < B_obs.n_rows; l++){
-    mean = 0;
-    for(int k = 0; k < pi.n_elem; k++){
-      mean = mean + Z(k) * arma::dot(nu.row(k), B_obs.row(l).t());
-      for(int n = 0; n < Phi.n_slices; n++){
-        mean = mean + Z(k) * chi(n) * arma::dot(Phi.slice(n).row(k),
-                        B_obs.row(l).t());
+      double acceptance_prob = z_new_lpdf - z_lpdf + lpdf_propose_old -
+        lpdf_propose_new;
+      if(boundary){
+        acceptance_prob = 1;
       }
+      accept_prob(i) = calcAcceptanceProb(acceptance_prob);
+
+      if(std::log(u(i)) < acceptance_prob){
+        // Accept new state and update parameters
+        for(int k = 0; k < K; k++){
+          Z.at(i,k) = Z_prop.at(i,k);
+        }
+      }
+    });
+  }
+};
+
+// Updates the Z matrix of any variant of the model, using a separate proposal
+// concentration for each function and recording the acceptance probability of
+// each proposal
+//
+// @name updateZKernel
+// @param data Data model containing the observations
+// @param coefs Coefficient policy containing the mean and eigenfunction coefficients
+// @param temper Tempering policy
+// @param chi Matrix containing current chi parameters
+// @param pi Vector containing the elements of pi
+// @param sigma_sq Double containing the sigma_sq variable
+// @param iter Int containing current mcmc iteration
+// @param tot_mcmc_iters Int containing total number of mcmc iterations
+// @param alpha_3 double containing current value of alpha_3
+// @param a_Z_PM Vector containing hyperparameter for sampling each row of Z
+// @param sched SubjectScheduler used to distribute the functions over threads
+// @param Z_ph Vector that acts as a placeholder for the proposals
+// @param accept_prob Vector acting as a placeholder for the acceptance probability of each row of Z
+// @param Z Cube that contains all past, current, and future MCMC draws
+template<class Data, class Coefs, class Temper>
+inline void updateZKernel(const Data& data,
+                          const Coefs& coefs,
+                          const Temper& temper,
+                          const arma::mat& chi,
+                          const arma::vec& pi,
+                          const double& sigma_sq,
+                          const int& iter,
+                          const int& tot_mcmc_iters,
+                          const double& alpha_3,
+                          const arma::vec& a_Z_PM,
+                          SubjectScheduler& sched,
+                          arma::vec& Z_ph,
+                          arma::vec& accept_prob,
+                          arma::cube& Z){
+  // R's random number generator cannot be used inside the parallel region
+  Workspace& ws = sched.serial;
+  arma::mat& Z_prop = fitScratch(ws.prop, Z.n_rows, Z.n_cols, ws.n_alloc);
+  arma::vec& u = fitScratch(ws.unif, Z.n_rows, ws.n_alloc);
+  arma::vec& alpha = fitScratch(ws.prop_alpha, Z.n_cols, ws.n_alloc);
+  for(int i = 0; i < Z.n_rows; i++){
+    for(int k = 0; k < Z.n_cols; k++){
+      alpha(k) = a_Z_PM(i) * Z(i,k,iter);
+    }
+    rdirichlet(alpha, Z_ph);
+    for(int k = 0; k < Z.n_cols; k++){
+      Z_prop(i,k) = Z_ph(k);
     }
-    lpdf = lpdf - (beta_i * (std::pow(y_obs(l) - mean, 2.0) / (2 * sigma_sq)));
+    u(i) = R::runif(0,1);
   }
+  accept_prob.set_size(Z.n_rows);
+  arma::mat& Z_iter = Z.slice(iter);
+  ZKernel<Data, Coefs, Temper> kernel = {data, coefs, temper, chi, pi,
+                                         sigma_sq, alpha_3, a_Z_PM, Z_prop, u,
+                                         sched, accept_prob, Z_iter};
+  dispatchDims(Z.n_cols, chi.n_cols, kernel);
 
-  return lpdf;
+  // Update next iteration
+  if(iter < (tot_mcmc_iters - 1)){
+    Z.slice(iter + 1) = Z.slice(iter);
+  }
 }
 
-// Calculates the probability that we propose a state given we are in another state
+// Updates the Z matrix of any variant of the model
 //
-// @name Z_proposal_density
-// @param Z Vector containing state we are proposing
-// @param alpha Vector containing parameters used to propose the proposed state
-inline double Z_proposal_density(const arma::vec& Z,
-                                 const arma::vec& alpha)
-{
-  double density = 0;
-  for(int i = 0; i < Z.n_elem; i++){
-    density = density + (alpha(i) - 1) * std::log(Z(i));
-  }
-
-  density = density - calc_lB(alpha);
+// @name updateZKernel
+template<class Data, class Coefs, class Temper>
+inline void updateZKernel(const Data& data,
+                          const Coefs& coefs,
+                          const Temper& temper,
+                          const arma::mat& chi,
+                          const arma::vec& pi,
+                          const double& sigma_sq,
+                          const int& iter,
+                          const int& tot_mcmc_iters,
+                          const double& alpha_3,
+                          const arma::vec& a_Z_PM,
+                          arma::vec& Z_ph,
+                          arma::vec& accept_prob,
+                          arma::cube& Z){
+  SubjectScheduler sched = makeSubjectScheduler(data.weights());
+  updateZKernel(data, coefs, temper, chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, sched, Z_ph, accept_prob, Z);
+}
 
-  return density;
+// Updates the Z matrix of any variant of the model using the same proposal
+// concentration for every function
+//
+// @name updateZKernel
+template<class Data, class Coefs, class Temper>
+inline void updateZKernel(const Data& data,
+                          const Coefs& coefs,
+                          const Temper& temper,
+                          const arma::mat& chi,
+                          const arma::vec& pi,
+                          const double& sigma_sq,
+                          const int& iter,
+                          const int& tot_mcmc_iters,
+                          const double& alpha_3,
+                          const double& a_Z_PM,
+                          arma::vec& Z_ph,
+                          arma::cube& Z){
+  arma::vec a_Z = a_Z_PM * arma::ones(Z.n_rows);
+  arma::vec accept_prob(Z.n_rows);
+  updateZKernel(data, coefs, temper, chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z, Z_ph, accept_prob, Z);
 }
 
 // Updates the Z Matrix
@@ -141,47 +253,10 @@ inline void updateZ_PM(const arma::field<arma::vec>& y_obs,
                        const double& a_Z_PM,
                        arma::vec& Z_ph,
                        arma::cube& Z){
-  double z_lpdf = 0;
-  double z_new_lpdf = 0;
-  double lpdf_propose_new = 0;
-  double lpdf_propose_old = 0;
-  double acceptance_prob = 0;
-  double rand_unif_var = 0;
-
-  for(int i = 0; i < Z.n_rows; i++){
-    // Propose new state
-    Z_ph = rdirichlet(a_Z_PM * Z.slice(iter).row(i).t());
-
-    // Get old state log pdf
-    z_lpdf = lpdf_z(y_obs(i,0), B_obs(i,0),Phi, nu, chi.row(i), pi,
-                    Z.slice(iter).row(i), alpha_3, i, sigma_sq);
-
-    // Get new state log pdf
-    z_new_lpdf = lpdf_z(y_obs(i,0), B_obs(i,0), Phi, nu, chi.row(i), pi,
-                        Z_ph.t(), alpha_3, i, sigma_sq);
-
-    // Get proposal densities
-    lpdf_propose_new = Z_proposal_density(Z_ph, a_Z_PM * Z.slice(iter).row(i).t());
-    lpdf_propose_old = Z_proposal_density(Z.slice(iter).row(i).t(), a_Z_PM * Z_ph);
-
-    acceptance_prob = z_new_lpdf - z_lpdf + lpdf_propose_old - lpdf_propose_new;
-    rand_unif_var = R::runif(0,1);
-
-    for(int j = 0; j < Z.n_cols; j++){
-      if(Z(i,j,iter) <= 0){
-        acceptance_prob = 1;
-      }
-    }
-
-    if(log(rand_unif_var) < acceptance_prob){
-      // Accept new state and update parameters
-      Z.slice(iter).row(i) = Z_ph.t();
-    }
-  }
-  // Update next iteration
-  if(iter < (tot_mcmc_iters - 1)){
-    Z.slice(iter + 1) = Z.slice(iter);
-  }
+  FieldData data = {y_obs, B_obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateZKernel(data, coefs, Untempered(), chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, Z_ph, Z);
 }
 
 // Updates the Z Matrix using Tempered Transitions
@@ -215,129 +290,669 @@ inline void updateZTempered_PM(const double& beta_i,
                                const double& a_Z_PM,
                                arma::vec& Z_ph,
                                arma::cube& Z){
-  double z_lpdf = 0;
-  double z_new_lpdf = 0;
-  double lpdf_propose_new = 0;
-  double lpdf_propose_old = 0;
-  double acceptance_prob = 0;
-  double rand_unif_var = 0;
+  FieldData data = {y_obs, B_obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateZKernel(data, coefs, temper, chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, Z_ph, Z);
+}
 
-  for(int i = 0; i < Z.n_rows; i++){
-    Z_ph = rdirichlet(a_Z_PM * Z.slice(iter).row(i).t());
+// Gets log-pdf of z_i given zeta_{-z_i} using tempered transitions and
+// contiguous observation storage
+//
+// @name lpdf_zTempered
+// @param beta_i Double containing current temperature
+// @param obs RaggedObs containing observed values and basis functions
+// @param i Int containing the function of interest
+// @param Phi Cube containing Phi parameters
+// @param nu Matrix containing nu parameters
+// @param chi Vector containing the ith row of chi
+// @param pi vector containing the elements of pi
+// @param Z Vector containing the ith row of Z
+// @param alpha_3 double containing current value of alpha_3
+// @param sigma_sq double containing the sigma_sq variable
+// @param coef Vector acting as a placeholder for the mean coefficients
+// @return lpdf_z double contianing the log-pdf
+inline double lpdf_zTempered(const double& beta_i,
+                             const RaggedObs& obs,
+                             const int& i,
+                             const arma::cube& Phi,
+                             const arma::mat& nu,
+                             const arma::rowvec& chi,
+                             const arma::vec& pi,
+                             const arma::rowvec& Z,
+                             const double& alpha_3,
+                             const double& sigma_sq,
+                             arma::vec& coef){
+  double lpdf = 0;
 
-    // Get old state log pdf
-    z_lpdf = lpdf_zTempered(beta_i, y_obs(i,0), B_obs(i,0),
-                            Phi, nu, chi.row(i), pi,
-                            Z.slice(iter).row(i), alpha_3, i, sigma_sq);
+  for(int l = 0; l < pi.n_elem; l++){
+    lpdf = lpdf + ((alpha_3* pi(l) - 1) * std::log(Z(l)));
+  }
 
-    // Get new state log pdf
-    z_new_lpdf = lpdf_zTempered(beta_i, y_obs(i,0), B_obs(i,0),
-                                Phi,  nu, chi.row(i), pi,
-                                Z_ph.t(), alpha_3, i, sigma_sq);
+  calcMeanCoef(nu, Phi, Z, chi, coef);
+  lpdf = lpdf - (beta_i * (calcRSS(obs, i, coef) / (2 * sigma_sq)));
 
-    // Get proposal densities
-    lpdf_propose_new = Z_proposal_density(Z_ph, a_Z_PM * Z.slice(iter).row(i).t());
-    lpdf_propose_old = Z_proposal_density(Z.slice(iter).row(i).t(), a_Z_PM * Z_ph);
+  return lpdf;
+}
 
-    acceptance_prob = z_new_lpdf - z_lpdf + lpdf_propose_old - lpdf_propose_new;
-    rand_unif_var = R::runif(0,1);
+// Gets log-pdf of z_i given zeta_{-z_i} using tempered transitions and
+// contiguous observation storage
+//
+// @name lpdf_zTempered
+inline double lpdf_zTempered(const double& beta_i,
+                             const RaggedObs& obs,
+                             const int& i,
+                             const arma::cube& Phi,
+                             const arma::mat& nu,
+                             const arma::rowvec& chi,
+                             const arma::vec& pi,
+                             const arma::rowvec& Z,
+                             const double& alpha_3,
+                             const double& sigma_sq){
+  arma::vec coef = arma::zeros(nu.n_cols);
+  return lpdf_zTempered(beta_i, obs, i, Phi, nu, chi, pi, Z, alpha_3,
+                        sigma_sq, coef);
+}
 
-    for(int j = 0; j < Z.n_cols; j++){
-      if(Z(i,j,iter) <= 0){
-        acceptance_prob = 1;
-      }
-    }
+// Updates the Z Matrix using Tempered Transitions and contiguous observation
+// storage, using a separate proposal concentration for each function and
+// recording the acceptance probability of each proposal
+//
+// @name UpdateZTempered
+// @param beta_i Double containing current temperature
+// @param obs RaggedObs containing observed values and basis functions
+// @param Phi Cube containing Phi parameters
+// @param nu Matrix containing nu parameters
+// @param pi Vector containing the elements of pi
+// @param sigma_sq Double containing the sigma_sq variable
+// @param iter Int containing current mcmc iteration
+// @param tot_mcmc_iters Int containing total number of mcmc iterations
+// @param alpha_3 double containing current value of alpha_3
+// @param a_Z_PM Vector containing hyperparameter for sampling each row of Z
+// @param sched SubjectScheduler used to distribute the functions over threads
+// @param Z_ph Matrix that acts as a placeholder for Z
+// @param accept_prob Vector acting as a placeholder for the acceptance probability of each row of Z
+// @param Z Cube that contains all past, current, and future MCMC draws
+inline void updateZTempered_PM(const double& beta_i,
+                               const RaggedObs& obs,
+                               const arma::cube& Phi,
+                               const arma::mat& nu,
+                               const arma::mat& chi,
+                               const arma::vec& pi,
+                               const double& sigma_sq,
+                               const int& iter,
+                               const int& tot_mcmc_iters,
+                               const double& alpha_3,
+                               const arma::vec& a_Z_PM,
+                               SubjectScheduler& sched,
+                               arma::vec& Z_ph,
+                               arma::vec& accept_prob,
+                               arma::cube& Z){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateZKernel(data, coefs, temper, chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, sched, Z_ph, accept_prob, Z);
+}
 
-    if(log(rand_unif_var) < acceptance_prob){
-      // Accept new state and update parameters
-      Z.slice(iter).row(i) = Z_ph.t();
-    }
-  }
+// Updates the Z Matrix using Tempered Transitions, single precision
+// observation storage and a scheduler
+//
+// @name UpdateZTempered
+inline void updateZTempered_PM(const double& beta_i,
+                               const RaggedObsF& obs,
+                               const arma::cube& Phi,
+                               const arma::mat& nu,
+                               const arma::mat& chi,
+                               const arma::vec& pi,
+                               const double& sigma_sq,
+                               const int& iter,
+                               const int& tot_mcmc_iters,
+                               const double& alpha_3,
+                               const arma::vec& a_Z_PM,
+                               SubjectScheduler& sched,
+                               arma::vec& Z_ph,
+                               arma::vec& accept_prob,
+                               arma::cube& Z){
+  RaggedDataF data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateZKernel(data, coefs, temper, chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, sched, Z_ph, accept_prob, Z);
+}
 
-  // Update next iteration
-  if(iter < (tot_mcmc_iters - 1)){
-    Z.slice(iter + 1) = Z.slice(iter);
-  }
+// Updates the Z Matrix using Tempered Transitions and contiguous observation
+// storage, using a separate proposal concentration for each function and
+// recording the acceptance probability of each proposal
+//
+// @name UpdateZTempered
+inline void updateZTempered_PM(const double& beta_i,
+                               const RaggedObs& obs,
+                               const arma::cube& Phi,
+                               const arma::mat& nu,
+                               const arma::mat& chi,
+                               const arma::vec& pi,
+                               const double& sigma_sq,
+                               const int& iter,
+                               const int& tot_mcmc_iters,
+                               const double& alpha_3,
+                               const arma::vec& a_Z_PM,
+                               arma::vec& Z_ph,
+                               arma::vec& accept_prob,
+                               arma::cube& Z){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateZKernel(data, coefs, temper, chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, Z_ph, accept_prob, Z);
+}
+
+// Updates the Z Matrix using Tempered Transitions and contiguous observation
+// storage
+//
+// @name UpdateZTempered
+inline void updateZTempered_PM(const double& beta_i,
+                               const RaggedObs& obs,
+                               const arma::cube& Phi,
+                               const arma::mat& nu,
+                               const arma::mat& chi,
+                               const arma::vec& pi,
+                               const double& sigma_sq,
+                               const int& iter,
+                               const int& tot_mcmc_iters,
+                               const double& alpha_3,
+                               const double& a_Z_PM,
+                               arma::vec& Z_ph,
+                               arma::cube& Z){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateZKernel(data, coefs, temper, chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, Z_ph, Z);
 }
 
-// Gets log-pdf of z_i given zeta_{-z_i} for the multivariate model
+// Updates the Z Matrix using contiguous observation storage
 //
-// @name lpdf_zMV
-// @param y_obs Vector containing ith observed point
+// @name UpdateZ
+// @param obs RaggedObs containing observed values and basis functions
 // @param Phi Cube containing Phi parameters
 // @param nu Matrix containing nu parameters
-// @param pi vector containing the elements of pi
-// @param Z Vector containing the ith row of Z
-// @param sigma_sq double containing the sigma_sq variable
-// @return lpdf_z double containing the log-pdf
-inline double lpdf_zMV(const arma::rowvec& y_obs,
+// @param pi Vector containing the elements of pi
+// @param sigma_sq Double containing the sigma_sq variable
+// @param iter Int containing current mcmc iteration
+// @param tot_mcmc_iters Int containing total number of mcmc iterations
+// @param alpha_3 double containing current value of alpha_3
+// @param a_Z_PM double containing hyperparameter for sampling Z
+// @param Z_ph Matrix that acts as a placeholder for Z
+// @param Z Cube that contains all past, current, and future MCMC draws
+inline void updateZ_PM(const RaggedObs& obs,
                        const arma::cube& Phi,
                        const arma::mat& nu,
-                       const arma::rowvec& chi,
+                       const arma::mat& chi,
                        const arma::vec& pi,
-                       const arma::rowvec& Z,
+                       const double& sigma_sq,
+                       const int& iter,
+                       const int& tot_mcmc_iters,
                        const double& alpha_3,
-                       const int& num,
-                       const double& sigma_sq){
-  double lpdf = 0;
+                       const double& a_Z_PM,
+                       arma::vec& Z_ph,
+                       arma::cube& Z){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateZKernel(data, coefs, Untempered(), chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, Z_ph, Z);
+}
 
-  for(int l = 0; l < pi.n_elem; l++){
-    lpdf = lpdf + ((alpha_3* pi(l) - 1) * std::log(Z(l)));
+// Updates the Z Matrix using contiguous observation storage, using a separate
+// proposal concentration for each function and recording the acceptance
+// probability of each proposal
+//
+// @name UpdateZ
+inline void updateZ_PM(const RaggedObs& obs,
+                       const arma::cube& Phi,
+                       const arma::mat& nu,
+                       const arma::mat& chi,
+                       const arma::vec& pi,
+                       const double& sigma_sq,
+                       const int& iter,
+                       const int& tot_mcmc_iters,
+                       const double& alpha_3,
+                       const arma::vec& a_Z_PM,
+                       arma::vec& Z_ph,
+                       arma::vec& accept_prob,
+                       arma::cube& Z){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateZKernel(data, coefs, Untempered(), chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, Z_ph, accept_prob, Z);
+}
+
+
+// Updates the Z Matrix using contiguous observation storage and a scheduler,
+// using a separate proposal concentration for each function and recording the
+// acceptance probability of each proposal
+//
+// @name UpdateZ
+inline void updateZ_PM(const RaggedObs& obs,
+                       const arma::cube& Phi,
+                       const arma::mat& nu,
+                       const arma::mat& chi,
+                       const arma::vec& pi,
+                       const double& sigma_sq,
+                       const int& iter,
+                       const int& tot_mcmc_iters,
+                       const double& alpha_3,
+                       const arma::vec& a_Z_PM,
+                       SubjectScheduler& sched,
+                       arma::vec& Z_ph,
+                       arma::vec& accept_prob,
+                       arma::cube& Z){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateZKernel(data, coefs, Untempered(), chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, sched, Z_ph, accept_prob, Z);
+}
+
+// Updates the Z Matrix using single precision observation storage and a
+// scheduler, using a separate proposal concentration for each function and
+// recording the acceptance probability of each proposal
+//
+// @name UpdateZ
+inline void updateZ_PM(const RaggedObsF& obs,
+                       const arma::cube& Phi,
+                       const arma::mat& nu,
+                       const arma::mat& chi,
+                       const arma::vec& pi,
+                       const double& sigma_sq,
+                       const int& iter,
+                       const int& tot_mcmc_iters,
+                       const double& alpha_3,
+                       const arma::vec& a_Z_PM,
+                       SubjectScheduler& sched,
+                       arma::vec& Z_ph,
+                       arma::vec& accept_prob,
+                       arma::cube& Z){
+  RaggedDataF data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateZKernel(data, coefs, Untempered(), chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, sched, Z_ph, accept_prob, Z);
+}
+
+// Gets the log-pdf of z_i in the additive log-ratio parametrization
+// (z = softmax(eta, 0)) and its gradient with respect to eta. The Jacobian of
+// the transformation is included, so the Dirichlet prior contributes
+// alpha_3 * pi_l * log(z_l). The residual sum of squares is evaluated from the
+// cached sufficient statistics of the function.
+//
+// @name lpdf_zSimplex
+// @param eta Vector (K - 1) containing the log-ratios of the memberships
+// @param a Vector containing alpha_3 * pi
+// @param H Matrix (K x K) containing X'X, where X is the fitted mean of each feature at the observed time points
+// @param g Vector (K) containing X'y
+// @param yty Double containing the sum of squares of the observed values
+// @param scale Double containing beta_i / (2 * sigma_sq)
+// @param z Vector (K) acting as a placeholder for the memberships
+// @param grad Vector (K - 1) acting as a placeholder for the gradient
+// @returns lpdf Double containing the log-pdf
+inline double lpdf_zSimplex(const arma::vec& eta,
+                            const arma::vec& a,
+                            const arma::mat& H,
+                            const arma::vec& g,
+                            const double yty,
+                            const double scale,
+                            arma::vec& z,
+                            arma::vec& grad){
+  int K = a.n_elem;
+  // z = softmax(eta, 0), computed with the log-sum-exp trick
+  double eta_max = 0;
+  for(int l = 0; l < (K - 1); l++){
+    eta_max = std::max(eta_max, eta(l));
+  }
+  double lse = std::exp(-eta_max);
+  for(int l = 0; l < (K - 1); l++){
+    lse = lse + std::exp(eta(l) - eta_max);
+  }
+  lse = eta_max + std::log(lse);
+  double lpdf = -a(K - 1) * lse;
+  z(K - 1) = std::exp(-lse);
+  for(int l = 0; l < (K - 1); l++){
+    z(l) = std::exp(eta(l) - lse);
+    lpdf = lpdf + (a(l) * (eta(l) - lse));
   }
 
-  arma::vec mean = arma::zeros(nu.n_cols);
-  for(int k = 0; k < Z.n_elem; k++){
-    mean = mean + Z(k) * nu.row(k).t();
-    for(int m = 0; m < Phi.n_slices; m++){
-      mean = mean + Z(k) * chi(m) * Phi.slice(m).row(k).t();
+  // residual sum of squares yty - 2 g'z + z'Hz
+  double Hz = 0;
+  double zHz = 0;
+  double gz = 0;
+  for(int l = 0; l < K; l++){
+    Hz = 0;
+    for(int k = 0; k < K; k++){
+      Hz = Hz + (H(l,k) * z(k));
     }
+    zHz = zHz + (z(l) * Hz);
+    gz = gz + (g(l) * z(l));
+  }
+  lpdf = lpdf - (scale * (yty - (2 * gz) + zHz));
+
+  // derivative of the log-pdf with respect to the memberships (likelihood
+  // part) is u = 2 * scale * (g - Hz)
+  double zu = 2 * scale * (gz - zHz);
+  double sum_a = arma::accu(a);
+  double u = 0;
+  for(int l = 0; l < (K - 1); l++){
+    Hz = 0;
+    for(int k = 0; k < K; k++){
+      Hz = Hz + (H(l,k) * z(k));
+    }
+    u = 2 * scale * (g(l) - Hz);
+    grad(l) = a(l) - (z(l) * sum_a) + (z(l) * (u - zu));
   }
-
-  lpdf = lpdf - (arma::dot(y_obs.t() - mean, y_obs.t() - mean) /
-    (2 * sigma_sq));
-
   return lpdf;
 }
 
-// Gets log-pdf of z_i given zeta_{-z_i} using tempered transitions for the multivariate model
+// Updates the Z Matrix using Hamiltonian Monte Carlo on the additive
+// log-ratio parametrization of the simplex (MALA when n_leapfrog is 1). The
+// fitted mean of each feature at the observed time points is computed once
+// per function, so each leapfrog step only costs O(K^2). Functions are
+// updated in parallel on the subject scheduler; the engines used by each
+// function are seeded from R's random number generator beforehand. The
+// observations can be stored in double (RaggedObs) or single (RaggedObsF)
+// precision; the sufficient statistics are accumulated in double precision.
 //
-// @name lpdf_zTemperedMV
+// @name UpdateZTemperedHMC
 // @param beta_i Double containing current temperature
-// @param y_obs Vector containing the ith observed point
+// @param obs RaggedObs or RaggedObsF containing observed values and basis functions
 // @param Phi Cube containing Phi parameters
 // @param nu Matrix containing nu parameters
-// @param pi vector containing the elements of pi
-// @param Z Vector containing the ith row of Z
-// @param sigma_sq double containing the sigma_sq variable
-// @return lpdf_z double containing the log-pdf
-inline double lpdf_zTemperedMV(const double& beta_i,
-                               const arma::rowvec& y_obs,
-                               const arma::cube& Phi,
-                               const arma::mat& nu,
-                               const arma::rowvec& chi,
-                               const arma::vec& pi,
-                               const arma::rowvec& Z,
-                               const double& alpha_3,
-                               const int& num,
-                               const double& sigma_sq){
-  double lpdf = 0;
+// @param chi Matrix containing chi parameters
+// @param pi Vector containing the elements of pi
+// @param sigma_sq Double containing the sigma_sq variable
+// @param iter Int containing current mcmc iteration
+// @param tot_mcmc_iters Int containing total number of mcmc iterations
+// @param alpha_3 double containing current value of alpha_3
+// @param step_Z Vector containing the leapfrog step size used for each row of Z
+// @param n_leapfrog Int containing the number of leapfrog steps
+// @param sched SubjectScheduler used to distribute the functions over threads
+// @param accept_prob Vector acting as a placeholder for the acceptance probability of each row of Z
+// @param Z Cube that contains all past, current, and future MCMC draws
+template<class Obs>
+inline void updateZTemperedHMC_PM(const double& beta_i,
+                                  const Obs& obs,
+                                  const arma::cube& Phi,
+                                  const arma::mat& nu,
+                                  const arma::mat& chi,
+                                  const arma::vec& pi,
+                                  const double& sigma_sq,
+                                  const int& iter,
+                                  const int& tot_mcmc_iters,
+                                  const double& alpha_3,
+                                  const arma::vec& step_Z,
+                                  const int& n_leapfrog,
+                                  SubjectScheduler& sched,
+                                  arma::vec& accept_prob,
+                                  arma::cube& Z){
+  int n_funct = Z.n_rows;
+  int K = Z.n_cols;
+  accept_prob.set_size(n_funct);
+  const double scale = beta_i / (2 * sigma_sq);
+  Workspace& ws_serial = sched.serial;
+  arma::vec& a = fitScratch(ws_serial.prop_alpha, K, ws_serial.n_alloc);
+  for(int l = 0; l < K; l++){
+    a(l) = alpha_3 * pi(l);
+  }
 
-  for(int l = 0; l < pi.n_elem; l++){
-    lpdf = lpdf + ((alpha_3* pi(l) - 1) * std::log(Z(l)));
+  // R's random number generator cannot be used inside the parallel region
+  // (the seeds are below 2^32, so they are stored exactly as doubles)
+  arma::vec& seeds = fitScratch(ws_serial.unif, n_funct, ws_serial.n_alloc);
+  for(int i = 0; i < n_funct; i++){
+    seeds(i) = std::floor(R::runif(0, 4294967296.0));
   }
 
-  arma::vec mean = arma::zeros(nu.n_cols);
-  for(int k = 0; k < Z.n_elem; k++){
-    mean = mean + Z(k) * nu.row(k).t();
-    for(int m = 0; m < Phi.n_slices; m++){
-      mean = mean + Z(k) * chi(m) * Phi.slice(m).row(k).t();
+  parallelForSubjects(sched, "Z", [&](const int i){
+    Workspace& ws = subjectWorkspace(sched);
+    arma::mat& W = fitScratch(ws.feat, nu.n_cols, K, ws.n_alloc);
+    arma::mat& H = fitScratch(ws.feat_gram, K, K, ws.n_alloc);
+    arma::vec& x = fitScratch(ws.coef, K, ws.n_alloc);
+    arma::vec& z = fitScratch(ws.memb, K, ws.n_alloc);
+    arma::mat& state = fitScratch(ws.hmc, K, 6, ws.n_alloc);
+    arma::vec g(state.colptr(0), K, false, true);
+    arma::vec z_new(state.colptr(1), K, false, true);
+    arma::vec eta(state.colptr(2), K - 1, false, true);
+    arma::vec eta_new(state.colptr(3), K - 1, false, true);
+    arma::vec p(state.colptr(4), K - 1, false, true);
+    arma::vec grad(state.colptr(5), K - 1, false, true);
+    double yty = 0;
+    double y_t = 0;
+    double lpdf = 0;
+    double lpdf_new = 0;
+    double log_ratio = 0;
+    bool on_boundary = false;
+    std::mt19937_64 rng((std::uint64_t) seeds(i));
+    std::normal_distribution<double> rnorm(0.0, 1.0);
+    std::uniform_real_distribution<double> runif(0.0, 1.0);
+
+    // cache the sufficient statistics of the function
+    H.zeros();
+    g.zeros();
+    yty = 0;
+    if(obs.n_obs(i) > 0){
+      for(int k = 0; k < K; k++){
+        for(arma::uword q = 0; q < nu.n_cols; q++){
+          W.at(q,k) = nu.at(k,q);
+          for(arma::uword m = 0; m < Phi.n_slices; m++){
+            W.at(q,k) = W.at(q,k) + (chi(i,m) * Phi.at(k,q,m));
+          }
+        }
+      }
+      // x is the fitted mean of each feature at the observed time point
+      for(arma::uword t = obs.offsets(i); t < obs.offsets(i + 1); t++){
+        for(int k = 0; k < K; k++){
+          x(k) = 0;
+          for(arma::uword q = 0; q < nu.n_cols; q++){
+            x(k) = x(k) + (obs.B_t.at(q,t) * W.at(q,k));
+          }
+        }
+        y_t = obs.y.at(t);
+        for(int k = 0; k < K; k++){
+          for(int l = 0; l <= k; l++){
+            H.at(l,k) = H.at(l,k) + (x(l) * x(k));
+          }
+          g(k) = g(k) + (x(k) * y_t);
+        }
+        yty = yty + (y_t * y_t);
+      }
+      for(int k = 0; k < K; k++){
+        for(int l = 0; l < k; l++){
+          H.at(k,l) = H.at(l,k);
+        }
+      }
+      yty = yty + obs.rss_offset(i);
+    }
+
+    on_boundary = false;
+    for(int l = 0; l < K; l++){
+      z(l) = std::max(Z(i,l,iter), 1e-300);
+      if(Z(i,l,iter) <= 0){
+        on_boundary = true;
+      }
+    }
+    for(int l = 0; l < (K - 1); l++){
+      eta(l) = std::log(z(l)) - std::log(z(K - 1));
+      p(l) = rnorm(rng);
+    }
+
+    // leapfrog integration
+    lpdf = lpdf_zSimplex(eta, a, H, g, yty, scale, z, grad);
+    log_ratio = lpdf - (0.5 * arma::dot(p, p));
+    eta_new = eta;
+    p = p + (0.5 * step_Z(i) * grad);
+    for(int j = 0; j < n_leapfrog; j++){
+      eta_new = eta_new + (step_Z(i) * p);
+      lpdf_new = lpdf_zSimplex(eta_new, a, H, g, yty, scale, z_new, grad);
+      if(j < (n_leapfrog - 1)){
+        p = p + (step_Z(i) * grad);
+      }
+    }
+    p = p + (0.5 * step_Z(i) * grad);
+    log_ratio = lpdf_new - (0.5 * arma::dot(p, p)) - log_ratio;
+
+    if(on_boundary){
+      log_ratio = 1;
+    }
+    accept_prob(i) = calcAcceptanceProb(log_ratio);
+    if(std::log(runif(rng)) < log_ratio){
+      for(int l = 0; l < K; l++){
+        Z(i,l,iter) = z_new(l);
+      }
+    }
+  });
+
+  // Update next iteration
+  if(iter < (tot_mcmc_iters - 1)){
+    Z.slice(iter + 1) = Z.slice(iter);
+  }
+}
+
+// Updates the Z Matrix using Hamiltonian Monte Carlo on the additive
+// log-ratio parametrization of the simplex
+//
+// @name UpdateZTemperedHMC
+inline void updateZTemperedHMC_PM(const double& beta_i,
+                                  const RaggedObs& obs,
+                                  const arma::cube& Phi,
+                                  const arma::mat& nu,
+                                  const arma::mat& chi,
+                                  const arma::vec& pi,
+                                  const double& sigma_sq,
+                                  const int& iter,
+                                  const int& tot_mcmc_iters,
+                                  const double& alpha_3,
+                                  const arma::vec& step_Z,
+                                  const int& n_leapfrog,
+                                  arma::vec& accept_prob,
+                                  arma::cube& Z){
+  SubjectScheduler sched = makeSubjectScheduler(obs);
+  updateZTemperedHMC_PM(beta_i, obs, Phi, nu, chi, pi, sigma_sq, iter,
+                        tot_mcmc_iters, alpha_3, step_Z, n_leapfrog, sched,
+                        accept_prob, Z);
+}
+
+// Updates the Z Matrix using Hamiltonian Monte Carlo on the additive
+// log-ratio parametrization of the simplex
+//
+// @name UpdateZHMC
+inline void updateZHMC_PM(const RaggedObs& obs,
+                          const arma::cube& Phi,
+                          const arma::mat& nu,
+                          const arma::mat& chi,
+                          const arma::vec& pi,
+                          const double& sigma_sq,
+                          const int& iter,
+                          const int& tot_mcmc_iters,
+                          const double& alpha_3,
+                          const arma::vec& step_Z,
+                          const int& n_leapfrog,
+                          arma::vec& accept_prob,
+                          arma::cube& Z){
+  updateZTemperedHMC_PM(1.0, obs, Phi, nu, chi, pi, sigma_sq, iter,
+                        tot_mcmc_iters, alpha_3, step_Z, n_leapfrog,
+                        accept_prob, Z);
+}
+
+// Updates the Z Matrix using Hamiltonian Monte Carlo on the additive
+// log-ratio parametrization of the simplex and the subject scheduler (obs is
+// a RaggedObs or a RaggedObsF)
+//
+// @name UpdateZHMC
+template<class Obs>
+inline void updateZHMC_PM(const Obs& obs,
+                          const arma::cube& Phi,
+                          const arma::mat& nu,
+                          const arma::mat& chi,
+                          const arma::vec& pi,
+                          const double& sigma_sq,
+                          const int& iter,
+                          const int& tot_mcmc_iters,
+                          const double& alpha_3,
+                          const arma::vec& step_Z,
+                          const int& n_leapfrog,
+                          SubjectScheduler& sched,
+                          arma::vec& accept_prob,
+                          arma::cube& Z){
+  updateZTemperedHMC_PM(1.0, obs, Phi, nu, chi, pi, sigma_sq, iter,
+                        tot_mcmc_iters, alpha_3, step_Z, n_leapfrog, sched,
+                        accept_prob, Z);
+}
+
+// Updates the Z matrix by iterated conditional modes, setting each row of Z to
+// the memberships on the simplex that maximize its conditional posterior
+// (the likelihood of the function and the Dirichlet(alpha_3 * pi) prior).
+// Since the prior density is unbounded at the boundary of the simplex when
+// alpha_3 * pi_k < 1, the memberships are kept greater than or equal to 1e-4,
+// which also lets the result start the Metropolis-Hastings updates of Z (used
+// by the ICM initializer).
+//
+// @name updateZICM
+// @param obs RaggedObs containing observed values and basis functions
+// @param Phi Cube containing Phi parameters
+// @param nu Matrix containing nu parameters
+// @param chi Matrix containing chi parameters
+// @param pi Vector containing the current pi parameters
+// @param alpha_3 Double containing the current alpha_3 parameter
+// @param sigma_sq Double containing the current sigma parameter
+// @param iter Int containing current iteration
+// @param tot_mcmc_iters Int containing total number of iterations
+// @param n_steps Int containing the maximum number of projected gradient steps
+// @param Z Cube containing the estimates of Z at each iteration
+inline void updateZICM(const RaggedObs& obs,
+                       const arma::cube& Phi,
+                       const arma::mat& nu,
+                       const arma::mat& chi,
+                       const arma::vec& pi,
+                       const double& alpha_3,
+                       const double& sigma_sq,
+                       const int& iter,
+                       const int& tot_mcmc_iters,
+                       const int& n_steps,
+                       arma::cube& Z){
+  double z_min = 1e-4;
+  arma::vec prior = (alpha_3 * pi) - 1;
+  arma::mat W;
+  arma::mat X;
+  arma::mat H;
+  arma::vec g;
+  arma::vec z;
+  auto f = [&](const arma::vec& x){
+    return -((0.5 * arma::dot(x, H * x)) - arma::dot(g, x)) / sigma_sq +
+      arma::dot(prior, arma::log(x));
+  };
+  auto grad = [&](const arma::vec& x){
+    arma::vec grad_x = -((H * x) - g) / sigma_sq + (prior / x);
+    return grad_x;
+  };
+  for(int i = 0; i < Z.n_rows; i++){
+    z = Z.slice(iter).row(i).t();
+    if(obs.n_obs(i) == 0){
+      H.zeros(Z.n_cols, Z.n_cols);
+      g.zeros(Z.n_cols);
+    }else{
+      // mean of the function is X z
+      W = nu.t();
+      for(int m = 0; m < Phi.n_slices; m++){
+        W = W + chi(i,m) * Phi.slice(m).t();
+      }
+      X = obs.B_i(i).t() * W;
+      H = X.t() * X;
+      g = X.t() * obs.y_i(i);
     }
+    maximizeSimplex(f, grad, z_min, n_steps,
+                    sigma_sq / std::max(arma::eig_sym(H).max(), 1e-12), z);
+    Z.slice(iter).row(i) = z.t();
+  }
+  if(iter < (tot_mcmc_iters - 1)){
+    Z.slice(iter + 1) = Z.slice(iter);
   }
-
-  lpdf = lpdf - ((beta_i * arma::dot(y_obs.t() - mean, y_obs.t() - mean)) /
-    (2 * sigma_sq));
-
-  return lpdf;
 }
 
 // Updates the Z Matrix
@@ -367,47 +982,10 @@ inline void updateZ_MMMV(const arma::mat& y_obs,
                          const double& a_Z_PM,
                          arma::vec& Z_ph,
                          arma::cube& Z){
-  double z_lpdf = 0;
-  double z_new_lpdf = 0;
-  double lpdf_propose_new = 0;
-  double lpdf_propose_old = 0;
-  double acceptance_prob = 0;
-  double rand_unif_var = 0;
-
-  for(int i = 0; i < Z.n_rows; i++){
-    // Propose new state
-    Z_ph = rdirichlet(a_Z_PM * Z.slice(iter).row(i).t());
-
-    // Get old state log pdf
-    z_lpdf = lpdf_zMV(y_obs.row(i), Phi, nu, chi.row(i), pi,
-                      Z.slice(iter).row(i), alpha_3, i, sigma_sq);
-
-    // Get new state log pdf
-    z_new_lpdf = lpdf_zMV(y_obs.row(i), Phi, nu, chi.row(i), pi,
-                          Z_ph.t(), alpha_3, i, sigma_sq);
-
-    // Get proposal densities
-    lpdf_propose_new = Z_proposal_density(Z_ph, a_Z_PM * Z.slice(iter).row(i).t());
-    lpdf_propose_old = Z_proposal_density(Z.slice(iter).row(i).t(), a_Z_PM * Z_ph);
-
-    acceptance_prob = z_new_lpdf - z_lpdf + lpdf_propose_old - lpdf_propose_new;
-    rand_unif_var = R::runif(0,1);
-
-    for(int j = 0; j < Z.n_cols; j++){
-      if(Z(i,j,iter) <= 0){
-        acceptance_prob = 1;
-      }
-    }
-
-    if(log(rand_unif_var) < acceptance_prob){
-      // Accept new state and update parameters
-      Z.slice(iter).row(i) = Z_ph.t();
-    }
-  }
-  // Update next iteration
-  if(iter < (tot_mcmc_iters - 1)){
-    Z.slice(iter + 1) = Z.slice(iter);
-  }
+  MVData data = {y_obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateZKernel(data, coefs, Untempered(), chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, Z_ph, Z);
 }
 
 // Updates the Z Matrix using Tempered Transitions
@@ -439,49 +1017,11 @@ inline void updateZTempered_MMMV(const double& beta_i,
                                  const double& a_Z_PM,
                                  arma::vec& Z_ph,
                                  arma::cube& Z){
-  double z_lpdf = 0;
-  double z_new_lpdf = 0;
-  double lpdf_propose_new = 0;
-  double lpdf_propose_old = 0;
-  double acceptance_prob = 0;
-  double rand_unif_var = 0;
-
-  for(int i = 0; i < Z.n_rows; i++){
-    Z_ph = rdirichlet(a_Z_PM * Z.slice(iter).row(i).t());
-
-    // Get old state log pdf
-    z_lpdf = lpdf_zTemperedMV(beta_i, y_obs.row(i),
-                              Phi, nu, chi.row(i), pi,
-                              Z.slice(iter).row(i), alpha_3, i, sigma_sq);
-
-    // Get new state log pdf
-    z_new_lpdf = lpdf_zTemperedMV(beta_i, y_obs.row(i),
-                                  Phi,  nu, chi.row(i), pi,
-                                  Z_ph.t(), alpha_3, i, sigma_sq);
-
-    // Get proposal densities
-    lpdf_propose_new = Z_proposal_density(Z_ph, a_Z_PM * Z.slice(iter).row(i).t());
-    lpdf_propose_old = Z_proposal_density(Z.slice(iter).row(i).t(), a_Z_PM * Z_ph);
-
-    acceptance_prob = z_new_lpdf - z_lpdf + lpdf_propose_old - lpdf_propose_new;
-    rand_unif_var = R::runif(0,1);
-
-    for(int j = 0; j < Z.n_cols; j++){
-      if(Z(i,j,iter) <= 0){
-        acceptance_prob = 1;
-      }
-    }
-
-    if(log(rand_unif_var) < acceptance_prob){
-      // Accept new state and update parameters
-      Z.slice(iter).row(i) = Z_ph.t();
-    }
-  }
-
-  // Update next iteration
-  if(iter < (tot_mcmc_iters - 1)){
-    Z.slice(iter + 1) = Z.slice(iter);
-  }
+  MVData data = {y_obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateZKernel(data, coefs, temper, chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, Z_ph, Z);
 }
 
 
@@ -489,110 +1029,6 @@ inline void updateZTempered_MMMV(const double& beta_i,
 // Covariate Adjusted Code //
 /////////////////////////////
 
-// Gets log-pdf of z_i given zeta_{-z_i} for the covariate adjusted model
-//
-// @name lpdf_zCovariateAdj
-// @param y_obs Vector containing y at observed time points
-// @param B_obs Matrix containing basis functions evaluated at observed time points
-// @param Phi Cube containing Phi parameters
-// @param xi Field of cubes containing phi parameters
-// @param nu Matrix containing nu parameters
-// @param eta Cube containing eta parameters
-// @param pi vector containing the elements of pi
-// @param Z Vector containing the ith row of Z
-// @param X rowvec containing the ith row of X
-// @param sigma_sq double containing the sigma_sq variable
-// @return lpdf_z double containing the log-pdf
-inline double lpdf_zCovariateAdj(const arma::vec& y_obs,
-                                 const arma::mat& B_obs,
-                                 const arma::cube& Phi,
-                                 const arma::field<arma::cube>& xi,
-                                 const arma::mat& nu,
-                                 const arma::cube& eta,
-                                 const arma::rowvec& chi,
-                                 const arma::vec& pi,
-                                 const arma::rowvec& Z,
-                                 const arma::rowvec& X,
-                                 const double& alpha_3,
-                                 const int& iter,
-                                 const double& sigma_sq){
-  double lpdf = 0;
-  double mean = 0;
-
-  for(int l = 0; l < pi.n_elem; l++){
-    lpdf = lpdf + ((alpha_3* pi(l) - 1) * std::log(Z(l)));
-  }
-
-  for(int l = 0; l < B_obs.n_rows; l++){
-    mean = 0;
-    for(int k = 0; k < pi.n_elem; k++){
-      mean = mean + Z(k) * (arma::dot(nu.row(k) , B_obs.row(l).t()) +
-        arma::dot(eta.slice(k) * X.t(), B_obs.row(l)));
-      for(int n = 0; n < Phi.n_slices; n++){
-        mean = mean + Z(k) * chi(n) * (arma::dot(Phi.slice(n).row(k),
-                        B_obs.row(l).t()) +  arma::dot(xi(iter,k).slice(n) * X.t(),
-                        B_obs.row(l)));
-      }
-    }
-    lpdf = lpdf - (std::pow(y_obs(l) - mean, 2.0) / (2 * sigma_sq));
-  }
-
-  return lpdf;
-}
-
-// Gets log-pdf of z_i given zeta_{-z_i} using tempered trasitions
-//
-// @name lpdf_zTempered
-// @param beta_i Double containing current temperature
-// @param y_obs Vector containing y at observed time points
-// @param B_obs Matrix containing basis functions evaluated at observed time points
-// @param Phi Cube containing Phi parameters
-// @param xi Field of cubes containing phi parameters
-// @param nu Matrix containing nu parameters
-// @param eta Cube containing eta parameters
-// @param pi vector containing the elements of pi
-// @param Z Vector containing the ith row of Z
-// @param X rowvec containing the ith row of X
-// @param sigma_sq double containing the sigma_sq variable
-// @return lpdf_z double contianing the log-pdf
-inline double lpdf_zCovariateAdjTempered(const double& beta_i,
-                                         const arma::vec& y_obs,
-                                         const arma::mat& B_obs,
-                                         const arma::cube& Phi,
-                                         const arma::field<arma::cube>& xi,
-                                         const arma::mat& nu,
-                                         const arma::cube& eta,
-                                         const arma::rowvec& chi,
-                                         const arma::vec& pi,
-                                         const arma::rowvec& Z,
-                                         const arma::rowvec& X,
-                                         const double& alpha_3,
-                                         const int& iter,
-                                         const double& sigma_sq){
-  double lpdf = 0;
-  double mean = 0;
-
-  for(int l = 0; l < pi.n_elem; l++){
-    lpdf = lpdf + ((alpha_3* pi(l) - 1) * std::log(Z(l)));
-  }
-
-  for(int l = 0; l < B_obs.n_rows; l++){
-    mean = 0;
-    for(int k = 0; k < pi.n_elem; k++){
-      mean = mean + Z(k) * (arma::dot(nu.row(k) , B_obs.row(l).t()) +
-        arma::dot(eta.slice(k) * X.t(), B_obs.row(l)));
-      for(int n = 0; n < Phi.n_slices; n++){
-        mean = mean + Z(k) * chi(n) * (arma::dot(Phi.slice(n).row(k),
-                                 B_obs.row(l).t()) +  arma::dot(xi(iter,k).slice(n) * X.t(),
-                                 B_obs.row(l)));
-      }
-    }
-    lpdf = lpdf - (beta_i * (std::pow(y_obs(l) - mean, 2.0) / (2 * sigma_sq)));
-  }
-
-  return lpdf;
-}
-
 // Updates the Z Matrix for the covariate adjusted model
 //
 // @name UpdateZ_PM_CovariateAdj
@@ -628,49 +1064,10 @@ inline void updateZ_PMCovariateAdj(const arma::field<arma::vec>& y_obs,
                                    const arma::mat& X,
                                    arma::vec& Z_ph,
                                    arma::cube& Z){
-  double z_lpdf = 0;
-  double z_new_lpdf = 0;
-  double lpdf_propose_new = 0;
-  double lpdf_propose_old = 0;
-  double acceptance_prob = 0;
-  double rand_unif_var = 0;
-
-  for(int i = 0; i < Z.n_rows; i++){
-    // Propose new state
-    Z_ph = rdirichlet(a_Z_PM * Z.slice(iter).row(i).t());
-
-    // Get old state log pdf
-    z_lpdf = lpdf_zCovariateAdj(y_obs(i,0), B_obs(i,0), Phi, xi, nu, eta,
-                                chi.row(i), pi, Z.slice(iter).row(i), X.row(i),
-                                alpha_3, iter, sigma_sq);
-
-    // Get new state log pdf
-    z_new_lpdf = lpdf_zCovariateAdj(y_obs(i,0), B_obs(i,0), Phi, xi, nu, eta,
-                                    chi.row(i), pi, Z_ph.t(), X.row(i), alpha_3,
-                                    iter, sigma_sq);
-
-    // Get proposal densities
-    lpdf_propose_new = Z_proposal_density(Z_ph, a_Z_PM * Z.slice(iter).row(i).t());
-    lpdf_propose_old = Z_proposal_density(Z.slice(iter).row(i).t(), a_Z_PM * Z_ph);
-
-    acceptance_prob = z_new_lpdf - z_lpdf + lpdf_propose_old - lpdf_propose_new;
-    rand_unif_var = R::runif(0,1);
-
-    for(int j = 0; j < Z.n_cols; j++){
-      if(Z(i,j,iter) <= 0){
-        acceptance_prob = 1;
-      }
-    }
-
-    if(log(rand_unif_var) < acceptance_prob){
-      // Accept new state and update parameters
-      Z.slice(iter).row(i) = Z_ph.t();
-    }
-  }
-  // Update next iteration
-  if(iter < (tot_mcmc_iters - 1)){
-    Z.slice(iter + 1) = Z.slice(iter);
-  }
+  FieldData data = {y_obs, B_obs};
+  CovariateCoefs coefs = {nu, eta, Phi, xi, iter, X};
+  updateZKernel(data, coefs, Untempered(), chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, Z_ph, Z);
 }
 
 // Updates the Z Matrix using Tempered Transitions for a covariate adjusted model
@@ -707,142 +1104,78 @@ inline void updateZTempered_PMCovariateAdj(const double& beta_i,
                                            const arma::mat& X,
                                            arma::vec& Z_ph,
                                            arma::cube& Z){
-  double z_lpdf = 0;
-  double z_new_lpdf = 0;
-  double lpdf_propose_new = 0;
-  double lpdf_propose_old = 0;
-  double acceptance_prob = 0;
-  double rand_unif_var = 0;
-
-  for(int i = 0; i < Z.n_rows; i++){
-    Z_ph = rdirichlet(a_Z_PM * Z.slice(iter).row(i).t());
-
-    // Get old state log pdf
-    z_lpdf = lpdf_zCovariateAdjTempered(beta_i, y_obs(i,0), B_obs(i,0),
-                            Phi, xi, nu, eta, chi.row(i), pi, Z.slice(iter).row(i),
-                            X.row(i), alpha_3, iter, sigma_sq);
-
-    // Get new state log pdf
-    z_new_lpdf = lpdf_zCovariateAdjTempered(beta_i, y_obs(i,0), B_obs(i,0),
-                                Phi, xi, nu, eta, chi.row(i), pi,
-                                Z_ph.t(), X.row(i), alpha_3, i, sigma_sq);
-
-    // Get proposal densities
-    lpdf_propose_new = Z_proposal_density(Z_ph, a_Z_PM * Z.slice(iter).row(i).t());
-    lpdf_propose_old = Z_proposal_density(Z.slice(iter).row(i).t(), a_Z_PM * Z_ph);
-
-    acceptance_prob = z_new_lpdf - z_lpdf + lpdf_propose_old - lpdf_propose_new;
-    rand_unif_var = R::runif(0,1);
-
-    for(int j = 0; j < Z.n_cols; j++){
-      if(Z(i,j,iter) <= 0){
-        acceptance_prob = 1;
-      }
-    }
-
-    if(log(rand_unif_var) < acceptance_prob){
-      // Accept new state and update parameters
-      Z.slice(iter).row(i) = Z_ph.t();
-    }
-  }
-
-  // Update next iteration
-  if(iter < (tot_mcmc_iters - 1)){
-    Z.slice(iter + 1) = Z.slice(iter);
-  }
-}
-
-// Gets log-pdf of z_i given zeta_{-z_i} for the multivariate covariate adjusted model
-//
-// @name lpdf_zMVCovariateAdj
-// @param y_obs Vector containing ith observed point
-// @param Phi Cube containing Phi parameters
-// @param xi Field of cubes containing phi parameters
-// @param nu Matrix containing nu parameters
-// @param eta Cube containing eta parameters
-// @param pi vector containing the elements of pi
-// @param Z Vector containing the ith row of Z
-// @param X rowvec containing the ith row of X
-// @param sigma_sq double containing the sigma_sq variable
-// @return lpdf_z double containing the log-pdf
-inline double lpdf_zMVCovariateAdj(const arma::rowvec& y_obs,
-                                   const arma::cube& Phi,
-                                   const arma::field<arma::cube>& xi,
-                                   const arma::mat& nu,
-                                   const arma::cube& eta,
-                                   const arma::rowvec& chi,
-                                   const arma::vec& pi,
-                                   const arma::rowvec& Z,
-                                   const arma::rowvec& X,
-                                   const double& alpha_3,
-                                   const int& iter,
-                                   const double& sigma_sq){
-  double lpdf = 0;
-
-  for(int l = 0; l < pi.n_elem; l++){
-    lpdf = lpdf + ((alpha_3* pi(l) - 1) * std::log(Z(l)));
-  }
-  arma::vec mean = arma::zeros(nu.n_cols);
-  for(int k = 0; k < Z.n_elem; k++){
-    mean = mean + Z(k) * (nu.row(k).t() + (eta.slice(k) * X.t()));
-    for(int m = 0; m < Phi.n_slices; m++){
-      mean = mean + Z(k) * chi(m) * (Phi.slice(m).row(k).t() +
-        xi(iter,k).slice(m) * X.t());
-    }
-  }
-
-  lpdf = lpdf - (arma::dot(y_obs.t() - mean, y_obs.t() - mean) /
-    (2 * sigma_sq));
-
-  return lpdf;
+  FieldData data = {y_obs, B_obs};
+  CovariateCoefs coefs = {nu, eta, Phi, xi, iter, X};
+  Tempered temper = {beta_i};
+  updateZKernel(data, coefs, temper, chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, Z_ph, Z);
 }
 
-// Gets log-pdf of z_i given zeta_{-z_i} using tempered transitions for the multivariate covariate adjusted model
+// Updates the Z Matrix for the covariate adjusted model using Tempered
+// Transitions and the cached covariate adjusted coefficients
 //
-// @name lpdf_zTemperedMVCovariateAdj
+// @name UpdateZTempered_PMCovariateAdj
 // @param beta_i Double containing current temperature
-// @param y_obs Vector containing the ith observed point
-// @param Phi Cube containing Phi parameters
-// @param xi Field of cubes containing phi parameters
-// @param nu Matrix containing nu parameters
-// @param eta Cube containing eta parameters
-// @param pi vector containing the elements of pi
-// @param Z Vector containing the ith row of Z
-// @param X rowvec containing the ith row of X
-// @param sigma_sq double containing the sigma_sq variable
-// @return lpdf_z double containing the log-pdf
-inline double lpdf_zTemperedMVCovariateAdj(const double& beta_i,
-                                           const arma::rowvec& y_obs,
-                                           const arma::cube& Phi,
-                                           const arma::field<arma::cube>& xi,
-                                           const arma::mat& nu,
-                                           const arma::cube& eta,
-                                           const arma::rowvec& chi,
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients
+// @param chi Matrix containing current chi parameters
+// @param pi Vector containing the elements of pi
+// @param sigma_sq Double containing the sigma_sq variable
+// @param iter Int containing current mcmc iteration
+// @param tot_mcmc_iters Int containing total number of mcmc iterations
+// @param alpha_3 double containing current value of alpha_3
+// @param a_Z_PM double containing hyperparameter for sampling Z
+// @param Z_ph Matrix that acts as a placeholder for Z
+// @param Z Cube that contains all past, current, and future MCMC draws
+inline void updateZTempered_PMCovariateAdj(const double& beta_i,
+                                           const RaggedObs& obs,
+                                           const CovariateEffects& cov,
+                                           const arma::mat& chi,
                                            const arma::vec& pi,
-                                           const arma::rowvec& Z,
-                                           const arma::rowvec& X,
-                                           const double& alpha_3,
+                                           const double& sigma_sq,
                                            const int& iter,
-                                           const double& sigma_sq){
-  double lpdf = 0;
-
-  for(int l = 0; l < pi.n_elem; l++){
-    lpdf = lpdf + ((alpha_3* pi(l) - 1) * std::log(Z(l)));
-  }
-
-  arma::vec mean = arma::zeros(nu.n_cols);
-  for(int k = 0; k < Z.n_elem; k++){
-    mean = mean + Z(k) * (nu.row(k).t() + (eta.slice(k) * X.t()));
-    for(int m = 0; m < Phi.n_slices; m++){
-      mean = mean + Z(k) * chi(m) * (Phi.slice(m).row(k).t() +
-        xi(iter,k).slice(m) * X.t());
-    }
-  }
-
-  lpdf = lpdf - ((beta_i * arma::dot(y_obs.t() - mean, y_obs.t() - mean)) /
-    (2 * sigma_sq));
+                                           const int& tot_mcmc_iters,
+                                           const double& alpha_3,
+                                           const double& a_Z_PM,
+                                           arma::vec& Z_ph,
+                                           arma::cube& Z){
+  RaggedData data = {obs};
+  CachedCovariateCoefs coefs = {cov};
+  Tempered temper = {beta_i};
+  updateZKernel(data, coefs, temper, chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, Z_ph, Z);
+}
 
-  return lpdf;
+// Updates the Z Matrix for the covariate adjusted model using the cached
+// covariate adjusted coefficients
+//
+// @name UpdateZ_PMCovariateAdj
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients
+// @param chi Matrix containing current chi parameters
+// @param pi Vector containing the elements of pi
+// @param sigma_sq Double containing the sigma_sq variable
+// @param iter Int containing current mcmc iteration
+// @param tot_mcmc_iters Int containing total number of mcmc iterations
+// @param alpha_3 double containing current value of alpha_3
+// @param a_Z_PM double containing hyperparameter for sampling Z
+// @param Z_ph Matrix that acts as a placeholder for Z
+// @param Z Cube that contains all past, current, and future MCMC draws
+inline void updateZ_PMCovariateAdj(const RaggedObs& obs,
+                                   const CovariateEffects& cov,
+                                   const arma::mat& chi,
+                                   const arma::vec& pi,
+                                   const double& sigma_sq,
+                                   const int& iter,
+                                   const int& tot_mcmc_iters,
+                                   const double& alpha_3,
+                                   const double& a_Z_PM,
+                                   arma::vec& Z_ph,
+                                   arma::cube& Z){
+  RaggedData data = {obs};
+  CachedCovariateCoefs coefs = {cov};
+  updateZKernel(data, coefs, Untempered(), chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, Z_ph, Z);
 }
 
 // Updates the Z Matrix for the covariate adjusted model
@@ -878,47 +1211,10 @@ inline void updateZ_MMMVCovariateAdj(const arma::mat& y_obs,
                                      const arma::mat& X,
                                      arma::vec& Z_ph,
                                      arma::cube& Z){
-  double z_lpdf = 0;
-  double z_new_lpdf = 0;
-  double lpdf_propose_new = 0;
-  double lpdf_propose_old = 0;
-  double acceptance_prob = 0;
-  double rand_unif_var = 0;
-
-  for(int i = 0; i < Z.n_rows; i++){
-    // Propose new state
-    Z_ph = rdirichlet(a_Z_PM * Z.slice(iter).row(i).t());
-
-    // Get old state log pdf
-    z_lpdf = lpdf_zMVCovariateAdj(y_obs.row(i), Phi, xi, nu, eta, chi.row(i), pi,
-                      Z.slice(iter).row(i), X.row(i), alpha_3, i, sigma_sq);
-
-    // Get new state log pdf
-    z_new_lpdf = lpdf_zMVCovariateAdj(y_obs.row(i), Phi, xi, nu, eta, chi.row(i),
-                                      pi, Z_ph.t(), X.row(i), alpha_3, i, sigma_sq);
-
-    // Get proposal densities
-    lpdf_propose_new = Z_proposal_density(Z_ph, a_Z_PM * Z.slice(iter).row(i).t());
-    lpdf_propose_old = Z_proposal_density(Z.slice(iter).row(i).t(), a_Z_PM * Z_ph);
-
-    acceptance_prob = z_new_lpdf - z_lpdf + lpdf_propose_old - lpdf_propose_new;
-    rand_unif_var = R::runif(0,1);
-
-    for(int j = 0; j < Z.n_cols; j++){
-      if(Z(i,j,iter) <= 0){
-        acceptance_prob = 1;
-      }
-    }
-
-    if(log(rand_unif_var) < acceptance_prob){
-      // Accept new state and update parameters
-      Z.slice(iter).row(i) = Z_ph.t();
-    }
-  }
-  // Update next iteration
-  if(iter < (tot_mcmc_iters - 1)){
-    Z.slice(iter + 1) = Z.slice(iter);
-  }
+  MVData data = {y_obs};
+  CovariateCoefs coefs = {nu, eta, Phi, xi, iter, X};
+  updateZKernel(data, coefs, Untempered(), chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, Z_ph, Z);
 }
 
 // Updates the Z Matrix using Tempered Transitions for the covariate adjusted multivariate model
@@ -956,49 +1252,11 @@ inline void updateZTempered_MMMVCovariateAdj(const double& beta_i,
                                              const arma::mat& X,
                                              arma::vec& Z_ph,
                                              arma::cube& Z){
-  double z_lpdf = 0;
-  double z_new_lpdf = 0;
-  double lpdf_propose_new = 0;
-  double lpdf_propose_old = 0;
-  double acceptance_prob = 0;
-  double rand_unif_var = 0;
-
-  for(int i = 0; i < Z.n_rows; i++){
-    Z_ph = rdirichlet(a_Z_PM * Z.slice(iter).row(i).t());
-
-    // Get old state log pdf
-    z_lpdf = lpdf_zTemperedMVCovariateAdj(beta_i, y_obs.row(i), Phi, xi, nu, eta,
-                                          chi.row(i), pi, Z.slice(iter).row(i),
-                                          X.row(i), alpha_3, i, sigma_sq);
-
-    // Get new state log pdf
-    z_new_lpdf = lpdf_zTemperedMVCovariateAdj(beta_i, y_obs.row(i),  Phi, xi, nu,
-                                              eta, chi.row(i), pi, Z_ph.t(),
-                                              X.row(i), alpha_3, i, sigma_sq);
-
-    // Get proposal densities
-    lpdf_propose_new = Z_proposal_density(Z_ph, a_Z_PM * Z.slice(iter).row(i).t());
-    lpdf_propose_old = Z_proposal_density(Z.slice(iter).row(i).t(), a_Z_PM * Z_ph);
-
-    acceptance_prob = z_new_lpdf - z_lpdf + lpdf_propose_old - lpdf_propose_new;
-    rand_unif_var = R::runif(0,1);
-
-    for(int j = 0; j < Z.n_cols; j++){
-      if(Z(i,j,iter) <= 0){
-        acceptance_prob = 1;
-      }
-    }
-
-    if(log(rand_unif_var) < acceptance_prob){
-      // Accept new state and update parameters
-      Z.slice(iter).row(i) = Z_ph.t();
-    }
-  }
-
-  // Update next iteration
-  if(iter < (tot_mcmc_iters - 1)){
-    Z.slice(iter + 1) = Z.slice(iter);
-  }
+  MVData data = {y_obs};
+  CovariateCoefs coefs = {nu, eta, Phi, xi, iter, X};
+  Tempered temper = {beta_i};
+  updateZKernel(data, coefs, temper, chi, pi, sigma_sq, iter, tot_mcmc_iters,
+                alpha_3, a_Z_PM, Z_ph, Z);
 }
 
 }
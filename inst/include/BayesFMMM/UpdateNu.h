@@ -3,8 +3,147 @@
 
 #include <RcppArmadillo.h>
 #include <cmath>
+#include "ConditionalModes.h"
+#include "CovariateEffects.h"
+#include "Distributions.h"
+#include "KernelPolicies.h"
+#include "RaggedObs.h"
+#include "SparseGaussian.h"
+#include "Workspace.h"
 
 namespace BayesFMMM{
+// Updates the nu parameters for one data model, coefficient policy,
+// temperature and source of randomness. The conditional posterior of each row
+// of nu is accumulated by the data model (addGram) and drawn by
+// drawGaussianCanonical in the buffers of the workspace.
+//
+// @name NuKernel
+template<class Data, class Coefs, class Temper, class Rng>
+struct NuKernel{
+  const Data& data;
+  const Coefs& coefs;
+  const Temper& temper;
+  Rng& rng;
+  const arma::vec& prior_scale;
+  const arma::mat& P;
+  const arma::mat& Z;
+  const arma::mat& chi;
+  const double sigma;
+  const int iter;
+  Workspace& ws;
+  arma::vec& b_1;
+  arma::mat& B_1;
+  arma::cube& nu;
+  arma::mat& nu_mean;
+
+  template<int K_, int M_>
+  void run() const{
+    arma::vec& coef = fitScratch(ws.coef, nu.n_cols, ws.n_alloc);
+    arma::vec& mean = fitScratch(ws.basis, nu.n_cols, ws.n_alloc);
+    arma::vec& x = fitScratch(ws.dir, nu.n_cols, ws.n_alloc);
+    arma::mat& U = fitScratch(ws.gram, nu.n_cols, nu.n_cols, ws.n_alloc);
+    const double w = temper.scale(1.0) / sigma;
+    for(arma::uword j = 0; j < nu.n_rows; j++){
+      b_1.zeros();
+      B_1.zeros();
+      for(arma::uword i = 0; i < Z.n_rows; i++){
+        if(Z.at(i,j) != 0){
+          // residual after removing every term except nu_j
+          coefs.template meanCoef<K_, M_>(i, Z, chi, coef);
+          for(arma::uword p = 0; p < nu.n_cols; p++){
+            coef.at(p) = coef.at(p) - Z.at(i,j) * nu.at(j,p,iter);
+          }
+          data.addGram(i, coef, Z.at(i,j) * Z.at(i,j), Z.at(i,j), B_1, b_1);
+        }
+      }
+      for(arma::uword q = 0; q < nu.n_cols; q++){
+        b_1.at(q) = w * b_1.at(q);
+        for(arma::uword p = 0; p <= q; p++){
+          B_1.at(p,q) = (w * B_1.at(p,q)) + (prior_scale(j) * P.at(p,q));
+        }
+      }
+      drawGaussianCanonical(B_1, b_1, rng, U, mean, x);
+      for(arma::uword p = 0; p < nu.n_cols; p++){
+        nu_mean.at(j,p) = mean.at(p);
+        coef.at(p) = x.at(p) - nu.at(j,p,iter);
+        nu.at(j,p,iter) = x.at(p);
+      }
+      coefs.moveNu(j, coef);
+    }
+  }
+};
+
+// Updates the nu parameters
+//
+// @name updateNuKernel
+// @param data Data model containing the observations
+// @param coefs Coefficient policy containing the mean coefficients of each function
+// @param temper Tempering policy
+// @param rng Source of randomness (ConditionalMode sets each row of nu to its conditional mode)
+// @param prior_scale Vector containing the scale of the prior precision of each row of nu
+// @param P Matrix containing the prior precision of each row of nu up to prior_scale
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param sigma Double containing current sigma parameter
+// @param iter Int containing MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param ws Workspace used as scratch memory
+// @param b_1 Vector acting as a placeholder for mean vector
+// @param B_1 Matrix acting as placeholder for covariance matrix
+// @param nu Cube containing MCMC samples for nu
+// @param nu_mean Matrix containing the conditional posterior means of nu used to draw the current sample
+template<class Data, class Coefs, class Temper, class Rng>
+inline void updateNuKernel(const Data& data,
+                           const Coefs& coefs,
+                           const Temper& temper,
+                           Rng& rng,
+                           const arma::vec& prior_scale,
+                           const arma::mat& P,
+                           const arma::mat& Z,
+                           const arma::mat& chi,
+                           const double sigma,
+                           const int iter,
+                           const int tot_mcmc_iters,
+                           Workspace& ws,
+                           arma::vec& b_1,
+                           arma::mat& B_1,
+                           arma::cube& nu,
+                           arma::mat& nu_mean){
+  NuKernel<Data, Coefs, Temper, Rng> kernel = {data, coefs, temper, rng,
+                                               prior_scale, P, Z, chi, sigma,
+                                               iter, ws, b_1, B_1, nu, nu_mean};
+  dispatchDims(Z.n_cols, chi.n_cols, kernel);
+  if(iter < (tot_mcmc_iters - 1)){
+    nu.slice(iter + 1) = nu.slice(iter);
+  }
+}
+
+// Updates the nu parameters of the multivariate model, whose prior precision
+// of nu_j is diagonal with scale 1 / tau_j
+//
+// @name updateNuKernelMV
+template<class Coefs, class Temper>
+inline void updateNuKernelMV(const arma::mat& y_obs,
+                             const Coefs& coefs,
+                             const Temper& temper,
+                             const arma::vec& tau,
+                             const arma::mat& Z,
+                             const arma::mat& chi,
+                             const double sigma,
+                             const int iter,
+                             const int tot_mcmc_iters,
+                             arma::vec& b_1,
+                             arma::mat& B_1,
+                             arma::cube& nu){
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  arma::mat nu_mean(nu.n_rows, nu.n_cols);
+  const arma::vec prior_scale = 1 / tau;
+  const arma::mat I = arma::eye(nu.n_cols, nu.n_cols);
+  updateNuKernel(MVData{y_obs}, coefs, temper, rng, prior_scale, I, Z, chi,
+                 sigma, iter, tot_mcmc_iters, ws, b_1, B_1, nu, nu_mean);
+}
+
 // Updates the nu parameters
 //
 // @name updateNu
@@ -34,43 +173,12 @@ inline void updateNu(const arma::field<arma::vec>& y_obs,
                      arma::vec& b_1,
                      arma::mat& B_1,
                      arma::cube& nu){
-  double ph = 0;
-  // initialize P matrix
-  for(int j = 0; j < nu.n_rows; j++){
-    b_1.zeros();
-    B_1.zeros();
-    for(int i = 0; i < Z.n_rows; i++){
-      if(Z(i,j) != 0){
-        for(int l = 0; l < y_obs(i,0).n_elem; l++){
-          ph = 0;
-          ph = y_obs(i,0)(l);
-          B_1 = B_1 + Z(i,j) * Z(i,j) * (B_obs(i,0).row(l).t() * B_obs(i,0).row(l));
-          for(int k = 0; k < nu.n_rows; k++){
-            if(Z(i,k) != 0){
-              if(k != j){
-                ph = ph -  Z(i,k) * (arma::dot(nu.slice(iter).row(k),
-                                     B_obs(i,0).row(l)));
-              }
-              for(int n = 0; n < Phi.n_slices; n++){
-                ph = ph - Z(i,k) * (chi(i,n) * arma::dot(Phi.slice(n).row(k),
-                                    B_obs(i,0).row(l)));
-              }
-            }
-          }
-          b_1 = b_1 + Z(i,j) * B_obs(i,0).row(l).t() * ph;
-        }
-      }
-    }
-    b_1 = b_1 / sigma;
-    B_1 = B_1 / sigma;
-    B_1 = B_1 + tau(j) * P;
-    B_1 = arma::pinv(B_1);
-    B_1 = (B_1 + B_1.t())/2;
-    nu.slice(iter).row(j) = arma::mvnrnd(B_1 * b_1, B_1).t();
-  }
-  if(iter < (tot_mcmc_iters - 1)){
-    nu.slice(iter + 1) = nu.slice(iter);
-  }
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  arma::mat nu_mean(nu.n_rows, nu.n_cols);
+  updateNuKernel(FieldData{y_obs, B_obs}, SharedCoefs{nu.slice(iter), Phi},
+                 Untempered(), rng, tau, P, Z, chi, sigma, iter,
+                 tot_mcmc_iters, ws, b_1, B_1, nu, nu_mean);
 }
 
 // Updates the nu parameters using tempered transitions
@@ -104,45 +212,372 @@ inline void updateNuTempered(const double& beta_i,
                              arma::vec& b_1,
                              arma::mat& B_1,
                              arma::cube& nu){
-  double ph = 0;
-  // initialize P matrix
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  arma::mat nu_mean(nu.n_rows, nu.n_cols);
+  updateNuKernel(FieldData{y_obs, B_obs}, SharedCoefs{nu.slice(iter), Phi},
+                 Tempered{beta_i}, rng, tau, P, Z, chi, sigma, iter,
+                 tot_mcmc_iters, ws, b_1, B_1, nu, nu_mean);
+}
+
+// Updates the nu parameters using tempered transitions and contiguous
+// observation storage
+//
+// @name updateNuTempered
+// @param beta_i temperature at current step
+// @param obs RaggedObs containing observed values and basis functions
+// @param tau Vector containing current tau parameters
+// @param Phi Cube containing current Phi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param sigma Double containing current sigma parameter
+// @param iter Int containing MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param P Matrix containing tridiagonal P matrix
+// @param ws Workspace used as scratch memory
+// @param b_1 Vector acting as a placeholder for mean vector
+// @param B_1 Matrix acting as placeholder for covariance matrix
+// @param nu Cube containing MCMC samples for nu
+// @param nu_mean Matrix containing the conditional posterior means of nu used to draw the current sample
+inline void updateNuTempered(const double& beta_i,
+                             const RaggedObs& obs,
+                             const arma::vec& tau,
+                             const arma::cube& Phi,
+                             const arma::mat& Z,
+                             const arma::mat& chi,
+                             const double& sigma,
+                             const int& iter,
+                             const int& tot_mcmc_iters,
+                             const arma::mat& P,
+                             Workspace& ws,
+                             arma::vec& b_1,
+                             arma::mat& B_1,
+                             arma::cube& nu,
+                             arma::mat& nu_mean){
+  RRng rng;
+  updateNuKernel(RaggedData{obs}, SharedCoefs{nu.slice(iter), Phi},
+                 Tempered{beta_i}, rng, tau, P, Z, chi, sigma, iter,
+                 tot_mcmc_iters, ws, b_1, B_1, nu, nu_mean);
+}
+
+// Updates the nu parameters using tempered transitions and contiguous
+// observation storage
+//
+// @name updateNuTempered
+inline void updateNuTempered(const double& beta_i,
+                             const RaggedObs& obs,
+                             const arma::vec& tau,
+                             const arma::cube& Phi,
+                             const arma::mat& Z,
+                             const arma::mat& chi,
+                             const double& sigma,
+                             const int& iter,
+                             const int& tot_mcmc_iters,
+                             const arma::mat& P,
+                             arma::vec& b_1,
+                             arma::mat& B_1,
+                             arma::cube& nu,
+                             arma::mat& nu_mean){
+  Workspace ws = makeWorkspace();
+  updateNuTempered(beta_i, obs, tau, Phi, Z, chi, sigma, iter, tot_mcmc_iters,
+                   P, ws, b_1, B_1, nu, nu_mean);
+}
+
+// Updates the nu parameters using tempered transitions, contiguous
+// observation storage and a workspace, discarding the conditional posterior
+// means
+//
+// @name updateNuTempered
+inline void updateNuTempered(const double& beta_i,
+                             const RaggedObs& obs,
+                             const arma::vec& tau,
+                             const arma::cube& Phi,
+                             const arma::mat& Z,
+                             const arma::mat& chi,
+                             const double& sigma,
+                             const int& iter,
+                             const int& tot_mcmc_iters,
+                             const arma::mat& P,
+                             Workspace& ws,
+                             arma::vec& b_1,
+                             arma::mat& B_1,
+                             arma::cube& nu){
+  arma::mat& nu_mean = fitScratch(ws.nu_mean, nu.n_rows, nu.n_cols, ws.n_alloc);
+  updateNuTempered(beta_i, obs, tau, Phi, Z, chi, sigma, iter, tot_mcmc_iters,
+                   P, ws, b_1, B_1, nu, nu_mean);
+}
+
+// Updates the nu parameters using tempered transitions, single precision
+// observation storage and a workspace, discarding the conditional posterior
+// means
+//
+// @name updateNuTempered
+inline void updateNuTempered(const double& beta_i,
+                             const RaggedObsF& obs,
+                             const arma::vec& tau,
+                             const arma::cube& Phi,
+                             const arma::mat& Z,
+                             const arma::mat& chi,
+                             const double& sigma,
+                             const int& iter,
+                             const int& tot_mcmc_iters,
+                             const arma::mat& P,
+                             Workspace& ws,
+                             arma::vec& b_1,
+                             arma::mat& B_1,
+                             arma::cube& nu){
+  RRng rng;
+  arma::mat& nu_mean = fitScratch(ws.nu_mean, nu.n_rows, nu.n_cols, ws.n_alloc);
+  updateNuKernel(RaggedDataF{obs}, SharedCoefs{nu.slice(iter), Phi},
+                 Tempered{beta_i}, rng, tau, P, Z, chi, sigma, iter,
+                 tot_mcmc_iters, ws, b_1, B_1, nu, nu_mean);
+}
+
+// Updates the nu parameters using contiguous observation storage and a
+// workspace
+//
+// @name updateNu
+inline void updateNu(const RaggedObs& obs,
+                     const arma::vec& tau,
+                     const arma::cube& Phi,
+                     const arma::mat& Z,
+                     const arma::mat& chi,
+                     const double& sigma,
+                     const int& iter,
+                     const int& tot_mcmc_iters,
+                     const arma::mat& P,
+                     Workspace& ws,
+                     arma::vec& b_1,
+                     arma::mat& B_1,
+                     arma::cube& nu,
+                     arma::mat& nu_mean){
+  RRng rng;
+  updateNuKernel(RaggedData{obs}, SharedCoefs{nu.slice(iter), Phi},
+                 Untempered(), rng, tau, P, Z, chi, sigma, iter,
+                 tot_mcmc_iters, ws, b_1, B_1, nu, nu_mean);
+}
+
+// Updates the nu parameters using single precision observation storage and a
+// workspace
+//
+// @name updateNu
+inline void updateNu(const RaggedObsF& obs,
+                     const arma::vec& tau,
+                     const arma::cube& Phi,
+                     const arma::mat& Z,
+                     const arma::mat& chi,
+                     const double& sigma,
+                     const int& iter,
+                     const int& tot_mcmc_iters,
+                     const arma::mat& P,
+                     Workspace& ws,
+                     arma::vec& b_1,
+                     arma::mat& B_1,
+                     arma::cube& nu,
+                     arma::mat& nu_mean){
+  RRng rng;
+  updateNuKernel(RaggedDataF{obs}, SharedCoefs{nu.slice(iter), Phi},
+                 Untempered(), rng, tau, P, Z, chi, sigma, iter,
+                 tot_mcmc_iters, ws, b_1, B_1, nu, nu_mean);
+}
+
+// Updates the nu parameters using contiguous observation storage
+//
+// @name updateNu
+// @param obs RaggedObs containing observed values and basis functions
+// @param tau Vector containing current tau parameters
+// @param Phi Cube containing current Phi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param sigma Double containing current sigma parameter
+// @param iter Int containing MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param P Matrix containing tridiagonal P matrix
+// @param b_1 Vector acting as a placeholder for mean vector
+// @param B_1 Matrix acting as placeholder for covariance matrix
+// @param nu Cube containing MCMC samples for nu
+// @param nu_mean Matrix containing the conditional posterior means of nu used to draw the current sample
+inline void updateNu(const RaggedObs& obs,
+                     const arma::vec& tau,
+                     const arma::cube& Phi,
+                     const arma::mat& Z,
+                     const arma::mat& chi,
+                     const double& sigma,
+                     const int& iter,
+                     const int& tot_mcmc_iters,
+                     const arma::mat& P,
+                     arma::vec& b_1,
+                     arma::mat& B_1,
+                     arma::cube& nu,
+                     arma::mat& nu_mean){
+  updateNuTempered(1.0, obs, tau, Phi, Z, chi, sigma, iter, tot_mcmc_iters,
+                   P, b_1, B_1, nu, nu_mean);
+}
+
+
+// Updates the nu parameters using tempered transitions and contiguous
+// observation storage, discarding the conditional posterior means
+//
+// @name updateNuTempered
+inline void updateNuTempered(const double& beta_i,
+                             const RaggedObs& obs,
+                             const arma::vec& tau,
+                             const arma::cube& Phi,
+                             const arma::mat& Z,
+                             const arma::mat& chi,
+                             const double& sigma,
+                             const int& iter,
+                             const int& tot_mcmc_iters,
+                             const arma::mat& P,
+                             arma::vec& b_1,
+                             arma::mat& B_1,
+                             arma::cube& nu){
+  arma::mat nu_mean(nu.n_rows, nu.n_cols);
+  updateNuTempered(beta_i, obs, tau, Phi, Z, chi, sigma, iter, tot_mcmc_iters,
+                   P, b_1, B_1, nu, nu_mean);
+}
+
+// Updates the nu parameters using contiguous observation storage, discarding
+// the conditional posterior means
+//
+// @name updateNu
+inline void updateNu(const RaggedObs& obs,
+                     const arma::vec& tau,
+                     const arma::cube& Phi,
+                     const arma::mat& Z,
+                     const arma::mat& chi,
+                     const double& sigma,
+                     const int& iter,
+                     const int& tot_mcmc_iters,
+                     const arma::mat& P,
+                     arma::vec& b_1,
+                     arma::mat& B_1,
+                     arma::cube& nu){
+  arma::mat nu_mean(nu.n_rows, nu.n_cols);
+  updateNuTempered(1.0, obs, tau, Phi, Z, chi, sigma, iter, tot_mcmc_iters,
+                   P, b_1, B_1, nu, nu_mean);
+}
+
+// Updates the nu parameters by iterated conditional modes, setting each row of
+// nu to its conditional posterior mode, i.e. its mean since the conditional is
+// Gaussian (used by the ICM initializer). This is updateNuKernel run with
+// ConditionalMode as the source of randomness.
+//
+// @name updateNuICM
+// @param obs RaggedObs containing observed values and basis functions
+// @param tau Vector containing current tau parameters
+// @param Phi Cube containing current Phi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param sigma Double containing current sigma parameter
+// @param iter Int containing current iteration
+// @param tot_mcmc_iters Int containing total number of iterations
+// @param P Matrix containing tridiagonal P matrix
+// @param b_1 Vector acting as a placeholder for mean vector
+// @param B_1 Matrix acting as placeholder for covariance matrix
+// @param nu Cube containing the estimates of nu at each iteration
+inline void updateNuICM(const RaggedObs& obs,
+                        const arma::vec& tau,
+                        const arma::cube& Phi,
+                        const arma::mat& Z,
+                        const arma::mat& chi,
+                        const double& sigma,
+                        const int& iter,
+                        const int& tot_mcmc_iters,
+                        const arma::mat& P,
+                        arma::vec& b_1,
+                        arma::mat& B_1,
+                        arma::cube& nu){
+  Workspace ws = makeWorkspace();
+  ConditionalMode mode;
+  arma::mat nu_mean(nu.n_rows, nu.n_cols);
+  updateNuKernel(RaggedData{obs}, SharedCoefs{nu.slice(iter), Phi},
+                 Untempered(), mode, tau, P, Z, chi, sigma, iter,
+                 tot_mcmc_iters, ws, b_1, B_1, nu, nu_mean);
+}
+
+// Updates the nu parameters using tempered transitions without forming the
+// inverse of the conditional posterior precision of each row of nu. The data
+// and the prior are perturbed and the resulting sparse system is solved by
+// preconditioned conjugate gradients (see drawGaussianPO), so the cost grows
+// with the number of non-zero basis function evaluations instead of P^3.
+//
+// @name updateNuTemperedPCG
+// @param beta_i temperature at current step
+// @param obs RaggedObs containing observed values and basis functions
+// @param B_sp Sparse matrix containing obs.B_t
+// @param tau Vector containing current tau parameters
+// @param Phi Cube containing current Phi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param sigma Double containing current sigma parameter
+// @param iter Int containing MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param P_diff Sparse matrix containing the differences between adjacent basis coefficients (P = P_diff' P_diff)
+// @param P Sparse matrix containing the P matrix
+// @param nu Cube containing MCMC samples for nu
+inline void updateNuTemperedPCG(const double& beta_i,
+                                const RaggedObs& obs,
+                                const arma::sp_mat& B_sp,
+                                const arma::vec& tau,
+                                const arma::cube& Phi,
+                                const arma::mat& Z,
+                                const arma::mat& chi,
+                                const double& sigma,
+                                const int& iter,
+                                const int& tot_mcmc_iters,
+                                const arma::sp_mat& P_diff,
+                                const arma::sp_mat& P,
+                                arma::cube& nu){
+  arma::vec coef = arma::zeros(nu.n_cols);
+  arma::vec resid = arma::zeros(obs.y.n_elem);
+  arma::vec xi(P_diff.n_rows);
+  arma::vec x;
   for(int j = 0; j < nu.n_rows; j++){
-    b_1.zeros();
-    B_1.zeros();
     for(int i = 0; i < Z.n_rows; i++){
-      if(Z(i,j) != 0){
-        for(int l = 0; l < y_obs(i,0).n_elem; l++){
-          ph = 0;
-          ph = y_obs(i,0)(l);
-          B_1 = B_1 + Z(i,j) * Z(i,j) * (B_obs(i,0).row(l).t() * B_obs(i,0).row(l));
-          for(int k = 0; k < nu.n_rows; k++){
-            if(Z(i,k) != 0){
-              if(k != j){
-                ph = ph - Z(i,k) * (arma::dot(nu.slice(iter).row(k),
-                                    B_obs(i,0).row(l)));
-              }
-              for(int n = 0; n < Phi.n_slices; n++){
-                ph = ph - Z(i,k) * (chi(i,n) * arma::dot(Phi.slice(n).row(k),
-                                    B_obs(i,0).row(l)));
-              }
-            }
-          }
-          b_1 = b_1 + Z(i,j) * B_obs(i,0).row(l).t() * ph;
-        }
+      if((Z(i,j) != 0) && (obs.n_obs(i) > 0)){
+        // residual after removing every term except nu_j
+        calcMeanCoef(nu.slice(iter), Phi, Z.row(i), chi.row(i), coef);
+        coef -= Z(i,j) * nu.slice(iter).row(j).t();
+        sparseResid(obs, B_sp, i, coef, resid);
       }
     }
-    b_1 = b_1 * (beta_i / sigma);
-    B_1 = B_1 * (beta_i / sigma);
-    B_1 = B_1 + tau(j) * P;
-    B_1 = arma::pinv(B_1);
-    B_1 = (B_1 + B_1.t())/2;
-    nu.slice(iter).row(j) = arma::mvnrnd(B_1 * b_1, B_1).t();
+    // draw from N(0, tau_j * P) using the difference matrix
+    for(arma::uword l = 0; l < xi.n_elem; l++){
+      xi(l) = R::norm_rand();
+    }
+    arma::vec v = std::sqrt(tau(j)) * (P_diff.t() * xi);
+    x = nu.slice(iter).row(j).t();
+    arma::sp_mat Q_0 = tau(j) * P;
+    drawGaussianPO(weightedBasis(obs, B_sp, Z.col(j)), resid, beta_i / sigma,
+                   Q_0, v, x);
+    nu.slice(iter).row(j) = x.t();
   }
   if(iter < (tot_mcmc_iters - 1)){
     nu.slice(iter + 1) = nu.slice(iter);
   }
 }
 
+// Updates the nu parameters without forming the inverse of the conditional
+// posterior precision of each row of nu
+//
+// @name updateNuPCG
+inline void updateNuPCG(const RaggedObs& obs,
+                        const arma::sp_mat& B_sp,
+                        const arma::vec& tau,
+                        const arma::cube& Phi,
+                        const arma::mat& Z,
+                        const arma::mat& chi,
+                        const double& sigma,
+                        const int& iter,
+                        const int& tot_mcmc_iters,
+                        const arma::sp_mat& P_diff,
+                        const arma::sp_mat& P,
+                        arma::cube& nu){
+  updateNuTemperedPCG(1.0, obs, B_sp, tau, Phi, Z, chi, sigma, iter,
+                      tot_mcmc_iters, P_diff, P, nu);
+}
+
 // Updates the nu parameters for the multivariate model
 //
 // @name updateNuMV
@@ -168,39 +603,8 @@ inline void updateNuMV(const arma::mat& y_obs,
                        arma::vec& b_1,
                        arma::mat& B_1,
                        arma::cube& nu){
-  // initialize P matrix
-  for(int j = 0; j < nu.n_rows; j++){
-    b_1.zeros();
-    B_1.zeros();
-    for(int i = 0; i < Z.n_rows; i++){
-      if(Z(i,j) != 0){
-        arma::vec ph = arma::zeros(y_obs.n_cols);
-        ph = y_obs.row(i).t();
-        B_1 = B_1 + Z(i,j) * Z(i,j) * arma::eye(y_obs.n_cols, y_obs.n_cols);
-        for(int k = 0; k < nu.n_rows; k++){
-          if(Z(i,k) != 0){
-            if(k != j){
-              ph = ph - Z(i,k) * nu.slice(iter).row(k).t();
-            }
-            for(int n = 0; n < Phi.n_slices; n++){
-              ph = ph - Z(i,k) * chi(i,n) * Phi.slice(n).row(k).t();
-            }
-          }
-        }
-        b_1 = b_1 + Z(i,j) * ph;
-      }
-    }
-    b_1 = b_1 / sigma;
-    B_1 = B_1 / sigma;
-    arma::mat D = arma::diagmat((1 / tau(j)) * arma::ones(b_1.n_elem));
-    B_1 = B_1 + D;
-    B_1 = arma::pinv(B_1);
-    B_1 = (B_1 + B_1.t())/2;
-    nu.slice(iter).row(j) = arma::mvnrnd(B_1 * b_1, B_1).t();
-  }
-  if(iter < (tot_mcmc_iters - 1)){
-    nu.slice(iter + 1) = nu.slice(iter);
-  }
+  updateNuKernelMV(y_obs, SharedCoefs{nu.slice(iter), Phi}, Untempered(), tau,
+                   Z, chi, sigma, iter, tot_mcmc_iters, b_1, B_1, nu);
 }
 
 // Updates the nu parameters for the tempered multivariate model
@@ -230,39 +634,8 @@ inline void updateNuTemperedMV(const double& beta_i,
                                arma::vec& b_1,
                                arma::mat& B_1,
                                arma::cube& nu){
-
-  for(int j = 0; j < nu.n_rows; j++){
-    b_1.zeros();
-    B_1.zeros();
-    for(int i = 0; i < Z.n_rows; i++){
-      if(Z(i,j) != 0){
-        arma::vec ph = arma::zeros(y_obs.n_cols);
-        ph = y_obs.row(i).t();
-        B_1 = B_1 + Z(i,j) * Z(i,j) * arma::eye(y_obs.n_cols, y_obs.n_cols);
-        for(int k = 0; k < nu.n_rows; k++){
-          if(Z(i,k) != 0){
-            if(k != j){
-              ph = ph - Z(i,k) * nu.slice(iter).row(k).t();
-            }
-            for(int n = 0; n < Phi.n_slices; n++){
-              ph = ph - Z(i,k) * chi(i,n) * Phi.slice(n).row(k).t();
-            }
-          }
-        }
-        b_1 = b_1 + Z(i,j) * ph;
-      }
-    }
-    b_1 = b_1 * (beta_i / sigma);
-    B_1 = B_1 * (beta_i / sigma);
-    arma::mat D = arma::diagmat((1 / tau(j)) * arma::ones(b_1.n_elem));
-    B_1 = B_1 + D;
-    B_1 = arma::pinv(B_1);
-    B_1 = (B_1 + B_1.t())/2;
-    nu.slice(iter).row(j) = arma::mvnrnd(B_1 * b_1, B_1).t();
-  }
-  if(iter < (tot_mcmc_iters - 1)){
-    nu.slice(iter + 1) = nu.slice(iter);
-  }
+  updateNuKernelMV(y_obs, SharedCoefs{nu.slice(iter), Phi}, Tempered{beta_i},
+                   tau, Z, chi, sigma, iter, tot_mcmc_iters, b_1, B_1, nu);
 }
 
 // Updates the nu parameters for the covariate adjusted functional model
@@ -300,47 +673,13 @@ inline void updateNuCovariateAdj(const arma::field<arma::vec>& y_obs,
                                  arma::vec& b_1,
                                  arma::mat& B_1,
                                  arma::cube& nu){
-  double ph = 0;
-  // initialize P matrix
-  for(int j = 0; j < nu.n_rows; j++){
-    b_1.zeros();
-    B_1.zeros();
-    for(int i = 0; i < Z.n_rows; i++){
-      if(Z(i,j) != 0){
-        for(int l = 0; l < y_obs(i,0).n_elem; l++){
-          ph = 0;
-          ph = y_obs(i,0)(l);
-          B_1 = B_1 + Z(i,j) * Z(i,j) * (B_obs(i,0).row(l).t() * B_obs(i,0).row(l));
-          for(int k = 0; k < nu.n_rows; k++){
-            if(Z(i,k) != 0){
-              if(k != j){
-                ph = ph -  Z(i,k) * (arma::dot(nu.slice(iter).row(k),
-                                     B_obs(i,0).row(l)));
-              }
-              ph = ph - Z(i,k) * (arma::dot(eta.slice(k) * X.row(i).t(),
-                                  B_obs(i,0).row(l)));
-
-              for(int n = 0; n < Phi.n_slices; n++){
-                ph = ph - Z(i,k) * chi(i,n) * (arma::dot(Phi.slice(n).row(k),
-                                       B_obs(i,0).row(l)) + arma::dot(xi(iter,k).slice(n) * X.row(i).t(),
-                                       B_obs(i,0).row(l)));
-              }
-            }
-          }
-          b_1 = b_1 + Z(i,j) * B_obs(i,0).row(l).t() * ph;
-        }
-      }
-    }
-    b_1 = b_1 / sigma;
-    B_1 = B_1 / sigma;
-    B_1 = B_1 + tau(j) * P;
-    B_1 = arma::pinv(B_1);
-    B_1 = (B_1 + B_1.t())/2;
-    nu.slice(iter).row(j) = arma::mvnrnd(B_1 * b_1, B_1).t();
-  }
-  if(iter < (tot_mcmc_iters - 1)){
-    nu.slice(iter + 1) = nu.slice(iter);
-  }
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  arma::mat nu_mean(nu.n_rows, nu.n_cols);
+  updateNuKernel(FieldData{y_obs, B_obs},
+                 CovariateCoefs{nu.slice(iter), eta, Phi, xi, iter, X},
+                 Untempered(), rng, tau, P, Z, chi, sigma, iter,
+                 tot_mcmc_iters, ws, b_1, B_1, nu, nu_mean);
 }
 
 // Updates the nu parameters using tempered transitions for the covariate adjusted functional model
@@ -380,47 +719,87 @@ inline void updateNuTemperedCovariateAdj(const double& beta_i,
                                          arma::vec& b_1,
                                          arma::mat& B_1,
                                          arma::cube& nu){
-  double ph = 0;
-  // initialize P matrix
-  for(int j = 0; j < nu.n_rows; j++){
-    b_1.zeros();
-    B_1.zeros();
-    for(int i = 0; i < Z.n_rows; i++){
-      if(Z(i,j) != 0){
-        for(int l = 0; l < y_obs(i,0).n_elem; l++){
-          ph = 0;
-          ph = y_obs(i,0)(l);
-          B_1 = B_1 + Z(i,j) * Z(i,j) * (B_obs(i,0).row(l).t() * B_obs(i,0).row(l));
-          for(int k = 0; k < nu.n_rows; k++){
-            if(Z(i,k) != 0){
-              if(k != j){
-                ph = ph - Z(i,k) * (arma::dot(nu.slice(iter).row(k),
-                                    B_obs(i,0).row(l)));
-              }
-              ph = ph - Z(i,k) * (arma::dot(eta.slice(k) * X.row(i).t(),
-                                  B_obs(i,0).row(l)));
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  arma::mat nu_mean(nu.n_rows, nu.n_cols);
+  updateNuKernel(FieldData{y_obs, B_obs},
+                 CovariateCoefs{nu.slice(iter), eta, Phi, xi, iter, X},
+                 Tempered{beta_i}, rng, tau, P, Z, chi, sigma, iter,
+                 tot_mcmc_iters, ws, b_1, B_1, nu, nu_mean);
+}
 
-              for(int n = 0; n < Phi.n_slices; n++){
-                ph = ph - Z(i,k) * chi(i,n) * (arma::dot(Phi.slice(n).row(k),
-                                       B_obs(i,0).row(l)) + arma::dot(xi(iter,k).slice(n) * X.row(i).t(),
-                                       B_obs(i,0).row(l)));
-              }
-            }
-          }
-          b_1 = b_1 + Z(i,j) * B_obs(i,0).row(l).t() * ph;
-        }
-      }
-    }
-    b_1 = b_1 * (beta_i / sigma);
-    B_1 = B_1 * (beta_i / sigma);
-    B_1 = B_1 + tau(j) * P;
-    B_1 = arma::pinv(B_1);
-    B_1 = (B_1 + B_1.t())/2;
-    nu.slice(iter).row(j) = arma::mvnrnd(B_1 * b_1, B_1).t();
-  }
-  if(iter < (tot_mcmc_iters - 1)){
-    nu.slice(iter + 1) = nu.slice(iter);
-  }
+// Updates the nu parameters for the covariate adjusted model using tempered
+// transitions and the cached covariate adjusted coefficients
+//
+// @name updateNuTemperedCovariateAdj
+// @param beta_i temperature at current step
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients (updated after each draw)
+// @param tau Vector containing current tau parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param sigma Double containing current sigma parameter
+// @param iter Int containing MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param P Matrix containing tridiagonal P matrix
+// @param b_1 Vector acting as a placeholder for mean vector
+// @param B_1 Matrix acting as placeholder for covariance matrix
+// @param nu Cube containing MCMC samples for nu
+inline void updateNuTemperedCovariateAdj(const double& beta_i,
+                                         const RaggedObs& obs,
+                                         CovariateEffects& cov,
+                                         const arma::vec& tau,
+                                         const arma::mat& Z,
+                                         const arma::mat& chi,
+                                         const double& sigma,
+                                         const int& iter,
+                                         const int& tot_mcmc_iters,
+                                         const arma::mat& P,
+                                         arma::vec& b_1,
+                                         arma::mat& B_1,
+                                         arma::cube& nu){
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  arma::mat nu_mean(nu.n_rows, nu.n_cols);
+  updateNuKernel(RaggedData{obs}, SyncedCovariateCoefs{cov}, Tempered{beta_i},
+                 rng, tau, P, Z, chi, sigma, iter, tot_mcmc_iters, ws, b_1,
+                 B_1, nu, nu_mean);
+}
+
+// Updates the nu parameters for the covariate adjusted model using the
+// cached covariate adjusted coefficients
+//
+// @name updateNuCovariateAdj
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients (updated after each draw)
+// @param tau Vector containing current tau parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param sigma Double containing current sigma parameter
+// @param iter Int containing MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param P Matrix containing tridiagonal P matrix
+// @param b_1 Vector acting as a placeholder for mean vector
+// @param B_1 Matrix acting as placeholder for covariance matrix
+// @param nu Cube containing MCMC samples for nu
+inline void updateNuCovariateAdj(const RaggedObs& obs,
+                                 CovariateEffects& cov,
+                                 const arma::vec& tau,
+                                 const arma::mat& Z,
+                                 const arma::mat& chi,
+                                 const double& sigma,
+                                 const int& iter,
+                                 const int& tot_mcmc_iters,
+                                 const arma::mat& P,
+                                 arma::vec& b_1,
+                                 arma::mat& B_1,
+                                 arma::cube& nu){
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  arma::mat nu_mean(nu.n_rows, nu.n_cols);
+  updateNuKernel(RaggedData{obs}, SyncedCovariateCoefs{cov}, Untempered(),
+                 rng, tau, P, Z, chi, sigma, iter, tot_mcmc_iters, ws, b_1,
+                 B_1, nu, nu_mean);
 }
 
 // Updates the nu parameters for the multivariate model
@@ -454,42 +833,9 @@ inline void updateNuMVCovariateAdj(const arma::mat& y_obs,
                                    arma::vec& b_1,
                                    arma::mat& B_1,
                                    arma::cube& nu){
-  // initialize P matrix
-  for(int j = 0; j < nu.n_rows; j++){
-    b_1.zeros();
-    B_1.zeros();
-    for(int i = 0; i < Z.n_rows; i++){
-      if(Z(i,j) != 0){
-        arma::vec ph = arma::zeros(y_obs.n_cols);
-        ph = y_obs.row(i).t();
-        B_1 = B_1 + Z(i,j) * Z(i,j) * arma::eye(y_obs.n_cols, y_obs.n_cols);
-        for(int k = 0; k < nu.n_rows; k++){
-          if(Z(i,k) != 0){
-            if(k != j){
-              ph = ph - Z(i,k) * nu.slice(iter).row(k).t();
-            }
-            ph = ph - Z(i,k) * (eta.slice(k) * X.row(i).t());
-
-            for(int n = 0; n < Phi.n_slices; n++){
-              ph = ph - Z(i,k) * chi(i,n) * (Phi.slice(n).row(k).t() +
-                xi(iter,k).slice(n) * X.row(i).t());
-            }
-          }
-        }
-        b_1 = b_1 + Z(i,j) * ph;
-      }
-    }
-    b_1 = b_1 / sigma;
-    B_1 = B_1 / sigma;
-    arma::mat D = arma::diagmat((1 / tau(j)) * arma::ones(b_1.n_elem));
-    B_1 = B_1 + D;
-    B_1 = arma::pinv(B_1);
-    B_1 = (B_1 + B_1.t())/2;
-    nu.slice(iter).row(j) = arma::mvnrnd(B_1 * b_1, B_1).t();
-  }
-  if(iter < (tot_mcmc_iters - 1)){
-    nu.slice(iter + 1) = nu.slice(iter);
-  }
+  updateNuKernelMV(y_obs, CovariateCoefs{nu.slice(iter), eta, Phi, xi, iter, X},
+                   Untempered(), tau, Z, chi, sigma, iter, tot_mcmc_iters, b_1,
+                   B_1, nu);
 }
 
 // Updates the nu parameters for the tempered multivariate model
@@ -525,42 +871,9 @@ inline void updateNuTemperedMVCovariateAdj(const double& beta_i,
                                            arma::vec& b_1,
                                            arma::mat& B_1,
                                            arma::cube& nu){
-
-  for(int j = 0; j < nu.n_rows; j++){
-    b_1.zeros();
-    B_1.zeros();
-    for(int i = 0; i < Z.n_rows; i++){
-      if(Z(i,j) != 0){
-        arma::vec ph = arma::zeros(y_obs.n_cols);
-        ph = y_obs.row(i).t();
-        B_1 = B_1 + Z(i,j) * Z(i,j) * arma::eye(y_obs.n_cols, y_obs.n_cols);
-        for(int k = 0; k < nu.n_rows; k++){
-          if(Z(i,k) != 0){
-            if(k != j){
-              ph = ph - Z(i,k) * nu.slice(iter).row(k).t();
-            }
-            ph = ph - Z(i,k) * (eta.slice(k) * X.row(i).t());
-
-            for(int n = 0; n < Phi.n_slices; n++){
-              ph = ph - Z(i,k) * chi(i,n) * (Phi.slice(n).row(k).t() +
-                xi(iter,k).slice(n) * X.row(i).t());
-            }
-          }
-        }
-        b_1 = b_1 + Z(i,j) * ph;
-      }
-    }
-    b_1 = b_1 * (beta_i / sigma);
-    B_1 = B_1 * (beta_i / sigma);
-    arma::mat D = arma::diagmat((1 / tau(j)) * arma::ones(b_1.n_elem));
-    B_1 = B_1 + D;
-    B_1 = arma::pinv(B_1);
-    B_1 = (B_1 + B_1.t())/2;
-    nu.slice(iter).row(j) = arma::mvnrnd(B_1 * b_1, B_1).t();
-  }
-  if(iter < (tot_mcmc_iters - 1)){
-    nu.slice(iter + 1) = nu.slice(iter);
-  }
+  updateNuKernelMV(y_obs, CovariateCoefs{nu.slice(iter), eta, Phi, xi, iter, X},
+                   Tempered{beta_i}, tau, Z, chi, sigma, iter, tot_mcmc_iters,
+                   b_1, B_1, nu);
 }
 
 }
@@ -3,8 +3,123 @@
 
 #include <RcppArmadillo.h>
 #include <cmath>
+#include "ConditionalModes.h"
+#include "CovariateEffects.h"
+#include "Distributions.h"
+#include "KernelPolicies.h"
+#include "RaggedObs.h"
+#include "SparseGaussian.h"
+#include "Workspace.h"
 
 namespace BayesFMMM{
+// Updates the Phi parameters for one data model, coefficient policy,
+// temperature and source of randomness. The conditional posterior of each row
+// of Phi is accumulated by the data model (addGram) and drawn by
+// drawGaussianCanonical in the buffers of the workspace.
+//
+// @name PhiKernel
+template<class Data, class Coefs, class Temper, class Rng>
+struct PhiKernel{
+  const Data& data;
+  const Coefs& coefs;
+  const Temper& temper;
+  Rng& rng;
+  const arma::cube& gamma;
+  const arma::mat& tilde_tau;
+  const arma::mat& Z;
+  const arma::mat& chi;
+  const double sigma_sq;
+  Workspace& ws;
+  arma::vec& m_1;
+  arma::mat& M_1;
+  arma::cube& Phi;
+
+  template<int K_, int M_>
+  void run() const{
+    arma::vec& coef = fitScratch(ws.coef, Phi.n_cols, ws.n_alloc);
+    arma::vec& mean = fitScratch(ws.basis, Phi.n_cols, ws.n_alloc);
+    arma::vec& x = fitScratch(ws.dir, Phi.n_cols, ws.n_alloc);
+    arma::mat& U = fitScratch(ws.gram, Phi.n_cols, Phi.n_cols, ws.n_alloc);
+    const double w = temper.scale(1.0) / sigma_sq;
+    double z_chi = 0;
+    for(arma::uword j = 0; j < Phi.n_rows; j++){
+      for(arma::uword m = 0; m < Phi.n_slices; m++){
+        m_1.zeros();
+        M_1.zeros();
+        for(arma::uword i = 0; i < Z.n_rows; i++){
+          if(Z.at(i,j) != 0){
+            // residual after removing every term except Phi_jm
+            z_chi = Z.at(i,j) * chi.at(i,m);
+            coefs.template meanCoef<K_, M_>(i, Z, chi, coef);
+            for(arma::uword p = 0; p < Phi.n_cols; p++){
+              coef.at(p) = coef.at(p) - z_chi * Phi.at(j,p,m);
+            }
+            data.addGram(i, coef, z_chi * z_chi, z_chi, M_1, m_1);
+          }
+        }
+        for(arma::uword q = 0; q < Phi.n_cols; q++){
+          m_1.at(q) = w * m_1.at(q);
+          for(arma::uword p = 0; p <= q; p++){
+            M_1.at(p,q) = w * M_1.at(p,q);
+          }
+          //Add on diagonal component
+          M_1.at(q,q) = M_1.at(q,q) + tilde_tau(j,m) * gamma.at(j,q,m);
+        }
+        drawGaussianCanonical(M_1, m_1, rng, U, mean, x);
+        for(arma::uword p = 0; p < Phi.n_cols; p++){
+          coef.at(p) = x.at(p) - Phi.at(j,p,m);
+          Phi.at(j,p,m) = x.at(p);
+        }
+        coefs.movePhi(j, m, coef);
+      }
+    }
+  }
+};
+
+// Updates the Phi parameters
+//
+// @name updatePhiKernel
+// @param data Data model containing the observations
+// @param coefs Coefficient policy containing the mean coefficients of each function
+// @param temper Tempering policy
+// @param rng Source of randomness (ConditionalMode sets each row of Phi to its conditional mode)
+// @param gamma Cube containing current gamma parameters
+// @param tilde_tau vector containing current tilde_tau parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing chi values
+// @param sigma_sq double containing the sigma_sq variable
+// @param iter int containing current mcmc sample
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param ws Workspace used as scratch memory
+// @param m_1 Vector acting as a placeholder for m in mean vector
+// @param M_1 Matrix acting as a placeholder for M in covariance
+// @param Phi Field of Cubes containing all mcmc samples of Phi
+template<class Data, class Coefs, class Temper, class Rng>
+inline void updatePhiKernel(const Data& data,
+                            const Coefs& coefs,
+                            const Temper& temper,
+                            Rng& rng,
+                            const arma::cube& gamma,
+                            const arma::mat& tilde_tau,
+                            const arma::mat& Z,
+                            const arma::mat& chi,
+                            const double sigma_sq,
+                            const int iter,
+                            const int tot_mcmc_iters,
+                            Workspace& ws,
+                            arma::vec& m_1,
+                            arma::mat& M_1,
+                            arma::field<arma::cube>& Phi){
+  PhiKernel<Data, Coefs, Temper, Rng> kernel = {data, coefs, temper, rng, gamma,
+                                                tilde_tau, Z, chi, sigma_sq, ws,
+                                                m_1, M_1, Phi(iter,0)};
+  dispatchDims(Z.n_cols, chi.n_cols, kernel);
+  // Update next iteration
+  if(iter < (tot_mcmc_iters - 1)){
+    Phi(iter + 1,0) = Phi(iter,0);
+  }
+}
+
 // Updates the Phi parameters
 //
 // @name UpdatePhi
@@ -33,59 +148,11 @@ inline void updatePhi(const arma::field<arma::vec>& y_obs,
                       arma::vec& m_1,
                       arma::mat& M_1,
                       arma::field<arma::cube>& Phi){
-  m_1.zeros();
-  M_1.zeros();
-  double ph = 0;
-
-  for(int j =  0; j < Phi(iter,0).n_rows; j ++){
-    for(int m = 0; m < Phi(iter,0).n_slices; m++){
-      m_1.zeros();
-      M_1.zeros();
-      for(int i = 0; i < Z.n_rows; i++){
-        if(Z(i,j) != 0){
-          for(int l = 0; l < y_obs(i,0).n_elem; l++){
-            ph = 0;
-            ph = y_obs(i,0)(l) - Z(i,j) * arma::dot(nu.row(j),
-                       B_obs(i,0).row(l));
-            M_1 = M_1 + Z(i,j) *  Z(i,j) * (chi(i,m) * chi(i,m) *
-              B_obs(i,0).row(l).t() * B_obs(i,0).row(l));
-            for(int k = 0; k < nu.n_rows; k++){
-              for(int n = 0; n < Phi(iter,0).n_slices; n++){
-                if(k == j){
-                  if(n != m){
-                    ph = ph - (Z(i,j) * chi(i,n) *
-                      arma::dot(Phi(iter,0).slice(n).row(k), B_obs(i,0).row(l)));
-                  }
-                }else{
-                  ph = ph - (Z(i,k) * chi(i,n) *
-                    arma::dot(Phi(iter,0).slice(n).row(k),  B_obs(i,0).row(l)));
-                }
-              }
-              if(k != j){
-                ph = ph - Z(i,k) * arma::dot(nu.row(k), B_obs(i,0).row(l));
-              }
-            }
-            m_1 = m_1 + Z(i,j) * chi(i,m) * B_obs(i,0).row(l).t() * ph;
-          }
-        }
-      }
-      m_1 = m_1 * (1 / sigma_sq);
-      M_1 = M_1 * (1 / sigma_sq);
-
-      //Add on diagonal component
-      for(int k = 0; k < M_1.n_rows; k++){
-        M_1(k,k) = M_1(k,k) + tilde_tau(j,m) * gamma.slice(m)(j,k);
-      }
-      arma::inv(M_1, M_1);
-
-      //generate new sample
-      Phi(iter,0).slice(m).row(j) =  arma::mvnrnd(M_1 * m_1, M_1).t();
-    }
-  }
-  // Update next iteration
-  if(iter < (tot_mcmc_iters - 1)){
-    Phi(iter + 1,0) = Phi(iter,0);
-  }
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  updatePhiKernel(FieldData{y_obs, B_obs}, SharedCoefs{nu, Phi(iter,0)},
+                  Untempered(), rng, gamma, tilde_tau, Z, chi, sigma_sq, iter,
+                  tot_mcmc_iters, ws, m_1, M_1, Phi);
 }
 
 // Updates the Phi parameters using a Tempered Transition
@@ -118,53 +185,266 @@ inline void updatePhiTempered(const double& beta_i,
                               arma::vec& m_1,
                               arma::mat& M_1,
                               arma::field<arma::cube>& Phi){
-  m_1.zeros();
-  M_1.zeros();
-  double ph = 0;
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  updatePhiKernel(FieldData{y_obs, B_obs}, SharedCoefs{nu, Phi(iter,0)},
+                  Tempered{beta_i}, rng, gamma, tilde_tau, Z, chi, sigma_sq,
+                  iter, tot_mcmc_iters, ws, m_1, M_1, Phi);
+}
+
+// Updates the Phi parameters using a Tempered Transition and contiguous
+// observation storage
+//
+// @name UpdatePhiTempered
+// @param beta_i Double containing the current temperature
+// @param obs RaggedObs containing observed values and basis functions
+// @param nu Matrix containing current nu parameters
+// @param gamma Cube containing current gamma parameters
+// @param tilde_tau vector containing current tilde_tau parameters
+// @param Z Matrix containing current Z parameters
+// @param sigma_sq double containing the sigma_sq variable
+// @param chi Matrix containing chi values
+// @param iter int containing current mcmc sample
+// @param ws Workspace used as scratch memory
+// @param m_1 Vector acting as a placeholder for m in mean vector
+// @param M_1 Matrix acting as a placeholder for M in covariance
+// @param Phi Field of Cubes containing all mcmc samples of Phi
+inline void updatePhiTempered(const double& beta_i,
+                              const RaggedObs& obs,
+                              const arma::mat& nu,
+                              const arma::cube& gamma,
+                              const arma::mat& tilde_tau,
+                              const arma::mat& Z,
+                              const arma::mat& chi,
+                              const double& sigma_sq,
+                              const int& iter,
+                              const int& tot_mcmc_iters,
+                              Workspace& ws,
+                              arma::vec& m_1,
+                              arma::mat& M_1,
+                              arma::field<arma::cube>& Phi){
+  RRng rng;
+  updatePhiKernel(RaggedData{obs}, SharedCoefs{nu, Phi(iter,0)},
+                  Tempered{beta_i}, rng, gamma, tilde_tau, Z, chi, sigma_sq,
+                  iter, tot_mcmc_iters, ws, m_1, M_1, Phi);
+}
+
+// Updates the Phi parameters using a Tempered Transition, single precision
+// observation storage and a workspace
+//
+// @name UpdatePhiTempered
+inline void updatePhiTempered(const double& beta_i,
+                              const RaggedObsF& obs,
+                              const arma::mat& nu,
+                              const arma::cube& gamma,
+                              const arma::mat& tilde_tau,
+                              const arma::mat& Z,
+                              const arma::mat& chi,
+                              const double& sigma_sq,
+                              const int& iter,
+                              const int& tot_mcmc_iters,
+                              Workspace& ws,
+                              arma::vec& m_1,
+                              arma::mat& M_1,
+                              arma::field<arma::cube>& Phi){
+  RRng rng;
+  updatePhiKernel(RaggedDataF{obs}, SharedCoefs{nu, Phi(iter,0)},
+                  Tempered{beta_i}, rng, gamma, tilde_tau, Z, chi, sigma_sq,
+                  iter, tot_mcmc_iters, ws, m_1, M_1, Phi);
+}
+
+// Updates the Phi parameters using a Tempered Transition and contiguous
+// observation storage
+//
+// @name UpdatePhiTempered
+inline void updatePhiTempered(const double& beta_i,
+                              const RaggedObs& obs,
+                              const arma::mat& nu,
+                              const arma::cube& gamma,
+                              const arma::mat& tilde_tau,
+                              const arma::mat& Z,
+                              const arma::mat& chi,
+                              const double& sigma_sq,
+                              const int& iter,
+                              const int& tot_mcmc_iters,
+                              arma::vec& m_1,
+                              arma::mat& M_1,
+                              arma::field<arma::cube>& Phi){
+  Workspace ws = makeWorkspace();
+  updatePhiTempered(beta_i, obs, nu, gamma, tilde_tau, Z, chi, sigma_sq, iter,
+                    tot_mcmc_iters, ws, m_1, M_1, Phi);
+}
+
+// Updates the Phi parameters using contiguous observation storage and a
+// workspace
+//
+// @name UpdatePhi
+inline void updatePhi(const RaggedObs& obs,
+                      const arma::mat& nu,
+                      const arma::cube& gamma,
+                      const arma::mat& tilde_tau,
+                      const arma::mat& Z,
+                      const arma::mat& chi,
+                      const double& sigma_sq,
+                      const int& iter,
+                      const int& tot_mcmc_iters,
+                      Workspace& ws,
+                      arma::vec& m_1,
+                      arma::mat& M_1,
+                      arma::field<arma::cube>& Phi){
+  RRng rng;
+  updatePhiKernel(RaggedData{obs}, SharedCoefs{nu, Phi(iter,0)}, Untempered(),
+                  rng, gamma, tilde_tau, Z, chi, sigma_sq, iter, tot_mcmc_iters,
+                  ws, m_1, M_1, Phi);
+}
+
+// Updates the Phi parameters using single precision observation storage and a
+// workspace
+//
+// @name UpdatePhi
+inline void updatePhi(const RaggedObsF& obs,
+                      const arma::mat& nu,
+                      const arma::cube& gamma,
+                      const arma::mat& tilde_tau,
+                      const arma::mat& Z,
+                      const arma::mat& chi,
+                      const double& sigma_sq,
+                      const int& iter,
+                      const int& tot_mcmc_iters,
+                      Workspace& ws,
+                      arma::vec& m_1,
+                      arma::mat& M_1,
+                      arma::field<arma::cube>& Phi){
+  RRng rng;
+  updatePhiKernel(RaggedDataF{obs}, SharedCoefs{nu, Phi(iter,0)}, Untempered(),
+                  rng, gamma, tilde_tau, Z, chi, sigma_sq, iter, tot_mcmc_iters,
+                  ws, m_1, M_1, Phi);
+}
+
+// Updates the Phi parameters using contiguous observation storage
+//
+// @name UpdatePhi
+// @param obs RaggedObs containing observed values and basis functions
+// @param nu Matrix containing current nu parameters
+// @param gamma Cube containing current gamma parameters
+// @param tilde_tau vector containing current tilde_tau parameters
+// @param Z Matrix containing current Z parameters
+// @param sigma_sq double containing the sigma_sq variable
+// @param chi Matrix containing chi values
+// @param iter int containing current mcmc sample
+// @param m_1 Vector acting as a placeholder for m in mean vector
+// @param M_1 Matrix acting as a placeholder for M in covariance
+// @param Phi Field of Cubes containing all mcmc samples of Phi
+inline void updatePhi(const RaggedObs& obs,
+                      const arma::mat& nu,
+                      const arma::cube& gamma,
+                      const arma::mat& tilde_tau,
+                      const arma::mat& Z,
+                      const arma::mat& chi,
+                      const double& sigma_sq,
+                      const int& iter,
+                      const int& tot_mcmc_iters,
+                      arma::vec& m_1,
+                      arma::mat& M_1,
+                      arma::field<arma::cube>& Phi){
+  updatePhiTempered(1.0, obs, nu, gamma, tilde_tau, Z, chi, sigma_sq, iter,
+                    tot_mcmc_iters, m_1, M_1, Phi);
+}
+
+
+// Updates the Phi parameters by iterated conditional modes, setting each row
+// of Phi to its conditional posterior mode, i.e. its mean since the
+// conditional is Gaussian (used by the ICM initializer). This is
+// updatePhiKernel run with ConditionalMode as the source of randomness.
+//
+// @name updatePhiICM
+// @param obs RaggedObs containing observed values and basis functions
+// @param nu Matrix containing current nu parameters
+// @param gamma Cube containing current gamma parameters
+// @param tilde_tau vector containing current tilde_tau parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing chi values
+// @param sigma_sq double containing the sigma_sq variable
+// @param iter int containing current iteration
+// @param tot_mcmc_iters Int containing total number of iterations
+// @param m_1 Vector acting as a placeholder for m in mean vector
+// @param M_1 Matrix acting as a placeholder for M in covariance
+// @param Phi Field of Cubes containing the estimates of Phi at each iteration
+inline void updatePhiICM(const RaggedObs& obs,
+                         const arma::mat& nu,
+                         const arma::cube& gamma,
+                         const arma::mat& tilde_tau,
+                         const arma::mat& Z,
+                         const arma::mat& chi,
+                         const double& sigma_sq,
+                         const int& iter,
+                         const int& tot_mcmc_iters,
+                         arma::vec& m_1,
+                         arma::mat& M_1,
+                         arma::field<arma::cube>& Phi){
+  Workspace ws = makeWorkspace();
+  ConditionalMode mode;
+  updatePhiKernel(RaggedData{obs}, SharedCoefs{nu, Phi(iter,0)}, Untempered(),
+                  mode, gamma, tilde_tau, Z, chi, sigma_sq, iter,
+                  tot_mcmc_iters, ws, m_1, M_1, Phi);
+}
 
+// Updates the Phi parameters using a Tempered Transition without forming
+// the inverse of the conditional posterior precision of each row of Phi. The
+// data and the prior are perturbed and the resulting sparse system is solved
+// by preconditioned conjugate gradients (see drawGaussianPO).
+//
+// @name updatePhiTemperedPCG
+// @param beta_i Double containing the current temperature
+// @param obs RaggedObs containing observed values and basis functions
+// @param B_sp Sparse matrix containing obs.B_t
+// @param nu Matrix containing current nu parameters
+// @param gamma Cube containing current gamma parameters
+// @param tilde_tau vector containing current tilde_tau parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing chi values
+// @param sigma_sq double containing the sigma_sq variable
+// @param iter int containing current mcmc sample
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param Phi Field of Cubes containing all mcmc samples of Phi
+inline void updatePhiTemperedPCG(const double& beta_i,
+                                 const RaggedObs& obs,
+                                 const arma::sp_mat& B_sp,
+                                 const arma::mat& nu,
+                                 const arma::cube& gamma,
+                                 const arma::mat& tilde_tau,
+                                 const arma::mat& Z,
+                                 const arma::mat& chi,
+                                 const double& sigma_sq,
+                                 const int& iter,
+                                 const int& tot_mcmc_iters,
+                                 arma::field<arma::cube>& Phi){
+  arma::vec coef = arma::zeros(nu.n_cols);
+  arma::vec resid = arma::zeros(obs.y.n_elem);
+  arma::vec prior_prec(nu.n_cols);
+  arma::vec v(nu.n_cols);
+  arma::vec x;
   for(int j =  0; j < Phi(iter,0).n_rows; j ++){
     for(int m = 0; m < Phi(iter,0).n_slices; m++){
-      m_1.zeros();
-      M_1.zeros();
       for(int i = 0; i < Z.n_rows; i++){
-        if(Z(i,j) != 0){
-          for(int l = 0; l < y_obs(i,0).n_elem; l++){
-            ph = 0;
-            ph = y_obs(i,0)(l) - Z(i,j) * arma::dot(nu.row(j),
-                       B_obs(i,0).row(l));
-            M_1 = M_1 + Z(i,j) *  Z(i,j) * (chi(i,m) * chi(i,m) * B_obs(i,0).row(l).t() *
-              B_obs(i,0).row(l));
-            for(int k = 0; k < nu.n_rows; k++){
-              for(int n = 0; n < Phi(iter,0).n_slices; n++){
-                if(k == j){
-                  if(n != m){
-                    ph = ph - (Z(i,j) * chi(i,n) *
-                      arma::dot(Phi(iter,0).slice(n).row(k), B_obs(i,0).row(l)));
-                  }
-                }else{
-                  ph = ph - (Z(i,k) * chi(i,n) *
-                    arma::dot(Phi(iter,0).slice(n).row(k),  B_obs(i,0).row(l)));
-                }
-              }
-              if(k != j){
-                ph = ph - Z(i,k) * arma::dot(nu.row(k), B_obs(i,0).row(l));
-              }
-            }
-            m_1 = m_1 +  Z(i,j) * chi(i,m) * B_obs(i,0).row(l).t() * ph;
-          }
+        if((Z(i,j) != 0) && (obs.n_obs(i) > 0)){
+          // residual after removing every term except Phi_jm
+          calcMeanCoef(nu, Phi(iter,0), Z.row(i), chi.row(i), coef);
+          coef -= (Z(i,j) * chi(i,m)) * Phi(iter,0).slice(m).row(j).t();
+          sparseResid(obs, B_sp, i, coef, resid);
         }
       }
-      m_1 = m_1 * (beta_i / sigma_sq);
-      M_1 = M_1 * (beta_i / sigma_sq);
-
-      //Add on diagonal component
-      for(int k = 0; k < M_1.n_rows; k++){
-        M_1(k,k) = M_1(k,k) + tilde_tau(j,m) * gamma.slice(m)(j,k);
+      // diagonal prior precision and a draw from the prior
+      for(int k = 0; k < prior_prec.n_elem; k++){
+        prior_prec(k) = tilde_tau(j,m) * gamma.slice(m)(j,k);
+        v(k) = std::sqrt(prior_prec(k)) * R::norm_rand();
       }
-      arma::inv(M_1, M_1);
-
-      //generate new sample
-      Phi(iter,0).slice(m).row(j) =  arma::mvnrnd(M_1 * m_1, M_1).t();
+      arma::sp_mat Q_0(prior_prec.n_elem, prior_prec.n_elem);
+      Q_0.diag() = prior_prec;
+      x = Phi(iter,0).slice(m).row(j).t();
+      drawGaussianPO(weightedBasis(obs, B_sp, Z.col(j) % chi.col(m)), resid,
+                     beta_i / sigma_sq, Q_0, v, x);
+      Phi(iter,0).slice(m).row(j) = x.t();
     }
   }
   // Update next iteration
@@ -173,6 +453,25 @@ inline void updatePhiTempered(const double& beta_i,
   }
 }
 
+// Updates the Phi parameters without forming the inverse of the conditional
+// posterior precision of each row of Phi
+//
+// @name updatePhiPCG
+inline void updatePhiPCG(const RaggedObs& obs,
+                         const arma::sp_mat& B_sp,
+                         const arma::mat& nu,
+                         const arma::cube& gamma,
+                         const arma::mat& tilde_tau,
+                         const arma::mat& Z,
+                         const arma::mat& chi,
+                         const double& sigma_sq,
+                         const int& iter,
+                         const int& tot_mcmc_iters,
+                         arma::field<arma::cube>& Phi){
+  updatePhiTemperedPCG(1.0, obs, B_sp, nu, gamma, tilde_tau, Z, chi, sigma_sq,
+                       iter, tot_mcmc_iters, Phi);
+}
+
 // Updates the Phi parameters for the multivariate model
 //
 // @name UpdatePhiMV
@@ -199,53 +498,11 @@ inline void updatePhiMV(const arma::mat& y_obs,
                         arma::vec& m_1,
                         arma::mat& M_1,
                         arma::field<arma::cube>& Phi){
-  m_1.zeros();
-  M_1.zeros();
-
-  for(int j =  0; j < Phi(iter,0).n_rows; j ++){
-    for(int m = 0; m < Phi(iter,0).n_slices; m++){
-      m_1.zeros();
-      M_1.zeros();
-      for(int i = 0; i < Z.n_rows; i++){
-        if(Z(i,j) != 0){
-          arma::vec ph = arma::zeros(y_obs.n_cols);
-          ph = y_obs.row(i).t() - Z(i,j) * nu.row(j).t();
-          M_1 = M_1 + Z(i,j) *  Z(i,j) * (chi(i,m) * chi(i,m) *
-            arma::eye(y_obs.n_cols, y_obs.n_cols));
-          for(int k = 0; k < nu.n_rows; k++){
-            for(int n = 0; n < Phi(iter,0).n_slices; n++){
-              if(k == j){
-                if(n != m){
-                  ph = ph - (Z(i,j) * chi(i,n) * Phi(iter,0).slice(n).row(k).t());
-                }
-              }else{
-                ph = ph - (Z(i,k) * chi(i,n) * Phi(iter,0).slice(n).row(k).t());
-              }
-            }
-            if(k != j){
-              ph = ph - Z(i,k) * nu.row(k).t();
-            }
-          }
-          m_1 = m_1 + Z(i,j) * chi(i,m) * ph;
-        }
-      }
-      m_1 = m_1 * (1 / sigma_sq);
-      M_1 = M_1 * (1 / sigma_sq);
-
-      //Add on diagonal component
-      for(int k = 0; k < M_1.n_rows; k++){
-        M_1(k,k) = M_1(k,k) + tilde_tau(j,m) * gamma.slice(m)(j,k);
-      }
-      arma::inv(M_1, M_1);
-
-      //generate new sample
-      Phi(iter,0).slice(m).row(j) =  arma::mvnrnd(M_1 * m_1, M_1).t();
-    }
-  }
-  // Update next iteration
-  if(iter < (tot_mcmc_iters - 1)){
-    Phi(iter + 1,0) = Phi(iter,0);
-  }
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  updatePhiKernel(MVData{y_obs}, SharedCoefs{nu, Phi(iter,0)}, Untempered(),
+                  rng, gamma, tilde_tau, Z, chi, sigma_sq, iter, tot_mcmc_iters,
+                  ws, m_1, M_1, Phi);
 }
 
 // Updates the Phi parameters for the tempered multivariate model
@@ -276,53 +533,11 @@ inline void updatePhiTemperedMV(const double& beta_i,
                                 arma::vec& m_1,
                                 arma::mat& M_1,
                                 arma::field<arma::cube>& Phi){
-  m_1.zeros();
-  M_1.zeros();
-
-  for(int j =  0; j < Phi(iter,0).n_rows; j ++){
-    for(int m = 0; m < Phi(iter,0).n_slices; m++){
-      m_1.zeros();
-      M_1.zeros();
-      for(int i = 0; i < Z.n_rows; i++){
-        if(Z(i,j) != 0){
-          arma::vec ph = arma::zeros(y_obs.n_cols);
-          ph = y_obs.row(i).t() - Z(i,j) * nu.row(j).t();
-          M_1 = M_1 + Z(i,j) *  Z(i,j) * (chi(i,m) * chi(i,m) *
-            arma::eye(y_obs.n_cols, y_obs.n_cols));
-          for(int k = 0; k < nu.n_rows; k++){
-            for(int n = 0; n < Phi(iter,0).n_slices; n++){
-              if(k == j){
-                if(n != m){
-                  ph = ph - (Z(i,j) * chi(i,n) * Phi(iter,0).slice(n).row(k).t());
-                }
-              }else{
-                ph = ph - (Z(i,k) * chi(i,n) * Phi(iter,0).slice(n).row(k).t());
-              }
-            }
-            if(k != j){
-              ph = ph - Z(i,k) * nu.row(k).t();
-            }
-          }
-          m_1 = m_1 + Z(i,j) * chi(i,m) * ph;
-        }
-      }
-      m_1 = m_1 * (beta_i / sigma_sq);
-      M_1 = M_1 * (beta_i / sigma_sq);
-
-      //Add on diagonal component
-      for(int k = 0; k < M_1.n_rows; k++){
-        M_1(k,k) = M_1(k,k) + tilde_tau(j,m) * gamma.slice(m)(j,k);
-      }
-      arma::inv(M_1, M_1);
-
-      //generate new sample
-      Phi(iter,0).slice(m).row(j) =  arma::mvnrnd(M_1 * m_1, M_1).t();
-    }
-  }
-  // Update next iteration
-  if(iter < (tot_mcmc_iters - 1)){
-    Phi(iter + 1,0) = Phi(iter,0);
-  }
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  updatePhiKernel(MVData{y_obs}, SharedCoefs{nu, Phi(iter,0)}, Tempered{beta_i},
+                  rng, gamma, tilde_tau, Z, chi, sigma_sq, iter, tot_mcmc_iters,
+                  ws, m_1, M_1, Phi);
 }
 
 
@@ -364,64 +579,12 @@ inline void updatePhiCovariateAdj(const arma::field<arma::vec>& y_obs,
                                   arma::vec& m_1,
                                   arma::mat& M_1,
                                   arma::field<arma::cube>& Phi){
-  m_1.zeros();
-  M_1.zeros();
-  double ph = 0;
-
-  for(int j =  0; j < Phi(iter,0).n_rows; j ++){
-    for(int m = 0; m < Phi(iter,0).n_slices; m++){
-      m_1.zeros();
-      M_1.zeros();
-      for(int i = 0; i < Z.n_rows; i++){
-        if(Z(i,j) != 0){
-          for(int l = 0; l < y_obs(i,0).n_elem; l++){
-            ph = 0;
-            ph = y_obs(i,0)(l) - Z(i,j) * (arma::dot(nu.row(j),
-                       B_obs(i,0).row(l)) + arma::dot(eta.slice(j) * X.row(i).t(),
-                       B_obs(i,0).row(l)));
-            M_1 = M_1 + Z(i,j) *  Z(i,j) * (chi(i,m) * chi(i,m) *
-              B_obs(i,0).row(l).t() * B_obs(i,0).row(l));
-            for(int k = 0; k < nu.n_rows; k++){
-              for(int n = 0; n < Phi(iter,0).n_slices; n++){
-                if(k == j){
-                  if(n != m){
-                    ph = ph - (Z(i,j) * chi(i,n) *
-                      arma::dot(Phi(iter,0).slice(n).row(k), B_obs(i,0).row(l)));
-                  }
-                  ph = ph - (Z(i,j) * chi(i,n) *
-                    arma::dot(xi(iter,k).slice(n) * X.row(i).t(),B_obs(i,0).row(l)));
-                }else{
-                  ph = ph - (Z(i,k) * chi(i,n) *
-                    arma::dot((Phi(iter,0).slice(n).row(k) +
-                    (xi(iter,k).slice(n) * X.row(i).t()).t()),  B_obs(i,0).row(l)));
-                }
-              }
-              if(k != j){
-                ph = ph - Z(i,k) * (arma::dot(nu.row(k), B_obs(i,0).row(l)) +
-                  arma::dot(eta.slice(k) * X.row(i).t(), B_obs(i,0).row(l)));
-              }
-            }
-            m_1 = m_1 + Z(i,j) * chi(i,m) * B_obs(i,0).row(l).t() * ph;
-          }
-        }
-      }
-      m_1 = m_1 * (1 / sigma_sq);
-      M_1 = M_1 * (1 / sigma_sq);
-
-      //Add on diagonal component
-      for(int k = 0; k < M_1.n_rows; k++){
-        M_1(k,k) = M_1(k,k) + tilde_tau_phi(j,m) * gamma.slice(m)(j,k);
-      }
-      arma::inv(M_1, M_1);
-
-      //generate new sample
-      Phi(iter,0).slice(m).row(j) =  arma::mvnrnd(M_1 * m_1, M_1).t();
-    }
-  }
-  // Update next iteration
-  if(iter < (tot_mcmc_iters - 1)){
-    Phi(iter + 1,0) = Phi(iter,0);
-  }
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  updatePhiKernel(FieldData{y_obs, B_obs},
+                  CovariateCoefs{nu, eta, Phi(iter,0), xi, iter, X},
+                  Untempered(), rng, gamma, tilde_tau_phi, Z, chi, sigma_sq,
+                  iter, tot_mcmc_iters, ws, m_1, M_1, Phi);
 }
 
 // Updates the Phi parameters using a Tempered Transition for a covariate adjusted model
@@ -460,64 +623,82 @@ inline void updatePhiTemperedCovariateAdj(const double& beta_i,
                                           arma::vec& m_1,
                                           arma::mat& M_1,
                                           arma::field<arma::cube>& Phi){
-  m_1.zeros();
-  M_1.zeros();
-  double ph = 0;
-
-  for(int j =  0; j < Phi(iter,0).n_rows; j ++){
-    for(int m = 0; m < Phi(iter,0).n_slices; m++){
-      m_1.zeros();
-      M_1.zeros();
-      for(int i = 0; i < Z.n_rows; i++){
-        if(Z(i,j) != 0){
-          for(int l = 0; l < y_obs(i,0).n_elem; l++){
-            ph = 0;
-            ph = y_obs(i,0)(l) - Z(i,j) * (arma::dot(nu.row(j),
-                            B_obs(i,0).row(l)) + arma::dot(eta.slice(j) * X.row(i).t(),
-                            B_obs(i,0).row(l)));
-            M_1 = M_1 + Z(i,j) *  Z(i,j) * (chi(i,m) * chi(i,m) *
-              B_obs(i,0).row(l).t() * B_obs(i,0).row(l));
-            for(int k = 0; k < nu.n_rows; k++){
-              for(int n = 0; n < Phi(iter,0).n_slices; n++){
-                if(k == j){
-                  if(n != m){
-                    ph = ph - (Z(i,j) * chi(i,n) *
-                      arma::dot(Phi(iter,0).slice(n).row(k), B_obs(i,0).row(l)));
-                  }
-                  ph = ph - (Z(i,j) * chi(i,n) *
-                    arma::dot(xi(iter,k).slice(n) * X.row(i).t(),B_obs(i,0).row(l)));
-                }else{
-                  ph = ph - (Z(i,k) * chi(i,n) *
-                    arma::dot((Phi(iter,0).slice(n).row(k) +
-                    (xi(iter,k).slice(n) * X.row(i).t()).t()),  B_obs(i,0).row(l)));
-                }
-              }
-              if(k != j){
-                ph = ph - Z(i,k) * (arma::dot(nu.row(k), B_obs(i,0).row(l)) +
-                  arma::dot(eta.slice(k) * X.row(i).t(), B_obs(i,0).row(l)));
-              }
-            }
-            m_1 = m_1 + Z(i,j) * chi(i,m) * B_obs(i,0).row(l).t() * ph;
-          }
-        }
-      }
-      m_1 = m_1 * (beta_i / sigma_sq);
-      M_1 = M_1 * (beta_i / sigma_sq);
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  updatePhiKernel(FieldData{y_obs, B_obs},
+                  CovariateCoefs{nu, eta, Phi(iter,0), xi, iter, X},
+                  Tempered{beta_i}, rng, gamma_phi, tilde_tau_phi, Z, chi,
+                  sigma_sq, iter, tot_mcmc_iters, ws, m_1, M_1, Phi);
+}
 
-      //Add on diagonal component
-      for(int k = 0; k < M_1.n_rows; k++){
-        M_1(k,k) = M_1(k,k) + tilde_tau_phi(j,m) * gamma_phi.slice(m)(j,k);
-      }
-      arma::inv(M_1, M_1);
+// Updates the Phi parameters for a covariate adjusted model using tempered
+// transitions and the cached covariate adjusted coefficients
+//
+// @name UpdatePhiTemperedCovariateAdj
+// @param beta_i Double containing the current temperature
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients (updated after each draw)
+// @param gamma Cube containing current gamma parameters
+// @param tilde_tau_phi vector containing current tilde_tau_phi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing chi values
+// @param sigma_sq double containing the sigma_sq variable
+// @param iter int containing current mcmc sample
+// @param m_1 Vector acting as a placeholder for m in mean vector
+// @param M_1 Matrix acting as a placeholder for M in covariance
+// @param Phi Field of Cubes containing all mcmc samples of Phi
+inline void updatePhiTemperedCovariateAdj(const double& beta_i,
+                                          const RaggedObs& obs,
+                                          CovariateEffects& cov,
+                                          const arma::cube& gamma,
+                                          const arma::mat& tilde_tau_phi,
+                                          const arma::mat& Z,
+                                          const arma::mat& chi,
+                                          const double& sigma_sq,
+                                          const int& iter,
+                                          const int& tot_mcmc_iters,
+                                          arma::vec& m_1,
+                                          arma::mat& M_1,
+                                          arma::field<arma::cube>& Phi){
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  updatePhiKernel(RaggedData{obs}, SyncedCovariateCoefs{cov}, Tempered{beta_i},
+                  rng, gamma, tilde_tau_phi, Z, chi, sigma_sq, iter,
+                  tot_mcmc_iters, ws, m_1, M_1, Phi);
+}
 
-      //generate new sample
-      Phi(iter,0).slice(m).row(j) =  arma::mvnrnd(M_1 * m_1, M_1).t();
-    }
-  }
-  // Update next iteration
-  if(iter < (tot_mcmc_iters - 1)){
-    Phi(iter + 1,0) = Phi(iter,0);
-  }
+// Updates the Phi parameters for a covariate adjusted model using the cached
+// covariate adjusted coefficients
+//
+// @name UpdatePhiCovariateAdj
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients (updated after each draw)
+// @param gamma Cube containing current gamma parameters
+// @param tilde_tau_phi vector containing current tilde_tau_phi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing chi values
+// @param sigma_sq double containing the sigma_sq variable
+// @param iter int containing current mcmc sample
+// @param m_1 Vector acting as a placeholder for m in mean vector
+// @param M_1 Matrix acting as a placeholder for M in covariance
+// @param Phi Field of Cubes containing all mcmc samples of Phi
+inline void updatePhiCovariateAdj(const RaggedObs& obs,
+                                  CovariateEffects& cov,
+                                  const arma::cube& gamma,
+                                  const arma::mat& tilde_tau_phi,
+                                  const arma::mat& Z,
+                                  const arma::mat& chi,
+                                  const double& sigma_sq,
+                                  const int& iter,
+                                  const int& tot_mcmc_iters,
+                                  arma::vec& m_1,
+                                  arma::mat& M_1,
+                                  arma::field<arma::cube>& Phi){
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  updatePhiKernel(RaggedData{obs}, SyncedCovariateCoefs{cov}, Untempered(), rng,
+                  gamma, tilde_tau_phi, Z, chi, sigma_sq, iter, tot_mcmc_iters,
+                  ws, m_1, M_1, Phi);
 }
 
 // Updates the Phi parameters for the covariate adjusted multivariate model
@@ -552,56 +733,12 @@ inline void updatePhiMVCovariateAdj(const arma::mat& y_obs,
                                     arma::vec& m_1,
                                     arma::mat& M_1,
                                     arma::field<arma::cube>& Phi){
-  m_1.zeros();
-  M_1.zeros();
-
-  for(int j =  0; j < Phi(iter,0).n_rows; j ++){
-    for(int m = 0; m < Phi(iter,0).n_slices; m++){
-      m_1.zeros();
-      M_1.zeros();
-      for(int i = 0; i < Z.n_rows; i++){
-        if(Z(i,j) != 0){
-          arma::vec ph = arma::zeros(y_obs.n_cols);
-          ph = y_obs.row(i).t() - Z(i,j) * (nu.row(j).t() +
-            (eta.slice(j) * X.row(i).t()));
-          M_1 = M_1 + Z(i,j) *  Z(i,j) * (chi(i,m) * chi(i,m) *
-            arma::eye(y_obs.n_cols, y_obs.n_cols));
-          for(int k = 0; k < nu.n_rows; k++){
-            for(int n = 0; n < Phi(iter,0).n_slices; n++){
-              if(k == j){
-                if(n != m){
-                  ph = ph - (Z(i,j) * chi(i,n) * Phi(iter,0).slice(n).row(k).t());
-                }
-                ph = ph - (Z(i,j) * chi(i,n) * (xi(iter,k).slice(n) * X.row(i).t()));
-              }else{
-                ph = ph - (Z(i,k) * chi(i,n) * (Phi(iter,0).slice(n).row(k).t() +
-                  (xi(iter,k).slice(n) * X.row(i).t())));
-              }
-            }
-            if(k != j){
-              ph = ph - Z(i,k) * (nu.row(k).t() +  (eta.slice(k) * X.row(i).t()));
-            }
-          }
-          m_1 = m_1 + Z(i,j) * chi(i,m) * ph;
-        }
-      }
-      m_1 = m_1 * (1 / sigma_sq);
-      M_1 = M_1 * (1 / sigma_sq);
-
-      //Add on diagonal component
-      for(int k = 0; k < M_1.n_rows; k++){
-        M_1(k,k) = M_1(k,k) + tilde_tau_phi(j,m) * gamma_phi.slice(m)(j,k);
-      }
-      arma::inv(M_1, M_1);
-
-      //generate new sample
-      Phi(iter,0).slice(m).row(j) =  arma::mvnrnd(M_1 * m_1, M_1).t();
-    }
-  }
-  // Update next iteration
-  if(iter < (tot_mcmc_iters - 1)){
-    Phi(iter + 1,0) = Phi(iter,0);
-  }
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  updatePhiKernel(MVData{y_obs},
+                  CovariateCoefs{nu, eta, Phi(iter,0), xi, iter, X},
+                  Untempered(), rng, gamma_phi, tilde_tau_phi, Z, chi, sigma_sq,
+                  iter, tot_mcmc_iters, ws, m_1, M_1, Phi);
 }
 
 // Updates the Phi parameters for the tempered multivariate covariate adjusted model
@@ -638,56 +775,12 @@ inline void updatePhiTemperedMVCovariateAdj(const double& beta_i,
                                             arma::vec& m_1,
                                             arma::mat& M_1,
                                             arma::field<arma::cube>& Phi){
-  m_1.zeros();
-  M_1.zeros();
-
-  for(int j =  0; j < Phi(iter,0).n_rows; j ++){
-    for(int m = 0; m < Phi(iter,0).n_slices; m++){
-      m_1.zeros();
-      M_1.zeros();
-      for(int i = 0; i < Z.n_rows; i++){
-        if(Z(i,j) != 0){
-          arma::vec ph = arma::zeros(y_obs.n_cols);
-          ph = y_obs.row(i).t() - Z(i,j) * (nu.row(j).t() +
-            (eta.slice(j) * X.row(i).t()));
-          M_1 = M_1 + Z(i,j) *  Z(i,j) * (chi(i,m) * chi(i,m) *
-            arma::eye(y_obs.n_cols, y_obs.n_cols));
-          for(int k = 0; k < nu.n_rows; k++){
-            for(int n = 0; n < Phi(iter,0).n_slices; n++){
-              if(k == j){
-                if(n != m){
-                  ph = ph - (Z(i,j) * chi(i,n) * Phi(iter,0).slice(n).row(k).t());
-                }
-                ph = ph - (Z(i,j) * chi(i,n) * (xi(iter,k).slice(n) * X.row(i).t()));
-              }else{
-                ph = ph - (Z(i,k) * chi(i,n) * (Phi(iter,0).slice(n).row(k).t() +
-                  (xi(iter,k).slice(n) * X.row(i).t())));
-              }
-            }
-            if(k != j){
-              ph = ph - Z(i,k) * (nu.row(k).t() +  (eta.slice(k) * X.row(i).t()));
-            }
-          }
-          m_1 = m_1 + Z(i,j) * chi(i,m) * ph;
-        }
-      }
-      m_1 = m_1 * (beta_i / sigma_sq);
-      M_1 = M_1 * (beta_i / sigma_sq);
-
-      //Add on diagonal component
-      for(int k = 0; k < M_1.n_rows; k++){
-        M_1(k,k) = M_1(k,k) + tilde_tau_phi(j,m) * gamma_phi.slice(m)(j,k);
-      }
-      arma::inv(M_1, M_1);
-
-      //generate new sample
-      Phi(iter,0).slice(m).row(j) =  arma::mvnrnd(M_1 * m_1, M_1).t();
-    }
-  }
-  // Update next iteration
-  if(iter < (tot_mcmc_iters - 1)){
-    Phi(iter + 1,0) = Phi(iter,0);
-  }
+  Workspace ws = makeWorkspace();
+  RRng rng;
+  updatePhiKernel(MVData{y_obs},
+                  CovariateCoefs{nu, eta, Phi(iter,0), xi, iter, X},
+                  Tempered{beta_i}, rng, gamma_phi, tilde_tau_phi, Z, chi,
+                  sigma_sq, iter, tot_mcmc_iters, ws, m_1, M_1, Phi);
 }
 
 }
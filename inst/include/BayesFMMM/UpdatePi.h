@@ -3,6 +3,7 @@
 
 #include <RcppArmadillo.h>
 #include <cmath>
+#include "ConditionalModes.h"
 #include "Distributions.h"
 
 namespace BayesFMMM{
@@ -52,6 +53,32 @@ inline double lpdf_pi_PM(const arma::vec& c,
   return lpdf;
 }
 
+// Calculates the log pdf of the posterior distribution of pi from the sums
+// of the log memberships of each feature (sum_i log(Z_ik)), so that the cost
+// does not depend on the number of functions
+//
+// @name lpdf_pi_PM
+// @param c vector containing hyperparameters
+// @param alpha_3 Double containing current value of alpha_3
+// @param pi Vector containing pi parameters
+// @param log_Z_sum Vector containing the sum of log(Z_ik) over the functions for each feature
+// @param n_funct Int containing the number of functions
+// @return lpdf Double containing the log pdf
+inline double lpdf_pi_PM(const arma::vec& c,
+                         const double& alpha_3,
+                         const arma::vec& pi,
+                         const arma::vec& log_Z_sum,
+                         const int n_funct){
+  double lpdf = 0;
+  for(int k = 0; k < pi.n_elem; k++){
+    lpdf = lpdf + ((c(k) - 1) * std::log(pi(k)));
+    lpdf = lpdf + (((alpha_3 * pi(k)) - 1) * log_Z_sum(k));
+  }
+  lpdf = lpdf -  (n_funct * calc_lB(alpha_3 * pi));
+
+  return lpdf;
+}
+
 // Calculates the probability that we propose a state given we are in another state
 //
 // @name pi_proposal_density
@@ -70,7 +97,8 @@ inline double pi_proposal_density(const arma::vec& pi,
   return density;
 }
 
-// Updates pi for the mixed membership model
+// Updates pi for the mixed membership model, recording the acceptance
+// probability of the proposal
 //
 // @name UpdatePi_PM
 // @param alpha_3 Double containing the current value of alpha_3
@@ -80,7 +108,10 @@ inline double pi_proposal_density(const arma::vec& pi,
 // @param tot_mcmc_iters Int  containing total number of MCMC iterations
 // @param a_pi_PM Double containing hyperparameter for sampling from pi
 // @param pi_ph Vector containing placeholder for proposed update
+// @param rng Source of randomness (RRng or a random number engine owned by the calling thread)
+// @param accept_prob Double acting as a placeholder for the acceptance probability
 // @param pi Matrix containing all values for pi values
+template <typename Rng>
 inline void updatePi_PM(const double& alpha_3,
                         const arma::mat& Z,
                         const arma::vec& c,
@@ -88,9 +119,10 @@ inline void updatePi_PM(const double& alpha_3,
                         const int& tot_mcmc_iters,
                         const double& a_pi_PM,
                         arma::vec& pi_ph,
+                        Rng& rng,
+                        double& accept_prob,
                         arma::mat& pi){
-
-  pi_ph = rdirichlet(a_pi_PM * pi.col(iter));
+  pi_ph = rdirichlet(a_pi_PM * pi.col(iter), rng);
 
   // calculate proposal log pdf
   double lpdf_new = lpdf_pi_PM(c, alpha_3, pi_ph, Z);
@@ -102,13 +134,137 @@ inline void updatePi_PM(const double& alpha_3,
   double lpdf_propose_old = pi_proposal_density(pi.col(iter), a_pi_PM * pi_ph);
 
   double acceptance_prob = lpdf_new - lpdf_old + lpdf_propose_old - lpdf_propose_new;
-  double rand_unif_var = R::runif(0,1);
+  accept_prob = calcAcceptanceProb(acceptance_prob);
+
+  if(std::log(drawUnif(rng)) < acceptance_prob){
+    // Accept new state and update parameters
+    pi.col(iter) = pi_ph;
+  }
+
+  if((tot_mcmc_iters - 1) > iter){
+    pi.col(iter+1) = pi.col(iter);
+  }
+}
+
+// Updates pi for the mixed membership model using R's random number
+// generator, recording the acceptance probability of the proposal
+//
+// @name UpdatePi_PM
+inline void updatePi_PM(const double& alpha_3,
+                        const arma::mat& Z,
+                        const arma::vec& c,
+                        const int& iter,
+                        const int& tot_mcmc_iters,
+                        const double& a_pi_PM,
+                        arma::vec& pi_ph,
+                        double& accept_prob,
+                        arma::mat& pi){
+  RRng rng;
+  updatePi_PM(alpha_3, Z, c, iter, tot_mcmc_iters, a_pi_PM, pi_ph, rng,
+              accept_prob, pi);
+}
+
+// Updates pi for the mixed membership model
+//
+// @name UpdatePi_PM
+inline void updatePi_PM(const double& alpha_3,
+                        const arma::mat& Z,
+                        const arma::vec& c,
+                        const int& iter,
+                        const int& tot_mcmc_iters,
+                        const double& a_pi_PM,
+                        arma::vec& pi_ph,
+                        arma::mat& pi){
+  double accept_prob = 0;
+  updatePi_PM(alpha_3, Z, c, iter, tot_mcmc_iters, a_pi_PM, pi_ph, accept_prob,
+              pi);
+}
+
+// Updates pi for the mixed membership model from the sums of the log
+// memberships of each feature, recording the acceptance probability of the
+// proposal
+//
+// @name UpdatePi_PM
+// @param alpha_3 Double containing the current value of alpha_3
+// @param log_Z_sum Vector containing the sum of log(Z_ik) over the functions for each feature
+// @param n_funct Int containing the number of functions
+// @param c Vector containing hyperparameters
+// @param iter Int containing current MCMC iteration
+// @param tot_mcmc_iters Int  containing total number of MCMC iterations
+// @param a_pi_PM Double containing hyperparameter for sampling from pi
+// @param pi_ph Vector containing placeholder for proposed update
+// @param accept_prob Double acting as a placeholder for the acceptance probability
+// @param pi Matrix containing all values for pi values
+inline void updatePi_PM(const double& alpha_3,
+                        const arma::vec& log_Z_sum,
+                        const int n_funct,
+                        const arma::vec& c,
+                        const int& iter,
+                        const int& tot_mcmc_iters,
+                        const double& a_pi_PM,
+                        arma::vec& pi_ph,
+                        double& accept_prob,
+                        arma::mat& pi){
+  pi_ph = rdirichlet(a_pi_PM * pi.col(iter));
+
+  double lpdf_new = lpdf_pi_PM(c, alpha_3, pi_ph, log_Z_sum, n_funct);
+  double lpdf_old = lpdf_pi_PM(c, alpha_3, pi.col(iter), log_Z_sum, n_funct);
+
+  double lpdf_propose_new = pi_proposal_density(pi_ph, a_pi_PM * pi.col(iter));
+  double lpdf_propose_old = pi_proposal_density(pi.col(iter), a_pi_PM * pi_ph);
+
+  double acceptance_prob = lpdf_new - lpdf_old + lpdf_propose_old - lpdf_propose_new;
+  accept_prob = calcAcceptanceProb(acceptance_prob);
 
-  if(std::log(rand_unif_var) < acceptance_prob){
+  if(std::log(R::runif(0,1)) < acceptance_prob){
     // Accept new state and update parameters
     pi.col(iter) = pi_ph;
   }
 
+  if((tot_mcmc_iters - 1) > iter){
+    pi.col(iter+1) = pi.col(iter);
+  }
+}
+
+// Updates pi for the mixed membership model by iterated conditional modes,
+// setting pi to the point of the simplex that maximizes its conditional
+// posterior (projected gradient ascent). The elements of pi are kept greater
+// than or equal to 1e-4 since the density is unbounded at the boundary of the
+// simplex when c_k < 1.
+//
+// @name updatePiICM
+// @param alpha_3 Double containing the current value of alpha_3
+// @param Z Matrix containing current value of Z parameters
+// @param c Vector containing hyperparameters
+// @param iter Int containing current iteration
+// @param tot_mcmc_iters Int containing total number of iterations
+// @param n_steps Int containing the maximum number of projected gradient steps
+// @param pi Matrix containing all values for pi values
+inline void updatePiICM(const double& alpha_3,
+                        const arma::mat& Z,
+                        const arma::vec& c,
+                        const int& iter,
+                        const int& tot_mcmc_iters,
+                        const int& n_steps,
+                        arma::mat& pi){
+  arma::vec log_Z_sum = arma::sum(arma::log(Z), 0).t();
+  int n_funct = Z.n_rows;
+  auto f = [&](const arma::vec& x){
+    return lpdf_pi_PM(c, alpha_3, x, log_Z_sum, n_funct);
+  };
+  auto grad = [&](const arma::vec& x){
+    arma::vec grad_x(x.n_elem);
+    for(int k = 0; k < x.n_elem; k++){
+      grad_x(k) = ((c(k) - 1) / x(k)) + (alpha_3 * log_Z_sum(k)) -
+        (n_funct * alpha_3 * (R::digamma(alpha_3 * x(k)) -
+        R::digamma(alpha_3)));
+    }
+    return grad_x;
+  };
+  arma::vec x = pi.col(iter);
+  maximizeSimplex(f, grad, 1e-4, n_steps,
+                  1 / ((n_funct * alpha_3 * alpha_3) + 1), x);
+  pi.col(iter) = x;
 
   if((tot_mcmc_iters - 1) > iter){
     pi.col(iter+1) = pi.col(iter);
@@ -3,8 +3,74 @@
 
 #include <RcppArmadillo.h>
 #include <cmath>
+#include "CovariateEffects.h"
+#include "KernelPolicies.h"
+#include "RaggedObs.h"
+#include "SubjectScheduler.h"
 
 namespace BayesFMMM{
+// Updates the Sigma parameters of any variant of the model (see
+// KernelPolicies.h). The residual sum of squares of each function is
+// computed in parallel on the subject scheduler and summed in the order of
+// the functions, so the result does not depend on the number of threads.
+//
+// @name updateSigmaKernel
+// @param data Data model containing the observations
+// @param coefs Coefficient policy containing the mean and eigenfunction coefficients
+// @param temper Tempering policy
+// @param alpha_0 Double containing hyperparameter
+// @param beta_0 Double containing hyperparameter
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param iter Int containing current MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param sched SubjectScheduler used to distribute the functions over threads
+// @param sigma Vector containing sigma for all mcmc iterations
+template<class Data, class Coefs, class Temper>
+inline void updateSigmaKernel(const Data& data,
+                              const Coefs& coefs,
+                              const Temper& temper,
+                              const double alpha_0,
+                              const double beta_0,
+                              const arma::mat& Z,
+                              const arma::mat& chi,
+                              const int& iter,
+                              const int& tot_mcmc_iters,
+                              SubjectScheduler& sched,
+                              arma::vec& sigma){
+  arma::vec rss = calcRSSKernel(data, coefs, Z, chi, "sigma", sched);
+  double b_1 = 0;
+  for(int i = 0; i < Z.n_rows; i++){
+    b_1 = b_1 + 0.5 * temper.scale(rss(i));
+  }
+  b_1 = b_1 + beta_0;
+  double a = (0.5 * temper.scale(data.n_total())) + alpha_0;
+  sigma(iter) = 1 / R::rgamma(a, 1/b_1);
+
+  if(iter < (tot_mcmc_iters - 1)){
+    sigma(iter + 1) = sigma(iter);
+  }
+}
+
+// Updates the Sigma parameters of any variant of the model
+//
+// @name updateSigmaKernel
+template<class Data, class Coefs, class Temper>
+inline void updateSigmaKernel(const Data& data,
+                              const Coefs& coefs,
+                              const Temper& temper,
+                              const double alpha_0,
+                              const double beta_0,
+                              const arma::mat& Z,
+                              const arma::mat& chi,
+                              const int& iter,
+                              const int& tot_mcmc_iters,
+                              arma::vec& sigma){
+  SubjectScheduler sched = makeSubjectScheduler(data.weights());
+  updateSigmaKernel(data, coefs, temper, alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sched, sigma);
+}
+
 // Updates the Sigma parameters
 //
 // @name updateSigma
@@ -30,31 +96,10 @@ inline void updateSigma(const arma::field<arma::vec>& y_obs,
                         const int& iter,
                         const int& tot_mcmc_iters,
                         arma::vec& sigma){
-  double a = 0;
-  double b = 0;
-  double b_1 = 0;
-  for(int i = 0; i < Z.n_rows; i++){
-    for(int l = 0; l < y_obs(i,0).n_elem; l++){
-      b = y_obs(i,0)(l);
-      for(int k = 0; k < Z.n_cols; k++){
-        if(Z(i,k) != 0){
-          b = b - Z(i,k) * arma::dot(nu.row(k), B_obs(i,0).row(l));
-          for(int n = 0; n < Phi.n_slices; n++){
-            b = b - Z(i,k) * chi(i,n) * arma::dot(Phi.slice(n).row(k), B_obs(i,0).row(l));
-          }
-        }
-      }
-      b_1 = b_1 + 0.5 * (b * b);
-    }
-    a = a + (y_obs(i,0).n_elem / 2);
-  }
-  b_1 = b_1 + beta_0;
-  a = a + alpha_0;
-  sigma(iter) = 1 / R::rgamma(a, 1/b_1);
-
-  if(iter < (tot_mcmc_iters - 1)){
-    sigma(iter + 1) = sigma(iter);
-  }
+  FieldData data = {y_obs, B_obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateSigmaKernel(data, coefs, Untempered(), alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sigma);
 }
 
 // Updates the Sigma parameters using Tempered Transitions
@@ -84,27 +129,199 @@ inline void updateSigmaTempered(const double& beta_i,
                                 const int& iter,
                                 const int& tot_mcmc_iters,
                                 arma::vec& sigma){
-  double a = 0;
-  double b = 0;
+  FieldData data = {y_obs, B_obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateSigmaKernel(data, coefs, temper, alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sigma);
+}
+
+// Updates the Sigma parameters using Tempered Transitions, contiguous
+// observation storage and the subject scheduler
+//
+// @name updateSigmaTempered
+// @param beta_i Double containing current temperature
+// @param obs RaggedObs containing observed values and basis functions
+// @param alpha_0 Double containing hyperparameter
+// @param beta_0 Double containing hyperparameter
+// @param nu Matrix containing current nu parameters
+// @param Phi Cube containing current Phi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param iter Int containing current MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param sched SubjectScheduler used to distribute the functions over threads
+// @param sigma Vector containing sigma for all mcmc iterations
+inline void updateSigmaTempered(const double& beta_i,
+                                const RaggedObs& obs,
+                                const double alpha_0,
+                                const double beta_0,
+                                const arma::mat& nu,
+                                const arma::cube& Phi,
+                                const arma::mat& Z,
+                                const arma::mat& chi,
+                                const int& iter,
+                                const int& tot_mcmc_iters,
+                                SubjectScheduler& sched,
+                                arma::vec& sigma){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateSigmaKernel(data, coefs, temper, alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sched, sigma);
+}
+
+// Updates the Sigma parameters using Tempered Transitions, single precision
+// observation storage and the subject scheduler
+//
+// @name updateSigmaTempered
+inline void updateSigmaTempered(const double& beta_i,
+                                const RaggedObsF& obs,
+                                const double alpha_0,
+                                const double beta_0,
+                                const arma::mat& nu,
+                                const arma::cube& Phi,
+                                const arma::mat& Z,
+                                const arma::mat& chi,
+                                const int& iter,
+                                const int& tot_mcmc_iters,
+                                SubjectScheduler& sched,
+                                arma::vec& sigma){
+  RaggedDataF data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateSigmaKernel(data, coefs, temper, alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sched, sigma);
+}
+
+// Updates the Sigma parameters using Tempered Transitions and contiguous
+// observation storage
+//
+// @name updateSigmaTempered
+inline void updateSigmaTempered(const double& beta_i,
+                                const RaggedObs& obs,
+                                const double alpha_0,
+                                const double beta_0,
+                                const arma::mat& nu,
+                                const arma::cube& Phi,
+                                const arma::mat& Z,
+                                const arma::mat& chi,
+                                const int& iter,
+                                const int& tot_mcmc_iters,
+                                arma::vec& sigma){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateSigmaKernel(data, coefs, temper, alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sigma);
+}
+
+// Updates the Sigma parameters using contiguous observation storage
+//
+// @name updateSigma
+// @param obs RaggedObs containing observed values and basis functions
+// @param alpha_0 Double containing hyperparameter
+// @param beta_0 Double containing hyperparameter
+// @param nu Matrix containing current nu parameters
+// @param Phi Cube containing current Phi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param iter Int containing current MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param sigma Vector containing sigma for all mcmc iterations
+inline void updateSigma(const RaggedObs& obs,
+                        const double alpha_0,
+                        const double beta_0,
+                        const arma::mat& nu,
+                        const arma::cube& Phi,
+                        const arma::mat& Z,
+                        const arma::mat& chi,
+                        const int& iter,
+                        const int& tot_mcmc_iters,
+                        arma::vec& sigma){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateSigmaKernel(data, coefs, Untempered(), alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sigma);
+}
+
+// Updates the Sigma parameters using contiguous observation storage and the
+// subject scheduler
+//
+// @name updateSigma
+inline void updateSigma(const RaggedObs& obs,
+                        const double alpha_0,
+                        const double beta_0,
+                        const arma::mat& nu,
+                        const arma::cube& Phi,
+                        const arma::mat& Z,
+                        const arma::mat& chi,
+                        const int& iter,
+                        const int& tot_mcmc_iters,
+                        SubjectScheduler& sched,
+                        arma::vec& sigma){
+  RaggedData data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateSigmaKernel(data, coefs, Untempered(), alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sched, sigma);
+}
+
+// Updates the Sigma parameters using single precision observation storage and
+// the subject scheduler
+//
+// @name updateSigma
+inline void updateSigma(const RaggedObsF& obs,
+                        const double alpha_0,
+                        const double beta_0,
+                        const arma::mat& nu,
+                        const arma::cube& Phi,
+                        const arma::mat& Z,
+                        const arma::mat& chi,
+                        const int& iter,
+                        const int& tot_mcmc_iters,
+                        SubjectScheduler& sched,
+                        arma::vec& sigma){
+  RaggedDataF data = {obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateSigmaKernel(data, coefs, Untempered(), alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sched, sigma);
+}
+
+
+// Updates the Sigma parameter by iterated conditional modes, setting sigma to
+// the mode of its inverse gamma conditional posterior (used by the ICM
+// initializer)
+//
+// @name updateSigmaICM
+// @param obs RaggedObs containing observed values and basis functions
+// @param alpha_0 Double containing hyperparameter
+// @param beta_0 Double containing hyperparameter
+// @param nu Matrix containing current nu parameters
+// @param Phi Cube containing current Phi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param iter Int containing current iteration
+// @param tot_mcmc_iters Int containing total number of iterations
+// @param sigma Vector containing the estimates of sigma at each iteration
+inline void updateSigmaICM(const RaggedObs& obs,
+                           const double alpha_0,
+                           const double beta_0,
+                           const arma::mat& nu,
+                           const arma::cube& Phi,
+                           const arma::mat& Z,
+                           const arma::mat& chi,
+                           const int& iter,
+                           const int& tot_mcmc_iters,
+                           arma::vec& sigma){
   double b_1 = 0;
+  arma::vec coef = arma::zeros(nu.n_cols);
   for(int i = 0; i < Z.n_rows; i++){
-    for(int l = 0; l < y_obs(i,0).n_elem; l++){
-      b = y_obs(i,0)(l);
-      for(int k = 0; k < Z.n_cols; k++){
-        if(Z(i,k) != 0){
-          b = b - Z(i,k) * arma::dot(nu.row(k), B_obs(i,0).row(l));
-          for(int n = 0; n < Phi.n_slices; n++){
-            b = b - Z(i,k) * chi(i,n) * arma::dot(Phi.slice(n).row(k), B_obs(i,0).row(l));
-          }
-        }
-      }
-      b_1 = b_1 + (beta_i / 2) * (b * b);
-    }
-    a = a + ((beta_i * y_obs(i,0).n_elem) / 2);
+    calcMeanCoef(nu, Phi, Z.row(i), chi.row(i), coef);
+    b_1 = b_1 + 0.5 * calcRSS(obs, i, coef);
   }
   b_1 = b_1 + beta_0;
-  a = a + alpha_0;
-  sigma(iter) = 1 / R::rgamma(a, 1/b_1);
+  double a = (obs.n_total() / 2.0) + alpha_0;
+  sigma(iter) = b_1 / (a + 1);
 
   if(iter < (tot_mcmc_iters - 1)){
     sigma(iter + 1) = sigma(iter);
@@ -134,25 +351,10 @@ inline void updateSigmaMV(const arma::mat& y_obs,
                           const int& iter,
                           const int& tot_mcmc_iters,
                           arma::vec& sigma){
-  double b_1 = 0;
-  arma::vec mean = arma::zeros(nu.n_cols);
-  for(int i = 0; i < Z.n_rows; i++){
-    mean = arma::zeros(nu.n_cols);
-    for(int k = 0; k < Z.n_cols; k++){
-      mean = mean + Z(i,k) * nu.row(k).t();
-      for(int m = 0; m < Phi.n_slices; m++){
-        mean = mean + Z(i,k) * chi(i,m) * Phi.slice(m).row(k).t();
-      }
-    }
-    b_1 = b_1 + 0.5 * arma::dot(y_obs.row(i).t() - mean, y_obs.row(i).t() - mean);
-  }
-  b_1 = b_1 + beta_0;
-  double a = (y_obs.n_elem / 2) + alpha_0;
-  sigma(iter) = 1 / R::rgamma(a, 1/b_1);
-
-  if(iter < (tot_mcmc_iters - 1)){
-    sigma(iter + 1) = sigma(iter);
-  }
+  MVData data = {y_obs};
+  SharedCoefs coefs = {nu, Phi};
+  updateSigmaKernel(data, coefs, Untempered(), alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sigma);
 }
 
 // Updates the Sigma parameters using Tempered Transitions
@@ -180,26 +382,11 @@ inline void updateSigmaTemperedMV(const double& beta_i,
                                   const int& iter,
                                   const int& tot_mcmc_iters,
                                   arma::vec& sigma){
-  double b_1 = 0;
-  arma::vec mean = arma::zeros(nu.n_cols);
-  for(int i = 0; i < Z.n_rows; i++){
-    mean = arma::zeros(nu.n_cols);
-    for(int k = 0; k < Z.n_cols; k++){
-      mean = mean + Z(i,k) * nu.row(k).t();
-      for(int m = 0; m < Phi.n_slices; m++){
-        mean = mean + Z(i,k) * chi(i,m) * Phi.slice(m).row(k).t();
-      }
-    }
-    b_1 = b_1 + (beta_i / 2) *
-      arma::dot(y_obs.row(i).t() - mean, y_obs.row(i).t() - mean);
-  }
-  b_1 = b_1 + beta_0;
-  double a = ((beta_i * y_obs.n_elem) / 2) + alpha_0;
-  sigma(iter) = 1 / R::rgamma(a, 1/b_1);
-
-  if(iter < (tot_mcmc_iters - 1)){
-    sigma(iter + 1) = sigma(iter);
-  }
+  MVData data = {y_obs};
+  SharedCoefs coefs = {nu, Phi};
+  Tempered temper = {beta_i};
+  updateSigmaKernel(data, coefs, temper, alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sigma);
 }
 
 // Updates the Sigma parameters for the Covariate Adjusted model
@@ -233,34 +420,10 @@ inline void updateSigmaCovariateAdj(const arma::field<arma::vec>& y_obs,
                                     const int& tot_mcmc_iters,
                                     const arma::mat& X,
                                     arma::vec& sigma){
-  double a = 0;
-  double b = 0;
-  double b_1 = 0;
-  for(int i = 0; i < Z.n_rows; i++){
-    for(int l = 0; l < y_obs(i,0).n_elem; l++){
-      b = y_obs(i,0)(l);
-      for(int k = 0; k < Z.n_cols; k++){
-        if(Z(i,k) != 0){
-          b = b - Z(i,k) * (arma::dot(nu.row(k) , B_obs(i,0).row(l)) +
-            arma::dot(eta.slice(k) * X.row(i).t(), B_obs(i,0).row(l)));
-          for(int n = 0; n < Phi.n_slices; n++){
-            b = b - Z(i,k) * chi(i,n) * (arma::dot(Phi.slice(n).row(k),
-                                 B_obs(i,0).row(l).t()) +  arma::dot(xi(iter,k).slice(n) * X.row(i).t(),
-                                 B_obs(i,0).row(l)));
-          }
-        }
-      }
-      b_1 = b_1 + 0.5 * (b * b);
-    }
-    a = a + (y_obs(i,0).n_elem / 2);
-  }
-  b_1 = b_1 + beta_0;
-  a = a + alpha_0;
-  sigma(iter) = 1 / R::rgamma(a, 1/b_1);
-
-  if(iter < (tot_mcmc_iters - 1)){
-    sigma(iter + 1) = sigma(iter);
-  }
+  FieldData data = {y_obs, B_obs};
+  CovariateCoefs coefs = {nu, eta, Phi, xi, iter, X};
+  updateSigmaKernel(data, coefs, Untempered(), alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sigma);
 }
 
 
@@ -297,34 +460,70 @@ inline void updateSigmaTemperedCovariateAdj(const double& beta_i,
                                             const int& tot_mcmc_iters,
                                             const arma::mat& X,
                                             arma::vec& sigma){
-  double a = 0;
-  double b = 0;
-  double b_1 = 0;
-  for(int i = 0; i < Z.n_rows; i++){
-    for(int l = 0; l < y_obs(i,0).n_elem; l++){
-      b = y_obs(i,0)(l);
-      for(int k = 0; k < Z.n_cols; k++){
-        if(Z(i,k) != 0){
-          b = b - Z(i,k) * (arma::dot(nu.row(k) , B_obs(i,0).row(l)) +
-            arma::dot(eta.slice(k) * X.row(i).t(), B_obs(i,0).row(l)));
-          for(int n = 0; n < Phi.n_slices; n++){
-            b = b - Z(i,k) * chi(i,n) * (arma::dot(Phi.slice(n).row(k),
-                                 B_obs(i,0).row(l).t()) +  arma::dot(xi(iter,k).slice(n) * X.row(i).t(),
-                                 B_obs(i,0).row(l)));
-          }
-        }
-      }
-      b_1 = b_1 + 0.5 * beta_i * (b * b);
-    }
-    a = a + ((beta_i * y_obs(i,0).n_elem) / 2);
-  }
-  b_1 = b_1 + beta_0;
-  a = a + alpha_0;
-  sigma(iter) = 1 / R::rgamma(a, 1/b_1);
+  FieldData data = {y_obs, B_obs};
+  CovariateCoefs coefs = {nu, eta, Phi, xi, iter, X};
+  Tempered temper = {beta_i};
+  updateSigmaKernel(data, coefs, temper, alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sigma);
+}
 
-  if(iter < (tot_mcmc_iters - 1)){
-    sigma(iter + 1) = sigma(iter);
-  }
+// Updates the Sigma parameters for the covariate adjusted model using
+// Tempered Transitions and the cached covariate adjusted coefficients
+//
+// @name updateSigmaTemperedCovariateAdj
+// @param beta_i Double containing current temperature
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients
+// @param alpha_0 Double containing hyperparameter
+// @param beta_0 Double containing hyperparameter
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param iter Int containing current MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param sigma Vector containing sigma for all mcmc iterations
+inline void updateSigmaTemperedCovariateAdj(const double& beta_i,
+                                            const RaggedObs& obs,
+                                            const CovariateEffects& cov,
+                                            const double alpha_0,
+                                            const double beta_0,
+                                            const arma::mat& Z,
+                                            const arma::mat& chi,
+                                            const int& iter,
+                                            const int& tot_mcmc_iters,
+                                            arma::vec& sigma){
+  RaggedData data = {obs};
+  CachedCovariateCoefs coefs = {cov};
+  Tempered temper = {beta_i};
+  updateSigmaKernel(data, coefs, temper, alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sigma);
+}
+
+// Updates the Sigma parameters for the covariate adjusted model using the
+// cached covariate adjusted coefficients
+//
+// @name updateSigmaCovariateAdj
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients
+// @param alpha_0 Double containing hyperparameter
+// @param beta_0 Double containing hyperparameter
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing current chi parameters
+// @param iter Int containing current MCMC iteration
+// @param tot_mcmc_iters Int containing total number of MCMC iterations
+// @param sigma Vector containing sigma for all mcmc iterations
+inline void updateSigmaCovariateAdj(const RaggedObs& obs,
+                                    const CovariateEffects& cov,
+                                    const double alpha_0,
+                                    const double beta_0,
+                                    const arma::mat& Z,
+                                    const arma::mat& chi,
+                                    const int& iter,
+                                    const int& tot_mcmc_iters,
+                                    arma::vec& sigma){
+  RaggedData data = {obs};
+  CachedCovariateCoefs coefs = {cov};
+  updateSigmaKernel(data, coefs, Untempered(), alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sigma);
 }
 
 // Updates the Sigma parameters for the covariate adjusted multivariate model
@@ -356,26 +555,10 @@ inline void updateSigmaMVCovariateAdj(const arma::mat& y_obs,
                                       const int& tot_mcmc_iters,
                                       const arma::mat& X,
                                       arma::vec& sigma){
-  double b_1 = 0;
-  arma::vec mean = arma::zeros(nu.n_cols);
-  for(int i = 0; i < Z.n_rows; i++){
-    mean = arma::zeros(nu.n_cols);
-    for(int k = 0; k < Z.n_cols; k++){
-      mean = mean + Z(i,k) * (nu.row(k).t() + eta.slice(k) * X.row(i).t());
-      for(int m = 0; m < Phi.n_slices; m++){
-        mean = mean + Z(i,k) * chi(i,m) * (Phi.slice(m).row(k).t() +
-          xi(iter,k).slice(m) * X.row(i).t());
-      }
-    }
-    b_1 = b_1 + 0.5 * arma::dot(y_obs.row(i).t() - mean, y_obs.row(i).t() - mean);
-  }
-  b_1 = b_1 + beta_0;
-  double a = (y_obs.n_elem / 2) + alpha_0;
-  sigma(iter) = 1 / R::rgamma(a, 1/b_1);
-
-  if(iter < (tot_mcmc_iters - 1)){
-    sigma(iter + 1) = sigma(iter);
-  }
+  MVData data = {y_obs};
+  CovariateCoefs coefs = {nu, eta, Phi, xi, iter, X};
+  updateSigmaKernel(data, coefs, Untempered(), alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sigma);
 }
 
 // Updates the Sigma parameters for the tempered covariate adjusted multivariate model
@@ -409,26 +592,11 @@ inline void updateSigmaTemperedMVCovariateAdj(const double& beta_i,
                                               const int& tot_mcmc_iters,
                                               const arma::mat& X,
                                               arma::vec& sigma){
-  double b_1 = 0;
-  arma::vec mean = arma::zeros(nu.n_cols);
-  for(int i = 0; i < Z.n_rows; i++){
-    mean = arma::zeros(nu.n_cols);
-    for(int k = 0; k < Z.n_cols; k++){
-      mean = mean + Z(i,k) * (nu.row(k).t() + eta.slice(k) * X.row(i).t());
-      for(int m = 0; m < Phi.n_slices; m++){
-        mean = mean + Z(i,k) * chi(i,m) * (Phi.slice(m).row(k).t() +
-          xi(iter,k).slice(m) * X.row(i).t());
-      }
-    }
-    b_1 = b_1 + (beta_i / 2) * arma::dot(y_obs.row(i).t() - mean, y_obs.row(i).t() - mean);
-  }
-  b_1 = b_1 + beta_0;
-  double a = ((beta_i * y_obs.n_elem) / 2) + alpha_0;
-  sigma(iter) = 1 / R::rgamma(a, 1/b_1);
-
-  if(iter < (tot_mcmc_iters - 1)){
-    sigma(iter + 1) = sigma(iter);
-  }
+  MVData data = {y_obs};
+  CovariateCoefs coefs = {nu, eta, Phi, xi, iter, X};
+  Tempered temper = {beta_i};
+  updateSigmaKernel(data, coefs, temper, alpha_0, beta_0, Z, chi, iter,
+                    tot_mcmc_iters, sigma);
 }
 
 }
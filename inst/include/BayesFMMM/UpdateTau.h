@@ -3,6 +3,9 @@
 
 #include <RcppArmadillo.h>
 #include <cmath>
+#include <random>
+#include "ConditionalModes.h"
+#include "Distributions.h"
 
 namespace BayesFMMM{
 // Updates the Tau parameters
@@ -14,13 +17,16 @@ namespace BayesFMMM{
 // @param iter Int containing current MCMC iteration
 // @param tot_mcmc_iters Int containing total number of MCMC iterations
 // @param P Matrix containing tridiagonal P matrix
+// @param rng Source of randomness (RRng or a random number engine owned by the calling thread)
 // @param tau Matrix containing tau for all mcmc iterations
+template <typename Rng>
 inline void updateTau(const double& alpha,
                       const double& beta,
                       const arma::mat& nu,
                       const int& iter,
                       const int& tot_mcmc_iters,
                       const arma::mat& P,
+                      Rng& rng,
                       arma::mat& tau){
   double a = 0;
   double b = 0;
@@ -28,6 +34,45 @@ inline void updateTau(const double& alpha,
   for(int i = 0; i < tau.n_cols; i++){
     a = alpha + (nu.n_cols / 2);
     b = beta + (0.5 * arma::dot(nu.row(i), P * nu.row(i).t()));
+    tau(iter, i) = drawGamma(a, 1/b, rng);
+  }
+  if(iter < (tot_mcmc_iters - 1)){
+    tau.row(iter + 1) = tau.row(iter);
+  }
+}
+
+// Updates the Tau parameters using R's random number generator
+//
+// @name updateTau
+inline void updateTau(const double& alpha,
+                      const double& beta,
+                      const arma::mat& nu,
+                      const int& iter,
+                      const int& tot_mcmc_iters,
+                      const arma::mat& P,
+                      arma::mat& tau){
+  RRng rng;
+  updateTau(alpha, beta, nu, iter, tot_mcmc_iters, P, rng, tau);
+}
+
+// Updates the Tau parameters using a sparse P matrix
+//
+// @name updateTau
+inline void updateTau(const double& alpha,
+                      const double& beta,
+                      const arma::mat& nu,
+                      const int& iter,
+                      const int& tot_mcmc_iters,
+                      const arma::sp_mat& P,
+                      arma::mat& tau){
+  double a = 0;
+  double b = 0;
+  arma::vec nu_i;
+
+  for(int i = 0; i < tau.n_cols; i++){
+    nu_i = nu.row(i).t();
+    a = alpha + (nu.n_cols / 2);
+    b = beta + (0.5 * arma::dot(nu_i, arma::vec(P * nu_i)));
     tau(iter, i) =  R::rgamma(a, 1/b);
   }
   if(iter < (tot_mcmc_iters - 1)){
@@ -35,6 +80,38 @@ inline void updateTau(const double& alpha,
   }
 }
 
+// Updates the Tau parameters by iterated conditional modes, setting tau to the
+// mode of its gamma conditional posterior (used by the ICM initializer)
+//
+// @name updateTauICM
+// @param alpha Double containing hyperparameter
+// @param beta Double containing hyperparameter
+// @param nu Matrix containing nu parameters
+// @param iter Int containing current iteration
+// @param tot_mcmc_iters Int containing total number of iterations
+// @param P Matrix containing tridiagonal P matrix
+// @param tau Matrix containing the estimates of tau at each iteration
+inline void updateTauICM(const double& alpha,
+                         const double& beta,
+                         const arma::mat& nu,
+                         const int& iter,
+                         const int& tot_mcmc_iters,
+                         const arma::mat& P,
+                         arma::mat& tau){
+  double a = 0;
+  double b = 0;
+
+  ConditionalMode mode;
+  for(int i = 0; i < tau.n_cols; i++){
+    a = alpha + (nu.n_cols / 2.0);
+    b = beta + (0.5 * arma::dot(nu.row(i), P * nu.row(i).t()));
+    tau(iter, i) = drawGamma(a, 1/b, mode);
+  }
+  if(iter < (tot_mcmc_iters - 1)){
+    tau.row(iter + 1) = tau.row(iter);
+  }
+}
+
 // Updates the Tau parameters for the multivariate model
 //
 // @name updateTauMV
@@ -3,6 +3,9 @@
 
 #include <RcppArmadillo.h>
 #include <cmath>
+#include "CovariateEffects.h"
+#include "RaggedObs.h"
+#include "Workspace.h"
 
 namespace BayesFMMM{
 // Updates the xi parameters for the functional covariate adjusted model
@@ -52,8 +55,8 @@ inline void updateXiCovariateAdj(const arma::field<arma::vec>& y_obs,
           if(Z(i,j) != 0){
             for(int l = 0; l < y_obs(i,0).n_elem; l++){
               ph = y_obs(i,0)(l);
-              M_1 = M_1 + Z(i,j) *  Z(i,j) * X(i,d) * X(i,d) * (chi(i,m) * chi(i,m) *
-                B_obs(i,0).row(l).t() * B_obs(i,0).row(l));
+              addOuterRow(B_obs(i,0), l, Z(i,j) * Z(i,j) * X(i,d) * X(i,d) *
+                          chi(i,m) * chi(i,m), M_1);
               for(int k = 0; k < Z.n_cols; k++){
                 ph = ph - (Z(i,k) * (arma::dot(nu.row(k),B_obs(i,0).row(l)) +
                   arma::dot(eta.slice(k) * X.row(i).t(), B_obs(i,0).row(l))));
@@ -66,7 +69,7 @@ inline void updateXiCovariateAdj(const arma::field<arma::vec>& y_obs,
               }
               ph = ph + (Z(i,j) * chi(i,m) * X(i,d) * arma::dot(xi(iter,j).slice(m).col(d),
                            B_obs(i,0).row(l)));
-              m_1 = m_1 + Z(i,j) * chi(i,m) * X(i,d) * B_obs(i,0).row(l).t() * ph;
+              addScaledRow(B_obs(i,0), l, Z(i,j) * chi(i,m) * X(i,d) * ph, m_1);
             }
           }
         }
@@ -141,8 +144,8 @@ inline void updateXiTemperedCovariateAdj(const double& beta_i,
           if(Z(i,j) != 0){
             for(int l = 0; l < y_obs(i,0).n_elem; l++){
               ph = y_obs(i,0)(l);
-              M_1 = M_1 + Z(i,j) *  Z(i,j) * X(i,d) * X(i,d) * (chi(i,m) * chi(i,m) *
-                B_obs(i,0).row(l).t() * B_obs(i,0).row(l));
+              addOuterRow(B_obs(i,0), l, Z(i,j) * Z(i,j) * X(i,d) * X(i,d) *
+                          chi(i,m) * chi(i,m), M_1);
               for(int k = 0; k < Z.n_cols; k++){
                 ph = ph - (Z(i,k) * (arma::dot(nu.row(k),B_obs(i,0).row(l)) +
                   arma::dot(eta.slice(k) * X.row(i).t(), B_obs(i,0).row(l))));
@@ -155,7 +158,7 @@ inline void updateXiTemperedCovariateAdj(const double& beta_i,
               }
               ph = ph + (Z(i,j) * chi(i,m) * X(i,d) * arma::dot(xi(iter,j).slice(m).col(d),
                            B_obs(i,0).row(l)));
-              m_1 = m_1 + Z(i,j) * chi(i,m) * X(i,d) * B_obs(i,0).row(l).t() * ph;
+              addScaledRow(B_obs(i,0), l, Z(i,j) * chi(i,m) * X(i,d) * ph, m_1);
             }
           }
         }
@@ -181,6 +184,119 @@ inline void updateXiTemperedCovariateAdj(const double& beta_i,
   }
 }
 
+// Updates the xi parameters for the functional covariate adjusted model using
+// tempered transitions and the cached covariate adjusted coefficients
+//
+// @name updateXiTemperedCovariateAdj
+// @param beta_i Double containing the current temperature
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients (updated after each draw)
+// @param gamma_xi Field of Cubes containing current gamma_xi parameters
+// @param tilde_tau_xi Cube containing current tilde_tau_xi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing chi values
+// @param sigma_sq double containing the sigma_sq variable
+// @param X Matrix containing covariates
+// @param iter int containing current mcmc sample
+// @param m_1 Vector acting as a placeholder for m in mean vector
+// @param M_1 Matrix acting as a placeholder for M in covariance
+// @param xi Field of Cubes containing all mcmc samples of xi
+inline void updateXiTemperedCovariateAdj(const double& beta_i,
+                                         const RaggedObs& obs,
+                                         CovariateEffects& cov,
+                                         const arma::field<arma::cube>& gamma_xi,
+                                         const arma::cube& tilde_tau_xi,
+                                         const arma::mat& Z,
+                                         const arma::mat& chi,
+                                         const double& sigma_sq,
+                                         const arma::mat& X,
+                                         const int& iter,
+                                         const int& tot_mcmc_iters,
+                                         arma::vec& m_1,
+                                         arma::mat& M_1,
+                                         arma::field<arma::cube>& xi){
+  arma::vec coef = arma::zeros(xi(iter,0).n_rows);
+  arma::vec resid;
+  arma::vec xi_old;
+
+  for(int j =  0; j < Z.n_cols; j ++){
+    for(int m = 0; m < xi(iter,0).n_slices; m++){
+      for(int d = 0; d < X.n_cols; d++){
+        m_1.zeros();
+        M_1.zeros();
+        for(int i = 0; i < Z.n_rows; i++){
+          if((Z(i,j) != 0) && (X(i,d) != 0) && (obs.n_obs(i) > 0)){
+            // residual after removing every term except xi_jmd
+            calcMeanCoef(cov, i, Z.row(i), chi.row(i), coef);
+            coef = coef - Z(i,j) * chi(i,m) * X(i,d) * xi(iter,j).slice(m).col(d);
+            resid = obs.y_i(i) - obs.B_i(i).t() * coef;
+            M_1 = M_1 + Z(i,j) * Z(i,j) * X(i,d) * X(i,d) * chi(i,m) * chi(i,m) *
+              (obs.B_i(i) * obs.B_i(i).t());
+            m_1 = m_1 + Z(i,j) * chi(i,m) * X(i,d) * (obs.B_i(i) * resid);
+          }
+        }
+        m_1 = m_1 * (beta_i / sigma_sq);
+        M_1 = M_1 * (beta_i / sigma_sq);
+
+        //Add on diagonal component
+        for(int k = 0; k < M_1.n_rows; k++){
+          M_1(k,k) = M_1(k,k) + tilde_tau_xi(j,m,d) * gamma_xi(iter,j)(k,d,m);
+        }
+        arma::inv(M_1, M_1);
+
+        //generate new sample
+        xi_old = xi(iter,j).slice(m).col(d);
+        xi(iter,j).slice(m).col(d) =  arma::mvnrnd(M_1 * m_1, M_1);
+
+        // propagate the change to the covariate adjusted eigenfunctions
+        xi_old = xi(iter,j).slice(m).col(d) - xi_old;
+        for(int i = 0; i < Z.n_rows; i++){
+          cov.Phi(i,0).slice(m).row(j) += X(i,d) * xi_old.t();
+        }
+      }
+    }
+  }
+  // Update next iteration
+  if(iter < (tot_mcmc_iters - 1)){
+    for(int k = 0; k < Z.n_cols; k++){
+      xi(iter + 1, k) = xi(iter, k);
+    }
+  }
+}
+
+// Updates the xi parameters for the functional covariate adjusted model using
+// the cached covariate adjusted coefficients
+//
+// @name updateXiCovariateAdj
+// @param obs RaggedObs containing observed values and basis functions
+// @param cov CovariateEffects containing the covariate adjusted coefficients (updated after each draw)
+// @param gamma_xi Field of Cubes containing current gamma_xi parameters
+// @param tilde_tau_xi Cube containing current tilde_tau_xi parameters
+// @param Z Matrix containing current Z parameters
+// @param chi Matrix containing chi values
+// @param sigma_sq double containing the sigma_sq variable
+// @param X Matrix containing covariates
+// @param iter int containing current mcmc sample
+// @param m_1 Vector acting as a placeholder for m in mean vector
+// @param M_1 Matrix acting as a placeholder for M in covariance
+// @param xi Field of Cubes containing all mcmc samples of xi
+inline void updateXiCovariateAdj(const RaggedObs& obs,
+                                 CovariateEffects& cov,
+                                 const arma::field<arma::cube>& gamma_xi,
+                                 const arma::cube& tilde_tau_xi,
+                                 const arma::mat& Z,
+                                 const arma::mat& chi,
+                                 const double& sigma_sq,
+                                 const arma::mat& X,
+                                 const int& iter,
+                                 const int& tot_mcmc_iters,
+                                 arma::vec& m_1,
+                                 arma::mat& M_1,
+                                 arma::field<arma::cube>& xi){
+  updateXiTemperedCovariateAdj(1.0, obs, cov, gamma_xi, tilde_tau_xi, Z, chi,
+                               sigma_sq, X, iter, tot_mcmc_iters, m_1, M_1, xi);
+}
+
 // Updates the Phi parameters for the multivariate covariate adjusted multivariate model
 //
 // @name UpdatePhiMVCovariateAdj
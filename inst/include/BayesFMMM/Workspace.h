@@ -0,0 +1,129 @@
+#ifndef BayesFMMM_WORKSPACE_H
+#define BayesFMMM_WORKSPACE_H
+
+#include <RcppArmadillo.h>
+
+namespace BayesFMMM{
+// Scratch memory reused by the inner loops of the kernels, so that they write
+// into preallocated buffers instead of allocating Armadillo temporaries for
+// every function or observed time point. Buffers are only reallocated when
+// their size changes, so once a sweep has been run with the current sizes no
+// further heap allocation is made by the loops using the workspace. Each thread of the subject scheduler owns
+// one Workspace, and the scheduler owns one more for the serial parts of its
+// kernels. Every time a buffer is (re)allocated it is counted in n_alloc;
+// memory allocated by a kernel outside of its workspace is not counted, so
+// the kernels using a workspace take all of their scratch memory from it.
+//
+// @name Workspace
+// @field coef Vector (P) containing basis coefficients of the conditional mean
+// @field dir Vector (P) containing basis coefficients of an eigenfunction or feature
+// @field basis Vector (P) containing the product of the basis functions with the residuals
+// @field gram Matrix (P x P) containing cross products of the basis functions
+// @field feat Matrix (P x K) containing the coefficients of the mean of each feature
+// @field feat_gram Matrix (K x K) containing cross products of the means of the features
+// @field memb Vector (K) containing the current memberships of a function
+// @field prop_alpha Vector (K) containing concentration parameters of the proposal
+// @field hmc Matrix (K x 6) containing the state, momentum and gradient of the HMC update of a row of Z
+// @field prop Matrix (N x K) containing the proposals of every row of Z
+// @field unif Vector (N) containing a uniform draw (or the seed of an engine) for every function
+// @field nu_mean Matrix (K x P) containing the conditional posterior means of nu when they are not kept
+// @field n_alloc Int containing the number of (re)allocations of the buffers
+struct Workspace{
+  arma::vec coef;
+  arma::vec dir;
+  arma::vec basis;
+  arma::mat gram;
+  arma::mat feat;
+  arma::mat feat_gram;
+  arma::vec memb;
+  arma::vec prop_alpha;
+  arma::mat hmc;
+  arma::mat prop;
+  arma::vec unif;
+  arma::mat nu_mean;
+  int n_alloc;
+};
+
+// Creates an empty workspace
+//
+// @name makeWorkspace
+// @returns ws Workspace with empty buffers
+inline Workspace makeWorkspace(){
+  Workspace ws;
+  ws.n_alloc = 0;
+  return ws;
+}
+
+// Sets the size of a buffer of fixed size, reallocating it only if the size
+// changed
+//
+// @name fitScratch
+// @param x Vector acting as the buffer
+// @param n Int containing the number of elements needed
+// @param n_alloc Int containing the number of (re)allocations
+// @returns x Reference to the buffer
+inline arma::vec& fitScratch(arma::vec& x,
+                             const arma::uword n,
+                             int& n_alloc){
+  if(x.n_elem != n){
+    x.set_size(n);
+    n_alloc++;
+  }
+  return x;
+}
+
+// Sets the size of a buffer of fixed size, reallocating it only if the size
+// changed
+//
+// @name fitScratch
+inline arma::mat& fitScratch(arma::mat& x,
+                             const arma::uword n_rows,
+                             const arma::uword n_cols,
+                             int& n_alloc){
+  if((x.n_rows != n_rows) || (x.n_cols != n_cols)){
+    x.set_size(n_rows, n_cols);
+    n_alloc++;
+  }
+  return x;
+}
+
+// Adds w * b_l' * b_l to A, where b_l is the lth row of B, without creating
+// temporaries
+//
+// @name addOuterRow
+// @param B Matrix containing basis functions evaluated at observed time points
+// @param l Int containing the row of interest
+// @param w Double containing the weight of the outer product
+// @param A Matrix to which the outer product is added
+inline void addOuterRow(const arma::mat& B,
+                        const arma::uword l,
+                        const double w,
+                        arma::mat& A){
+  double b_q = 0;
+  for(arma::uword q = 0; q < B.n_cols; q++){
+    b_q = w * B.at(l,q);
+    for(arma::uword p = 0; p < B.n_cols; p++){
+      A.at(p,q) = A.at(p,q) + (b_q * B.at(l,p));
+    }
+  }
+}
+
+// Adds w * b_l' to a, where b_l is the lth row of B, without creating
+// temporaries
+//
+// @name addScaledRow
+// @param B Matrix containing basis functions evaluated at observed time points
+// @param l Int containing the row of interest
+// @param w Double containing the weight of the row
+// @param a Vector to which the row is added
+inline void addScaledRow(const arma::mat& B,
+                         const arma::uword l,
+                         const double w,
+                         arma::vec& a){
+  for(arma::uword p = 0; p < B.n_cols; p++){
+    a.at(p) = a.at(p) + (w * B.at(l,p));
+  }
+}
+}
+
+#endif
@@ -97,190 +97,9 @@ Rcpp::List FMeanCI(const std::string dir,
     }
   }
 
-  arma::cube nu_i;
-  nu_i.load(dir + "Nu0.txt");
-  if(k <= 0){
-    Rcpp::stop("'k' must be positive");
-  }
-  if(k > nu_i.n_rows){
-    Rcpp::stop("'k' must be less than or equal to the number of clusters in the model");
-  }
-  arma::cube nu_samp1 = arma::zeros(nu_i.n_rows, nu_i.n_cols, nu_i.n_slices * n_files);
-  nu_samp1.subcube(0, 0, 0, nu_i.n_rows-1, nu_i.n_cols-1, nu_i.n_slices-1) = nu_i;
-  for(int i = 1; i < n_files; i++){
-    nu_i.load(dir + "Nu" + std::to_string(i) +".txt");
-    nu_samp1.subcube(0, 0,  nu_i.n_slices*i, nu_i.n_rows-1, nu_i.n_cols-1,
-                    (nu_i.n_slices)*(i+1) - 1) = nu_i;
-  }
-
-  arma::cube nu_samp = arma::zeros(nu_i.n_rows, nu_i.n_cols,
-                                   std::round((nu_i.n_slices * n_files)* (1 - burnin_prop)));
-  nu_samp = nu_samp1.subcube(0, 0, std::round(nu_i.n_slices * n_files * burnin_prop),
-                             nu_samp1.n_rows-1, nu_samp1.n_cols-1, nu_samp1.n_slices-1);
-
-  if(rescale == true){
-    if(nu_i.n_rows > 2){
-      rescale = false;
-      Rcpp::Rcout << "Rescale property cannot be used for K > 2";
-    }
-  }
-
-  splines2::BSpline bspline;
-
-  bspline = splines2::BSpline(time, internal_knots, basis_degree,
-                              boundary_knots);
-  // Get Basis matrix (100 x 8)
-  arma::mat bspline_mat{bspline.basis(true)};
-
-  // Make B_obs
-  arma::mat B = bspline_mat;
-  arma::mat f_samp = arma::zeros(nu_samp.n_slices, time.n_elem);
-
-  // Initialize placeholders
-  arma::vec CI_Upper = arma::zeros(time.n_elem);
-  arma::vec CI_50 = arma::zeros(time.n_elem);
-  arma::vec CI_Lower = arma::zeros(time.n_elem);
-
-  if(simultaneous == false){
-    if(rescale == true){
-      // Get Z matrix
-      arma::cube Z_i;
-      Z_i.load(dir + "Z0.txt");
-      arma::cube Z_samp1 = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-      Z_samp1.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-      for(int i = 1; i < n_files; i++){
-        Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-        Z_samp1.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-      }
-      arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols,
-                                      std::round((Z_i.n_slices * n_files)* (1 - burnin_prop)));
-      Z_samp = Z_samp1.subcube(0, 0, std::round(Z_i.n_slices * n_files * burnin_prop),
-                               Z_samp1.n_rows-1, Z_samp1.n_cols-1, Z_samp1.n_slices-1);
-
-      // rescale Z and nu
-      arma::mat transform_mat;
-      arma::vec ph = arma::zeros(Z_samp.n_rows);
-      for(int j = 0; j < Z_samp.n_slices; j++){
-        transform_mat = arma::zeros(Z_samp.n_cols, Z_samp.n_cols);
-        int max_ind = 0;
-        for(int i = 0; i < Z_samp.n_cols; i++){
-          for(int l = 0; l < Z_samp.n_rows; l++){
-            ph(l) = Z_samp(l,i,j);
-          }
-          max_ind = arma::index_max(ph);
-          transform_mat.row(i) = Z_samp.slice(j).row(max_ind);
-        }
-        nu_samp.slice(j) = transform_mat * nu_samp.slice(j);
-      }
-
-      for(int i = 0; i < nu_samp.n_slices; i++){
-        f_samp.row(i) = (B * nu_samp.slice(i).row(k-1).t()).t();
-      }
-    } else{
-      for(int i = 0; i < nu_samp.n_slices; i++){
-        f_samp.row(i) = (B * nu_samp.slice(i).row(k-1).t()).t();
-      }
-    }
-
-    arma::vec p = {alpha/2, 0.5, 1 - (alpha/2)};
-    arma::vec q = arma::zeros(3);
-
-    for(int i = 0; i < time.n_elem; i++){
-      q = arma::quantile(f_samp.col(i), p);
-      CI_Lower(i) = q(0);
-      CI_50(i) = q(1);
-      CI_Upper(i) = q(2);
-    }
-  }else{
-    if(rescale == true){
-      // Get Z matrix
-      arma::cube Z_i;
-      Z_i.load(dir + "Z0.txt");
-      arma::cube Z_samp1 = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-      Z_samp1.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-      for(int i = 1; i < n_files; i++){
-        Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-        Z_samp1.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-      }
-
-      arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols,
-                                      std::round((Z_i.n_slices * n_files)* (1 - burnin_prop)));
-      Z_samp = Z_samp1.subcube(0, 0, std::round(Z_i.n_slices * n_files * burnin_prop),
-                               Z_samp1.n_rows-1, Z_samp1.n_cols-1, Z_samp1.n_slices-1);
-      // rescale Z and nu
-      arma::mat transform_mat;
-      arma::vec ph = arma::zeros(Z_samp.n_rows);
-      for(int j = 0; j < Z_samp.n_slices; j++){
-        transform_mat = arma::zeros(Z_samp.n_cols, Z_samp.n_cols);
-        int max_ind = 0;
-        for(int i = 0; i < Z_samp.n_cols; i++){
-          for(int l = 0; l < Z_samp.n_rows; l++){
-            ph(l) = Z_samp(l,i,j);
-          }
-          max_ind = arma::index_max(ph);
-          transform_mat.row(i) = Z_samp.slice(j).row(max_ind);
-        }
-        nu_samp.slice(j) = transform_mat * nu_samp.slice(j);
-      }
-
-      for(int i = 0; i < nu_samp.n_slices; i++){
-        f_samp.row(i) = (B * nu_samp.slice(i).row(k-1).t()).t();
-      }
-      arma::rowvec f_mean = arma::mean(f_samp, 0);
-      arma::rowvec f_sd = arma::stddev(f_samp, 0, 0);
-
-      arma::vec C = arma::zeros(nu_samp.n_slices);
-      arma::vec ph1 = arma::zeros(time.n_elem);
-      for(int i = 0; i < nu_samp.n_slices; i++){
-        for(int j = 0; j < time.n_elem; j++){
-          ph1(j) = std::abs((f_samp(i,j) - f_mean(j)) / f_sd(j));
-        }
-        C(i) = arma::max(ph1);
-      }
-
-      arma::vec p = {1 - alpha};
-      arma::vec q = arma::zeros(1);
-      q = arma::quantile(C, p);
-
-      for(int i = 0; i < time.n_elem; i++){
-        CI_Lower(i) = f_mean(i) - q(0) * f_sd(i);
-        CI_50(i) = f_mean(i);
-        CI_Upper(i) =  f_mean(i) + q(0) * f_sd(i);
-      }
-    }else{
-      arma::mat f_samp = arma::zeros(nu_samp.n_slices, time.n_elem);
-      for(int i = 0; i < nu_samp.n_slices; i++){
-        f_samp.row(i) = (B * nu_samp.slice(i).row(k-1).t()).t();
-      }
-      arma::rowvec f_mean = arma::mean(f_samp, 0);
-      arma::rowvec f_sd = arma::stddev(f_samp, 0, 0);
-
-      arma::vec C = arma::zeros(nu_samp.n_slices);
-      arma::vec ph1 = arma::zeros(time.n_elem);
-      for(int i = 0; i < nu_samp.n_slices; i++){
-        for(int j = 0; j < time.n_elem; j++){
-          ph1(j) = std::abs((f_samp(i,j) - f_mean(j)) / f_sd(j));
-        }
-        C(i) = arma::max(ph1);
-      }
-
-      arma::vec p = {1 - alpha};
-      arma::vec q = arma::zeros(1);
-      q = arma::quantile(C, p);
-
-      for(int i = 0; i < time.n_elem; i++){
-        CI_Lower(i) = f_mean(i) - q(0) * f_sd(i);
-        CI_50(i) = f_mean(i);
-        CI_Upper(i) =  f_mean(i) + q(0) * f_sd(i);
-      }
-    }
-  }
-
-  Rcpp::List CI =  Rcpp::List::create(Rcpp::Named("CI_Upper", CI_Upper),
-                                      Rcpp::Named("CI_50", CI_50),
-                                      Rcpp::Named("CI_Lower", CI_Lower),
-                                      Rcpp::Named("mean_trace", f_samp));
-  return(CI);
+  BayesFMMM::Posterior post(dir, n_files, basis_degree, boundary_knots,
+                            internal_knots);
+  return post.FMeanCI(time, k, alpha, rescale, simultaneous, burnin_prop);
 }
 
 
@@ -383,20 +202,14 @@ Rcpp::List HDFMeanCI(const std::string dir,
   }
 
   arma::cube nu_i;
-  nu_i.load(dir + "Nu0.txt");
+  BayesFMMM::loadSamples(nu_i, dir + "Nu0.txt");
   if(k <= 0){
     Rcpp::stop("'k' must be positive");
   }
   if(k > nu_i.n_rows){
     Rcpp::stop("'k' must be less than or equal to the number of clusters in the model");
   }
-  arma::cube nu_samp1 = arma::zeros(nu_i.n_rows, nu_i.n_cols, nu_i.n_slices * n_files);
-  nu_samp1.subcube(0, 0, 0, nu_i.n_rows-1, nu_i.n_cols-1, nu_i.n_slices-1) = nu_i;
-  for(int i = 1; i < n_files; i++){
-    nu_i.load(dir + "Nu" + std::to_string(i) +".txt");
-    nu_samp1.subcube(0, 0,  nu_i.n_slices*i, nu_i.n_rows-1, nu_i.n_cols-1,
-                     (nu_i.n_slices)*(i+1) - 1) = nu_i;
-  }
+  arma::cube nu_samp1 = BayesFMMM::loadCubeSamples(dir, "Nu", n_files);
 
   arma::cube nu_samp = arma::zeros(nu_i.n_rows, nu_i.n_cols,
                                    std::round((nu_i.n_slices * n_files)* (1 - burnin_prop)));
@@ -417,146 +230,41 @@ Rcpp::List HDFMeanCI(const std::string dir,
     }
   }
 
+  if(rescale == true){
+    // Get Z matrix
+    arma::cube Z_i;
+    BayesFMMM::loadSamples(Z_i, dir + "Z0.txt");
+    arma::cube Z_samp1 = BayesFMMM::loadCubeSamples(dir, "Z", n_files);
+    arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols,
+                                    std::round((Z_i.n_slices * n_files)* (1 - burnin_prop)));
+    Z_samp = Z_samp1.subcube(0, 0, std::round(Z_i.n_slices * n_files * burnin_prop),
+                             Z_samp1.n_rows-1, Z_samp1.n_cols-1, Z_samp1.n_slices-1);
 
-  // Initialize placeholders
-  arma::vec CI_Upper = arma::zeros(time.n_rows);
-  arma::vec CI_50 = arma::zeros(time.n_rows);
-  arma::vec CI_Lower = arma::zeros(time.n_rows);
-
-  if(simultaneous == false){
-    if(rescale == true){
-      // Get Z matrix
-      arma::cube Z_i;
-      Z_i.load(dir + "Z0.txt");
-      arma::cube Z_samp1 = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-      Z_samp1.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-      for(int i = 1; i < n_files; i++){
-        Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-        Z_samp1.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-      }
-      arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols,
-                                      std::round((Z_i.n_slices * n_files)* (1 - burnin_prop)));
-      Z_samp = Z_samp1.subcube(0, 0, std::round(Z_i.n_slices * n_files * burnin_prop),
-                               Z_samp1.n_rows-1, Z_samp1.n_cols-1, Z_samp1.n_slices-1);
-
-      // rescale Z and nu
-      arma::mat transform_mat;
-      arma::vec ph = arma::zeros(Z_samp.n_rows);
-      for(int j = 0; j < Z_samp.n_slices; j++){
-        transform_mat = arma::zeros(Z_samp.n_cols, Z_samp.n_cols);
-        int max_ind = 0;
-        for(int i = 0; i < Z_samp.n_cols; i++){
-          for(int l = 0; l < Z_samp.n_rows; l++){
-            ph(l) = Z_samp(l,i,j);
-          }
-          max_ind = arma::index_max(ph);
-          transform_mat.row(i) = Z_samp.slice(j).row(max_ind);
-        }
-        nu_samp.slice(j) = transform_mat * nu_samp.slice(j);
-      }
-
-      for(int i = 0; i < nu_samp.n_slices; i++){
-        f_samp.row(i) = (B * nu_samp.slice(i).row(k-1).t()).t();
-      }
-    } else{
-      for(int i = 0; i < nu_samp.n_slices; i++){
-        f_samp.row(i) = (B * nu_samp.slice(i).row(k-1).t()).t();
-      }
-    }
-
-    arma::vec p = {alpha/2, 0.5, 1 - (alpha/2)};
-    arma::vec q = arma::zeros(3);
-
-    for(int i = 0; i < time.n_rows; i++){
-      q = arma::quantile(f_samp.col(i), p);
-      CI_Lower(i) = q(0);
-      CI_50(i) = q(1);
-      CI_Upper(i) = q(2);
-    }
-  }else{
-    if(rescale == true){
-      // Get Z matrix
-      arma::cube Z_i;
-      Z_i.load(dir + "Z0.txt");
-      arma::cube Z_samp1 = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-      Z_samp1.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-      for(int i = 1; i < n_files; i++){
-        Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-        Z_samp1.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-      }
-
-      arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols,
-                                      std::round((Z_i.n_slices * n_files)* (1 - burnin_prop)));
-      Z_samp = Z_samp1.subcube(0, 0, std::round(Z_i.n_slices * n_files * burnin_prop),
-                               Z_samp1.n_rows-1, Z_samp1.n_cols-1, Z_samp1.n_slices-1);
-      // rescale Z and nu
-      arma::mat transform_mat;
-      arma::vec ph = arma::zeros(Z_samp.n_rows);
-      for(int j = 0; j < Z_samp.n_slices; j++){
-        transform_mat = arma::zeros(Z_samp.n_cols, Z_samp.n_cols);
-        int max_ind = 0;
-        for(int i = 0; i < Z_samp.n_cols; i++){
-          for(int l = 0; l < Z_samp.n_rows; l++){
-            ph(l) = Z_samp(l,i,j);
-          }
-          max_ind = arma::index_max(ph);
-          transform_mat.row(i) = Z_samp.slice(j).row(max_ind);
-        }
-        nu_samp.slice(j) = transform_mat * nu_samp.slice(j);
-      }
-      arma::mat f_samp = arma::zeros(nu_samp.n_slices, time.n_rows);
-      for(int i = 0; i < nu_samp.n_slices; i++){
-        f_samp.row(i) = (B * nu_samp.slice(i).row(k-1).t()).t();
-      }
-      arma::rowvec f_mean = arma::mean(f_samp, 0);
-      arma::rowvec f_sd = arma::stddev(f_samp, 0, 0);
-
-      arma::vec C = arma::zeros(nu_samp.n_slices);
-      arma::vec ph1 = arma::zeros(time.n_rows);
-      for(int i = 0; i < nu_samp.n_slices; i++){
-        for(int j = 0; j < time.n_rows; j++){
-          ph1(j) = std::abs((f_samp(i,j) - f_mean(j)) / f_sd(j));
-        }
-        C(i) = arma::max(ph1);
-      }
-
-      arma::vec p = {1 - alpha};
-      arma::vec q = arma::zeros(1);
-      q = arma::quantile(C, p);
-
-      for(int i = 0; i < time.n_rows; i++){
-        CI_Lower(i) = f_mean(i) - q(0) * f_sd(i);
-        CI_50(i) = f_mean(i);
-        CI_Upper(i) =  f_mean(i) + q(0) * f_sd(i);
-      }
-    }else{
-      arma::mat f_samp = arma::zeros(nu_samp.n_slices, time.n_rows);
-      for(int i = 0; i < nu_samp.n_slices; i++){
-        f_samp.row(i) = (B * nu_samp.slice(i).row(k-1).t()).t();
-      }
-      arma::rowvec f_mean = arma::mean(f_samp, 0);
-      arma::rowvec f_sd = arma::stddev(f_samp, 0, 0);
-
-      arma::vec C = arma::zeros(nu_samp.n_slices);
-      arma::vec ph1 = arma::zeros(time.n_rows);
-      for(int i = 0; i < nu_samp.n_slices; i++){
-        for(int j = 0; j < time.n_rows; j++){
-          ph1(j) = std::abs((f_samp(i,j) - f_mean(j)) / f_sd(j));
+    // rescale Z and nu
+    arma::mat transform_mat;
+    arma::vec ph = arma::zeros(Z_samp.n_rows);
+    for(int j = 0; j < Z_samp.n_slices; j++){
+      transform_mat = arma::zeros(Z_samp.n_cols, Z_samp.n_cols);
+      int max_ind = 0;
+      for(int i = 0; i < Z_samp.n_cols; i++){
+        for(int l = 0; l < Z_samp.n_rows; l++){
+          ph(l) = Z_samp(l,i,j);
         }
-        C(i) = arma::max(ph1);
-      }
-
-      arma::vec p = {1 - alpha};
-      arma::vec q = arma::zeros(1);
-      q = arma::quantile(C, p);
-
-      for(int i = 0; i < time.n_rows; i++){
-        CI_Lower(i) = f_mean(i) - q(0) * f_sd(i);
-        CI_50(i) = f_mean(i);
-        CI_Upper(i) =  f_mean(i) + q(0) * f_sd(i);
+        max_ind = arma::index_max(ph);
+        transform_mat.row(i) = Z_samp.slice(j).row(max_ind);
       }
+      nu_samp.slice(j) = transform_mat * nu_samp.slice(j);
     }
   }
+  for(int i = 0; i < nu_samp.n_slices; i++){
+    f_samp.row(i) = (B * nu_samp.slice(i).row(k-1).t()).t();
+  }
+
+  // Initialize placeholders
+  arma::vec CI_Upper = arma::zeros(time.n_rows);
+  arma::vec CI_50 = arma::zeros(time.n_rows);
+  arma::vec CI_Lower = arma::zeros(time.n_rows);
+  BayesFMMM::calcRowCI(f_samp.t(), alpha, simultaneous, CI_Lower, CI_50, CI_Upper);
 
   Rcpp::List CI =  Rcpp::List::create(Rcpp::Named("CI_Upper", CI_Upper),
                                       Rcpp::Named("CI_50", CI_50),
@@ -625,14 +333,8 @@ Rcpp::List MVMeanCI(const std::string dir,
   }
 
   arma::cube nu_i;
-  nu_i.load(dir + "Nu0.txt");
-  arma::cube nu_samp1 = arma::zeros(nu_i.n_rows, nu_i.n_cols, nu_i.n_slices * n_files);
-  nu_samp1.subcube(0, 0, 0, nu_i.n_rows-1, nu_i.n_cols-1, nu_i.n_slices-1) = nu_i;
-  for(int i = 1; i < n_files; i++){
-    nu_i.load(dir + "Nu" + std::to_string(i) +".txt");
-    nu_samp1.subcube(0, 0,  nu_i.n_slices*i, nu_i.n_rows-1, nu_i.n_cols-1,
-                     (nu_i.n_slices)*(i+1) - 1) = nu_i;
-  }
+  BayesFMMM::loadSamples(nu_i, dir + "Nu0.txt");
+  arma::cube nu_samp1 = BayesFMMM::loadCubeSamples(dir, "Nu", n_files);
 
   arma::cube nu_samp = arma::zeros(nu_i.n_rows, nu_i.n_cols,
                                    std::round((nu_i.n_slices * n_files)* (1 - burnin_prop)));
@@ -654,13 +356,8 @@ Rcpp::List MVMeanCI(const std::string dir,
   if(rescale == true){
     // Get Z matrix
     arma::cube Z_i;
-    Z_i.load(dir + "Z0.txt");
-    arma::cube Z_samp1 = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-    Z_samp1.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-    for(int i = 1; i < n_files; i++){
-      Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-      Z_samp1.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-    }
+    BayesFMMM::loadSamples(Z_i, dir + "Z0.txt");
+    arma::cube Z_samp1 = BayesFMMM::loadCubeSamples(dir, "Z", n_files);
     arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols,
                                     std::round((Z_i.n_slices * n_files)* (1 - burnin_prop)));
     Z_samp = Z_samp1.subcube(0, 0, std::round(Z_i.n_slices * n_files * burnin_prop),
@@ -683,21 +380,14 @@ Rcpp::List MVMeanCI(const std::string dir,
     }
   }
 
+  // quantiles of each element of nu (viewed as a (K*P) x samples matrix)
   arma::vec p = {alpha/2, 0.5, 1 - (alpha/2)};
-  arma::vec q = arma::zeros(3);
-  arma::vec ph = arma::zeros(nu_samp.n_slices);
-
-  for(int i = 0; i < nu_i.n_cols; i++){
-    for(int k = 0; k < nu_i.n_rows; k++){
-      for(int n = 0; n < nu_samp.n_slices; n++){
-        ph(n) = nu_samp(k,i,n);
-      }
-      q = arma::quantile(ph, p);
-      CI_Lower(k, i) = q(0);
-      CI_50(k,i) = q(1);
-      CI_Upper(k,i) = q(2);
-    }
-  }
+  const arma::mat nu_draws(nu_samp.memptr(), nu_samp.n_rows * nu_samp.n_cols,
+                           nu_samp.n_slices, false, true);
+  arma::mat q = BayesFMMM::calcRowQuantiles(nu_draws, p);
+  CI_Lower = arma::reshape(q.col(0), nu_i.n_rows, nu_i.n_cols);
+  CI_50 = arma::reshape(q.col(1), nu_i.n_rows, nu_i.n_cols);
+  CI_Upper = arma::reshape(q.col(2), nu_i.n_rows, nu_i.n_cols);
 
   Rcpp::List CI =  Rcpp::List::create(Rcpp::Named("CI_Upper", CI_Upper),
                                       Rcpp::Named("CI_50", CI_50),
@@ -815,202 +505,10 @@ Rcpp::List FCovCI(const std::string dir,
     }
   }
 
-  // Get Phi Paramters
-  arma::field<arma::cube> phi_i;
-  phi_i.load(dir + "Phi0.txt");
-  if(l <= 0){
-    Rcpp::stop("'l' must be positive");
-  }
-  if(l > phi_i(0,0).n_rows){
-    Rcpp::stop("'l' must be less than or equal to the number of clusters in the model");
-  }
-  if(m <= 0){
-    Rcpp::stop("'m' must be positive");
-  }
-  if(m > phi_i(0,0).n_rows){
-    Rcpp::stop("'m' must be less than or equal to the number of clusters in the model");
-  }
-
-  if(rescale == true){
-    if(phi_i(0,0).n_rows > 2){
-      rescale = false;
-      Rcpp::Rcout << "Rescale property cannot be used for K > 2";
-    }
-  }
-  arma::field<arma::cube> phi_samp1(n_MCMC * n_files, 1);
-  for(int i = 0; i < n_MCMC; i++){
-    phi_samp1(i,0) = phi_i(i,0);
-  }
-
-  for(int i = 1; i < n_files; i++){
-    phi_i.load(dir + "Phi" + std::to_string(i) +".txt");
-    for(int j = 0; j < n_MCMC; j++){
-      phi_samp1((i * n_MCMC) + j, 0) = phi_i(j,0);
-    }
-  }
-
-  arma::field<arma::cube> phi_samp(std::round((n_MCMC * n_files) * (1 - burnin_prop)), 1);
-  for(int i = 0; i < std::round((n_MCMC * n_files) * (1 - burnin_prop)); i++){
-    phi_samp(i,0) = phi_samp1(i + std::round((n_MCMC * n_files) * burnin_prop), 0);
-  }
-
-  // Make spline basis 1
-  splines2::BSpline bspline1;
-  bspline1 = splines2::BSpline(time1, internal_knots, basis_degree,
-                               boundary_knots);
-  // Get Basis matrix (time1 x Phi.n_cols)
-  arma::mat bspline_mat1{bspline1.basis(true)};
-  // Make B_obs
-  arma::mat B1 = bspline_mat1;
-
-  // Make spline basis 2
-  splines2::BSpline bspline2;
-  bspline2 = splines2::BSpline(time2, internal_knots, basis_degree,
-                               boundary_knots);
-  // Get Basis matrix (time2 x Phi.n_cols)
-  arma::mat bspline_mat2{bspline2.basis(true)};
-  // Make B_obs
-  arma::mat B2 = bspline_mat2;
-
-  // Initialize placeholders
-  arma::mat CI_Upper = arma::zeros(time1.n_elem, time2.n_elem);
-  arma::mat CI_50 = arma::zeros(time1.n_elem, time2.n_elem);
-  arma::mat CI_Lower = arma::zeros(time2.n_elem, time2.n_elem);
-  arma::cube cov_samp = arma::zeros(time1.n_elem, time2.n_elem, std::round((n_MCMC * n_files) * (1 - burnin_prop)));
-
-  if(simultaneous == false){
-    if(rescale == true){
-      // Get Z matrix
-      arma::cube Z_i;
-      Z_i.load(dir + "Z0.txt");
-      arma::cube Z_samp1 = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-      Z_samp1.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-      for(int i = 1; i < n_files; i++){
-        Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-        Z_samp1.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-      }
-
-      arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols,
-                                      std::round((Z_i.n_slices * n_files)* (1 - burnin_prop)));
-      Z_samp = Z_samp1.subcube(0, 0, std::round(Z_i.n_slices * n_files * burnin_prop),
-                               Z_samp1.n_rows-1, Z_samp1.n_cols-1, Z_samp1.n_slices-1);
-      // rescale Z and Phi
-      arma::mat transform_mat;
-      arma::vec ph = arma::zeros(Z_samp.n_rows);
-      for(int j = 0; j < Z_samp.n_slices; j++){
-        transform_mat = arma::zeros(Z_samp.n_cols, Z_samp.n_cols);
-        int max_ind = 0;
-        for(int i = 0; i < Z_samp.n_cols; i++){
-          for(int a = 0; a < Z_samp.n_rows; a++){
-            ph(a) = Z_samp(a,i,j);
-          }
-          max_ind = arma::index_max(ph);
-          transform_mat.row(i) = Z_samp.slice(j).row(max_ind);
-        }
-        for(int b = 0; b < phi_samp(j,0).n_slices; b++){
-          phi_samp(j,0).slice(b) = transform_mat * phi_samp(j,0).slice(b);
-        }
-      }
-    }
-    for(int i = 0; i < std::round((n_MCMC * n_files) * (1 - burnin_prop)); i++){
-      for(int j = 0; j < phi_samp(i,0).n_slices; j++){
-        cov_samp.slice(i) = cov_samp.slice(i) + (B1 * (phi_samp(i,0).slice(j).row(l-1)).t() *
-          (B2 * phi_samp(i,0).slice(j).row(m-1).t()).t());
-      }
-    }
-
-    arma::vec p = {alpha/2, 0.5, 1 - (alpha/2)};
-    arma::vec q = arma::zeros(3);
-
-    arma::vec ph1 = arma::zeros(cov_samp.n_slices);
-    for(int i = 0; i < time1.n_elem; i++){
-      for(int j = 0; j < time2.n_elem; j++){
-        ph1 = cov_samp(arma::span(i), arma::span(j), arma::span::all);
-        q = arma::quantile(ph1, p);
-        CI_Upper(i,j) = q(2);
-        CI_50(i,j) = q(1);
-        CI_Lower(i,j) = q(0);
-      }
-    }
-  }else{
-    if(rescale == true){
-      // Get Z matrix
-      arma::cube Z_i;
-      Z_i.load(dir + "Z0.txt");
-      arma::cube Z_samp1 = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-      Z_samp1.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-      for(int i = 1; i < n_files; i++){
-        Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-        Z_samp1.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-      }
-
-      arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols,
-                                      std::round((Z_i.n_slices * n_files)* (1 - burnin_prop)));
-      Z_samp = Z_samp1.subcube(0, 0, std::round(Z_i.n_slices * n_files * burnin_prop),
-                               Z_samp1.n_rows-1, Z_samp1.n_cols-1, Z_samp1.n_slices-1);
-      // rescale Z and Phi
-      arma::mat transform_mat;
-      arma::vec ph = arma::zeros(Z_samp.n_rows);
-      for(int j = 0; j < Z_samp.n_slices; j++){
-        transform_mat = arma::zeros(Z_samp.n_cols, Z_samp.n_cols);
-        int max_ind = 0;
-        for(int i = 0; i < Z_samp.n_cols; i++){
-          for(int a = 0; a < Z_samp.n_rows; a++){
-            ph(a) = Z_samp(a,i,j);
-          }
-          max_ind = arma::index_max(ph);
-          transform_mat.row(i) = Z_samp.slice(j).row(max_ind);
-        }
-        for(int b = 0; b < phi_samp(j,0).n_slices; b++){
-          phi_samp(j,0).slice(b) = transform_mat * phi_samp(j,0).slice(b);
-        }
-      }
-    }
-    for(int i = 0; i < std::round((n_MCMC * n_files) * (1 - burnin_prop)); i++){
-      for(int j = 0; j < phi_samp(i,0).n_slices; j++){
-        cov_samp.slice(i) = cov_samp.slice(i) + (B1 * (phi_samp(i,0).slice(j).row(l-1)).t() *
-          (B2 * (phi_samp(i,0).slice(j).row(m-1)).t()).t());
-      }
-    }
-
-    arma::mat cov_mean = arma::mean(cov_samp, 2);
-    arma::mat cov_sd = arma::zeros(time1.n_elem, time2.n_elem);
-    arma::vec ph2 = arma::zeros(cov_samp.n_slices);
-    for(int i = 0; i < time1.n_elem; i++){
-      for(int j = 0; j < time2.n_elem; j++){
-        ph2 = cov_samp(arma::span(i), arma::span(j), arma::span::all);
-        cov_sd(i,j) = arma::stddev(ph2);
-      }
-    }
-
-    arma::vec C = arma::zeros(cov_samp.n_slices);
-    arma::mat ph1 = arma::zeros(time1.n_elem, time2.n_elem);
-    for(int i = 0; i < cov_samp.n_slices; i++){
-      for(int j = 0; j < time1.n_elem; j++){
-        for(int k = 0; k < time2.n_elem; k++){
-          ph1(j,k) = std::abs((cov_samp(j,k,i) - cov_mean(j,k)) / cov_sd(j,k));
-        }
-      }
-      C(i) = ph1.max();
-    }
-
-    arma::vec p = {1- alpha};
-    arma::vec q = arma::zeros(1);
-    q = arma::quantile(C, p);
-
-    for(int i = 0; i < time1.n_elem; i++){
-      for(int j = 0; j < time2.n_elem; j++){
-        CI_Lower(i,j) = cov_mean(i,j) - q(0) * cov_sd(i,j);
-        CI_50(i,j) = cov_mean(i,j);
-        CI_Upper(i,j) =  cov_mean(i,j) + q(0) * cov_sd(i,j);
-      }
-    }
-  }
-  Rcpp::List CI =  Rcpp::List::create(Rcpp::Named("CI_Upper", CI_Upper),
-                                      Rcpp::Named("CI_50", CI_50),
-                                      Rcpp::Named("CI_Lower", CI_Lower),
-                                      Rcpp::Named("cov_trace", cov_samp));
-  return(CI);
+  BayesFMMM::Posterior post(dir, n_files, basis_degree, boundary_knots,
+                            internal_knots);
+  return post.FCovCI(time1, time2, l, m, alpha, rescale, simultaneous,
+                     burnin_prop);
 }
 
 //' Calculates the credible interval for the covariance (High Dimensional Functional Data)
@@ -1128,7 +626,7 @@ Rcpp::List HDFCovCI(const std::string dir,
 
   // Get Phi Paramters
   arma::field<arma::cube> phi_i;
-  phi_i.load(dir + "Phi0.txt");
+  BayesFMMM::loadSamples(phi_i, dir + "Phi0.txt");
   if(l <= 0){
     Rcpp::stop("'l' must be positive");
   }
@@ -1151,17 +649,7 @@ Rcpp::List HDFCovCI(const std::string dir,
 
 
 
-  arma::field<arma::cube> phi_samp1(n_MCMC * n_files, 1);
-  for(int i = 0; i < n_MCMC; i++){
-    phi_samp1(i,0) = phi_i(i,0);
-  }
-
-  for(int i = 1; i < n_files; i++){
-    phi_i.load(dir + "Phi" + std::to_string(i) +".txt");
-    for(int j = 0; j < n_MCMC; j++){
-      phi_samp1((i * n_MCMC) + j, 0) = phi_i(j,0);
-    }
-  }
+  arma::field<arma::cube> phi_samp1 = BayesFMMM::loadFieldSamples(dir, "Phi", n_files, n_MCMC);
 
   arma::field<arma::cube> phi_samp(std::round((n_MCMC * n_files) * (1 - burnin_prop)), 1);
   for(int i = 0; i < std::round((n_MCMC * n_files) * (1 - burnin_prop)); i++){
@@ -1178,144 +666,59 @@ Rcpp::List HDFCovCI(const std::string dir,
   // Make spline basis 2
   arma::field<arma::mat> time2field(1,1);
   time2field(0,0) = time2;
-  arma::field<arma::mat> B_obs2 = BayesFMMM::TensorBSpline(time1field, 1, basis_degree,
+  arma::field<arma::mat> B_obs2 = BayesFMMM::TensorBSpline(time2field, 1, basis_degree,
                                                           boundary_knots, internal_knots);
   arma::mat B2 = B_obs2(0,0);
 
-  // Initialize placeholders
-  arma::mat CI_Upper = arma::zeros(time1.n_rows, time2.n_rows);
-  arma::mat CI_50 = arma::zeros(time1.n_rows, time2.n_rows);
-  arma::mat CI_Lower = arma::zeros(time2.n_rows, time2.n_rows);
   arma::cube cov_samp = arma::zeros(time1.n_rows, time2.n_rows, std::round((n_MCMC * n_files) * (1 - burnin_prop)));
 
-  if(simultaneous == false){
-    if(rescale == true){
-      // Get Z matrix
-      arma::cube Z_i;
-      Z_i.load(dir + "Z0.txt");
-      arma::cube Z_samp1 = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-      Z_samp1.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-      for(int i = 1; i < n_files; i++){
-        Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-        Z_samp1.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-      }
-
-      arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols,
-                                      std::round((Z_i.n_slices * n_files)* (1 - burnin_prop)));
-      Z_samp = Z_samp1.subcube(0, 0, std::round(Z_i.n_slices * n_files * burnin_prop),
-                               Z_samp1.n_rows-1, Z_samp1.n_cols-1, Z_samp1.n_slices-1);
-      // rescale Z and Phi
-      arma::mat transform_mat;
-      arma::vec ph = arma::zeros(Z_samp.n_rows);
-      for(int j = 0; j < Z_samp.n_slices; j++){
-        transform_mat = arma::zeros(Z_samp.n_cols, Z_samp.n_cols);
-        int max_ind = 0;
-        for(int i = 0; i < Z_samp.n_cols; i++){
-          for(int a = 0; a < Z_samp.n_rows; a++){
-            ph(a) = Z_samp(a,i,j);
-          }
-          max_ind = arma::index_max(ph);
-          transform_mat.row(i) = Z_samp.slice(j).row(max_ind);
-        }
-        for(int b = 0; b < phi_samp(j,0).n_slices; b++){
-          phi_samp(j,0).slice(b) = transform_mat * phi_samp(j,0).slice(b);
-        }
-      }
-    }
-    for(int i = 0; i < std::round((n_MCMC * n_files) * (1 - burnin_prop)); i++){
-      for(int j = 0; j < phi_samp(i,0).n_slices; j++){
-        cov_samp.slice(i) = cov_samp.slice(i) + (B1 * (phi_samp(i,0).slice(j).row(l-1)).t() *
-          (B2 * phi_samp(i,0).slice(j).row(m-1).t()).t());
-      }
-    }
-
-    arma::vec p = {alpha/2, 0.5, 1 - (alpha/2)};
-    arma::vec q = arma::zeros(3);
-
-    arma::vec ph1 = arma::zeros(cov_samp.n_slices);
-    for(int i = 0; i < time1.n_rows; i++){
-      for(int j = 0; j < time2.n_rows; j++){
-        ph1 = cov_samp(arma::span(i), arma::span(j), arma::span::all);
-        q = arma::quantile(ph1, p);
-        CI_Upper(i,j) = q(2);
-        CI_50(i,j) = q(1);
-        CI_Lower(i,j) = q(0);
-      }
-    }
-  }else{
-    if(rescale == true){
-      // Get Z matrix
-      arma::cube Z_i;
-      Z_i.load(dir + "Z0.txt");
-      arma::cube Z_samp1 = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-      Z_samp1.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-      for(int i = 1; i < n_files; i++){
-        Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-        Z_samp1.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-      }
+  if(rescale == true){
+    // Get Z matrix
+    arma::cube Z_i;
+    BayesFMMM::loadSamples(Z_i, dir + "Z0.txt");
+    arma::cube Z_samp1 = BayesFMMM::loadCubeSamples(dir, "Z", n_files);
 
-      arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols,
-                                      std::round((Z_i.n_slices * n_files)* (1 - burnin_prop)));
-      Z_samp = Z_samp1.subcube(0, 0, std::round(Z_i.n_slices * n_files * burnin_prop),
-                               Z_samp1.n_rows-1, Z_samp1.n_cols-1, Z_samp1.n_slices-1);
-      // rescale Z and Phi
-      arma::mat transform_mat;
-      arma::vec ph = arma::zeros(Z_samp.n_rows);
-      for(int j = 0; j < Z_samp.n_slices; j++){
-        transform_mat = arma::zeros(Z_samp.n_cols, Z_samp.n_cols);
-        int max_ind = 0;
-        for(int i = 0; i < Z_samp.n_cols; i++){
-          for(int a = 0; a < Z_samp.n_rows; a++){
-            ph(a) = Z_samp(a,i,j);
-          }
-          max_ind = arma::index_max(ph);
-          transform_mat.row(i) = Z_samp.slice(j).row(max_ind);
-        }
-        for(int b = 0; b < phi_samp(j,0).n_slices; b++){
-          phi_samp(j,0).slice(b) = transform_mat * phi_samp(j,0).slice(b);
+    arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols,
+                                    std::round((Z_i.n_slices * n_files)* (1 - burnin_prop)));
+    Z_samp = Z_samp1.subcube(0, 0, std::round(Z_i.n_slices * n_files * burnin_prop),
+                             Z_samp1.n_rows-1, Z_samp1.n_cols-1, Z_samp1.n_slices-1);
+    // rescale Z and Phi
+    arma::mat transform_mat;
+    arma::vec ph = arma::zeros(Z_samp.n_rows);
+    for(int j = 0; j < Z_samp.n_slices; j++){
+      transform_mat = arma::zeros(Z_samp.n_cols, Z_samp.n_cols);
+      int max_ind = 0;
+      for(int i = 0; i < Z_samp.n_cols; i++){
+        for(int a = 0; a < Z_samp.n_rows; a++){
+          ph(a) = Z_samp(a,i,j);
         }
+        max_ind = arma::index_max(ph);
+        transform_mat.row(i) = Z_samp.slice(j).row(max_ind);
       }
-    }
-    for(int i = 0; i < std::round((n_MCMC * n_files) * (1 - burnin_prop)); i++){
-      for(int j = 0; j < phi_samp(i,0).n_slices; j++){
-        cov_samp.slice(i) = cov_samp.slice(i) + (B1 * (phi_samp(i,0).slice(j).row(l-1)).t() *
-          (B2 * (phi_samp(i,0).slice(j).row(m-1)).t()).t());
-      }
-    }
-
-    arma::mat cov_mean = arma::mean(cov_samp, 2);
-    arma::mat cov_sd = arma::zeros(time1.n_rows, time2.n_rows);
-    arma::vec ph2 = arma::zeros(cov_samp.n_slices);
-    for(int i = 0; i < time1.n_rows; i++){
-      for(int j = 0; j < time2.n_rows; j++){
-        ph2 = cov_samp(arma::span(i), arma::span(j), arma::span::all);
-        cov_sd(i,j) = arma::stddev(ph2);
+      for(int b = 0; b < phi_samp(j,0).n_slices; b++){
+        phi_samp(j,0).slice(b) = transform_mat * phi_samp(j,0).slice(b);
       }
     }
-
-    arma::vec C = arma::zeros(cov_samp.n_slices);
-    arma::mat ph1 = arma::zeros(time1.n_rows, time2.n_rows);
-    for(int i = 0; i < cov_samp.n_slices; i++){
-      for(int j = 0; j < time1.n_rows; j++){
-        for(int k = 0; k < time2.n_rows; k++){
-          ph1(j,k) = std::abs((cov_samp(j,k,i) - cov_mean(j,k)) / cov_sd(j,k));
-        }
-      }
-      C(i) = ph1.max();
+  }
+  for(int i = 0; i < std::round((n_MCMC * n_files) * (1 - burnin_prop)); i++){
+    for(int j = 0; j < phi_samp(i,0).n_slices; j++){
+      cov_samp.slice(i) = cov_samp.slice(i) + (B1 * (phi_samp(i,0).slice(j).row(l-1)).t() *
+        (B2 * phi_samp(i,0).slice(j).row(m-1).t()).t());
     }
+  }
 
-    arma::vec p = {1- alpha};
-    arma::vec q = arma::zeros(1);
-    q = arma::quantile(C, p);
+  // view the draws as a (cells x samples) matrix without copying
+  const arma::mat cov_draws(cov_samp.memptr(), time1.n_rows * time2.n_rows,
+                            cov_samp.n_slices, false, true);
+  arma::vec CI_Upper_vec;
+  arma::vec CI_50_vec;
+  arma::vec CI_Lower_vec;
+  BayesFMMM::calcRowCI(cov_draws, alpha, simultaneous, CI_Lower_vec, CI_50_vec,
+                       CI_Upper_vec);
+  arma::mat CI_Upper = arma::reshape(CI_Upper_vec, time1.n_rows, time2.n_rows);
+  arma::mat CI_50 = arma::reshape(CI_50_vec, time1.n_rows, time2.n_rows);
+  arma::mat CI_Lower = arma::reshape(CI_Lower_vec, time1.n_rows, time2.n_rows);
 
-    for(int i = 0; i < time1.n_rows; i++){
-      for(int j = 0; j < time2.n_rows; j++){
-        CI_Lower(i,j) = cov_mean(i,j) - q(0) * cov_sd(i,j);
-        CI_50(i,j) = cov_mean(i,j);
-        CI_Upper(i,j) =  cov_mean(i,j) + q(0) * cov_sd(i,j);
-      }
-    }
-  }
   Rcpp::List CI =  Rcpp::List::create(Rcpp::Named("CI_Upper", CI_Upper),
                                       Rcpp::Named("CI_50", CI_50),
                                       Rcpp::Named("CI_Lower", CI_Lower),
@@ -1399,7 +802,7 @@ Rcpp::List MVCovCI(const std::string dir,
 
   // Get Phi Paramters
   arma::field<arma::cube> phi_i;
-  phi_i.load(dir + "Phi0.txt");
+  BayesFMMM::loadSamples(phi_i, dir + "Phi0.txt");
   if(l <= 0){
     Rcpp::stop("'l' must be positive");
   }
@@ -1418,17 +821,7 @@ Rcpp::List MVCovCI(const std::string dir,
       Rcpp::Rcout << "Rescale property cannot be used for K > 2";
     }
   }
-  arma::field<arma::cube> phi_samp1(n_MCMC * n_files, 1);
-  for(int i = 0; i < n_MCMC; i++){
-    phi_samp1(i,0) = phi_i(i,0);
-  }
-
-  for(int i = 1; i < n_files; i++){
-    phi_i.load(dir + "Phi" + std::to_string(i) +".txt");
-    for(int j = 0; j < n_MCMC; j++){
-      phi_samp1((i * n_MCMC) + j, 0) = phi_i(j,0);
-    }
-  }
+  arma::field<arma::cube> phi_samp1 = BayesFMMM::loadFieldSamples(dir, "Phi", n_files, n_MCMC);
 
   arma::field<arma::cube> phi_samp(std::round((n_MCMC * n_files) * (1 - burnin_prop)), 1);
   for(int i = 0; i < std::round((n_MCMC * n_files) * (1 - burnin_prop)); i++){
@@ -1444,13 +837,8 @@ Rcpp::List MVCovCI(const std::string dir,
   if(rescale == true){
     // Get Z matrix
     arma::cube Z_i;
-    Z_i.load(dir + "Z0.txt");
-    arma::cube Z_samp1 = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-    Z_samp1.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-    for(int i = 1; i < n_files; i++){
-      Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-      Z_samp1.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-    }
+    BayesFMMM::loadSamples(Z_i, dir + "Z0.txt");
+    arma::cube Z_samp1 = BayesFMMM::loadCubeSamples(dir, "Z", n_files);
     arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols,
                                     std::round((Z_i.n_slices * n_files)* (1 - burnin_prop)));
     Z_samp = Z_samp1.subcube(0, 0, std::round(Z_i.n_slices * n_files * burnin_prop),
@@ -1483,19 +871,14 @@ Rcpp::List MVCovCI(const std::string dir,
     }
   }
 
+  // quantiles of each cell (viewed as a cells x samples matrix)
   arma::vec p = {alpha/2, 0.5, 1 - (alpha/2)};
-  arma::vec q = arma::zeros(3);
-
-  arma::vec ph1 = arma::zeros(cov_samp.n_slices);
-  for(int i = 0; i < phi_i(0,0).n_cols; i++){
-    for(int j = 0; j < phi_i(0,0).n_cols; j++){
-      ph1 = cov_samp(arma::span(i), arma::span(j), arma::span::all);
-      q = arma::quantile(ph1, p);
-      CI_Upper(i,j) = q(2);
-      CI_50(i,j) = q(1);
-      CI_Lower(i,j) = q(0);
-    }
-  }
+  const arma::mat cov_draws(cov_samp.memptr(), cov_samp.n_rows * cov_samp.n_cols,
+                            cov_samp.n_slices, false, true);
+  arma::mat q = BayesFMMM::calcRowQuantiles(cov_draws, p);
+  CI_Lower = arma::reshape(q.col(0), cov_samp.n_rows, cov_samp.n_cols);
+  CI_50 = arma::reshape(q.col(1), cov_samp.n_rows, cov_samp.n_cols);
+  CI_Upper = arma::reshape(q.col(2), cov_samp.n_rows, cov_samp.n_cols);
 
   Rcpp::List CI =  Rcpp::List::create(Rcpp::Named("CI_Upper", CI_Upper),
                                       Rcpp::Named("CI_50", CI_50),
@@ -1542,29 +925,9 @@ Rcpp::List SigmaCI(const std::string dir,
     Rcpp::stop("'alpha' must be between 0 and 1");
   }
 
-  arma::vec sigma_i;
-  sigma_i.load(dir + "Sigma0.txt");
-  arma::vec sigma_samp = arma::zeros(sigma_i.n_elem * n_files);
-  sigma_samp.subvec(0, sigma_i.n_elem - 1) = sigma_i;
-  for(int i = 1; i < n_files; i++){
-    sigma_i.load(dir + "Sigma" + std::to_string(i) +".txt");
-    sigma_samp.subvec(sigma_i.n_elem *i, (sigma_i.n_elem *(i + 1)) - 1) = sigma_i;
-  }
-
-  arma::vec p = {alpha/2, 0.5, 1 - (alpha/2)};
-  arma::vec q = arma::zeros(3);
-  q = arma::quantile(sigma_samp, p);
-
-  double CI_Upper = q(2);
-  double CI_50 = q(1);
-  double CI_Lower = q(1);
-
-  Rcpp::List CI =  Rcpp::List::create(Rcpp::Named("CI_Upper", CI_Upper),
-                                      Rcpp::Named("CI_50", CI_50),
-                                      Rcpp::Named("CI_Lower", CI_Lower));
-
-  return(CI);
-}
+  BayesFMMM::Posterior post(dir, n_files);
+  return post.SigmaCI(alpha);
+}
 
 //' Calculates the credible interval for membership parameters Z
 //'
@@ -1586,65 +949,8 @@ Rcpp::List ZCI(const std::string dir,
                const double alpha = 0.05,
                bool rescale = true,
                const double burnin_prop = 0.1){
-  arma::cube Z_i;
-  Z_i.load(dir + "Z0.txt");
-  arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-  Z_samp.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-
-  if(rescale == true){
-    if(Z_samp.n_cols > 2){
-      rescale = false;
-      Rcpp::Rcout << "Rescale property cannot be used for K > 2";
-    }
-  }
-
-  for(int i = 1; i < n_files; i++){
-    Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-    Z_samp.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-  }
-  if(rescale == true){
-    arma::mat transform_mat;
-    arma::vec ph = arma::zeros(Z_samp.n_rows);
-    for(int j = 0; j < Z_samp.n_slices; j++){
-      transform_mat = arma::zeros(Z_samp.n_cols, Z_samp.n_cols);
-      int max_ind = 0;
-      for(int i = 0; i < Z_samp.n_cols; i++){
-        for(int k = 0; k < Z_samp.n_rows; k++){
-          ph(k) = Z_samp(k,i,j);
-        }
-        max_ind = arma::index_max(ph);
-        transform_mat.row(i) = Z_samp.slice(j).row(max_ind);
-      }
-      //Z_samp.slice(j) =  Z_samp.slice(j) * arma::inv(transform_mat);
-      Z_samp.slice(j) =  arma::solve(transform_mat.t(), Z_samp.slice(j).t(), arma::solve_opts::no_approx).t();
-    }
-  }
-
-  arma::vec p = {alpha/2, 0.5, 1 - (alpha/2)};
-  arma::vec q = arma::zeros(3);
-
-  arma::mat CI_Upper = arma::zeros(Z_i.n_rows, Z_i.n_cols);
-  arma::mat CI_50 = arma::zeros(Z_i.n_rows, Z_i.n_cols);
-  arma::mat CI_Lower = arma::zeros(Z_i.n_rows, Z_i.n_cols);
-
-  arma::vec ph(std::round(Z_samp.n_slices * (1 - burnin_prop)), arma::fill::zeros);
-  for(int i = 0; i < Z_i.n_rows; i++){
-    for(int j = 0; j < Z_i.n_cols; j++){
-      for(int l = 0; l < std::round(Z_samp.n_slices * (1 - burnin_prop)); l++){
-        ph(l) = Z_samp(i,j, l + std::round(Z_samp.n_slices * burnin_prop));
-      }
-      q = arma::quantile(ph, p);
-      CI_Upper(i,j) = q(2);
-      CI_50(i,j) = q(1);
-      CI_Lower(i,j) = q(0);
-    }
-  }
-
-  Rcpp::List CI =  Rcpp::List::create(Rcpp::Named("CI_Upper", CI_Upper),
-                                      Rcpp::Named("CI_50", CI_50),
-                                      Rcpp::Named("CI_Lower", CI_Lower));
-
-  return(CI);
+  BayesFMMM::Posterior post(dir, n_files);
+  return post.ZCI(alpha, rescale, burnin_prop);
 }
 
 //' Calculates the DIC of a functional model
@@ -1689,99 +995,183 @@ double Model_DIC(const std::string dir,
     Rcpp::stop("'burnin_prop' must be between 0 and 1");
   }
 
-  // Get Nu parameters
-  arma::cube nu_i;
-  nu_i.load(dir + "Nu0.txt");
-  arma::cube nu_samp = arma::zeros(nu_i.n_rows, nu_i.n_cols, nu_i.n_slices * n_files);
-  nu_samp.subcube(0, 0, 0, nu_i.n_rows-1, nu_i.n_cols-1, nu_i.n_slices-1) = nu_i;
-  for(int i = 1; i < n_files; i++){
-    nu_i.load(dir + "Nu" + std::to_string(i) +".txt");
-    nu_samp.subcube(0, 0,  nu_i.n_slices*i, nu_i.n_rows-1, nu_i.n_cols-1,
-                    (nu_i.n_slices)*(i+1) - 1) = nu_i;
-  }
+  BayesFMMM::Posterior post(dir, n_files, basis_degree, boundary_knots,
+                            internal_knots);
+  return post.DIC(time, Y, burnin_prop);
+}
 
-  // Get Phi parameters
-  arma::field<arma::cube> phi_i;
-  phi_i.load(dir + "Phi0.txt");
-  arma::field<arma::cube> phi_samp(n_MCMC * n_files, 1);
-  for(int i = 0; i < n_MCMC; i++){
-    phi_samp(i,0) = phi_i(i,0);
+//' Calculates the DIC, WAIC and PSIS-LOO of a functional model
+//'
+//' Computes the pointwise log-likelihood of every observed time point once and
+//' derives the deviance information criterion (DIC), the widely applicable
+//' information criterion (WAIC) and the Pareto smoothed importance sampling
+//' leave-one-out information criterion (LOOIC) from it. Observations are
+//' processed in parallel when the package is compiled with OpenMP support.
+//'
+//' @name Model_IC
+//' @param dir String containing the directory where the MCMC files are located
+//' @param n_files Int containing the number of files per parameter
+//' @param n_MCMC Int containing the number of saved MCMC iterations per file
+//' @param basis_degree Int containing the degree of B-splines used
+//' @param boundary_knots Vector containing the boundary points of our index domain of interest
+//' @param internal_knots Vector location of internal knots for B-splines
+//' @param time Field of vectors containing time points at which the function was observed
+//' @param Y Field of vectors containing observed values of the function
+//' @param burnin_prop Double containing proportion of MCMC samples to discard
+//' @returns IC List containing:
+//' \describe{
+//'   \item{\code{DIC}}{Double containing DIC value}
+//'   \item{\code{WAIC}}{Double containing WAIC value}
+//'   \item{\code{p_waic}}{Double containing the effective number of parameters used in WAIC}
+//'   \item{\code{LOOIC}}{Double containing PSIS-LOO information criterion}
+//'   \item{\code{elpd_loo}}{Double containing the expected log pointwise predictive density estimated by PSIS-LOO}
+//'   \item{\code{p_loo}}{Double containing the effective number of parameters estimated by PSIS-LOO}
+//'   \item{\code{lppd}}{Double containing the log pointwise predictive density}
+//'   \item{\code{pareto_k}}{Vector containing the estimated Pareto shape parameter of each observed time point}
+//' }
+//'
+//' @section Warning:
+//' The following must be true:
+//' \describe{
+//'   \item{\code{basis_degree}}{must be an integer larger than or equal to 1}
+//'   \item{\code{internal_knots}}{must lie in the range of \code{boundary_knots}}
+//'   \item{\code{burnin_prop}}{must be between 0 and 1}
+//' }
+//' @export
+// [[Rcpp::export]]
+Rcpp::List Model_IC(const std::string dir,
+                    const int n_files,
+                    const int n_MCMC,
+                    const int basis_degree,
+                    const arma::vec boundary_knots,
+                    const arma::vec internal_knots,
+                    const arma::field<arma::vec> time,
+                    const arma::field<arma::vec> Y,
+                    const double burnin_prop = 0.2){
+  if(basis_degree <  1){
+    Rcpp::stop("'basis_degree' must be an integer greater than or equal to 1");
   }
-
-  for(int i = 1; i < n_files; i++){
-    phi_i.load(dir + "Phi" + std::to_string(i) +".txt");
-    for(int j = 0; j < n_MCMC; j++){
-      phi_samp((i * n_MCMC) + j, 0) = phi_i(j,0);
+  for(int i = 0; i < internal_knots.n_elem; i++){
+    if(boundary_knots(0) >= internal_knots(i)){
+      Rcpp::stop("at least one element in 'internal_knots' is less than or equal to first boundary knot");
+    }
+    if(boundary_knots(1) <= internal_knots(i)){
+      Rcpp::stop("at least one element in 'internal_knots' is more than or equal to second boundary knot");
     }
   }
-
-  // Get Z parameters
-  arma::cube Z_i;
-  Z_i.load(dir + "Z0.txt");
-  arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-  Z_samp.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-  for(int i = 1; i < n_files; i++){
-    Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-    Z_samp.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
+  if(burnin_prop < 0){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
   }
-
-  // Get sigma parameters
-  arma::vec sigma_i;
-  sigma_i.load(dir + "Sigma0.txt");
-  arma::vec sigma_samp = arma::zeros(sigma_i.n_elem * n_files);
-  sigma_samp.subvec(0, sigma_i.n_elem - 1) = sigma_i;
-  for(int i = 1; i < n_files; i++){
-    sigma_i.load(dir + "Sigma" + std::to_string(i) +".txt");
-    sigma_samp.subvec(sigma_i.n_elem *i, (sigma_i.n_elem *(i + 1)) - 1) = sigma_i;
+  if(burnin_prop >= 1){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
   }
 
-  // Get chi parameters
-  arma::cube chi_i;
-  chi_i.load(dir + "Chi0.txt");
-  arma::cube chi_samp = arma::zeros(chi_i.n_rows, chi_i.n_cols, chi_i.n_slices * n_files);
-  chi_samp.subcube(0, 0, 0, chi_i.n_rows-1, chi_i.n_cols-1, chi_i.n_slices-1) = chi_i;
-  for(int i = 1; i < n_files; i++){
-    chi_i.load(dir + "Chi" + std::to_string(i) +".txt");
-    chi_samp.subcube(0, 0,  chi_i.n_slices*i, chi_i.n_rows-1, chi_i.n_cols-1,
-                     (chi_i.n_slices)*(i+1) - 1) = chi_i;
-  }
-
-  // Make spline basis
-  arma::field<arma::mat> B_obs(Z_samp.n_rows, 1);
-  splines2::BSpline bspline2;
-  for(int i = 0; i < Z_samp.n_rows; i++){
-    bspline2 = splines2::BSpline(time(i,0),  internal_knots, basis_degree,
-                                 boundary_knots);
-    // Get Basis matrix (time2 x Phi.n_cols)
-    arma::mat bspline_mat2{bspline2.basis(true)};
-    // Make B_obs
-    B_obs(i,0) = bspline_mat2;
-  }
+  BayesFMMM::Posterior post(dir, n_files, basis_degree, boundary_knots,
+                            internal_knots);
+  return post.IC(time, Y, burnin_prop);
+}
 
-  double expected_log_f = 0;
-  for(int i = std::round(burnin_prop *nu_samp.n_slices) ; i < nu_samp.n_slices; i++){
-    expected_log_f = expected_log_f + BayesFMMM::calcLikelihood(Y, B_obs, nu_samp.slice(i),
-                                                                phi_samp(i,0), Z_samp.slice(i),
-                                                                chi_samp.slice(i), sigma_samp(i));
+//' Samples the memberships and scores of new functions given a fitted model
+//'
+//' Scores functions that were not used to fit the model. For each saved MCMC
+//' iteration after the burn-in, the memberships (Z) and scores (chi) of every
+//' new function are sampled from their conditional distributions given the
+//' population level parameters (nu, Phi, pi, alpha_3 and sigma) of that
+//' iteration. A single chain is run for each new function across the saved
+//' iterations, and new functions are processed in parallel when the package is
+//' compiled with OpenMP support.
+//'
+//' @name Model_ScoreMembership
+//' @param dir String containing the directory where the MCMC files are located
+//' @param n_files Int containing the number of files per parameter
+//' @param basis_degree Int containing the degree of B-splines used
+//' @param boundary_knots Vector containing the boundary points of our index domain of interest
+//' @param internal_knots Vector location of internal knots for B-splines
+//' @param time Field of vectors containing time points at which the new functions were observed
+//' @param Y Field of vectors containing observed values of the new functions
+//' @param alpha Double specifying the percentile of the credible interval
+//' @param burnin_prop Double containing proportion of MCMC samples to discard
+//' @param n_iter Int containing the number of sweeps per saved MCMC iteration
+//' @param n_warmup Int containing the number of sweeps before the first saved MCMC iteration is used
+//' @param a_Z_PM Double containing hyperparameter of the proposal distribution of Z
+//' @param return_draws Boolean indicating whether the draws of Z and chi should be returned
+//' @returns scores List containing:
+//' \describe{
+//'   \item{\code{Z_mean}}{Matrix containing the posterior mean of the memberships of the new functions}
+//'   \item{\code{Z_CI}}{List containing the upper, median, and lower credible values of the memberships (see \code{ZCI})}
+//'   \item{\code{chi_mean}}{Matrix containing the posterior mean of the scores of the new functions}
+//'   \item{\code{acceptance}}{Vector containing the acceptance rate of the memberships of each new function}
+//'   \item{\code{Z}}{Cube containing the draws of the memberships (only if \code{return_draws = TRUE})}
+//'   \item{\code{chi}}{Cube containing the draws of the scores (only if \code{return_draws = TRUE})}
+//' }
+//'
+//' @section Warning:
+//' The following must be true:
+//' \describe{
+//'   \item{\code{basis_degree}}{must be an integer larger than or equal to 1}
+//'   \item{\code{internal_knots}}{must lie in the range of \code{boundary_knots}}
+//'   \item{\code{Y}}{must have the same length as \code{time}}
+//'   \item{\code{alpha}}{must be between 0 and 1}
+//'   \item{\code{burnin_prop}}{must be between 0 and 1}
+//'   \item{\code{n_iter}}{must be an integer larger than or equal to 1}
+//'   \item{\code{n_warmup}}{must be an integer larger than or equal to 0}
+//'   \item{\code{a_Z_PM}}{must be positive}
+//' }
+//' @export
+// [[Rcpp::export]]
+Rcpp::List Model_ScoreMembership(const std::string dir,
+                                 const int n_files,
+                                 const int basis_degree,
+                                 const arma::vec boundary_knots,
+                                 const arma::vec internal_knots,
+                                 const arma::field<arma::vec> time,
+                                 const arma::field<arma::vec> Y,
+                                 const double alpha = 0.05,
+                                 const double burnin_prop = 0.2,
+                                 const int n_iter = 1,
+                                 const int n_warmup = 50,
+                                 const double a_Z_PM = 1000,
+                                 const bool return_draws = false){
+  if(basis_degree <  1){
+    Rcpp::stop("'basis_degree' must be an integer greater than or equal to 1");
   }
-  expected_log_f = expected_log_f / std::round((1-burnin_prop) *nu_samp.n_slices);
-
-  double f_hat = 0;
-  double f_hat_ij = 0;
-  for(int i = 0; i < Z_samp.n_rows; i++){
-    for(int j = 0; j < time(i,0).n_elem; j++){
-      f_hat_ij = 0;
-      for(int n = std::round(burnin_prop *nu_samp.n_slices); n < nu_samp.n_slices; n++){
-        f_hat_ij = f_hat_ij + BayesFMMM::calcDIC2(Y(i,0), B_obs(i,0), nu_samp.slice(n), phi_samp(n,0),
-                                                  Z_samp.slice(n), chi_samp.slice(n), i, j,
-                                                  sigma_samp(n));
-      }
-      f_hat = f_hat + std::log(f_hat_ij / std::round((1-burnin_prop) *nu_samp.n_slices));
+  for(int i = 0; i < internal_knots.n_elem; i++){
+    if(boundary_knots(0) >= internal_knots(i)){
+      Rcpp::stop("at least one element in 'internal_knots' is less than or equal to first boundary knot");
+    }
+    if(boundary_knots(1) <= internal_knots(i)){
+      Rcpp::stop("at least one element in 'internal_knots' is more than or equal to second boundary knot");
     }
   }
+  if(Y.n_elem != time.n_elem){
+    Rcpp::stop("'Y' must have the same length as 'time'");
+  }
+  if(alpha <= 0){
+    Rcpp::stop("'alpha' must be between 0 and 1");
+  }
+  if(alpha >= 1){
+    Rcpp::stop("'alpha' must be between 0 and 1");
+  }
+  if(burnin_prop < 0){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  if(burnin_prop >= 1){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  if(n_iter < 1){
+    Rcpp::stop("'n_iter' must be an integer greater than or equal to 1");
+  }
+  if(n_warmup < 0){
+    Rcpp::stop("'n_warmup' must be an integer greater than or equal to 0");
+  }
+  if(a_Z_PM <= 0){
+    Rcpp::stop("'a_Z_PM' must be positive");
+  }
 
-  double DIC = (2 * f_hat) - (4 * expected_log_f);
-  return(DIC);
+  BayesFMMM::Posterior post(dir, n_files, basis_degree, boundary_knots,
+                            internal_knots);
+  return post.ScoreMembership(time, Y, alpha, burnin_prop, n_iter, n_warmup,
+                              a_Z_PM, return_draws);
 }
 
 //' Calculates the AIC of a functional model
@@ -1827,113 +1217,9 @@ double Model_AIC(const std::string dir,
     Rcpp::stop("'burnin_prop' must be between 0 and 1");
   }
 
-  // Get Nu parameters
-  arma::cube nu_i;
-  nu_i.load(dir + "Nu0.txt");
-  arma::cube nu_samp = arma::zeros(nu_i.n_rows, nu_i.n_cols, nu_i.n_slices * n_files);
-  nu_samp.subcube(0, 0, 0, nu_i.n_rows-1, nu_i.n_cols-1, nu_i.n_slices-1) = nu_i;
-  for(int i = 1; i < n_files; i++){
-    nu_i.load(dir + "Nu" + std::to_string(i) +".txt");
-    nu_samp.subcube(0, 0,  nu_i.n_slices*i, nu_i.n_rows-1, nu_i.n_cols-1,
-                    (nu_i.n_slices)*(i+1) - 1) = nu_i;
-  }
-
-  // Get Phi parameters
-  arma::field<arma::cube> phi_i;
-  phi_i.load(dir + "Phi0.txt");
-  arma::field<arma::cube> phi_samp(n_MCMC * n_files, 1);
-  for(int i = 0; i < n_MCMC; i++){
-    phi_samp(i,0) = phi_i(i,0);
-  }
-
-  for(int i = 1; i < n_files; i++){
-    phi_i.load(dir + "Phi" + std::to_string(i) +".txt");
-    for(int j = 0; j < n_MCMC; j++){
-      phi_samp((i * n_MCMC) + j, 0) = phi_i(j,0);
-    }
-  }
-
-  // Get Z parameters
-  arma::cube Z_i;
-  Z_i.load(dir + "Z0.txt");
-  arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-  Z_samp.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-  for(int i = 1; i < n_files; i++){
-    Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-    Z_samp.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-  }
-
-  // Get sigma parameters
-  arma::vec sigma_i;
-  sigma_i.load(dir + "Sigma0.txt");
-  arma::vec sigma_samp = arma::zeros(sigma_i.n_elem * n_files);
-  sigma_samp.subvec(0, sigma_i.n_elem - 1) = sigma_i;
-  for(int i = 1; i < n_files; i++){
-    sigma_i.load(dir + "Sigma" + std::to_string(i) +".txt");
-    sigma_samp.subvec(sigma_i.n_elem *i, (sigma_i.n_elem *(i + 1)) - 1) = sigma_i;
-  }
-
-  // Get chi parameters
-  arma::cube chi_i;
-  chi_i.load(dir + "Chi0.txt");
-  arma::cube chi_samp = arma::zeros(chi_i.n_rows, chi_i.n_cols, chi_i.n_slices * n_files);
-  chi_samp.subcube(0, 0, 0, chi_i.n_rows-1, chi_i.n_cols-1, chi_i.n_slices-1) = chi_i;
-  for(int i = 1; i < n_files; i++){
-    chi_i.load(dir + "Chi" + std::to_string(i) +".txt");
-    chi_samp.subcube(0, 0,  chi_i.n_slices*i, chi_i.n_rows-1, chi_i.n_cols-1,
-                     (chi_i.n_slices)*(i+1) - 1) = chi_i;
-  }
-
-  // Make spline basis
-  arma::field<arma::mat> B_obs(Z_samp.n_rows, 1);
-  splines2::BSpline bspline2;
-  for(int i = 0; i < Z_samp.n_rows; i++){
-    bspline2 = splines2::BSpline(time(i,0),  internal_knots, basis_degree,
-                                 boundary_knots);
-    // Get Basis matrix (time2 x Phi.n_cols)
-    arma::mat bspline_mat2{bspline2.basis(true)};
-    // Make B_obs
-    B_obs(i,0) = bspline_mat2;
-  }
-
-  // Estimate individual curve fit
-  arma::field<arma::mat> curve_fit(Z_i.n_rows, 1);
-  arma::rowvec Z_ph(Z_i.n_cols, arma::fill::zeros);
-  for(int i = 0; i < Z_i.n_rows; i++){
-    curve_fit(i,0) = arma::zeros(std::round((1 - burnin_prop) * sigma_i.n_elem * n_files), Y(i,0).n_elem);
-    for(int j = std::round(burnin_prop * sigma_i.n_elem * n_files); j < sigma_i.n_elem * n_files; j++){
-      Z_ph = Z_samp(arma::span(i), arma::span::all, arma::span(j));
-      curve_fit(i,0).row(j - std::round(burnin_prop * sigma_i.n_elem * n_files)) = Z_ph * nu_samp.slice(j) * B_obs(i,0).t();
-      for(int k = 0; k < chi_samp.n_cols; k++){
-        curve_fit(i,0).row(j - std::round(burnin_prop * sigma_i.n_elem * n_files)) = curve_fit(i,0).row(j - std::round(burnin_prop * sigma_i.n_elem * n_files)) + (chi_samp(i, k, j) *
-          Z_ph * phi_samp(j,0).slice(k) * B_obs(i,0).t());
-      }
-    }
-  }
-
-  // Get mean curve fit
-  arma::field<arma::rowvec> mean_curve_fit(Z_i.n_rows, 1);
-  for(int i = 0; i < Z_i.n_rows; i++){
-    mean_curve_fit(i,0) = arma::mean(curve_fit(i,0), 0);
-  }
-
-  // Get posterior mean of sigma^2
-  double mean_sigma = arma::mean(sigma_samp);
-
-  // Calculate Log likelihood
-  double log_lik = 0;
-  for(int i = 0; i < Z_samp.n_rows; i++){
-    for(int j = 0; j < Y(i,0).n_elem; j++){
-      log_lik = log_lik + R::dnorm(Y(i,0)(j), mean_curve_fit(i,0)(j),
-                                   std::sqrt(mean_sigma), true);
-    }
-  }
-
-  // Calculate AIC
-  double AIC =  2*((Z_samp.n_rows + phi_samp(0,0).n_cols) * Z_samp.n_cols +
-                    2 * phi_samp(0,0).n_cols * phi_samp(0,0).n_slices * phi_samp(0,0).n_rows +
-                    2 + 4 * Z_samp.n_cols + chi_samp.n_rows * chi_samp.n_cols + (phi_samp(0,0).n_slices*Z_samp.n_cols)) - (2 * log_lik);
-  return(AIC);
+  BayesFMMM::Posterior post(dir, n_files, basis_degree, boundary_knots,
+                            internal_knots);
+  return post.AIC(time, Y, burnin_prop);
 }
 
 //' Calculates the BIC of a functional model
@@ -1979,118 +1265,9 @@ double Model_BIC(const std::string dir,
     Rcpp::stop("'burnin_prop' must be between 0 and 1");
   }
 
-  // Get Nu parameters
-  arma::cube nu_i;
-  nu_i.load(dir + "Nu0.txt");
-  arma::cube nu_samp = arma::zeros(nu_i.n_rows, nu_i.n_cols, nu_i.n_slices * n_files);
-  nu_samp.subcube(0, 0, 0, nu_i.n_rows-1, nu_i.n_cols-1, nu_i.n_slices-1) = nu_i;
-  for(int i = 1; i < n_files; i++){
-    nu_i.load(dir + "Nu" + std::to_string(i) +".txt");
-    nu_samp.subcube(0, 0,  nu_i.n_slices*i, nu_i.n_rows-1, nu_i.n_cols-1,
-                    (nu_i.n_slices)*(i+1) - 1) = nu_i;
-  }
-
-  // Get Phi parameters
-  arma::field<arma::cube> phi_i;
-  phi_i.load(dir + "Phi0.txt");
-  arma::field<arma::cube> phi_samp(n_MCMC * n_files, 1);
-  for(int i = 0; i < n_MCMC; i++){
-    phi_samp(i,0) = phi_i(i,0);
-  }
-
-  for(int i = 1; i < n_files; i++){
-    phi_i.load(dir + "Phi" + std::to_string(i) +".txt");
-    for(int j = 0; j < n_MCMC; j++){
-      phi_samp((i * n_MCMC) + j, 0) = phi_i(j,0);
-    }
-  }
-
-  // Get Z parameters
-  arma::cube Z_i;
-  Z_i.load(dir + "Z0.txt");
-  arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-  Z_samp.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-  for(int i = 1; i < n_files; i++){
-    Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-    Z_samp.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-  }
-
-  // Get sigma parameters
-  arma::vec sigma_i;
-  sigma_i.load(dir + "Sigma0.txt");
-  arma::vec sigma_samp = arma::zeros(sigma_i.n_elem * n_files);
-  sigma_samp.subvec(0, sigma_i.n_elem - 1) = sigma_i;
-  for(int i = 1; i < n_files; i++){
-    sigma_i.load(dir + "Sigma" + std::to_string(i) +".txt");
-    sigma_samp.subvec(sigma_i.n_elem *i, (sigma_i.n_elem *(i + 1)) - 1) = sigma_i;
-  }
-
-  // Get chi parameters
-  arma::cube chi_i;
-  chi_i.load(dir + "Chi0.txt");
-  arma::cube chi_samp = arma::zeros(chi_i.n_rows, chi_i.n_cols, chi_i.n_slices * n_files);
-  chi_samp.subcube(0, 0, 0, chi_i.n_rows-1, chi_i.n_cols-1, chi_i.n_slices-1) = chi_i;
-  for(int i = 1; i < n_files; i++){
-    chi_i.load(dir + "Chi" + std::to_string(i) +".txt");
-    chi_samp.subcube(0, 0,  chi_i.n_slices*i, chi_i.n_rows-1, chi_i.n_cols-1,
-                     (chi_i.n_slices)*(i+1) - 1) = chi_i;
-  }
-
-  // Make spline basis
-  arma::field<arma::mat> B_obs(Z_samp.n_rows, 1);
-  splines2::BSpline bspline2;
-  for(int i = 0; i < Z_samp.n_rows; i++){
-    bspline2 = splines2::BSpline(time(i,0),  internal_knots, basis_degree,
-                                 boundary_knots);
-    // Get Basis matrix (time2 x Phi.n_cols)
-    arma::mat bspline_mat2{bspline2.basis(true)};
-    // Make B_obs
-    B_obs(i,0) = bspline_mat2;
-  }
-
-  // Estimate individual curve fit
-  arma::field<arma::mat> curve_fit(Z_i.n_rows, 1);
-  arma::rowvec Z_ph(Z_i.n_cols, arma::fill::zeros);
-  for(int i = 0; i < Z_i.n_rows; i++){
-    curve_fit(i,0) = arma::zeros(std::round((1 - burnin_prop) * sigma_i.n_elem * n_files), Y(i,0).n_elem);
-    for(int j = std::round(burnin_prop * sigma_i.n_elem * n_files); j < sigma_i.n_elem * n_files; j++){
-      Z_ph = Z_samp(arma::span(i), arma::span::all, arma::span(j));
-      curve_fit(i,0).row(j - std::round(burnin_prop * sigma_i.n_elem * n_files)) = Z_ph * nu_samp.slice(j) * B_obs(i,0).t();
-      for(int k = 0; k < chi_samp.n_cols; k++){
-        curve_fit(i,0).row(j - std::round(burnin_prop * sigma_i.n_elem * n_files)) = curve_fit(i,0).row(j - std::round(burnin_prop * sigma_i.n_elem * n_files)) + (chi_samp(i, k, j) *
-          Z_ph * phi_samp(j,0).slice(k) * B_obs(i,0).t());
-      }
-    }
-  }
-
-  // Get mean curve fit
-  arma::field<arma::rowvec> mean_curve_fit(Z_i.n_rows, 1);
-  for(int i = 0; i < Z_i.n_rows; i++){
-    mean_curve_fit(i,0) = arma::mean(curve_fit(i,0), 0);
-  }
-
-  // Get posterior mean of sigma^2
-  double mean_sigma = arma::mean(sigma_samp);
-
-  // Calculate Log likelihood
-  double log_lik = 0;
-  for(int i = 0; i < Z_samp.n_rows; i++){
-    for(int j = 0; j < Y(i,0).n_elem; j++){
-      log_lik = log_lik + R::dnorm(Y(i,0)(j), mean_curve_fit(i,0)(j),
-                                   std::sqrt(mean_sigma), true);
-    }
-  }
-  double tilde_N = 0;
-  for(int i = 0; i < Z_samp.n_rows; i++){
-    tilde_N = tilde_N + Y(i,0).n_elem;
-  }
-
-  // Calculate BIC
-  double BIC = (2 * log_lik) - (std::log(tilde_N) *
-                ((Z_samp.n_rows + phi_samp(0,0).n_cols) * Z_samp.n_cols +
-                2 * phi_samp(0,0).n_cols * phi_samp(0,0).n_slices * phi_samp(0,0).n_rows +
-                2 + 4 * Z_samp.n_cols + chi_samp.n_rows * chi_samp.n_cols + (phi_samp(0,0).n_slices*Z_samp.n_cols)));
-  return(BIC);
+  BayesFMMM::Posterior post(dir, n_files, basis_degree, boundary_knots,
+                            internal_knots);
+  return post.BIC(time, Y, burnin_prop);
 }
 
 //' Calculates the log-likelihood of the parameters for each iteration
@@ -2128,83 +1305,10 @@ arma::vec Model_LLik(const std::string dir,
     }
   }
 
-  // Get Nu parameters
-  arma::cube nu_i;
-  nu_i.load(dir + "Nu0.txt");
-  arma::cube nu_samp = arma::zeros(nu_i.n_rows, nu_i.n_cols, nu_i.n_slices * n_files);
-  nu_samp.subcube(0, 0, 0, nu_i.n_rows-1, nu_i.n_cols-1, nu_i.n_slices-1) = nu_i;
-  for(int i = 1; i < n_files; i++){
-    nu_i.load(dir + "Nu" + std::to_string(i) +".txt");
-    nu_samp.subcube(0, 0,  nu_i.n_slices*i, nu_i.n_rows-1, nu_i.n_cols-1,
-                    (nu_i.n_slices)*(i+1) - 1) = nu_i;
-  }
-
-  // Get Phi parameters
-  arma::field<arma::cube> phi_i;
-  phi_i.load(dir + "Phi0.txt");
-  arma::field<arma::cube> phi_samp(n_MCMC * n_files, 1);
-  for(int i = 0; i < n_MCMC; i++){
-    phi_samp(i,0) = phi_i(i,0);
-  }
-
-  for(int i = 1; i < n_files; i++){
-    phi_i.load(dir + "Phi" + std::to_string(i) +".txt");
-    for(int j = 0; j < n_MCMC; j++){
-      phi_samp((i * n_MCMC) + j, 0) = phi_i(j,0);
-    }
-  }
-
-  // Get Z parameters
-  arma::cube Z_i;
-  Z_i.load(dir + "Z0.txt");
-  arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-  Z_samp.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-  for(int i = 1; i < n_files; i++){
-    Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-    Z_samp.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-  }
-
-  // Get sigma parameters
-  arma::vec sigma_i;
-  sigma_i.load(dir + "Sigma0.txt");
-  arma::vec sigma_samp = arma::zeros(sigma_i.n_elem * n_files);
-  sigma_samp.subvec(0, sigma_i.n_elem - 1) = sigma_i;
-  for(int i = 1; i < n_files; i++){
-    sigma_i.load(dir + "Sigma" + std::to_string(i) +".txt");
-    sigma_samp.subvec(sigma_i.n_elem *i, (sigma_i.n_elem *(i + 1)) - 1) = sigma_i;
-  }
-
-  // Get chi parameters
-  arma::cube chi_i;
-  chi_i.load(dir + "Chi0.txt");
-  arma::cube chi_samp = arma::zeros(chi_i.n_rows, chi_i.n_cols, chi_i.n_slices * n_files);
-  chi_samp.subcube(0, 0, 0, chi_i.n_rows-1, chi_i.n_cols-1, chi_i.n_slices-1) = chi_i;
-  for(int i = 1; i < n_files; i++){
-    chi_i.load(dir + "Chi" + std::to_string(i) +".txt");
-    chi_samp.subcube(0, 0,  chi_i.n_slices*i, chi_i.n_rows-1, chi_i.n_cols-1,
-                     (chi_i.n_slices)*(i+1) - 1) = chi_i;
-  }
-
-  // Make spline basis
-  arma::field<arma::mat> B_obs(Z_samp.n_rows, 1);
-  splines2::BSpline bspline2;
-  for(int i = 0; i < Z_samp.n_rows; i++){
-    bspline2 = splines2::BSpline(time(i,0),  internal_knots, basis_degree,
-                                 boundary_knots);
-    // Get Basis matrix (time2 x Phi.n_cols)
-    arma::mat bspline_mat2{bspline2.basis(true)};
-    // Make B_obs
-    B_obs(i,0) = bspline_mat2;
-  }
-  arma::vec LLik = arma::zeros(nu_samp.n_slices);
-  for(int i = 0; i < nu_samp.n_slices; i++){
-    LLik(i) =  BayesFMMM::calcLikelihood(Y, B_obs, nu_samp.slice(i),
-                                         phi_samp(i,0), Z_samp.slice(i),
-                                         chi_samp.slice(i), sigma_samp(i));
-  }
-
- return(LLik);
-}
+  BayesFMMM::Posterior post(dir, n_files, basis_degree, boundary_knots,
+                            internal_knots);
+  return post.LLik(time, Y);
+}
 
 //' Calculates the AIC of a multivariate model
 //'
@@ -2231,61 +1335,23 @@ double MV_Model_AIC(const std::string dir,
   }
 
   // Get Nu parameters
-  arma::cube nu_i;
-  nu_i.load(dir + "Nu0.txt");
-  arma::cube nu_samp = arma::zeros(nu_i.n_rows, nu_i.n_cols, nu_i.n_slices * n_files);
-  nu_samp.subcube(0, 0, 0, nu_i.n_rows-1, nu_i.n_cols-1, nu_i.n_slices-1) = nu_i;
-  for(int i = 1; i < n_files; i++){
-    nu_i.load(dir + "Nu" + std::to_string(i) +".txt");
-    nu_samp.subcube(0, 0,  nu_i.n_slices*i, nu_i.n_rows-1, nu_i.n_cols-1,
-                    (nu_i.n_slices)*(i+1) - 1) = nu_i;
-  }
+  arma::cube nu_samp = BayesFMMM::loadCubeSamples(dir, "Nu", n_files);
 
   // Get Phi parameters
-  arma::field<arma::cube> phi_i;
-  phi_i.load(dir + "Phi0.txt");
-  arma::field<arma::cube> phi_samp(n_MCMC * n_files, 1);
-  for(int i = 0; i < n_MCMC; i++){
-    phi_samp(i,0) = phi_i(i,0);
-  }
-
-  for(int i = 1; i < n_files; i++){
-    phi_i.load(dir + "Phi" + std::to_string(i) +".txt");
-    for(int j = 0; j < n_MCMC; j++){
-      phi_samp((i * n_MCMC) + j, 0) = phi_i(j,0);
-    }
-  }
+  arma::field<arma::cube> phi_samp = BayesFMMM::loadFieldSamples(dir, "Phi", n_files, n_MCMC);
 
   // Get Z parameters
   arma::cube Z_i;
-  Z_i.load(dir + "Z0.txt");
-  arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-  Z_samp.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-  for(int i = 1; i < n_files; i++){
-    Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-    Z_samp.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-  }
+  BayesFMMM::loadSamples(Z_i, dir + "Z0.txt");
+  arma::cube Z_samp = BayesFMMM::loadCubeSamples(dir, "Z", n_files);
 
   // Get sigma parameters
   arma::vec sigma_i;
-  sigma_i.load(dir + "Sigma0.txt");
-  arma::vec sigma_samp = arma::zeros(sigma_i.n_elem * n_files);
-  sigma_samp.subvec(0, sigma_i.n_elem - 1) = sigma_i;
-  for(int i = 1; i < n_files; i++){
-    sigma_i.load(dir + "Sigma" + std::to_string(i) +".txt");
-    sigma_samp.subvec(sigma_i.n_elem *i, (sigma_i.n_elem *(i + 1)) - 1) = sigma_i;
-  }
+  BayesFMMM::loadSamples(sigma_i, dir + "Sigma0.txt");
+  arma::vec sigma_samp = BayesFMMM::loadVecSamples(dir, "Sigma", n_files);
 
   // Get chi parameters
-  arma::cube chi_i;
-  chi_i.load(dir + "Chi0.txt");
-  arma::cube chi_samp = arma::zeros(chi_i.n_rows, chi_i.n_cols, chi_i.n_slices * n_files);
-  chi_samp.subcube(0, 0, 0, chi_i.n_rows-1, chi_i.n_cols-1, chi_i.n_slices-1) = chi_i;
-  for(int i = 1; i < n_files; i++){
-    chi_i.load(dir + "Chi" + std::to_string(i) +".txt");
-    chi_samp.subcube(0, 0,  chi_i.n_slices*i, chi_i.n_rows-1, chi_i.n_cols-1,
-                     (chi_i.n_slices)*(i+1) - 1) = chi_i;
-  }
+  arma::cube chi_samp = BayesFMMM::loadCubeSamples(dir, "Chi", n_files);
 
 
   // Get posterior mean of sigma^2
@@ -2355,61 +1421,23 @@ double MV_Model_BIC(const std::string dir,
   }
 
   // Get Nu parameters
-  arma::cube nu_i;
-  nu_i.load(dir + "Nu0.txt");
-  arma::cube nu_samp = arma::zeros(nu_i.n_rows, nu_i.n_cols, nu_i.n_slices * n_files);
-  nu_samp.subcube(0, 0, 0, nu_i.n_rows-1, nu_i.n_cols-1, nu_i.n_slices-1) = nu_i;
-  for(int i = 1; i < n_files; i++){
-    nu_i.load(dir + "Nu" + std::to_string(i) +".txt");
-    nu_samp.subcube(0, 0,  nu_i.n_slices*i, nu_i.n_rows-1, nu_i.n_cols-1,
-                    (nu_i.n_slices)*(i+1) - 1) = nu_i;
-  }
+  arma::cube nu_samp = BayesFMMM::loadCubeSamples(dir, "Nu", n_files);
 
   // Get Phi parameters
-  arma::field<arma::cube> phi_i;
-  phi_i.load(dir + "Phi0.txt");
-  arma::field<arma::cube> phi_samp(n_MCMC * n_files, 1);
-  for(int i = 0; i < n_MCMC; i++){
-    phi_samp(i,0) = phi_i(i,0);
-  }
-
-  for(int i = 1; i < n_files; i++){
-    phi_i.load(dir + "Phi" + std::to_string(i) +".txt");
-    for(int j = 0; j < n_MCMC; j++){
-      phi_samp((i * n_MCMC) + j, 0) = phi_i(j,0);
-    }
-  }
+  arma::field<arma::cube> phi_samp = BayesFMMM::loadFieldSamples(dir, "Phi", n_files, n_MCMC);
 
   // Get Z parameters
   arma::cube Z_i;
-  Z_i.load(dir + "Z0.txt");
-  arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-  Z_samp.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-  for(int i = 1; i < n_files; i++){
-    Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-    Z_samp.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-  }
+  BayesFMMM::loadSamples(Z_i, dir + "Z0.txt");
+  arma::cube Z_samp = BayesFMMM::loadCubeSamples(dir, "Z", n_files);
 
   // Get sigma parameters
   arma::vec sigma_i;
-  sigma_i.load(dir + "Sigma0.txt");
-  arma::vec sigma_samp = arma::zeros(sigma_i.n_elem * n_files);
-  sigma_samp.subvec(0, sigma_i.n_elem - 1) = sigma_i;
-  for(int i = 1; i < n_files; i++){
-    sigma_i.load(dir + "Sigma" + std::to_string(i) +".txt");
-    sigma_samp.subvec(sigma_i.n_elem *i, (sigma_i.n_elem *(i + 1)) - 1) = sigma_i;
-  }
+  BayesFMMM::loadSamples(sigma_i, dir + "Sigma0.txt");
+  arma::vec sigma_samp = BayesFMMM::loadVecSamples(dir, "Sigma", n_files);
 
   // Get chi parameters
-  arma::cube chi_i;
-  chi_i.load(dir + "Chi0.txt");
-  arma::cube chi_samp = arma::zeros(chi_i.n_rows, chi_i.n_cols, chi_i.n_slices * n_files);
-  chi_samp.subcube(0, 0, 0, chi_i.n_rows-1, chi_i.n_cols-1, chi_i.n_slices-1) = chi_i;
-  for(int i = 1; i < n_files; i++){
-    chi_i.load(dir + "Chi" + std::to_string(i) +".txt");
-    chi_samp.subcube(0, 0,  chi_i.n_slices*i, chi_i.n_rows-1, chi_i.n_cols-1,
-                     (chi_i.n_slices)*(i+1) - 1) = chi_i;
-  }
+  arma::cube chi_samp = BayesFMMM::loadCubeSamples(dir, "Chi", n_files);
 
   // Get posterior mean of sigma^2
   double mean_sigma = arma::mean(sigma_samp);
@@ -2476,61 +1504,19 @@ double MV_Model_DIC(const std::string dir,
   }
 
   // Get Nu parameters
-  arma::cube nu_i;
-  nu_i.load(dir + "Nu0.txt");
-  arma::cube nu_samp = arma::zeros(nu_i.n_rows, nu_i.n_cols, nu_i.n_slices * n_files);
-  nu_samp.subcube(0, 0, 0, nu_i.n_rows-1, nu_i.n_cols-1, nu_i.n_slices-1) = nu_i;
-  for(int i = 1; i < n_files; i++){
-    nu_i.load(dir + "Nu" + std::to_string(i) +".txt");
-    nu_samp.subcube(0, 0,  nu_i.n_slices*i, nu_i.n_rows-1, nu_i.n_cols-1,
-                    (nu_i.n_slices)*(i+1) - 1) = nu_i;
-  }
+  arma::cube nu_samp = BayesFMMM::loadCubeSamples(dir, "Nu", n_files);
 
   // Get Phi parameters
-  arma::field<arma::cube> phi_i;
-  phi_i.load(dir + "Phi0.txt");
-  arma::field<arma::cube> phi_samp(n_MCMC * n_files, 1);
-  for(int i = 0; i < n_MCMC; i++){
-    phi_samp(i,0) = phi_i(i,0);
-  }
-
-  for(int i = 1; i < n_files; i++){
-    phi_i.load(dir + "Phi" + std::to_string(i) +".txt");
-    for(int j = 0; j < n_MCMC; j++){
-      phi_samp((i * n_MCMC) + j, 0) = phi_i(j,0);
-    }
-  }
+  arma::field<arma::cube> phi_samp = BayesFMMM::loadFieldSamples(dir, "Phi", n_files, n_MCMC);
 
   // Get Z parameters
-  arma::cube Z_i;
-  Z_i.load(dir + "Z0.txt");
-  arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-  Z_samp.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-  for(int i = 1; i < n_files; i++){
-    Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-    Z_samp.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-  }
+  arma::cube Z_samp = BayesFMMM::loadCubeSamples(dir, "Z", n_files);
 
   // Get sigma parameters
-  arma::vec sigma_i;
-  sigma_i.load(dir + "Sigma0.txt");
-  arma::vec sigma_samp = arma::zeros(sigma_i.n_elem * n_files);
-  sigma_samp.subvec(0, sigma_i.n_elem - 1) = sigma_i;
-  for(int i = 1; i < n_files; i++){
-    sigma_i.load(dir + "Sigma" + std::to_string(i) +".txt");
-    sigma_samp.subvec(sigma_i.n_elem *i, (sigma_i.n_elem *(i + 1)) - 1) = sigma_i;
-  }
+  arma::vec sigma_samp = BayesFMMM::loadVecSamples(dir, "Sigma", n_files);
 
   // Get chi parameters
-  arma::cube chi_i;
-  chi_i.load(dir + "Chi0.txt");
-  arma::cube chi_samp = arma::zeros(chi_i.n_rows, chi_i.n_cols, chi_i.n_slices * n_files);
-  chi_samp.subcube(0, 0, 0, chi_i.n_rows-1, chi_i.n_cols-1, chi_i.n_slices-1) = chi_i;
-  for(int i = 1; i < n_files; i++){
-    chi_i.load(dir + "Chi" + std::to_string(i) +".txt");
-    chi_samp.subcube(0, 0,  chi_i.n_slices*i, chi_i.n_rows-1, chi_i.n_cols-1,
-                     (chi_i.n_slices)*(i+1) - 1) = chi_i;
-  }
+  arma::cube chi_samp = BayesFMMM::loadCubeSamples(dir, "Chi", n_files);
 
 
   double expected_log_f = 0;
@@ -2573,61 +1559,19 @@ arma::vec MV_Model_LLik(const std::string dir,
                         const arma::mat Y){
 
   // Get Nu parameters
-  arma::cube nu_i;
-  nu_i.load(dir + "Nu0.txt");
-  arma::cube nu_samp = arma::zeros(nu_i.n_rows, nu_i.n_cols, nu_i.n_slices * n_files);
-  nu_samp.subcube(0, 0, 0, nu_i.n_rows-1, nu_i.n_cols-1, nu_i.n_slices-1) = nu_i;
-  for(int i = 1; i < n_files; i++){
-    nu_i.load(dir + "Nu" + std::to_string(i) +".txt");
-    nu_samp.subcube(0, 0,  nu_i.n_slices*i, nu_i.n_rows-1, nu_i.n_cols-1,
-                    (nu_i.n_slices)*(i+1) - 1) = nu_i;
-  }
+  arma::cube nu_samp = BayesFMMM::loadCubeSamples(dir, "Nu", n_files);
 
   // Get Phi parameters
-  arma::field<arma::cube> phi_i;
-  phi_i.load(dir + "Phi0.txt");
-  arma::field<arma::cube> phi_samp(n_MCMC * n_files, 1);
-  for(int i = 0; i < n_MCMC; i++){
-    phi_samp(i,0) = phi_i(i,0);
-  }
-
-  for(int i = 1; i < n_files; i++){
-    phi_i.load(dir + "Phi" + std::to_string(i) +".txt");
-    for(int j = 0; j < n_MCMC; j++){
-      phi_samp((i * n_MCMC) + j, 0) = phi_i(j,0);
-    }
-  }
+  arma::field<arma::cube> phi_samp = BayesFMMM::loadFieldSamples(dir, "Phi", n_files, n_MCMC);
 
   // Get Z parameters
-  arma::cube Z_i;
-  Z_i.load(dir + "Z0.txt");
-  arma::cube Z_samp = arma::zeros(Z_i.n_rows, Z_i.n_cols, Z_i.n_slices * n_files);
-  Z_samp.subcube(0, 0, 0, Z_i.n_rows-1, Z_i.n_cols-1, Z_i.n_slices-1) = Z_i;
-  for(int i = 1; i < n_files; i++){
-    Z_i.load(dir + "Z" + std::to_string(i) +".txt");
-    Z_samp.subcube(0, 0,  Z_i.n_slices*i, Z_i.n_rows-1, Z_i.n_cols-1, (Z_i.n_slices)*(i+1) - 1) = Z_i;
-  }
+  arma::cube Z_samp = BayesFMMM::loadCubeSamples(dir, "Z", n_files);
 
   // Get sigma parameters
-  arma::vec sigma_i;
-  sigma_i.load(dir + "Sigma0.txt");
-  arma::vec sigma_samp = arma::zeros(sigma_i.n_elem * n_files);
-  sigma_samp.subvec(0, sigma_i.n_elem - 1) = sigma_i;
-  for(int i = 1; i < n_files; i++){
-    sigma_i.load(dir + "Sigma" + std::to_string(i) +".txt");
-    sigma_samp.subvec(sigma_i.n_elem *i, (sigma_i.n_elem *(i + 1)) - 1) = sigma_i;
-  }
+  arma::vec sigma_samp = BayesFMMM::loadVecSamples(dir, "Sigma", n_files);
 
   // Get chi parameters
-  arma::cube chi_i;
-  chi_i.load(dir + "Chi0.txt");
-  arma::cube chi_samp = arma::zeros(chi_i.n_rows, chi_i.n_cols, chi_i.n_slices * n_files);
-  chi_samp.subcube(0, 0, 0, chi_i.n_rows-1, chi_i.n_cols-1, chi_i.n_slices-1) = chi_i;
-  for(int i = 1; i < n_files; i++){
-    chi_i.load(dir + "Chi" + std::to_string(i) +".txt");
-    chi_samp.subcube(0, 0,  chi_i.n_slices*i, chi_i.n_rows-1, chi_i.n_cols-1,
-                     (chi_i.n_slices)*(i+1) - 1) = chi_i;
-  }
+  arma::cube chi_samp = BayesFMMM::loadCubeSamples(dir, "Chi", n_files);
 
   arma::vec LLik = arma::zeros(nu_samp.n_slices);
   for(int i = 0; i < nu_samp.n_slices; i++){
@@ -2638,3 +1582,394 @@ arma::vec MV_Model_LLik(const std::string dir,
 
   return(LLik);
 }
+
+//' Creates a posterior session for a functional model
+//'
+//' Reading the MCMC files and evaluating the B-spline basis is often the most
+//' expensive part of computing posterior summaries. This function creates a
+//' posterior session that reads the posterior samples from the directory the
+//' first time they are needed and keeps them in memory. The B-spline bases are
+//' also cached for each set of time points used. The session can then be passed
+//' to \code{Session_FMeanCI}, \code{Session_FCovCI}, \code{Session_ZCI},
+//' \code{Session_SigmaCI}, \code{Session_DIC}, \code{Session_IC},
+//' \code{Session_ScoreMembership}, \code{Session_AIC}, \code{Session_BIC} and
+//' \code{Session_LLik}, which give the same results as their directory based
+//' counterparts.
+//'
+//' @name PosteriorSession
+//' @param dir String containing the directory where the MCMC files are located
+//' @param n_files Int containing the number of files per parameter
+//' @param basis_degree Int containing the degree of B-splines used
+//' @param boundary_knots Vector containing the boundary points of our index domain of interest
+//' @param internal_knots Vector location of internal knots for B-splines
+//' @returns session External pointer to the posterior session
+//'
+//' @section Warning:
+//' The following must be true:
+//' \describe{
+//'   \item{\code{n_files}}{must be an integer larger than or equal to 1}
+//'   \item{\code{basis_degree}}{must be an integer larger than or equal to 1}
+//'   \item{\code{internal_knots}}{must lie in the range of \code{boundary_knots}}
+//' }
+//'
+//' @examples
+//' ## Set Hyperparameters
+//' dir <- system.file("test-data","", package = "BayesFMMM")
+//' n_files <- 1
+//' time <- seq(0, 990, 10)
+//' basis_degree <- 3
+//' boundary_knots <- c(0, 1000)
+//' internal_knots <- c(200, 400, 600, 800)
+//'
+//' ## Create posterior session
+//' session <- PosteriorSession(dir, n_files, basis_degree, boundary_knots,
+//'                             internal_knots)
+//'
+//' ## Get CI for mean functions
+//' CI1 <- Session_FMeanCI(session, time, 1)
+//' CI2 <- Session_FMeanCI(session, time, 2)
+//'
+//' ## Get CI for covariance function
+//' CI12 <- Session_FCovCI(session, time, time, 1, 2)
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::XPtr<BayesFMMM::Posterior> PosteriorSession(const std::string dir,
+                                                  const int n_files,
+                                                  const int basis_degree,
+                                                  const arma::vec boundary_knots,
+                                                  const arma::vec internal_knots){
+  if(n_files <= 0){
+    Rcpp::stop("'n_files' must be greater than 0");
+  }
+  if(basis_degree <  1){
+    Rcpp::stop("'basis_degree' must be an integer greater than or equal to 1");
+  }
+  for(int i = 0; i < internal_knots.n_elem; i++){
+    if(boundary_knots(0) >= internal_knots(i)){
+      Rcpp::stop("at least one element in 'internal_knots' is less than or equal to first boundary knot");
+    }
+    if(boundary_knots(1) <= internal_knots(i)){
+      Rcpp::stop("at least one element in 'internal_knots' is more than or equal to second boundary knot");
+    }
+  }
+
+  Rcpp::XPtr<BayesFMMM::Posterior> session(new BayesFMMM::Posterior(dir, n_files,
+                                                                     basis_degree,
+                                                                     boundary_knots,
+                                                                     internal_knots),
+                                           true);
+  session.attr("class") = "BayesFMMM_posterior";
+  return session;
+}
+
+//' Calculates the credible interval for the mean using a posterior session
+//'
+//' Same as \code{FMeanCI}, but uses the posterior samples stored in a session
+//' created by \code{PosteriorSession}.
+//'
+//' @name Session_FMeanCI
+//' @param session External pointer to the posterior session (from \code{PosteriorSession})
+//' @param time Vector containing time points of interest
+//' @param k Int containing the cluster group of which you want to get the credible interval for
+//' @param alpha Double specifying the percentile of the credible interval ((1 - alpha) * 100 percent)
+//' @param rescale Boolean indicating whether or not we should rescale the Z variables so that there is at least one observation almost completely in one group
+//' @param simultaneous Boolean indicating whether or not the credible intervals should be simultaneous credible intervals or pointwise credible intervals
+//' @param burnin_prop Double containing proportion of MCMC samples to discard
+//' @return CI list containing the credible interval for the mean function, as well as the median posterior estimate of the mean function. Posterior samples fo the mean function are also returned.
+//'
+//' @section Warning:
+//' The following must be true:
+//' \describe{
+//'   \item{\code{k}}{must be an integer larger than 1 and less than or equal to the number of clusters in the model}
+//'   \item{\code{alpha}}{must be between 0 and 1}
+//'   \item{\code{burnin_prop}}{must be less than 1 and greater than or equal to 0}
+//' }
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::List Session_FMeanCI(Rcpp::XPtr<BayesFMMM::Posterior> session,
+                           const arma::vec time,
+                           const int k,
+                           const double alpha = 0.05,
+                           bool rescale = true,
+                           const bool simultaneous = false,
+                           const double burnin_prop = 0.1){
+  if(alpha < 0){
+    Rcpp::stop("'alpha' must be between 0 and 1");
+  }
+  if(alpha >= 1){
+    Rcpp::stop("'alpha' must be between 0 and 1");
+  }
+  if(burnin_prop < 0){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  if(burnin_prop >= 1){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  return session->FMeanCI(time, k, alpha, rescale, simultaneous, burnin_prop);
+}
+
+//' Calculates the credible interval for the covariance using a posterior session
+//'
+//' Same as \code{FCovCI}, but uses the posterior samples stored in a session
+//' created by \code{PosteriorSession}.
+//'
+//' @name Session_FCovCI
+//' @param session External pointer to the posterior session (from \code{PosteriorSession})
+//' @param time1 Vector containing time points of interest for first cluster
+//' @param time2 Vector containing time points of interest for second cluster
+//' @param l Int containing the 1st cluster group of which you want to get the credible interval for
+//' @param m Int containing the 2nd cluster group of which you want to get the credible interval for
+//' @param alpha Double specifying the percentile of the credible interval ((1 - alpha) * 100 percent)
+//' @param rescale Boolean indicating whether or not we should rescale the Z variables so that there is at least one observation almost completely in one group
+//' @param simultaneous Boolean indicating whether or not the credible intervals should be simultaneous credible intervals or pointwise credible intervals
+//' @param burnin_prop Double containing proportion of MCMC samples to discard
+//' @return CI list containing the credible interval for the covariance function, as well as the median posterior estimate of the covariance function. Posterior estimates of the covariance function are also returned.
+//'
+//' @section Warning:
+//' The following must be true:
+//' \describe{
+//'   \item{\code{l}}{must be an integer larger than 1 and less than or equal to the number of clusters in the model}
+//'   \item{\code{m}}{must be an integer larger than 1 and less than or equal to the number of clusters in the model}
+//'   \item{\code{alpha}}{must be between 0 and 1}
+//'   \item{\code{burnin_prop}}{must be less than 1 and greater than or equal to 0}
+//' }
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::List Session_FCovCI(Rcpp::XPtr<BayesFMMM::Posterior> session,
+                          const arma::vec time1,
+                          const arma::vec time2,
+                          const int l,
+                          const int m,
+                          const double alpha = 0.05,
+                          bool rescale = true,
+                          const bool simultaneous = false,
+                          const double burnin_prop = 0.1){
+  if(alpha < 0){
+    Rcpp::stop("'alpha' must be between 0 and 1");
+  }
+  if(alpha >= 1){
+    Rcpp::stop("'alpha' must be between 0 and 1");
+  }
+  if(burnin_prop < 0){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  if(burnin_prop >= 1){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  return session->FCovCI(time1, time2, l, m, alpha, rescale, simultaneous,
+                         burnin_prop);
+}
+
+//' Calculates the credible interval for membership parameters Z using a posterior session
+//'
+//' Same as \code{ZCI}, but uses the posterior samples stored in a session
+//' created by \code{PosteriorSession}.
+//'
+//' @name Session_ZCI
+//' @param session External pointer to the posterior session (from \code{PosteriorSession})
+//' @param alpha Double specifying the percentile of the credible interval ((1 - alpha) * 100 percent)
+//' @param rescale Boolean indicating whether or not we should rescale the Z variables so that there is at least one observation almost completely in one group
+//' @param burnin_prop Double containing proportion of MCMC samples to discard
+//' @return CI List containing the desired credible values
+//' @export
+// [[Rcpp::export]]
+Rcpp::List Session_ZCI(Rcpp::XPtr<BayesFMMM::Posterior> session,
+                       const double alpha = 0.05,
+                       bool rescale = true,
+                       const double burnin_prop = 0.1){
+  return session->ZCI(alpha, rescale, burnin_prop);
+}
+
+//' Calculates the credible interval for sigma squared using a posterior session
+//'
+//' Same as \code{SigmaCI}, but uses the posterior samples stored in a session
+//' created by \code{PosteriorSession}.
+//'
+//' @name Session_SigmaCI
+//' @param session External pointer to the posterior session (from \code{PosteriorSession})
+//' @param alpha Double specifying the percentile of the credible interval ((1 - alpha) * 100 percent)
+//' @returns CI list containing the credible interval for sigma squared, as well as the median posterior estimate of sigma squared
+//'
+//' @section Warning:
+//' The following must be true:
+//' \describe{
+//'   \item{\code{alpha}}{must be between 0 and 1}
+//' }
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::List Session_SigmaCI(Rcpp::XPtr<BayesFMMM::Posterior> session,
+                           const double alpha = 0.05){
+  if(alpha < 0){
+    Rcpp::stop("'alpha' must be between 0 and 1");
+  }
+  if(alpha >= 1){
+    Rcpp::stop("'alpha' must be between 0 and 1");
+  }
+  return session->SigmaCI(alpha);
+}
+
+//' Calculates the DIC of a functional model using a posterior session
+//'
+//' @name Session_DIC
+//' @param session External pointer to the posterior session (from \code{PosteriorSession})
+//' @param time Field of vectors containing time points at which the function was observed
+//' @param Y Field of vectors containing observed values of the function
+//' @param burnin_prop Double containing proportion of MCMC samples to discard
+//' @returns DIC Double containing DIC value
+//' @export
+// [[Rcpp::export]]
+double Session_DIC(Rcpp::XPtr<BayesFMMM::Posterior> session,
+                   const arma::field<arma::vec>& time,
+                   const arma::field<arma::vec>& Y,
+                   const double burnin_prop = 0.2){
+  if(burnin_prop < 0){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  if(burnin_prop >= 1){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  return session->DIC(time, Y, burnin_prop);
+}
+
+//' Calculates the DIC, WAIC and PSIS-LOO of a functional model using a posterior session
+//'
+//' @name Session_IC
+//' @param session External pointer to the posterior session (from \code{PosteriorSession})
+//' @param time Field of vectors containing time points at which the function was observed
+//' @param Y Field of vectors containing observed values of the function
+//' @param burnin_prop Double containing proportion of MCMC samples to discard
+//' @returns IC List containing DIC, WAIC and PSIS-LOO values (see \code{Model_IC})
+//' @export
+// [[Rcpp::export]]
+Rcpp::List Session_IC(Rcpp::XPtr<BayesFMMM::Posterior> session,
+                      const arma::field<arma::vec>& time,
+                      const arma::field<arma::vec>& Y,
+                      const double burnin_prop = 0.2){
+  if(burnin_prop < 0){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  if(burnin_prop >= 1){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  return session->IC(time, Y, burnin_prop);
+}
+
+//' Samples the memberships and scores of new functions using a posterior session
+//'
+//' Same as \code{Model_ScoreMembership}, but uses the posterior samples stored
+//' in a session created by \code{PosteriorSession}.
+//'
+//' @name Session_ScoreMembership
+//' @param session External pointer to the posterior session (from \code{PosteriorSession})
+//' @param time Field of vectors containing time points at which the new functions were observed
+//' @param Y Field of vectors containing observed values of the new functions
+//' @param alpha Double specifying the percentile of the credible interval
+//' @param burnin_prop Double containing proportion of MCMC samples to discard
+//' @param n_iter Int containing the number of sweeps per saved MCMC iteration
+//' @param n_warmup Int containing the number of sweeps before the first saved MCMC iteration is used
+//' @param a_Z_PM Double containing hyperparameter of the proposal distribution of Z
+//' @param return_draws Boolean indicating whether the draws of Z and chi should be returned
+//' @returns scores List containing the memberships and scores of the new functions (see \code{Model_ScoreMembership})
+//' @export
+// [[Rcpp::export]]
+Rcpp::List Session_ScoreMembership(Rcpp::XPtr<BayesFMMM::Posterior> session,
+                                   const arma::field<arma::vec>& time,
+                                   const arma::field<arma::vec>& Y,
+                                   const double alpha = 0.05,
+                                   const double burnin_prop = 0.2,
+                                   const int n_iter = 1,
+                                   const int n_warmup = 50,
+                                   const double a_Z_PM = 1000,
+                                   const bool return_draws = false){
+  if(Y.n_elem != time.n_elem){
+    Rcpp::stop("'Y' must have the same length as 'time'");
+  }
+  if(alpha <= 0){
+    Rcpp::stop("'alpha' must be between 0 and 1");
+  }
+  if(alpha >= 1){
+    Rcpp::stop("'alpha' must be between 0 and 1");
+  }
+  if(burnin_prop < 0){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  if(burnin_prop >= 1){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  if(n_iter < 1){
+    Rcpp::stop("'n_iter' must be an integer greater than or equal to 1");
+  }
+  if(n_warmup < 0){
+    Rcpp::stop("'n_warmup' must be an integer greater than or equal to 0");
+  }
+  if(a_Z_PM <= 0){
+    Rcpp::stop("'a_Z_PM' must be positive");
+  }
+  return session->ScoreMembership(time, Y, alpha, burnin_prop, n_iter, n_warmup,
+                                  a_Z_PM, return_draws);
+}
+
+//' Calculates the AIC of a functional model using a posterior session
+//'
+//' @name Session_AIC
+//' @param session External pointer to the posterior session (from \code{PosteriorSession})
+//' @param time Field of vectors containing time points at which the function was observed
+//' @param Y Field of vectors containing observed values of the function
+//' @param burnin_prop Double containing proportion of MCMC samples to discard
+//' @returns AIC Double containing AIC value
+//' @export
+// [[Rcpp::export]]
+double Session_AIC(Rcpp::XPtr<BayesFMMM::Posterior> session,
+                   const arma::field<arma::vec>& time,
+                   const arma::field<arma::vec>& Y,
+                   const double burnin_prop = 0.2){
+  if(burnin_prop < 0){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  if(burnin_prop >= 1){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  return session->AIC(time, Y, burnin_prop);
+}
+
+//' Calculates the BIC of a functional model using a posterior session
+//'
+//' @name Session_BIC
+//' @param session External pointer to the posterior session (from \code{PosteriorSession})
+//' @param time Field of vectors containing time points at which the function was observed
+//' @param Y Field of vectors containing observed values of the function
+//' @param burnin_prop Double containing proportion of MCMC samples to discard
+//' @returns BIC Double containing BIC value
+//' @export
+// [[Rcpp::export]]
+double Session_BIC(Rcpp::XPtr<BayesFMMM::Posterior> session,
+                   const arma::field<arma::vec>& time,
+                   const arma::field<arma::vec>& Y,
+                   const double burnin_prop = 0.2){
+  if(burnin_prop < 0){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  if(burnin_prop >= 1){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  return session->BIC(time, Y, burnin_prop);
+}
+
+//' Calculates the log-likelihood of the parameters for each iteration using a posterior session
+//'
+//' @name Session_LLik
+//' @param session External pointer to the posterior session (from \code{PosteriorSession})
+//' @param time Field of vectors containing time points at which the function was observed
+//' @param Y Field of vectors containing observed values of the function
+//' @returns LLik Vector containing the log-likelihood evaluated at each iteration
+//' @export
+// [[Rcpp::export]]
+arma::vec Session_LLik(Rcpp::XPtr<BayesFMMM::Posterior> session,
+                       const arma::field<arma::vec>& time,
+                       const arma::field<arma::vec>& Y){
+  return session->LLik(time, Y);
+}
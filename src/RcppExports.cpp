@@ -182,6 +182,48 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// Model_IC
+Rcpp::List Model_IC(const std::string dir, const int n_files, const int n_MCMC, const int basis_degree, const arma::vec boundary_knots, const arma::vec internal_knots, const arma::field<arma::vec> time, const arma::field<arma::vec> Y, const double burnin_prop);
+RcppExport SEXP _BayesFMMM_Model_IC(SEXP dirSEXP, SEXP n_filesSEXP, SEXP n_MCMCSEXP, SEXP basis_degreeSEXP, SEXP boundary_knotsSEXP, SEXP internal_knotsSEXP, SEXP timeSEXP, SEXP YSEXP, SEXP burnin_propSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string >::type dir(dirSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_files(n_filesSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_MCMC(n_MCMCSEXP);
+    Rcpp::traits::input_parameter< const int >::type basis_degree(basis_degreeSEXP);
+    Rcpp::traits::input_parameter< const arma::vec >::type boundary_knots(boundary_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec >::type internal_knots(internal_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
+    rcpp_result_gen = Rcpp::wrap(Model_IC(dir, n_files, n_MCMC, basis_degree, boundary_knots, internal_knots, time, Y, burnin_prop));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Model_ScoreMembership
+Rcpp::List Model_ScoreMembership(const std::string dir, const int n_files, const int basis_degree, const arma::vec boundary_knots, const arma::vec internal_knots, const arma::field<arma::vec> time, const arma::field<arma::vec> Y, const double alpha, const double burnin_prop, const int n_iter, const int n_warmup, const double a_Z_PM, const bool return_draws);
+RcppExport SEXP _BayesFMMM_Model_ScoreMembership(SEXP dirSEXP, SEXP n_filesSEXP, SEXP basis_degreeSEXP, SEXP boundary_knotsSEXP, SEXP internal_knotsSEXP, SEXP timeSEXP, SEXP YSEXP, SEXP alphaSEXP, SEXP burnin_propSEXP, SEXP n_iterSEXP, SEXP n_warmupSEXP, SEXP a_Z_PMSEXP, SEXP return_drawsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string >::type dir(dirSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_files(n_filesSEXP);
+    Rcpp::traits::input_parameter< const int >::type basis_degree(basis_degreeSEXP);
+    Rcpp::traits::input_parameter< const arma::vec >::type boundary_knots(boundary_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec >::type internal_knots(internal_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_iter(n_iterSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_warmup(n_warmupSEXP);
+    Rcpp::traits::input_parameter< const double >::type a_Z_PM(a_Z_PMSEXP);
+    Rcpp::traits::input_parameter< const bool >::type return_draws(return_drawsSEXP);
+    rcpp_result_gen = Rcpp::wrap(Model_ScoreMembership(dir, n_files, basis_degree, boundary_knots, internal_knots, time, Y, alpha, burnin_prop, n_iter, n_warmup, a_Z_PM, return_draws));
+    return rcpp_result_gen;
+END_RCPP
+}
 // Model_AIC
 double Model_AIC(const std::string dir, const int n_files, const int n_MCMC, const int basis_degree, const arma::vec boundary_knots, const arma::vec internal_knots, const arma::field<arma::vec> time, const arma::field<arma::vec> Y, const double burnin_prop);
 RcppExport SEXP _BayesFMMM_Model_AIC(SEXP dirSEXP, SEXP n_filesSEXP, SEXP n_MCMCSEXP, SEXP basis_degreeSEXP, SEXP boundary_knotsSEXP, SEXP internal_knotsSEXP, SEXP timeSEXP, SEXP YSEXP, SEXP burnin_propSEXP) {
@@ -297,8 +339,173 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// PosteriorSession
+Rcpp::XPtr<BayesFMMM::Posterior> PosteriorSession(const std::string dir, const int n_files, const int basis_degree, const arma::vec boundary_knots, const arma::vec internal_knots);
+RcppExport SEXP _BayesFMMM_PosteriorSession(SEXP dirSEXP, SEXP n_filesSEXP, SEXP basis_degreeSEXP, SEXP boundary_knotsSEXP, SEXP internal_knotsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string >::type dir(dirSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_files(n_filesSEXP);
+    Rcpp::traits::input_parameter< const int >::type basis_degree(basis_degreeSEXP);
+    Rcpp::traits::input_parameter< const arma::vec >::type boundary_knots(boundary_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec >::type internal_knots(internal_knotsSEXP);
+    rcpp_result_gen = Rcpp::wrap(PosteriorSession(dir, n_files, basis_degree, boundary_knots, internal_knots));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Session_FMeanCI
+Rcpp::List Session_FMeanCI(Rcpp::XPtr<BayesFMMM::Posterior> session, const arma::vec time, const int k, const double alpha, bool rescale, const bool simultaneous, const double burnin_prop);
+RcppExport SEXP _BayesFMMM_Session_FMeanCI(SEXP sessionSEXP, SEXP timeSEXP, SEXP kSEXP, SEXP alphaSEXP, SEXP rescaleSEXP, SEXP simultaneousSEXP, SEXP burnin_propSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<BayesFMMM::Posterior> >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< const arma::vec >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< bool >::type rescale(rescaleSEXP);
+    Rcpp::traits::input_parameter< const bool >::type simultaneous(simultaneousSEXP);
+    Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
+    rcpp_result_gen = Rcpp::wrap(Session_FMeanCI(session, time, k, alpha, rescale, simultaneous, burnin_prop));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Session_FCovCI
+Rcpp::List Session_FCovCI(Rcpp::XPtr<BayesFMMM::Posterior> session, const arma::vec time1, const arma::vec time2, const int l, const int m, const double alpha, bool rescale, const bool simultaneous, const double burnin_prop);
+RcppExport SEXP _BayesFMMM_Session_FCovCI(SEXP sessionSEXP, SEXP time1SEXP, SEXP time2SEXP, SEXP lSEXP, SEXP mSEXP, SEXP alphaSEXP, SEXP rescaleSEXP, SEXP simultaneousSEXP, SEXP burnin_propSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<BayesFMMM::Posterior> >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< const arma::vec >::type time1(time1SEXP);
+    Rcpp::traits::input_parameter< const arma::vec >::type time2(time2SEXP);
+    Rcpp::traits::input_parameter< const int >::type l(lSEXP);
+    Rcpp::traits::input_parameter< const int >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< bool >::type rescale(rescaleSEXP);
+    Rcpp::traits::input_parameter< const bool >::type simultaneous(simultaneousSEXP);
+    Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
+    rcpp_result_gen = Rcpp::wrap(Session_FCovCI(session, time1, time2, l, m, alpha, rescale, simultaneous, burnin_prop));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Session_ZCI
+Rcpp::List Session_ZCI(Rcpp::XPtr<BayesFMMM::Posterior> session, const double alpha, bool rescale, const double burnin_prop);
+RcppExport SEXP _BayesFMMM_Session_ZCI(SEXP sessionSEXP, SEXP alphaSEXP, SEXP rescaleSEXP, SEXP burnin_propSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<BayesFMMM::Posterior> >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< bool >::type rescale(rescaleSEXP);
+    Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
+    rcpp_result_gen = Rcpp::wrap(Session_ZCI(session, alpha, rescale, burnin_prop));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Session_SigmaCI
+Rcpp::List Session_SigmaCI(Rcpp::XPtr<BayesFMMM::Posterior> session, const double alpha);
+RcppExport SEXP _BayesFMMM_Session_SigmaCI(SEXP sessionSEXP, SEXP alphaSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<BayesFMMM::Posterior> >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    rcpp_result_gen = Rcpp::wrap(Session_SigmaCI(session, alpha));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Session_DIC
+double Session_DIC(Rcpp::XPtr<BayesFMMM::Posterior> session, const arma::field<arma::vec>& time, const arma::field<arma::vec>& Y, const double burnin_prop);
+RcppExport SEXP _BayesFMMM_Session_DIC(SEXP sessionSEXP, SEXP timeSEXP, SEXP YSEXP, SEXP burnin_propSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<BayesFMMM::Posterior> >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
+    rcpp_result_gen = Rcpp::wrap(Session_DIC(session, time, Y, burnin_prop));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Session_IC
+Rcpp::List Session_IC(Rcpp::XPtr<BayesFMMM::Posterior> session, const arma::field<arma::vec>& time, const arma::field<arma::vec>& Y, const double burnin_prop);
+RcppExport SEXP _BayesFMMM_Session_IC(SEXP sessionSEXP, SEXP timeSEXP, SEXP YSEXP, SEXP burnin_propSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<BayesFMMM::Posterior> >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
+    rcpp_result_gen = Rcpp::wrap(Session_IC(session, time, Y, burnin_prop));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Session_ScoreMembership
+Rcpp::List Session_ScoreMembership(Rcpp::XPtr<BayesFMMM::Posterior> session, const arma::field<arma::vec>& time, const arma::field<arma::vec>& Y, const double alpha, const double burnin_prop, const int n_iter, const int n_warmup, const double a_Z_PM, const bool return_draws);
+RcppExport SEXP _BayesFMMM_Session_ScoreMembership(SEXP sessionSEXP, SEXP timeSEXP, SEXP YSEXP, SEXP alphaSEXP, SEXP burnin_propSEXP, SEXP n_iterSEXP, SEXP n_warmupSEXP, SEXP a_Z_PMSEXP, SEXP return_drawsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<BayesFMMM::Posterior> >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_iter(n_iterSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_warmup(n_warmupSEXP);
+    Rcpp::traits::input_parameter< const double >::type a_Z_PM(a_Z_PMSEXP);
+    Rcpp::traits::input_parameter< const bool >::type return_draws(return_drawsSEXP);
+    rcpp_result_gen = Rcpp::wrap(Session_ScoreMembership(session, time, Y, alpha, burnin_prop, n_iter, n_warmup, a_Z_PM, return_draws));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Session_AIC
+double Session_AIC(Rcpp::XPtr<BayesFMMM::Posterior> session, const arma::field<arma::vec>& time, const arma::field<arma::vec>& Y, const double burnin_prop);
+RcppExport SEXP _BayesFMMM_Session_AIC(SEXP sessionSEXP, SEXP timeSEXP, SEXP YSEXP, SEXP burnin_propSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<BayesFMMM::Posterior> >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
+    rcpp_result_gen = Rcpp::wrap(Session_AIC(session, time, Y, burnin_prop));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Session_BIC
+double Session_BIC(Rcpp::XPtr<BayesFMMM::Posterior> session, const arma::field<arma::vec>& time, const arma::field<arma::vec>& Y, const double burnin_prop);
+RcppExport SEXP _BayesFMMM_Session_BIC(SEXP sessionSEXP, SEXP timeSEXP, SEXP YSEXP, SEXP burnin_propSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<BayesFMMM::Posterior> >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
+    rcpp_result_gen = Rcpp::wrap(Session_BIC(session, time, Y, burnin_prop));
+    return rcpp_result_gen;
+END_RCPP
+}
+// Session_LLik
+arma::vec Session_LLik(Rcpp::XPtr<BayesFMMM::Posterior> session, const arma::field<arma::vec>& time, const arma::field<arma::vec>& Y);
+RcppExport SEXP _BayesFMMM_Session_LLik(SEXP sessionSEXP, SEXP timeSEXP, SEXP YSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<BayesFMMM::Posterior> >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type Y(YSEXP);
+    rcpp_result_gen = Rcpp::wrap(Session_LLik(session, time, Y));
+    return rcpp_result_gen;
+END_RCPP
+}
 // BFMMM_Nu_Z_multiple_try
-Rcpp::List BFMMM_Nu_Z_multiple_try(const int tot_mcmc_iters, const int n_try, const int k, const arma::field<arma::vec> Y, const arma::field<arma::vec> time, const int n_funct, const int basis_degree, const int n_eigen, const arma::vec boundary_knots, const arma::vec internal_knots, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0);
+Rcpp::List BFMMM_Nu_Z_multiple_try(const int tot_mcmc_iters, const int n_try, const int k, const arma::field<arma::vec>& Y, const arma::field<arma::vec>& time, const int n_funct, const int basis_degree, const int n_eigen, const arma::vec& boundary_knots, const arma::vec& internal_knots, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0);
 RcppExport SEXP _BayesFMMM_BFMMM_Nu_Z_multiple_try(SEXP tot_mcmc_itersSEXP, SEXP n_trySEXP, SEXP kSEXP, SEXP YSEXP, SEXP timeSEXP, SEXP n_functSEXP, SEXP basis_degreeSEXP, SEXP n_eigenSEXP, SEXP boundary_knotsSEXP, SEXP internal_knotsSEXP, SEXP cSEXP, SEXP bSEXP, SEXP alpha1lSEXP, SEXP alpha2lSEXP, SEXP beta1lSEXP, SEXP beta2lSEXP, SEXP a_Z_PMSEXP, SEXP a_pi_PMSEXP, SEXP var_alpha3SEXP, SEXP var_epsilon1SEXP, SEXP var_epsilon2SEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_0SEXP, SEXP beta_0SEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -306,13 +513,13 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const int >::type tot_mcmc_iters(tot_mcmc_itersSEXP);
     Rcpp::traits::input_parameter< const int >::type n_try(n_trySEXP);
     Rcpp::traits::input_parameter< const int >::type k(kSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type time(timeSEXP);
     Rcpp::traits::input_parameter< const int >::type n_funct(n_functSEXP);
     Rcpp::traits::input_parameter< const int >::type basis_degree(basis_degreeSEXP);
     Rcpp::traits::input_parameter< const int >::type n_eigen(n_eigenSEXP);
-    Rcpp::traits::input_parameter< const arma::vec >::type boundary_knots(boundary_knotsSEXP);
-    Rcpp::traits::input_parameter< const arma::vec >::type internal_knots(internal_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type boundary_knots(boundary_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type internal_knots(internal_knotsSEXP);
     Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::NumericVector> >::type c(cSEXP);
     Rcpp::traits::input_parameter< const double >::type b(bSEXP);
     Rcpp::traits::input_parameter< const double >::type alpha1l(alpha1lSEXP);
@@ -333,7 +540,7 @@ BEGIN_RCPP
 END_RCPP
 }
 // BFMMM_Theta_est
-Rcpp::List BFMMM_Theta_est(const int tot_mcmc_iters, const int n_try, const int k, const arma::field<arma::vec> Y, const arma::field<arma::vec> time, const int n_funct, const int basis_degree, const int n_eigen, const arma::vec boundary_knots, const arma::vec internal_knots, const arma::cube Z_samp, const arma::cube nu_samp, const double burnin_prop, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double nu_1, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0);
+Rcpp::List BFMMM_Theta_est(const int tot_mcmc_iters, const int n_try, const int k, const arma::field<arma::vec>& Y, const arma::field<arma::vec>& time, const int n_funct, const int basis_degree, const int n_eigen, const arma::vec& boundary_knots, const arma::vec& internal_knots, const arma::cube& Z_samp, const arma::cube& nu_samp, const double burnin_prop, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double nu_1, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0);
 RcppExport SEXP _BayesFMMM_BFMMM_Theta_est(SEXP tot_mcmc_itersSEXP, SEXP n_trySEXP, SEXP kSEXP, SEXP YSEXP, SEXP timeSEXP, SEXP n_functSEXP, SEXP basis_degreeSEXP, SEXP n_eigenSEXP, SEXP boundary_knotsSEXP, SEXP internal_knotsSEXP, SEXP Z_sampSEXP, SEXP nu_sampSEXP, SEXP burnin_propSEXP, SEXP cSEXP, SEXP bSEXP, SEXP nu_1SEXP, SEXP alpha1lSEXP, SEXP alpha2lSEXP, SEXP beta1lSEXP, SEXP beta2lSEXP, SEXP a_Z_PMSEXP, SEXP a_pi_PMSEXP, SEXP var_alpha3SEXP, SEXP var_epsilon1SEXP, SEXP var_epsilon2SEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_0SEXP, SEXP beta_0SEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -341,15 +548,15 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const int >::type tot_mcmc_iters(tot_mcmc_itersSEXP);
     Rcpp::traits::input_parameter< const int >::type n_try(n_trySEXP);
     Rcpp::traits::input_parameter< const int >::type k(kSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type time(timeSEXP);
     Rcpp::traits::input_parameter< const int >::type n_funct(n_functSEXP);
     Rcpp::traits::input_parameter< const int >::type basis_degree(basis_degreeSEXP);
     Rcpp::traits::input_parameter< const int >::type n_eigen(n_eigenSEXP);
-    Rcpp::traits::input_parameter< const arma::vec >::type boundary_knots(boundary_knotsSEXP);
-    Rcpp::traits::input_parameter< const arma::vec >::type internal_knots(internal_knotsSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type Z_samp(Z_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type nu_samp(nu_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type boundary_knots(boundary_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type internal_knots(internal_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type Z_samp(Z_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type nu_samp(nu_sampSEXP);
     Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
     Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::NumericVector> >::type c(cSEXP);
     Rcpp::traits::input_parameter< const double >::type b(bSEXP);
@@ -371,32 +578,62 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// BFMMM_ICM_init
+Rcpp::List BFMMM_ICM_init(const int tot_iters, const int k, const arma::field<arma::vec>& Y, const arma::field<arma::vec>& time, const int n_funct, const int basis_degree, const int n_eigen, const arma::vec& boundary_knots, const arma::vec& internal_knots, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double nu_1, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double alpha, const double beta, const double alpha_0, const double beta_0);
+RcppExport SEXP _BayesFMMM_BFMMM_ICM_init(SEXP tot_itersSEXP, SEXP kSEXP, SEXP YSEXP, SEXP timeSEXP, SEXP n_functSEXP, SEXP basis_degreeSEXP, SEXP n_eigenSEXP, SEXP boundary_knotsSEXP, SEXP internal_knotsSEXP, SEXP cSEXP, SEXP bSEXP, SEXP nu_1SEXP, SEXP alpha1lSEXP, SEXP alpha2lSEXP, SEXP beta1lSEXP, SEXP beta2lSEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_0SEXP, SEXP beta_0SEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const int >::type tot_iters(tot_itersSEXP);
+    Rcpp::traits::input_parameter< const int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_funct(n_functSEXP);
+    Rcpp::traits::input_parameter< const int >::type basis_degree(basis_degreeSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_eigen(n_eigenSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type boundary_knots(boundary_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type internal_knots(internal_knotsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::NumericVector> >::type c(cSEXP);
+    Rcpp::traits::input_parameter< const double >::type b(bSEXP);
+    Rcpp::traits::input_parameter< const double >::type nu_1(nu_1SEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha1l(alpha1lSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha2l(alpha2lSEXP);
+    Rcpp::traits::input_parameter< const double >::type beta1l(beta1lSEXP);
+    Rcpp::traits::input_parameter< const double >::type beta2l(beta2lSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< const double >::type beta(betaSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha_0(alpha_0SEXP);
+    Rcpp::traits::input_parameter< const double >::type beta_0(beta_0SEXP);
+    rcpp_result_gen = Rcpp::wrap(BFMMM_ICM_init(tot_iters, k, Y, time, n_funct, basis_degree, n_eigen, boundary_knots, internal_knots, c, b, nu_1, alpha1l, alpha2l, beta1l, beta2l, alpha, beta, alpha_0, beta_0));
+    return rcpp_result_gen;
+END_RCPP
+}
 // BFMMM_warm_start
-Rcpp::List BFMMM_warm_start(const int tot_mcmc_iters, const int k, const arma::field<arma::vec> Y, const arma::field<arma::vec> time, const int n_funct, const int basis_degree, const int n_eigen, const arma::vec boundary_knots, const arma::vec internal_knots, const arma::cube Z_samp, const arma::mat pi_samp, const arma::vec alpha_3_samp, const arma::cube delta_samp, const arma::field<arma::cube> gamma_samp, const arma::field<arma::cube> Phi_samp, const arma::cube A_samp, const arma::cube nu_samp, const arma::mat tau_samp, const arma::vec sigma_samp, const arma::cube chi_samp, const double burnin_prop, Rcpp::Nullable<Rcpp::CharacterVector> dir, const double thinning_num, const double beta_N_t, int N_t, int n_temp_trans, int r_stored_iters, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double nu_1, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0);
-RcppExport SEXP _BayesFMMM_BFMMM_warm_start(SEXP tot_mcmc_itersSEXP, SEXP kSEXP, SEXP YSEXP, SEXP timeSEXP, SEXP n_functSEXP, SEXP basis_degreeSEXP, SEXP n_eigenSEXP, SEXP boundary_knotsSEXP, SEXP internal_knotsSEXP, SEXP Z_sampSEXP, SEXP pi_sampSEXP, SEXP alpha_3_sampSEXP, SEXP delta_sampSEXP, SEXP gamma_sampSEXP, SEXP Phi_sampSEXP, SEXP A_sampSEXP, SEXP nu_sampSEXP, SEXP tau_sampSEXP, SEXP sigma_sampSEXP, SEXP chi_sampSEXP, SEXP burnin_propSEXP, SEXP dirSEXP, SEXP thinning_numSEXP, SEXP beta_N_tSEXP, SEXP N_tSEXP, SEXP n_temp_transSEXP, SEXP r_stored_itersSEXP, SEXP cSEXP, SEXP bSEXP, SEXP nu_1SEXP, SEXP alpha1lSEXP, SEXP alpha2lSEXP, SEXP beta1lSEXP, SEXP beta2lSEXP, SEXP a_Z_PMSEXP, SEXP a_pi_PMSEXP, SEXP var_alpha3SEXP, SEXP var_epsilon1SEXP, SEXP var_epsilon2SEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_0SEXP, SEXP beta_0SEXP) {
+Rcpp::List BFMMM_warm_start(const int tot_mcmc_iters, const int k, Rcpp::Nullable<Rcpp::List> Y, Rcpp::Nullable<Rcpp::List> time, const int n_funct, const int basis_degree, const int n_eigen, const arma::vec& boundary_knots, const arma::vec& internal_knots, const arma::cube& Z_samp, const arma::mat& pi_samp, const arma::vec& alpha_3_samp, const arma::cube& delta_samp, const BayesFMMM::CubeList& gamma_samp, const BayesFMMM::CubeList& Phi_samp, const arma::cube& A_samp, const arma::cube& nu_samp, const arma::mat& tau_samp, const arma::vec& sigma_samp, const arma::cube& chi_samp, const double burnin_prop, Rcpp::Nullable<Rcpp::CharacterVector> dir, const double thinning_num, const double beta_N_t, int N_t, int n_temp_trans, int r_stored_iters, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double nu_1, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0, Rcpp::Nullable<Rcpp::List> control);
+RcppExport SEXP _BayesFMMM_BFMMM_warm_start(SEXP tot_mcmc_itersSEXP, SEXP kSEXP, SEXP YSEXP, SEXP timeSEXP, SEXP n_functSEXP, SEXP basis_degreeSEXP, SEXP n_eigenSEXP, SEXP boundary_knotsSEXP, SEXP internal_knotsSEXP, SEXP Z_sampSEXP, SEXP pi_sampSEXP, SEXP alpha_3_sampSEXP, SEXP delta_sampSEXP, SEXP gamma_sampSEXP, SEXP Phi_sampSEXP, SEXP A_sampSEXP, SEXP nu_sampSEXP, SEXP tau_sampSEXP, SEXP sigma_sampSEXP, SEXP chi_sampSEXP, SEXP burnin_propSEXP, SEXP dirSEXP, SEXP thinning_numSEXP, SEXP beta_N_tSEXP, SEXP N_tSEXP, SEXP n_temp_transSEXP, SEXP r_stored_itersSEXP, SEXP cSEXP, SEXP bSEXP, SEXP nu_1SEXP, SEXP alpha1lSEXP, SEXP alpha2lSEXP, SEXP beta1lSEXP, SEXP beta2lSEXP, SEXP a_Z_PMSEXP, SEXP a_pi_PMSEXP, SEXP var_alpha3SEXP, SEXP var_epsilon1SEXP, SEXP var_epsilon2SEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_0SEXP, SEXP beta_0SEXP, SEXP controlSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const int >::type tot_mcmc_iters(tot_mcmc_itersSEXP);
     Rcpp::traits::input_parameter< const int >::type k(kSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type time(timeSEXP);
     Rcpp::traits::input_parameter< const int >::type n_funct(n_functSEXP);
     Rcpp::traits::input_parameter< const int >::type basis_degree(basis_degreeSEXP);
     Rcpp::traits::input_parameter< const int >::type n_eigen(n_eigenSEXP);
-    Rcpp::traits::input_parameter< const arma::vec >::type boundary_knots(boundary_knotsSEXP);
-    Rcpp::traits::input_parameter< const arma::vec >::type internal_knots(internal_knotsSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type Z_samp(Z_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::mat >::type pi_samp(pi_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::vec >::type alpha_3_samp(alpha_3_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type delta_samp(delta_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::cube> >::type gamma_samp(gamma_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::cube> >::type Phi_samp(Phi_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type A_samp(A_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type nu_samp(nu_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::mat >::type tau_samp(tau_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::vec >::type sigma_samp(sigma_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type chi_samp(chi_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type boundary_knots(boundary_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type internal_knots(internal_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type Z_samp(Z_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type pi_samp(pi_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type alpha_3_samp(alpha_3_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type delta_samp(delta_sampSEXP);
+    Rcpp::traits::input_parameter< const BayesFMMM::CubeList& >::type gamma_samp(gamma_sampSEXP);
+    Rcpp::traits::input_parameter< const BayesFMMM::CubeList& >::type Phi_samp(Phi_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type A_samp(A_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type nu_samp(nu_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type tau_samp(tau_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type sigma_samp(sigma_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type chi_samp(chi_sampSEXP);
     Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
     Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::CharacterVector> >::type dir(dirSEXP);
     Rcpp::traits::input_parameter< const double >::type thinning_num(thinning_numSEXP);
@@ -420,7 +657,111 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const double >::type beta(betaSEXP);
     Rcpp::traits::input_parameter< const double >::type alpha_0(alpha_0SEXP);
     Rcpp::traits::input_parameter< const double >::type beta_0(beta_0SEXP);
-    rcpp_result_gen = Rcpp::wrap(BFMMM_warm_start(tot_mcmc_iters, k, Y, time, n_funct, basis_degree, n_eigen, boundary_knots, internal_knots, Z_samp, pi_samp, alpha_3_samp, delta_samp, gamma_samp, Phi_samp, A_samp, nu_samp, tau_samp, sigma_samp, chi_samp, burnin_prop, dir, thinning_num, beta_N_t, N_t, n_temp_trans, r_stored_iters, c, b, nu_1, alpha1l, alpha2l, beta1l, beta2l, a_Z_PM, a_pi_PM, var_alpha3, var_epsilon1, var_epsilon2, alpha, beta, alpha_0, beta_0));
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type control(controlSEXP);
+    rcpp_result_gen = Rcpp::wrap(BFMMM_warm_start(tot_mcmc_iters, k, Y, time, n_funct, basis_degree, n_eigen, boundary_knots, internal_knots, Z_samp, pi_samp, alpha_3_samp, delta_samp, gamma_samp, Phi_samp, A_samp, nu_samp, tau_samp, sigma_samp, chi_samp, burnin_prop, dir, thinning_num, beta_N_t, N_t, n_temp_trans, r_stored_iters, c, b, nu_1, alpha1l, alpha2l, beta1l, beta2l, a_Z_PM, a_pi_PM, var_alpha3, var_epsilon1, var_epsilon2, alpha, beta, alpha_0, beta_0, control));
+    return rcpp_result_gen;
+END_RCPP
+}
+// BFMMM_warm_start_incremental
+Rcpp::List BFMMM_warm_start_incremental(const int tot_mcmc_iters, const int k, const arma::field<arma::vec>& Y, const arma::field<arma::vec>& time, const int n_funct, const int basis_degree, const int n_eigen, const arma::vec& boundary_knots, const arma::vec& internal_knots, const std::string post_dir, const int n_files, const double burnin_prop, const int score_iters, const int score_warmup, const double score_a_Z_PM, Rcpp::Nullable<Rcpp::CharacterVector> dir, const double thinning_num, const double beta_N_t, int N_t, int n_temp_trans, int r_stored_iters, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double nu_1, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0, Rcpp::Nullable<Rcpp::List> control);
+RcppExport SEXP _BayesFMMM_BFMMM_warm_start_incremental(SEXP tot_mcmc_itersSEXP, SEXP kSEXP, SEXP YSEXP, SEXP timeSEXP, SEXP n_functSEXP, SEXP basis_degreeSEXP, SEXP n_eigenSEXP, SEXP boundary_knotsSEXP, SEXP internal_knotsSEXP, SEXP post_dirSEXP, SEXP n_filesSEXP, SEXP burnin_propSEXP, SEXP score_itersSEXP, SEXP score_warmupSEXP, SEXP score_a_Z_PMSEXP, SEXP dirSEXP, SEXP thinning_numSEXP, SEXP beta_N_tSEXP, SEXP N_tSEXP, SEXP n_temp_transSEXP, SEXP r_stored_itersSEXP, SEXP cSEXP, SEXP bSEXP, SEXP nu_1SEXP, SEXP alpha1lSEXP, SEXP alpha2lSEXP, SEXP beta1lSEXP, SEXP beta2lSEXP, SEXP a_Z_PMSEXP, SEXP a_pi_PMSEXP, SEXP var_alpha3SEXP, SEXP var_epsilon1SEXP, SEXP var_epsilon2SEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_0SEXP, SEXP beta_0SEXP, SEXP controlSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const int >::type tot_mcmc_iters(tot_mcmc_itersSEXP);
+    Rcpp::traits::input_parameter< const int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_funct(n_functSEXP);
+    Rcpp::traits::input_parameter< const int >::type basis_degree(basis_degreeSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_eigen(n_eigenSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type boundary_knots(boundary_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type internal_knots(internal_knotsSEXP);
+    Rcpp::traits::input_parameter< const std::string >::type post_dir(post_dirSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_files(n_filesSEXP);
+    Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
+    Rcpp::traits::input_parameter< const int >::type score_iters(score_itersSEXP);
+    Rcpp::traits::input_parameter< const int >::type score_warmup(score_warmupSEXP);
+    Rcpp::traits::input_parameter< const double >::type score_a_Z_PM(score_a_Z_PMSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::CharacterVector> >::type dir(dirSEXP);
+    Rcpp::traits::input_parameter< const double >::type thinning_num(thinning_numSEXP);
+    Rcpp::traits::input_parameter< const double >::type beta_N_t(beta_N_tSEXP);
+    Rcpp::traits::input_parameter< int >::type N_t(N_tSEXP);
+    Rcpp::traits::input_parameter< int >::type n_temp_trans(n_temp_transSEXP);
+    Rcpp::traits::input_parameter< int >::type r_stored_iters(r_stored_itersSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::NumericVector> >::type c(cSEXP);
+    Rcpp::traits::input_parameter< const double >::type b(bSEXP);
+    Rcpp::traits::input_parameter< const double >::type nu_1(nu_1SEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha1l(alpha1lSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha2l(alpha2lSEXP);
+    Rcpp::traits::input_parameter< const double >::type beta1l(beta1lSEXP);
+    Rcpp::traits::input_parameter< const double >::type beta2l(beta2lSEXP);
+    Rcpp::traits::input_parameter< const double >::type a_Z_PM(a_Z_PMSEXP);
+    Rcpp::traits::input_parameter< const double >::type a_pi_PM(a_pi_PMSEXP);
+    Rcpp::traits::input_parameter< const double >::type var_alpha3(var_alpha3SEXP);
+    Rcpp::traits::input_parameter< const double >::type var_epsilon1(var_epsilon1SEXP);
+    Rcpp::traits::input_parameter< const double >::type var_epsilon2(var_epsilon2SEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< const double >::type beta(betaSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha_0(alpha_0SEXP);
+    Rcpp::traits::input_parameter< const double >::type beta_0(beta_0SEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type control(controlSEXP);
+    rcpp_result_gen = Rcpp::wrap(BFMMM_warm_start_incremental(tot_mcmc_iters, k, Y, time, n_funct, basis_degree, n_eigen, boundary_knots, internal_knots, post_dir, n_files, burnin_prop, score_iters, score_warmup, score_a_Z_PM, dir, thinning_num, beta_N_t, N_t, n_temp_trans, r_stored_iters, c, b, nu_1, alpha1l, alpha2l, beta1l, beta2l, a_Z_PM, a_pi_PM, var_alpha3, var_epsilon1, var_epsilon2, alpha, beta, alpha_0, beta_0, control));
+    return rcpp_result_gen;
+END_RCPP
+}
+// BFMMM_CovariateAdj_warm_start
+Rcpp::List BFMMM_CovariateAdj_warm_start(const int tot_mcmc_iters, const int k, const arma::field<arma::vec>& Y, const arma::field<arma::vec>& time, const arma::mat& X, const int n_funct, const int basis_degree, const int n_eigen, const arma::vec& boundary_knots, const arma::vec& internal_knots, const arma::cube& Z_samp, const arma::mat& pi_samp, const arma::vec& alpha_3_samp, const arma::cube& delta_samp, const BayesFMMM::CubeList& gamma_samp, const BayesFMMM::CubeList& Phi_samp, const arma::cube& A_samp, const arma::cube& nu_samp, const arma::mat& tau_samp, const arma::vec& sigma_samp, const arma::cube& chi_samp, const double burnin_prop, Rcpp::Nullable<Rcpp::CharacterVector> dir, const double thinning_num, const double beta_N_t, int N_t, int n_temp_trans, int r_stored_iters, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double nu_1, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0, Rcpp::Nullable<Rcpp::List> control);
+RcppExport SEXP _BayesFMMM_BFMMM_CovariateAdj_warm_start(SEXP tot_mcmc_itersSEXP, SEXP kSEXP, SEXP YSEXP, SEXP timeSEXP, SEXP XSEXP, SEXP n_functSEXP, SEXP basis_degreeSEXP, SEXP n_eigenSEXP, SEXP boundary_knotsSEXP, SEXP internal_knotsSEXP, SEXP Z_sampSEXP, SEXP pi_sampSEXP, SEXP alpha_3_sampSEXP, SEXP delta_sampSEXP, SEXP gamma_sampSEXP, SEXP Phi_sampSEXP, SEXP A_sampSEXP, SEXP nu_sampSEXP, SEXP tau_sampSEXP, SEXP sigma_sampSEXP, SEXP chi_sampSEXP, SEXP burnin_propSEXP, SEXP dirSEXP, SEXP thinning_numSEXP, SEXP beta_N_tSEXP, SEXP N_tSEXP, SEXP n_temp_transSEXP, SEXP r_stored_itersSEXP, SEXP cSEXP, SEXP bSEXP, SEXP nu_1SEXP, SEXP alpha1lSEXP, SEXP alpha2lSEXP, SEXP beta1lSEXP, SEXP beta2lSEXP, SEXP a_Z_PMSEXP, SEXP a_pi_PMSEXP, SEXP var_alpha3SEXP, SEXP var_epsilon1SEXP, SEXP var_epsilon2SEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_0SEXP, SEXP beta_0SEXP, SEXP controlSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const int >::type tot_mcmc_iters(tot_mcmc_itersSEXP);
+    Rcpp::traits::input_parameter< const int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_funct(n_functSEXP);
+    Rcpp::traits::input_parameter< const int >::type basis_degree(basis_degreeSEXP);
+    Rcpp::traits::input_parameter< const int >::type n_eigen(n_eigenSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type boundary_knots(boundary_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type internal_knots(internal_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type Z_samp(Z_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type pi_samp(pi_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type alpha_3_samp(alpha_3_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type delta_samp(delta_sampSEXP);
+    Rcpp::traits::input_parameter< const BayesFMMM::CubeList& >::type gamma_samp(gamma_sampSEXP);
+    Rcpp::traits::input_parameter< const BayesFMMM::CubeList& >::type Phi_samp(Phi_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type A_samp(A_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type nu_samp(nu_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type tau_samp(tau_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type sigma_samp(sigma_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type chi_samp(chi_sampSEXP);
+    Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::CharacterVector> >::type dir(dirSEXP);
+    Rcpp::traits::input_parameter< const double >::type thinning_num(thinning_numSEXP);
+    Rcpp::traits::input_parameter< const double >::type beta_N_t(beta_N_tSEXP);
+    Rcpp::traits::input_parameter< int >::type N_t(N_tSEXP);
+    Rcpp::traits::input_parameter< int >::type n_temp_trans(n_temp_transSEXP);
+    Rcpp::traits::input_parameter< int >::type r_stored_iters(r_stored_itersSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::NumericVector> >::type c(cSEXP);
+    Rcpp::traits::input_parameter< const double >::type b(bSEXP);
+    Rcpp::traits::input_parameter< const double >::type nu_1(nu_1SEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha1l(alpha1lSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha2l(alpha2lSEXP);
+    Rcpp::traits::input_parameter< const double >::type beta1l(beta1lSEXP);
+    Rcpp::traits::input_parameter< const double >::type beta2l(beta2lSEXP);
+    Rcpp::traits::input_parameter< const double >::type a_Z_PM(a_Z_PMSEXP);
+    Rcpp::traits::input_parameter< const double >::type a_pi_PM(a_pi_PMSEXP);
+    Rcpp::traits::input_parameter< const double >::type var_alpha3(var_alpha3SEXP);
+    Rcpp::traits::input_parameter< const double >::type var_epsilon1(var_epsilon1SEXP);
+    Rcpp::traits::input_parameter< const double >::type var_epsilon2(var_epsilon2SEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< const double >::type beta(betaSEXP);
+    Rcpp::traits::input_parameter< const double >::type alpha_0(alpha_0SEXP);
+    Rcpp::traits::input_parameter< const double >::type beta_0(beta_0SEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type control(controlSEXP);
+    rcpp_result_gen = Rcpp::wrap(BFMMM_CovariateAdj_warm_start(tot_mcmc_iters, k, Y, time, X, n_funct, basis_degree, n_eigen, boundary_knots, internal_knots, Z_samp, pi_samp, alpha_3_samp, delta_samp, gamma_samp, Phi_samp, A_samp, nu_samp, tau_samp, sigma_samp, chi_samp, burnin_prop, dir, thinning_num, beta_N_t, N_t, n_temp_trans, r_stored_iters, c, b, nu_1, alpha1l, alpha2l, beta1l, beta2l, a_Z_PM, a_pi_PM, var_alpha3, var_epsilon1, var_epsilon2, alpha, beta, alpha_0, beta_0, control));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -490,8 +831,75 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// ReadCubeFiles
+arma::cube ReadCubeFiles(std::string dir, std::string name, int n_files);
+RcppExport SEXP _BayesFMMM_ReadCubeFiles(SEXP dirSEXP, SEXP nameSEXP, SEXP n_filesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type dir(dirSEXP);
+    Rcpp::traits::input_parameter< std::string >::type name(nameSEXP);
+    Rcpp::traits::input_parameter< int >::type n_files(n_filesSEXP);
+    rcpp_result_gen = Rcpp::wrap(ReadCubeFiles(dir, name, n_files));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ReadFieldCubeFiles
+arma::field<arma::cube> ReadFieldCubeFiles(std::string dir, std::string name, int n_files);
+RcppExport SEXP _BayesFMMM_ReadFieldCubeFiles(SEXP dirSEXP, SEXP nameSEXP, SEXP n_filesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type dir(dirSEXP);
+    Rcpp::traits::input_parameter< std::string >::type name(nameSEXP);
+    Rcpp::traits::input_parameter< int >::type n_files(n_filesSEXP);
+    rcpp_result_gen = Rcpp::wrap(ReadFieldCubeFiles(dir, name, n_files));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ReadVecFiles
+arma::vec ReadVecFiles(std::string dir, std::string name, int n_files);
+RcppExport SEXP _BayesFMMM_ReadVecFiles(SEXP dirSEXP, SEXP nameSEXP, SEXP n_filesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type dir(dirSEXP);
+    Rcpp::traits::input_parameter< std::string >::type name(nameSEXP);
+    Rcpp::traits::input_parameter< int >::type n_files(n_filesSEXP);
+    rcpp_result_gen = Rcpp::wrap(ReadVecFiles(dir, name, n_files));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ConvertSampleDir
+Rcpp::IntegerVector ConvertSampleDir(std::string dir, std::string out_dir, std::string codec, double codec_tol);
+RcppExport SEXP _BayesFMMM_ConvertSampleDir(SEXP dirSEXP, SEXP out_dirSEXP, SEXP codecSEXP, SEXP codec_tolSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type dir(dirSEXP);
+    Rcpp::traits::input_parameter< std::string >::type out_dir(out_dirSEXP);
+    Rcpp::traits::input_parameter< std::string >::type codec(codecSEXP);
+    Rcpp::traits::input_parameter< double >::type codec_tol(codec_tolSEXP);
+    rcpp_result_gen = Rcpp::wrap(ConvertSampleDir(dir, out_dir, codec, codec_tol));
+    return rcpp_result_gen;
+END_RCPP
+}
+// WriteObsStore
+int WriteObsStore(const arma::field<arma::vec>& Y, const arma::field<arma::vec>& time, std::string file, bool append);
+RcppExport SEXP _BayesFMMM_WriteObsStore(SEXP YSEXP, SEXP timeSEXP, SEXP fileSEXP, SEXP appendSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< std::string >::type file(fileSEXP);
+    Rcpp::traits::input_parameter< bool >::type append(appendSEXP);
+    rcpp_result_gen = Rcpp::wrap(WriteObsStore(Y, time, file, append));
+    return rcpp_result_gen;
+END_RCPP
+}
 // BHDFMMM_Nu_Z_multiple_try
-Rcpp::List BHDFMMM_Nu_Z_multiple_try(const int tot_mcmc_iters, const int n_try, const int k, const arma::field<arma::vec> Y, const arma::field<arma::mat> time, const int n_funct, const arma::vec basis_degree, const int n_eigen, const arma::mat boundary_knots, const arma::field<arma::vec> internal_knots, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0);
+Rcpp::List BHDFMMM_Nu_Z_multiple_try(const int tot_mcmc_iters, const int n_try, const int k, const arma::field<arma::vec>& Y, const arma::field<arma::mat>& time, const int n_funct, const arma::vec& basis_degree, const int n_eigen, const arma::mat& boundary_knots, const arma::field<arma::vec>& internal_knots, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0);
 RcppExport SEXP _BayesFMMM_BHDFMMM_Nu_Z_multiple_try(SEXP tot_mcmc_itersSEXP, SEXP n_trySEXP, SEXP kSEXP, SEXP YSEXP, SEXP timeSEXP, SEXP n_functSEXP, SEXP basis_degreeSEXP, SEXP n_eigenSEXP, SEXP boundary_knotsSEXP, SEXP internal_knotsSEXP, SEXP cSEXP, SEXP bSEXP, SEXP alpha1lSEXP, SEXP alpha2lSEXP, SEXP beta1lSEXP, SEXP beta2lSEXP, SEXP a_Z_PMSEXP, SEXP a_pi_PMSEXP, SEXP var_alpha3SEXP, SEXP var_epsilon1SEXP, SEXP var_epsilon2SEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_0SEXP, SEXP beta_0SEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -499,13 +907,13 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const int >::type tot_mcmc_iters(tot_mcmc_itersSEXP);
     Rcpp::traits::input_parameter< const int >::type n_try(n_trySEXP);
     Rcpp::traits::input_parameter< const int >::type k(kSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::mat> >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::mat>& >::type time(timeSEXP);
     Rcpp::traits::input_parameter< const int >::type n_funct(n_functSEXP);
-    Rcpp::traits::input_parameter< const arma::vec >::type basis_degree(basis_degreeSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type basis_degree(basis_degreeSEXP);
     Rcpp::traits::input_parameter< const int >::type n_eigen(n_eigenSEXP);
-    Rcpp::traits::input_parameter< const arma::mat >::type boundary_knots(boundary_knotsSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type internal_knots(internal_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type boundary_knots(boundary_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type internal_knots(internal_knotsSEXP);
     Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::NumericVector> >::type c(cSEXP);
     Rcpp::traits::input_parameter< const double >::type b(bSEXP);
     Rcpp::traits::input_parameter< const double >::type alpha1l(alpha1lSEXP);
@@ -526,7 +934,7 @@ BEGIN_RCPP
 END_RCPP
 }
 // BHDFMMM_Theta_est
-Rcpp::List BHDFMMM_Theta_est(const int tot_mcmc_iters, const int n_try, const int k, const arma::field<arma::vec> Y, const arma::field<arma::mat> time, const int n_funct, const arma::vec basis_degree, const int n_eigen, const arma::mat boundary_knots, const arma::field<arma::vec> internal_knots, const arma::cube Z_samp, const arma::cube nu_samp, const double burnin_prop, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double nu_1, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0);
+Rcpp::List BHDFMMM_Theta_est(const int tot_mcmc_iters, const int n_try, const int k, const arma::field<arma::vec>& Y, const arma::field<arma::mat>& time, const int n_funct, const arma::vec& basis_degree, const int n_eigen, const arma::mat& boundary_knots, const arma::field<arma::vec>& internal_knots, const arma::cube& Z_samp, const arma::cube& nu_samp, const double burnin_prop, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double nu_1, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0);
 RcppExport SEXP _BayesFMMM_BHDFMMM_Theta_est(SEXP tot_mcmc_itersSEXP, SEXP n_trySEXP, SEXP kSEXP, SEXP YSEXP, SEXP timeSEXP, SEXP n_functSEXP, SEXP basis_degreeSEXP, SEXP n_eigenSEXP, SEXP boundary_knotsSEXP, SEXP internal_knotsSEXP, SEXP Z_sampSEXP, SEXP nu_sampSEXP, SEXP burnin_propSEXP, SEXP cSEXP, SEXP bSEXP, SEXP nu_1SEXP, SEXP alpha1lSEXP, SEXP alpha2lSEXP, SEXP beta1lSEXP, SEXP beta2lSEXP, SEXP a_Z_PMSEXP, SEXP a_pi_PMSEXP, SEXP var_alpha3SEXP, SEXP var_epsilon1SEXP, SEXP var_epsilon2SEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_0SEXP, SEXP beta_0SEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -534,15 +942,15 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const int >::type tot_mcmc_iters(tot_mcmc_itersSEXP);
     Rcpp::traits::input_parameter< const int >::type n_try(n_trySEXP);
     Rcpp::traits::input_parameter< const int >::type k(kSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::mat> >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::mat>& >::type time(timeSEXP);
     Rcpp::traits::input_parameter< const int >::type n_funct(n_functSEXP);
-    Rcpp::traits::input_parameter< const arma::vec >::type basis_degree(basis_degreeSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type basis_degree(basis_degreeSEXP);
     Rcpp::traits::input_parameter< const int >::type n_eigen(n_eigenSEXP);
-    Rcpp::traits::input_parameter< const arma::mat >::type boundary_knots(boundary_knotsSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type internal_knots(internal_knotsSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type Z_samp(Z_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type nu_samp(nu_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type boundary_knots(boundary_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type internal_knots(internal_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type Z_samp(Z_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type nu_samp(nu_sampSEXP);
     Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
     Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::NumericVector> >::type c(cSEXP);
     Rcpp::traits::input_parameter< const double >::type b(bSEXP);
@@ -565,31 +973,31 @@ BEGIN_RCPP
 END_RCPP
 }
 // BHDFMMM_warm_start
-Rcpp::List BHDFMMM_warm_start(const int tot_mcmc_iters, const int k, const arma::field<arma::vec> Y, const arma::field<arma::mat> time, const int n_funct, const arma::vec basis_degree, const int n_eigen, const arma::mat boundary_knots, const arma::field<arma::vec> internal_knots, const arma::cube Z_samp, const arma::mat pi_samp, const arma::vec alpha_3_samp, const arma::cube delta_samp, const arma::field<arma::cube> gamma_samp, const arma::field<arma::cube> Phi_samp, const arma::cube A_samp, const arma::cube nu_samp, const arma::mat tau_samp, const arma::vec sigma_samp, const arma::cube chi_samp, const double burnin_prop, Rcpp::Nullable<Rcpp::CharacterVector> dir, const double thinning_num, const double beta_N_t, int N_t, int n_temp_trans, int r_stored_iters, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double nu_1, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0);
-RcppExport SEXP _BayesFMMM_BHDFMMM_warm_start(SEXP tot_mcmc_itersSEXP, SEXP kSEXP, SEXP YSEXP, SEXP timeSEXP, SEXP n_functSEXP, SEXP basis_degreeSEXP, SEXP n_eigenSEXP, SEXP boundary_knotsSEXP, SEXP internal_knotsSEXP, SEXP Z_sampSEXP, SEXP pi_sampSEXP, SEXP alpha_3_sampSEXP, SEXP delta_sampSEXP, SEXP gamma_sampSEXP, SEXP Phi_sampSEXP, SEXP A_sampSEXP, SEXP nu_sampSEXP, SEXP tau_sampSEXP, SEXP sigma_sampSEXP, SEXP chi_sampSEXP, SEXP burnin_propSEXP, SEXP dirSEXP, SEXP thinning_numSEXP, SEXP beta_N_tSEXP, SEXP N_tSEXP, SEXP n_temp_transSEXP, SEXP r_stored_itersSEXP, SEXP cSEXP, SEXP bSEXP, SEXP nu_1SEXP, SEXP alpha1lSEXP, SEXP alpha2lSEXP, SEXP beta1lSEXP, SEXP beta2lSEXP, SEXP a_Z_PMSEXP, SEXP a_pi_PMSEXP, SEXP var_alpha3SEXP, SEXP var_epsilon1SEXP, SEXP var_epsilon2SEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_0SEXP, SEXP beta_0SEXP) {
+Rcpp::List BHDFMMM_warm_start(const int tot_mcmc_iters, const int k, const arma::field<arma::vec>& Y, const arma::field<arma::mat>& time, const int n_funct, const arma::vec& basis_degree, const int n_eigen, const arma::mat& boundary_knots, const arma::field<arma::vec>& internal_knots, const arma::cube& Z_samp, const arma::mat& pi_samp, const arma::vec& alpha_3_samp, const arma::cube& delta_samp, const BayesFMMM::CubeList& gamma_samp, const BayesFMMM::CubeList& Phi_samp, const arma::cube& A_samp, const arma::cube& nu_samp, const arma::mat& tau_samp, const arma::vec& sigma_samp, const arma::cube& chi_samp, const double burnin_prop, Rcpp::Nullable<Rcpp::CharacterVector> dir, const double thinning_num, const double beta_N_t, int N_t, int n_temp_trans, int r_stored_iters, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double nu_1, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0, Rcpp::Nullable<Rcpp::List> control);
+RcppExport SEXP _BayesFMMM_BHDFMMM_warm_start(SEXP tot_mcmc_itersSEXP, SEXP kSEXP, SEXP YSEXP, SEXP timeSEXP, SEXP n_functSEXP, SEXP basis_degreeSEXP, SEXP n_eigenSEXP, SEXP boundary_knotsSEXP, SEXP internal_knotsSEXP, SEXP Z_sampSEXP, SEXP pi_sampSEXP, SEXP alpha_3_sampSEXP, SEXP delta_sampSEXP, SEXP gamma_sampSEXP, SEXP Phi_sampSEXP, SEXP A_sampSEXP, SEXP nu_sampSEXP, SEXP tau_sampSEXP, SEXP sigma_sampSEXP, SEXP chi_sampSEXP, SEXP burnin_propSEXP, SEXP dirSEXP, SEXP thinning_numSEXP, SEXP beta_N_tSEXP, SEXP N_tSEXP, SEXP n_temp_transSEXP, SEXP r_stored_itersSEXP, SEXP cSEXP, SEXP bSEXP, SEXP nu_1SEXP, SEXP alpha1lSEXP, SEXP alpha2lSEXP, SEXP beta1lSEXP, SEXP beta2lSEXP, SEXP a_Z_PMSEXP, SEXP a_pi_PMSEXP, SEXP var_alpha3SEXP, SEXP var_epsilon1SEXP, SEXP var_epsilon2SEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_0SEXP, SEXP beta_0SEXP, SEXP controlSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const int >::type tot_mcmc_iters(tot_mcmc_itersSEXP);
     Rcpp::traits::input_parameter< const int >::type k(kSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type Y(YSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::mat> >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::mat>& >::type time(timeSEXP);
     Rcpp::traits::input_parameter< const int >::type n_funct(n_functSEXP);
-    Rcpp::traits::input_parameter< const arma::vec >::type basis_degree(basis_degreeSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type basis_degree(basis_degreeSEXP);
     Rcpp::traits::input_parameter< const int >::type n_eigen(n_eigenSEXP);
-    Rcpp::traits::input_parameter< const arma::mat >::type boundary_knots(boundary_knotsSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::vec> >::type internal_knots(internal_knotsSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type Z_samp(Z_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::mat >::type pi_samp(pi_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::vec >::type alpha_3_samp(alpha_3_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type delta_samp(delta_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::cube> >::type gamma_samp(gamma_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::cube> >::type Phi_samp(Phi_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type A_samp(A_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type nu_samp(nu_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::mat >::type tau_samp(tau_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::vec >::type sigma_samp(sigma_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type chi_samp(chi_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type boundary_knots(boundary_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::field<arma::vec>& >::type internal_knots(internal_knotsSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type Z_samp(Z_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type pi_samp(pi_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type alpha_3_samp(alpha_3_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type delta_samp(delta_sampSEXP);
+    Rcpp::traits::input_parameter< const BayesFMMM::CubeList& >::type gamma_samp(gamma_sampSEXP);
+    Rcpp::traits::input_parameter< const BayesFMMM::CubeList& >::type Phi_samp(Phi_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type A_samp(A_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type nu_samp(nu_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type tau_samp(tau_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type sigma_samp(sigma_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type chi_samp(chi_sampSEXP);
     Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
     Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::CharacterVector> >::type dir(dirSEXP);
     Rcpp::traits::input_parameter< const double >::type thinning_num(thinning_numSEXP);
@@ -613,12 +1021,13 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const double >::type beta(betaSEXP);
     Rcpp::traits::input_parameter< const double >::type alpha_0(alpha_0SEXP);
     Rcpp::traits::input_parameter< const double >::type beta_0(beta_0SEXP);
-    rcpp_result_gen = Rcpp::wrap(BHDFMMM_warm_start(tot_mcmc_iters, k, Y, time, n_funct, basis_degree, n_eigen, boundary_knots, internal_knots, Z_samp, pi_samp, alpha_3_samp, delta_samp, gamma_samp, Phi_samp, A_samp, nu_samp, tau_samp, sigma_samp, chi_samp, burnin_prop, dir, thinning_num, beta_N_t, N_t, n_temp_trans, r_stored_iters, c, b, nu_1, alpha1l, alpha2l, beta1l, beta2l, a_Z_PM, a_pi_PM, var_alpha3, var_epsilon1, var_epsilon2, alpha, beta, alpha_0, beta_0));
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type control(controlSEXP);
+    rcpp_result_gen = Rcpp::wrap(BHDFMMM_warm_start(tot_mcmc_iters, k, Y, time, n_funct, basis_degree, n_eigen, boundary_knots, internal_knots, Z_samp, pi_samp, alpha_3_samp, delta_samp, gamma_samp, Phi_samp, A_samp, nu_samp, tau_samp, sigma_samp, chi_samp, burnin_prop, dir, thinning_num, beta_N_t, N_t, n_temp_trans, r_stored_iters, c, b, nu_1, alpha1l, alpha2l, beta1l, beta2l, a_Z_PM, a_pi_PM, var_alpha3, var_epsilon1, var_epsilon2, alpha, beta, alpha_0, beta_0, control));
     return rcpp_result_gen;
 END_RCPP
 }
 // BMVMMM_Nu_Z_multiple_try
-Rcpp::List BMVMMM_Nu_Z_multiple_try(const int tot_mcmc_iters, const int n_try, const int k, const arma::mat Y, const int n_eigen, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0);
+Rcpp::List BMVMMM_Nu_Z_multiple_try(const int tot_mcmc_iters, const int n_try, const int k, const arma::mat& Y, const int n_eigen, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0);
 RcppExport SEXP _BayesFMMM_BMVMMM_Nu_Z_multiple_try(SEXP tot_mcmc_itersSEXP, SEXP n_trySEXP, SEXP kSEXP, SEXP YSEXP, SEXP n_eigenSEXP, SEXP cSEXP, SEXP bSEXP, SEXP alpha1lSEXP, SEXP alpha2lSEXP, SEXP beta1lSEXP, SEXP beta2lSEXP, SEXP a_Z_PMSEXP, SEXP a_pi_PMSEXP, SEXP var_alpha3SEXP, SEXP var_epsilon1SEXP, SEXP var_epsilon2SEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_0SEXP, SEXP beta_0SEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -626,7 +1035,7 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const int >::type tot_mcmc_iters(tot_mcmc_itersSEXP);
     Rcpp::traits::input_parameter< const int >::type n_try(n_trySEXP);
     Rcpp::traits::input_parameter< const int >::type k(kSEXP);
-    Rcpp::traits::input_parameter< const arma::mat >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
     Rcpp::traits::input_parameter< const int >::type n_eigen(n_eigenSEXP);
     Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::NumericVector> >::type c(cSEXP);
     Rcpp::traits::input_parameter< const double >::type b(bSEXP);
@@ -648,7 +1057,7 @@ BEGIN_RCPP
 END_RCPP
 }
 // BMVMMM_Theta_est
-Rcpp::List BMVMMM_Theta_est(const int tot_mcmc_iters, const int n_try, const int k, const arma::mat Y, const int n_eigen, const arma::cube Z_samp, const arma::cube nu_samp, const double burnin_prop, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double nu_1, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0);
+Rcpp::List BMVMMM_Theta_est(const int tot_mcmc_iters, const int n_try, const int k, const arma::mat& Y, const int n_eigen, const arma::cube& Z_samp, const arma::cube& nu_samp, const double burnin_prop, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double nu_1, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0);
 RcppExport SEXP _BayesFMMM_BMVMMM_Theta_est(SEXP tot_mcmc_itersSEXP, SEXP n_trySEXP, SEXP kSEXP, SEXP YSEXP, SEXP n_eigenSEXP, SEXP Z_sampSEXP, SEXP nu_sampSEXP, SEXP burnin_propSEXP, SEXP cSEXP, SEXP bSEXP, SEXP nu_1SEXP, SEXP alpha1lSEXP, SEXP alpha2lSEXP, SEXP beta1lSEXP, SEXP beta2lSEXP, SEXP a_Z_PMSEXP, SEXP a_pi_PMSEXP, SEXP var_alpha3SEXP, SEXP var_epsilon1SEXP, SEXP var_epsilon2SEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_0SEXP, SEXP beta_0SEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -656,10 +1065,10 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const int >::type tot_mcmc_iters(tot_mcmc_itersSEXP);
     Rcpp::traits::input_parameter< const int >::type n_try(n_trySEXP);
     Rcpp::traits::input_parameter< const int >::type k(kSEXP);
-    Rcpp::traits::input_parameter< const arma::mat >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
     Rcpp::traits::input_parameter< const int >::type n_eigen(n_eigenSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type Z_samp(Z_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type nu_samp(nu_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type Z_samp(Z_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type nu_samp(nu_sampSEXP);
     Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
     Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::NumericVector> >::type c(cSEXP);
     Rcpp::traits::input_parameter< const double >::type b(bSEXP);
@@ -682,26 +1091,26 @@ BEGIN_RCPP
 END_RCPP
 }
 // BMVMMM_warm_start
-Rcpp::List BMVMMM_warm_start(const int tot_mcmc_iters, const int k, const arma::mat Y, const int n_eigen, const arma::cube Z_samp, const arma::mat pi_samp, const arma::vec alpha_3_samp, const arma::cube delta_samp, const arma::field<arma::cube> gamma_samp, const arma::field<arma::cube> Phi_samp, const arma::cube A_samp, const arma::cube nu_samp, const arma::mat tau_samp, const arma::vec sigma_samp, const arma::cube chi_samp, const double burnin_prop, Rcpp::Nullable<Rcpp::CharacterVector> dir, const double thinning_num, const double beta_N_t, int N_t, int n_temp_trans, int r_stored_iters, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double nu_1, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0);
-RcppExport SEXP _BayesFMMM_BMVMMM_warm_start(SEXP tot_mcmc_itersSEXP, SEXP kSEXP, SEXP YSEXP, SEXP n_eigenSEXP, SEXP Z_sampSEXP, SEXP pi_sampSEXP, SEXP alpha_3_sampSEXP, SEXP delta_sampSEXP, SEXP gamma_sampSEXP, SEXP Phi_sampSEXP, SEXP A_sampSEXP, SEXP nu_sampSEXP, SEXP tau_sampSEXP, SEXP sigma_sampSEXP, SEXP chi_sampSEXP, SEXP burnin_propSEXP, SEXP dirSEXP, SEXP thinning_numSEXP, SEXP beta_N_tSEXP, SEXP N_tSEXP, SEXP n_temp_transSEXP, SEXP r_stored_itersSEXP, SEXP cSEXP, SEXP bSEXP, SEXP nu_1SEXP, SEXP alpha1lSEXP, SEXP alpha2lSEXP, SEXP beta1lSEXP, SEXP beta2lSEXP, SEXP a_Z_PMSEXP, SEXP a_pi_PMSEXP, SEXP var_alpha3SEXP, SEXP var_epsilon1SEXP, SEXP var_epsilon2SEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_0SEXP, SEXP beta_0SEXP) {
+Rcpp::List BMVMMM_warm_start(const int tot_mcmc_iters, const int k, const arma::mat& Y, const int n_eigen, const arma::cube& Z_samp, const arma::mat& pi_samp, const arma::vec& alpha_3_samp, const arma::cube& delta_samp, const BayesFMMM::CubeList& gamma_samp, const BayesFMMM::CubeList& Phi_samp, const arma::cube& A_samp, const arma::cube& nu_samp, const arma::mat& tau_samp, const arma::vec& sigma_samp, const arma::cube& chi_samp, const double burnin_prop, Rcpp::Nullable<Rcpp::CharacterVector> dir, const double thinning_num, const double beta_N_t, int N_t, int n_temp_trans, int r_stored_iters, Rcpp::Nullable<Rcpp::NumericVector> c, const double b, const double nu_1, const double alpha1l, const double alpha2l, const double beta1l, const double beta2l, const double a_Z_PM, const double a_pi_PM, const double var_alpha3, const double var_epsilon1, const double var_epsilon2, const double alpha, const double beta, const double alpha_0, const double beta_0, Rcpp::Nullable<Rcpp::List> control);
+RcppExport SEXP _BayesFMMM_BMVMMM_warm_start(SEXP tot_mcmc_itersSEXP, SEXP kSEXP, SEXP YSEXP, SEXP n_eigenSEXP, SEXP Z_sampSEXP, SEXP pi_sampSEXP, SEXP alpha_3_sampSEXP, SEXP delta_sampSEXP, SEXP gamma_sampSEXP, SEXP Phi_sampSEXP, SEXP A_sampSEXP, SEXP nu_sampSEXP, SEXP tau_sampSEXP, SEXP sigma_sampSEXP, SEXP chi_sampSEXP, SEXP burnin_propSEXP, SEXP dirSEXP, SEXP thinning_numSEXP, SEXP beta_N_tSEXP, SEXP N_tSEXP, SEXP n_temp_transSEXP, SEXP r_stored_itersSEXP, SEXP cSEXP, SEXP bSEXP, SEXP nu_1SEXP, SEXP alpha1lSEXP, SEXP alpha2lSEXP, SEXP beta1lSEXP, SEXP beta2lSEXP, SEXP a_Z_PMSEXP, SEXP a_pi_PMSEXP, SEXP var_alpha3SEXP, SEXP var_epsilon1SEXP, SEXP var_epsilon2SEXP, SEXP alphaSEXP, SEXP betaSEXP, SEXP alpha_0SEXP, SEXP beta_0SEXP, SEXP controlSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const int >::type tot_mcmc_iters(tot_mcmc_itersSEXP);
     Rcpp::traits::input_parameter< const int >::type k(kSEXP);
-    Rcpp::traits::input_parameter< const arma::mat >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type Y(YSEXP);
     Rcpp::traits::input_parameter< const int >::type n_eigen(n_eigenSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type Z_samp(Z_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::mat >::type pi_samp(pi_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::vec >::type alpha_3_samp(alpha_3_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type delta_samp(delta_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::cube> >::type gamma_samp(gamma_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::field<arma::cube> >::type Phi_samp(Phi_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type A_samp(A_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type nu_samp(nu_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::mat >::type tau_samp(tau_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::vec >::type sigma_samp(sigma_sampSEXP);
-    Rcpp::traits::input_parameter< const arma::cube >::type chi_samp(chi_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type Z_samp(Z_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type pi_samp(pi_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type alpha_3_samp(alpha_3_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type delta_samp(delta_sampSEXP);
+    Rcpp::traits::input_parameter< const BayesFMMM::CubeList& >::type gamma_samp(gamma_sampSEXP);
+    Rcpp::traits::input_parameter< const BayesFMMM::CubeList& >::type Phi_samp(Phi_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type A_samp(A_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type nu_samp(nu_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type tau_samp(tau_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::vec& >::type sigma_samp(sigma_sampSEXP);
+    Rcpp::traits::input_parameter< const arma::cube& >::type chi_samp(chi_sampSEXP);
     Rcpp::traits::input_parameter< const double >::type burnin_prop(burnin_propSEXP);
     Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::CharacterVector> >::type dir(dirSEXP);
     Rcpp::traits::input_parameter< const double >::type thinning_num(thinning_numSEXP);
@@ -725,7 +1134,8 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const double >::type beta(betaSEXP);
     Rcpp::traits::input_parameter< const double >::type alpha_0(alpha_0SEXP);
     Rcpp::traits::input_parameter< const double >::type beta_0(beta_0SEXP);
-    rcpp_result_gen = Rcpp::wrap(BMVMMM_warm_start(tot_mcmc_iters, k, Y, n_eigen, Z_samp, pi_samp, alpha_3_samp, delta_samp, gamma_samp, Phi_samp, A_samp, nu_samp, tau_samp, sigma_samp, chi_samp, burnin_prop, dir, thinning_num, beta_N_t, N_t, n_temp_trans, r_stored_iters, c, b, nu_1, alpha1l, alpha2l, beta1l, beta2l, a_Z_PM, a_pi_PM, var_alpha3, var_epsilon1, var_epsilon2, alpha, beta, alpha_0, beta_0));
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type control(controlSEXP);
+    rcpp_result_gen = Rcpp::wrap(BMVMMM_warm_start(tot_mcmc_iters, k, Y, n_eigen, Z_samp, pi_samp, alpha_3_samp, delta_samp, gamma_samp, Phi_samp, A_samp, nu_samp, tau_samp, sigma_samp, chi_samp, burnin_prop, dir, thinning_num, beta_N_t, N_t, n_temp_trans, r_stored_iters, c, b, nu_1, alpha1l, alpha2l, beta1l, beta2l, a_Z_PM, a_pi_PM, var_alpha3, var_epsilon1, var_epsilon2, alpha, beta, alpha_0, beta_0, control));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -742,6 +1152,8 @@ static const R_CallMethodDef CallEntries[] = {
     {"_BayesFMMM_SigmaCI", (DL_FUNC) &_BayesFMMM_SigmaCI, 3},
     {"_BayesFMMM_ZCI", (DL_FUNC) &_BayesFMMM_ZCI, 5},
     {"_BayesFMMM_Model_DIC", (DL_FUNC) &_BayesFMMM_Model_DIC, 9},
+    {"_BayesFMMM_Model_IC", (DL_FUNC) &_BayesFMMM_Model_IC, 9},
+    {"_BayesFMMM_Model_ScoreMembership", (DL_FUNC) &_BayesFMMM_Model_ScoreMembership, 13},
     {"_BayesFMMM_Model_AIC", (DL_FUNC) &_BayesFMMM_Model_AIC, 9},
     {"_BayesFMMM_Model_BIC", (DL_FUNC) &_BayesFMMM_Model_BIC, 9},
     {"_BayesFMMM_Model_LLik", (DL_FUNC) &_BayesFMMM_Model_LLik, 8},
@@ -749,21 +1161,40 @@ static const R_CallMethodDef CallEntries[] = {
     {"_BayesFMMM_MV_Model_BIC", (DL_FUNC) &_BayesFMMM_MV_Model_BIC, 5},
     {"_BayesFMMM_MV_Model_DIC", (DL_FUNC) &_BayesFMMM_MV_Model_DIC, 5},
     {"_BayesFMMM_MV_Model_LLik", (DL_FUNC) &_BayesFMMM_MV_Model_LLik, 4},
+    {"_BayesFMMM_PosteriorSession", (DL_FUNC) &_BayesFMMM_PosteriorSession, 5},
+    {"_BayesFMMM_Session_FMeanCI", (DL_FUNC) &_BayesFMMM_Session_FMeanCI, 7},
+    {"_BayesFMMM_Session_FCovCI", (DL_FUNC) &_BayesFMMM_Session_FCovCI, 9},
+    {"_BayesFMMM_Session_ZCI", (DL_FUNC) &_BayesFMMM_Session_ZCI, 4},
+    {"_BayesFMMM_Session_SigmaCI", (DL_FUNC) &_BayesFMMM_Session_SigmaCI, 2},
+    {"_BayesFMMM_Session_DIC", (DL_FUNC) &_BayesFMMM_Session_DIC, 4},
+    {"_BayesFMMM_Session_IC", (DL_FUNC) &_BayesFMMM_Session_IC, 4},
+    {"_BayesFMMM_Session_ScoreMembership", (DL_FUNC) &_BayesFMMM_Session_ScoreMembership, 9},
+    {"_BayesFMMM_Session_AIC", (DL_FUNC) &_BayesFMMM_Session_AIC, 4},
+    {"_BayesFMMM_Session_BIC", (DL_FUNC) &_BayesFMMM_Session_BIC, 4},
+    {"_BayesFMMM_Session_LLik", (DL_FUNC) &_BayesFMMM_Session_LLik, 3},
     {"_BayesFMMM_BFMMM_Nu_Z_multiple_try", (DL_FUNC) &_BayesFMMM_BFMMM_Nu_Z_multiple_try, 25},
     {"_BayesFMMM_BFMMM_Theta_est", (DL_FUNC) &_BayesFMMM_BFMMM_Theta_est, 29},
-    {"_BayesFMMM_BFMMM_warm_start", (DL_FUNC) &_BayesFMMM_BFMMM_warm_start, 43},
+    {"_BayesFMMM_BFMMM_ICM_init", (DL_FUNC) &_BayesFMMM_BFMMM_ICM_init, 20},
+    {"_BayesFMMM_BFMMM_warm_start", (DL_FUNC) &_BayesFMMM_BFMMM_warm_start, 44},
+    {"_BayesFMMM_BFMMM_warm_start_incremental", (DL_FUNC) &_BayesFMMM_BFMMM_warm_start_incremental, 38},
+    {"_BayesFMMM_BFMMM_CovariateAdj_warm_start", (DL_FUNC) &_BayesFMMM_BFMMM_CovariateAdj_warm_start, 45},
     {"_BayesFMMM_ReadVec", (DL_FUNC) &_BayesFMMM_ReadVec, 1},
     {"_BayesFMMM_ReadMat", (DL_FUNC) &_BayesFMMM_ReadMat, 1},
     {"_BayesFMMM_ReadCube", (DL_FUNC) &_BayesFMMM_ReadCube, 1},
     {"_BayesFMMM_ReadFieldCube", (DL_FUNC) &_BayesFMMM_ReadFieldCube, 1},
     {"_BayesFMMM_ReadFieldMat", (DL_FUNC) &_BayesFMMM_ReadFieldMat, 1},
     {"_BayesFMMM_ReadFieldVec", (DL_FUNC) &_BayesFMMM_ReadFieldVec, 1},
+    {"_BayesFMMM_ReadCubeFiles", (DL_FUNC) &_BayesFMMM_ReadCubeFiles, 3},
+    {"_BayesFMMM_ReadFieldCubeFiles", (DL_FUNC) &_BayesFMMM_ReadFieldCubeFiles, 3},
+    {"_BayesFMMM_ReadVecFiles", (DL_FUNC) &_BayesFMMM_ReadVecFiles, 3},
+    {"_BayesFMMM_ConvertSampleDir", (DL_FUNC) &_BayesFMMM_ConvertSampleDir, 4},
+    {"_BayesFMMM_WriteObsStore", (DL_FUNC) &_BayesFMMM_WriteObsStore, 4},
     {"_BayesFMMM_BHDFMMM_Nu_Z_multiple_try", (DL_FUNC) &_BayesFMMM_BHDFMMM_Nu_Z_multiple_try, 25},
     {"_BayesFMMM_BHDFMMM_Theta_est", (DL_FUNC) &_BayesFMMM_BHDFMMM_Theta_est, 29},
-    {"_BayesFMMM_BHDFMMM_warm_start", (DL_FUNC) &_BayesFMMM_BHDFMMM_warm_start, 43},
+    {"_BayesFMMM_BHDFMMM_warm_start", (DL_FUNC) &_BayesFMMM_BHDFMMM_warm_start, 44},
     {"_BayesFMMM_BMVMMM_Nu_Z_multiple_try", (DL_FUNC) &_BayesFMMM_BMVMMM_Nu_Z_multiple_try, 20},
     {"_BayesFMMM_BMVMMM_Theta_est", (DL_FUNC) &_BayesFMMM_BMVMMM_Theta_est, 24},
-    {"_BayesFMMM_BMVMMM_warm_start", (DL_FUNC) &_BayesFMMM_BMVMMM_warm_start, 38},
+    {"_BayesFMMM_BMVMMM_warm_start", (DL_FUNC) &_BayesFMMM_BMVMMM_warm_start, 39},
     {"run_testthat_tests", (DL_FUNC) &run_testthat_tests, 1},
     {NULL, NULL, 0}
 };
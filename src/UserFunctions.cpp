@@ -1,5 +1,6 @@
 #include <RcppArmadillo.h>
 #include <cmath>
+#include <utility>
 #include <splines2Armadillo.h>
 #include <BayesFMMM.h>
 
@@ -103,13 +104,13 @@
 Rcpp::List BFMMM_Nu_Z_multiple_try(const int tot_mcmc_iters,
                                    const int n_try,
                                    const int k,
-                                   const arma::field<arma::vec> Y,
-                                   const arma::field<arma::vec> time,
+                                   const arma::field<arma::vec>& Y,
+                                   const arma::field<arma::vec>& time,
                                    const int n_funct,
                                    const int basis_degree,
                                    const int n_eigen,
-                                   const arma::vec boundary_knots,
-                                   const arma::vec internal_knots,
+                                   const arma::vec& boundary_knots,
+                                   const arma::vec& internal_knots,
                                    Rcpp::Nullable<Rcpp::NumericVector> c  = R_NilValue,
                                    const double b = 10,
                                    const double alpha1l = 1,
@@ -378,15 +379,15 @@ Rcpp::List BFMMM_Nu_Z_multiple_try(const int tot_mcmc_iters,
 Rcpp::List BFMMM_Theta_est(const int tot_mcmc_iters,
                            const int n_try,
                            const int k,
-                           const arma::field<arma::vec> Y,
-                           const arma::field<arma::vec> time,
+                           const arma::field<arma::vec>& Y,
+                           const arma::field<arma::vec>& time,
                            const int n_funct,
                            const int basis_degree,
                            const int n_eigen,
-                           const arma::vec boundary_knots,
-                           const arma::vec internal_knots,
-                           const arma::cube Z_samp,
-                           const arma::cube nu_samp,
+                           const arma::vec& boundary_knots,
+                           const arma::vec& internal_knots,
+                           const arma::cube& Z_samp,
+                           const arma::cube& nu_samp,
                            const double burnin_prop = 0.8,
                            Rcpp::Nullable<Rcpp::NumericVector> c  = R_NilValue,
                            const double b = 10,
@@ -600,28 +601,1344 @@ Rcpp::List BFMMM_Theta_est(const int tot_mcmc_iters,
   return BestChain;
 }
 
+//' Find initial starting points for all parameters using iterated conditional modes
+//'
+//' This function is an alternative to running \code{BFMMM_Nu_Z_multiple_try}
+//' followed by \code{BFMMM_Theta_est}. Every parameter is set in turn to the
+//' mode of its full conditional distribution (iterated conditional modes), so
+//' the estimates converge to a local maximum a posteriori (MAP) estimate: the
+//' mean functions (nu), the eigenfunctions (Phi) and the scores (chi) are set to
+//' their conditional means, the precision parameters (sigma, tau, delta and
+//' gamma) to their conditional modes, and the memberships (Z), pi, alpha_3 and
+//' A to the maximizers of their conditional posteriors. These are point
+//' estimates, not a variational approximation of the posterior, and are only
+//' meant to be used as starting values. Once this function is ran, the results
+//' can be used directly in \code{BFMMM_warm_start}.
+//'
+//' @name BFMMM_ICM_init
+//' @param tot_iters Int containing the total number of ICM iterations
+//' @param k Int containing the number of clusters
+//' @param Y List of vectors containing the observed values
+//' @param time List of vectors containing the observed time points
+//' @param n_funct Int containing the number of functions
+//' @param basis_degree Int containing the degree of B-splines used
+//' @param n_eigen Int containing the number of eigenfunctions
+//' @param boundary_knots Vector containing the boundary points of our index domain of interest
+//' @param internal_knots Vector location of internal knots for B-splines
+//' @param c Vector containing hyperparmeter for sampling from pi (If left NULL, the one vector will be used)
+//' @param b double containing hyperparamete for sampling from alpha_3
+//' @param nu_1 double containing hyperparameter for sampling from gamma
+//' @param alpha1l Double containing hyperparameter for sampling from A
+//' @param alpha2l Double containing hyperparameter for sampling from A
+//' @param beta1l Double containing hyperparameter for sampling from A (scale)
+//' @param beta2l Double containing hyperparameter for sampling from A (scale)
+//' @param alpha Double containing hyperparameter for tau
+//' @param beta Double containing hyperparameter for tau (scale)
+//' @param alpha_0 Double containing hyperparameter for sigma
+//' @param beta_0 Double containing hyperparameter for sigma (scale)
+//' @returns a List containing:
+//' \describe{
+//'   \item{\code{B}}{The basis functions evaluated at the observed time points}
+//'   \item{\code{nu}}{nu estimates at each iteration}
+//'   \item{\code{pi}}{pi estimates at each iteration}
+//'   \item{\code{alpha_3}}{alpha_3 estimates at each iteration}
+//'   \item{\code{A}}{A estimates at each iteration}
+//'   \item{\code{delta}}{delta estimates at each iteration}
+//'   \item{\code{sigma}}{sigma estimates at each iteration}
+//'   \item{\code{tau}}{tau estimates at each iteration}
+//'   \item{\code{gamma}}{gamma estimates at each iteration}
+//'   \item{\code{Phi}}{Phi estimates at each iteration}
+//'   \item{\code{Z}}{Z estimates at each iteration}
+//'   \item{\code{chi}}{chi estimates at each iteration}
+//'   \item{\code{loglik}}{Log-likelihood at each iteration}
+//' }
+//' @section Warning:
+//' The following must be true:
+//' \describe{
+//'   \item{\code{tot_iters}}{must be an integer larger than or equal to 10}
+//'   \item{\code{k}}{must be an integer larger than or equal to 2}
+//'   \item{\code{n_funct}}{must be an integer larger than 1}
+//'   \item{\code{basis_degree}}{must be an integer larger than or equal to 1}
+//'   \item{\code{n_eigen}}{must be greater than or equal to 1}
+//'   \item{\code{internal_knots}}{must lie in the range of \code{boundary_knots}}
+//'   \item{\code{c}}{must be greater than 0 and have k elements}
+//'   \item{\code{b}}{must be positive}
+//'   \item{\code{nu_1}}{must be positive}
+//'   \item{\code{alpha1l}}{must be positive}
+//'   \item{\code{beta1l}}{must be positive}
+//'   \item{\code{alpha2l}}{must be positive}
+//'   \item{\code{beta1l}}{must be positive}
+//'   \item{\code{alpha}}{must be positive}
+//'   \item{\code{beta}}{must be positive}
+//'   \item{\code{alpha_0}}{must be positive}
+//'   \item{\code{beta_0}}{must be positive}
+//' }
+//'
+//' @examples
+//' ## Load sample data
+//' Y <- readRDS(system.file("test-data", "Sim_data.RDS", package = "BayesFMMM"))
+//' time <- readRDS(system.file("test-data", "time.RDS", package = "BayesFMMM"))
+//'
+//' ## Set Hyperparameters
+//' tot_iters <- 100
+//' tot_mcmc_iters <- 150
+//' k <- 2
+//' n_funct <- 40
+//' basis_degree <- 3
+//' n_eigen <- 3
+//' boundary_knots <- c(0, 1000)
+//' internal_knots <- c(250, 500, 750)
+//'
+//' ## Get starting values of all parameters
+//' est <- BFMMM_ICM_init(tot_iters, k, Y, time, n_funct, basis_degree, n_eigen,
+//'                       boundary_knots, internal_knots)
+//'
+//' MCMC.chain <-BFMMM_warm_start(tot_mcmc_iters, k, Y, time, n_funct,
+//'                               basis_degree, n_eigen, boundary_knots,
+//'                               internal_knots, est$Z, est$pi, est$alpha_3,
+//'                               est$delta, est$gamma, est$Phi, est$A,
+//'                               est$nu, est$tau, est$sigma, est$chi)
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::List BFMMM_ICM_init(const int tot_iters,
+                          const int k,
+                          const arma::field<arma::vec>& Y,
+                          const arma::field<arma::vec>& time,
+                          const int n_funct,
+                          const int basis_degree,
+                          const int n_eigen,
+                          const arma::vec& boundary_knots,
+                          const arma::vec& internal_knots,
+                          Rcpp::Nullable<Rcpp::NumericVector> c  = R_NilValue,
+                          const double b = 10,
+                          const double nu_1 = 3,
+                          const double alpha1l = 2,
+                          const double alpha2l = 3,
+                          const double beta1l = 2,
+                          const double beta2l = 2,
+                          const double alpha = 1,
+                          const double beta = 10,
+                          const double alpha_0 = 1,
+                          const double beta_0 = 1){
+  // generate warnings
+  if(tot_iters <  10){
+    Rcpp::stop("'tot_iters' must be an integer greater than or equal to 10");
+  }
+  if(k <  2){
+    Rcpp::stop("'k' must be an integer greater than or equal to 2");
+  }
+  if(n_funct <  1){
+    Rcpp::stop("'n_funct' must be an integer greater than or equal to 1");
+  }
+  if(basis_degree <  1){
+    Rcpp::stop("'basis_degree' must be an integer greater than or equal to 1");
+  }
+  if(n_eigen <  1){
+    Rcpp::stop("'n_eigen' must be an integer greater than or equal to 1");
+  }
+  for(int i = 0; i < internal_knots.n_elem; i++){
+    if(boundary_knots(0) >= internal_knots(i)){
+      Rcpp::stop("at least one element in 'internal_knots' is less than or equal to first boundary knot");
+    }
+    if(boundary_knots(1) <= internal_knots(i)){
+      Rcpp::stop("at least one element in 'internal_knots' is more than or equal to second boundary knot");
+    }
+  }
+  if(b <= 0){
+    Rcpp::stop("'b' must be positive");
+  }
+  if(nu_1 <= 0){
+    Rcpp::stop("'nu_1' must be positive");
+  }
+  if(alpha1l <= 0){
+    Rcpp::stop("'alpha1l' must be positive");
+  }
+  if(beta1l <= 0){
+    Rcpp::stop("'beta1l' must be positive");
+  }
+  if(alpha2l <= 0){
+    Rcpp::stop("'alpha2l' must be positive");
+  }
+  if(beta2l <= 0){
+    Rcpp::stop("'beta2l' must be positive");
+  }
+  if(alpha <= 0){
+    Rcpp::stop("'alpha' must be positive");
+  }
+  if(beta <= 0){
+    Rcpp::stop("'beta' must be positive");
+  }
+  if(alpha_0 <= 0){
+    Rcpp::stop("'alpha_0' must be positive");
+  }
+  if(beta_0 <= 0){
+    Rcpp::stop("'beta_0' must be positive");
+  }
+
+  // initialize hyperparameter c
+  arma::vec c1 = arma::ones(k) * 10;
+  if(c.isNotNull()) {
+    Rcpp::NumericVector c_(c);
+    c1 = Rcpp::as<arma::vec>(c_);
+  }
+
+  // generate warning for c
+  if(c1.n_elem != k){
+    Rcpp::stop("number of elements of the vector 'c' must be equal to k");
+  }
+  for(int i = 0; i < k; i++){
+    if(c1(i) <= 0){
+      Rcpp::stop("all elements of 'c' must be positive");
+    }
+  }
+
+  splines2::BSpline bspline;
+  // Make B_obs
+  arma::field<arma::mat> B_obs(n_funct,1);
+  for(int i = 0; i < n_funct; i++)
+  {
+    // Create Bspline object
+    bspline = splines2::BSpline(time(i,0), internal_knots, basis_degree,
+                                boundary_knots);
+    // Get Basis matrix (100 x 8)
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+  }
+
+  // start iterated conditional modes
+  Rcpp::List mod = BayesFMMM::BFMMM_ICM(Y, time, n_funct, k, basis_degree,
+                                        n_eigen, boundary_knots, internal_knots,
+                                        tot_iters, c1, b, nu_1, alpha1l, alpha2l,
+                                        beta1l, beta2l, alpha, beta, alpha_0,
+                                        beta_0);
+
+  Rcpp::List est =  Rcpp::List::create(Rcpp::Named("B", B_obs),
+                                       Rcpp::Named("nu", mod["nu"]),
+                                       Rcpp::Named("pi", mod["pi"]),
+                                       Rcpp::Named("alpha_3", mod["alpha_3"]),
+                                       Rcpp::Named("A", mod["A"]),
+                                       Rcpp::Named("delta", mod["delta"]),
+                                       Rcpp::Named("sigma", mod["sigma"]),
+                                       Rcpp::Named("tau", mod["tau"]),
+                                       Rcpp::Named("gamma", mod["gamma"]),
+                                       Rcpp::Named("Phi", mod["Phi"]),
+                                       Rcpp::Named("Z", mod["Z"]),
+                                       Rcpp::Named("chi", mod["chi"]),
+                                       Rcpp::Named("loglik", mod["loglik"]));
+
+  return est;
+}
+
 //' Performs MCMC for functional models given an informed set of starting points
 //'
-//' This function is meant to be used after using \code{BFMMM_Nu_Z_multiple_try}
-//' and \code{BFMMM_Theta_est}. This function will use the outputs of these two
-//' functions to start the MCMC chain in a good location. Since the posterior distribution
-//' can often be multimodal, it is important to have a good starting position.
-//' To help move across modes, this function allows users to use tempered transitions
-//' every \code{n_temp_trans} iterations. By using a mixture of tempered transitions
-//' and un-tempered transitions, we can allow the chain to explore multiple modes without
-//' while keeping sampling relatively computationally efficient. To save on RAM usage, we
-//' allow users to specify how many samples are kept in memory using \code{r_stored_iters}.
-//' If \code{r_stored_iters} is less than \code{tot_mcmc_iters}, then a thinned version
-//' of the chain is stored in the user specified directory (\code{dir}). The samples from each
-//' parameter can be viewed using the following functions: \code{ReadFieldCube},
-//' \code{ReadFieldMat}, \code{ReadFieldVec}, \code{ReadCube}, \code{ReadMat},
-//' \code{ReadVec}.
+//' This function is meant to be used after using \code{BFMMM_Nu_Z_multiple_try}
+//' and \code{BFMMM_Theta_est}. This function will use the outputs of these two
+//' functions to start the MCMC chain in a good location. Since the posterior distribution
+//' can often be multimodal, it is important to have a good starting position.
+//' To help move across modes, this function allows users to use tempered transitions
+//' every \code{n_temp_trans} iterations. By using a mixture of tempered transitions
+//' and un-tempered transitions, we can allow the chain to explore multiple modes without
+//' while keeping sampling relatively computationally efficient. To save on RAM usage, we
+//' allow users to specify how many samples are kept in memory using \code{r_stored_iters}.
+//' If \code{r_stored_iters} is less than \code{tot_mcmc_iters}, then a thinned version
+//' of the chain is stored in the user specified directory (\code{dir}). The samples from each
+//' parameter can be viewed using the following functions: \code{ReadFieldCube},
+//' \code{ReadFieldMat}, \code{ReadFieldVec}, \code{ReadCube}, \code{ReadMat},
+//' \code{ReadVec}.
+//'
+//' @name BFMMM_warm_start
+//' @param tot_mcmc_iters Int containing the total number of MCMC iterations
+//' @param k Int containing the number of clusters
+//' @param Y List of vectors containing the observed values (can be NULL if \code{data_file} is specified)
+//' @param time List of vectors containing the observed time points (can be NULL if \code{data_file} is specified)
+//' @param n_funct Int containing the number of functions
+//' @param basis_degree Int containing the degree of B-splines used
+//' @param n_eigen Int containing the number of eigenfunctions
+//' @param boundary_knots Vector containing the boundary points of our index domain of interest
+//' @param internal_knots Vector location of internal knots for B-splines
+//' @param Z_samp Cube containing initial chain of Z parameters (from \code{BFMMM_NU_Z_multiple_try})
+//' @param pi_samp Matrix containing initial chain of pi parameters (from \code{BFMMM_NU_Z_multiple_try})
+//' @param alpha_3_samp Vector containing initial chain of alpha_3 parameters (from \code{BFMMM_NU_Z_multiple_try})
+//' @param delta_samp Matrix containing initial chain of delta parameters (from \code{BFMMM_Theta_est})
+//' @param gamma_samp List of cubes containing initial chain of gamma parameters (from \code{BFMMM_Theta_est}), or a 4-dimensional array with the chain stacked along the last dimension
+//' @param Phi_samp List of cubes containing initial chain of phi parameters (from \code{BFMMM_Theta_est}), or a 4-dimensional array with the chain stacked along the last dimension
+//' @param A_samp Matrix containing initial chain of A parameters (from \code{BFMMM_Theta_est})
+//' @param nu_samp Cube containing initial chain of nu parameters (from \code{BFMMM_NU_Z_multiple_try})
+//' @param tau_samp Matrix containing initial chain of tau parameters (from \code{BFMMM_NU_Z_multiple_try})
+//' @param sigma_samp Vector containing initial chain of sigma parameters (from \code{BFMMM_Theta_est})
+//' @param chi_samp Cube containing initial chain of chi parameters (from \code{BFMMM_Theta_est})
+//' @param burnin_prop Double containing proportion of chain used to estimate the starting point of nu parameters and Z parameters
+//' @param dir String containing directory where the MCMC files should be saved (if NULL, then no files will be saved)
+//' @param thinning_num Int containing how often we should save MCMC iterations
+//' @param beta_N_t Double containing the maximum weight for tempered transitions
+//' @param N_t Int containing total number of tempered transitions
+//' @param n_temp_trans Int containing how often tempered transitions are performed (if 0, then no tempered transitions are performed)
+//' @param r_stored_iters Int containing how many MCMC iterations are stored in RAM (if 0, then all MCMC iterations are stored in RAM)
+//' @param c Vector containing hyperparmeter for sampling from pi (If left NULL, the one vector will be used)
+//' @param b double containing hyperparamete for sampling from alpha_3
+//' @param nu_1 double containing hyperparameter for sampling from gamma
+//' @param alpha1l Double containing hyperparameter for sampling from A
+//' @param alpha2l Double containing hyperparameter for sampling from A
+//' @param beta1l Double containing hyperparameter for sampling from A (scale)
+//' @param beta2l Double containing hyperparameter for sampling from A (scale)
+//' @param a_Z_PM Double containing hyperparameter of the random walk MH for Z parameter
+//' @param a_pi_PM Double containing hyperparameter of the random walk MH for pi parameter
+//' @param var_alpha3 Double containing variance parameter of the random walk MH for alpha_3 parameter
+//' @param var_epsilon1 Double containing hyperparameter for sampling from A having to do with variance for Metropolis-Hastings algorithm
+//' @param var_epsilon2 Double containing hyperparameter for sampling from A having to do with variance for Metropolis-Hastings algorithm
+//' @param alpha Double containing hyperparameter for sampling from tau
+//' @param beta Double containing hyperparameter for sampling from tau (scale)
+//' @param alpha_0 Double containing hyperparameter for sampling from sigma
+//' @param beta_0 Double containing hyperparameter for sampling from sigma (scale)
+//' @param control List containing the options of the sampler that do not change the model. Options that are not in the list keep their default values (\code{summary_burnin = 0}, \code{n_adapt = 0}, \code{n_adapt_ladder = 0}, \code{n_leapfrog_Z = 0}, \code{step_Z = 0.1}, \code{parallel_sweep = FALSE}, \code{single_precision = FALSE}, \code{codec = "arma_ascii"}, \code{codec_tol = 1e-4}, \code{compress_obs = FALSE}, \code{sg_batch_size = 0}, \code{sg_step = 0.1}, \code{sg_n_anchor = 100}; \code{summary_time}, \code{summary_probs}, \code{retain} and \code{data_file} default to NULL), and names that are not listed below give an error:
+//' \describe{
+//'   \item{\code{summary_time}}{Vector containing time points at which online posterior summaries of the mean and covariance functions are computed (if NULL, then no summaries are computed)}
+//'   \item{\code{summary_probs}}{Vector containing probabilities of the pointwise quantiles tracked by the online summaries (if NULL, then c(0.025, 0.5, 0.975) is used)}
+//'   \item{\code{summary_burnin}}{Int containing number of MCMC iterations discarded before updating the online summaries}
+//'   \item{\code{n_adapt}}{Int containing number of MCMC iterations during which the proposal scales of the Metropolis-Hastings steps (\code{a_Z_PM} for each function, \code{a_pi_PM}, \code{var_alpha3}, \code{var_epsilon1} and \code{var_epsilon2}) are adapted towards target acceptance rates before being fixed (if 0, then the user specified values are used throughout)}
+//'   \item{\code{n_adapt_ladder}}{Int containing number of MCMC iterations during which the temperature ladder of the tempered transitions is respaced so that each rung has a similar acceptance probability (if 0, then the geometric ladder is used throughout)}
+//'   \item{\code{n_leapfrog_Z}}{Int containing the number of leapfrog steps of the Hamiltonian Monte Carlo updates of Z on the simplex (1 gives MALA; if 0, then the Dirichlet random walk with concentration \code{a_Z_PM} is used)}
+//'   \item{\code{step_Z}}{Double containing the leapfrog step size of the Hamiltonian Monte Carlo updates of Z (adapted for each function if \code{n_adapt} > 0)}
+//'   \item{\code{parallel_sweep}}{Boolean indicating whether conditionally independent blocks of the Gibbs sweep are updated concurrently (the updates of pi, alpha_3, delta, A, gamma and tau then use their own random number engines, seeded from R's random number generator, and run on one thread while the updates of Z, Phi, nu, sigma and chi use the remaining threads, when the package is compiled with OpenMP support and more than one thread is available)}
+//'   \item{\code{single_precision}}{Boolean indicating whether the sampler stores the observed values and basis functions in single precision instead of double precision (sums over observations are still accumulated in double precision). Every update reads the single precision copy, which halves the memory used by the observations and the memory traffic of the updates, and the rounding error is negligible compared to the measurement error of most functional data.}
+//'   \item{\code{retain}}{Named vector containing how often each parameter is saved to \code{dir}, where the names are the prefixes of the files of the parameters (for example \code{c(Nu = 1, Phi = 1, Z = 1, Chi = 1, Sigma = 1, Gamma = 10)}). Parameters that are not named are not saved. Nu, Phi, Z, Chi, Sigma, Pi and alpha_3 are read together by the posterior summaries, so the ones that are saved must have the same value. If NULL, every parameter is saved every \code{thinning_num} iterations}
+//'   \item{\code{codec}}{String containing how the saved parameters are stored: "arma_ascii" (Armadillo text format), "lossless" (byte-shuffled and compressed), "float16" (half precision, relative error of at most 2^-11) or "quantized" (absolute error of at most \code{codec_tol}). The files can be read with \code{ReadCube}, \code{ReadFieldCube}, \code{ReadMat} and \code{ReadVec}}
+//'   \item{\code{codec_tol}}{Double containing the largest absolute error of the saved values when using the quantized codec}
+//'   \item{\code{data_file}}{String containing the path of an observation store written by \code{WriteObsStore} (if NULL, then \code{Y} and \code{time} are used). The functions are streamed from the file and only their sufficient statistics are kept in RAM, and \code{Y} and \code{time} are ignored (they can be NULL)}
+//'   \item{\code{compress_obs}}{Boolean indicating whether the observations of each function are replaced by their sufficient statistics (at most as many pseudo-observations as basis functions). The posterior is unchanged, but the memory used by the observations and the cost of each sweep no longer grow with the number of observed time points}
+//'   \item{\code{sg_batch_size}}{Integer containing the number of functions in each minibatch of the stochastic gradient sampler (if 0, then the tempered transitions sampler is used). Every iteration only the memberships and scores of the functions in the minibatch are updated, nu and Phi are moved by preconditioned stochastic gradient Langevin steps with control variates, and sigma, pi and alpha_3 are updated from estimates of the residual sum of squares and from the sums of the log memberships, so the cost of an iteration does not grow with the number of functions. The chain is an approximation of the posterior whose accuracy depends on \code{sg_step}}
+//'   \item{\code{sg_step}}{Double containing the step size of the stochastic gradient Langevin steps (relative to the inverse of the diagonal of the posterior precision)}
+//'   \item{\code{sg_n_anchor}}{Integer containing how often (in MCMC iterations) the control variates of the stochastic gradient sampler are recomputed using all functions}
+//' }
+//'
+//' @returns a List containing:
+//' \describe{
+//'   \item{\code{B_obs}}{The basis functions evaluated at the observed time points of each function (only if \code{data_file} is NULL and \code{compress_obs} is FALSE, since the sampler otherwise only uses the sufficient statistics of the observations)}
+//'   \item{\code{nu}}{Nu samples from the MCMC chain}
+//'   \item{\code{chi}}{chi samples from the MCMC chain}
+//'   \item{\code{pi}}{pi samples from the MCMC chain}
+//'   \item{\code{alpha_3}}{alpha_3 samples from the MCMC chain}
+//'   \item{\code{A}}{A samples from MCMC chain}
+//'   \item{\code{delta}}{delta samples from the MCMC chain}
+//'   \item{\code{sigma}}{sigma samples from the MCMC chain}
+//'   \item{\code{tau}}{tau samples from the MCMC chain}
+//'   \item{\code{gamma}}{gamma samples from the MCMC chain}
+//'   \item{\code{Phi}}{Phi samples from the MCMC chain}
+//'   \item{\code{Z}}{Z samples from the MCMC chain}
+//'   \item{\code{loglik}}{Log-likelihood plot of best performing chain}
+//'   \item{\code{summary}}{Online posterior summaries evaluated at \code{summary_time} (only if \code{summary_time} is specified). Contains the Rao-Blackwellized posterior mean of the mean functions (\code{mean}), their posterior standard deviation (\code{mean_sd}) and pointwise quantiles (\code{mean_quantiles}), and the posterior mean (\code{cov}), standard deviation (\code{cov_sd}) and pointwise quantiles (\code{cov_quantiles}) of the covariance surfaces for each pair of clusters in \code{cov_pairs}}
+//'   \item{\code{tuning}}{Final proposal scales of the Metropolis-Hastings steps (and leapfrog step sizes \code{step_Z} if \code{n_leapfrog_Z} > 0) and their average acceptance probabilities after adaptation (only if \code{n_adapt} > 0)}
+//'   \item{\code{ladder}}{Temperature ladder used by the tempered transitions (\code{beta}) with the average acceptance probability (\code{rung_accept}) and log acceptance ratio (\code{rung_log_ratio}) of each pair of adjacent temperatures, the mean (\code{loglik_mean}) and standard deviation (\code{loglik_sd}) of the log-likelihood at each temperature, the number of tempered transitions (\code{n_trans}) and their acceptance rate (\code{accept}) since the ladder was last respaced (only if \code{n_temp_trans} > 0)}
+//'   \item{\code{sg}}{Minibatch size (\code{batch_size}), step size (\code{step}), number of times the control variates were recomputed (\code{n_anchor}) and the average acceptance probabilities of the proposals of Z (\code{accept_Z}), pi (\code{accept_pi}) and alpha_3 (\code{accept_alpha3}) of the stochastic gradient sampler (only if \code{sg_batch_size} > 0). In this case \code{Z} and \code{chi} only contain the last MCMC sample (the files saved to \code{dir} contain every retained sample), \code{loglik} contains estimates of the log-likelihood, and \code{tuning}, \code{ladder} and \code{utilization} are not returned}
+//'   \item{\code{utilization}}{Utilization of the threads in the loops over functions for each kernel (\code{Z}, \code{chi}, \code{sigma}, \code{loglik}): the number of calls (\code{n_calls}), the wall time (\code{wall}), the time each thread spent processing functions (\code{busy}) and the total number of observed time points it processed (\code{weight}), the fraction of the wall time the threads were busy (\code{utilization}), the ratio of the largest to the average busy time (\code{imbalance}), and the number of chunks of functions taken from another thread (\code{n_steals})}
+//' }
+//'
+//' @section Warning:
+//' The following must be true:
+//' \describe{
+//'   \item{\code{tot_mcmc_iters}}{must be an integer larger than or equal to 100}
+//'   \item{\code{burnin_prop}}{must be between 0 and 1}
+//'   \item{\code{k}}{must be an integer larger than or equal to 2}
+//'   \item{\code{n_funct}}{must be an integer larger than 1}
+//'   \item{\code{basis_degree}}{must be an integer larger than or equal to 1}
+//'   \item{\code{n_eigen}}{must be greater than or equal to 1}
+//'   \item{\code{internal_knots}}{must lie in the range of \code{boundary_knots}}
+//'   \item{\code{dir}}{must be specified if \code{r_stored_iters} <= \code{tot_mcmc_iters} (other than if \code{r_stored_iters} = 0 or \code{summary_time} is specified)}
+//'   \item{\code{n_thinning}}{must be a positive integer}
+//'   \item{\code{beta_N_t}}{must be between 1 and 0}
+//'   \item{\code{N_t}}{must be a positive integer}
+//'   \item{\code{n_temp_trans}}{must be a non-negative integer}
+//'   \item{\code{r_stored_iters}}{must be a non-negative integer}
+//'   \item{\code{c}}{must be greater than 0 and have k elements}
+//'   \item{\code{b}}{must be positive}
+//'   \item{\code{nu_1}}{must be positive}
+//'   \item{\code{alpha1l}}{must be positive}
+//'   \item{\code{beta1l}}{must be positive}
+//'   \item{\code{alpha2l}}{must be positive}
+//'   \item{\code{beta1l}}{must be positive}
+//'   \item{\code{a_Z_PM}}{must be positive}
+//'   \item{\code{a_pi_PM}}{must be positive}
+//'   \item{\code{var_alpha3}}{must be positive}
+//'   \item{\code{var_epsilon1}}{must be positive}
+//'   \item{\code{var_epsilon2}}{must be positive}
+//'   \item{\code{alpha}}{must be positive}
+//'   \item{\code{beta}}{must be positive}
+//'   \item{\code{alpha_0}}{must be positive}
+//'   \item{\code{beta_0}}{must be positive}
+//'   \item{\code{summary_time}}{must lie in the range of \code{boundary_knots}}
+//'   \item{\code{summary_probs}}{must be between 0 and 1}
+//'   \item{\code{summary_burnin}}{must be a non-negative integer}
+//'   \item{\code{n_adapt}}{must be a non-negative integer}
+//'   \item{\code{n_adapt_ladder}}{must be a non-negative integer}
+//'   \item{\code{n_leapfrog_Z}}{must be a non-negative integer}
+//'   \item{\code{step_Z}}{must be positive}
+//'   \item{\code{sg_batch_size}}{must be a non-negative integer}
+//'   \item{\code{sg_step}}{must be positive}
+//'   \item{\code{sg_n_anchor}}{must be a positive integer}
+//' }
+//'
+//'@examples
+//' ## Load sample data
+//' Y <- readRDS(system.file("test-data", "Sim_data.RDS", package = "BayesFMMM"))
+//' time <- readRDS(system.file("test-data", "time.RDS", package = "BayesFMMM"))
+//'
+//' ## Set Hyperparameters
+//' tot_mcmc_iters <- 150
+//' n_try <- 1
+//' k <- 2
+//' n_funct <- 40
+//' basis_degree <- 3
+//' n_eigen <- 3
+//' boundary_knots <- c(0, 1000)
+//' internal_knots <- c(250, 500, 750)
+//'
+//' ## Get Estimates of Z and nu
+//' est1 <- BFMMM_Nu_Z_multiple_try(tot_mcmc_iters, n_try, k, Y, time, n_funct,
+//'                                 basis_degree, n_eigen, boundary_knots,
+//'                                 internal_knots)
+//'
+//' ## Get estimates of other parameters
+//' est2 <- BFMMM_Theta_est(tot_mcmc_iters, n_try, k, Y, time, n_funct,
+//'                         basis_degree, n_eigen, boundary_knots,
+//'                         internal_knots, est1$Z, est1$nu)
+//'
+//' MCMC.chain <-BFMMM_warm_start(tot_mcmc_iters, k, Y, time, n_funct,
+//'                               basis_degree, n_eigen, boundary_knots,
+//'                               internal_knots, est1$Z, est1$pi, est1$alpha_3,
+//'                               est2$delta, est2$gamma, est2$Phi, est2$A,
+//'                               est1$nu, est1$tau, est2$sigma, est2$chi)
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::List BFMMM_warm_start(const int tot_mcmc_iters,
+                            const int k,
+                            Rcpp::Nullable<Rcpp::List> Y,
+                            Rcpp::Nullable<Rcpp::List> time,
+                            const int n_funct,
+                            const int basis_degree,
+                            const int n_eigen,
+                            const arma::vec& boundary_knots,
+                            const arma::vec& internal_knots,
+                            const arma::cube& Z_samp,
+                            const arma::mat& pi_samp,
+                            const arma::vec& alpha_3_samp,
+                            const arma::cube& delta_samp,
+                            const BayesFMMM::CubeList& gamma_samp,
+                            const BayesFMMM::CubeList& Phi_samp,
+                            const arma::cube& A_samp,
+                            const arma::cube& nu_samp,
+                            const arma::mat& tau_samp,
+                            const arma::vec& sigma_samp,
+                            const arma::cube& chi_samp,
+                            const double burnin_prop = 0.8,
+                            Rcpp::Nullable<Rcpp::CharacterVector> dir = R_NilValue,
+                            const double thinning_num = 1,
+                            const double beta_N_t = 1,
+                            int N_t = 1,
+                            int n_temp_trans = 0,
+                            int r_stored_iters = 0,
+                            Rcpp::Nullable<Rcpp::NumericVector> c  = R_NilValue,
+                            const double b = 10,
+                            const double nu_1 = 3,
+                            const double alpha1l = 2,
+                            const double alpha2l = 3,
+                            const double beta1l = 2,
+                            const double beta2l = 2,
+                            const double a_Z_PM = 10000,
+                            const double a_pi_PM = 1000,
+                            const double var_alpha3 = 0.05,
+                            const double var_epsilon1 = 1,
+                            const double var_epsilon2 = 1,
+                            const double alpha = 1,
+                            const double beta = 10,
+                            const double alpha_0 = 1,
+                            const double beta_0 = 1,
+                            Rcpp::Nullable<Rcpp::List> control = R_NilValue){
+
+  // generate warnings
+  if(tot_mcmc_iters <  100){
+    Rcpp::stop("'tot_mcmc_iters' must be an integer greater than or equal to 100");
+  }
+  if(burnin_prop < 0){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  if(burnin_prop >= 1){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  if(k <  2){
+    Rcpp::stop("'k' must be an integer greater than or equal to 2");
+  }
+  if(n_funct <  1){
+    Rcpp::stop("'n_funct' must be an integer greater than or equal to 1");
+  }
+  if(basis_degree <  1){
+    Rcpp::stop("'basis_degree' must be an integer greater than or equal to 1");
+  }
+  if(n_eigen <  1){
+    Rcpp::stop("'n_eigen' must be an integer greater than or equal to 1");
+  }
+  if(n_funct <  1){
+    Rcpp::stop("'n_funct' must be an integer greater than or equal to 1");
+  }
+  for(int i = 0; i < internal_knots.n_elem; i++){
+    if(boundary_knots(0) >= internal_knots(i)){
+      Rcpp::stop("at least one element in 'internal_knots' is less than or equal to first boundary knot");
+    }
+    if(boundary_knots(1) <= internal_knots(i)){
+      Rcpp::stop("at least one element in 'internal_knots' is more than or equal to second boundary knot");
+    }
+  }
+  if(b <= 0){
+    Rcpp::stop("'b' must be positive");
+  }
+  if(nu_1 <= 0){
+    Rcpp::stop("'nu_1' must be positive");
+  }
+  if(alpha1l <= 0){
+    Rcpp::stop("'alpha1l' must be positive");
+  }
+  if(beta1l <= 0){
+    Rcpp::stop("'beta1l' must be positive");
+  }
+  if(alpha2l <= 0){
+    Rcpp::stop("'alpha2l' must be positive");
+  }
+  if(beta2l <= 0){
+    Rcpp::stop("'beta2l' must be positive");
+  }
+  if(a_Z_PM <= 0){
+    Rcpp::stop("'a_Z_PM' must be positive");
+  }
+  if(a_pi_PM <= 0){
+    Rcpp::stop("'a_pi_PM' must be positive");
+  }
+  if(var_alpha3 <= 0){
+    Rcpp::stop("'var_alpha3' must be positive");
+  }
+  if(var_epsilon1 <= 0){
+    Rcpp::stop("'var_epsilon1' must be positive");
+  }
+  if(var_epsilon2 <= 0){
+    Rcpp::stop("'var_epsilon2' must be positive");
+  }
+  if(alpha <= 0){
+    Rcpp::stop("'alpha' must be positive");
+  }
+  if(beta <= 0){
+    Rcpp::stop("'beta' must be positive");
+  }
+  if(alpha_0 <= 0){
+    Rcpp::stop("'alpha_0' must be positive");
+  }
+  if(beta_0 <= 0){
+    Rcpp::stop("'beta_0' must be positive");
+  }
+  if(thinning_num <= 0){
+    Rcpp::stop("'thinning_num' must be a positive integer");
+  }
+  if(beta_N_t <= 0){
+    Rcpp::stop("'beta_N_t' must be between 0 and 1");
+  }
+  if(beta_N_t > 1){
+    Rcpp::stop("'beta_N_t' must be between 0 and 1");
+  }
+  if(N_t < 1){
+    Rcpp::stop("'N_t' must be a positive integer");
+  }
+  if(r_stored_iters < 0){
+    Rcpp::stop("'r_stored_iters' must be a non-negative integer");
+  }
+  if(n_temp_trans < 0){
+    Rcpp::stop("'n_temp_trans' must be a non-negative integer");
+  }
+
+  // options of the sampler that do not change the model
+  BayesFMMM::SamplerControl ctrl =
+    BayesFMMM::makeSamplerControl(control, BayesFMMM::warmStartControls());
+
+  // initialize online summaries
+  arma::mat B_grid;
+  if(!ctrl.summary_time.is_empty()){
+    const arma::vec& t_grid = ctrl.summary_time;
+    for(int i = 0; i < t_grid.n_elem; i++){
+      if((t_grid(i) < boundary_knots(0)) || (t_grid(i) > boundary_knots(1))){
+        Rcpp::stop("all elements of 'summary_time' must lie in the range of 'boundary_knots'");
+      }
+    }
+    splines2::BSpline bspline_grid = splines2::BSpline(t_grid, internal_knots,
+                                                       basis_degree,
+                                                       boundary_knots);
+    B_grid = bspline_grid.basis(true);
+  }
+
+  // initialize hyperparameter c
+  arma::vec c1 = arma::ones(k) * 10;
+  if(c.isNotNull()){
+    Rcpp::NumericVector c_(c);
+    c1 = Rcpp::as<arma::vec>(c_);
+  }
+
+  // generate warning for c
+  if(c1.n_elem != k){
+    Rcpp::stop("number of elements of the vector 'c' must be equal to k");
+  }
+  for(int i = 0; i < k; i++){
+    if(c1(i) <= 0){
+      Rcpp::stop("all elements of 'c' must be positive");
+    }
+  }
+
+  // if r_stored_iters is default, do not save anything
+  std::string dir1 = "";
+  if(r_stored_iters == 0){
+    r_stored_iters = tot_mcmc_iters + 1;
+  }
+
+  // check if directory is specified
+  if(dir.isNotNull()){
+    Rcpp::CharacterVector s(dir);
+    dir1 = std::string(s[0]);
+
+    // save entire chain at last iteration
+    if(r_stored_iters == 0){
+      r_stored_iters = tot_mcmc_iters;
+    }
+  }
+
+  // Check if there is a place to store files if r_stored_iters < tot_mcmc_iters
+  // (not needed if only the online summaries are of interest)
+  if(dir.isNull() && ctrl.summary_time.is_empty()){
+    if(r_stored_iters <= tot_mcmc_iters){
+      Rcpp::stop("'r_stored_iters' <= 'tot_mcmc_iters' with no 'dir' specified. Either specify 'dir' or increase 'r_stored_iters'");
+    }
+  }
+
+  // if n_temp_trans is default set to greater than tot_mcmc_iters
+  if(n_temp_trans == 0){
+    n_temp_trans = tot_mcmc_iters + 1;
+    N_t = 1;
+  }
+
+  // save RAM
+  if(r_stored_iters > tot_mcmc_iters + 1){
+    r_stored_iters = tot_mcmc_iters + 1;
+  }
+
+  // parameters saved to dir and how often they are saved
+  BayesFMMM::RetentionPolicy retention =
+    BayesFMMM::makeRetentionPolicy(BayesFMMM::modelParams(), thinning_num,
+                                   r_stored_iters, ctrl.retain);
+  retention.codec = ctrl.codec;
+
+  // Start of Algorithm
+  splines2::BSpline bspline;
+  // Make B_obs
+  arma::field<arma::mat> B_obs(n_funct,1);
+  BayesFMMM::RaggedObs obs;
+  if(!ctrl.data_file.empty()){
+    // stream the functions from the observation store and only keep their
+    // sufficient statistics
+    BayesFMMM::ObsStore store;
+    BayesFMMM::openObsStore(ctrl.data_file, store);
+    if((int) store.n_funct() != n_funct){
+      Rcpp::stop("the number of functions in 'data_file' must be equal to 'n_funct'");
+    }
+    obs = BayesFMMM::makeRaggedObs(store, internal_knots, basis_degree,
+                                   boundary_knots);
+  }else{
+    if(Y.isNull() || time.isNull()){
+      Rcpp::stop("'Y' and 'time' must be specified if 'data_file' is NULL");
+    }
+    Rcpp::List Y_(Y);
+    Rcpp::List time_(time);
+    const arma::field<arma::vec> y_obs = Rcpp::as<arma::field<arma::vec>>(Y_);
+    const arma::field<arma::vec> t_obs = Rcpp::as<arma::field<arma::vec>>(time_);
+    for(int i = 0; i < n_funct; i++)
+    {
+      // Create Bspline object
+      bspline = splines2::BSpline(t_obs(i,0), internal_knots, basis_degree,
+                                  boundary_knots);
+      // Get Basis matrix (100 x 8)
+      arma::mat bspline_mat{bspline.basis(true)};
+      B_obs(i,0) = bspline_mat;
+    }
+    obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+    if(ctrl.compress_obs){
+      // the basis at the observed time points is not used by the sampler
+      obs = BayesFMMM::compressRaggedObs(obs);
+      B_obs.reset();
+    }
+  }
+  // the basis at the observed time points is only returned if the sampler
+  // uses it
+  const bool return_basis = ctrl.data_file.empty() && !ctrl.compress_obs;
+
+  int n_nu = alpha_3_samp.n_elem;
+
+  double alpha_3_est = arma::median(alpha_3_samp.subvec(std::round(n_nu * burnin_prop), n_nu - 1));
+  arma::vec pi_est = arma::zeros(pi_samp.n_rows);
+  arma::mat Z_est = arma::zeros(n_funct, Z_samp.n_cols);
+  arma::mat nu_est = arma::zeros(nu_samp.n_rows, nu_samp.n_cols);
+  arma::vec ph_Z = arma::zeros(n_nu - std::round(n_nu * burnin_prop));
+  arma::vec ph_nu = arma::zeros(n_nu - std::round(n_nu * burnin_prop));
+  for(int i = 0; i < Z_est.n_cols; i++){
+    pi_est(i) = arma::median(pi_samp.row(i).subvec(std::round(n_nu * burnin_prop), n_nu - 1));
+    for(int j = 0; j < Z_est.n_rows; j++){
+      for(int l = std::round(n_nu * burnin_prop); l < n_nu; l++){
+        ph_Z(l - std::round(n_nu * burnin_prop)) = Z_samp(j,i,l);
+      }
+      Z_est(j,i) = arma::median(ph_Z);
+    }
+    for(int j = 0; j < nu_samp.n_cols; j++){
+      for(int l = std::round(n_nu * burnin_prop); l < n_nu; l++){
+        ph_nu(l - std::round(n_nu * burnin_prop)) = nu_samp(i,j,l);
+      }
+      nu_est(i,j) = arma::median(ph_nu);
+    }
+  }
+
+  // normalize
+  for(int i = 0; i < Z_est.n_rows; i++){
+    Z_est.row(i) = Z_est.row(i) / arma::accu(Z_est.row(i));
+  }
+
+  // // rescale Z and nu
+  // arma::mat transform_mat = arma::zeros(Z_samp.n_cols, Z_samp.n_cols);
+  // int max_ind = 0;
+  // for(int i = 0; i < Z_est.n_cols; i++){
+  //   max_ind = arma::index_max(Z_est.col(i));
+  //   transform_mat.row(i) = Z_est.row(max_ind);
+  // }
+  // arma::mat Z_est_rescale = Z_est * arma::pinv(transform_mat);
+  // arma::mat nu_est_rescale = transform_mat * nu_est;
+  // transform_mat(0,0) = 0.95;
+  // transform_mat(0,1) = 0.05;
+  // transform_mat(1,0) = 0.95;
+  // transform_mat(1,0) = 0.05;
+  //
+  // Z_est_rescale = Z_est_rescale * transform_mat;
+  // nu_est_rescale = arma::pinv(transform_mat) * nu_est_rescale;
+
+  pi_est = pi_est / arma::accu(pi_est);
+
+  int n_Phi = sigma_samp.n_elem;
+
+  double sigma_est = arma::median(sigma_samp.subvec(std::round(n_Phi * burnin_prop), n_Phi - 1));
+  arma::mat delta_est = arma::zeros(delta_samp.n_rows, delta_samp.n_cols);
+  arma::vec ph_delta = arma::zeros(n_Phi - std::round(n_Phi * burnin_prop));
+  for(int k = 0; k < delta_samp.n_cols; k++){
+    for(int i = 0; i < delta_samp.n_rows; i++){
+      for(int l = std::round(n_Phi * burnin_prop); l < n_Phi; l++){
+        ph_delta(l - std::round(n_Phi * burnin_prop)) = delta_samp(i,k,l);
+      }
+      delta_est(i, k) = arma::median(ph_delta);
+    }
+  }
+
+  arma::cube gamma_est = arma::zeros(gamma_samp.n_rows, gamma_samp.n_cols, gamma_samp.n_slices);
+  arma::cube Phi_est = arma::zeros(Phi_samp.n_rows, Phi_samp.n_cols, Phi_samp.n_slices);
+  arma::vec ph_phi = arma::zeros(n_Phi - std::round(n_Phi * burnin_prop));
+  arma::vec ph_gamma = arma::zeros(n_Phi - std::round(n_Phi * burnin_prop));
+  for(int i = 0; i < Phi_est.n_rows; i++){
+    for(int j = 0; j < Phi_est.n_cols; j++){
+      for(int m = 0; m < Phi_est.n_slices; m++){
+        for(int l = std::round(n_Phi * burnin_prop); l < n_Phi; l++){
+          ph_phi(l - std::round(n_Phi * burnin_prop)) = Phi_samp(l,i,j,m);
+
+          ph_gamma(l - std::round(n_Phi * burnin_prop)) = gamma_samp(l,i,j,m);
+        }
+        Phi_est(i,j,m) = arma::median(ph_phi);
+        gamma_est(i,j,m) = arma::median(ph_gamma);
+      }
+    }
+  }
+
+  arma::mat A_est = arma::zeros(A_samp.n_rows, A_samp.n_cols);
+  arma::vec ph_A = arma::zeros(n_Phi - std::round(n_Phi * burnin_prop));
+  for(int k = 0; k < A_samp.n_rows; k++){
+    for(int i = 0; i < A_samp.n_cols; i++){
+      for(int l = std::round(n_Phi * burnin_prop); l < n_Phi; l++){
+        ph_A(l - std::round(n_Phi * burnin_prop)) = A_samp(k, i, l);
+      }
+      A_est(k, i) = arma::median(ph_A);
+    }
+  }
+
+  arma::vec tau_est = arma::zeros(tau_samp.n_cols);
+  arma::vec ph_tau = arma::zeros(n_nu - std::round(n_nu * burnin_prop));
+  for(int i = 0; i < tau_est.n_elem; i++){
+    for(int l = std::round(n_nu * burnin_prop); l < n_nu; l++){
+      ph_tau(l - std::round(n_nu * burnin_prop)) = tau_samp(l,i);
+    }
+    tau_est(i) = arma::median(ph_tau);
+  }
+  arma::mat chi_est = arma::zeros(chi_samp.n_rows, chi_samp.n_cols);
+  arma::vec ph_chi = arma::zeros(n_Phi - std::round(n_Phi * burnin_prop));
+  for(int i = 0; i < chi_est.n_rows; i++){
+    for(int j = 0; j < chi_est.n_cols; j++){
+      for(int l = std::round(n_Phi * burnin_prop); l < n_Phi; l++){
+        ph_chi(l - std::round(n_Phi * burnin_prop)) = chi_samp(i,j,l);
+      }
+      chi_est(i,j) = arma::median(ph_chi);
+    }
+  }
+
+  // start MCMC sampling
+  if(ctrl.sg_batch_size > 0){
+    Rcpp::List mod1 = BayesFMMM::BFMMM_SG_warm_start(obs, k, n_eigen,
+                                                     tot_mcmc_iters,
+                                                     r_stored_iters, c1, b, nu_1,
+                                                     alpha1l, alpha2l, beta1l,
+                                                     beta2l, a_Z_PM, a_pi_PM,
+                                                     var_alpha3, var_epsilon1,
+                                                     var_epsilon2, alpha, beta,
+                                                     alpha_0, beta_0, dir1, Z_est,
+                                                     pi_est, alpha_3_est, delta_est,
+                                                     gamma_est, Phi_est, A_est,
+                                                     nu_est, tau_est, sigma_est,
+                                                     chi_est, ctrl.sg_batch_size,
+                                                     ctrl.sg_step, ctrl.sg_n_anchor,
+                                                     retention);
+    Rcpp::List mod2 =  Rcpp::List::create(Rcpp::Named("nu", mod1["nu"]),
+                                          Rcpp::Named("chi", mod1["chi"]),
+                                          Rcpp::Named("pi", mod1["pi"]),
+                                          Rcpp::Named("alpha_3", mod1["alpha_3"]),
+                                          Rcpp::Named("A", mod1["A"]),
+                                          Rcpp::Named("delta", mod1["delta"]),
+                                          Rcpp::Named("sigma", mod1["sigma"]),
+                                          Rcpp::Named("tau", mod1["tau"]),
+                                          Rcpp::Named("gamma", mod1["gamma"]),
+                                          Rcpp::Named("Phi", mod1["Phi"]),
+                                          Rcpp::Named("Z", mod1["Z"]),
+                                          Rcpp::Named("loglik", mod1["loglik"]));
+    mod2.push_back(mod1["sg"], "sg");
+    if(return_basis){
+      mod2.push_front(B_obs, "B_obs");
+    }
+    return mod2;
+  }
+
+  Rcpp::List mod1 = BayesFMMM::BFMMM_MTT_warm_start(std::move(obs),
+                                                    thinning_num, k, n_eigen,
+                                                    tot_mcmc_iters,
+                                                    r_stored_iters, n_temp_trans,
+                                                    c1, b, nu_1, alpha1l, alpha2l,
+                                                    beta1l, beta2l, a_Z_PM, a_pi_PM,
+                                                    var_alpha3, var_epsilon1,
+                                                    var_epsilon2, alpha, beta, alpha_0,
+                                                    beta_0, dir1, beta_N_t, N_t,
+                                                    Z_est, pi_est, alpha_3_est,
+                                                    delta_est, gamma_est, Phi_est, A_est,
+                                                    nu_est, tau_est, sigma_est, chi_est,
+                                                    B_grid, ctrl.summary_probs,
+                                                    ctrl.summary_burnin, ctrl.n_adapt,
+                                                    ctrl.n_adapt_ladder, ctrl.step_Z,
+                                                    ctrl.n_leapfrog_Z, ctrl.parallel_sweep,
+                                                    ctrl.single_precision, retention);
+
+  Rcpp::List mod2 =  Rcpp::List::create(Rcpp::Named("nu", mod1["nu"]),
+                                        Rcpp::Named("chi", mod1["chi"]),
+                                        Rcpp::Named("pi", mod1["pi"]),
+                                        Rcpp::Named("alpha_3", mod1["alpha_3"]),
+                                        Rcpp::Named("A", mod1["A"]),
+                                        Rcpp::Named("delta", mod1["delta"]),
+                                        Rcpp::Named("sigma", mod1["sigma"]),
+                                        Rcpp::Named("tau", mod1["tau"]),
+                                        Rcpp::Named("gamma", mod1["gamma"]),
+                                        Rcpp::Named("Phi", mod1["Phi"]),
+                                        Rcpp::Named("Z", mod1["Z"]),
+                                        Rcpp::Named("loglik", mod1["loglik"]));
+  if(!ctrl.summary_time.is_empty()){
+    mod2.push_back(mod1["summary"], "summary");
+  }
+  if(ctrl.n_adapt > 0){
+    mod2.push_back(mod1["tuning"], "tuning");
+  }
+  if(n_temp_trans <= tot_mcmc_iters){
+    mod2.push_back(mod1["ladder"], "ladder");
+  }
+  mod2.push_back(mod1["utilization"], "utilization");
+  if(return_basis){
+    mod2.push_front(B_obs, "B_obs");
+  }
+
+  return mod2;
+}
+
+
+//' Continues the MCMC of a functional model when new functions are observed
+//'
+//' This function is meant to be used when new functions are observed after a
+//' model was fit using \code{BFMMM_warm_start}. Instead of running
+//' \code{BFMMM_Nu_Z_multiple_try}, \code{BFMMM_Theta_est} and
+//' \code{BFMMM_warm_start} again on all of the functions, the chain is started
+//' from the last MCMC sample saved in \code{post_dir}. The functions used in the
+//' previous fit must come first in \code{Y} and \code{time} (in the same order),
+//' followed by the new functions. The memberships and scores of the new
+//' functions are initialized at their posterior means given the saved samples
+//' (see \code{Model_ScoreMembership}), so that only a short chain is needed
+//' before the samples can be used. All other arguments work as in
+//' \code{BFMMM_warm_start}.
+//'
+//' @name BFMMM_warm_start_incremental
+//' @param tot_mcmc_iters Int containing the total number of MCMC iterations
+//' @param k Int containing the number of clusters
+//' @param Y List of vectors containing the observed values (previously used functions first)
+//' @param time List of vectors containing the observed time points (previously used functions first)
+//' @param n_funct Int containing the number of functions (previously used and new)
+//' @param basis_degree Int containing the degree of B-splines used
+//' @param n_eigen Int containing the number of eigenfunctions
+//' @param boundary_knots Vector containing the boundary points of our index domain of interest
+//' @param internal_knots Vector location of internal knots for B-splines
+//' @param post_dir String containing the directory where the MCMC files of the previous fit are located
+//' @param n_files Int containing the number of files per parameter of the previous fit
+//' @param burnin_prop Double containing proportion of the saved MCMC samples discarded when initializing the new functions
+//' @param score_iters Int containing the number of sweeps per saved MCMC iteration used to initialize the new functions
+//' @param score_warmup Int containing the number of sweeps before the first saved MCMC iteration is used to initialize the new functions
+//' @param score_a_Z_PM Double containing hyperparameter of the proposal distribution of Z used to initialize the new functions
+//' @param dir String containing directory where the MCMC files should be saved (if NULL, then no files will be saved)
+//' @param thinning_num Int containing how often we should save MCMC iterations
+//' @param beta_N_t Double containing the maximum weight for tempered transitions
+//' @param N_t Int containing total number of tempered transitions
+//' @param n_temp_trans Int containing how often tempered transitions are performed (if 0, then no tempered transitions are performed)
+//' @param r_stored_iters Int containing how many MCMC iterations are stored in RAM (if 0, then all MCMC iterations are stored in RAM)
+//' @param c Vector containing hyperparmeter for sampling from pi (If left NULL, the one vector will be used)
+//' @param b double containing hyperparamete for sampling from alpha_3
+//' @param nu_1 double containing hyperparameter for sampling from gamma
+//' @param alpha1l Double containing hyperparameter for sampling from A
+//' @param alpha2l Double containing hyperparameter for sampling from A
+//' @param beta1l Double containing hyperparameter for sampling from A (scale)
+//' @param beta2l Double containing hyperparameter for sampling from A (scale)
+//' @param a_Z_PM Double containing hyperparameter of the random walk MH for Z parameter
+//' @param a_pi_PM Double containing hyperparameter of the random walk MH for pi parameter
+//' @param var_alpha3 Double containing variance parameter of the random walk MH for alpha_3 parameter
+//' @param var_epsilon1 Double containing hyperparameter for sampling from A having to do with variance for Metropolis-Hastings algorithm
+//' @param var_epsilon2 Double containing hyperparameter for sampling from A having to do with variance for Metropolis-Hastings algorithm
+//' @param alpha Double containing hyperparameter for sampling from tau
+//' @param beta Double containing hyperparameter for sampling from tau (scale)
+//' @param alpha_0 Double containing hyperparameter for sampling from sigma
+//' @param beta_0 Double containing hyperparameter for sampling from sigma (scale)
+//' @param control List containing the options of the sampler that do not change the model. Options that are not in the list keep their default values (\code{summary_burnin = 0}, \code{n_adapt = 0}, \code{n_adapt_ladder = 0}, \code{n_leapfrog_Z = 0}, \code{step_Z = 0.1}, \code{parallel_sweep = FALSE}, \code{single_precision = FALSE}, \code{codec = "arma_ascii"}, \code{codec_tol = 1e-4}; \code{summary_time}, \code{summary_probs} and \code{retain} default to NULL), and names that are not listed below give an error:
+//' \describe{
+//'   \item{\code{summary_time}}{Vector containing time points at which online posterior summaries of the mean and covariance functions are computed (if NULL, then no summaries are computed)}
+//'   \item{\code{summary_probs}}{Vector containing probabilities of the pointwise quantiles tracked by the online summaries (if NULL, then c(0.025, 0.5, 0.975) is used)}
+//'   \item{\code{summary_burnin}}{Int containing number of MCMC iterations discarded before updating the online summaries}
+//'   \item{\code{n_adapt}}{Int containing number of MCMC iterations during which the proposal scales of the Metropolis-Hastings steps (\code{a_Z_PM} for each function, \code{a_pi_PM}, \code{var_alpha3}, \code{var_epsilon1} and \code{var_epsilon2}) are adapted towards target acceptance rates before being fixed (if 0, then the user specified values are used throughout)}
+//'   \item{\code{n_adapt_ladder}}{Int containing number of MCMC iterations during which the temperature ladder of the tempered transitions is respaced so that each rung has a similar acceptance probability (if 0, then the geometric ladder is used throughout)}
+//'   \item{\code{n_leapfrog_Z}}{Int containing the number of leapfrog steps of the Hamiltonian Monte Carlo updates of Z on the simplex (1 gives MALA; if 0, then the Dirichlet random walk with concentration \code{a_Z_PM} is used)}
+//'   \item{\code{step_Z}}{Double containing the leapfrog step size of the Hamiltonian Monte Carlo updates of Z (adapted for each function if \code{n_adapt} > 0)}
+//'   \item{\code{parallel_sweep}}{Boolean indicating whether conditionally independent blocks of the Gibbs sweep are updated concurrently (the updates of pi, alpha_3, delta, A, gamma and tau then use their own random number engines, seeded from R's random number generator, and run on one thread while the updates of Z, Phi, nu, sigma and chi use the remaining threads, when the package is compiled with OpenMP support and more than one thread is available)}
+//'   \item{\code{single_precision}}{Boolean indicating whether the sampler stores the observed values and basis functions in single precision instead of double precision (sums over observations are still accumulated in double precision). Every update reads the single precision copy, which halves the memory used by the observations and the memory traffic of the updates, and the rounding error is negligible compared to the measurement error of most functional data.}
+//'   \item{\code{retain}}{Named vector containing how often each parameter is saved to \code{dir}, where the names are the prefixes of the files of the parameters (for example \code{c(Nu = 1, Phi = 1, Z = 1, Chi = 1, Sigma = 1, Gamma = 10)}). Parameters that are not named are not saved. Nu, Phi, Z, Chi, Sigma, Pi and alpha_3 are read together by the posterior summaries, so the ones that are saved must have the same value. If NULL, every parameter is saved every \code{thinning_num} iterations (the fit in \code{post_dir} must have saved every parameter)}
+//'   \item{\code{codec}}{String containing how the saved parameters are stored: "arma_ascii" (Armadillo text format), "lossless" (byte-shuffled and compressed), "float16" (half precision, relative error of at most 2^-11) or "quantized" (absolute error of at most \code{codec_tol}). The files can be read with \code{ReadCube}, \code{ReadFieldCube}, \code{ReadMat} and \code{ReadVec}}
+//'   \item{\code{codec_tol}}{Double containing the largest absolute error of the saved values when using the quantized codec}
+//' }
+//'
+//' @returns a List containing the same elements as \code{BFMMM_warm_start}, as well as:
+//' \describe{
+//'   \item{\code{n_new}}{Number of new functions}
+//'   \item{\code{score_acceptance}}{Acceptance rate of the memberships of each new function when they were initialized}
+//' }
+//'
+//' @section Warning:
+//' The following must be true:
+//' \describe{
+//'   \item{\code{tot_mcmc_iters}}{must be an integer larger than or equal to 100}
+//'   \item{\code{k}}{must be equal to the number of clusters of the previous fit}
+//'   \item{\code{n_funct}}{must be larger than or equal to the number of functions of the previous fit}
+//'   \item{\code{basis_degree}}{must be an integer larger than or equal to 1}
+//'   \item{\code{n_eigen}}{must be equal to the number of eigenfunctions of the previous fit}
+//'   \item{\code{internal_knots}}{must lie in the range of \code{boundary_knots} and be the same as in the previous fit}
+//'   \item{\code{n_files}}{must be an integer larger than or equal to 1}
+//'   \item{\code{burnin_prop}}{must be between 0 and 1}
+//'   \item{\code{score_iters}}{must be an integer larger than or equal to 1}
+//'   \item{\code{score_warmup}}{must be a non-negative integer}
+//'   \item{\code{score_a_Z_PM}}{must be positive}
+//'   \item{\code{dir}}{must be specified if \code{r_stored_iters} <= \code{tot_mcmc_iters} (other than if \code{r_stored_iters} = 0 or \code{summary_time} is specified)}
+//'   \item{\code{n_thinning}}{must be a positive integer}
+//'   \item{\code{beta_N_t}}{must be between 1 and 0}
+//'   \item{\code{N_t}}{must be a positive integer}
+//'   \item{\code{n_temp_trans}}{must be a non-negative integer}
+//'   \item{\code{r_stored_iters}}{must be a non-negative integer}
+//'   \item{\code{c}}{must be greater than 0 and have k elements}
+//'   \item{\code{b}}{must be positive}
+//'   \item{\code{nu_1}}{must be positive}
+//'   \item{\code{alpha1l}}{must be positive}
+//'   \item{\code{beta1l}}{must be positive}
+//'   \item{\code{alpha2l}}{must be positive}
+//'   \item{\code{beta1l}}{must be positive}
+//'   \item{\code{a_Z_PM}}{must be positive}
+//'   \item{\code{a_pi_PM}}{must be positive}
+//'   \item{\code{var_alpha3}}{must be positive}
+//'   \item{\code{var_epsilon1}}{must be positive}
+//'   \item{\code{var_epsilon2}}{must be positive}
+//'   \item{\code{alpha}}{must be positive}
+//'   \item{\code{beta}}{must be positive}
+//'   \item{\code{alpha_0}}{must be positive}
+//'   \item{\code{beta_0}}{must be positive}
+//'   \item{\code{summary_time}}{must lie in the range of \code{boundary_knots}}
+//'   \item{\code{summary_probs}}{must be between 0 and 1}
+//'   \item{\code{summary_burnin}}{must be a non-negative integer}
+//'   \item{\code{n_adapt}}{must be a non-negative integer}
+//'   \item{\code{n_adapt_ladder}}{must be a non-negative integer}
+//'   \item{\code{n_leapfrog_Z}}{must be a non-negative integer}
+//'   \item{\code{step_Z}}{must be positive}
+//' }
+//' @export
+// [[Rcpp::export]]
+Rcpp::List BFMMM_warm_start_incremental(const int tot_mcmc_iters,
+                                        const int k,
+                                        const arma::field<arma::vec>& Y,
+                                        const arma::field<arma::vec>& time,
+                                        const int n_funct,
+                                        const int basis_degree,
+                                        const int n_eigen,
+                                        const arma::vec& boundary_knots,
+                                        const arma::vec& internal_knots,
+                                        const std::string post_dir,
+                                        const int n_files,
+                                        const double burnin_prop = 0.2,
+                                        const int score_iters = 1,
+                                        const int score_warmup = 50,
+                                        const double score_a_Z_PM = 1000,
+                                        Rcpp::Nullable<Rcpp::CharacterVector> dir = R_NilValue,
+                                        const double thinning_num = 1,
+                                        const double beta_N_t = 1,
+                                        int N_t = 1,
+                                        int n_temp_trans = 0,
+                                        int r_stored_iters = 0,
+                                        Rcpp::Nullable<Rcpp::NumericVector> c  = R_NilValue,
+                                        const double b = 10,
+                                        const double nu_1 = 3,
+                                        const double alpha1l = 2,
+                                        const double alpha2l = 3,
+                                        const double beta1l = 2,
+                                        const double beta2l = 2,
+                                        const double a_Z_PM = 10000,
+                                        const double a_pi_PM = 1000,
+                                        const double var_alpha3 = 0.05,
+                                        const double var_epsilon1 = 1,
+                                        const double var_epsilon2 = 1,
+                                        const double alpha = 1,
+                                        const double beta = 10,
+                                        const double alpha_0 = 1,
+                                        const double beta_0 = 1,
+                                        Rcpp::Nullable<Rcpp::List> control = R_NilValue){
+
+  // generate warnings
+  if(tot_mcmc_iters <  100){
+    Rcpp::stop("'tot_mcmc_iters' must be an integer greater than or equal to 100");
+  }
+  if(k <  2){
+    Rcpp::stop("'k' must be an integer greater than or equal to 2");
+  }
+  if(n_funct <  1){
+    Rcpp::stop("'n_funct' must be an integer greater than or equal to 1");
+  }
+  if(basis_degree <  1){
+    Rcpp::stop("'basis_degree' must be an integer greater than or equal to 1");
+  }
+  if(n_eigen <  1){
+    Rcpp::stop("'n_eigen' must be an integer greater than or equal to 1");
+  }
+  for(int i = 0; i < internal_knots.n_elem; i++){
+    if(boundary_knots(0) >= internal_knots(i)){
+      Rcpp::stop("at least one element in 'internal_knots' is less than or equal to first boundary knot");
+    }
+    if(boundary_knots(1) <= internal_knots(i)){
+      Rcpp::stop("at least one element in 'internal_knots' is more than or equal to second boundary knot");
+    }
+  }
+  if(n_files < 1){
+    Rcpp::stop("'n_files' must be an integer greater than or equal to 1");
+  }
+  if(burnin_prop < 0){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  if(burnin_prop >= 1){
+    Rcpp::stop("'burnin_prop' must be between 0 and 1");
+  }
+  if(score_iters < 1){
+    Rcpp::stop("'score_iters' must be an integer greater than or equal to 1");
+  }
+  if(score_warmup < 0){
+    Rcpp::stop("'score_warmup' must be a non-negative integer");
+  }
+  if(score_a_Z_PM <= 0){
+    Rcpp::stop("'score_a_Z_PM' must be positive");
+  }
+  if(b <= 0){
+    Rcpp::stop("'b' must be positive");
+  }
+  if(nu_1 <= 0){
+    Rcpp::stop("'nu_1' must be positive");
+  }
+  if(alpha1l <= 0){
+    Rcpp::stop("'alpha1l' must be positive");
+  }
+  if(beta1l <= 0){
+    Rcpp::stop("'beta1l' must be positive");
+  }
+  if(alpha2l <= 0){
+    Rcpp::stop("'alpha2l' must be positive");
+  }
+  if(beta2l <= 0){
+    Rcpp::stop("'beta2l' must be positive");
+  }
+  if(a_Z_PM <= 0){
+    Rcpp::stop("'a_Z_PM' must be positive");
+  }
+  if(a_pi_PM <= 0){
+    Rcpp::stop("'a_pi_PM' must be positive");
+  }
+  if(var_alpha3 <= 0){
+    Rcpp::stop("'var_alpha3' must be positive");
+  }
+  if(var_epsilon1 <= 0){
+    Rcpp::stop("'var_epsilon1' must be positive");
+  }
+  if(var_epsilon2 <= 0){
+    Rcpp::stop("'var_epsilon2' must be positive");
+  }
+  if(alpha <= 0){
+    Rcpp::stop("'alpha' must be positive");
+  }
+  if(beta <= 0){
+    Rcpp::stop("'beta' must be positive");
+  }
+  if(alpha_0 <= 0){
+    Rcpp::stop("'alpha_0' must be positive");
+  }
+  if(beta_0 <= 0){
+    Rcpp::stop("'beta_0' must be positive");
+  }
+  if(thinning_num <= 0){
+    Rcpp::stop("'thinning_num' must be a positive integer");
+  }
+  if(beta_N_t <= 0){
+    Rcpp::stop("'beta_N_t' must be between 0 and 1");
+  }
+  if(beta_N_t > 1){
+    Rcpp::stop("'beta_N_t' must be between 0 and 1");
+  }
+  if(N_t < 1){
+    Rcpp::stop("'N_t' must be a positive integer");
+  }
+  if(r_stored_iters < 0){
+    Rcpp::stop("'r_stored_iters' must be a non-negative integer");
+  }
+  if(n_temp_trans < 0){
+    Rcpp::stop("'n_temp_trans' must be a non-negative integer");
+  }
+
+  // read the last state of the previous fit
+  BayesFMMM::ChainState state = BayesFMMM::loadLastState(post_dir, n_files);
+  int n_old = state.Z.n_rows;
+  int P = internal_knots.n_elem + basis_degree + 1;
+  if(state.Z.n_cols != k){
+    Rcpp::stop("'k' must be equal to the number of clusters of the previous fit");
+  }
+  if(state.chi.n_cols != n_eigen){
+    Rcpp::stop("'n_eigen' must be equal to the number of eigenfunctions of the previous fit");
+  }
+  if(state.nu.n_cols != P){
+    Rcpp::stop("'basis_degree' and 'internal_knots' must give the same number of basis functions as in the previous fit");
+  }
+  if(n_funct < n_old){
+    Rcpp::stop("'n_funct' must be greater than or equal to the number of functions of the previous fit");
+  }
+
+  // options of the sampler that do not change the model
+  BayesFMMM::SamplerControl ctrl =
+    BayesFMMM::makeSamplerControl(control, BayesFMMM::temperedControls());
+
+  // initialize online summaries
+  arma::mat B_grid;
+  if(!ctrl.summary_time.is_empty()){
+    const arma::vec& t_grid = ctrl.summary_time;
+    for(int i = 0; i < t_grid.n_elem; i++){
+      if((t_grid(i) < boundary_knots(0)) || (t_grid(i) > boundary_knots(1))){
+        Rcpp::stop("all elements of 'summary_time' must lie in the range of 'boundary_knots'");
+      }
+    }
+    splines2::BSpline bspline_grid = splines2::BSpline(t_grid, internal_knots,
+                                                       basis_degree,
+                                                       boundary_knots);
+    B_grid = bspline_grid.basis(true);
+  }
+
+  // initialize hyperparameter c
+  arma::vec c1 = arma::ones(k) * 10;
+  if(c.isNotNull()){
+    Rcpp::NumericVector c_(c);
+    c1 = Rcpp::as<arma::vec>(c_);
+  }
+
+  // generate warning for c
+  if(c1.n_elem != k){
+    Rcpp::stop("number of elements of the vector 'c' must be equal to k");
+  }
+  for(int i = 0; i < k; i++){
+    if(c1(i) <= 0){
+      Rcpp::stop("all elements of 'c' must be positive");
+    }
+  }
+
+  // if r_stored_iters is default, do not save anything
+  std::string dir1 = "";
+  if(r_stored_iters == 0){
+    r_stored_iters = tot_mcmc_iters + 1;
+  }
+
+  // check if directory is specified
+  if(dir.isNotNull()){
+    Rcpp::CharacterVector s(dir);
+    dir1 = std::string(s[0]);
+
+    // save entire chain at last iteration
+    if(r_stored_iters == 0){
+      r_stored_iters = tot_mcmc_iters;
+    }
+  }
+
+  // Check if there is a place to store files if r_stored_iters < tot_mcmc_iters
+  // (not needed if only the online summaries are of interest)
+  if(dir.isNull() && ctrl.summary_time.is_empty()){
+    if(r_stored_iters <= tot_mcmc_iters){
+      Rcpp::stop("'r_stored_iters' <= 'tot_mcmc_iters' with no 'dir' specified. Either specify 'dir' or increase 'r_stored_iters'");
+    }
+  }
+
+  // if n_temp_trans is default set to greater than tot_mcmc_iters
+  if(n_temp_trans == 0){
+    n_temp_trans = tot_mcmc_iters + 1;
+    N_t = 1;
+  }
+
+  // save RAM
+  if(r_stored_iters > tot_mcmc_iters + 1){
+    r_stored_iters = tot_mcmc_iters + 1;
+  }
+
+  // parameters saved to dir and how often they are saved
+  BayesFMMM::RetentionPolicy retention =
+    BayesFMMM::makeRetentionPolicy(BayesFMMM::modelParams(), thinning_num,
+                                   r_stored_iters, ctrl.retain);
+  retention.codec = ctrl.codec;
+
+  // Start of Algorithm
+  splines2::BSpline bspline;
+  // Make B_obs
+  arma::field<arma::mat> B_obs(n_funct,1);
+  for(int i = 0; i < n_funct; i++)
+  {
+    // Create Bspline object
+    bspline = splines2::BSpline(time(i,0), internal_knots, basis_degree,
+                                boundary_knots);
+    // Get Basis matrix (100 x 8)
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+  }
+
+  // previously used functions start at their last state
+  arma::mat Z_est = arma::zeros(n_funct, k);
+  arma::mat chi_est = arma::zeros(n_funct, n_eigen);
+  if(n_old > 0){
+    Z_est.rows(0, n_old - 1) = state.Z;
+    chi_est.rows(0, n_old - 1) = state.chi;
+  }
+
+  // new functions start at their posterior means given the previous fit
+  arma::vec score_acceptance;
+  if(n_funct > n_old){
+    arma::field<arma::vec> Y_new(n_funct - n_old, 1);
+    arma::field<arma::vec> time_new(n_funct - n_old, 1);
+    for(int i = n_old; i < n_funct; i++){
+      Y_new(i - n_old, 0) = Y(i,0);
+      time_new(i - n_old, 0) = time(i,0);
+    }
+    BayesFMMM::Posterior post(post_dir, n_files, basis_degree, boundary_knots,
+                              internal_knots);
+    Rcpp::List scores = post.ScoreMembership(time_new, Y_new, 0.05, burnin_prop,
+                                             score_iters, score_warmup,
+                                             score_a_Z_PM, false);
+    Z_est.rows(n_old, n_funct - 1) = Rcpp::as<arma::mat>(scores["Z_mean"]);
+    chi_est.rows(n_old, n_funct - 1) = Rcpp::as<arma::mat>(scores["chi_mean"]);
+    score_acceptance = Rcpp::as<arma::vec>(scores["acceptance"]);
+  }
+
+  // start MCMC sampling
+  Rcpp::List mod1 = BayesFMMM::BFMMM_MTT_warm_start(Y, time, n_funct, thinning_num, k,
+                                                    basis_degree, n_eigen, boundary_knots,
+                                                    internal_knots, tot_mcmc_iters,
+                                                    r_stored_iters, n_temp_trans,
+                                                    c1, b, nu_1, alpha1l, alpha2l,
+                                                    beta1l, beta2l, a_Z_PM, a_pi_PM,
+                                                    var_alpha3, var_epsilon1,
+                                                    var_epsilon2, alpha, beta, alpha_0,
+                                                    beta_0, dir1, beta_N_t, N_t,
+                                                    Z_est, state.pi, state.alpha_3,
+                                                    state.delta, state.gamma, state.Phi,
+                                                    state.A, state.nu, state.tau,
+                                                    state.sigma, chi_est,
+                                                    B_grid, ctrl.summary_probs,
+                                                    ctrl.summary_burnin, ctrl.n_adapt,
+                                                    ctrl.n_adapt_ladder, ctrl.step_Z,
+                                                    ctrl.n_leapfrog_Z, ctrl.parallel_sweep,
+                                                    ctrl.single_precision, retention);
+
+  Rcpp::List mod2 =  Rcpp::List::create(Rcpp::Named("B_obs", B_obs),
+                                        Rcpp::Named("nu", mod1["nu"]),
+                                        Rcpp::Named("chi", mod1["chi"]),
+                                        Rcpp::Named("pi", mod1["pi"]),
+                                        Rcpp::Named("alpha_3", mod1["alpha_3"]),
+                                        Rcpp::Named("A", mod1["A"]),
+                                        Rcpp::Named("delta", mod1["delta"]),
+                                        Rcpp::Named("sigma", mod1["sigma"]),
+                                        Rcpp::Named("tau", mod1["tau"]),
+                                        Rcpp::Named("gamma", mod1["gamma"]),
+                                        Rcpp::Named("Phi", mod1["Phi"]),
+                                        Rcpp::Named("Z", mod1["Z"]),
+                                        Rcpp::Named("loglik", mod1["loglik"]),
+                                        Rcpp::Named("n_new", n_funct - n_old),
+                                        Rcpp::Named("score_acceptance", score_acceptance));
+  if(!ctrl.summary_time.is_empty()){
+    mod2.push_back(mod1["summary"], "summary");
+  }
+  if(ctrl.n_adapt > 0){
+    mod2.push_back(mod1["tuning"], "tuning");
+  }
+  if(n_temp_trans <= tot_mcmc_iters){
+    mod2.push_back(mod1["ladder"], "ladder");
+  }
+  mod2.push_back(mod1["utilization"], "utilization");
+
+  return mod2;
+}
+
+
+//' Performs MCMC for covariate adjusted functional models given an informed set of starting points
+//'
+//' This function is the covariate adjusted analogue of \code{BFMMM_warm_start}. The
+//' mean of each cluster and the eigenfunctions are allowed to depend on the covariates
+//' \code{X} through the coefficients eta and xi, so the mean function of the jth
+//' cluster for the ith function is given by nu_j + eta_j X_i and the eigenfunctions are
+//' given by Phi_jm + xi_jm X_i. The chain is started using the outputs of
+//' \code{BFMMM_Nu_Z_multiple_try} and \code{BFMMM_Theta_est} (fit without covariates),
+//' with all covariate effects started at zero. The covariate adjusted coefficients
+//' of every function are computed once per MCMC iteration, so each iteration costs
+//' about the same as an iteration of \code{BFMMM_warm_start}. Tempered transitions
+//' and batch storage of the samples work as in \code{BFMMM_warm_start}. The
+//' samples of the covariate effects can be read in using \code{ReadFieldCube}
+//' (eta, xi, gamma_xi, delta_xi and A_xi) and \code{ReadCube} (tau_eta).
 //'
-//' @name BFMMM_warm_start
+//' @name BFMMM_CovariateAdj_warm_start
 //' @param tot_mcmc_iters Int containing the total number of MCMC iterations
 //' @param k Int containing the number of clusters
 //' @param Y List of vectors containing the observed values
 //' @param time List of vectors containing the observed time points
+//' @param X Matrix containing the covariates (one row per function)
 //' @param n_funct Int containing the number of functions
 //' @param basis_degree Int containing the degree of B-splines used
 //' @param n_eigen Int containing the number of eigenfunctions
@@ -631,8 +1948,8 @@ Rcpp::List BFMMM_Theta_est(const int tot_mcmc_iters,
 //' @param pi_samp Matrix containing initial chain of pi parameters (from \code{BFMMM_NU_Z_multiple_try})
 //' @param alpha_3_samp Vector containing initial chain of alpha_3 parameters (from \code{BFMMM_NU_Z_multiple_try})
 //' @param delta_samp Matrix containing initial chain of delta parameters (from \code{BFMMM_Theta_est})
-//' @param gamma_samp List of cubes containing initial chain of gamma parameters (from \code{BFMMM_Theta_est})
-//' @param Phi_samp List of cubes containing initial chain of phi parameters (from \code{BFMMM_Theta_est})
+//' @param gamma_samp List of cubes containing initial chain of gamma parameters (from \code{BFMMM_Theta_est}), or a 4-dimensional array with the chain stacked along the last dimension
+//' @param Phi_samp List of cubes containing initial chain of phi parameters (from \code{BFMMM_Theta_est}), or a 4-dimensional array with the chain stacked along the last dimension
 //' @param A_samp Matrix containing initial chain of A parameters (from \code{BFMMM_Theta_est})
 //' @param nu_samp Cube containing initial chain of nu parameters (from \code{BFMMM_NU_Z_multiple_try})
 //' @param tau_samp Matrix containing initial chain of tau parameters (from \code{BFMMM_NU_Z_multiple_try})
@@ -647,34 +1964,46 @@ Rcpp::List BFMMM_Theta_est(const int tot_mcmc_iters,
 //' @param r_stored_iters Int containing how many MCMC iterations are stored in RAM (if 0, then all MCMC iterations are stored in RAM)
 //' @param c Vector containing hyperparmeter for sampling from pi (If left NULL, the one vector will be used)
 //' @param b double containing hyperparamete for sampling from alpha_3
-//' @param nu_1 double containing hyperparameter for sampling from gamma
-//' @param alpha1l Double containing hyperparameter for sampling from A
-//' @param alpha2l Double containing hyperparameter for sampling from A
-//' @param beta1l Double containing hyperparameter for sampling from A (scale)
-//' @param beta2l Double containing hyperparameter for sampling from A (scale)
+//' @param nu_1 double containing hyperparameter for sampling from gamma and gamma_xi
+//' @param alpha1l Double containing hyperparameter for sampling from A and A_xi
+//' @param alpha2l Double containing hyperparameter for sampling from A and A_xi
+//' @param beta1l Double containing hyperparameter for sampling from A and A_xi (scale)
+//' @param beta2l Double containing hyperparameter for sampling from A and A_xi (scale)
 //' @param a_Z_PM Double containing hyperparameter of the random walk MH for Z parameter
 //' @param a_pi_PM Double containing hyperparameter of the random walk MH for pi parameter
 //' @param var_alpha3 Double containing variance parameter of the random walk MH for alpha_3 parameter
 //' @param var_epsilon1 Double containing hyperparameter for sampling from A having to do with variance for Metropolis-Hastings algorithm
 //' @param var_epsilon2 Double containing hyperparameter for sampling from A having to do with variance for Metropolis-Hastings algorithm
-//' @param alpha Double containing hyperparameter for sampling from tau
-//' @param beta Double containing hyperparameter for sampling from tau (scale)
+//' @param alpha Double containing hyperparameter for sampling from tau and tau_eta
+//' @param beta Double containing hyperparameter for sampling from tau and tau_eta (scale)
 //' @param alpha_0 Double containing hyperparameter for sampling from sigma
 //' @param beta_0 Double containing hyperparameter for sampling from sigma (scale)
+//' @param control List containing the options of the sampler that do not change the model. Options that are not in the list keep their default values (\code{codec = "arma_ascii"}, \code{codec_tol = 1e-4}; \code{retain} defaults to NULL), and names that are not listed below give an error:
+//' \describe{
+//'   \item{\code{retain}}{Named vector containing how often each parameter is saved to \code{dir}, where the names are the prefixes of the files of the parameters (for example \code{c(Nu = 1, Phi = 1, Z = 1, Chi = 1, Sigma = 1, Gamma = 10)}). Parameters that are not named are not saved. Nu, Phi, Z, Chi, Sigma, Pi and alpha_3 are read together by the posterior summaries, so the ones that are saved must have the same value. If NULL, every parameter is saved every \code{thinning_num} iterations}
+//'   \item{\code{codec}}{String containing how the saved parameters are stored: "arma_ascii" (Armadillo text format), "lossless" (byte-shuffled and compressed), "float16" (half precision, relative error of at most 2^-11) or "quantized" (absolute error of at most \code{codec_tol}). The files can be read with \code{ReadCube}, \code{ReadFieldCube}, \code{ReadMat} and \code{ReadVec}}
+//'   \item{\code{codec_tol}}{Double containing the largest absolute error of the saved values when using the quantized codec}
+//' }
 //'
 //' @returns a List containing:
 //' \describe{
 //'   \item{\code{B}}{The basis functions evaluated at the observed time points}
 //'   \item{\code{nu}}{Nu samples from the MCMC chain}
+//'   \item{\code{eta}}{eta samples from the MCMC chain}
 //'   \item{\code{chi}}{chi samples from the MCMC chain}
 //'   \item{\code{pi}}{pi samples from the MCMC chain}
 //'   \item{\code{alpha_3}}{alpha_3 samples from the MCMC chain}
 //'   \item{\code{A}}{A samples from MCMC chain}
+//'   \item{\code{A_xi}}{A_xi samples from MCMC chain}
 //'   \item{\code{delta}}{delta samples from the MCMC chain}
+//'   \item{\code{delta_xi}}{delta_xi samples from the MCMC chain}
 //'   \item{\code{sigma}}{sigma samples from the MCMC chain}
 //'   \item{\code{tau}}{tau samples from the MCMC chain}
+//'   \item{\code{tau_eta}}{tau_eta samples from the MCMC chain}
 //'   \item{\code{gamma}}{gamma samples from the MCMC chain}
+//'   \item{\code{gamma_xi}}{gamma_xi samples from the MCMC chain}
 //'   \item{\code{Phi}}{Phi samples from the MCMC chain}
+//'   \item{\code{xi}}{xi samples from the MCMC chain}
 //'   \item{\code{Z}}{Z samples from the MCMC chain}
 //'   \item{\code{loglik}}{Log-likelihood plot of best performing chain}
 //' }
@@ -686,6 +2015,7 @@ Rcpp::List BFMMM_Theta_est(const int tot_mcmc_iters,
 //'   \item{\code{burnin_prop}}{must be between 0 and 1}
 //'   \item{\code{k}}{must be an integer larger than or equal to 2}
 //'   \item{\code{n_funct}}{must be an integer larger than 1}
+//'   \item{\code{X}}{must have \code{n_funct} rows}
 //'   \item{\code{basis_degree}}{must be an integer larger than or equal to 1}
 //'   \item{\code{n_eigen}}{must be greater than or equal to 1}
 //'   \item{\code{internal_knots}}{must lie in the range of \code{boundary_knots}}
@@ -728,6 +2058,9 @@ Rcpp::List BFMMM_Theta_est(const int tot_mcmc_iters,
 //' boundary_knots <- c(0, 1000)
 //' internal_knots <- c(250, 500, 750)
 //'
+//' ## Simulate a covariate
+//' X <- matrix(rnorm(n_funct), ncol = 1)
+//'
 //' ## Get Estimates of Z and nu
 //' est1 <- BFMMM_Nu_Z_multiple_try(tot_mcmc_iters, n_try, k, Y, time, n_funct,
 //'                                 basis_degree, n_eigen, boundary_knots,
@@ -738,57 +2071,61 @@ Rcpp::List BFMMM_Theta_est(const int tot_mcmc_iters,
 //'                         basis_degree, n_eigen, boundary_knots,
 //'                         internal_knots, est1$Z, est1$nu)
 //'
-//' MCMC.chain <-BFMMM_warm_start(tot_mcmc_iters, k, Y, time, n_funct,
-//'                               basis_degree, n_eigen, boundary_knots,
-//'                               internal_knots, est1$Z, est1$pi, est1$alpha_3,
-//'                               est2$delta, est2$gamma, est2$Phi, est2$A,
-//'                               est1$nu, est1$tau, est2$sigma, est2$chi)
+//' MCMC.chain <- BFMMM_CovariateAdj_warm_start(tot_mcmc_iters, k, Y, time, X,
+//'                                             n_funct, basis_degree, n_eigen,
+//'                                             boundary_knots, internal_knots,
+//'                                             est1$Z, est1$pi, est1$alpha_3,
+//'                                             est2$delta, est2$gamma, est2$Phi,
+//'                                             est2$A, est1$nu, est1$tau,
+//'                                             est2$sigma, est2$chi)
 //'
 //' @export
 // [[Rcpp::export]]
-Rcpp::List BFMMM_warm_start(const int tot_mcmc_iters,
-                            const int k,
-                            const arma::field<arma::vec> Y,
-                            const arma::field<arma::vec> time,
-                            const int n_funct,
-                            const int basis_degree,
-                            const int n_eigen,
-                            const arma::vec boundary_knots,
-                            const arma::vec internal_knots,
-                            const arma::cube Z_samp,
-                            const arma::mat pi_samp,
-                            const arma::vec alpha_3_samp,
-                            const arma::cube delta_samp,
-                            const arma::field<arma::cube> gamma_samp,
-                            const arma::field<arma::cube> Phi_samp,
-                            const arma::cube A_samp,
-                            const arma::cube nu_samp,
-                            const arma::mat tau_samp,
-                            const arma::vec sigma_samp,
-                            const arma::cube chi_samp,
-                            const double burnin_prop = 0.8,
-                            Rcpp::Nullable<Rcpp::CharacterVector> dir = R_NilValue,
-                            const double thinning_num = 1,
-                            const double beta_N_t = 1,
-                            int N_t = 1,
-                            int n_temp_trans = 0,
-                            int r_stored_iters = 0,
-                            Rcpp::Nullable<Rcpp::NumericVector> c  = R_NilValue,
-                            const double b = 10,
-                            const double nu_1 = 3,
-                            const double alpha1l = 2,
-                            const double alpha2l = 3,
-                            const double beta1l = 2,
-                            const double beta2l = 2,
-                            const double a_Z_PM = 10000,
-                            const double a_pi_PM = 1000,
-                            const double var_alpha3 = 0.05,
-                            const double var_epsilon1 = 1,
-                            const double var_epsilon2 = 1,
-                            const double alpha = 1,
-                            const double beta = 10,
-                            const double alpha_0 = 1,
-                            const double beta_0 = 1){
+Rcpp::List BFMMM_CovariateAdj_warm_start(const int tot_mcmc_iters,
+                                         const int k,
+                                         const arma::field<arma::vec>& Y,
+                                         const arma::field<arma::vec>& time,
+                                         const arma::mat& X,
+                                         const int n_funct,
+                                         const int basis_degree,
+                                         const int n_eigen,
+                                         const arma::vec& boundary_knots,
+                                         const arma::vec& internal_knots,
+                                         const arma::cube& Z_samp,
+                                         const arma::mat& pi_samp,
+                                         const arma::vec& alpha_3_samp,
+                                         const arma::cube& delta_samp,
+                                         const BayesFMMM::CubeList& gamma_samp,
+                                         const BayesFMMM::CubeList& Phi_samp,
+                                         const arma::cube& A_samp,
+                                         const arma::cube& nu_samp,
+                                         const arma::mat& tau_samp,
+                                         const arma::vec& sigma_samp,
+                                         const arma::cube& chi_samp,
+                                         const double burnin_prop = 0.8,
+                                         Rcpp::Nullable<Rcpp::CharacterVector> dir = R_NilValue,
+                                         const double thinning_num = 1,
+                                         const double beta_N_t = 1,
+                                         int N_t = 1,
+                                         int n_temp_trans = 0,
+                                         int r_stored_iters = 0,
+                                         Rcpp::Nullable<Rcpp::NumericVector> c  = R_NilValue,
+                                         const double b = 10,
+                                         const double nu_1 = 3,
+                                         const double alpha1l = 2,
+                                         const double alpha2l = 3,
+                                         const double beta1l = 2,
+                                         const double beta2l = 2,
+                                         const double a_Z_PM = 10000,
+                                         const double a_pi_PM = 1000,
+                                         const double var_alpha3 = 0.05,
+                                         const double var_epsilon1 = 1,
+                                         const double var_epsilon2 = 1,
+                                         const double alpha = 1,
+                                         const double beta = 10,
+                                         const double alpha_0 = 1,
+                                         const double beta_0 = 1,
+                                         Rcpp::Nullable<Rcpp::List> control = R_NilValue){
 
   // generate warnings
   if(tot_mcmc_iters <  100){
@@ -806,15 +2143,15 @@ Rcpp::List BFMMM_warm_start(const int tot_mcmc_iters,
   if(n_funct <  1){
     Rcpp::stop("'n_funct' must be an integer greater than or equal to 1");
   }
+  if(X.n_rows != n_funct){
+    Rcpp::stop("'X' must have 'n_funct' rows");
+  }
   if(basis_degree <  1){
     Rcpp::stop("'basis_degree' must be an integer greater than or equal to 1");
   }
   if(n_eigen <  1){
     Rcpp::stop("'n_eigen' must be an integer greater than or equal to 1");
   }
-  if(n_funct <  1){
-    Rcpp::stop("'n_funct' must be an integer greater than or equal to 1");
-  }
   for(int i = 0; i < internal_knots.n_elem; i++){
     if(boundary_knots(0) >= internal_knots(i)){
       Rcpp::stop("at least one element in 'internal_knots' is less than or equal to first boundary knot");
@@ -914,11 +2251,6 @@ Rcpp::List BFMMM_warm_start(const int tot_mcmc_iters,
   if(dir.isNotNull()){
     Rcpp::CharacterVector s(dir);
     dir1 = std::string(s[0]);
-
-    // save entire chain at last iteration
-    if(r_stored_iters == 0){
-      r_stored_iters = tot_mcmc_iters;
-    }
   }
 
   // Check if there is a place to store files if r_stored_iters < tot_mcmc_iters
@@ -939,6 +2271,14 @@ Rcpp::List BFMMM_warm_start(const int tot_mcmc_iters,
     r_stored_iters = tot_mcmc_iters + 1;
   }
 
+  // parameters saved to dir and how often they are saved
+  BayesFMMM::SamplerControl ctrl =
+    BayesFMMM::makeSamplerControl(control, BayesFMMM::storageControls());
+  BayesFMMM::RetentionPolicy retention =
+    BayesFMMM::makeRetentionPolicy(BayesFMMM::covariateAdjParams(), thinning_num,
+                                   r_stored_iters, ctrl.retain);
+  retention.codec = ctrl.codec;
+
   // Start of Algorithm
   splines2::BSpline bspline;
   // Make B_obs
@@ -981,24 +2321,6 @@ Rcpp::List BFMMM_warm_start(const int tot_mcmc_iters,
   for(int i = 0; i < Z_est.n_rows; i++){
     Z_est.row(i) = Z_est.row(i) / arma::accu(Z_est.row(i));
   }
-
-  // // rescale Z and nu
-  // arma::mat transform_mat = arma::zeros(Z_samp.n_cols, Z_samp.n_cols);
-  // int max_ind = 0;
-  // for(int i = 0; i < Z_est.n_cols; i++){
-  //   max_ind = arma::index_max(Z_est.col(i));
-  //   transform_mat.row(i) = Z_est.row(max_ind);
-  // }
-  // arma::mat Z_est_rescale = Z_est * arma::pinv(transform_mat);
-  // arma::mat nu_est_rescale = transform_mat * nu_est;
-  // transform_mat(0,0) = 0.95;
-  // transform_mat(0,1) = 0.05;
-  // transform_mat(1,0) = 0.95;
-  // transform_mat(1,0) = 0.05;
-  //
-  // Z_est_rescale = Z_est_rescale * transform_mat;
-  // nu_est_rescale = arma::pinv(transform_mat) * nu_est_rescale;
-
   pi_est = pi_est / arma::accu(pi_est);
 
   int n_Phi = sigma_samp.n_elem;
@@ -1015,17 +2337,17 @@ Rcpp::List BFMMM_warm_start(const int tot_mcmc_iters,
     }
   }
 
-  arma::cube gamma_est = arma::zeros(gamma_samp(0,0).n_rows, gamma_samp(0,0).n_cols, gamma_samp(0,0).n_slices);
-  arma::cube Phi_est = arma::zeros(Phi_samp(0,0).n_rows, Phi_samp(0,0).n_cols, Phi_samp(0,0).n_slices);
+  arma::cube gamma_est = arma::zeros(gamma_samp.n_rows, gamma_samp.n_cols, gamma_samp.n_slices);
+  arma::cube Phi_est = arma::zeros(Phi_samp.n_rows, Phi_samp.n_cols, Phi_samp.n_slices);
   arma::vec ph_phi = arma::zeros(n_Phi - std::round(n_Phi * burnin_prop));
   arma::vec ph_gamma = arma::zeros(n_Phi - std::round(n_Phi * burnin_prop));
   for(int i = 0; i < Phi_est.n_rows; i++){
     for(int j = 0; j < Phi_est.n_cols; j++){
       for(int m = 0; m < Phi_est.n_slices; m++){
         for(int l = std::round(n_Phi * burnin_prop); l < n_Phi; l++){
-          ph_phi(l - std::round(n_Phi * burnin_prop)) = Phi_samp(l,0)(i,j,m);
+          ph_phi(l - std::round(n_Phi * burnin_prop)) = Phi_samp(l,i,j,m);
 
-          ph_gamma(l - std::round(n_Phi * burnin_prop)) = gamma_samp(l,0)(i,j,m);
+          ph_gamma(l - std::round(n_Phi * burnin_prop)) = gamma_samp(l,i,j,m);
         }
         Phi_est(i,j,m) = arma::median(ph_phi);
         gamma_est(i,j,m) = arma::median(ph_gamma);
@@ -1064,33 +2386,39 @@ Rcpp::List BFMMM_warm_start(const int tot_mcmc_iters,
   }
 
   // start MCMC sampling
-  Rcpp::List mod1 = BayesFMMM::BFMMM_MTT_warm_start(Y, time, n_funct, thinning_num, k,
-                                                    basis_degree, n_eigen, boundary_knots,
-                                                    internal_knots, tot_mcmc_iters,
-                                                    r_stored_iters, n_temp_trans,
-                                                    c1, b, nu_1, alpha1l, alpha2l,
-                                                    beta1l, beta2l, a_Z_PM, a_pi_PM,
-                                                    var_alpha3, var_epsilon1,
-                                                    var_epsilon2, alpha, beta, alpha_0,
-                                                    beta_0, dir1, beta_N_t, N_t,
-                                                    Z_est, pi_est, alpha_3_est,
-                                                    delta_est, gamma_est, Phi_est, A_est,
-                                                    nu_est, tau_est, sigma_est, chi_est);
+  Rcpp::List mod1 = BayesFMMM::BFMMM_CovariateAdj_MTT(Y, time, n_funct, X, thinning_num,
+                                                      k, basis_degree, n_eigen,
+                                                      boundary_knots, internal_knots,
+                                                      tot_mcmc_iters, r_stored_iters,
+                                                      n_temp_trans, c1, b, nu_1,
+                                                      alpha1l, alpha2l, beta1l, beta2l,
+                                                      a_Z_PM, a_pi_PM, var_alpha3,
+                                                      var_epsilon1, var_epsilon2, alpha,
+                                                      beta, alpha_0, beta_0, dir1,
+                                                      beta_N_t, N_t, Z_est, pi_est,
+                                                      alpha_3_est, delta_est, gamma_est,
+                                                      Phi_est, A_est, nu_est, tau_est,
+                                                      sigma_est, chi_est, retention);
 
   Rcpp::List mod2 =  Rcpp::List::create(Rcpp::Named("B_obs", B_obs),
                                         Rcpp::Named("nu", mod1["nu"]),
+                                        Rcpp::Named("eta", mod1["eta"]),
                                         Rcpp::Named("chi", mod1["chi"]),
                                         Rcpp::Named("pi", mod1["pi"]),
                                         Rcpp::Named("alpha_3", mod1["alpha_3"]),
                                         Rcpp::Named("A", mod1["A"]),
+                                        Rcpp::Named("A_xi", mod1["A_xi"]),
                                         Rcpp::Named("delta", mod1["delta"]),
+                                        Rcpp::Named("delta_xi", mod1["delta_xi"]),
                                         Rcpp::Named("sigma", mod1["sigma"]),
                                         Rcpp::Named("tau", mod1["tau"]),
+                                        Rcpp::Named("tau_eta", mod1["tau_eta"]),
                                         Rcpp::Named("gamma", mod1["gamma"]),
+                                        Rcpp::Named("gamma_xi", mod1["gamma_xi"]),
                                         Rcpp::Named("Phi", mod1["Phi"]),
+                                        Rcpp::Named("xi", mod1["xi"]),
                                         Rcpp::Named("Z", mod1["Z"]),
                                         Rcpp::Named("loglik", mod1["loglik"]));
-
   return mod2;
 }
 
@@ -1098,7 +2426,9 @@ Rcpp::List BFMMM_warm_start(const int tot_mcmc_iters,
 //' Reads saved parameter data (sigma, alpha_3)
 //'
 //' Reads armadillo vector type data and returns it as a vector in R. The following
-//' parameters can be read in using this function: sigma and alpha_3.
+//' parameters can be read in using this function: sigma and alpha_3. Files saved
+//' with a storage codec (\code{codec} option of the samplers) are decoded
+//' automatically.
 //'
 //' @name ReadVec
 //' @param file String containing location where armadillo vector is stored
@@ -1135,14 +2465,16 @@ Rcpp::List BFMMM_warm_start(const int tot_mcmc_iters,
 // [[Rcpp::export]]
 arma::vec ReadVec(std::string file){
   arma::vec B;
-  B.load(file);
+  BayesFMMM::loadSamples(B, file);
   return B;
 }
 
 //' Reads saved parameter data (pi, A, delta, tau)
 //'
 //' Reads armadillo matrix type data and returns it as a matirx in R. The following
-//' parameters can be read in using this function: pi, A, delta, and tau.
+//' parameters can be read in using this function: pi, A, delta, and tau. Files
+//' saved with a storage codec (\code{codec} option of the samplers) are
+//' decoded automatically.
 //'
 //' @name ReadMat
 //' @param file String containing location where armadillo matrix is stored
@@ -1182,14 +2514,16 @@ arma::vec ReadVec(std::string file){
 // [[Rcpp::export]]
 arma::mat ReadMat(std::string file){
   arma::mat B;
-  B.load(file);
+  BayesFMMM::loadSamples(B, file);
   return B;
 }
 
 //' Reads saved parameter data (nu, chi, Z)
 //'
 //' Reads armadillo cube type data and returns it as an array in R. The following
-//' parameters can be read in using this function: nu, chi, and Z.
+//' parameters can be read in using this function: nu, chi, and Z. Files saved
+//' with a storage codec (\code{codec} option of the samplers) are decoded
+//' automatically.
 //'
 //' @name ReadCube
 //' @param file String containing location where armadillo cube is stored
@@ -1230,7 +2564,7 @@ arma::mat ReadMat(std::string file){
 // [[Rcpp::export]]
 arma::cube ReadCube(std::string file){
   arma::cube B;
-  B.load(file);
+  BayesFMMM::loadSamples(B, file);
   return B;
 }
 
@@ -1238,7 +2572,8 @@ arma::cube ReadCube(std::string file){
 //'
 //' Reads armadillo field of cubes type data and returns it as a list of arrays
 //' in R. The following parameters can be read in using this function: gamma and
-//' Phi.
+//' Phi. Files saved with a storage codec (\code{codec} option of the samplers)
+//' are decoded automatically.
 //'
 //' @name ReadFieldCube
 //' @param file String containing location where armadillo field of cubes is stored
@@ -1280,7 +2615,7 @@ arma::cube ReadCube(std::string file){
 // [[Rcpp::export]]
 arma::field<arma::cube> ReadFieldCube(std::string file){
   arma::field<arma::cube> B;
-  B.load(file);
+  BayesFMMM::loadSamples(B, file);
   return B;
 }
 
@@ -1332,6 +2667,181 @@ arma::field<arma::vec> ReadFieldVec(std::string file){
   return B;
 }
 
+//' Reads all saved files of a parameter (nu, chi, Z)
+//'
+//' Reads the files of a parameter saved as an armadillo cube (for example
+//' Nu0.txt, Nu1.txt, ...) and returns the MCMC samples of all files in one
+//' array. The files are read concurrently, and files saved with a storage
+//' codec are decoded automatically.
+//'
+//' @name ReadCubeFiles
+//' @param dir String containing the directory where the MCMC files are located
+//' @param name String containing the name of the parameter (prefix of the files, such as "Nu", "Chi" or "Z")
+//' @param n_files Int containing the number of files per parameter
+//' @returns Cube Array containing the MCMC samples of all files (one sample per slice)
+//'
+//' @examples
+//' ## set directory
+//' dir <- system.file("test-data", "", package = "BayesFMMM")
+//'
+//' ## Read in files
+//' nu <- ReadCubeFiles(dir, "Nu", 1)
+//'
+//' @export
+// [[Rcpp::export]]
+arma::cube ReadCubeFiles(std::string dir,
+                         std::string name,
+                         int n_files){
+  return BayesFMMM::loadCubeSamples(dir, name, n_files);
+}
+
+//' Reads all saved files of a parameter (gamma, Phi)
+//'
+//' Reads the files of a parameter saved as an armadillo field of cubes (for
+//' example Phi0.txt, Phi1.txt, ...) and returns the MCMC samples of all files
+//' in one list. The files are read concurrently, and files saved with a storage
+//' codec are decoded automatically.
+//'
+//' @name ReadFieldCubeFiles
+//' @param dir String containing the directory where the MCMC files are located
+//' @param name String containing the name of the parameter (prefix of the files, such as "Phi" or "Gamma")
+//' @param n_files Int containing the number of files per parameter
+//' @returns FieldCube List of arrays containing the MCMC samples of all files
+//'
+//' @examples
+//' ## set directory
+//' dir <- system.file("test-data", "", package = "BayesFMMM")
+//'
+//' ## Read in files
+//' Phi <- ReadFieldCubeFiles(dir, "Phi", 1)
+//'
+//' @export
+// [[Rcpp::export]]
+arma::field<arma::cube> ReadFieldCubeFiles(std::string dir,
+                                           std::string name,
+                                           int n_files){
+  return BayesFMMM::loadFieldSamples(dir, name, n_files);
+}
+
+//' Reads all saved files of a parameter (sigma, alpha_3)
+//'
+//' Reads the files of a parameter saved as an armadillo vector (for example
+//' Sigma0.txt, Sigma1.txt, ...) and returns the MCMC samples of all files in
+//' one vector. The files are read concurrently, and files saved with a storage
+//' codec are decoded automatically.
+//'
+//' @name ReadVecFiles
+//' @param dir String containing the directory where the MCMC files are located
+//' @param name String containing the name of the parameter (prefix of the files, such as "Sigma" or "alpha_3")
+//' @param n_files Int containing the number of files per parameter
+//' @returns Vec Vector containing the MCMC samples of all files
+//'
+//' @examples
+//' ## set directory
+//' dir <- system.file("test-data", "", package = "BayesFMMM")
+//'
+//' ## Read in files
+//' sigma <- ReadVecFiles(dir, "Sigma", 1)
+//'
+//' @export
+// [[Rcpp::export]]
+arma::vec ReadVecFiles(std::string dir,
+                       std::string name,
+                       int n_files){
+  return BayesFMMM::loadVecSamples(dir, name, n_files);
+}
+
+//' Converts a directory of saved MCMC samples to a storage codec
+//'
+//' Reads every file saved by the samplers in \code{dir} (for example the
+//' files saved in the armadillo text format by previous versions of the
+//' package) and writes them to \code{out_dir} with a storage codec, keeping
+//' the names of the files. The files are converted concurrently. The converted
+//' files can be read by all functions of the package that read saved MCMC
+//' samples. \code{out_dir} can be the same as \code{dir}, in which case the
+//' files are replaced.
+//'
+//' @name ConvertSampleDir
+//' @param dir String containing the directory where the MCMC files are located
+//' @param out_dir String containing the directory where the converted files are saved
+//' @param codec String containing how the converted files are stored: "lossless" (byte-shuffled and compressed), "float16" (half precision, relative error of at most 2^-11), "quantized" (absolute error of at most \code{codec_tol}) or "arma_ascii" (Armadillo text format)
+//' @param codec_tol Double containing the largest absolute error of the saved values when using the quantized codec
+//' @returns n_files Named vector containing the number of files converted for each parameter
+//'
+//' @examples
+//' ## set directories
+//' dir <- system.file("test-data", "", package = "BayesFMMM")
+//' out_dir <- paste0(tempdir(), "/")
+//'
+//' ## Convert files
+//' n_files <- ConvertSampleDir(dir, out_dir)
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::IntegerVector ConvertSampleDir(std::string dir,
+                                     std::string out_dir,
+                                     std::string codec = "lossless",
+                                     double codec_tol = 1e-4){
+  std::vector<std::string> params = BayesFMMM::covariateAdjParams();
+  arma::uvec n_files =
+    BayesFMMM::convertSampleDirectory(dir, out_dir, params,
+                                      BayesFMMM::makeSampleCodec(codec, codec_tol));
+  Rcpp::IntegerVector n_converted(params.size());
+  n_converted.names() = Rcpp::wrap(params);
+  for(std::size_t j = 0; j < params.size(); j++){
+    n_converted[j] = n_files(j);
+  }
+  return n_converted;
+}
+
+//' Writes functional data to an observation store
+//'
+//' Writes the observed functions to a binary file that can be used as the
+//' \code{data_file} option of \code{BFMMM_warm_start}. The sampler memory-maps the
+//' file and streams it one function at a time, keeping only the sufficient
+//' statistics of each function in RAM, so cohorts whose observations do not
+//' fit in RAM can be analyzed. A large cohort can be written in chunks by
+//' setting \code{append = TRUE} for every chunk after the first.
+//'
+//' @name WriteObsStore
+//' @param Y List of vectors containing the observed values
+//' @param time List of vectors containing the observed time points
+//' @param file String containing the path of the observation store
+//' @param append Boolean indicating whether the functions are added to the end of an existing observation store
+//' @returns n_funct Int containing the number of functions in the observation store
+//'
+//' @examples
+//' ## Load sample data
+//' Y <- readRDS(system.file("test-data", "Sim_data.RDS", package = "BayesFMMM"))
+//' time <- readRDS(system.file("test-data", "time.RDS", package = "BayesFMMM"))
+//'
+//' ## Write the first 20 functions and then the other 20 functions
+//' file <- paste0(tempdir(), "/obs.bin")
+//' WriteObsStore(Y[1:20], time[1:20], file)
+//' n_funct <- WriteObsStore(Y[21:40], time[21:40], file, append = TRUE)
+//'
+//' @export
+// [[Rcpp::export]]
+int WriteObsStore(const arma::field<arma::vec>& Y,
+                  const arma::field<arma::vec>& time,
+                  std::string file,
+                  bool append = false){
+  if(Y.n_elem != time.n_elem){
+    Rcpp::stop("'Y' and 'time' must have the same number of functions");
+  }
+  for(arma::uword i = 0; i < Y.n_elem; i++){
+    if(Y(i).n_elem != time(i).n_elem){
+      Rcpp::stop("the elements of 'Y' and 'time' must have the same length");
+    }
+  }
+  if(!BayesFMMM::writeObsStore(Y, time, file, append)){
+    Rcpp::stop("unable to write '" + file + "'");
+  }
+  BayesFMMM::ObsStore store;
+  BayesFMMM::openObsStore(file, store);
+  return store.n_funct();
+}
+
 //' Find initial starting position for nu and Z parameters for high dimensional functional data (Domain dimension > 1)
 //'
 //' Function for finding a good initial starting point for nu parameters and Z
@@ -1434,13 +2944,13 @@ arma::field<arma::vec> ReadFieldVec(std::string file){
 Rcpp::List BHDFMMM_Nu_Z_multiple_try(const int tot_mcmc_iters,
                                      const int n_try,
                                      const int k,
-                                     const arma::field<arma::vec> Y,
-                                     const arma::field<arma::mat> time,
+                                     const arma::field<arma::vec>& Y,
+                                     const arma::field<arma::mat>& time,
                                      const int n_funct,
-                                     const arma::vec basis_degree,
+                                     const arma::vec& basis_degree,
                                      const int n_eigen,
-                                     const arma::mat boundary_knots,
-                                     const arma::field<arma::vec> internal_knots,
+                                     const arma::mat& boundary_knots,
+                                     const arma::field<arma::vec>& internal_knots,
                                      Rcpp::Nullable<Rcpp::NumericVector> c  = R_NilValue,
                                      const double b = 10,
                                      const double alpha1l = 1,
@@ -1707,15 +3217,15 @@ Rcpp::List BHDFMMM_Nu_Z_multiple_try(const int tot_mcmc_iters,
 Rcpp::List BHDFMMM_Theta_est(const int tot_mcmc_iters,
                              const int n_try,
                              const int k,
-                             const arma::field<arma::vec> Y,
-                             const arma::field<arma::mat> time,
+                             const arma::field<arma::vec>& Y,
+                             const arma::field<arma::mat>& time,
                              const int n_funct,
-                             const arma::vec basis_degree,
+                             const arma::vec& basis_degree,
                              const int n_eigen,
-                             const arma::mat boundary_knots,
-                             const arma::field<arma::vec> internal_knots,
-                             const arma::cube Z_samp,
-                             const arma::cube nu_samp,
+                             const arma::mat& boundary_knots,
+                             const arma::field<arma::vec>& internal_knots,
+                             const arma::cube& Z_samp,
+                             const arma::cube& nu_samp,
                              const double burnin_prop = 0.8,
                              Rcpp::Nullable<Rcpp::NumericVector> c  = R_NilValue,
                              const double b = 10,
@@ -1952,8 +3462,8 @@ Rcpp::List BHDFMMM_Theta_est(const int tot_mcmc_iters,
 //' @param pi_samp Matrix containing initial chain of pi parameters (from \code{BFMMM_NU_Z_multiple_try})
 //' @param alpha_3_samp Vector containing initial chain of alpha_3 parameters (from \code{BFMMM_NU_Z_multiple_try})
 //' @param delta_samp Matrix containing initial chain of delta parameters (from \code{BFMMM_Theta_est})
-//' @param gamma_samp List of cubes containing initial chain of gamma parameters (from \code{BFMMM_Theta_est})
-//' @param Phi_samp List of cubes containing initial chain of phi parameters (from \code{BFMMM_Theta_est})
+//' @param gamma_samp List of cubes containing initial chain of gamma parameters (from \code{BFMMM_Theta_est}), or a 4-dimensional array with the chain stacked along the last dimension
+//' @param Phi_samp List of cubes containing initial chain of phi parameters (from \code{BFMMM_Theta_est}), or a 4-dimensional array with the chain stacked along the last dimension
 //' @param A_samp Matrix containing initial chain of A parameters (from \code{BFMMM_Theta_est})
 //' @param nu_samp Cube containing initial chain of nu parameters (from \code{BFMMM_NU_Z_multiple_try})
 //' @param tau_samp Matrix containing initial chain of tau parameters (from \code{BFMMM_NU_Z_multiple_try})
@@ -1982,6 +3492,12 @@ Rcpp::List BHDFMMM_Theta_est(const int tot_mcmc_iters,
 //' @param beta Double containing hyperparameter for sampling from tau (scale)
 //' @param alpha_0 Double containing hyperparameter for sampling from sigma
 //' @param beta_0 Double containing hyperparameter for sampling from sigma (scale)
+//' @param control List containing the options of the sampler that do not change the model. Options that are not in the list keep their default values (\code{codec = "arma_ascii"}, \code{codec_tol = 1e-4}; \code{retain} defaults to NULL), and names that are not listed below give an error:
+//' \describe{
+//'   \item{\code{retain}}{Named vector containing how often each parameter is saved to \code{dir}, where the names are the prefixes of the files of the parameters (for example \code{c(Nu = 1, Phi = 1, Z = 1, Chi = 1, Sigma = 1, Gamma = 10)}). Parameters that are not named are not saved. Nu, Phi, Z, Chi, Sigma, Pi and alpha_3 are read together by the posterior summaries, so the ones that are saved must have the same value. If NULL, every parameter is saved every \code{thinning_num} iterations}
+//'   \item{\code{codec}}{String containing how the saved parameters are stored: "arma_ascii" (Armadillo text format), "lossless" (byte-shuffled and compressed), "float16" (half precision, relative error of at most 2^-11) or "quantized" (absolute error of at most \code{codec_tol}). The files can be read with \code{ReadCube}, \code{ReadFieldCube}, \code{ReadMat} and \code{ReadVec}}
+//'   \item{\code{codec_tol}}{Double containing the largest absolute error of the saved values when using the quantized codec}
+//' }
 //'
 //' @returns a List containing:
 //' \describe{
@@ -2069,24 +3585,24 @@ Rcpp::List BHDFMMM_Theta_est(const int tot_mcmc_iters,
 // [[Rcpp::export]]
 Rcpp::List BHDFMMM_warm_start(const int tot_mcmc_iters,
                               const int k,
-                              const arma::field<arma::vec> Y,
-                              const arma::field<arma::mat> time,
+                              const arma::field<arma::vec>& Y,
+                              const arma::field<arma::mat>& time,
                               const int n_funct,
-                              const arma::vec basis_degree,
+                              const arma::vec& basis_degree,
                               const int n_eigen,
-                              const arma::mat boundary_knots,
-                              const arma::field<arma::vec> internal_knots,
-                              const arma::cube Z_samp,
-                              const arma::mat pi_samp,
-                              const arma::vec alpha_3_samp,
-                              const arma::cube delta_samp,
-                              const arma::field<arma::cube> gamma_samp,
-                              const arma::field<arma::cube> Phi_samp,
-                              const arma::cube A_samp,
-                              const arma::cube nu_samp,
-                              const arma::mat tau_samp,
-                              const arma::vec sigma_samp,
-                              const arma::cube chi_samp,
+                              const arma::mat& boundary_knots,
+                              const arma::field<arma::vec>& internal_knots,
+                              const arma::cube& Z_samp,
+                              const arma::mat& pi_samp,
+                              const arma::vec& alpha_3_samp,
+                              const arma::cube& delta_samp,
+                              const BayesFMMM::CubeList& gamma_samp,
+                              const BayesFMMM::CubeList& Phi_samp,
+                              const arma::cube& A_samp,
+                              const arma::cube& nu_samp,
+                              const arma::mat& tau_samp,
+                              const arma::vec& sigma_samp,
+                              const arma::cube& chi_samp,
                               const double burnin_prop = 0.8,
                               Rcpp::Nullable<Rcpp::CharacterVector> dir = R_NilValue,
                               const double thinning_num = 1,
@@ -2109,7 +3625,8 @@ Rcpp::List BHDFMMM_warm_start(const int tot_mcmc_iters,
                               const double alpha = 1,
                               const double beta = 10,
                               const double alpha_0 = 1,
-                              const double beta_0 = 1){
+                              const double beta_0 = 1,
+                              Rcpp::Nullable<Rcpp::List> control = R_NilValue){
 
   // generate warnings
   if(tot_mcmc_iters <  100){
@@ -2267,6 +3784,14 @@ Rcpp::List BHDFMMM_warm_start(const int tot_mcmc_iters,
     r_stored_iters = tot_mcmc_iters + 1;
   }
 
+  // parameters saved to dir and how often they are saved
+  BayesFMMM::SamplerControl ctrl =
+    BayesFMMM::makeSamplerControl(control, BayesFMMM::storageControls());
+  BayesFMMM::RetentionPolicy retention =
+    BayesFMMM::makeRetentionPolicy(BayesFMMM::modelParams(), thinning_num,
+                                   r_stored_iters, ctrl.retain);
+  retention.codec = ctrl.codec;
+
   // Start of Algorithm
   arma::field<arma::mat> B_obs = BayesFMMM::TensorBSpline(time, n_funct, basis_degree,
                                                           boundary_knots, internal_knots);
@@ -2332,17 +3857,17 @@ Rcpp::List BHDFMMM_warm_start(const int tot_mcmc_iters,
     }
   }
 
-  arma::cube gamma_est = arma::zeros(gamma_samp(0,0).n_rows, gamma_samp(0,0).n_cols, gamma_samp(0,0).n_slices);
-  arma::cube Phi_est = arma::zeros(Phi_samp(0,0).n_rows, Phi_samp(0,0).n_cols, Phi_samp(0,0).n_slices);
+  arma::cube gamma_est = arma::zeros(gamma_samp.n_rows, gamma_samp.n_cols, gamma_samp.n_slices);
+  arma::cube Phi_est = arma::zeros(Phi_samp.n_rows, Phi_samp.n_cols, Phi_samp.n_slices);
   arma::vec ph_phi = arma::zeros(n_Phi - std::round(n_Phi * burnin_prop));
   arma::vec ph_gamma = arma::zeros(n_Phi - std::round(n_Phi * burnin_prop));
   for(int i = 0; i < Phi_est.n_rows; i++){
     for(int j = 0; j < Phi_est.n_cols; j++){
       for(int m = 0; m < Phi_est.n_slices; m++){
         for(int l = std::round(n_Phi * burnin_prop); l < n_Phi; l++){
-          ph_phi(l - std::round(n_Phi * burnin_prop)) = Phi_samp(l,0)(i,j,m);
+          ph_phi(l - std::round(n_Phi * burnin_prop)) = Phi_samp(l,i,j,m);
 
-          ph_gamma(l - std::round(n_Phi * burnin_prop)) = gamma_samp(l,0)(i,j,m);
+          ph_gamma(l - std::round(n_Phi * burnin_prop)) = gamma_samp(l,i,j,m);
         }
         Phi_est(i,j,m) = arma::median(ph_phi);
         gamma_est(i,j,m) = arma::median(ph_gamma);
@@ -2392,7 +3917,8 @@ Rcpp::List BHDFMMM_warm_start(const int tot_mcmc_iters,
                                                       beta_0, dir1, beta_N_t, N_t,
                                                       Z_est, pi_est, alpha_3_est,
                                                       delta_est, gamma_est, Phi_est, A_est,
-                                                      nu_est, tau_est, sigma_est, chi_est);
+                                                      nu_est, tau_est, sigma_est, chi_est,
+                                                      retention);
 
   Rcpp::List mod2 =  Rcpp::List::create(Rcpp::Named("B_obs", B_obs),
                                         Rcpp::Named("nu", mod1["nu"]),
@@ -2495,7 +4021,7 @@ Rcpp::List BHDFMMM_warm_start(const int tot_mcmc_iters,
 Rcpp::List BMVMMM_Nu_Z_multiple_try(const int tot_mcmc_iters,
                                     const int n_try,
                                     const int k,
-                                    const arma::mat Y,
+                                    const arma::mat& Y,
                                     const int n_eigen,
                                     Rcpp::Nullable<Rcpp::NumericVector> c  = R_NilValue,
                                     const double b = 10,
@@ -2717,10 +4243,10 @@ Rcpp::List BMVMMM_Nu_Z_multiple_try(const int tot_mcmc_iters,
 Rcpp::List BMVMMM_Theta_est(const int tot_mcmc_iters,
                             const int n_try,
                             const int k,
-                            const arma::mat Y,
+                            const arma::mat& Y,
                             const int n_eigen,
-                            const arma::cube Z_samp,
-                            const arma::cube nu_samp,
+                            const arma::cube& Z_samp,
+                            const arma::cube& nu_samp,
                             const double burnin_prop = 0.8,
                             Rcpp::Nullable<Rcpp::NumericVector> c  = R_NilValue,
                             const double b = 10,
@@ -2926,8 +4452,8 @@ Rcpp::List BMVMMM_Theta_est(const int tot_mcmc_iters,
 //' @param pi_samp Matrix containing initial chain of pi parameters (from \code{BFMMM_NU_Z_multiple_try})
 //' @param alpha_3_samp Vector containing initial chain of alpha_3 parameters (from \code{BFMMM_NU_Z_multiple_try})
 //' @param delta_samp Matrix containing initial chain of delta parameters (from \code{BFMMM_Theta_est})
-//' @param gamma_samp List of cubes containing initial chain of gamma parameters (from \code{BFMMM_Theta_est})
-//' @param Phi_samp List of cubes containing initial chain of phi parameters (from \code{BFMMM_Theta_est})
+//' @param gamma_samp List of cubes containing initial chain of gamma parameters (from \code{BFMMM_Theta_est}), or a 4-dimensional array with the chain stacked along the last dimension
+//' @param Phi_samp List of cubes containing initial chain of phi parameters (from \code{BFMMM_Theta_est}), or a 4-dimensional array with the chain stacked along the last dimension
 //' @param A_samp Matrix containing initial chain of A parameters (from \code{BFMMM_Theta_est})
 //' @param nu_samp Cube containing initial chain of nu parameters (from \code{BFMMM_NU_Z_multiple_try})
 //' @param tau_samp Matrix containing initial chain of tau parameters (from \code{BFMMM_NU_Z_multiple_try})
@@ -2956,6 +4482,12 @@ Rcpp::List BMVMMM_Theta_est(const int tot_mcmc_iters,
 //' @param beta Double containing hyperparameter for sampling from tau (scale)
 //' @param alpha_0 Double containing hyperparameter for sampling from sigma
 //' @param beta_0 Double containing hyperparameter for sampling from sigma (scale)
+//' @param control List containing the options of the sampler that do not change the model. Options that are not in the list keep their default values (\code{codec = "arma_ascii"}, \code{codec_tol = 1e-4}; \code{retain} defaults to NULL), and names that are not listed below give an error:
+//' \describe{
+//'   \item{\code{retain}}{Named vector containing how often each parameter is saved to \code{dir}, where the names are the prefixes of the files of the parameters (for example \code{c(Nu = 1, Phi = 1, Z = 1, Chi = 1, Sigma = 1, Gamma = 10)}). Parameters that are not named are not saved. Nu, Phi, Z, Chi, Sigma, Pi and alpha_3 are read together by the posterior summaries, so the ones that are saved must have the same value. If NULL, every parameter is saved every \code{thinning_num} iterations}
+//'   \item{\code{codec}}{String containing how the saved parameters are stored: "arma_ascii" (Armadillo text format), "lossless" (byte-shuffled and compressed), "float16" (half precision, relative error of at most 2^-11) or "quantized" (absolute error of at most \code{codec_tol}). The files can be read with \code{ReadCube}, \code{ReadFieldCube}, \code{ReadMat} and \code{ReadVec}}
+//'   \item{\code{codec_tol}}{Double containing the largest absolute error of the saved values when using the quantized codec}
+//' }
 //'
 //' @returns a List containing:
 //' \describe{
@@ -3029,19 +4561,19 @@ Rcpp::List BMVMMM_Theta_est(const int tot_mcmc_iters,
 // [[Rcpp::export]]
 Rcpp::List BMVMMM_warm_start(const int tot_mcmc_iters,
                              const int k,
-                             const arma::mat Y,
+                             const arma::mat& Y,
                              const int n_eigen,
-                             const arma::cube Z_samp,
-                             const arma::mat pi_samp,
-                             const arma::vec alpha_3_samp,
-                             const arma::cube delta_samp,
-                             const arma::field<arma::cube> gamma_samp,
-                             const arma::field<arma::cube> Phi_samp,
-                             const arma::cube A_samp,
-                             const arma::cube nu_samp,
-                             const arma::mat tau_samp,
-                             const arma::vec sigma_samp,
-                             const arma::cube chi_samp,
+                             const arma::cube& Z_samp,
+                             const arma::mat& pi_samp,
+                             const arma::vec& alpha_3_samp,
+                             const arma::cube& delta_samp,
+                             const BayesFMMM::CubeList& gamma_samp,
+                             const BayesFMMM::CubeList& Phi_samp,
+                             const arma::cube& A_samp,
+                             const arma::cube& nu_samp,
+                             const arma::mat& tau_samp,
+                             const arma::vec& sigma_samp,
+                             const arma::cube& chi_samp,
                              const double burnin_prop = 0.8,
                              Rcpp::Nullable<Rcpp::CharacterVector> dir = R_NilValue,
                              const double thinning_num = 1,
@@ -3064,7 +4596,8 @@ Rcpp::List BMVMMM_warm_start(const int tot_mcmc_iters,
                              const double alpha = 1,
                              const double beta = 10,
                              const double alpha_0 = 1,
-                             const double beta_0 = 1){
+                             const double beta_0 = 1,
+                             Rcpp::Nullable<Rcpp::List> control = R_NilValue){
 
   // generate warnings
   if(tot_mcmc_iters <  100){
@@ -3198,6 +4731,14 @@ Rcpp::List BMVMMM_warm_start(const int tot_mcmc_iters,
     r_stored_iters = tot_mcmc_iters + 1;
   }
 
+  // parameters saved to dir and how often they are saved
+  BayesFMMM::SamplerControl ctrl =
+    BayesFMMM::makeSamplerControl(control, BayesFMMM::storageControls());
+  BayesFMMM::RetentionPolicy retention =
+    BayesFMMM::makeRetentionPolicy(BayesFMMM::modelParams(), thinning_num,
+                                   r_stored_iters, ctrl.retain);
+  retention.codec = ctrl.codec;
+
   // Start of Algorithm
 
   int n_nu = alpha_3_samp.n_elem;
@@ -3261,17 +4802,17 @@ Rcpp::List BMVMMM_warm_start(const int tot_mcmc_iters,
     }
   }
 
-  arma::cube gamma_est = arma::zeros(gamma_samp(0,0).n_rows, gamma_samp(0,0).n_cols, gamma_samp(0,0).n_slices);
-  arma::cube Phi_est = arma::zeros(Phi_samp(0,0).n_rows, Phi_samp(0,0).n_cols, Phi_samp(0,0).n_slices);
+  arma::cube gamma_est = arma::zeros(gamma_samp.n_rows, gamma_samp.n_cols, gamma_samp.n_slices);
+  arma::cube Phi_est = arma::zeros(Phi_samp.n_rows, Phi_samp.n_cols, Phi_samp.n_slices);
   arma::vec ph_phi = arma::zeros(n_Phi - std::round(n_Phi * burnin_prop));
   arma::vec ph_gamma = arma::zeros(n_Phi - std::round(n_Phi * burnin_prop));
   for(int i = 0; i < Phi_est.n_rows; i++){
     for(int j = 0; j < Phi_est.n_cols; j++){
       for(int m = 0; m < Phi_est.n_slices; m++){
         for(int l = std::round(n_Phi * burnin_prop); l < n_Phi; l++){
-          ph_phi(l - std::round(n_Phi * burnin_prop)) = Phi_samp(l,0)(i,j,m);
+          ph_phi(l - std::round(n_Phi * burnin_prop)) = Phi_samp(l,i,j,m);
 
-          ph_gamma(l - std::round(n_Phi * burnin_prop)) = gamma_samp(l,0)(i,j,m);
+          ph_gamma(l - std::round(n_Phi * burnin_prop)) = gamma_samp(l,i,j,m);
         }
         Phi_est(i,j,m) = arma::median(ph_phi);
         gamma_est(i,j,m) = arma::median(ph_gamma);
@@ -3320,7 +4861,8 @@ Rcpp::List BMVMMM_warm_start(const int tot_mcmc_iters,
                                                       beta_0, dir1, beta_N_t, N_t,
                                                       Z_est, pi_est, alpha_3_est,
                                                       delta_est, gamma_est, Phi_est, A_est,
-                                                      nu_est, tau_est, sigma_est, chi_est);
+                                                      nu_est, tau_est, sigma_est, chi_est,
+                                                      retention);
 
   Rcpp::List mod2 =  Rcpp::List::create(Rcpp::Named("nu", mod1["nu"]),
                                         Rcpp::Named("chi", mod1["chi"]),
@@ -0,0 +1,61 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Adapts the proposal scales when every proposal is accepted for the first
+// half of the functions and no proposal is accepted for the second half, and
+// checks that the scales move in the right direction and are frozen after
+// n_adapt iterations
+//
+arma::vec TestProposalTuning(){
+  int n_funct = 4;
+  int n_adapt = 50;
+  BayesFMMM::ProposalTuning tuning = BayesFMMM::makeProposalTuning(n_funct,
+                                                                   1000, 1000,
+                                                                   0.5, 1, 1,
+                                                                   n_adapt);
+  tuning.accept_Z = {1, 1, 0, 0};
+  tuning.accept_pi = 0;
+  tuning.accept_alpha3 = 1;
+  tuning.accept_A = {0, 1};
+  for(int i = 0; i < n_adapt; i++){
+    BayesFMMM::updateProposalTuning(i, tuning);
+  }
+  double a_Z_0 = tuning.a_Z_PM(0);
+  for(int i = n_adapt; i < 2 * n_adapt; i++){
+    BayesFMMM::updateProposalTuning(i, tuning);
+  }
+
+  arma::vec mod = arma::zeros(7);
+  // larger steps when proposals are always accepted
+  mod(0) = (tuning.a_Z_PM(0) < 1000) && (tuning.a_Z_PM(2) > 1000);
+  mod(1) = (tuning.a_pi_PM > 1000);
+  mod(2) = (tuning.var_alpha3 > 0.5);
+  mod(3) = (tuning.var_epsilon1 < 1) && (tuning.var_epsilon2 > 1);
+  // frozen after adaptation
+  mod(4) = std::abs(tuning.a_Z_PM(0) - a_Z_0);
+  mod(5) = tuning.n_frozen;
+  mod(6) = std::abs(tuning.mean_accept_Z(0) - 1) + tuning.mean_accept(0);
+  return mod;
+}
+
+context("Unit tests for adaptive proposal tuning") {
+  test_that("Robbins-Monro adaptation of proposal scales"){
+    arma::vec x = TestProposalTuning();
+    expect_true(x(0) == 1);
+    expect_true(x(1) == 1);
+    expect_true(x(2) == 1);
+    expect_true(x(3) == 1);
+    expect_true(x(4) == 0);
+    expect_true(x(5) == 50);
+    expect_true(x(6) < 1e-10);
+  }
+
+  test_that("Acceptance probability of Metropolis-Hastings ratios"){
+    expect_true(BayesFMMM::calcAcceptanceProb(0.5) == 1);
+    expect_true(std::abs(BayesFMMM::calcAcceptanceProb(std::log(0.25)) - 0.25) < 1e-12);
+    expect_true(BayesFMMM::calcAcceptanceProb(std::nan("")) == 0);
+  }
+
+}
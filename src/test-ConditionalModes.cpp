@@ -0,0 +1,185 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Compares the first row of nu from the ICM update with the conditional
+// posterior mean computed by updateNu
+//
+double TestNuICM(){
+  int n_funct = 20;
+  int K = 3;
+  int P = 8;
+  int M = 2;
+  arma::field<arma::mat> B_obs(n_funct,1);
+  arma::field<arma::vec> y_obs(n_funct,1);
+  for(int i = 0; i < n_funct; i++){
+    arma::vec t_obs =  arma::regspace(0, 20 + (i % 5), 990);
+    splines2::BSpline bspline;
+    bspline = splines2::BSpline(t_obs, P);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+    y_obs(i,0) = arma::randn(B_obs(i,0).n_rows);
+  }
+  BayesFMMM::RaggedObs obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+
+  arma::cube nu(K, P, 2, arma::fill::randn);
+  arma::cube Phi = 0.5 * arma::randn(K, P, M);
+  arma::mat Z(n_funct, K);
+  arma::vec alpha = {3, 3, 3};
+  for(int i = 0; i < n_funct; i++){
+    Z.row(i) = BayesFMMM::rdirichlet(alpha).t();
+  }
+  arma::mat chi(n_funct, M, arma::fill::randn);
+  arma::vec tau = {1, 2, 3};
+  double sigma = 0.5;
+  arma::mat P_mat = arma::eye(P, P);
+  arma::vec b_1(P);
+  arma::mat B_1(P, P);
+
+  arma::cube nu_icm = nu;
+  arma::mat nu_mean(K, P);
+  BayesFMMM::updateNu(obs, tau, Phi, Z, chi, sigma, 0, 2, P_mat, b_1, B_1, nu,
+                      nu_mean);
+  BayesFMMM::updateNuICM(obs, tau, Phi, Z, chi, sigma, 0, 2, P_mat, b_1, B_1,
+                         nu_icm);
+  return arma::abs(nu_icm.slice(0).row(0) - nu_mean.row(0)).max();
+}
+
+// Checks that projectSimplex returns a point of the simplex and leaves points
+// of the simplex unchanged
+//
+arma::vec TestProjectSimplex(){
+  arma::vec x = {0.8, -0.3, 1.2, 0.1};
+  arma::vec proj = BayesFMMM::projectSimplex(x);
+  arma::vec z = {0.1, 0.2, 0.3, 0.4};
+  arma::vec mod = arma::zeros(3);
+  mod(0) = proj.min();
+  mod(1) = std::abs(arma::accu(proj) - 1);
+  mod(2) = arma::abs(BayesFMMM::projectSimplex(z) - z).max();
+  return mod;
+}
+
+// Compares the conditional log posterior of the memberships of each function
+// at the ICM update of Z with its value at random points of the simplex
+// (within the bounds of the update). Returns the largest improvement found,
+// which should not be positive.
+//
+double TestZICM(){
+  int n_funct = 10;
+  int K = 3;
+  int P = 8;
+  int M = 2;
+  arma::field<arma::mat> B_obs(n_funct,1);
+  arma::field<arma::vec> y_obs(n_funct,1);
+  arma::cube nu(K, P, 1, arma::fill::randn);
+  arma::cube Phi = 0.5 * arma::randn(K, P, M);
+  arma::mat chi(n_funct, M, arma::fill::randn);
+  arma::vec alpha = {3, 3, 3};
+  for(int i = 0; i < n_funct; i++){
+    arma::vec t_obs =  arma::regspace(0, 20 + (i % 5), 990);
+    splines2::BSpline bspline;
+    bspline = splines2::BSpline(t_obs, P);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+    arma::vec z = BayesFMMM::rdirichlet(alpha);
+    arma::mat W = nu.slice(0).t();
+    for(int m = 0; m < M; m++){
+      W = W + chi(i,m) * Phi.slice(m).t();
+    }
+    y_obs(i,0) = B_obs(i,0) * W * z + 0.5 * arma::randn(t_obs.n_elem);
+  }
+  BayesFMMM::RaggedObs obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+  arma::vec pi = {0.5, 0.3, 0.2};
+  double alpha_3 = 4;
+  double sigma = 0.25;
+  arma::cube Z(n_funct, K, 1);
+  Z.slice(0).fill(1.0 / K);
+  BayesFMMM::updateZICM(obs, Phi, nu.slice(0), chi, pi, alpha_3, sigma, 0, 1,
+                        100, Z);
+
+  double max_diff = -arma::datum::inf;
+  for(int i = 0; i < n_funct; i++){
+    arma::mat W = nu.slice(0).t();
+    for(int m = 0; m < M; m++){
+      W = W + chi(i,m) * Phi.slice(m).t();
+    }
+    arma::mat X = B_obs(i,0) * W;
+    auto lpdf = [&](const arma::vec& z){
+      return -arma::accu(arma::square(y_obs(i,0) - X * z)) / (2 * sigma) +
+        arma::dot((alpha_3 * pi) - 1, arma::log(z));
+    };
+    double lpdf_icm = lpdf(Z.slice(0).row(i).t());
+    for(int l = 0; l < 1000; l++){
+      arma::vec z = BayesFMMM::projectSimplex(BayesFMMM::rdirichlet(alpha),
+                                              1e-4);
+      max_diff = std::max(max_diff, lpdf(z) - lpdf_icm);
+    }
+  }
+  return max_diff;
+}
+
+// Checks that the ICM update of alpha_3 is a stationary point of its
+// conditional log posterior. Returns the central finite difference of the
+// log posterior at the update and the largest improvement found on a grid
+// around it.
+//
+arma::vec TestAlpha3ICM(){
+  int n_funct = 50;
+  arma::vec pi = {0.5, 0.3, 0.2};
+  arma::mat Z(n_funct, 3);
+  for(int i = 0; i < n_funct; i++){
+    Z.row(i) = BayesFMMM::rdirichlet(5 * pi).t();
+  }
+  double b = 1;
+  arma::vec alpha_3 = {1};
+  BayesFMMM::updateAlpha3ICM(pi, b, Z, 0, 1, alpha_3);
+
+  double ph = 1;
+  auto lpdf = [&](double x){
+    return BayesFMMM::lpdf_alpha3(pi, b, Z, x, ph, 1);
+  };
+  double h = 1e-4 * alpha_3(0);
+  arma::vec mod = arma::zeros(2);
+  mod(0) = std::abs((lpdf(alpha_3(0) + h) - lpdf(alpha_3(0) - h)) / (2 * h));
+  mod(1) = -arma::datum::inf;
+  for(int l = 1; l < 100; l++){
+    mod(1) = std::max(mod(1), lpdf(0.1 * l) - lpdf(alpha_3(0)));
+  }
+  return mod;
+}
+
+context("Unit tests for iterated conditional modes") {
+  test_that("ICM update of nu"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestNuICM();
+    expect_true(x < 1e-6);
+  }
+
+  test_that("Projection onto the simplex"){
+    arma::vec x = TestProjectSimplex();
+    expect_true(x(0) >= 0);
+    expect_true(x(1) < 1e-10);
+    expect_true(x(2) < 1e-10);
+  }
+
+  test_that("ICM update of Z maximizes the conditional posterior"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestZICM();
+    expect_true(x < 1e-6);
+  }
+
+  test_that("ICM update of alpha_3 maximizes the conditional posterior"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestAlpha3ICM();
+    expect_true(x(0) < 1e-3);
+    expect_true(x(1) < 1e-8);
+  }
+
+}
@@ -0,0 +1,99 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Compares the log likelihood computed from the cached covariate adjusted
+// coefficients with calcLikelihoodCovariateAdj, and checks that the cache is
+// still exact after nu, eta, Phi and xi are updated
+//
+arma::vec TestCovariateEffects(){
+  int n_funct = 20;
+  int K = 3;
+  int P = 8;
+  int M = 2;
+  int D = 2;
+  arma::field<arma::mat> B_obs(n_funct,1);
+  arma::field<arma::vec> y_obs(n_funct,1);
+  for(int i = 0; i < n_funct; i++){
+    arma::vec t_obs =  arma::regspace(0, 20 + (i % 5), 990);
+    splines2::BSpline bspline;
+    bspline = splines2::BSpline(t_obs, P);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+    y_obs(i,0) = arma::randn(B_obs(i,0).n_rows);
+  }
+  BayesFMMM::RaggedObs obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+
+  arma::mat X = arma::randn(n_funct, D);
+  arma::cube nu(K, P, 2, arma::fill::randn);
+  arma::field<arma::cube> eta(2,1);
+  arma::field<arma::cube> Phi(2,1);
+  arma::field<arma::cube> xi(2,K);
+  arma::field<arma::cube> gamma_xi(2,K);
+  for(int s = 0; s < 2; s++){
+    eta(s,0) = 0.5 * arma::randn(P, D, K);
+    Phi(s,0) = 0.5 * arma::randn(K, P, M);
+    for(int k = 0; k < K; k++){
+      xi(s,k) = 0.1 * arma::randn(P, D, M);
+      gamma_xi(s,k) = arma::ones(P, D, M);
+    }
+  }
+  arma::cube Z(n_funct, K, 2);
+  arma::cube chi(n_funct, M, 2, arma::fill::randn);
+  arma::vec alpha = {3, 3, 3};
+  for(int i = 0; i < n_funct; i++){
+    Z.slice(0).row(i) = BayesFMMM::rdirichlet(alpha).t();
+  }
+  Z.slice(1) = Z.slice(0);
+  double sigma = 0.5;
+
+  BayesFMMM::CovariateEffects cov;
+  BayesFMMM::updateCovariateEffects(nu.slice(0), eta(0,0), Phi(0,0), xi, 0, X, cov);
+
+  arma::vec mod = arma::zeros(2);
+  mod(0) = std::abs(BayesFMMM::calcLikelihoodCovariateAdj(obs, cov, Z.slice(0),
+                                                          chi.slice(0), sigma) -
+    BayesFMMM::calcLikelihoodCovariateAdj(y_obs, B_obs, nu.slice(0), eta(0,0),
+                                          Phi(0,0), xi, Z.slice(0), chi.slice(0),
+                                          0, X, sigma));
+
+  // update parameters while keeping the cache up to date
+  arma::mat P_mat = arma::eye(P, P);
+  arma::vec b_1(P);
+  arma::mat B_1(P, P);
+  arma::cube gamma = arma::ones(K, P, M);
+  arma::mat tilde_tau = arma::ones(K, M);
+  arma::cube tilde_tau_xi = arma::ones(K, M, D);
+  arma::mat tau_eta = arma::ones(K, D);
+  arma::vec tau = arma::ones(K);
+  BayesFMMM::updateNuCovariateAdj(obs, cov, tau, Z.slice(0), chi.slice(0), sigma,
+                                  0, 2, P_mat, b_1, B_1, nu);
+  BayesFMMM::updateEta(obs, cov, tau_eta, Z.slice(0), chi.slice(0), sigma, 0, 2,
+                       P_mat, X, b_1, B_1, eta);
+  BayesFMMM::updatePhiCovariateAdj(obs, cov, gamma, tilde_tau, Z.slice(0),
+                                   chi.slice(0), sigma, 0, 2, b_1, B_1, Phi);
+  BayesFMMM::updateXiCovariateAdj(obs, cov, gamma_xi, tilde_tau_xi, Z.slice(0),
+                                  chi.slice(0), sigma, X, 0, 2, b_1, B_1, xi);
+
+  BayesFMMM::CovariateEffects cov_new;
+  BayesFMMM::updateCovariateEffects(nu.slice(0), eta(0,0), Phi(0,0), xi, 0, X,
+                                    cov_new);
+  mod(1) = arma::abs(cov.nu - cov_new.nu).max();
+  for(int i = 0; i < n_funct; i++){
+    mod(1) = std::max(mod(1), arma::abs(cov.Phi(i,0) - cov_new.Phi(i,0)).max());
+  }
+  return mod;
+}
+
+context("Unit tests for cached covariate effects") {
+  test_that("Cached covariate adjusted likelihood and updates"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestCovariateEffects();
+    expect_true(x(0) < 1e-6);
+    expect_true(x(1) < 1e-10);
+  }
+
+}
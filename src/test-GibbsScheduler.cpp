@@ -0,0 +1,200 @@
+#include <RcppArmadillo.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <testthat.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <BayesFMMM.h>
+
+// Builds the dependency graph of the untempered Gibbs sweep of the mixed
+// membership model and checks that every block is run after the blocks it
+// depends on. Returns the number of violations (-1 if the waves are wrong).
+//
+int TestGibbsScheduleOrder(){
+  BayesFMMM::GibbsSchedule sweep;
+  std::vector<int> done(11, 0);
+  std::vector<int> violations(11, 0);
+  std::vector<std::vector<int> > deps = {{}, {0}, {1}, {0}, {3}, {4}, {4},
+                                         {3}, {7}, {7}, {9}};
+  std::vector<bool> uses_r = {true, false, false, true, false, false, false,
+                              true, false, true, true};
+  for(int j = 0; j < 11; j++){
+    BayesFMMM::addGibbsBlock(deps[j], uses_r[j], [&, j](std::mt19937_64& rng){
+      for(int d = 0; d < deps[j].size(); d++){
+        if(done[deps[j][d]] == 0){
+          violations[j] = 1;
+        }
+      }
+      done[j] = 1;
+    }, sweep);
+  }
+  std::vector<int> wave_size = {1, 2, 3, 4, 1};
+  if(sweep.waves.size() != wave_size.size()){
+    return -1;
+  }
+  for(int w = 0; w < wave_size.size(); w++){
+    if(sweep.waves[w].size() != wave_size[w]){
+      return -1;
+    }
+  }
+  for(int i = 0; i < 3; i++){
+    std::fill(done.begin(), done.end(), 0);
+    BayesFMMM::runGibbsSchedule(sweep);
+  }
+  int n_violations = 0;
+  for(int j = 0; j < 11; j++){
+    n_violations = n_violations + violations[j] + (1 - done[j]);
+  }
+  return n_violations;
+}
+
+// Runs a wave containing a block that uses R's random number generator and a
+// block that uses its own engine, where the engine block waits (up to a
+// second) for the other block to check whether it is running. Returns whether
+// the blocks ran concurrently, the number of threads of a parallel region
+// opened by the block using R's generator, and the number of threads
+// available.
+//
+arma::vec TestGibbsScheduleOverlap(){
+  BayesFMMM::GibbsSchedule sweep;
+  std::atomic<bool> engine_started(false);
+  std::atomic<bool> engine_done(false);
+  std::atomic<bool> checked(false);
+  auto wait_for = [](const std::atomic<bool>& flag){
+    std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    while(!flag && (std::chrono::steady_clock::now() - start <
+            std::chrono::seconds(1))){
+    }
+  };
+  arma::vec out = arma::ones(3);
+  BayesFMMM::addGibbsBlock({}, false, [&](std::mt19937_64& rng){
+    engine_started = true;
+    wait_for(checked);
+    engine_done = true;
+  }, sweep);
+  BayesFMMM::addGibbsBlock({}, true, [&](std::mt19937_64& rng){
+    wait_for(engine_started);
+    out(0) = engine_started && !engine_done;
+    checked = true;
+    int n_team = 1;
+    #pragma omp parallel
+    {
+      #pragma omp single
+      {
+#ifdef _OPENMP
+        n_team = omp_get_num_threads();
+#endif
+      }
+    }
+    out(1) = n_team;
+  }, sweep);
+#ifdef _OPENMP
+  out(2) = omp_get_max_threads();
+#endif
+  BayesFMMM::runGibbsSchedule(sweep);
+  return out;
+}
+
+// Draws the prior-side parameters with R's random number generator and with
+// a random number engine using the same kernels, and compares the draws of
+// delta with the conditional means. Returns the largest relative differences.
+//
+arma::vec TestKernelSources(){
+  int K = 2;
+  int P = 8;
+  int M = 3;
+  int n_samp = 20000;
+  arma::cube Phi = arma::randn(K, P, M);
+  arma::cube gamma = arma::ones(K, P, M);
+  arma::mat A = 2 * arma::ones(K, 2);
+  arma::cube delta_r = arma::ones(K, M, 2);
+  arma::cube delta_e = arma::ones(K, M, 2);
+  arma::mat mean_r = arma::zeros(K, M);
+  arma::mat mean_e = arma::zeros(K, M);
+  BayesFMMM::RRng rng_r;
+  std::mt19937_64 rng_e(1);
+  for(int l = 0; l < n_samp; l++){
+    delta_r.slice(0).ones();
+    delta_e.slice(0).ones();
+    BayesFMMM::updateDelta(Phi, gamma, A, 0, 2, rng_r, delta_r);
+    BayesFMMM::updateDelta(Phi, gamma, A, 0, 2, rng_e, delta_e);
+    mean_r = mean_r + delta_r.slice(0) / n_samp;
+    mean_e = mean_e + delta_e.slice(0) / n_samp;
+  }
+  arma::vec diff = arma::zeros(2);
+  diff(0) = arma::abs((mean_r - mean_e) / mean_r).max();
+
+  // the first element of delta given the others is drawn from a gamma
+  // distribution with shape a(k,0) + P * M / 2
+  double param2 = 1;
+  for(int j = 0; j < P; j++){
+    for(int m = 0; m < M; m++){
+      param2 = param2 + 0.5 * Phi(0, j, m) * Phi(0, j, m);
+    }
+  }
+  diff(1) = std::abs(mean_e(0,0) - ((A(0,0) + P * M / 2.0) / param2)) /
+    mean_e(0,0);
+  return diff;
+}
+
+// Compares the mean of draws from the positive truncated normal distribution
+// with its theoretical value
+//
+double TestTruncNormPositive(const double mean,
+                             const double sd){
+  std::mt19937_64 rng(1);
+  int n_samp = 100000;
+  double x_mean = 0;
+  for(int i = 0; i < n_samp; i++){
+    x_mean = x_mean + BayesFMMM::rtruncnormPositive(mean, sd, rng) / n_samp;
+  }
+  double alpha = -mean / sd;
+  double truth = mean + (sd * R::dnorm(alpha, 0, 1, false) /
+                         (1 - R::pnorm(alpha, 0, 1, true, false)));
+  return std::abs(x_mean - truth);
+}
+
+context("Unit tests for the Gibbs sweep scheduler") {
+  test_that("Blocks are run after their dependencies"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    int x = TestGibbsScheduleOrder();
+    expect_true(x == 0);
+  }
+
+  test_that("Blocks using R's generator overlap the engine blocks"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestGibbsScheduleOverlap();
+    if(x(2) > 1){
+      expect_true(x(0) == 1);
+      expect_true(x(1) == x(2) - 1);
+    }else{
+      expect_true(x(0) == 0);
+      expect_true(x(1) == 1);
+    }
+  }
+
+  test_that("Prior-side kernels agree with R's generator and an engine"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestKernelSources();
+    expect_true(x(0) < 0.05);
+    expect_true(x(1) < 0.05);
+  }
+
+  test_that("Positive truncated normal sampler"){
+    double x = TestTruncNormPositive(1, 1);
+    expect_true(x < 0.01);
+    x = TestTruncNormPositive(-3, 0.5);
+    expect_true(x < 0.01);
+  }
+
+}
@@ -0,0 +1,86 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Compares the DIC computed from the single pass over the pointwise
+// log-likelihood with the DIC computed from calcLikelihood and calcDIC2, and
+// checks that the WAIC and PSIS-LOO estimates of the effective number of
+// parameters agree
+//
+arma::vec TestInformationCriteria(){
+  int n_samp = 200;
+  arma::field<arma::mat> B_obs(20,1);
+  arma::field<arma::vec> y_obs(20,1);
+  for(int i = 0; i < 20; i++){
+    arma::vec t_obs =  arma::regspace(0, 20 + (i % 5), 990);
+    splines2::BSpline bspline;
+    bspline = splines2::BSpline(t_obs, 8);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+    y_obs(i,0) = arma::randn(B_obs(i,0).n_rows);
+  }
+
+  // Make posterior samples
+  arma::cube nu(3, 8, n_samp);
+  arma::field<arma::cube> Phi(n_samp, 1);
+  arma::cube Z(20, 3, n_samp);
+  arma::cube chi(20, 2, n_samp, arma::fill::randn);
+  arma::vec sigma = 1 + 0.1 * arma::randu(n_samp);
+  arma::vec alpha = {3, 3, 3};
+  for(int s = 0; s < n_samp; s++){
+    nu.slice(s) = 0.1 * arma::randn(3, 8);
+    Phi(s,0) = 0.05 * arma::randn(3, 8, 2);
+    for(int i = 0; i < 20; i++){
+      Z.slice(s).row(i) = BayesFMMM::rdirichlet(alpha).t();
+    }
+  }
+  int burnin = 40;
+
+  BayesFMMM::RaggedObs obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+  Rcpp::List ic = BayesFMMM::calcInformationCriteria(obs, nu, Phi, Z, chi,
+                                                     sigma, burnin);
+
+  double expected_log_f = 0;
+  for(int s = burnin; s < n_samp; s++){
+    expected_log_f = expected_log_f + BayesFMMM::calcLikelihood(y_obs, B_obs,
+                                                                nu.slice(s), Phi(s,0),
+                                                                Z.slice(s), chi.slice(s),
+                                                                sigma(s));
+  }
+  expected_log_f = expected_log_f / (n_samp - burnin);
+  double f_hat = 0;
+  double f_hat_ij = 0;
+  for(int i = 0; i < 20; i++){
+    for(int j = 0; j < y_obs(i,0).n_elem; j++){
+      f_hat_ij = 0;
+      for(int s = burnin; s < n_samp; s++){
+        f_hat_ij = f_hat_ij + BayesFMMM::calcDIC2(y_obs(i,0), B_obs(i,0), nu.slice(s),
+                                                  Phi(s,0), Z.slice(s), chi.slice(s),
+                                                  i, j, sigma(s));
+      }
+      f_hat = f_hat + std::log(f_hat_ij / (n_samp - burnin));
+    }
+  }
+  double DIC = (2 * f_hat) - (4 * expected_log_f);
+
+  double DIC_ic = ic["DIC"];
+  double p_waic = ic["p_waic"];
+  double p_loo = ic["p_loo"];
+  arma::vec mod = arma::zeros(2);
+  mod(0) = std::abs(DIC_ic - DIC);
+  mod(1) = std::abs(p_waic - p_loo) / p_waic;
+  return mod;
+}
+
+context("Unit tests for information criteria") {
+  test_that("Single pass DIC, WAIC and PSIS-LOO"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestInformationCriteria();
+    expect_true(x(0) < 1e-6);
+    expect_true(x(1) < 0.1);
+  }
+
+}
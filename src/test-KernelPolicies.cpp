@@ -0,0 +1,292 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Compares the mean coefficients computed with the sizes known at compile
+// time, with the sizes known at run time, and with calcMeanCoef
+//
+double TestMeanCoefFixed(const int K,
+                         const int M){
+  int n_funct = 5;
+  int P = 8;
+  arma::mat nu(K, P, arma::fill::randn);
+  arma::cube Phi(K, P, M, arma::fill::randn);
+  arma::mat Z(n_funct, K, arma::fill::randu);
+  arma::mat chi(n_funct, M, arma::fill::randn);
+  BayesFMMM::SharedCoefs coefs = {nu, Phi};
+
+  arma::vec coef_fixed;
+  arma::vec coef_dynamic;
+  arma::vec coef;
+  double diff = 0;
+  for(int i = 0; i < n_funct; i++){
+    if((K == 3) && (M == 2)){
+      coefs.meanCoef<3, 2>(i, Z, chi, coef_fixed);
+    }else{
+      coefs.meanCoef<0, 0>(i, Z, chi, coef_fixed);
+    }
+    coefs.meanCoef<0, 0>(i, Z, chi, coef_dynamic);
+    BayesFMMM::calcMeanCoef(nu, Phi, Z.row(i), chi.row(i), coef);
+    diff = std::max(diff, arma::abs(coef_fixed - coef).max());
+    diff = std::max(diff, arma::abs(coef_dynamic - coef).max());
+  }
+  return diff;
+}
+
+// Compares the log-likelihood of the multivariate model computed by the
+// unified kernel with the likelihood of each observed vector
+//
+double TestLikelihoodMVKernel(){
+  int n_funct = 20;
+  int K = 3;
+  int P = 5;
+  int M = 2;
+  arma::mat nu(K, P, arma::fill::randn);
+  arma::cube Phi(K, P, M, arma::fill::randn);
+  arma::mat Z(n_funct, K);
+  arma::vec alpha = {1, 1, 1};
+  for(int i = 0; i < n_funct; i++){
+    Z.row(i) = BayesFMMM::rdirichlet(alpha).t();
+  }
+  arma::mat chi(n_funct, M, arma::fill::randn);
+  arma::mat y_obs(n_funct, P, arma::fill::randn);
+  double sigma = 0.7;
+
+  double log_lik = 0;
+  for(int i = 0; i < n_funct; i++){
+    log_lik = log_lik + std::log(BayesFMMM::calcDIC2MV(y_obs.row(i), nu, Phi,
+                                                       Z, chi, i, sigma));
+  }
+  double log_lik_kernel = BayesFMMM::calcLikelihoodMV(y_obs, nu, Phi, Z, chi,
+                                                      sigma);
+  return std::abs(log_lik - log_lik_kernel) / std::abs(log_lik);
+}
+
+// Compares the log-likelihood and the chi, nu and Z (HMC) draws computed from
+// single precision observations with those computed from double precision
+// observations (returns the relative error of the log-likelihood and the
+// largest differences between the chi, nu and Z draws)
+//
+arma::vec TestSinglePrecisionKernels(){
+  int n_funct = 30;
+  int K = 3;
+  int P = 8;
+  int M = 2;
+  arma::field<arma::vec> y_obs(n_funct,1);
+  arma::field<arma::mat> B_obs(n_funct,1);
+  arma::mat nu(K, P, arma::fill::randn);
+  arma::cube Phi = 0.5 * arma::randn(K, P, M);
+  arma::mat Z(n_funct, K);
+  arma::vec alpha = {1, 1, 1};
+  arma::mat chi(n_funct, M, arma::fill::randn);
+  arma::vec coef;
+  for(int i = 0; i < n_funct; i++){
+    Z.row(i) = BayesFMMM::rdirichlet(alpha).t();
+    arma::vec t_obs = arma::regspace(0, 10 + (i % 5), 990);
+    splines2::BSpline bspline;
+    bspline = splines2::BSpline(t_obs, P);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+    BayesFMMM::calcMeanCoef(nu, Phi, Z.row(i), chi.row(i), coef);
+    y_obs(i,0) = B_obs(i,0) * coef + 0.1 * arma::randn(t_obs.n_elem);
+  }
+  BayesFMMM::RaggedObs obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+  BayesFMMM::RaggedObsF obs_f = BayesFMMM::makeRaggedObsF(obs);
+  BayesFMMM::SubjectScheduler sched = BayesFMMM::makeSubjectScheduler(obs);
+
+  arma::vec diff = arma::zeros(4);
+  double log_lik = BayesFMMM::calcLikelihood(obs, nu, Phi, Z, chi, 0.01,
+                                             sched);
+  double log_lik_f = BayesFMMM::calcLikelihood(obs_f, nu, Phi, Z, chi, 0.01,
+                                               sched);
+  diff(0) = std::abs(log_lik - log_lik_f) / std::abs(log_lik);
+
+  arma::cube chi_double(n_funct, M, 2);
+  chi_double.slice(0) = chi;
+  arma::cube chi_single = chi_double;
+  Rcpp::Environment base_env("package:base");
+  Rcpp::Function set_seed_r = base_env["set.seed"];
+  set_seed_r(2);
+  BayesFMMM::updateChi(obs, Phi, nu, Z, 0.01, 0, 2, sched, chi_double);
+  set_seed_r(2);
+  BayesFMMM::updateChi(obs_f, Phi, nu, Z, 0.01, 0, 2, sched, chi_single);
+  diff(1) = arma::abs(chi_double.slice(0) - chi_single.slice(0)).max();
+
+  arma::vec tau = arma::ones(K);
+  arma::mat P_mat = arma::eye(P, P);
+  arma::vec b_1(P);
+  arma::mat B_1(P, P);
+  arma::mat nu_mean(K, P);
+  arma::cube nu_double(K, P, 2);
+  nu_double.slice(0) = nu;
+  arma::cube nu_single = nu_double;
+  BayesFMMM::Workspace ws = BayesFMMM::makeWorkspace();
+  set_seed_r(3);
+  BayesFMMM::updateNu(obs, tau, Phi, Z, chi, 0.01, 0, 2, P_mat, ws, b_1, B_1,
+                      nu_double, nu_mean);
+  set_seed_r(3);
+  BayesFMMM::updateNu(obs_f, tau, Phi, Z, chi, 0.01, 0, 2, P_mat, ws, b_1, B_1,
+                      nu_single, nu_mean);
+  diff(2) = arma::abs(nu_double.slice(0) - nu_single.slice(0)).max();
+
+  arma::vec pi = arma::ones(K) / K;
+  arma::vec step_Z = 0.01 * arma::ones(n_funct);
+  arma::vec accept_prob(n_funct);
+  arma::cube Z_double(n_funct, K, 2);
+  Z_double.slice(0) = Z;
+  arma::cube Z_single = Z_double;
+  set_seed_r(4);
+  BayesFMMM::updateZHMC_PM(obs, Phi, nu, chi, pi, 0.01, 0, 2, 1, step_Z, 5,
+                           sched, accept_prob, Z_double);
+  set_seed_r(4);
+  BayesFMMM::updateZHMC_PM(obs_f, Phi, nu, chi, pi, 0.01, 0, 2, 1, step_Z, 5,
+                           sched, accept_prob, Z_single);
+  diff(3) = arma::abs(Z_double.slice(0) - Z_single.slice(0)).max();
+  return diff;
+}
+
+// Compares the Gram matrices and cross products accumulated by each data
+// model with those computed from the basis functions of each function
+// (returns the largest difference)
+//
+double TestAddGram(){
+  int n_funct = 6;
+  int P = 5;
+  arma::field<arma::vec> y_obs(n_funct,1);
+  arma::field<arma::mat> B_obs(n_funct,1);
+  arma::field<arma::mat> B_mv(n_funct,1);
+  arma::mat y_mv(n_funct, P, arma::fill::randn);
+  for(int i = 0; i < n_funct; i++){
+    B_obs(i,0) = arma::randu(3 + i, P);
+    y_obs(i,0) = arma::randn(3 + i);
+    B_mv(i,0) = arma::eye(P, P);
+  }
+  arma::field<arma::vec> y_mv_field(n_funct,1);
+  for(int i = 0; i < n_funct; i++){
+    y_mv_field(i,0) = y_mv.row(i).t();
+  }
+  BayesFMMM::RaggedObs obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+  BayesFMMM::RaggedObsF obs_f = BayesFMMM::makeRaggedObsF(obs);
+  BayesFMMM::FieldData field = {y_obs, B_obs};
+  BayesFMMM::RaggedData ragged = {obs};
+  BayesFMMM::RaggedDataF ragged_f = {obs_f};
+  BayesFMMM::MVData mv = {y_mv};
+  BayesFMMM::FieldData mv_field = {y_mv_field, B_mv};
+
+  arma::vec coef(P, arma::fill::randn);
+  arma::mat G_field = arma::zeros(P, P);
+  arma::mat G_ragged = arma::zeros(P, P);
+  arma::mat G_ragged_f = arma::zeros(P, P);
+  arma::mat G_mv = arma::zeros(P, P);
+  arma::mat G_mv_field = arma::zeros(P, P);
+  arma::mat G = arma::zeros(P, P);
+  arma::vec g_field = arma::zeros(P);
+  arma::vec g_ragged = arma::zeros(P);
+  arma::vec g_ragged_f = arma::zeros(P);
+  arma::vec g_mv = arma::zeros(P);
+  arma::vec g_mv_field = arma::zeros(P);
+  arma::vec g = arma::zeros(P);
+  for(int i = 0; i < n_funct; i++){
+    field.addGram(i, coef, 0.3, 0.6, G_field, g_field);
+    ragged.addGram(i, coef, 0.3, 0.6, G_ragged, g_ragged);
+    ragged_f.addGram(i, coef, 0.3, 0.6, G_ragged_f, g_ragged_f);
+    mv.addGram(i, coef, 0.3, 0.6, G_mv, g_mv);
+    mv_field.addGram(i, coef, 0.3, 0.6, G_mv_field, g_mv_field);
+    G = G + 0.3 * (B_obs(i,0).t() * B_obs(i,0));
+    g = g + 0.6 * (B_obs(i,0).t() * (y_obs(i,0) - B_obs(i,0) * coef));
+  }
+  double diff = 0;
+  diff = std::max(diff, arma::abs(arma::trimatu(G_field - G)).max());
+  diff = std::max(diff, arma::abs(arma::trimatu(G_ragged - G)).max());
+  diff = std::max(diff, arma::abs(g_field - g).max());
+  diff = std::max(diff, arma::abs(g_ragged - g).max());
+  diff = std::max(diff, 1e-4 * arma::abs(arma::trimatu(G_ragged_f - G)).max());
+  diff = std::max(diff, 1e-4 * arma::abs(g_ragged_f - g).max());
+  diff = std::max(diff, arma::abs(arma::trimatu(G_mv - G_mv_field)).max());
+  diff = std::max(diff, arma::abs(g_mv - g_mv_field).max());
+  return diff;
+}
+
+// Compares the covariance and mean given by drawGaussianCanonical with the
+// inverse of the precision, and the mean of its draws with the mean (returns
+// the largest difference of the covariance and mean, and of the average
+// draw)
+//
+arma::vec TestDrawGaussianCanonical(){
+  int P = 6;
+  int n_draws = 20000;
+  arma::mat A(P, P, arma::fill::randn);
+  arma::mat Q = A * A.t() + P * arma::eye(P, P);
+  arma::vec b(P, arma::fill::randn);
+  arma::mat U(P, P);
+  arma::vec mean(P);
+  arma::vec x(P);
+  arma::mat Q_1 = Q;
+  BayesFMMM::ConditionalMode mode;
+  BayesFMMM::drawGaussianCanonical(Q_1, b, mode, U, mean, x);
+
+  arma::vec diff = arma::zeros(2);
+  diff(0) = arma::abs(Q_1 - arma::inv_sympd(Q)).max();
+  diff(0) = std::max(diff(0), arma::abs(mean - arma::solve(Q, b)).max());
+  diff(0) = std::max(diff(0), arma::abs(x - mean).max());
+
+  BayesFMMM::RRng rng;
+  arma::vec avg = arma::zeros(P);
+  for(int r = 0; r < n_draws; r++){
+    Q_1 = Q;
+    BayesFMMM::drawGaussianCanonical(Q_1, b, rng, U, mean, x);
+    avg = avg + x / n_draws;
+  }
+  diff(1) = arma::abs(avg - mean).max();
+  return diff;
+}
+
+context("Unit tests for the kernel policies") {
+  test_that("Mean coefficients with sizes known at compile time"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestMeanCoefFixed(3, 2);
+    expect_true(x < 1e-10);
+    x = TestMeanCoefFixed(6, 4);
+    expect_true(x < 1e-10);
+  }
+
+  test_that("Log-likelihood of the multivariate model"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestLikelihoodMVKernel();
+    expect_true(x < 1e-10);
+  }
+
+  test_that("Single precision observations"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestSinglePrecisionKernels();
+    expect_true(x(0) < 1e-4);
+    expect_true(x(1) < 1e-3);
+    expect_true(x(2) < 1e-3);
+    expect_true(x(3) < 1e-3);
+  }
+
+  test_that("Gram matrices accumulated by the data models"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestAddGram();
+    expect_true(x < 1e-8);
+  }
+
+  test_that("Gaussian draws from the canonical parameters"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestDrawGaussianCanonical();
+    expect_true(x(0) < 1e-10);
+    expect_true(x(1) < 0.02);
+  }
+
+}
@@ -0,0 +1,126 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Simulates functions from a partial membership model with the given
+// parameters
+//
+BayesFMMM::RaggedObs SimulateScoringObs(const arma::mat& nu,
+                                        const arma::cube& Phi,
+                                        const arma::mat& Z,
+                                        const arma::mat& chi,
+                                        const double sigma){
+  int n_funct = Z.n_rows;
+  arma::field<arma::mat> B_obs(n_funct,1);
+  arma::field<arma::vec> y_obs(n_funct,1);
+  arma::vec coef;
+  for(int i = 0; i < n_funct; i++){
+    arma::vec t_obs =  arma::regspace(0, 10 + (i % 3), 990);
+    splines2::BSpline bspline;
+    bspline = splines2::BSpline(t_obs, nu.n_cols);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+    BayesFMMM::calcMeanCoef(nu, Phi, Z.row(i), chi.row(i), coef);
+    y_obs(i,0) = B_obs(i,0) * coef + std::sqrt(sigma) * arma::randn(t_obs.n_elem);
+  }
+  return BayesFMMM::makeRaggedObs(y_obs, B_obs);
+}
+
+// Compares the log-pdf of z_i computed from the stacked coefficients with
+// lpdf_zTempered
+//
+double TestScoringLpdf(){
+  int n_funct = 5;
+  int K = 3;
+  int P = 8;
+  int M = 2;
+  arma::cube nu(K, P, 2, arma::fill::randn);
+  arma::field<arma::cube> Phi(2,1);
+  Phi(0,0) = 0.5 * arma::randn(K, P, M);
+  Phi(1,0) = 0.5 * arma::randn(K, P, M);
+  arma::mat Z(n_funct, K);
+  arma::vec alpha = {2, 2, 2};
+  for(int i = 0; i < n_funct; i++){
+    Z.row(i) = BayesFMMM::rdirichlet(alpha).t();
+  }
+  arma::mat chi(n_funct, M, arma::fill::randn);
+  arma::vec pi = {0.2, 0.3, 0.5};
+  double sigma = 0.5;
+  BayesFMMM::RaggedObs obs = SimulateScoringObs(nu.slice(1), Phi(1,0), Z, chi,
+                                                sigma);
+
+  arma::mat C = BayesFMMM::stackScoringCoef(nu, Phi, 1);
+  double max_diff = 0;
+  for(int i = 0; i < n_funct; i++){
+    double yty = arma::dot(obs.y_i(i), obs.y_i(i));
+    arma::vec Cty = C.t() * (obs.B_i(i) * obs.y_i(i));
+    arma::mat Q = C.t() * obs.B_i(i) * obs.B_i(i).t() * C;
+    double lpdf = BayesFMMM::lpdf_zScoring(Z.row(i).t(), chi.row(i).t(), yty,
+                                           Cty, Q, pi, 10, sigma);
+    double lpdf_true = BayesFMMM::lpdf_zTempered(1.0, obs, i, Phi(1,0),
+                                                 nu.slice(1), chi.row(i), pi,
+                                                 Z.row(i), 10, sigma);
+    max_diff = std::max(max_diff, std::abs(lpdf - lpdf_true));
+  }
+  return max_diff;
+}
+
+// Scores simulated functions using the true parameters as the posterior draws
+// and returns the largest error in the posterior mean of Z
+//
+double TestScoringRecovery(){
+  int n_funct = 20;
+  int K = 2;
+  int P = 8;
+  int M = 1;
+  int n_samp = 100;
+  arma::mat nu_true(K, P);
+  nu_true.row(0) = 3 * arma::linspace(-1, 1, P).t();
+  nu_true.row(1) = -3 * arma::linspace(-1, 1, P).t();
+  arma::cube Phi_true = 0.2 * arma::randn(K, P, M);
+  arma::mat Z(n_funct, K);
+  Z.col(0) = arma::linspace(0.05, 0.95, n_funct);
+  Z.col(1) = 1 - Z.col(0);
+  arma::mat chi(n_funct, M, arma::fill::randn);
+  double sigma = 0.01;
+  BayesFMMM::RaggedObs obs = SimulateScoringObs(nu_true, Phi_true, Z, chi,
+                                                sigma);
+
+  arma::cube nu(K, P, n_samp);
+  arma::field<arma::cube> Phi(n_samp,1);
+  arma::mat pi = 0.5 * arma::ones(K, n_samp);
+  arma::vec alpha_3 = arma::ones(n_samp);
+  arma::vec sigma_samp = sigma * arma::ones(n_samp);
+  for(int s = 0; s < n_samp; s++){
+    nu.slice(s) = nu_true;
+    Phi(s,0) = Phi_true;
+  }
+
+  arma::cube Z_samp;
+  arma::cube chi_samp;
+  arma::vec acceptance;
+  BayesFMMM::scoreMembership(obs, nu, Phi, pi, alpha_3, sigma_samp, 20, 2, 200,
+                             100, Z_samp, chi_samp, acceptance);
+  arma::mat Z_mean = arma::mean(Z_samp, 2).eval().slice(0);
+  return arma::abs(Z_mean - Z).max();
+}
+
+context("Unit tests for membership scoring") {
+  test_that("Log-pdf of z_i from stacked coefficients"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestScoringLpdf();
+    expect_true(x < 1e-6);
+  }
+
+  test_that("Scoring recovers memberships of new functions"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestScoringRecovery();
+    expect_true(x < 0.05);
+  }
+
+}
@@ -0,0 +1,185 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Simulates functions with more observed time points than basis functions
+// (and a few functions with fewer)
+//
+void SimulateStoreData(const int n_funct,
+                       const arma::vec& internal_knots,
+                       const arma::vec& boundary_knots,
+                       arma::field<arma::vec>& y_obs,
+                       arma::field<arma::vec>& t_obs,
+                       arma::field<arma::mat>& B_obs){
+  y_obs.set_size(n_funct, 1);
+  t_obs.set_size(n_funct, 1);
+  B_obs.set_size(n_funct, 1);
+  for(int i = 0; i < n_funct; i++){
+    if(i % 7 == 0){
+      t_obs(i,0) = arma::regspace(100, 200, 900);
+    }else{
+      t_obs(i,0) = arma::regspace(0, 5 + (i % 11), 990);
+    }
+    splines2::BSpline bspline(t_obs(i,0), internal_knots, 3, boundary_knots);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+    y_obs(i,0) = arma::sin(t_obs(i,0) / 200) + 0.3 * arma::randn(t_obs(i,0).n_elem);
+  }
+}
+
+// Compares the residual sums of squares, log-likelihood, sigma and the nu
+// and Phi draws (same seed) using the observations and their sufficient
+// statistics. Returns the largest relative differences and the number of
+// values stored after compression.
+//
+arma::vec TestCompressedObs(){
+  int n_funct = 30;
+  int K = 3;
+  int M = 2;
+  arma::vec internal_knots = {250, 500, 750};
+  arma::vec boundary_knots = {0, 1000};
+  int P = 8;
+  arma::field<arma::vec> y_obs;
+  arma::field<arma::vec> t_obs;
+  arma::field<arma::mat> B_obs;
+  SimulateStoreData(n_funct, internal_knots, boundary_knots, y_obs, t_obs,
+                    B_obs);
+  BayesFMMM::RaggedObs obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+  BayesFMMM::RaggedObs obs_c = BayesFMMM::compressRaggedObs(obs);
+
+  arma::mat Z(n_funct, K);
+  arma::vec alpha = {1, 1, 1};
+  for(int i = 0; i < n_funct; i++){
+    Z.row(i) = BayesFMMM::rdirichlet(alpha).t();
+  }
+  arma::mat nu(K, P, arma::fill::randn);
+  arma::cube Phi = 0.5 * arma::randn(K, P, M);
+  arma::mat chi(n_funct, M, arma::fill::randn);
+
+  arma::vec diff = arma::zeros(5);
+  arma::vec coef;
+  for(int i = 0; i < n_funct; i++){
+    BayesFMMM::calcMeanCoef(nu, Phi, Z.row(i), chi.row(i), coef);
+    double rss = BayesFMMM::calcRSS(obs, i, coef);
+    diff(0) = std::max(diff(0), std::abs(BayesFMMM::calcRSS(obs_c, i, coef) - rss) / rss);
+  }
+  double ll = BayesFMMM::calcLikelihood(obs, nu, Phi, Z, chi, 0.5);
+  double ll_c = BayesFMMM::calcLikelihood(obs_c, nu, Phi, Z, chi, 0.5);
+  diff(1) = std::abs(ll - ll_c) / std::abs(ll);
+
+  Rcpp::Environment base_env("package:base");
+  Rcpp::Function set_seed_r = base_env["set.seed"];
+  arma::vec tau = arma::ones(K);
+  arma::mat P_mat = arma::eye(P, P);
+  arma::cube gamma = arma::ones(K, P, M);
+  arma::mat tilde_tau = arma::ones(K, M);
+  arma::vec b_1(P);
+  arma::mat B_1(P, P);
+  arma::mat nu_mean(K, P);
+  arma::cube chi_c(n_funct, M, 2);
+  chi_c.slice(0) = chi;
+  arma::cube nu_1(K, P, 2);
+  nu_1.slice(0) = nu;
+  arma::cube nu_2 = nu_1;
+  arma::field<arma::cube> Phi_1(2,1);
+  Phi_1(0,0) = Phi;
+  Phi_1(1,0) = Phi;
+  arma::field<arma::cube> Phi_2 = Phi_1;
+  BayesFMMM::Workspace ws = BayesFMMM::makeWorkspace();
+  set_seed_r(2);
+  BayesFMMM::updatePhi(obs, nu_1.slice(0), gamma, tilde_tau, Z, chi_c.slice(0),
+                       1, 0, 2, ws, b_1, B_1, Phi_1);
+  BayesFMMM::updateNu(obs, tau, Phi_1(0,0), Z, chi_c.slice(0), 1, 0, 2, P_mat,
+                      ws, b_1, B_1, nu_1, nu_mean);
+  set_seed_r(2);
+  BayesFMMM::updatePhi(obs_c, nu_2.slice(0), gamma, tilde_tau, Z, chi_c.slice(0),
+                       1, 0, 2, ws, b_1, B_1, Phi_2);
+  BayesFMMM::updateNu(obs_c, tau, Phi_2(0,0), Z, chi_c.slice(0), 1, 0, 2, P_mat,
+                      ws, b_1, B_1, nu_2, nu_mean);
+  diff(2) = arma::abs(nu_1.slice(1) - nu_2.slice(1)).max();
+  diff(3) = arma::abs(Phi_1(1,0) - Phi_2(1,0)).max();
+  diff(4) = obs_c.y.n_elem;
+  return diff;
+}
+
+// Writes the functions to an observation store in two chunks and compares
+// the records and the streamed sufficient statistics with the functions.
+// Returns the largest differences and the number of functions in the store.
+//
+arma::vec TestObsStoreRoundTrip(){
+  Rcpp::Environment base_env("package:base");
+  Rcpp::Function tempdir_r = base_env["tempdir"];
+  std::string file = Rcpp::as<std::string>(tempdir_r()) + "/obs_store_test.bin";
+  int n_funct = 25;
+  arma::vec internal_knots = {250, 500, 750};
+  arma::vec boundary_knots = {0, 1000};
+  arma::field<arma::vec> y_obs;
+  arma::field<arma::vec> t_obs;
+  arma::field<arma::mat> B_obs;
+  SimulateStoreData(n_funct, internal_knots, boundary_knots, y_obs, t_obs,
+                    B_obs);
+  arma::field<arma::vec> y_1 = y_obs.rows(0, 9);
+  arma::field<arma::vec> t_1 = t_obs.rows(0, 9);
+  arma::field<arma::vec> y_2 = y_obs.rows(10, n_funct - 1);
+  arma::field<arma::vec> t_2 = t_obs.rows(10, n_funct - 1);
+  arma::vec diff = arma::zeros(3);
+  if(!BayesFMMM::writeObsStore(y_1, t_1, file, false) ||
+     !BayesFMMM::writeObsStore(y_2, t_2, file, true)){
+    diff.fill(-1);
+    return diff;
+  }
+
+  BayesFMMM::ObsStore store;
+  BayesFMMM::openObsStore(file, store);
+  arma::vec t_i;
+  arma::vec y_i;
+  for(int i = 0; i < n_funct; i++){
+    if(!BayesFMMM::readObsRecord(store, i, t_i, y_i) ||
+       (t_i.n_elem != t_obs(i,0).n_elem)){
+      diff(0) = 1;
+      continue;
+    }
+    diff(0) = std::max(diff(0), arma::abs(t_i - t_obs(i,0)).max());
+    diff(0) = std::max(diff(0), arma::abs(y_i - y_obs(i,0)).max());
+  }
+
+  BayesFMMM::RaggedObs obs_s = BayesFMMM::makeRaggedObs(store, internal_knots,
+                                                        3, boundary_knots);
+  BayesFMMM::RaggedObs obs_c =
+    BayesFMMM::compressRaggedObs(BayesFMMM::makeRaggedObs(y_obs, B_obs));
+  if((obs_s.y.n_elem != obs_c.y.n_elem) || (obs_s.n_total() != obs_c.n_total())){
+    diff(1) = 1;
+  }else{
+    diff(1) = std::max(arma::abs(obs_s.B_t - obs_c.B_t).max(),
+                       arma::abs(obs_s.rss0 - obs_c.rss0).max());
+  }
+  diff(2) = store.n_funct();
+  return diff;
+}
+
+context("Unit tests for compressed observations and observation stores") {
+  test_that("Compressed observations give the same likelihood and draws"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestCompressedObs();
+    expect_true(x(0) < 1e-8);
+    expect_true(x(1) < 1e-8);
+    expect_true(x(2) < 1e-6);
+    expect_true(x(3) < 1e-6);
+    expect_true(x(4) <= 30 * 8);
+  }
+
+  test_that("Observation stores are written, appended and streamed"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestObsStoreRoundTrip();
+    expect_true(x(0) == 0);
+    expect_true(x(1) >= 0);
+    expect_true(x(1) < 1e-8);
+    expect_true(x(2) == 25);
+  }
+
+}
@@ -908,7 +908,175 @@ arma::cube TestUpdateZTempered_MVCovariateAdjusted(){
   return mod;
 }
 
+// Compares the gradient of the log-pdf of z_i in the additive log-ratio
+// parametrization with central finite differences
+//
+// @name TestGradZSimplex
+double TestGradZSimplex(){
+  int K = 4;
+  arma::mat X(30, K, arma::fill::randn);
+  arma::vec y(30, arma::fill::randn);
+  arma::mat H = X.t() * X;
+  arma::vec g = X.t() * y;
+  double yty = arma::dot(y, y);
+  arma::vec a = {0.5, 1, 2, 3};
+  arma::vec eta = {0.3, -0.5, 1.2};
+  arma::vec z(K);
+  arma::vec grad(K - 1);
+  arma::vec grad_ph(K - 1);
+  BayesFMMM::lpdf_zSimplex(eta, a, H, g, yty, 0.7, z, grad);
+  double h = 1e-6;
+  double max_diff = 0;
+  for(int l = 0; l < (K - 1); l++){
+    arma::vec eta_plus = eta;
+    arma::vec eta_minus = eta;
+    eta_plus(l) = eta_plus(l) + h;
+    eta_minus(l) = eta_minus(l) - h;
+    double fd = (BayesFMMM::lpdf_zSimplex(eta_plus, a, H, g, yty, 0.7, z, grad_ph) -
+      BayesFMMM::lpdf_zSimplex(eta_minus, a, H, g, yty, 0.7, z, grad_ph)) / (2 * h);
+    max_diff = std::max(max_diff, std::abs(fd - grad(l)) / std::max(std::abs(fd), 1.0));
+  }
+  return max_diff;
+}
+
+// Tests updating Z using Hamiltonian Monte Carlo on the simplex
+//
+// @name TestUpdateZHMC_PM
+arma::cube TestUpdateZHMC_PM(){
+  // Set space of functions
+  arma::vec t_obs =  arma::regspace(0, 10, 990);
+  splines2::BSpline bspline;
+  bspline = splines2::BSpline(t_obs, 8);
+  arma::mat bspline_mat{bspline.basis(true)};
+  // Make B_obs
+  arma::field<arma::mat> B_obs(20,1);
+
+  for(int i = 0; i < 20; i++){
+    B_obs(i,0) = bspline_mat;
+  }
+
+  // Make nu matrix
+  arma::mat nu(3,8);
+  nu = {{2, 0, 1, 0, 0, 0, 1, 3},
+  {1, 3, 0, 2, 0, 0, 3, 0},
+  {5, 2, 5, 0, 3, 4, 1, 0}};
+
+  // Make Phi matrix
+  arma::cube Phi(3,8,5);
+  for(int i=0; i < 5; i++)
+  {
+    Phi.slice(i) = (5-i) * 0.2 * arma::randu<arma::mat>(3,8);
+  }
+  double sigma_sq = 0.001;
+
+  // Make chi matrix
+  arma::mat chi(20, 5, arma::fill::randn);
+
+  // Make Z matrix
+  arma::mat Z(20, 3);
+  arma::mat alpha(20,3, arma::fill::ones);
+  alpha = alpha * 10;
+  for(int i = 0; i < Z.n_rows; i++){
+    Z.row(i) = BayesFMMM::rdirichlet(alpha.row(i).t()).t();
+  }
+
+  arma::field<arma::vec> y_obs(20, 1);
+  arma::vec mean = arma::zeros(8);
+
+  for(int j = 0; j < 20; j++){
+    BayesFMMM::calcMeanCoef(nu, Phi, Z.row(j), chi.row(j), mean);
+    y_obs(j, 0) = arma::mvnrnd(B_obs(j, 0) * mean, sigma_sq *
+      arma::eye(B_obs(j,0).n_rows, B_obs(j,0).n_rows));
+  }
+  BayesFMMM::RaggedObs obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+
+  // Initialize pi
+  arma::vec pi = {10, 10, 10};
+  arma::vec step_Z = 0.002 * arma::ones(20);
+  arma::vec accept_prob = arma::zeros(20);
+
+  //Initialize Z_samp
+  arma::cube Z_samp = arma::ones(20, 3, 1000);
+  for(int i = 0; i < 20; i++){
+    Z_samp.slice(0).row(i) = BayesFMMM::rdirichlet(pi).t();
+  }
+  for(int i = 0; i < 1000; i++){
+    BayesFMMM::updateZHMC_PM(obs, Phi, nu, chi, pi, sigma_sq, i, 1000, 1.0,
+                             step_Z, 10, accept_prob, Z_samp);
+  }
+  arma::mat Z_est = arma::zeros(20, 3);
+  arma::vec ph_Z = arma::zeros(500);
+  for(int i = 0; i < 20; i++){
+    for(int j = 0; j < 3; j++){
+      for(int l = 500; l < 1000; l++){
+        ph_Z(l - 500) = Z_samp(i,j,l);
+      }
+      Z_est(i,j) = arma::median(ph_Z);
+    }
+  }
+
+  // normalize
+  for(int i = 0; i < 20; i++){
+    Z_est.row(i) = Z_est.row(i) / arma::accu(Z_est.row(i));
+  }
+
+  arma::cube mod = arma::zeros(20, 3, 2);
+  mod.slice(0) = Z_est;
+  mod.slice(1) = Z;
+  return mod;
+}
+
 // Tests sampling of Z
+// Runs the Z kernel with the field and contiguous data models, and with the
+// tempered policy at beta = 1, from the same seed. Returns the largest
+// difference between the chains.
+//
+// @name TestZKernelVariants
+double TestZKernelVariants(){
+  Rcpp::Environment base_env("package:base");
+  Rcpp::Function set_seed_r = base_env["set.seed"];
+  arma::field<arma::vec> y_obs(20, 1);
+  arma::field<arma::mat> B_obs(20, 1);
+  for(int i = 0; i < 20; i++){
+    arma::vec t_i = arma::regspace(0, 10 + (i % 4), 990);
+    splines2::BSpline bspline(t_i, 8);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+    y_obs(i,0) = arma::sin(t_i / 200) + 0.1 * arma::randn(t_i.n_elem);
+  }
+  BayesFMMM::RaggedObs obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+  arma::mat nu = arma::randn(3, 8);
+  arma::cube Phi = 0.2 * arma::randn(3, 8, 2);
+  arma::mat chi(20, 2, arma::fill::randn);
+  arma::vec pi = {1, 1, 1};
+  arma::vec Z_ph = arma::zeros(3);
+  arma::cube Z_0 = arma::zeros(20, 3, 50);
+  for(int i = 0; i < 20; i++){
+    Z_0.slice(0).row(i) = BayesFMMM::rdirichlet(pi).t();
+  }
+  arma::cube Z_field = Z_0;
+  arma::cube Z_ragged = Z_0;
+  arma::cube Z_tempered = Z_0;
+
+  set_seed_r(2);
+  for(int i = 0; i < 50; i++){
+    BayesFMMM::updateZ_PM(y_obs, B_obs, Phi, nu, chi, pi, 0.01, i, 50, 1.0,
+                          100, Z_ph, Z_field);
+  }
+  set_seed_r(2);
+  for(int i = 0; i < 50; i++){
+    BayesFMMM::updateZ_PM(obs, Phi, nu, chi, pi, 0.01, i, 50, 1.0, 100, Z_ph,
+                          Z_ragged);
+  }
+  set_seed_r(2);
+  for(int i = 0; i < 50; i++){
+    BayesFMMM::updateZTempered_PM(1.0, obs, Phi, nu, chi, pi, 0.01, i, 50, 1.0,
+                                  100, Z_ph, Z_tempered);
+  }
+  return std::max(arma::abs(Z_field - Z_ragged).max(),
+                  arma::abs(Z_ragged - Z_tempered).max());
+}
+
 context("Unit tests for Z parameters") {
   test_that("Sampler for Z parameters") {
     Rcpp::Environment base_env("package:base");
@@ -1099,4 +1267,38 @@ context("Unit tests for Z parameters") {
     }
     expect_true(similar == true);
   }
+
+  test_that("Gradient of the log-pdf of Z on the simplex") {
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestGradZSimplex();
+    expect_true(x < 1e-5);
+  }
+
+  test_that("Sampler for Z parameters using Hamiltonian Monte Carlo") {
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::cube x = TestUpdateZHMC_PM();
+    arma::mat est = x.slice(0);
+    arma::mat truth = x.slice(1);
+    bool similar = true;
+    for(int i = 0; i < est.n_rows; i++){
+      for(int j = 0; j < est.n_cols; j++){
+        if(std::abs(est(i,j) - truth(i,j)) > 0.02){
+          similar = false;
+        }
+      }
+    }
+    expect_true(similar == true);
+  }
+
+  test_that("Z kernel gives the same chain for every data model and temperature") {
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestZKernelVariants();
+    expect_true(x < 1e-12);
+  }
 }
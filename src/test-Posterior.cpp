@@ -0,0 +1,60 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Compares the row-wise quantiles of a matrix of draws with arma::quantile
+// applied to each row
+//
+double TestRowQuantiles(){
+  arma::mat X = arma::randn(50, 333);
+  arma::vec p = {0, 0.025, 0.5, 0.975, 1};
+  arma::mat q = BayesFMMM::calcRowQuantiles(X, p);
+  double max_diff = 0;
+  for(arma::uword i = 0; i < X.n_rows; i++){
+    arma::vec x_i = X.row(i).t();
+    arma::vec q_i = arma::quantile(x_i, p);
+    max_diff = std::max(max_diff, arma::max(arma::abs(q.row(i).t() - q_i)));
+  }
+  return max_diff;
+}
+
+// Compares the simultaneous credible band with the band computed from the
+// max statistic of each sample
+//
+double TestSimultaneousCI(){
+  arma::mat X = arma::randn(40, 500);
+  arma::vec CI_Lower;
+  arma::vec CI_50;
+  arma::vec CI_Upper;
+  BayesFMMM::calcRowCI(X, 0.05, true, CI_Lower, CI_50, CI_Upper);
+
+  arma::vec x_mean = arma::mean(X, 1);
+  arma::vec x_sd = arma::stddev(X, 0, 1);
+  arma::vec C = arma::zeros(X.n_cols);
+  for(arma::uword i = 0; i < X.n_cols; i++){
+    C(i) = arma::max(arma::abs(X.col(i) - x_mean) / x_sd);
+  }
+  arma::vec p = {0.95};
+  arma::vec q = arma::quantile(C, p);
+  return arma::max(arma::abs(CI_Upper - (x_mean + q(0) * x_sd)));
+}
+
+context("Unit tests for posterior summaries") {
+  test_that("Row-wise quantiles of MCMC draws"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestRowQuantiles();
+    expect_true(x < 1e-12);
+  }
+
+  test_that("Simultaneous credible bands of MCMC draws"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestSimultaneousCI();
+    expect_true(x < 1e-12);
+  }
+
+}
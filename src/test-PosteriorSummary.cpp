@@ -0,0 +1,90 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Compares the streaming quantile estimates with the empirical quantiles of
+// 10000 draws from a standard normal distribution
+//
+arma::vec TestP2Quantile(){
+  arma::vec x = arma::randn(10000);
+  arma::vec probs = {0.025, 0.5, 0.975};
+  arma::vec est = arma::zeros(3);
+  for(int r = 0; r < 3; r++){
+    BayesFMMM::P2Quantile quant(probs(r));
+    for(int i = 0; i < x.n_elem; i++){
+      quant.update(x(i));
+    }
+    est(r) = quant.value();
+  }
+  arma::vec emp = arma::quantile(x, probs);
+  return arma::abs(est - emp);
+}
+
+// Compares the online summaries of the mean and covariance functions with
+// summaries computed from stored draws (the conditional means of nu differ
+// from the draws, so the standard deviations must come from the draws)
+//
+arma::vec TestOnlineSummary(){
+  arma::vec t_grid = arma::regspace(0, 10, 990);
+  splines2::BSpline bspline = splines2::BSpline(t_grid, 8);
+  arma::mat B_grid{bspline.basis(true)};
+
+  int n_draws = 200;
+  arma::vec probs = {0.5};
+  BayesFMMM::OnlineSummary summary(B_grid, 2, probs);
+  arma::mat f_mean = arma::zeros(2, B_grid.n_rows);
+  arma::mat cov_12 = arma::zeros(B_grid.n_rows, B_grid.n_rows);
+  arma::cube f_draws(2, B_grid.n_rows, n_draws);
+  for(int i = 0; i < n_draws; i++){
+    arma::mat nu_mean = arma::randn(2, 8);
+    arma::mat nu = nu_mean + arma::randn(2, 8);
+    arma::cube Phi = arma::randn(2, 8, 3);
+    summary.update(nu, nu_mean, Phi);
+    f_mean = f_mean + (nu_mean * B_grid.t()) / n_draws;
+    f_draws.slice(i) = nu * B_grid.t();
+    for(int n = 0; n < 3; n++){
+      cov_12 = cov_12 + (B_grid * Phi.slice(n).row(0).t() *
+        Phi.slice(n).row(1) * B_grid.t()) / n_draws;
+    }
+  }
+  Rcpp::List out = summary.summary();
+  arma::mat f_online = out["mean"];
+  arma::cube cov_online = out["cov"];
+
+  arma::mat sd_online = out["mean_sd"];
+
+  arma::vec mod = arma::zeros(3);
+  mod(0) = arma::max(arma::max(arma::abs(f_online - f_mean)));
+  mod(1) = arma::max(arma::max(arma::abs(cov_online.slice(1) - cov_12)));
+  arma::mat f_k(n_draws, B_grid.n_rows);
+  for(arma::uword k = 0; k < 2; k++){
+    for(int i = 0; i < n_draws; i++){
+      f_k.row(i) = f_draws.slice(i).row(k);
+    }
+    arma::rowvec sd_k = arma::stddev(f_k, 0);
+    mod(2) = std::max(mod(2), arma::abs(sd_online.row(k) - sd_k).max());
+  }
+  return mod;
+}
+
+context("Unit tests for online posterior summaries") {
+  test_that("Streaming quantile estimates"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestP2Quantile();
+    expect_true(x.max() < 0.05);
+  }
+
+  test_that("Online mean and covariance functions"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestOnlineSummary();
+    expect_true(x(0) < 1e-8);
+    expect_true(x(1) < 1e-8);
+    expect_true(x(2) < 1e-8);
+  }
+
+}
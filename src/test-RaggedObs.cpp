@@ -0,0 +1,133 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <vector>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Tests the log-likelihood computed on contiguous storage against the field
+// based implementation using functions observed at different numbers of
+// time points
+//
+arma::vec TestRaggedLikelihood(){
+  // Make B_obs and y_obs with a different number of time points per function
+  arma::field<arma::mat> B_obs(50,1);
+  arma::field<arma::vec> y_obs(50,1);
+  for(int i = 0; i < 50; i++){
+    arma::vec t_obs =  arma::regspace(0, 10 + (i % 7), 990);
+    splines2::BSpline bspline;
+    bspline = splines2::BSpline(t_obs, 8);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+  }
+
+  // Make nu matrix
+  arma::mat nu(3,8);
+  nu = {{2, 0, 1, 0, 0, 0, 1, 3},
+  {1, 3, 0, 2, 0, 0, 3, 0},
+  {5, 2, 5, 0, 3, 4, 1, 0}};
+
+  // Make Phi matrix
+  arma::cube Phi(3,8,5);
+  for(int i=0; i < 5; i++)
+  {
+    Phi.slice(i) = (5-i) * 0.1 * arma::randu<arma::mat>(3,8);
+  }
+  double sigma_sq = 0.5;
+
+  // Make chi matrix
+  arma::mat chi(50, 5, arma::fill::randn);
+
+  arma::mat Z(50, 3);
+  arma::vec c(3, arma::fill::randu);
+  arma:: vec alpha = c * 10;
+  for(int i = 0; i < Z.n_rows; i++){
+    Z.row(i) = BayesFMMM::rdirichlet(alpha).t();
+  }
+
+  arma::vec mean = arma::zeros(8);
+  for(int j = 0; j < 50; j++){
+    mean = arma::zeros(8);
+    for(int l = 0; l < 3; l++){
+      mean = mean + Z(j,l) * nu.row(l).t();
+      for(int m = 0; m < Phi.n_slices; m++){
+        mean = mean + Z(j,l) * chi(j,m) * Phi.slice(m).row(l).t();
+      }
+    }
+    y_obs(j, 0) = arma::mvnrnd(B_obs(j, 0) * mean, sigma_sq *
+      arma::eye(B_obs(j,0).n_rows, B_obs(j,0).n_rows));
+  }
+
+  BayesFMMM::RaggedObs obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+
+  arma::vec mod = arma::zeros(4);
+  mod(0) = BayesFMMM::calcLikelihood(obs, nu, Phi, Z, chi, sigma_sq);
+  mod(1) = BayesFMMM::calcLikelihood(y_obs, B_obs, nu, Phi, Z, chi, sigma_sq);
+  mod(2) = arma::accu(arma::abs(obs.B_i(17).t() - B_obs(17,0)));
+  mod(3) = arma::accu(arma::abs(obs.y_i(17) - y_obs(17,0)));
+
+  return mod;
+}
+
+// Packs empty fields, fields with different numbers of functions and
+// functions whose basis matrices do not match their observed values. Returns
+// the number of calls that were rejected.
+//
+int TestRaggedValidation(){
+  arma::field<arma::vec> y_obs(3,1);
+  arma::field<arma::mat> B_obs(3,1);
+  for(int i = 0; i < 3; i++){
+    y_obs(i,0) = arma::randn(5);
+    B_obs(i,0) = arma::randu(5, 4);
+  }
+  arma::field<arma::vec> y_empty;
+  arma::field<arma::mat> B_empty;
+  arma::field<arma::mat> B_short = B_obs.rows(0, 1);
+  arma::field<arma::mat> B_rows = B_obs;
+  B_rows(1,0) = arma::randu(4, 4);
+  arma::field<arma::mat> B_cols = B_obs;
+  B_cols(2,0) = arma::randu(5, 3);
+
+  int n_rejected = 0;
+  std::vector<arma::field<arma::mat> > B_bad = {B_empty, B_short, B_rows, B_cols};
+  for(std::size_t l = 0; l < B_bad.size(); l++){
+    try{
+      BayesFMMM::makeRaggedObs((l == 0) ? y_empty : y_obs, B_bad[l]);
+    }catch(std::exception& e){
+      n_rejected++;
+    }
+  }
+  BayesFMMM::makeRaggedObs(y_obs, B_obs);
+  return n_rejected;
+}
+
+context("Unit tests for contiguous observation storage") {
+  test_that("Mismatched observations are rejected"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    int x = TestRaggedValidation();
+    expect_true(x == 4);
+  }
+
+  test_that("Packed observations match the original fields"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestRaggedLikelihood();
+    expect_true(x(2) == 0);
+    expect_true(x(3) == 0);
+  }
+
+  test_that("Log-likelihood using contiguous storage"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestRaggedLikelihood();
+    bool similar = true;
+    if(std::abs(x(0) - x(1)) > 1e-6 * std::abs(x(1))){
+      similar = false;
+    }
+    expect_true(similar == true);
+  }
+
+}
@@ -0,0 +1,217 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <fstream>
+#include <vector>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Writes a batch of MCMC iterations with a retention policy and compares the
+// files with the iterations that should have been retained. Returns the
+// largest difference (-1 if a file is missing or a parameter that is not
+// retained was written).
+//
+double TestRetentionFlush(){
+  Rcpp::Environment base_env("package:base");
+  Rcpp::Function tempdir_r = base_env["tempdir"];
+  std::string directory = Rcpp::as<std::string>(tempdir_r()) + "/retention_";
+  int r_stored_iters = 20;
+  arma::cube nu(3, 4, r_stored_iters, arma::fill::randn);
+  arma::mat pi(3, r_stored_iters, arma::fill::randu);
+  arma::mat tau(r_stored_iters, 3, arma::fill::randu);
+  arma::vec sigma(r_stored_iters, arma::fill::randu);
+  arma::field<arma::cube> gamma(r_stored_iters, 1);
+  for(int i = 0; i < r_stored_iters; i++){
+    gamma(i,0) = arma::randu(3, 4, 2);
+  }
+
+  Rcpp::NumericVector retain = Rcpp::NumericVector::create(
+    Rcpp::Named("Nu", 1), Rcpp::Named("Pi", 1), Rcpp::Named("Tau", 5),
+    Rcpp::Named("Gamma", 2));
+  BayesFMMM::RetentionPolicy retention =
+    BayesFMMM::makeRetentionPolicy(BayesFMMM::modelParams(), 1,
+                                   r_stored_iters, retain);
+  BayesFMMM::flushRetained(retention, "Nu", nu, directory, 0);
+  BayesFMMM::flushRetainedCols(retention, "Pi", pi, directory, 0);
+  BayesFMMM::flushRetainedRows(retention, "Tau", tau, directory, 0);
+  BayesFMMM::flushRetained(retention, "Sigma", sigma, directory, 0);
+  BayesFMMM::flushRetained(retention, "Gamma", gamma, directory, 0);
+
+  std::ifstream sigma_file(directory + "Sigma0.txt");
+  if(sigma_file.good()){
+    return -1;
+  }
+  arma::cube nu1;
+  arma::mat pi1;
+  arma::mat tau1;
+  arma::field<arma::cube> gamma1;
+  if(!nu1.load(directory + "Nu0.txt") || !pi1.load(directory + "Pi0.txt") ||
+     !tau1.load(directory + "Tau0.txt") || !gamma1.load(directory + "Gamma0.txt")){
+    return -1;
+  }
+  if((nu1.n_slices != 20) || (pi1.n_cols != 20) || (tau1.n_rows != 4) ||
+     (gamma1.n_rows != 10)){
+    return -1;
+  }
+
+  double diff = 0;
+  for(int p = 0; p < 20; p++){
+    diff = std::max(diff, arma::abs(nu1.slice(p) -
+      nu.slice(BayesFMMM::retainedSlot(p, 1))).max());
+  }
+  for(int p = 0; p < 20; p++){
+    diff = std::max(diff, arma::abs(pi1.col(p) - pi.col(p)).max());
+  }
+  for(int p = 0; p < 4; p++){
+    diff = std::max(diff, arma::abs(tau1.row(p) - tau.row((p == 0) ? 0 : 5 * p - 1)).max());
+  }
+  for(int p = 0; p < 10; p++){
+    diff = std::max(diff, arma::abs(gamma1(p,0) - gamma((p == 0) ? 0 : 2 * p - 1, 0)).max());
+  }
+  return diff;
+}
+
+// Builds retention policies where parameters read together by the posterior
+// summaries have different thinning. Returns the number of policies that were
+// rejected.
+//
+int TestRetentionMixedJoint(){
+  std::vector<Rcpp::NumericVector> retain = {
+    Rcpp::NumericVector::create(Rcpp::Named("Nu", 1), Rcpp::Named("Z", 10)),
+    Rcpp::NumericVector::create(Rcpp::Named("Phi", 2), Rcpp::Named("Sigma", 1)),
+    Rcpp::NumericVector::create(Rcpp::Named("Chi", 4), Rcpp::Named("Pi", 4),
+                                Rcpp::Named("alpha_3", 2))};
+  int n_rejected = 0;
+  for(std::size_t l = 0; l < retain.size(); l++){
+    try{
+      BayesFMMM::makeRetentionPolicy(BayesFMMM::modelParams(), 1, 20, retain[l]);
+    }catch(std::exception& e){
+      n_rejected++;
+    }
+  }
+  return n_rejected;
+}
+
+// Saves a batch of MCMC iterations where the parameters of the likelihood are
+// retained every other iteration and the remaining ones with other thinning,
+// then reads the directory back. Returns the largest difference between the
+// log-likelihood read back and the log-likelihood of the retained iterations,
+// and whether reading a Z file with a different number of samples was
+// rejected.
+//
+arma::vec TestRetentionReadback(){
+  Rcpp::Environment base_env("package:base");
+  Rcpp::Function tempdir_r = base_env["tempdir"];
+  std::string directory = Rcpp::as<std::string>(tempdir_r()) + "/readback_";
+  int r_stored_iters = 20;
+  int n_funct = 10;
+  int K = 2;
+  int M = 2;
+  arma::vec internal_knots = {250, 500, 750};
+  arma::vec boundary_knots = {0, 1000};
+  arma::field<arma::vec> time(n_funct, 1);
+  arma::field<arma::vec> y_obs(n_funct, 1);
+  for(int i = 0; i < n_funct; i++){
+    time(i,0) = arma::regspace(0, 50 + 10 * i, 1000);
+    y_obs(i,0) = arma::sin(time(i,0) / 200) + 0.3 * arma::randn(time(i,0).n_elem);
+  }
+  int P = internal_knots.n_elem + 4;
+
+  arma::cube nu(K, P, r_stored_iters, arma::fill::randn);
+  arma::cube Z(n_funct, K, r_stored_iters);
+  arma::cube chi(n_funct, M, r_stored_iters, arma::fill::randn);
+  arma::vec sigma = 0.1 + arma::randu(r_stored_iters);
+  arma::mat tau(r_stored_iters, M, arma::fill::randu);
+  arma::field<arma::cube> Phi(r_stored_iters, 1);
+  arma::field<arma::cube> gamma(r_stored_iters, 1);
+  arma::vec alpha = arma::ones(K);
+  for(int l = 0; l < r_stored_iters; l++){
+    Phi(l,0) = 0.5 * arma::randn(K, P, M);
+    gamma(l,0) = arma::randu(K, P, M);
+    for(int i = 0; i < n_funct; i++){
+      Z.slice(l).row(i) = BayesFMMM::rdirichlet(alpha).t();
+    }
+  }
+
+  Rcpp::NumericVector retain = Rcpp::NumericVector::create(
+    Rcpp::Named("Nu", 2), Rcpp::Named("Phi", 2), Rcpp::Named("Z", 2),
+    Rcpp::Named("Chi", 2), Rcpp::Named("Sigma", 2), Rcpp::Named("Tau", 5),
+    Rcpp::Named("Gamma", 4));
+  BayesFMMM::RetentionPolicy retention =
+    BayesFMMM::makeRetentionPolicy(BayesFMMM::modelParams(), 1,
+                                   r_stored_iters, retain);
+  BayesFMMM::flushRetained(retention, "Nu", nu, directory, 0);
+  BayesFMMM::flushRetained(retention, "Phi", Phi, directory, 0);
+  BayesFMMM::flushRetained(retention, "Z", Z, directory, 0);
+  BayesFMMM::flushRetained(retention, "Chi", chi, directory, 0);
+  BayesFMMM::flushRetained(retention, "Sigma", sigma, directory, 0);
+  BayesFMMM::flushRetainedRows(retention, "Tau", tau, directory, 0);
+  BayesFMMM::flushRetained(retention, "Gamma", gamma, directory, 0);
+
+  arma::vec diff = arma::zeros(2);
+  BayesFMMM::Posterior post(directory, 1, 3, boundary_knots, internal_knots);
+  arma::vec llik = post.LLik(time, y_obs);
+  if(llik.n_elem != 10){
+    diff(0) = -1;
+    return diff;
+  }
+  arma::field<arma::mat> B_obs(n_funct, 1);
+  for(int i = 0; i < n_funct; i++){
+    splines2::BSpline bspline(time(i,0), internal_knots, 3, boundary_knots);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+  }
+  for(int p = 0; p < 10; p++){
+    arma::uword l = BayesFMMM::retainedSlot(p, 2);
+    double llik_p = BayesFMMM::calcLikelihood(y_obs, B_obs, nu.slice(l),
+                                              Phi(l,0), Z.slice(l),
+                                              chi.slice(l), sigma(l));
+    diff(0) = std::max(diff(0), std::abs(llik(p) - llik_p) / std::abs(llik_p));
+  }
+
+  // Z saved with a different thinning than the other parameters
+  arma::cube Z1 = Z.slices(0, 3);
+  Z1.save(directory + "Z0.txt");
+  BayesFMMM::Posterior post1(directory, 1, 3, boundary_knots, internal_knots);
+  try{
+    post1.LLik(time, y_obs);
+  }catch(std::exception& e){
+    diff(1) = 1;
+  }
+  return diff;
+}
+
+context("Unit tests for the retention policy") {
+  test_that("Retained parameters are written once with their thinning"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestRetentionFlush();
+    expect_true(x >= 0);
+    expect_true(x < 1e-6);
+  }
+
+  test_that("Parameters read together must share their thinning"){
+    int x = TestRetentionMixedJoint();
+    expect_true(x == 3);
+  }
+
+  test_that("Directories saved with mixed thinning are read back aligned"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestRetentionReadback();
+    expect_true(x(0) >= 0);
+    expect_true(x(0) < 1e-6);
+    expect_true(x(1) == 1);
+  }
+
+  test_that("Every parameter is retained by default"){
+    BayesFMMM::RetentionPolicy retention =
+      BayesFMMM::makeRetentionPolicy(BayesFMMM::covariateAdjParams(), 3);
+    expect_true(retention.thinning.size() == 17);
+    expect_true(BayesFMMM::retainedThinning(retention, "Gamma") == 3);
+    expect_true(BayesFMMM::retainedThinning(retention, "AXi") == 3);
+    expect_true(BayesFMMM::retainedThinning(retention, "Unknown") == 0);
+  }
+
+}
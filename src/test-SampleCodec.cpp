@@ -0,0 +1,106 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Saves a cube and a field of cubes of draws with a storage codec, loads them
+// back and returns the largest absolute and relative errors (-1 if a file
+// could not be loaded or has the wrong dimensions). The relative errors of
+// values close to 0 are computed with respect to 1e-4.
+//
+arma::vec TestCodecRoundTrip(const std::string& method,
+                             const double tol){
+  Rcpp::Environment base_env("package:base");
+  Rcpp::Function tempdir_r = base_env["tempdir"];
+  std::string directory = Rcpp::as<std::string>(tempdir_r()) + "/codec_" +
+    method;
+  BayesFMMM::SampleCodec codec = BayesFMMM::makeSampleCodec(method, tol);
+
+  // slowly varying draws, similar to a chain
+  arma::cube nu(3, 8, 50);
+  nu.slice(0) = arma::randn(3, 8);
+  for(arma::uword p = 1; p < nu.n_slices; p++){
+    nu.slice(p) = nu.slice(p - 1) + 0.05 * arma::randn(3, 8);
+  }
+  arma::field<arma::cube> Phi(10, 1);
+  for(arma::uword p = 0; p < Phi.n_rows; p++){
+    Phi(p,0) = 0.5 * arma::randn(3, 8, 2);
+  }
+  arma::vec sigma = 0.01 * arma::randu(50) + 0.001;
+
+  arma::vec err = -arma::ones(2);
+  if(!BayesFMMM::saveSamples(nu, directory + "Nu0.txt", codec) ||
+     !BayesFMMM::saveSamples(Phi, directory + "Phi0.txt", codec) ||
+     !BayesFMMM::saveSamples(sigma, directory + "Sigma0.txt", codec)){
+    return err;
+  }
+  arma::cube nu1;
+  arma::field<arma::cube> Phi1;
+  arma::vec sigma1;
+  if(!BayesFMMM::loadSamples(nu1, directory + "Nu0.txt") ||
+     !BayesFMMM::loadSamples(Phi1, directory + "Phi0.txt") ||
+     !BayesFMMM::loadSamples(sigma1, directory + "Sigma0.txt")){
+    return err;
+  }
+  if((nu1.n_slices != 50) || (Phi1.n_rows != 10) || (sigma1.n_elem != 50)){
+    return err;
+  }
+  err(0) = std::max(arma::abs(nu1 - nu).max(), arma::abs(sigma1 - sigma).max());
+  err(1) = (arma::abs(nu1 - nu) / arma::clamp(arma::abs(nu), 1e-4, arma::datum::inf)).max();
+  for(arma::uword p = 0; p < Phi.n_rows; p++){
+    err(0) = std::max(err(0), arma::abs(Phi1(p,0) - Phi(p,0)).max());
+    err(1) = std::max(err(1), (arma::abs(Phi1(p,0) - Phi(p,0)) /
+      arma::clamp(arma::abs(Phi(p,0)), 1e-4, arma::datum::inf)).max());
+  }
+  return err;
+}
+
+// Saves draws that cannot be stored in half precision with the float16 codec
+// and returns the largest difference with the loaded draws
+//
+double TestCodecFallback(){
+  Rcpp::Environment base_env("package:base");
+  Rcpp::Function tempdir_r = base_env["tempdir"];
+  std::string file = Rcpp::as<std::string>(tempdir_r()) + "/codec_fallback.txt";
+  arma::mat tau = 1e6 * arma::randu(20, 3);
+  BayesFMMM::saveSamples(tau, file, BayesFMMM::makeSampleCodec("float16", 0));
+  arma::mat tau1;
+  if(!BayesFMMM::loadSamples(tau1, file) || (tau1.n_rows != 20)){
+    return -1;
+  }
+  return arma::abs(tau1 - tau).max();
+}
+
+context("Unit tests for the storage codecs") {
+  test_that("Lossless codec recovers the draws exactly"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestCodecRoundTrip("lossless", 0);
+    expect_true(x(0) == 0);
+    x = TestCodecRoundTrip("arma_ascii", 0);
+    expect_true(x(0) >= 0);
+    expect_true(x(0) < 1e-6);
+  }
+
+  test_that("Lossy codecs respect their error bounds"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestCodecRoundTrip("quantized", 1e-3);
+    expect_true(x(0) >= 0);
+    expect_true(x(0) <= 1e-3 * (1 + 1e-8));
+    x = TestCodecRoundTrip("float16", 0);
+    expect_true(x(1) >= 0);
+    expect_true(x(1) < std::ldexp(1.0, -11) + std::ldexp(1.0, -23));
+  }
+
+  test_that("Draws out of the range of a lossy codec are stored losslessly"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestCodecFallback();
+    expect_true(x == 0);
+  }
+
+}
@@ -0,0 +1,109 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Saves batches of nu, sigma and Phi samples in the Armadillo formats (and
+// one batch with a storage codec), reads them back with the parallel loaders
+// and returns the largest difference with the samples (-1 if the dimensions
+// do not match)
+//
+double TestParallelLoader(){
+  Rcpp::Environment base_env("package:base");
+  Rcpp::Function tempdir_r = base_env["tempdir"];
+  std::string directory = Rcpp::as<std::string>(tempdir_r()) + "/loader_";
+  int n_files = 4;
+  arma::cube nu(3, 5, 40, arma::fill::randn);
+  arma::vec sigma(40, arma::fill::randu);
+  arma::field<arma::cube> Phi(40, 1);
+  for(int i = 0; i < 40; i++){
+    Phi(i,0) = arma::randn(3, 5, 2);
+  }
+  BayesFMMM::SampleCodec codec = BayesFMMM::makeSampleCodec("lossless", 0);
+  for(int i = 0; i < n_files; i++){
+    arma::cube nu_i = nu.slices(10 * i, 10 * i + 9);
+    arma::vec sigma_i = sigma.subvec(10 * i, 10 * i + 9);
+    arma::field<arma::cube> Phi_i = Phi.rows(10 * i, 10 * i + 9);
+    if(i == 2){
+      BayesFMMM::saveSamples(nu_i, directory + "Nu2.txt", codec);
+    }else{
+      nu_i.save(directory + "Nu" + std::to_string(i) + ".txt", arma::arma_ascii);
+    }
+    sigma_i.save(directory + "Sigma" + std::to_string(i) + ".txt", arma::arma_ascii);
+    Phi_i.save(directory + "Phi" + std::to_string(i) + ".txt");
+  }
+
+  arma::cube nu1 = BayesFMMM::loadCubeSamples(directory, "Nu", n_files);
+  arma::vec sigma1 = BayesFMMM::loadVecSamples(directory, "Sigma", n_files);
+  arma::field<arma::cube> Phi1 = BayesFMMM::loadFieldSamples(directory, "Phi", n_files);
+  if((nu1.n_slices != 40) || (sigma1.n_elem != 40) || (Phi1.n_rows != 40) ||
+     (BayesFMMM::countSampleFiles(directory, "Nu") != n_files)){
+    return -1;
+  }
+  double diff = std::max(arma::abs(nu1 - nu).max(), arma::abs(sigma1 - sigma).max());
+  for(int i = 0; i < 40; i++){
+    diff = std::max(diff, arma::abs(Phi1(i,0) - Phi(i,0)).max());
+  }
+  return diff;
+}
+
+// Converts a directory of samples saved in the Armadillo formats and returns
+// the largest difference between the converted and the original samples (-1
+// if the files were not converted)
+//
+double TestConvertDirectory(){
+  Rcpp::Environment base_env("package:base");
+  Rcpp::Function tempdir_r = base_env["tempdir"];
+  std::string directory = Rcpp::as<std::string>(tempdir_r()) + "/convert_";
+  std::string out_directory = Rcpp::as<std::string>(tempdir_r()) + "/converted_";
+  arma::cube Z(10, 3, 20, arma::fill::randu);
+  arma::mat pi(3, 20, arma::fill::randu);
+  arma::field<arma::cube> gamma(20, 1);
+  for(int i = 0; i < 20; i++){
+    gamma(i,0) = arma::randu(3, 5, 2);
+  }
+  for(int i = 0; i < 2; i++){
+    Z.save(directory + "Z" + std::to_string(i) + ".txt", arma::arma_ascii);
+    pi.save(directory + "Pi" + std::to_string(i) + ".txt", arma::arma_ascii);
+    gamma.save(directory + "Gamma" + std::to_string(i) + ".txt");
+  }
+
+  arma::uvec n_files =
+    BayesFMMM::convertSampleDirectory(directory, out_directory,
+                                      BayesFMMM::modelParams(),
+                                      BayesFMMM::makeSampleCodec("lossless", 0));
+  if((arma::accu(n_files) != 6) ||
+     !BayesFMMM::isCodecFile(out_directory + "Z1.txt")){
+    return -1;
+  }
+  arma::cube Z1 = BayesFMMM::loadCubeSamples(out_directory, "Z", 2);
+  arma::mat pi1 = BayesFMMM::loadMatSamples(out_directory, "Pi", 2);
+  arma::field<arma::cube> gamma1 = BayesFMMM::loadFieldSamples(out_directory, "Gamma", 2);
+  double diff = std::max(arma::abs(Z1.slices(20, 39) - Z).max(),
+                         arma::abs(pi1.cols(0, 19) - pi).max());
+  for(int i = 0; i < 20; i++){
+    diff = std::max(diff, arma::abs(gamma1(i + 20,0) - gamma(i,0)).max());
+  }
+  return diff;
+}
+
+context("Unit tests for the parallel sample loader") {
+  test_that("Files are read concurrently and stacked in order"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestParallelLoader();
+    expect_true(x >= 0);
+    expect_true(x < 1e-10);
+  }
+
+  test_that("Result directories are converted to a storage codec"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestConvertDirectory();
+    expect_true(x >= 0);
+    expect_true(x < 1e-10);
+  }
+
+}
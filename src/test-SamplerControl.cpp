@@ -0,0 +1,83 @@
+#include <RcppArmadillo.h>
+#include <string>
+#include <vector>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Parses control lists that should be rejected (options of other samplers, a
+// misspelled option, an unnamed list, values out of range and online
+// summaries with the stochastic gradient sampler). Returns the number of
+// lists that were rejected.
+//
+int TestSamplerControlRejected(){
+  std::vector<Rcpp::List> control = {
+    Rcpp::List::create(Rcpp::Named("n_adapt", 100)),
+    Rcpp::List::create(Rcpp::Named("codec_to", 0.01)),
+    Rcpp::List::create(1, 2),
+    Rcpp::List::create(Rcpp::Named("step_Z", -1)),
+    Rcpp::List::create(Rcpp::Named("codec", "quantized"),
+                       Rcpp::Named("codec_tol", 0)),
+    Rcpp::List::create(Rcpp::Named("sg_batch_size", 10)),
+    Rcpp::List::create(Rcpp::Named("sg_n_anchor", 0)),
+    Rcpp::List::create(Rcpp::Named("sg_batch_size", 10),
+                       Rcpp::Named("summary_time", 500))};
+  std::vector<std::vector<std::string>> options = {
+    BayesFMMM::storageControls(), BayesFMMM::storageControls(),
+    BayesFMMM::temperedControls(), BayesFMMM::temperedControls(),
+    BayesFMMM::storageControls(), BayesFMMM::temperedControls(),
+    BayesFMMM::warmStartControls(), BayesFMMM::warmStartControls()};
+  int n_rejected = 0;
+  for(std::size_t l = 0; l < control.size(); l++){
+    try{
+      BayesFMMM::makeSamplerControl(control[l], options[l]);
+    }catch(std::exception& e){
+      n_rejected++;
+    }
+  }
+  return n_rejected;
+}
+
+context("Unit tests for the control options of the samplers") {
+  test_that("Options that are not specified keep their default values"){
+    BayesFMMM::SamplerControl ctrl =
+      BayesFMMM::makeSamplerControl(R_NilValue, BayesFMMM::warmStartControls());
+    expect_true(ctrl.summary_time.is_empty());
+    expect_true(ctrl.summary_probs.n_elem == 3);
+    expect_true(ctrl.n_adapt == 0);
+    expect_true(ctrl.step_Z == 0.1);
+    expect_true(!ctrl.single_precision);
+    expect_true(ctrl.retain.isNull());
+    expect_true(ctrl.codec.method == BayesFMMM::SAMPLE_CODEC_ASCII);
+    expect_true(ctrl.data_file.empty());
+    expect_true(ctrl.sg_batch_size == 0);
+  }
+
+  test_that("Specified options are parsed"){
+    Rcpp::List control = Rcpp::List::create(
+      Rcpp::Named("summary_time", Rcpp::NumericVector::create(0, 500, 1000)),
+      Rcpp::Named("n_adapt", 50),
+      Rcpp::Named("n_leapfrog_Z", 5),
+      Rcpp::Named("parallel_sweep", true),
+      Rcpp::Named("retain", Rcpp::NumericVector::create(Rcpp::Named("Nu", 2))),
+      Rcpp::Named("codec", "quantized"),
+      Rcpp::Named("codec_tol", 0.01),
+      Rcpp::Named("compress_obs", true),
+      Rcpp::Named("sg_step", 0.05));
+    BayesFMMM::SamplerControl ctrl =
+      BayesFMMM::makeSamplerControl(control, BayesFMMM::warmStartControls());
+    expect_true(ctrl.summary_time.n_elem == 3);
+    expect_true(ctrl.n_adapt == 50);
+    expect_true(ctrl.n_leapfrog_Z == 5);
+    expect_true(ctrl.parallel_sweep);
+    expect_true(ctrl.retain.isNotNull());
+    expect_true(ctrl.codec.method == BayesFMMM::SAMPLE_CODEC_QUANTIZED);
+    expect_true(ctrl.codec.tol == 0.01);
+    expect_true(ctrl.compress_obs);
+    expect_true(ctrl.sg_step == 0.05);
+  }
+
+  test_that("Options of other samplers and invalid values are rejected"){
+    int x = TestSamplerControlRejected();
+    expect_true(x == 8);
+  }
+}
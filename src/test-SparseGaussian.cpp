@@ -0,0 +1,121 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Compares the sparse P matrix with the dense P matrix and the conjugate
+// gradient solution with a dense solve. Returns the largest differences and
+// the number of conjugate gradient iterations.
+//
+arma::vec TestSparseSolve(){
+  arma::vec basis_degree = {3, 2};
+  arma::field<arma::vec> internal_knots(2,1);
+  internal_knots(0,0) = {0.25, 0.5, 0.75};
+  internal_knots(1,0) = {0.3, 0.6};
+  arma::vec diff = arma::zeros(3);
+  arma::mat P_mat = BayesFMMM::GetP(basis_degree, internal_knots);
+  arma::sp_mat P_diff = BayesFMMM::GetPDiff(basis_degree, internal_knots);
+  arma::sp_mat P_sp = BayesFMMM::GetPSparse(basis_degree, internal_knots);
+  diff(0) = std::max(arma::abs(P_mat - arma::mat(P_sp)).max(),
+                     arma::abs(P_mat - arma::mat(P_diff.t() * P_diff)).max());
+
+  int P = P_mat.n_cols;
+  arma::sp_mat B_sp = arma::sprandu<arma::sp_mat>(P, 200, 0.1);
+  arma::sp_mat Q = B_sp * B_sp.t() + 0.5 * P_sp;
+  Q.diag() += 0.01;
+  arma::vec rhs = arma::randn(P);
+  arma::vec x = arma::zeros(P);
+  diff(2) = BayesFMMM::pcgSolve(Q, rhs, 1e-12, 10 * P, x);
+  diff(1) = arma::abs(x - arma::solve(arma::mat(Q), rhs)).max();
+  return diff;
+}
+
+// Draws nu many times using perturbation-optimization and compares the
+// sample mean and covariance with the mean and covariance of the full
+// conditional computed with dense matrices. Returns the largest differences
+// scaled by the posterior standard deviations.
+//
+arma::vec TestPerturbOptimize(){
+  int n_funct = 30;
+  int K = 1;
+  int M = 2;
+  arma::vec internal_knots = {250, 500, 750};
+  arma::vec boundary_knots = {0, 1000};
+  arma::field<arma::vec> y_obs(n_funct, 1);
+  arma::field<arma::mat> B_obs(n_funct, 1);
+  for(int i = 0; i < n_funct; i++){
+    arma::vec t_i = arma::regspace(0, 20 + (i % 7), 990);
+    splines2::BSpline bspline(t_i, internal_knots, 3, boundary_knots);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+    y_obs(i,0) = arma::sin(t_i / 200) + 0.3 * arma::randn(t_i.n_elem);
+  }
+  BayesFMMM::RaggedObs obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+  int P = obs.B_t.n_rows;
+  const arma::sp_mat B_sp(obs.B_t);
+  arma::mat Z(n_funct, K);
+  arma::vec alpha = arma::ones(K);
+  for(int i = 0; i < n_funct; i++){
+    Z.row(i) = BayesFMMM::rdirichlet(alpha).t();
+  }
+  arma::cube Phi = 0.5 * arma::randn(K, P, M);
+  arma::mat chi = arma::randn(n_funct, M);
+  arma::vec tau = {2};
+  double sigma = 0.2;
+
+  // the P matrix of a single dimension
+  arma::vec basis_degree = {3};
+  arma::field<arma::vec> knots(1,1);
+  knots(0,0) = internal_knots;
+  arma::sp_mat P_diff = BayesFMMM::GetPDiff(basis_degree, knots);
+  arma::sp_mat P_sp = P_diff.t() * P_diff;
+  arma::mat P_mat(P_sp);
+
+  // conditional mean and covariance of nu
+  arma::cube nu(K, P, 2);
+  nu.slice(0) = arma::randn(K, P);
+  arma::mat nu_0 = nu.slice(0);
+  arma::vec b_1(P);
+  arma::mat B_1(P, P);
+  arma::mat nu_mean(K, P);
+  BayesFMMM::updateNu(obs, tau, Phi, Z, chi, sigma, 0, 2, P_mat, b_1, B_1,
+                      nu, nu_mean);
+  arma::vec mean_1 = nu_mean.row(0).t();
+  arma::mat cov_1 = B_1;
+
+  int n_samp = 10000;
+  arma::mat samp(n_samp, P);
+  for(int l = 0; l < n_samp; l++){
+    nu.slice(0) = nu_0;
+    BayesFMMM::updateNuPCG(obs, B_sp, tau, Phi, Z, chi, sigma, 0, 2, P_diff,
+                           P_sp, nu);
+    samp.row(l) = nu.slice(0).row(0);
+  }
+  arma::vec sd = arma::sqrt(cov_1.diag());
+  arma::vec diff = arma::zeros(2);
+  diff(0) = arma::abs((arma::mean(samp, 0).t() - mean_1) / sd).max();
+  diff(1) = arma::abs((arma::cov(samp) - cov_1) / (sd * sd.t())).max();
+  return diff;
+}
+
+context("Unit tests for the sparse Gaussian sampler") {
+  test_that("Sparse P matrix and conjugate gradients match dense computations"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestSparseSolve();
+    expect_true(x(0) < 1e-12);
+    expect_true(x(1) < 1e-8);
+    expect_true(x(2) > 0);
+  }
+
+  test_that("Perturbation-optimization draws follow the full conditional of nu"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestPerturbOptimize();
+    expect_true(x(0) < 0.1);
+    expect_true(x(1) < 0.1);
+  }
+
+}
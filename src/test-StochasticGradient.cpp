@@ -0,0 +1,261 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Simulates observations and parameters of the mixed membership model
+//
+void SimulateSGData(const int n_funct,
+                    const int K,
+                    const int M,
+                    BayesFMMM::RaggedObs& obs,
+                    arma::mat& nu,
+                    arma::cube& Phi,
+                    arma::mat& Z,
+                    arma::mat& chi){
+  arma::vec internal_knots = {250, 500, 750};
+  arma::vec boundary_knots = {0, 1000};
+  arma::field<arma::vec> y_obs(n_funct, 1);
+  arma::field<arma::mat> B_obs(n_funct, 1);
+  for(int i = 0; i < n_funct; i++){
+    arma::vec t_i = arma::regspace(0, 10 + (i % 7), 990);
+    splines2::BSpline bspline(t_i, internal_knots, 3, boundary_knots);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+    y_obs(i,0) = arma::sin(t_i / 200) + 0.3 * arma::randn(t_i.n_elem);
+  }
+  obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+  int P = obs.B_t.n_rows;
+  arma::vec alpha = arma::ones(K);
+  Z.set_size(n_funct, K);
+  for(int i = 0; i < n_funct; i++){
+    Z.row(i) = BayesFMMM::rdirichlet(alpha).t();
+  }
+  nu = arma::randn(K, P);
+  Phi = 0.5 * arma::randn(K, P, M);
+  chi = arma::randn(n_funct, M);
+}
+
+// Compares the gradient of the log-likelihood with finite differences and
+// the control variate estimates with the gradient using all functions.
+// Returns the largest relative differences.
+//
+arma::vec TestSGGradient(){
+  int n_funct = 40;
+  int K = 3;
+  int M = 2;
+  BayesFMMM::RaggedObs obs;
+  arma::mat nu;
+  arma::cube Phi;
+  arma::mat Z;
+  arma::mat chi;
+  SimulateSGData(n_funct, K, M, obs, nu, Phi, Z, chi);
+  int P = obs.B_t.n_rows;
+  arma::uvec all = arma::regspace<arma::uvec>(0, n_funct - 1);
+  arma::vec diff = arma::zeros(4);
+
+  // finite differences of -rss / 2
+  arma::mat g_nu = arma::zeros(K, P);
+  arma::cube g_Phi = arma::zeros(K, P, M);
+  BayesFMMM::accumulateSubjects(obs, all, nu, Phi, Z, chi, 1.0, g_nu, g_Phi);
+  arma::mat g_nu_ph = g_nu;
+  arma::cube g_Phi_ph = g_Phi;
+  double h = 1e-5;
+  for(int k = 0; k < K; k++){
+    for(int p = 0; p < P; p++){
+      arma::mat nu_h = nu;
+      nu_h(k,p) = nu_h(k,p) + h;
+      double rss_1 = BayesFMMM::accumulateSubjects(obs, all, nu_h, Phi, Z, chi,
+                                                   1.0, g_nu_ph, g_Phi_ph);
+      nu_h(k,p) = nu_h(k,p) - 2 * h;
+      double rss_2 = BayesFMMM::accumulateSubjects(obs, all, nu_h, Phi, Z, chi,
+                                                   1.0, g_nu_ph, g_Phi_ph);
+      diff(0) = std::max(diff(0), std::abs(g_nu(k,p) + ((rss_1 - rss_2) / (4 * h))) /
+        (std::abs(g_nu(k,p)) + 1));
+      arma::cube Phi_h = Phi;
+      Phi_h(k,p,1) = Phi_h(k,p,1) + h;
+      rss_1 = BayesFMMM::accumulateSubjects(obs, all, nu, Phi_h, Z, chi, 1.0,
+                                            g_nu_ph, g_Phi_ph);
+      Phi_h(k,p,1) = Phi_h(k,p,1) - 2 * h;
+      rss_2 = BayesFMMM::accumulateSubjects(obs, all, nu, Phi_h, Z, chi, 1.0,
+                                            g_nu_ph, g_Phi_ph);
+      diff(1) = std::max(diff(1), std::abs(g_Phi(k,p,1) + ((rss_1 - rss_2) / (4 * h))) /
+        (std::abs(g_Phi(k,p,1)) + 1));
+    }
+  }
+
+  // at the anchor the control variate estimate is exact for any minibatch
+  double rss = 0;
+  arma::vec coef;
+  for(int i = 0; i < n_funct; i++){
+    BayesFMMM::calcMeanCoef(nu, Phi, Z.row(i), chi.row(i), coef);
+    rss = rss + BayesFMMM::calcRSS(obs, i, coef);
+  }
+  BayesFMMM::SGState state = BayesFMMM::makeSGState(K, P, M);
+  BayesFMMM::setSGAnchor(obs, nu, Phi, Z, chi, state);
+  BayesFMMM::sampleMinibatch(n_funct, 5, state);
+  arma::mat g_nu_est;
+  arma::cube g_Phi_est;
+  double rss_est = BayesFMMM::estimateSGGradient(obs, nu, Phi, Z, chi, state,
+                                                 g_nu_est, g_Phi_est);
+  diff(2) = std::max(arma::abs(g_nu_est - g_nu).max(),
+                     arma::abs(g_Phi_est - g_Phi).max());
+  diff(2) = std::max(diff(2), std::abs(rss_est - rss) / rss);
+
+  // with all functions in the minibatch it is exact for any parameters
+  arma::mat nu_1 = nu + 0.1 * arma::randn(K, P);
+  g_nu.zeros();
+  g_Phi.zeros();
+  double rss_1 = BayesFMMM::accumulateSubjects(obs, all, nu_1, Phi, Z, chi, 1.0,
+                                               g_nu, g_Phi);
+  BayesFMMM::sampleMinibatch(n_funct, n_funct, state);
+  rss_est = BayesFMMM::estimateSGGradient(obs, nu_1, Phi, Z, chi, state,
+                                          g_nu_est, g_Phi_est);
+  diff(3) = std::max(arma::abs(g_nu_est - g_nu).max(),
+                     arma::abs(g_Phi_est - g_Phi).max());
+  diff(3) = std::max(diff(3), std::abs(rss_est - rss_1) / rss_1);
+  return diff;
+}
+
+// Updates the local parameters of a few minibatches and compares the sums
+// kept at the anchor with the sums recomputed from all functions. Also
+// compares the log-pdfs of pi and alpha_3 computed from the sums of the log
+// memberships with the ones computed from Z. Returns the largest differences
+// and the number of functions whose parameters changed.
+//
+arma::vec TestSGLocals(){
+  int n_funct = 40;
+  int K = 3;
+  int M = 2;
+  BayesFMMM::RaggedObs obs;
+  arma::mat nu;
+  arma::cube Phi;
+  arma::mat Z;
+  arma::mat chi;
+  SimulateSGData(n_funct, K, M, obs, nu, Phi, Z, chi);
+  int P = obs.B_t.n_rows;
+  arma::vec pi = {0.3, 0.3, 0.4};
+  arma::vec c = {1, 2, 3};
+  arma::vec diff = arma::zeros(5);
+
+  BayesFMMM::SGState state = BayesFMMM::makeSGState(K, P, M);
+  BayesFMMM::setSGAnchor(obs, nu, Phi, Z, chi, state);
+  arma::mat Z_0 = Z;
+  arma::mat chi_0 = chi;
+  arma::mat nu_1 = nu + 0.1 * arma::randn(K, P);
+  for(int l = 0; l < 5; l++){
+    BayesFMMM::sampleMinibatch(n_funct, 6, state);
+    BayesFMMM::updateSGLocals(obs, Phi, nu_1, pi, 2.0, 0.1, 50, state, Z, chi);
+  }
+  BayesFMMM::SGState state_1 = BayesFMMM::makeSGState(K, P, M);
+  BayesFMMM::setSGAnchor(obs, nu, Phi, Z, chi, state_1);
+  diff(0) = std::max(arma::abs(state.grad_nu_hat - state_1.grad_nu_hat).max(),
+                     arma::abs(state.grad_Phi_hat - state_1.grad_Phi_hat).max());
+  diff(1) = std::abs(state.rss_hat - state_1.rss_hat) / state_1.rss_hat;
+  diff(2) = arma::abs(state.log_Z_sum - state_1.log_Z_sum).max();
+
+  double alpha_3 = 2;
+  double alpha_3_ph = 2.5;
+  diff(3) = std::max(std::abs(BayesFMMM::lpdf_pi_PM(c, alpha_3, pi, Z) -
+    BayesFMMM::lpdf_pi_PM(c, alpha_3, pi, state.log_Z_sum, n_funct)),
+    std::abs(BayesFMMM::lpdf_alpha3(pi, 1.0, Z, alpha_3, alpha_3_ph, 0.5) -
+      BayesFMMM::lpdf_alpha3(pi, 1.0, state.log_Z_sum, n_funct, alpha_3,
+                             alpha_3_ph, 0.5)));
+  for(int i = 0; i < n_funct; i++){
+    if(arma::any(chi.row(i) != chi_0.row(i))){
+      diff(4) = diff(4) + 1;
+    }
+  }
+  return diff;
+}
+
+// Runs two batches of the stochastic gradient sampler saving every
+// parameter and reads the files back. Returns the number of saved draws of
+// nu, Z and chi, the largest difference between the last saved draws of Z
+// and chi and the returned ones, and the largest difference between the first
+// and last saved draws of Z in the first batch.
+//
+arma::vec TestSGSavedDraws(){
+  int n_funct = 40;
+  int K = 3;
+  int M = 2;
+  BayesFMMM::RaggedObs obs;
+  arma::mat nu;
+  arma::cube Phi;
+  arma::mat Z;
+  arma::mat chi;
+  SimulateSGData(n_funct, K, M, obs, nu, Phi, Z, chi);
+  int P = obs.B_t.n_rows;
+  Rcpp::Environment base_env("package:base");
+  Rcpp::Function tempdir_r = base_env["tempdir"];
+  std::string directory = Rcpp::as<std::string>(tempdir_r()) + "/sg_";
+  BayesFMMM::RetentionPolicy retention =
+    BayesFMMM::makeRetentionPolicy(BayesFMMM::modelParams(), 1);
+
+  arma::vec c = arma::ones(K);
+  arma::vec pi = arma::ones(K) / K;
+  arma::mat delta = arma::ones(K, M);
+  arma::cube gamma = arma::ones(K, P, M);
+  arma::mat A = arma::ones(K, 2);
+  arma::vec tau = arma::ones(K);
+  Rcpp::List mod = BayesFMMM::BFMMM_SG_warm_start(obs, K, M, 20, 10, c, 1000,
+                                                  3, 2, 3, 1, 1, 1000, 1000,
+                                                  0.05, 1, 1, 1, 1, 1, 1,
+                                                  directory, Z, pi, 1, delta,
+                                                  gamma, Phi, A, nu, tau, 0.1,
+                                                  chi, 10, 0.01, 5, retention);
+  arma::mat Z_last = Rcpp::as<arma::mat>(mod["Z"]);
+  arma::mat chi_last = Rcpp::as<arma::mat>(mod["chi"]);
+
+  BayesFMMM::Posterior post(directory, 2);
+  arma::vec diff = arma::zeros(5);
+  diff(0) = post.nu().n_slices;
+  diff(1) = post.Z().n_slices;
+  diff(2) = post.chi().n_slices;
+  if((diff(1) != 20) || (diff(2) != 20)){
+    return diff;
+  }
+  diff(3) = std::max(arma::abs(post.Z().slice(19) - Z_last).max(),
+                     arma::abs(post.chi().slice(19) - chi_last).max());
+  diff(4) = arma::abs(post.Z().slice(9) - post.Z().slice(0)).max();
+  return diff;
+}
+
+context("Unit tests for the stochastic gradient sampler") {
+  test_that("Control variate gradients are exact at the anchor and with all functions"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestSGGradient();
+    expect_true(x(0) < 1e-5);
+    expect_true(x(1) < 1e-5);
+    expect_true(x(2) < 1e-8);
+    expect_true(x(3) < 1e-8);
+  }
+
+  test_that("Minibatch updates keep the sums at the anchor up to date"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestSGLocals();
+    expect_true(x(0) < 1e-8);
+    expect_true(x(1) < 1e-10);
+    expect_true(x(2) < 1e-8);
+    expect_true(x(3) < 1e-8);
+    expect_true(x(4) > 0);
+    expect_true(x(4) <= 30);
+  }
+
+  test_that("Z and chi are saved for every retained iteration"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestSGSavedDraws();
+    expect_true(x(0) == 20);
+    expect_true(x(1) == 20);
+    expect_true(x(2) == 20);
+    expect_true(x(3) < 1e-6);
+    expect_true(x(4) > 0);
+  }
+
+}
@@ -0,0 +1,168 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Makes observations where a few functions are observed at many more time
+// points than the others
+//
+BayesFMMM::RaggedObs MakeUnbalancedObs(arma::field<arma::vec>& y_obs,
+                                       arma::field<arma::mat>& B_obs){
+  int n_funct = y_obs.n_rows;
+  for(int i = 0; i < n_funct; i++){
+    arma::vec t_obs;
+    if((i % 10) == 0){
+      t_obs = arma::regspace(0, 1, 990);
+    }else{
+      t_obs = arma::regspace(0, 50 + (i % 7), 990);
+    }
+    splines2::BSpline bspline;
+    bspline = splines2::BSpline(t_obs, 8);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+    y_obs(i,0) = arma::randn(t_obs.n_elem);
+  }
+  return BayesFMMM::makeRaggedObs(y_obs, B_obs);
+}
+
+// Runs a kernel that counts the number of times each function is processed
+// and checks the statistics of the scheduler. Returns the number of functions
+// not processed exactly once (-1 if the statistics are wrong).
+//
+int TestSubjectCoverage(){
+  int n_funct = 97;
+  arma::field<arma::vec> y_obs(n_funct,1);
+  arma::field<arma::mat> B_obs(n_funct,1);
+  BayesFMMM::RaggedObs obs = MakeUnbalancedObs(y_obs, B_obs);
+  BayesFMMM::SubjectScheduler sched = BayesFMMM::makeSubjectScheduler(obs);
+  if((sched.chunk_start(0) != 0) ||
+     (sched.chunk_start(sched.chunk_start.n_elem - 1) != n_funct)){
+    return -1;
+  }
+
+  std::vector<int> count(n_funct, 0);
+  for(int j = 0; j < 3; j++){
+    BayesFMMM::parallelForSubjects(sched, "count", [&](const int i){
+      count[i] = count[i] + 1;
+    });
+  }
+  int n_wrong = 0;
+  for(int i = 0; i < n_funct; i++){
+    if(count[i] != 3){
+      n_wrong++;
+    }
+  }
+  const BayesFMMM::KernelUtilization& stats = sched.stats["count"];
+  double total_weight = 3 * (obs.y.n_elem + (n_funct * obs.B_t.n_rows));
+  if((stats.n_calls != 3) ||
+     (std::abs(arma::accu(stats.weight) - total_weight) > 1e-8)){
+    return -1;
+  }
+  return n_wrong;
+}
+
+// Compares the chi and sigma updates on the subject scheduler with the field
+// based implementations using the same seed
+//
+arma::vec TestSchedulerDraws(){
+  int n_funct = 40;
+  int K = 3;
+  int M = 2;
+  arma::field<arma::vec> y_obs(n_funct,1);
+  arma::field<arma::mat> B_obs(n_funct,1);
+  BayesFMMM::RaggedObs obs = MakeUnbalancedObs(y_obs, B_obs);
+
+  arma::mat nu(K, 8, arma::fill::randn);
+  arma::cube Phi = 0.5 * arma::randn(K, 8, M);
+  arma::mat Z(n_funct, K);
+  arma::vec alpha = {1, 1, 1};
+  for(int i = 0; i < n_funct; i++){
+    Z.row(i) = BayesFMMM::rdirichlet(alpha).t();
+  }
+  arma::cube chi_field(n_funct, M, 2, arma::fill::randn);
+  arma::cube chi_sched = chi_field;
+  arma::vec sigma_field = arma::ones(2);
+  arma::vec sigma_sched = arma::ones(2);
+  BayesFMMM::SubjectScheduler sched = BayesFMMM::makeSubjectScheduler(obs);
+
+  Rcpp::Environment base_env("package:base");
+  Rcpp::Function set_seed_r = base_env["set.seed"];
+  set_seed_r(2);
+  BayesFMMM::updateChiTempered(0.5, y_obs, B_obs, Phi, nu, Z, 0.8, 0, 2,
+                               chi_field);
+  BayesFMMM::updateSigmaTempered(0.5, y_obs, B_obs, 1, 1, nu, Phi, Z,
+                                 chi_field.slice(0), 0, 2, sigma_field);
+  set_seed_r(2);
+  BayesFMMM::updateChiTempered(0.5, obs, Phi, nu, Z, 0.8, 0, 2, sched,
+                               chi_sched);
+  BayesFMMM::updateSigmaTempered(0.5, obs, 1, 1, nu, Phi, Z,
+                                 chi_sched.slice(0), 0, 2, sched, sigma_sched);
+
+  arma::vec diff = arma::zeros(2);
+  diff(0) = arma::abs(chi_field.slice(0) - chi_sched.slice(0)).max();
+  diff(1) = std::abs(sigma_field(0) - sigma_sched(0));
+  return diff;
+}
+
+// Runs a kernel that throws for one function and then a kernel that does
+// not. Returns 1 if the exception reached the caller and the scheduler could
+// be used again.
+//
+int TestSubjectException(){
+  int n_funct = 97;
+  arma::field<arma::vec> y_obs(n_funct,1);
+  arma::field<arma::mat> B_obs(n_funct,1);
+  BayesFMMM::RaggedObs obs = MakeUnbalancedObs(y_obs, B_obs);
+  BayesFMMM::SubjectScheduler sched = BayesFMMM::makeSubjectScheduler(obs);
+  int caught = 0;
+  try{
+    BayesFMMM::parallelForSubjects(sched, "throw", [](const int i){
+      if(i == 13){
+        throw std::runtime_error("function 13");
+      }
+    });
+  }catch(std::runtime_error& e){
+    caught = (std::string(e.what()) == "function 13");
+  }
+  std::vector<int> count(n_funct, 0);
+  BayesFMMM::parallelForSubjects(sched, "count", [&count](const int i){
+    count[i] = count[i] + 1;
+  });
+  for(int i = 0; i < n_funct; i++){
+    if(count[i] != 1){
+      caught = 0;
+    }
+  }
+  return caught;
+}
+
+context("Unit tests for the subject scheduler") {
+  test_that("Exceptions thrown by a kernel reach the caller"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    int x = TestSubjectException();
+    expect_true(x == 1);
+  }
+
+  test_that("Every function is processed exactly once"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    int x = TestSubjectCoverage();
+    expect_true(x == 0);
+  }
+
+  test_that("Draws do not depend on the scheduler"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestSchedulerDraws();
+    expect_true(x(0) < 1e-8);
+    expect_true(x(1) < 1e-8);
+  }
+
+}
@@ -0,0 +1,87 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Compares the log acceptance probability of a tempered transition computed
+// from the log-likelihood of each state with CalculateTTAcceptance
+//
+double TestTTAcceptanceLoglik(){
+  int n_funct = 6;
+  int K = 3;
+  int P = 8;
+  int M = 2;
+  int N_t = 4;
+  int n_states = (2 * N_t) + 1;
+  arma::field<arma::mat> B_obs(n_funct,1);
+  arma::field<arma::vec> y_obs(n_funct,1);
+  for(int i = 0; i < n_funct; i++){
+    arma::vec t_obs =  arma::regspace(0, 10 + (i % 3), 990);
+    splines2::BSpline bspline;
+    bspline = splines2::BSpline(t_obs, P);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+    y_obs(i,0) = arma::randn(t_obs.n_elem);
+  }
+  BayesFMMM::RaggedObs obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+
+  arma::cube nu(K, P, n_states, arma::fill::randn);
+  arma::field<arma::cube> Phi(n_states,1);
+  arma::cube Z(n_funct, K, n_states);
+  arma::vec alpha = {1, 1, 1};
+  for(int l = 0; l < n_states; l++){
+    Phi(l,0) = 0.5 * arma::randn(K, P, M);
+    for(int i = 0; i < n_funct; i++){
+      Z.slice(l).row(i) = BayesFMMM::rdirichlet(alpha).t();
+    }
+  }
+  arma::cube chi(n_funct, M, n_states, arma::fill::randn);
+  arma::vec sigma = 0.5 + arma::randu(n_states);
+  arma::vec beta = {1, 0.6, 0.3, 0.1};
+
+  double logA = BayesFMMM::CalculateTTAcceptance(beta, obs, nu, Phi, Z, chi,
+                                                 sigma);
+  arma::vec loglik = BayesFMMM::calcTTLoglik(obs, nu, Phi, Z, chi, sigma);
+  double logA_loglik = BayesFMMM::CalculateTTAcceptance(beta, loglik);
+  return std::abs(logA - logA_loglik) / std::abs(logA);
+}
+
+// Respaces a geometric ladder when the log-likelihood has the same standard
+// deviation at every temperature, in which case the respaced ladder should be
+// equally spaced
+//
+double TestLadderRespacing(){
+  int N_t = 6;
+  arma::vec beta(N_t);
+  for(int i = 0; i < N_t; i++){
+    beta(i) = std::pow(0.01, i / (N_t - 1.0));
+  }
+  BayesFMMM::LadderStats stats = BayesFMMM::makeLadderStats(N_t);
+  arma::vec loglik((2 * N_t) + 1);
+  for(int j = 0; j < 50; j++){
+    loglik.fill(-100 + 3 * (j % 2));
+    BayesFMMM::updateLadderStats(beta, loglik, false, stats);
+  }
+  arma::vec beta_new = BayesFMMM::adaptTemperatureLadder(beta, stats);
+  arma::vec beta_linear = arma::linspace(1, 0.01, N_t);
+  return arma::abs(beta_new - beta_linear).max();
+}
+
+context("Unit tests for the temperature ladder") {
+  test_that("Acceptance probability from log-likelihood of each state"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestTTAcceptanceLoglik();
+    expect_true(x < 1e-8);
+  }
+
+  test_that("Respacing of the temperature ladder"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestLadderRespacing();
+    expect_true(x < 1e-8);
+  }
+
+}
@@ -0,0 +1,178 @@
+#include <RcppArmadillo.h>
+#include <cmath>
+#include <testthat.h>
+#include <BayesFMMM.h>
+
+// Compares the outer products and scaled rows accumulated without
+// temporaries with the corresponding Armadillo expressions
+//
+double TestRowAccumulation(){
+  arma::mat B(20, 6, arma::fill::randn);
+  arma::mat A = arma::zeros(6, 6);
+  arma::vec a = arma::zeros(6);
+  arma::mat A_arma = arma::zeros(6, 6);
+  arma::vec a_arma = arma::zeros(6);
+  for(arma::uword l = 0; l < B.n_rows; l++){
+    BayesFMMM::addOuterRow(B, l, 0.3, A);
+    BayesFMMM::addScaledRow(B, l, -1.7, a);
+    A_arma = A_arma + 0.3 * (B.row(l).t() * B.row(l));
+    a_arma = a_arma - 1.7 * B.row(l).t();
+  }
+  return std::max(arma::abs(A - A_arma).max(), arma::abs(a - a_arma).max());
+}
+
+// Compares the nu and Phi updates using contiguous storage and a workspace
+// with the field based implementations using the same seed, running them
+// twice so that the second sweep reuses the buffers of the first. Returns the
+// largest differences of the draws and the number of buffers (re)allocated
+// during the second sweep.
+//
+arma::vec TestWorkspaceDraws(){
+  int n_funct = 30;
+  int K = 3;
+  int P = 8;
+  int M = 2;
+  arma::field<arma::vec> y_obs(n_funct,1);
+  arma::field<arma::mat> B_obs(n_funct,1);
+  arma::mat Z(n_funct, K);
+  arma::vec alpha = {1, 1, 1};
+  for(int i = 0; i < n_funct; i++){
+    Z.row(i) = BayesFMMM::rdirichlet(alpha).t();
+    arma::vec t_obs = arma::regspace(0, 10 + (i % 5), 990);
+    splines2::BSpline bspline;
+    bspline = splines2::BSpline(t_obs, P);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+    y_obs(i,0) = arma::randn(t_obs.n_elem);
+  }
+  BayesFMMM::RaggedObs obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+  arma::mat chi(n_funct, M, arma::fill::randn);
+  arma::vec tau = arma::ones(K);
+  arma::mat P_mat = arma::eye(P, P);
+  arma::cube gamma = arma::ones(K, P, M);
+  arma::mat tilde_tau = arma::ones(K, M);
+  arma::vec b_1(P);
+  arma::mat B_1(P, P);
+
+  arma::cube nu_field(K, P, 2, arma::fill::randn);
+  arma::cube nu_ws = nu_field;
+  arma::field<arma::cube> Phi_field(2,1);
+  Phi_field(0,0) = 0.5 * arma::randn(K, P, M);
+  Phi_field(1,0) = Phi_field(0,0);
+  arma::field<arma::cube> Phi_ws = Phi_field;
+  BayesFMMM::Workspace ws = BayesFMMM::makeWorkspace();
+  int n_alloc = 0;
+  int n_first = 0;
+
+  Rcpp::Environment base_env("package:base");
+  Rcpp::Function set_seed_r = base_env["set.seed"];
+  for(int s = 0; s < 2; s++){
+    set_seed_r(2 + s);
+    BayesFMMM::updatePhi(y_obs, B_obs, nu_field.slice(0), gamma, tilde_tau, Z,
+                         chi, 1, 0, 2, b_1, B_1, Phi_field);
+    BayesFMMM::updateNu(y_obs, B_obs, tau, Phi_field(0,0), Z, chi, 1, 0, 2,
+                        P_mat, b_1, B_1, nu_field);
+    set_seed_r(2 + s);
+    // (re)allocations made by the first sweep
+    n_first = (s == 1) ? ws.n_alloc : n_first;
+    n_alloc = ws.n_alloc;
+    BayesFMMM::updatePhi(obs, nu_ws.slice(0), gamma, tilde_tau, Z, chi, 1, 0, 2,
+                         ws, b_1, B_1, Phi_ws);
+    BayesFMMM::updateNuTempered(1.0, obs, tau, Phi_ws(0,0), Z, chi, 1, 0, 2,
+                                P_mat, ws, b_1, B_1, nu_ws);
+  }
+
+  arma::vec diff = arma::zeros(4);
+  diff(0) = arma::abs(nu_field.slice(0) - nu_ws.slice(0)).max();
+  diff(1) = arma::abs(Phi_field(0,0) - Phi_ws(0,0)).max();
+  diff(2) = ws.n_alloc - n_alloc;
+  diff(3) = n_first;
+  return diff;
+}
+
+// Runs the chi, sigma, likelihood and Z (Metropolis-Hastings and HMC)
+// kernels on the subject scheduler twice and returns the number of buffers
+// (re)allocated during the first and the second run, and the number of
+// buffers of the serial workspace allocated during the first run
+//
+arma::vec TestSchedulerWorkspaceReuse(){
+  int n_funct = 40;
+  int K = 3;
+  int P = 8;
+  int M = 2;
+  arma::field<arma::vec> y_obs(n_funct,1);
+  arma::field<arma::mat> B_obs(n_funct,1);
+  arma::mat Z(n_funct, K);
+  arma::vec alpha = {1, 1, 1};
+  for(int i = 0; i < n_funct; i++){
+    Z.row(i) = BayesFMMM::rdirichlet(alpha).t();
+    arma::vec t_obs = arma::regspace(0, 5 + (i % 9), 990);
+    splines2::BSpline bspline;
+    bspline = splines2::BSpline(t_obs, P);
+    arma::mat bspline_mat{bspline.basis(true)};
+    B_obs(i,0) = bspline_mat;
+    y_obs(i,0) = arma::randn(t_obs.n_elem);
+  }
+  BayesFMMM::RaggedObs obs = BayesFMMM::makeRaggedObs(y_obs, B_obs);
+  BayesFMMM::SubjectScheduler sched = BayesFMMM::makeSubjectScheduler(obs);
+  arma::mat nu(K, P, arma::fill::randn);
+  arma::cube Phi = 0.5 * arma::randn(K, P, M);
+  arma::cube chi(n_funct, M, 2, arma::fill::randn);
+  arma::vec sigma = arma::ones(2);
+  arma::cube Z_cube(n_funct, K, 2);
+  Z_cube.slice(0) = Z;
+  arma::vec pi = arma::ones(K) / K;
+  arma::vec a_Z_PM = 500 * arma::ones(n_funct);
+  arma::vec step_Z = 0.05 * arma::ones(n_funct);
+  arma::vec Z_ph(K);
+  arma::vec accept_prob(n_funct);
+
+  int n_alloc = 0;
+  arma::vec n_run = arma::zeros(3);
+  for(int s = 0; s < 2; s++){
+    n_alloc = BayesFMMM::countWorkspaceAllocations(sched);
+    BayesFMMM::updateChi(obs, Phi, nu, Z, 1, 0, 2, sched, chi);
+    BayesFMMM::updateSigma(obs, 1, 1, nu, Phi, Z, chi.slice(0), 0, 2, sched,
+                           sigma);
+    BayesFMMM::calcLikelihood(obs, nu, Phi, Z, chi.slice(0), sigma(0), sched);
+    BayesFMMM::updateZ_PM(obs, Phi, nu, chi.slice(0), pi, sigma(0), 0, 2, 1,
+                          a_Z_PM, sched, Z_ph, accept_prob, Z_cube);
+    BayesFMMM::updateZHMC_PM(obs, Phi, nu, chi.slice(0), pi, sigma(0), 0, 2, 1,
+                             step_Z, 5, sched, accept_prob, Z_cube);
+    n_run(s) = BayesFMMM::countWorkspaceAllocations(sched) - n_alloc;
+    n_run(2) = (s == 0) ? sched.serial.n_alloc : n_run(2);
+  }
+  return n_run;
+}
+
+context("Unit tests for the scratch workspaces") {
+  test_that("Accumulated outer products and rows"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    double x = TestRowAccumulation();
+    expect_true(x < 1e-10);
+  }
+
+  test_that("Draws using a workspace match the field based updates"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestWorkspaceDraws();
+    expect_true(x(0) < 1e-6);
+    expect_true(x(1) < 1e-6);
+    expect_true(x(2) == 0);
+    expect_true(x(3) > 0);
+  }
+
+  test_that("Scheduler workspaces are reused across sweeps"){
+    Rcpp::Environment base_env("package:base");
+    Rcpp::Function set_seed_r = base_env["set.seed"];
+    set_seed_r(1);
+    arma::vec x = TestSchedulerWorkspaceReuse();
+    expect_true(x(0) > 0);
+    expect_true(x(1) == 0);
+    expect_true(x(2) > 0);
+  }
+
+}